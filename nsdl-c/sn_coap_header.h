@@ -155,7 +155,8 @@ typedef enum sn_coap_status_ {
     COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING = 3, /**< User will get whole message after all message blocks received.
                                                          User must release messages with this status. */
     COAP_STATUS_PARSER_BLOCKWISE_ACK           = 4, /**< Acknowledgement for sent Blockwise message received */
-    COAP_STATUS_PARSER_BLOCKWISE_MSG_REJECTED  = 5, /**< Blockwise message received but not supported by compiling switch */
+    COAP_STATUS_PARSER_BLOCKWISE_MSG_REJECTED  = 5, /**< Blockwise message received but not supported by compiling switch,
+                                                         or block of a download did not fit to payload sink */
     COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED  = 6, /**< Blockwise message fully received and returned to app.
                                                          User must take care of releasing whole payload of the blockwise messages */
     COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED = 7  /**< When re-transmissions have been done and ACK not received, CoAP library calls
@@ -163,6 +164,33 @@ typedef enum sn_coap_status_ {
 } sn_coap_status_e;
 
 
+/* * * * * * * * * * * * * * * * */
+/* * * * PAYLOAD LENGTH TYPE * * * */
+/* * * * * * * * * * * * * * * * */
+
+/* Large payload mode changes public types, so it must be set identically
+ * for library and application, e.g. as compiler definition. See sn_config.h */
+#ifdef YOTTA_CFG_COAP_LARGE_PAYLOAD
+#define SN_COAP_LARGE_PAYLOAD YOTTA_CFG_COAP_LARGE_PAYLOAD
+#elif defined MBED_CONF_MBED_CLIENT_SN_COAP_LARGE_PAYLOAD
+#define SN_COAP_LARGE_PAYLOAD MBED_CONF_MBED_CLIENT_SN_COAP_LARGE_PAYLOAD
+#endif
+
+#ifndef SN_COAP_LARGE_PAYLOAD
+#define SN_COAP_LARGE_PAYLOAD 0
+#endif
+
+/**
+ * \brief Type of payload lengths and memory allocation sizes
+ */
+#if SN_COAP_LARGE_PAYLOAD
+typedef uint32_t sn_coap_len_t;
+#define SN_COAP_LEN_MAX UINT32_MAX
+#else
+typedef uint16_t sn_coap_len_t;
+#define SN_COAP_LEN_MAX UINT16_MAX
+#endif
+
 /* * * * * * * * * * * * * */
 /* * * * STRUCTURES  * * * */
 /* * * * * * * * * * * * * */
@@ -208,6 +236,7 @@ typedef struct sn_coap_options_list_ {
  */
 typedef struct sn_coap_hdr_ {
     uint8_t                 token_len;          /**< 1-8 bytes. */
+    uint8_t                 inline_storage;     /**< Not for user. Set when token and short uri path live inside message allocation */
 
     sn_coap_status_e        coap_status;        /**< Used for telling to User special cases when parsing message */
     sn_coap_msg_code_e      msg_code;           /**< Empty: 0; Requests: 1-31; Responses: 64-191 */
@@ -217,7 +246,7 @@ typedef struct sn_coap_hdr_ {
 
     uint16_t                msg_id;             /**< Message ID. Parser sets parsed message ID, builder sets message ID of built coap message */
     uint16_t                uri_path_len;       /**< 0-255 bytes. Repeatable. */
-    uint16_t                payload_len;        /**< Must be set to zero if not used */
+    sn_coap_len_t           payload_len;        /**< Must be set to zero if not used */
 
     uint8_t                *token_ptr;          /**< Must be set to NULL if not used */
     uint8_t                *uri_path_ptr;       /**< Must be set to NULL if not used. E.g: temp1/temp2 */
@@ -374,6 +403,38 @@ extern sn_coap_hdr_s *sn_coap_parser_alloc_message(struct coap_s *handle);
  */
 extern sn_coap_options_list_s *sn_coap_parser_alloc_options(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr);
 
+/**
+ * \brief Stores a copy of token to message
+ *
+ * \param *handle Pointer to CoAP library handle
+ * \param *coap_msg_ptr is pointer to CoAP message, which must not have token yet
+ * \param *token_ptr is pointer to token to be copied
+ * \param token_len is length of token, 1-8 bytes
+ *
+ * Token is stored inside message allocated by sn_coap_parser_alloc_message() when compact
+ * storage is enabled, see SN_COAP_INLINE_URI_PATH_SIZE. Otherwise it is allocated separately.
+ * Either way it is released by sn_coap_parser_release_allocated_coap_msg_mem().
+ *
+ * \return 0 = success, -1 = failure
+ */
+extern int8_t sn_coap_parser_set_token(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, const uint8_t *token_ptr, uint8_t token_len);
+
+/**
+ * \brief Stores a copy of uri path to message
+ *
+ * \param *handle Pointer to CoAP library handle
+ * \param *coap_msg_ptr is pointer to CoAP message, which must not have uri path yet
+ * \param *uri_path_ptr is pointer to uri path to be copied
+ * \param uri_path_len is length of uri path
+ *
+ * Uri path is stored inside message allocated by sn_coap_parser_alloc_message() if it is not
+ * longer than SN_COAP_INLINE_URI_PATH_SIZE. Otherwise it is allocated separately.
+ * Either way it is released by sn_coap_parser_release_allocated_coap_msg_mem().
+ *
+ * \return 0 = success, -1 = failure
+ */
+extern int8_t sn_coap_parser_set_uri_path(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, const uint8_t *uri_path_ptr, uint16_t uri_path_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,7 +30,7 @@ extern "C" {
 #include "sn_coap_header.h"
 
 /**
- * \fn struct coap_s *sn_coap_protocol_init(void* (*used_malloc_func_ptr)(uint16_t), void (*used_free_func_ptr)(void*),
+ * \fn struct coap_s *sn_coap_protocol_init(void* (*used_malloc_func_ptr)(sn_coap_len_t), void (*used_free_func_ptr)(void*),
         uint8_t (*used_tx_callback_ptr)(sn_nsdl_capab_e , uint8_t *, uint16_t, sn_nsdl_addr_s *),
         int8_t (*used_rx_callback_ptr)(sn_coap_hdr_s *, sn_nsdl_addr_s *)
  *
@@ -49,7 +49,7 @@ extern "C" {
  *          Null if failed
  */
 
-extern struct coap_s *sn_coap_protocol_init(void *(*used_malloc_func_ptr)(uint16_t), void (*used_free_func_ptr)(void *),
+extern struct coap_s *sn_coap_protocol_init(void *(*used_malloc_func_ptr)(sn_coap_len_t), void (*used_free_func_ptr)(void *),
         uint8_t (*used_tx_callback_ptr)(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *),
         int8_t (*used_rx_callback_ptr)(sn_coap_hdr_s *, sn_nsdl_addr_s *, void *));
 
@@ -89,6 +89,158 @@ extern int8_t sn_coap_protocol_destroy(struct coap_s *handle);
  */
 extern int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr, sn_coap_hdr_s *src_coap_msg_ptr, void *param);
 
+/**
+ * \fn int16_t sn_coap_protocol_build_copy(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *packet_data_ptr, uint16_t packet_data_len, sn_coap_hdr_s *src_coap_msg_ptr, void *param)
+ *
+ * \brief Turns Packet data built earlier by sn_coap_protocol_build() into the same message for another
+ *        destination without encoding it again. Only Message ID and token are rewritten in place,
+ *        so the same message can be sent to several destinations from one encode.
+ *
+ * \param *dst_addr_ptr is pointer to destination address where CoAP message will be sent
+ *
+ * \param *packet_data_ptr is pointer to Packet data built from src_coap_msg_ptr
+ *
+ * \param packet_data_len is length of Packet data
+ *
+ * \param *src_coap_msg_ptr is pointer to the header Packet data was built from, with msg_id and token
+ *        of the new message. Message ID is generated if msg_id is 0, as in sn_coap_protocol_build().
+ *
+ * \param param void pointer that will be passed to tx/rx function callback when those are called.
+ *
+ * \return Return value is packet_data_len.\n
+ *         In failure cases:\n
+ *          -1 = Token length differs from the one in Packet data, or message would be blockwised\n
+ *          -2 = Failure in given pointer (= NULL)\n
+ *         Confirmable message is stored for resending as in sn_coap_protocol_build().
+ */
+extern int16_t sn_coap_protocol_build_copy(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *packet_data_ptr, uint16_t packet_data_len, sn_coap_hdr_s *src_coap_msg_ptr, void *param);
+
+/**
+ * \fn int8_t sn_coap_protocol_prepare_streamed_message(struct coap_s *handle, sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+ *        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context)
+ *
+ * \brief Prepares a request whose payload is generated block by block instead of being stored as a whole.
+ *        Adds Block1 and Size1 options when needed and fills the first block to allocated payload_ptr,
+ *        which is freed by the caller after sn_coap_protocol_build_streamed() as with any other payload.
+ *        Available only when blockwise transfer is compiled in.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *src_coap_msg_ptr is pointer to request to be sent
+ *
+ * \param payload_total_len is length of the whole payload, can exceed 64 kB
+ *
+ * \param payload_source is called to write len bytes of payload starting from offset to given buffer.
+ *        Must return number of bytes written, anything less than requested aborts the transfer.
+ *
+ * \param *source_context is passed to payload_source
+ *
+ * \return  0 = success, -1 = invalid parameter or payload source failed, -2 = out of memory
+ */
+extern int8_t sn_coap_protocol_prepare_streamed_message(struct coap_s *handle, sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context);
+
+/**
+ * \fn int16_t sn_coap_protocol_build_streamed(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr,
+ *        sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+ *        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context, void *param)
+ *
+ * \brief Builds first block of a request prepared with sn_coap_protocol_prepare_streamed_message().
+ *        Following blocks are requested from payload_source when Block1 acknowledgements are received,
+ *        so only one block of payload is held in memory at a time.
+ *
+ * \param *source_context must be allocated with the same allocator given to sn_coap_protocol_init().
+ *        On success the library takes its ownership and frees it when transfer ends or times out.
+ *
+ * \return Byte count of built Packet data, or same error codes as sn_coap_protocol_build()
+ */
+extern int16_t sn_coap_protocol_build_streamed(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr,
+        sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context, void *param);
+
+/**
+ * \fn int8_t sn_coap_protocol_start_download(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr,
+ *        uint8_t window, uint16_t (*payload_sink)(void *, uint32_t, const uint8_t *, uint16_t), void *sink_context, void *param)
+ *
+ * \brief Starts Block2 download of a resource with several requests outstanding at a time.
+ *        First block is requested alone to agree block size with server, after that up to window
+ *        blocks are requested at a time. Received blocks are given to payload_sink at their offsets,
+ *        possibly out of order, and are never stored as a whole.
+ *        Requests are sent with TX callback and retransmitted by the download itself, so resending
+ *        queue size does not limit the window. Available only when blockwise transfer is compiled in.
+ *
+ *        Responses are returned by sn_coap_protocol_parse() with coap_status:\n
+ *          COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING for a block given to payload_sink,\n
+ *          COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED when all blocks are given to payload_sink,
+ *          payload_ptr is NULL,\n
+ *          COAP_STATUS_PARSER_BLOCKWISE_MSG_REJECTED when payload_sink aborted the download.\n
+ *        Error response ends the download and is returned as it is. If a request is not answered
+ *        after all retransmissions, RX callback is called with COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *dst_addr_ptr is pointer to server address
+ *
+ * \param *src_coap_msg_ptr is pointer to GET request to be sent, it is copied and can be released after the call
+ *
+ * \param window is maximum count of outstanding requests, 1 - SN_COAP_BLOCKWISE_MAX_WINDOW
+ *
+ * \param payload_sink is called to store len bytes of payload starting from offset.
+ *        Must return number of bytes stored, anything less than given aborts the download.
+ *
+ * \param *sink_context must be allocated with the same allocator given to sn_coap_protocol_init().
+ *        On success the library takes its ownership and frees it when download ends or times out.
+ *
+ * \param *param is passed to TX and RX callbacks
+ *
+ * \return  0 = success, -1 = invalid parameter, -2 = out of memory
+ */
+extern int8_t sn_coap_protocol_start_download(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr,
+        uint8_t window, uint16_t (*payload_sink)(void *, uint32_t, const uint8_t *, uint16_t), void *sink_context, void *param);
+
+/**
+ * \fn int8_t sn_coap_protocol_start_upload(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr,
+ *        uint32_t payload_total_len, uint8_t window, uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t),
+ *        void *source_context, void *param)
+ *
+ * \brief Starts Block1 upload with several blocks outstanding at a time.
+ *        First block is sent alone to agree block size with server, after that up to window
+ *        blocks are sent at a time. Every block is acknowledged separately, so only the blocks
+ *        whose acknowledgement is missing are retransmitted. Blocks are read from payload_source
+ *        when sent and again when retransmitted, so the whole payload is never held in memory.
+ *        Available only when blockwise transfer is compiled in.
+ *
+ *        Responses are returned by sn_coap_protocol_parse() with coap_status:\n
+ *          COAP_STATUS_PARSER_BLOCKWISE_ACK for 2.31 Continue of a block,\n
+ *          COAP_STATUS_OK for final response, which ends the upload as does an error response.\n
+ *        If a block is not acknowledged after all retransmissions, RX callback is called with
+ *        COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *dst_addr_ptr is pointer to server address
+ *
+ * \param *src_coap_msg_ptr is pointer to PUT or POST request to be sent without payload,
+ *        it is copied and can be released after the call
+ *
+ * \param payload_total_len is length of the whole payload, can exceed 64 kB
+ *
+ * \param window is maximum count of outstanding blocks, 1 - SN_COAP_BLOCKWISE_MAX_WINDOW
+ *
+ * \param payload_source is called to write len bytes of payload starting from offset to given buffer.
+ *        Must return number of bytes written, anything less than requested fails sending of the block.
+ *
+ * \param *source_context must be allocated with the same allocator given to sn_coap_protocol_init().
+ *        On success the library takes its ownership and frees it when upload ends or times out.
+ *
+ * \param *param is passed to TX and RX callbacks
+ *
+ * \return  0 = success, -1 = invalid parameter or payload source failed, -2 = out of memory
+ */
+extern int8_t sn_coap_protocol_start_upload(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr,
+        uint32_t payload_total_len, uint8_t window, uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t),
+        void *source_context, void *param);
+
 /**
  * \fn sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint16_t packet_data_len, uint8_t *packet_data_ptr)
  *
@@ -132,6 +284,21 @@ extern sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr
 
 extern int8_t sn_coap_protocol_exec(struct coap_s *handle, uint32_t current_time);
 
+/**
+ * \fn int8_t sn_coap_protocol_get_next_deadline(struct coap_s *handle, uint32_t *deadline_ptr)
+ *
+ * \brief Returns system time when sn_coap_protocol_exec() has next pending work,
+ *        so that caller can sleep until then instead of polling.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *deadline_ptr Earliest re-sending time, in same time base as given to sn_coap_protocol_exec()
+ *
+ * \return  0 if deadline was written
+ *          -1 if failed or there is nothing to be re-sent
+ */
+extern int8_t sn_coap_protocol_get_next_deadline(struct coap_s *handle, uint32_t *deadline_ptr);
+
 /**
  * \fn int8_t sn_coap_protocol_set_block_size(uint16_t block_size)
  *
@@ -199,7 +366,7 @@ extern void sn_coap_protocol_clear_retransmission_buffer(struct coap_s *handle);
  * \param payload Coap payload of the block.
  *
  */
-extern void sn_coap_protocol_block_remove(struct coap_s *handle, sn_nsdl_addr_s *source_address, uint16_t payload_length, void *payload);
+extern void sn_coap_protocol_block_remove(struct coap_s *handle, sn_nsdl_addr_s *source_address, sn_coap_len_t payload_length, void *payload);
 
 /**
  * \fn void sn_coap_protocol_delete_retransmission(struct coap_s *handle)
@@ -212,6 +379,29 @@ extern void sn_coap_protocol_block_remove(struct coap_s *handle, sn_nsdl_addr_s
  */
 extern int8_t sn_coap_protocol_delete_retransmission(struct coap_s *handle, uint16_t msg_id);
 
+/**
+ * \fn void sn_coap_protocol_clear_sent_messages_by_param(struct coap_s *handle, void *param)
+ *
+ * \param *handle Pointer to CoAP library handle
+ * \param *param TX/RX callback parameter given when messages were built
+ *
+ * \brief Removes messages waiting for re-transmission and streamed blockwise messages which were
+ *        built with given callback parameter. Used when owner of the parameter is destroyed while
+ *        CoAP library handle is still in use.
+ */
+extern void sn_coap_protocol_clear_sent_messages_by_param(struct coap_s *handle, void *param);
+
+/**
+ * \fn uint16_t sn_coap_protocol_reserve_message_id(struct coap_s *handle)
+ *
+ * \param *handle Pointer to CoAP library handle
+ * \return Message ID, 0 if handle is invalid
+ *
+ * \brief Takes next message ID into use without building a message. Message ID is used when message
+ *        with the same msg_id is later given to sn_coap_protocol_build().
+ */
+extern uint16_t sn_coap_protocol_reserve_message_id(struct coap_s *handle);
+
 #endif /* SN_COAP_PROTOCOL_H_ */
 
 #ifdef __cplusplus
@@ -80,9 +80,77 @@
  * Application can set this value based on their
  * available storage capability.
  * By default, maximum size is UINT16_MAX, 65535 bytes.
+ * Larger values need SN_COAP_LARGE_PAYLOAD.
  */
 #undef SN_COAP_MAX_INCOMING_MESSAGE_SIZE    /* UINT16_MAX */
 
+/**
+ * \def SN_COAP_LARGE_PAYLOAD
+ *
+ * \brief Enables 32-bit payload lengths. When set to 1,
+ * sn_coap_len_t is uint32_t and it is used for payload
+ * lengths, resource lengths and memory allocation sizes,
+ * so a single blockwise transfer can exceed 65535 bytes.
+ * Changes public types, so it must be given to both
+ * library and application, e.g. as compiler definition.
+ * By default, this feature is disabled.
+ */
+#undef SN_COAP_LARGE_PAYLOAD                /* 0 */
+
+/**
+ * \def SN_COAP_BLOCKWISE_MAX_WINDOW
+ *
+ * \brief Maximum count of outstanding requests of one
+ * transfer started with sn_coap_protocol_start_download() or
+ * sn_coap_protocol_start_upload(). Each window slot takes a
+ * few bytes from every transfer. Default is 4.
+ */
+#undef SN_COAP_BLOCKWISE_MAX_WINDOW /* 4 */
+
+/**
+ * \def SN_COAP_INLINE_URI_PATH_SIZE
+ *
+ * \brief Enables compact storage of CoAP messages allocated
+ * by the library. When non-zero, token and uri paths up to
+ * this many bytes are kept in the same allocation as message
+ * header instead of separate allocations. Application must then
+ * set them with sn_coap_parser_set_token() and
+ * sn_coap_parser_set_uri_path() or own pointers, and must not
+ * free token_ptr or uri_path_ptr of library allocated messages.
+ * Default is 0, compact storage is not used.
+ */
+#undef SN_COAP_INLINE_URI_PATH_SIZE         /* 0 */
+
+/**
+ * \def SN_NSDL_UPDATE_JITTER_PERCENT
+ *
+ * \brief Maximum random advance of automatic registration
+ * update, in percents of the update interval. Spreads updates
+ * of endpoints which registered at the same time.
+ * Default is 10.
+ */
+#undef SN_NSDL_UPDATE_JITTER_PERCENT        /* 10 */
+
+/**
+ * \def SN_NSDL_DEFAULT_LIFETIME
+ *
+ * \brief Lifetime in seconds used for automatic registration
+ * update when endpoint does not give lifetime parameter.
+ * Default is 86400, as defined by LWM2M.
+ */
+#undef SN_NSDL_DEFAULT_LIFETIME             /* 86400 */
+
+/**
+ * \def SN_NSDL_MAX_QUEUED_NOTIFICATIONS
+ *
+ * \brief Maximum number of observation notifications held
+ * back while endpoint sleeps in queue mode. When the queue
+ * is full, new notifications are refused and
+ * sn_nsdl_send_observation_notification() returns 0.
+ * Default is 8.
+ */
+#undef SN_NSDL_MAX_QUEUED_NOTIFICATIONS     /* 8 */
+
 #ifdef MBED_CLIENT_USER_CONFIG_FILE
 #include MBED_CLIENT_USER_CONFIG_FILE
 #endif
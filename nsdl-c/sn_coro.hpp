@@ -0,0 +1,822 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file sn_coro.hpp
+ *
+ * \brief Header-only C++20 coroutine layer over sn_cpp.hpp.
+ *
+ * Client requests are awaited instead of matched in an RX callback:
+ *
+ *   sn::task<> read_model(sn::coap_client &client)
+ *   {
+ *       sn::coap_message response = co_await client.get("/3/0/1");
+ *       if (!response) {
+ *           co_return;     // Timed out, reset or out of memory
+ *       }
+ *       ...
+ *   }
+ *
+ * Dynamic resources of an NSDL handle can be served by coroutines, which may
+ * await other operations before responding:
+ *
+ *   sn::task<> read_temperature(sn::server_request request)
+ *   {
+ *       sn::coap_message value = co_await sensor.get("/temp");
+ *       request.respond(COAP_MSG_CODE_RESPONSE_CONTENT, value ? value.payload() : sn::byte_view());
+ *   }
+ *
+ * A handler that is still running when the resource callback returns gets a
+ * separate response: confirmable request is acknowledged with an empty ACK,
+ * and the response is sent later as a new confirmable message with the
+ * request token (RFC 7252, 5.2.2). A handler that responds before its first
+ * suspension gets a piggybacked response as with plain callbacks.
+ *
+ * Everything runs on the thread calling input(), exec() and
+ * sn_nsdl_process_coap(). Coroutines are resumed from inside those calls.
+ */
+
+#ifndef SN_CORO_HPP_
+#define SN_CORO_HPP_
+
+#if !defined(__cpp_impl_coroutine) && !defined(__cpp_coroutines)
+#error "sn_coro.hpp needs C++20 coroutines"
+#endif
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "sn_cpp.hpp"
+
+namespace sn {
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+struct promise_base {
+    struct final_awaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) noexcept
+        {
+            promise_base &promise = coroutine.promise();
+
+            if (promise.detached) {
+                coroutine.destroy();
+                return std::noop_coroutine();
+            }
+            return promise.continuation ? promise.continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+
+    std::coroutine_handle<> continuation;
+    bool detached = false;
+};
+
+template <typename T>
+struct promise : promise_base {
+    task<T> get_return_object() noexcept;
+    void return_value(T value) { result.emplace(std::move(value)); }
+
+    std::optional<T> result;
+};
+
+template <>
+struct promise<void> : promise_base {
+    task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+};
+
+} // namespace detail
+
+/**
+ * \brief Lazily started coroutine. Runs when awaited, or when given to spawn().
+ */
+template <typename T>
+class task {
+public:
+    using promise_type = detail::promise<T>;
+
+    task(task &&other) noexcept : coroutine_(std::exchange(other.coroutine_, nullptr)) {}
+
+    task &operator=(task &&other) noexcept
+    {
+        if (this != &other) {
+            if (coroutine_) {
+                coroutine_.destroy();
+            }
+            coroutine_ = std::exchange(other.coroutine_, nullptr);
+        }
+        return *this;
+    }
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task()
+    {
+        if (coroutine_) {
+            coroutine_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !coroutine_ || coroutine_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        coroutine_.promise().continuation = awaiting;
+        return coroutine_;
+    }
+
+    T await_resume()
+    {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*coroutine_.promise().result);
+        }
+    }
+
+private:
+    friend struct detail::promise<T>;
+    friend void spawn(task<void> &&started);
+
+    explicit task(std::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {}
+
+    std::coroutine_handle<promise_type> coroutine_;
+};
+
+namespace detail {
+
+template <typename T>
+inline task<T> promise<T>::get_return_object() noexcept
+{
+    return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object() noexcept
+{
+    return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+/**
+ * \brief Starts a task that nobody awaits. It runs until its first suspension before
+ *        this returns, and frees itself when it completes.
+ */
+inline void spawn(task<void> &&started)
+{
+    std::coroutine_handle<detail::promise<void>> coroutine = std::exchange(started.coroutine_, nullptr);
+
+    if (coroutine) {
+        coroutine.promise().detached = true;
+        coroutine.resume();
+    }
+}
+
+/**
+ * \brief Copy of a peer address, usable where sn_nsdl_addr_s is needed
+ */
+class address {
+public:
+    address() noexcept
+    {
+        addr_ = sn_nsdl_addr_s();
+    }
+
+    explicit address(const sn_nsdl_addr_s &src)
+        : bytes_(src.addr_ptr, src.addr_ptr + src.addr_len)
+    {
+        addr_ = src;
+        addr_.addr_ptr = bytes_.data();
+    }
+
+    address(const address &other) : address(other.addr_) {}
+
+    address &operator=(const address &other)
+    {
+        if (this != &other) {
+            bytes_ = other.bytes_;
+            addr_ = other.addr_;
+            addr_.addr_ptr = bytes_.data();
+        }
+        return *this;
+    }
+
+    sn_nsdl_addr_s &get() noexcept { return addr_; }
+
+private:
+    std::vector<uint8_t> bytes_;
+    sn_nsdl_addr_s addr_;
+};
+
+/**
+ * \brief CoAP client of one peer, with requests awaited by coroutines.
+ *
+ * Any number of requests may be outstanding. They are matched to responses by
+ * token, so separate responses and responses out of order are handled.
+ * Confirmable requests are resent by the library; a request completes with an
+ * empty message when resending gives up, when the peer resets it or when it is
+ * not answered within the request timeout. Block2 responses are reassembled by
+ * the library before the request completes.
+ *
+ * Destroying the client completes outstanding requests with an empty message.
+ */
+class coap_client {
+public:
+    /**
+     * \brief Transmits a datagram to the peer, returns false on failure
+     */
+    using send_func = std::function<bool(byte_view datagram, const sn_nsdl_addr_s &peer)>;
+
+    class request;
+
+    static constexpr uint32_t default_timeout = 93;     /* Seconds, MAX_TRANSMIT_WAIT of RFC 7252 */
+
+    coap_client(coap_handle::alloc_func alloc, coap_handle::free_func free, const sn_nsdl_addr_s &peer, send_func send)
+        : coap_(alloc, free, &client_tx, &client_rx), peer_(peer), send_(std::move(send))
+    {
+    }
+
+    coap_client(const coap_client &) = delete;
+    coap_client &operator=(const coap_client &) = delete;
+
+    ~coap_client()
+    {
+        closing_ = true;
+        while (!pending_.empty()) {
+            complete(pending_.front(), coap_message());
+        }
+    }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(coap_); }
+
+    coap_handle &handle() noexcept { return coap_; }
+
+    /**
+     * \brief Time after which an unanswered request completes empty, in seconds of exec() time base
+     */
+    void set_timeout(uint32_t seconds) noexcept { timeout_ = seconds; }
+
+    /**
+     * \brief Number of requests waiting for a response
+     */
+    std::size_t outstanding() const noexcept { return pending_.size(); }
+
+    request get(std::string_view path);
+    request post(std::string_view path, byte_view payload, sn_coap_content_format_e format = COAP_CT_TEXT_PLAIN);
+    request put(std::string_view path, byte_view payload, sn_coap_content_format_e format = COAP_CT_TEXT_PLAIN);
+    request del(std::string_view path);
+
+    /**
+     * \brief Request with all fields set by caller. Token is set by the client.
+     */
+    request send(coap_message &&message);
+
+    /**
+     * \brief Processes a datagram received from the peer. Completes the request it answers.
+     *
+     * \return true if datagram was a response to an outstanding request
+     */
+    bool input(span<uint8_t> datagram)
+    {
+        coap_message message = coap_.parse(datagram, peer_.get(), this);
+
+        if (!message) {
+            return false;
+        }
+        if (message.type() == COAP_MSG_TYPE_CONFIRMABLE && message.code() > COAP_MSG_CODE_REQUEST_DELETE) {
+            acknowledge(message.msg_id());
+        }
+        if (message.type() == COAP_MSG_TYPE_RESET) {
+            return fail_msg_id(message.msg_id());
+        }
+        if (message.code() <= COAP_MSG_CODE_REQUEST_DELETE ||
+                (message.status() != COAP_STATUS_OK && message.status() != COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED)) {
+            /* Empty ACK of a separate response, requests from peer, duplicates and blocks */
+            return false;
+        }
+
+        request *waiting = find_token(message.token());
+        if (!waiting) {
+            return false;
+        }
+        complete(waiting, std::move(message));
+        return true;
+    }
+
+    /**
+     * \brief Resends and times out requests, see sn_coap_protocol_exec()
+     *
+     * \param current_time Time in seconds
+     */
+    void exec(uint32_t current_time);
+
+private:
+    static uint8_t client_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+    {
+        coap_client *client = static_cast<coap_client *>(param);
+
+        return client && client->send_(byte_view(packet_ptr, packet_len), *address_ptr);
+    }
+
+    /* Resending gave up, message is released by the library after this */
+    static int8_t client_rx(sn_coap_hdr_s *message, sn_nsdl_addr_s *address_ptr, void *param)
+    {
+        coap_client *client = static_cast<coap_client *>(param);
+
+        if (client && message->coap_status == COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED) {
+            request *waiting = client->find_token(byte_view(message->token_ptr, message->token_len));
+            if (waiting) {
+                client->complete(waiting, coap_message());
+            }
+        }
+        return 0;
+    }
+
+    request *find_token(byte_view token) noexcept;
+    bool fail_msg_id(uint16_t msg_id);
+    void complete(request *waiting, coap_message &&response);
+
+    void acknowledge(uint16_t msg_id)
+    {
+        coap_message ack = coap_.create_message();
+
+        if (ack) {
+            ack.set_type(COAP_MSG_TYPE_ACKNOWLEDGEMENT);
+            ack.set_code(COAP_MSG_CODE_EMPTY);
+            ack.set_msg_id(msg_id);
+            std::vector<uint8_t> datagram = coap_.build(ack, peer_.get(), this);
+            if (!datagram.empty()) {
+                send_(datagram, peer_.get());
+            }
+        }
+    }
+
+    coap_message create(sn_coap_msg_code_e code, std::string_view path)
+    {
+        coap_message message = coap_.create_message();
+
+        if (!path.empty() && path.front() == '/') {
+            path.remove_prefix(1);
+        }
+        if (message && (path.empty() || message.set_uri_path(path))) {
+            message.set_type(COAP_MSG_TYPE_CONFIRMABLE);
+            message.set_code(code);
+            return message;
+        }
+        return coap_message();
+    }
+
+    coap_handle coap_;
+    address peer_;
+    send_func send_;
+    std::vector<request *> pending_;
+    uint32_t timeout_ = default_timeout;
+    uint32_t now_ = 0;
+    uint32_t next_token_ = 1;
+    bool closing_ = false;
+};
+
+/**
+ * \brief Awaitable request of coap_client. Result is the response, empty on failure.
+ *
+ * Request is sent when awaited. Payload given to the request must stay valid until then.
+ */
+class coap_client::request {
+public:
+    request(const request &) = delete;
+    request &operator=(const request &) = delete;
+
+    bool await_ready() const noexcept { return !message_; }
+
+    bool await_suspend(std::coroutine_handle<> waiter)
+    {
+        uint8_t token[4] = {
+            static_cast<uint8_t>(client_->next_token_ >> 24), static_cast<uint8_t>(client_->next_token_ >> 16),
+            static_cast<uint8_t>(client_->next_token_ >> 8), static_cast<uint8_t>(client_->next_token_)
+        };
+
+        client_->next_token_++;
+        if (!message_.token().empty() || !message_.set_token(token)) {
+            return false;
+        }
+        std::vector<uint8_t> datagram = client_->coap_.build(message_, client_->peer_.get(), client_);
+        if (datagram.empty()) {
+            return false;
+        }
+
+        token_ = (uint32_t(token[0]) << 24) | (uint32_t(token[1]) << 16) | (uint32_t(token[2]) << 8) | token[3];
+        msg_id_ = message_.msg_id();
+        deadline_ = client_->now_ + client_->timeout_;
+        waiter_ = waiter;
+        message_.reset();
+
+        if (!client_->send_(datagram, client_->peer_.get())) {
+            sn_coap_protocol_delete_retransmission(client_->coap_.get(), msg_id_);
+            return false;
+        }
+        client_->pending_.push_back(this);
+        return true;
+    }
+
+    coap_message await_resume() noexcept { return std::move(response_); }
+
+private:
+    friend class coap_client;
+
+    request(coap_client *client, coap_message &&message) noexcept
+        : client_(client), message_(client->closing_ ? coap_message() : std::move(message))
+    {
+    }
+
+    coap_client *client_;
+    coap_message message_;
+    coap_message response_;
+    std::coroutine_handle<> waiter_;
+    uint32_t token_ = 0;
+    uint32_t deadline_ = 0;
+    uint16_t msg_id_ = 0;
+};
+
+inline coap_client::request coap_client::get(std::string_view path)
+{
+    return request(this, create(COAP_MSG_CODE_REQUEST_GET, path));
+}
+
+inline coap_client::request coap_client::post(std::string_view path, byte_view payload, sn_coap_content_format_e format)
+{
+    coap_message message = create(COAP_MSG_CODE_REQUEST_POST, path);
+
+    if (message) {
+        message.set_payload(payload);
+        message.set_content_format(format);
+    }
+    return request(this, std::move(message));
+}
+
+inline coap_client::request coap_client::put(std::string_view path, byte_view payload, sn_coap_content_format_e format)
+{
+    coap_message message = create(COAP_MSG_CODE_REQUEST_PUT, path);
+
+    if (message) {
+        message.set_payload(payload);
+        message.set_content_format(format);
+    }
+    return request(this, std::move(message));
+}
+
+inline coap_client::request coap_client::del(std::string_view path)
+{
+    return request(this, create(COAP_MSG_CODE_REQUEST_DELETE, path));
+}
+
+inline coap_client::request coap_client::send(coap_message &&message)
+{
+    return request(this, std::move(message));
+}
+
+inline void coap_client::exec(uint32_t current_time)
+{
+    std::vector<request *> expired;
+
+    now_ = current_time;
+    coap_.exec(current_time);
+
+    for (request *waiting : pending_) {
+        if (static_cast<int32_t>(current_time - waiting->deadline_) >= 0) {
+            expired.push_back(waiting);
+        }
+    }
+    /* Resumed coroutines may complete or add other requests */
+    for (request *waiting : expired) {
+        if (std::find(pending_.begin(), pending_.end(), waiting) != pending_.end()) {
+            sn_coap_protocol_delete_retransmission(coap_.get(), waiting->msg_id_);
+            complete(waiting, coap_message());
+        }
+    }
+}
+
+inline coap_client::request *coap_client::find_token(byte_view token) noexcept
+{
+    if (token.size() != 4) {
+        return nullptr;
+    }
+    uint32_t value = (uint32_t(token[0]) << 24) | (uint32_t(token[1]) << 16) | (uint32_t(token[2]) << 8) | token[3];
+    for (request *waiting : pending_) {
+        if (waiting->token_ == value) {
+            return waiting;
+        }
+    }
+    return nullptr;
+}
+
+inline bool coap_client::fail_msg_id(uint16_t msg_id)
+{
+    for (request *waiting : pending_) {
+        if (waiting->msg_id_ == msg_id) {
+            complete(waiting, coap_message());
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void coap_client::complete(request *waiting, coap_message &&response)
+{
+    pending_.erase(std::find(pending_.begin(), pending_.end(), waiting));
+    waiting->response_ = std::move(response);
+    waiting->waiter_.resume();
+}
+
+class coap_server;
+
+namespace detail {
+
+/* Cleared when server is destroyed, so that late responses are dropped */
+struct server_link {
+    struct nsdl_s *nsdl;
+};
+
+struct exchange {
+    exchange(std::shared_ptr<server_link> link, const sn_coap_hdr_s &request, const sn_nsdl_addr_s &src)
+        : link(std::move(link)),
+          peer(src),
+          token(request.token_ptr, request.token_ptr + request.token_len),
+          uri_path(reinterpret_cast<const char *>(request.uri_path_ptr), request.uri_path_ptr ? request.uri_path_len : 0),
+          payload(request.payload_ptr, request.payload_ptr + (request.payload_ptr ? request.payload_len : 0)),
+          code(request.msg_code),
+          type(request.msg_type),
+          content_format(request.content_format),
+          observe(request.options_list_ptr ? request.options_list_ptr->observe : -1),
+          msg_id(request.msg_id)
+    {
+    }
+
+    exchange(const exchange &) = delete;
+    exchange &operator=(const exchange &) = delete;
+
+    /* Handler finished without a response */
+    ~exchange()
+    {
+        if (!responded) {
+            respond(COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR, byte_view(), COAP_CT_NONE);
+        }
+    }
+
+    bool respond(sn_coap_msg_code_e response_code, byte_view response_payload, sn_coap_content_format_e format)
+    {
+        sn_coap_hdr_s response = sn_coap_hdr_s();
+
+        if (responded || !link->nsdl) {
+            return false;
+        }
+        responded = true;
+        response.msg_code = response_code;
+        response.content_format = format;
+        response.token_ptr = token.empty() ? nullptr : token.data();
+        response.token_len = static_cast<uint8_t>(token.size());
+        response.payload_ptr = const_cast<uint8_t *>(response_payload.data());
+        response.payload_len = static_cast<sn_coap_len_t>(response_payload.size());
+        if (type == COAP_MSG_TYPE_CONFIRMABLE && !acknowledged) {
+            response.msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+            response.msg_id = msg_id;
+        } else {
+            response.msg_type = type == COAP_MSG_TYPE_CONFIRMABLE ? COAP_MSG_TYPE_CONFIRMABLE : COAP_MSG_TYPE_NON_CONFIRMABLE;
+        }
+        return sn_nsdl_send_coap_message(link->nsdl, &peer.get(), &response) == 0;
+    }
+
+    /* Request is answered later, stop peer from resending it */
+    void acknowledge()
+    {
+        sn_coap_hdr_s ack = sn_coap_hdr_s();
+
+        ack.msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+        ack.msg_code = COAP_MSG_CODE_EMPTY;
+        ack.msg_id = msg_id;
+        ack.content_format = COAP_CT_NONE;
+        if (sn_nsdl_send_coap_message(link->nsdl, &peer.get(), &ack) == 0) {
+            acknowledged = true;
+        }
+    }
+
+    std::shared_ptr<server_link> link;
+    address peer;
+    std::vector<uint8_t> token;
+    std::string uri_path;
+    std::vector<uint8_t> payload;
+    sn_coap_msg_code_e code;
+    sn_coap_msg_type_e type;
+    sn_coap_content_format_e content_format;
+    int32_t observe;
+    uint16_t msg_id;
+    bool acknowledged = false;
+    bool responded = false;
+};
+
+} // namespace detail
+
+/**
+ * \brief Request given to a coroutine resource handler.
+ *
+ * Fields are copied from the received message, so they stay valid while the
+ * handler is suspended. Copies refer to the same exchange. If the last copy is
+ * destroyed before respond() is called, 5.00 Internal Server Error is sent.
+ */
+class server_request {
+public:
+    sn_coap_msg_code_e code() const noexcept { return exchange_->code; }
+    sn_coap_msg_type_e type() const noexcept { return exchange_->type; }
+    sn_coap_content_format_e content_format() const noexcept { return exchange_->content_format; }
+    int32_t observe() const noexcept { return exchange_->observe; }
+    std::string_view uri_path() const noexcept { return exchange_->uri_path; }
+    byte_view token() const noexcept { return exchange_->token; }
+    byte_view payload() const noexcept { return exchange_->payload; }
+    bool responded() const noexcept { return exchange_->responded; }
+
+    /**
+     * \brief Sends the response. Payload is copied while sending.
+     *
+     * \return true on success, false if already responded, server is gone or sending failed
+     */
+    bool respond(sn_coap_msg_code_e code, byte_view payload = byte_view(),
+                 sn_coap_content_format_e format = COAP_CT_NONE)
+    {
+        return exchange_->respond(code, payload, format);
+    }
+
+private:
+    friend class coap_server;
+
+    explicit server_request(std::shared_ptr<detail::exchange> exchange) noexcept : exchange_(std::move(exchange)) {}
+
+    std::shared_ptr<detail::exchange> exchange_;
+};
+
+/**
+ * \brief Serves dynamic resources of an NSDL handle with coroutine handlers.
+ *
+ * Resource callbacks of the C API have no context pointer, so servers are
+ * found by NSDL handle. Requests arriving through sessions sharing the
+ * resource store are answered with 4.04.
+ */
+class coap_server {
+public:
+    using handler = std::function<task<>(server_request)>;
+
+    explicit coap_server(struct nsdl_s *nsdl)
+        : link_(std::make_shared<detail::server_link>(detail::server_link{nsdl}))
+    {
+        registry().push_back(this);
+    }
+
+    coap_server(const coap_server &) = delete;
+    coap_server &operator=(const coap_server &) = delete;
+
+    ~coap_server()
+    {
+        std::vector<coap_server *> &servers = registry();
+
+        for (std::size_t i = 0; i < servers.size(); i++) {
+            if (servers[i] == this) {
+                servers.erase(servers.begin() + i);
+                break;
+            }
+        }
+        for (const route &entry : routes_) {
+            sn_nsdl_delete_resource(link_->nsdl, static_cast<uint16_t>(entry.path.size()),
+                                    reinterpret_cast<uint8_t *>(const_cast<char *>(entry.path.data())));
+        }
+        link_->nsdl = nullptr;
+    }
+
+    /**
+     * \brief Creates a dynamic resource served by handler
+     *
+     * \param path          Resource path, e.g. "3303/0/5700"
+     * \param access        SN_GRS_GET_ALLOWED etc.
+     * \param handle_request Called for each request, usually a coroutine function
+     * \param observable    Resource is observable
+     *
+     * \return true on success, false on failure
+     */
+    bool add_resource(std::string_view path, uint8_t access, handler handle_request, bool observable = false)
+    {
+        sn_nsdl_resource_info_s resource = sn_nsdl_resource_info_s();
+        sn_nsdl_resource_parameters_s parameters = sn_nsdl_resource_parameters_s();
+
+        /* Library stores path without leading and trailing slashes, as they are in requests */
+        while (!path.empty() && path.front() == '/') {
+            path.remove_prefix(1);
+        }
+        while (!path.empty() && path.back() == '/') {
+            path.remove_suffix(1);
+        }
+        if (path.empty() || path.size() > UINT16_MAX || !handle_request) {
+            return false;
+        }
+        routes_.push_back(route{std::string(path), std::move(handle_request)});
+        parameters.observable = observable;
+        resource.resource_parameters_ptr = &parameters;
+        resource.mode = SN_GRS_DYNAMIC;
+        resource.access = access;
+        resource.publish_uri = 1;
+        resource.path = reinterpret_cast<uint8_t *>(routes_.back().path.data());
+        resource.pathlen = static_cast<uint16_t>(path.size());
+        resource.sn_grs_dyn_res_callback = &dispatch;
+        if (sn_nsdl_create_resource(link_->nsdl, &resource) != 0) {
+            routes_.pop_back();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct route {
+        std::string path;
+        handler handle_request;
+    };
+
+    static std::vector<coap_server *> &registry()
+    {
+        static std::vector<coap_server *> servers;
+        return servers;
+    }
+
+    /* Request is released by the library when this returns */
+    static uint8_t dispatch(struct nsdl_s *nsdl, sn_coap_hdr_s *request, sn_nsdl_addr_s *src, sn_nsdl_capab_e protocol)
+    {
+        const handler *found = nullptr;
+        std::shared_ptr<detail::server_link> link;
+        std::string_view path(reinterpret_cast<const char *>(request->uri_path_ptr), request->uri_path_ptr ? request->uri_path_len : 0);
+
+        (void) protocol;
+        for (coap_server *server : registry()) {
+            if (server->link_->nsdl != nsdl) {
+                continue;
+            }
+            for (const route &entry : server->routes_) {
+                if (entry.path == path) {
+                    found = &entry.handle_request;
+                    link = server->link_;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            sn_coap_hdr_s *response = sn_nsdl_build_response(nsdl, request, COAP_MSG_CODE_RESPONSE_NOT_FOUND);
+            if (response) {
+                sn_nsdl_send_coap_message(nsdl, src, response);
+                sn_nsdl_release_allocated_coap_msg_mem(nsdl, response);
+            }
+            return 0;
+        }
+
+        std::shared_ptr<detail::exchange> exchange = std::make_shared<detail::exchange>(link, *request, *src);
+
+        /* Runs until the handler completes or suspends */
+        spawn((*found)(server_request(exchange)));
+
+        if (!exchange->responded && exchange.use_count() > 1 && exchange->type == COAP_MSG_TYPE_CONFIRMABLE) {
+            exchange->acknowledge();
+        }
+        return 0;
+    }
+
+    std::shared_ptr<detail::server_link> link_;
+    std::vector<route> routes_;
+};
+
+} // namespace sn
+
+#endif /* SN_CORO_HPP_ */
@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file sn_cpp.hpp
+ *
+ * \brief Header-only C++17 layer over the CoAP and NSDL C API.
+ *
+ * Library handles and CoAP messages are move-only owners, released in their
+ * destructors. Tokens, paths and payloads are read through span and
+ * string_view views without copying. Ownership rules of the C API are
+ * followed by the owners:
+ *  - payload of COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED is freed with the message
+ *  - option strings set with borrow_*() are never freed by the library
+ *  - a message parsed from a datagram moved into it keeps the datagram alive,
+ *    so views stay valid as long as the message
+ *
+ * Raw C structures are reachable with get(), and release() hands ownership
+ * back to C code, which then follows the C API rules.
+ *
+ * Nothing here throws; failures are empty handles, empty messages and
+ * empty vectors.
+ */
+
+#ifndef SN_CPP_HPP_
+#define SN_CPP_HPP_
+
+#if !defined(__cplusplus) || __cplusplus < 201703L
+#error "sn_cpp.hpp needs C++17"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if __has_include(<version>)
+#include <version>
+#endif
+#ifdef __cpp_lib_span
+#include <span>
+#endif
+
+#include "ns_types.h"
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+
+namespace sn {
+
+#ifdef __cpp_lib_span
+template <typename T>
+using span = std::span<T>;
+#else
+/**
+ * \brief Non-owning view of contiguous elements, subset of C++20 std::span.
+ */
+template <typename T>
+class span {
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T *;
+
+    constexpr span() noexcept : data_(nullptr), size_(0) {}
+    constexpr span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+    template <typename U, std::size_t N, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr span(U (&array)[N]) noexcept : data_(array), size_(N) {}
+
+    template <typename Container, typename = std::enable_if_t<
+                  std::is_convertible_v<decltype(std::declval<Container &>().data()), T *>>>
+    constexpr span(Container &container) noexcept : data_(container.data()), size_(container.size()) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr span(const span<U> &other) noexcept : data_(other.data()), size_(other.size()) {}
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T &operator[](std::size_t index) const noexcept { return data_[index]; }
+    constexpr iterator begin() const noexcept { return data_; }
+    constexpr iterator end() const noexcept { return data_ + size_; }
+
+private:
+    T *data_;
+    std::size_t size_;
+};
+#endif
+
+using byte_view = span<const uint8_t>;
+
+class coap_handle;
+
+/**
+ * \brief Move-only owner of a sn_coap_hdr_s allocated by a CoAP handle.
+ *
+ * Views returned by accessors are valid until the message is modified,
+ * released or destroyed. If the message was parsed from a borrowed datagram,
+ * payload view is also bound to the datagram.
+ */
+class coap_message {
+public:
+    coap_message() noexcept = default;
+
+    coap_message(coap_message &&other) noexcept
+    {
+        take(other);
+    }
+
+    coap_message &operator=(coap_message &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    coap_message(const coap_message &) = delete;
+    coap_message &operator=(const coap_message &) = delete;
+
+    ~coap_message()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept { return hdr_ != nullptr; }
+
+    /**
+     * \brief Raw message for fields without accessor. Ownership stays here.
+     */
+    sn_coap_hdr_s *get() const noexcept { return hdr_; }
+
+    /**
+     * \brief Gives up ownership. Caller must release the message with
+     *        sn_coap_parser_release_allocated_coap_msg_mem(), after freeing payload of
+     *        a COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED message and setting borrowed
+     *        option pointers to NULL. Owned datagram is freed here.
+     */
+    sn_coap_hdr_s *release() noexcept
+    {
+        sn_coap_hdr_s *hdr = hdr_;
+
+        hdr_ = nullptr;
+        borrowed_ = 0;
+        owns_payload_ = false;
+        datagram_.clear();
+        return hdr;
+    }
+
+    /**
+     * \brief Releases the message, object becomes empty
+     */
+    void reset() noexcept
+    {
+        if (hdr_) {
+            free_payload();
+            if (hdr_->options_list_ptr) {
+                if (borrowed_ & borrowed_uri_query) {
+                    hdr_->options_list_ptr->uri_query_ptr = nullptr;
+                }
+                if (borrowed_ & borrowed_location_path) {
+                    hdr_->options_list_ptr->location_path_ptr = nullptr;
+                }
+                if (borrowed_ & borrowed_location_query) {
+                    hdr_->options_list_ptr->location_query_ptr = nullptr;
+                }
+            }
+            sn_coap_parser_release_allocated_coap_msg_mem(coap_, hdr_);
+        }
+        hdr_ = nullptr;
+        borrowed_ = 0;
+        datagram_.clear();
+    }
+
+    sn_coap_msg_type_e type() const noexcept { return hdr_->msg_type; }
+    sn_coap_msg_code_e code() const noexcept { return hdr_->msg_code; }
+    uint16_t msg_id() const noexcept { return hdr_->msg_id; }
+    sn_coap_status_e status() const noexcept { return hdr_->coap_status; }
+    sn_coap_content_format_e content_format() const noexcept { return hdr_->content_format; }
+
+    /**
+     * \brief Observe option, -1 when not present
+     */
+    int32_t observe() const noexcept
+    {
+        return hdr_->options_list_ptr ? hdr_->options_list_ptr->observe : -1;
+    }
+
+    byte_view token() const noexcept { return byte_view(hdr_->token_ptr, hdr_->token_len); }
+    std::string_view uri_path() const noexcept { return view(hdr_->uri_path_ptr, hdr_->uri_path_len); }
+    byte_view payload() const noexcept { return byte_view(hdr_->payload_ptr, hdr_->payload_len); }
+
+    std::string_view uri_query() const noexcept
+    {
+        return hdr_->options_list_ptr ? view(hdr_->options_list_ptr->uri_query_ptr, hdr_->options_list_ptr->uri_query_len) : std::string_view();
+    }
+
+    std::string_view location_path() const noexcept
+    {
+        return hdr_->options_list_ptr ? view(hdr_->options_list_ptr->location_path_ptr, hdr_->options_list_ptr->location_path_len) : std::string_view();
+    }
+
+    void set_type(sn_coap_msg_type_e type) noexcept { hdr_->msg_type = type; }
+    void set_code(sn_coap_msg_code_e code) noexcept { hdr_->msg_code = code; }
+    void set_msg_id(uint16_t msg_id) noexcept { hdr_->msg_id = msg_id; }
+    void set_content_format(sn_coap_content_format_e format) noexcept { hdr_->content_format = format; }
+
+    /**
+     * \brief Stores a copy of token
+     *
+     * \return true on success, false if out of memory or token is longer than 8 bytes
+     */
+    bool set_token(byte_view token) noexcept
+    {
+        return token.size() <= 8 &&
+               sn_coap_parser_set_token(coap_, hdr_, token.data(), static_cast<uint8_t>(token.size())) == 0;
+    }
+
+    /**
+     * \brief Stores a copy of uri path
+     *
+     * \return true on success, false if out of memory
+     */
+    bool set_uri_path(std::string_view path) noexcept
+    {
+        return path.size() <= UINT16_MAX &&
+               sn_coap_parser_set_uri_path(coap_, hdr_, reinterpret_cast<const uint8_t *>(path.data()),
+                                           static_cast<uint16_t>(path.size())) == 0;
+    }
+
+    /**
+     * \brief Refers to payload without copying, it must stay valid until the message is built
+     */
+    void set_payload(byte_view payload) noexcept
+    {
+        free_payload();
+        hdr_->payload_ptr = const_cast<uint8_t *>(payload.data());
+        hdr_->payload_len = static_cast<sn_coap_len_t>(payload.size());
+    }
+
+    /**
+     * \brief Refer to option strings without copying, they must stay valid until the message
+     *        is built. They are not freed with the message.
+     *
+     * \return true on success, false if out of memory
+     */
+    bool borrow_uri_query(std::string_view query) noexcept
+    {
+        return borrow(query, &sn_coap_options_list_s::uri_query_ptr, &sn_coap_options_list_s::uri_query_len, borrowed_uri_query);
+    }
+
+    bool borrow_location_path(std::string_view path) noexcept
+    {
+        return borrow(path, &sn_coap_options_list_s::location_path_ptr, &sn_coap_options_list_s::location_path_len, borrowed_location_path);
+    }
+
+    bool borrow_location_query(std::string_view query) noexcept
+    {
+        return borrow(query, &sn_coap_options_list_s::location_query_ptr, &sn_coap_options_list_s::location_query_len, borrowed_location_query);
+    }
+
+    /**
+     * \brief Sets observe option
+     *
+     * \return true on success, false if out of memory
+     */
+    bool set_observe(int32_t observe) noexcept
+    {
+        if (!sn_coap_parser_alloc_options(coap_, hdr_)) {
+            return false;
+        }
+        hdr_->options_list_ptr->observe = observe;
+        return true;
+    }
+
+private:
+    friend class coap_handle;
+
+    enum : uint8_t {
+        borrowed_uri_query      = 0x01,
+        borrowed_location_path  = 0x02,
+        borrowed_location_query = 0x04
+    };
+
+    coap_message(struct coap_s *coap, void (*free_func)(void *), sn_coap_hdr_s *hdr, std::vector<uint8_t> &&datagram) noexcept
+        : coap_(coap), free_(free_func), hdr_(hdr), datagram_(std::move(datagram))
+    {
+        /* Reassembled blockwise payload is allocated by the library, and freed by the application */
+        owns_payload_ = hdr_ && hdr_->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED && hdr_->payload_ptr;
+    }
+
+    static std::string_view view(const uint8_t *ptr, std::size_t len) noexcept
+    {
+        return ptr ? std::string_view(reinterpret_cast<const char *>(ptr), len) : std::string_view();
+    }
+
+    template <typename Len>
+    bool borrow(std::string_view value, uint8_t *sn_coap_options_list_s::*ptr_member,
+                Len sn_coap_options_list_s::*len_member, uint8_t flag) noexcept
+    {
+        sn_coap_options_list_s *options = sn_coap_parser_alloc_options(coap_, hdr_);
+
+        if (!options || value.size() > UINT16_MAX) {
+            return false;
+        }
+        if (!(borrowed_ & flag) && options->*ptr_member) {
+            free_(options->*ptr_member);
+        }
+        options->*ptr_member = reinterpret_cast<uint8_t *>(const_cast<char *>(value.data()));
+        options->*len_member = static_cast<Len>(value.size());
+        borrowed_ |= flag;
+        return true;
+    }
+
+    void free_payload() noexcept
+    {
+        if (owns_payload_) {
+            free_(hdr_->payload_ptr);
+            hdr_->payload_ptr = nullptr;
+            hdr_->payload_len = 0;
+            owns_payload_ = false;
+        }
+    }
+
+    void take(coap_message &other) noexcept
+    {
+        coap_ = other.coap_;
+        free_ = other.free_;
+        hdr_ = std::exchange(other.hdr_, nullptr);
+        datagram_ = std::move(other.datagram_);
+        borrowed_ = std::exchange(other.borrowed_, 0);
+        owns_payload_ = std::exchange(other.owns_payload_, false);
+    }
+
+    struct coap_s *coap_ = nullptr;
+    void (*free_)(void *) = nullptr;
+    sn_coap_hdr_s *hdr_ = nullptr;
+    std::vector<uint8_t> datagram_;
+    uint8_t borrowed_ = 0;
+    bool owns_payload_ = false;
+};
+
+/**
+ * \brief Move-only owner of a CoAP library handle, see sn_coap_protocol_init().
+ *
+ * Messages created by a handle must be destroyed before it.
+ */
+class coap_handle {
+public:
+    using alloc_func = void *(*)(sn_coap_len_t);
+    using free_func = void (*)(void *);
+    using tx_func = uint8_t (*)(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *);
+    using rx_func = int8_t (*)(sn_coap_hdr_s *, sn_nsdl_addr_s *, void *);
+
+    coap_handle(alloc_func alloc, free_func free, tx_func tx, rx_func rx = nullptr) noexcept
+        : coap_(sn_coap_protocol_init(alloc, free, tx, rx)), free_(free)
+    {
+    }
+
+    coap_handle(coap_handle &&other) noexcept
+        : coap_(std::exchange(other.coap_, nullptr)), free_(other.free_)
+    {
+    }
+
+    coap_handle &operator=(coap_handle &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            coap_ = std::exchange(other.coap_, nullptr);
+            free_ = other.free_;
+        }
+        return *this;
+    }
+
+    coap_handle(const coap_handle &) = delete;
+    coap_handle &operator=(const coap_handle &) = delete;
+
+    ~coap_handle()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept { return coap_ != nullptr; }
+    struct coap_s *get() const noexcept { return coap_; }
+
+    void reset() noexcept
+    {
+        if (coap_) {
+            sn_coap_protocol_destroy(coap_);
+            coap_ = nullptr;
+        }
+    }
+
+    /**
+     * \brief Parses a datagram with protocol handling, see sn_coap_protocol_parse().
+     *        Message payload refers to the datagram, which must outlive the message.
+     */
+    coap_message parse(span<uint8_t> datagram, sn_nsdl_addr_s &src, void *param = nullptr) noexcept
+    {
+        return wrap(datagram.size() <= UINT16_MAX ?
+                    sn_coap_protocol_parse(coap_, &src, static_cast<uint16_t>(datagram.size()), datagram.data(), param) : nullptr, {});
+    }
+
+    /**
+     * \brief Parses a datagram with protocol handling. Datagram is moved into the message.
+     */
+    coap_message parse(std::vector<uint8_t> &&datagram, sn_nsdl_addr_s &src, void *param = nullptr) noexcept
+    {
+        sn_coap_hdr_s *hdr = datagram.size() <= UINT16_MAX ?
+                             sn_coap_protocol_parse(coap_, &src, static_cast<uint16_t>(datagram.size()), datagram.data(), param) : nullptr;
+        return wrap(hdr, std::move(datagram));
+    }
+
+    /**
+     * \brief Parses a datagram without protocol handling, see sn_coap_parser().
+     *        Message payload refers to the datagram, which must outlive the message.
+     */
+    coap_message parse_packet(span<uint8_t> datagram) noexcept
+    {
+        coap_version_e version = COAP_VERSION_UNKNOWN;
+
+        return wrap(datagram.size() <= UINT16_MAX ?
+                    sn_coap_parser(coap_, static_cast<uint16_t>(datagram.size()), datagram.data(), &version) : nullptr, {});
+    }
+
+    /**
+     * \brief Parses a datagram without protocol handling. Datagram is moved into the message.
+     */
+    coap_message parse_packet(std::vector<uint8_t> &&datagram) noexcept
+    {
+        coap_version_e version = COAP_VERSION_UNKNOWN;
+        sn_coap_hdr_s *hdr = datagram.size() <= UINT16_MAX ?
+                             sn_coap_parser(coap_, static_cast<uint16_t>(datagram.size()), datagram.data(), &version) : nullptr;
+        return wrap(hdr, std::move(datagram));
+    }
+
+    /**
+     * \brief Empty message, see sn_coap_parser_alloc_message()
+     */
+    coap_message create_message() noexcept
+    {
+        return wrap(sn_coap_parser_alloc_message(coap_), {});
+    }
+
+    /**
+     * \brief Response to a request, see sn_coap_build_response()
+     */
+    coap_message create_response(const coap_message &request, sn_coap_msg_code_e code) noexcept
+    {
+        return wrap(request ? sn_coap_build_response(coap_, request.get(), code) : nullptr, {});
+    }
+
+    /**
+     * \brief Takes ownership of a message allocated by this handle, e.g. one given to RX callback
+     *        with COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED
+     */
+    coap_message adopt(sn_coap_hdr_s *hdr) noexcept
+    {
+        return wrap(hdr, {});
+    }
+
+    /**
+     * \brief Builds a datagram, see sn_coap_protocol_build(). Confirmable messages are stored
+     *        for resending as with the C API. Payload longer than the block size needs block
+     *        option set in the message, the way sn_nsdl prepares it.
+     *
+     * \return Datagram, empty on failure
+     */
+    std::vector<uint8_t> build(const coap_message &message, sn_nsdl_addr_s &dst, void *param = nullptr)
+    {
+        std::vector<uint8_t> datagram;
+        uint16_t size = message ? sn_coap_builder_calc_needed_packet_data_size(message.get()) : 0;
+        int16_t len;
+
+        if (!size) {
+            return datagram;
+        }
+        datagram.resize(size);
+        len = sn_coap_protocol_build(coap_, &dst, datagram.data(), message.get(), param);
+        datagram.resize(len > 0 ? static_cast<std::size_t>(len) : 0);
+        return datagram;
+    }
+
+    int8_t exec(uint32_t current_time) noexcept
+    {
+        return sn_coap_protocol_exec(coap_, current_time);
+    }
+
+private:
+    coap_message wrap(sn_coap_hdr_s *hdr, std::vector<uint8_t> &&datagram) noexcept
+    {
+        if (!hdr) {
+            return coap_message();
+        }
+        return coap_message(coap_, free_, hdr, std::move(datagram));
+    }
+
+    struct coap_s *coap_;
+    free_func free_;
+};
+
+/**
+ * \brief Move-only owner of an NSDL library handle, see sn_nsdl_init().
+ */
+class nsdl_handle {
+public:
+    using alloc_func = void *(*)(sn_coap_len_t);
+    using free_func = void (*)(void *);
+    using tx_func = uint8_t (*)(struct nsdl_s *, sn_nsdl_capab_e, uint8_t *, uint16_t, sn_nsdl_addr_s *);
+    using rx_func = uint8_t (*)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *);
+
+    nsdl_handle(tx_func tx, rx_func rx, alloc_func alloc, free_func free) noexcept
+        : nsdl_(sn_nsdl_init(tx, rx, alloc, free))
+    {
+    }
+
+    nsdl_handle(nsdl_handle &&other) noexcept
+        : nsdl_(std::exchange(other.nsdl_, nullptr))
+    {
+    }
+
+    nsdl_handle &operator=(nsdl_handle &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            nsdl_ = std::exchange(other.nsdl_, nullptr);
+        }
+        return *this;
+    }
+
+    nsdl_handle(const nsdl_handle &) = delete;
+    nsdl_handle &operator=(const nsdl_handle &) = delete;
+
+    ~nsdl_handle()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept { return nsdl_ != nullptr; }
+    struct nsdl_s *get() const noexcept { return nsdl_; }
+
+    void reset() noexcept
+    {
+        if (nsdl_) {
+            sn_nsdl_destroy(nsdl_);
+            nsdl_ = nullptr;
+        }
+    }
+
+    /**
+     * \brief Processes a received datagram, see sn_nsdl_process_coap()
+     */
+    int8_t process(span<uint8_t> datagram, sn_nsdl_addr_s &src) noexcept
+    {
+        if (datagram.size() > UINT16_MAX) {
+            return SN_NSDL_FAILURE;
+        }
+        return sn_nsdl_process_coap(nsdl_, datagram.data(), static_cast<uint16_t>(datagram.size()), &src);
+    }
+
+    int8_t exec(uint32_t time) noexcept
+    {
+        return sn_nsdl_exec(nsdl_, time);
+    }
+
+    /**
+     * \brief Sends a notification, see sn_nsdl_send_observation_notification().
+     *        Token and payload are only read.
+     *
+     * \return Message ID of the notification, 0 on failure
+     */
+    uint16_t send_notification(byte_view token, byte_view payload, sn_coap_observe_e observe,
+                               sn_coap_msg_type_e type = COAP_MSG_TYPE_CONFIRMABLE,
+                               sn_coap_content_format_e content_format = COAP_CT_TEXT_PLAIN) noexcept
+    {
+        if (token.size() > 8) {
+            return 0;
+        }
+        return sn_nsdl_send_observation_notification(nsdl_, const_cast<uint8_t *>(token.data()), static_cast<uint8_t>(token.size()),
+                                                     const_cast<uint8_t *>(payload.data()), static_cast<sn_coap_len_t>(payload.size()),
+                                                     observe, type, content_format);
+    }
+
+private:
+    struct nsdl_s *nsdl_;
+};
+
+} // namespace sn
+
+#endif /* SN_CPP_HPP_ */
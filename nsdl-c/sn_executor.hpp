@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file sn_executor.hpp
+ *
+ * \brief Header-only C++17 dispatcher running dynamic resource handlers on a thread pool.
+ *
+ * Dynamic resource callbacks are called inside sn_nsdl_process_coap(), on the
+ * thread owning the NSDL handle. A slow callback delays every other handle
+ * served by that thread. With pool_dispatcher the callback only copies the
+ * request and queues it to a work_stealing_pool; the handler runs on a worker
+ * and its result is sent later as a separate response (RFC 7252, 5.2.2):
+ *
+ *   sn::work_stealing_pool pool(4);
+ *   sn::pool_dispatcher dispatcher(nsdl, pool, [&] { wake_event_loop(); });
+ *
+ *   dispatcher.add_resource("3303/0/5700", SN_GRS_GET_ALLOWED,
+ *                           [](const sn::pool_dispatcher::request &request) {
+ *                               return sn::pool_dispatcher::response{COAP_MSG_CODE_RESPONSE_CONTENT, read_sensor()};
+ *                           });
+ *
+ *   // Event loop of the owning thread
+ *   sn_nsdl_process_coap(nsdl, packet, len, &src);
+ *   dispatcher.poll();
+ *
+ * The library is used only on the owning thread: responses are collected to a
+ * completion queue and sent from poll(). Handlers must not call the library.
+ */
+
+#ifndef SN_EXECUTOR_HPP_
+#define SN_EXECUTOR_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sn_cpp.hpp"
+
+namespace sn {
+
+/**
+ * \brief Fixed size thread pool with a job deque per worker.
+ *
+ * Jobs submitted from a worker go to its own deque and are taken newest
+ * first, so follow-up work stays on a warm cache. Jobs submitted from other
+ * threads are spread round robin. An idle worker steals the oldest job of
+ * another worker before going to sleep.
+ *
+ * Destroying the pool runs all queued jobs and joins the workers. A job that
+ * throws terminates the program.
+ */
+class work_stealing_pool {
+public:
+    using job = std::function<void()>;
+
+    explicit work_stealing_pool(unsigned threads = std::thread::hardware_concurrency())
+    {
+        if (threads == 0) {
+            threads = 1;
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            queues_.push_back(std::make_unique<queue>());
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            workers_.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool &) = delete;
+    work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+    ~work_stealing_pool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(idle_lock_);
+            stopping_ = true;
+        }
+        idle_.notify_all();
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    /**
+     * \brief Queues a job, callable from any thread including workers
+     */
+    void submit(job work)
+    {
+        const current &self = current_worker();
+        std::size_t index;
+
+        if (self.pool == this) {
+            index = self.index;
+        } else {
+            index = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        }
+        {
+            std::lock_guard<std::mutex> guard(queues_[index]->lock);
+            queues_[index]->jobs.push_back(std::move(work));
+        }
+        {
+            std::lock_guard<std::mutex> guard(idle_lock_);
+            queued_++;
+        }
+        idle_.notify_one();
+    }
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    /**
+     * \brief Number of jobs taken from another worker's deque
+     */
+    uint64_t steals() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct queue {
+        std::mutex lock;
+        std::deque<job> jobs;
+    };
+
+    struct current {
+        const work_stealing_pool *pool;
+        std::size_t index;
+    };
+
+    static current &current_worker() noexcept
+    {
+        static thread_local current self = {nullptr, 0};
+        return self;
+    }
+
+    bool take(std::size_t index, job &work)
+    {
+        {
+            queue &own = *queues_[index];
+            std::lock_guard<std::mutex> guard(own.lock);
+
+            if (!own.jobs.empty()) {
+                work = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < queues_.size(); i++) {
+            queue &victim = *queues_[(index + i) % queues_.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+
+            if (!victim.jobs.empty()) {
+                work = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(std::size_t index)
+    {
+        current_worker() = current{this, index};
+        for (;;) {
+            job work;
+
+            if (take(index, work)) {
+                {
+                    std::lock_guard<std::mutex> guard(idle_lock_);
+                    queued_--;
+                }
+                work();
+                continue;
+            }
+            /* Counter is raised after the push, so a job seen here is found by some worker */
+            std::unique_lock<std::mutex> guard(idle_lock_);
+            idle_.wait(guard, [this] { return queued_ > 0 || stopping_; });
+            if (stopping_ && queued_ <= 0) {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex idle_lock_;
+    std::condition_variable idle_;
+    int64_t queued_ = 0;                /* May be briefly negative, guarded by idle_lock_ */
+    bool stopping_ = false;
+    std::atomic<std::size_t> next_{0};
+    std::atomic<uint64_t> steals_{0};
+};
+
+namespace detail {
+
+struct pool_completion;
+
+/* Shared by a dispatcher and its jobs, closed when the dispatcher is destroyed */
+struct completion_queue {
+    std::mutex lock;
+    std::vector<pool_completion> done;
+    std::function<void()> wake;
+    bool open = true;
+};
+
+} // namespace detail
+
+/**
+ * \brief Serves dynamic resources of an NSDL handle from a work_stealing_pool.
+ *
+ * Confirmable requests are acknowledged with an empty ACK when they are
+ * queued, and answered with a confirmable separate response. Non-confirmable
+ * requests get a non-confirmable response. Large responses are sent
+ * blockwise by the library as usual.
+ *
+ * A dispatcher belongs to the thread owning its NSDL handle; create it,
+ * add resources, process packets and call poll() there. Several threads may
+ * each run their own handles and dispatchers sharing one pool.
+ */
+class pool_dispatcher {
+public:
+    /**
+     * \brief Request given to a handler, copied from the received message
+     */
+    struct request {
+        std::string uri_path;
+        std::vector<uint8_t> token;
+        std::vector<uint8_t> payload;
+        sn_coap_msg_code_e code;
+        sn_coap_msg_type_e type;
+        sn_coap_content_format_e content_format;
+        int32_t observe;
+    };
+
+    struct response {
+        sn_coap_msg_code_e code;
+        std::vector<uint8_t> payload;
+        sn_coap_content_format_e content_format = COAP_CT_NONE;
+    };
+
+    /**
+     * \brief Runs on a pool worker. An exception is answered with 5.00.
+     */
+    using handler = std::function<response(const request &)>;
+
+    /**
+     * \param nsdl  NSDL handle, owned by the calling thread
+     * \param pool  Pool running the handlers, may be shared by several dispatchers
+     * \param wake  Called from a worker when a response is ready for poll(), e.g. to
+     *              write an eventfd of the event loop. Called with a lock held, keep it short.
+     */
+    pool_dispatcher(struct nsdl_s *nsdl, work_stealing_pool &pool, std::function<void()> wake = nullptr);
+
+    pool_dispatcher(const pool_dispatcher &) = delete;
+    pool_dispatcher &operator=(const pool_dispatcher &) = delete;
+
+    /* Handlers still running finish on the pool, their responses are dropped */
+    ~pool_dispatcher();
+
+    /**
+     * \brief Creates a dynamic resource served by handler
+     *
+     * \param path          Resource path, e.g. "3303/0/5700"
+     * \param access        SN_GRS_GET_ALLOWED etc.
+     * \param handle_request Called on a worker for each request
+     * \param observable    Resource is observable
+     *
+     * \return true on success, false on failure
+     */
+    bool add_resource(std::string_view path, uint8_t access, handler handle_request, bool observable = false);
+
+    /**
+     * \brief Sends responses of finished handlers
+     *
+     * \return Number of responses sent
+     */
+    std::size_t poll();
+
+    /**
+     * \brief Number of requests queued or running, whose response is not yet sent
+     */
+    std::size_t in_flight() const noexcept { return in_flight_; }
+
+private:
+    struct route {
+        std::string path;
+        std::shared_ptr<const handler> handle_request;
+    };
+
+    /* Callbacks run on the owning thread, so the registry is per thread */
+    static std::vector<pool_dispatcher *> &registry()
+    {
+        static thread_local std::vector<pool_dispatcher *> dispatchers;
+        return dispatchers;
+    }
+
+    static uint8_t dispatch(struct nsdl_s *nsdl, sn_coap_hdr_s *request, sn_nsdl_addr_s *src, sn_nsdl_capab_e protocol);
+
+    void send(detail::pool_completion &completed);
+
+    struct nsdl_s *nsdl_;
+    work_stealing_pool &pool_;
+    std::shared_ptr<detail::completion_queue> completions_;
+    std::vector<route> routes_;
+    std::size_t in_flight_ = 0;
+};
+
+namespace detail {
+
+struct pool_completion {
+    std::vector<uint8_t> peer_bytes;
+    sn_nsdl_addr_s peer;
+    std::vector<uint8_t> token;
+    sn_coap_msg_type_e type;
+    pool_dispatcher::response result;
+};
+
+} // namespace detail
+
+inline pool_dispatcher::pool_dispatcher(struct nsdl_s *nsdl, work_stealing_pool &pool, std::function<void()> wake)
+    : nsdl_(nsdl), pool_(pool), completions_(std::make_shared<detail::completion_queue>())
+{
+    completions_->wake = std::move(wake);
+    registry().push_back(this);
+}
+
+inline pool_dispatcher::~pool_dispatcher()
+{
+    std::vector<pool_dispatcher *> &dispatchers = registry();
+
+    for (std::size_t i = 0; i < dispatchers.size(); i++) {
+        if (dispatchers[i] == this) {
+            dispatchers.erase(dispatchers.begin() + i);
+            break;
+        }
+    }
+    for (const route &entry : routes_) {
+        sn_nsdl_delete_resource(nsdl_, static_cast<uint16_t>(entry.path.size()),
+                                reinterpret_cast<uint8_t *>(const_cast<char *>(entry.path.data())));
+    }
+    std::lock_guard<std::mutex> guard(completions_->lock);
+    completions_->open = false;
+    completions_->done.clear();
+}
+
+inline bool pool_dispatcher::add_resource(std::string_view path, uint8_t access, handler handle_request, bool observable)
+{
+    sn_nsdl_resource_info_s resource = sn_nsdl_resource_info_s();
+    sn_nsdl_resource_parameters_s parameters = sn_nsdl_resource_parameters_s();
+
+    while (!path.empty() && path.front() == '/') {
+        path.remove_prefix(1);
+    }
+    while (!path.empty() && path.back() == '/') {
+        path.remove_suffix(1);
+    }
+    if (path.empty() || path.size() > UINT16_MAX || !handle_request) {
+        return false;
+    }
+    routes_.push_back(route{std::string(path), std::make_shared<const handler>(std::move(handle_request))});
+    parameters.observable = observable;
+    resource.resource_parameters_ptr = &parameters;
+    resource.mode = SN_GRS_DYNAMIC;
+    resource.access = access;
+    resource.publish_uri = 1;
+    resource.path = reinterpret_cast<uint8_t *>(routes_.back().path.data());
+    resource.pathlen = static_cast<uint16_t>(path.size());
+    resource.sn_grs_dyn_res_callback = &dispatch;
+    if (sn_nsdl_create_resource(nsdl_, &resource) != 0) {
+        routes_.pop_back();
+        return false;
+    }
+    return true;
+}
+
+/* Request is released by the library when this returns */
+inline uint8_t pool_dispatcher::dispatch(struct nsdl_s *nsdl, sn_coap_hdr_s *received, sn_nsdl_addr_s *src,
+        sn_nsdl_capab_e protocol)
+{
+    pool_dispatcher *owner = nullptr;
+    const route *found = nullptr;
+    std::string_view path(reinterpret_cast<const char *>(received->uri_path_ptr),
+                          received->uri_path_ptr ? received->uri_path_len : 0);
+
+    (void) protocol;
+    for (pool_dispatcher *dispatcher : registry()) {
+        if (dispatcher->nsdl_ != nsdl) {
+            continue;
+        }
+        for (const route &entry : dispatcher->routes_) {
+            if (entry.path == path) {
+                owner = dispatcher;
+                found = &entry;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        sn_coap_hdr_s *response = sn_nsdl_build_response(nsdl, received, COAP_MSG_CODE_RESPONSE_NOT_FOUND);
+        if (response) {
+            sn_nsdl_send_coap_message(nsdl, src, response);
+            sn_nsdl_release_allocated_coap_msg_mem(nsdl, response);
+        }
+        return 0;
+    }
+
+    auto copied = std::make_shared<request>();
+    auto completed = std::make_shared<detail::pool_completion>();
+
+    copied->uri_path.assign(path.data(), path.size());
+    copied->token.assign(received->token_ptr, received->token_ptr + received->token_len);
+    if (received->payload_ptr) {
+        copied->payload.assign(received->payload_ptr, received->payload_ptr + received->payload_len);
+    }
+    copied->code = received->msg_code;
+    copied->type = received->msg_type;
+    copied->content_format = received->content_format;
+    copied->observe = received->options_list_ptr ? received->options_list_ptr->observe : -1;
+
+    completed->peer_bytes.assign(src->addr_ptr, src->addr_ptr + src->addr_len);
+    completed->peer = *src;
+    completed->token = copied->token;
+    completed->type = copied->type;
+
+    /* Stop the peer from resending while the handler runs */
+    if (received->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
+        sn_coap_hdr_s ack = sn_coap_hdr_s();
+
+        ack.msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+        ack.msg_code = COAP_MSG_CODE_EMPTY;
+        ack.msg_id = received->msg_id;
+        ack.content_format = COAP_CT_NONE;
+        sn_nsdl_send_coap_message(nsdl, src, &ack);
+    }
+
+    owner->in_flight_++;
+    owner->pool_.submit([copied, completed, handle_request = found->handle_request,
+                         completions = owner->completions_] {
+        try {
+            completed->result = (*handle_request)(*copied);
+        } catch (...) {
+            completed->result = response{COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR, {}};
+        }
+
+        std::lock_guard<std::mutex> guard(completions->lock);
+        if (completions->open) {
+            completions->done.push_back(std::move(*completed));
+            if (completions->wake) {
+                completions->wake();
+            }
+        }
+    });
+    return 0;
+}
+
+inline std::size_t pool_dispatcher::poll()
+{
+    std::vector<detail::pool_completion> ready;
+
+    {
+        std::lock_guard<std::mutex> guard(completions_->lock);
+        ready.swap(completions_->done);
+    }
+    for (detail::pool_completion &completed : ready) {
+        send(completed);
+    }
+    in_flight_ -= ready.size();
+    return ready.size();
+}
+
+inline void pool_dispatcher::send(detail::pool_completion &completed)
+{
+    sn_coap_hdr_s response = sn_coap_hdr_s();
+
+    completed.peer.addr_ptr = completed.peer_bytes.data();
+    response.msg_type = completed.type == COAP_MSG_TYPE_CONFIRMABLE ? COAP_MSG_TYPE_CONFIRMABLE : COAP_MSG_TYPE_NON_CONFIRMABLE;
+    response.msg_code = completed.result.code;
+    response.content_format = completed.result.content_format;
+    response.token_ptr = completed.token.empty() ? nullptr : completed.token.data();
+    response.token_len = static_cast<uint8_t>(completed.token.size());
+    response.payload_ptr = completed.result.payload.empty() ? nullptr : completed.result.payload.data();
+    response.payload_len = static_cast<sn_coap_len_t>(completed.result.payload.size());
+    sn_nsdl_send_coap_message(nsdl_, &completed.peer, &response);
+}
+
+} // namespace sn
+
+#endif /* SN_EXECUTOR_HPP_ */
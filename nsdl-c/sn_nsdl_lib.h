@@ -160,7 +160,7 @@ typedef enum sn_nsdl_resource_mode_ {
  */
 typedef struct sn_nsdl_resource_parameters_ {
     unsigned int     observable:2;
-    unsigned int     registered:2;
+    unsigned int     registered:8;      /* Registration state, two bits for each session sharing the resource */
 
     uint16_t    resource_type_len;
     uint16_t    interface_description_len;
@@ -186,11 +186,13 @@ typedef struct sn_nsdl_resource_info_ {
 
     bool                            is_put:1; //if true, pointers are assumed to be consts (never freed). Note: resource_parameters_ptr is always freed!
 
+    bool                            from_template:1;            /**< Writable copy of a template resource, path, resource type and interface description point to the template */
+
     uint8_t                         external_memory_block;
 
     uint16_t                        pathlen;                    /**< Address */
 
-    uint16_t                        resourcelen;                /**< 0 if dynamic resource, resource information in static resource */
+    sn_coap_len_t                   resourcelen;                /**< 0 if dynamic resource, resource information in static resource */
 
     sn_nsdl_resource_parameters_s   *resource_parameters_ptr;
 
@@ -203,6 +205,25 @@ typedef struct sn_nsdl_resource_info_ {
     ns_list_link_t                  link;
 } sn_nsdl_resource_info_s;
 
+/**
+ * \brief Handler of a dynamic resource fixed at build time, see sn_nsdl_set_static_dispatch()
+ */
+typedef struct sn_nsdl_static_handler_ {
+    uint8_t                         access;                     /**< Allowed methods, sn_grs_resource_acl_e bits */
+
+    uint8_t (*callback)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e);
+} sn_nsdl_static_handler_s;
+
+/**
+ * \brief Observer of a resource in one server session, see sn_nsdl_send_observation_notification_to_observers()
+ */
+typedef struct sn_nsdl_observer_ {
+    struct nsdl_s                   *handle;                    /**< Session whose server observes the resource */
+    uint8_t                         *token_ptr;                 /**< Token the server gave in its observation request */
+    uint8_t                         token_len;
+    uint16_t                        msg_id;                     /**< Set by library: message ID of the notification, 0 if not sent */
+} sn_nsdl_observer_s;
+
 /**
  * \brief Defines OMA device object parameters.
  */
@@ -254,7 +275,28 @@ typedef struct sn_nsdl_bs_ep_info_ {
  */
 struct nsdl_s *sn_nsdl_init(uint8_t (*sn_nsdl_tx_cb)(struct nsdl_s *, sn_nsdl_capab_e , uint8_t *, uint16_t, sn_nsdl_addr_s *),
                             uint8_t (*sn_nsdl_rx_cb)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *),
-                            void *(*sn_nsdl_alloc)(uint16_t), void (*sn_nsdl_free)(void *));
+                            void *(*sn_nsdl_alloc)(sn_coap_len_t), void (*sn_nsdl_free)(void *));
+
+/**
+ * \fn struct nsdl_s *sn_nsdl_init_session(struct nsdl_s *handle)
+ *
+ * \brief Creates a new server session which shares resources and CoAP state of an existing handle.
+ *
+ *        Each session has its own server address, endpoint parameters and registration, so the same
+ *        resources can be registered to several servers without duplicating them. Resources created,
+ *        updated or deleted through any session are seen by all of them. Callbacks, memory functions,
+ *        CoAP retransmission, duplicate detection and blockwise settings are shared.
+ *
+ *        Registration state of resources is kept separately for each session, so registration updates of
+ *        every session list only the links its own server does not have yet. At most four sessions can share
+ *        the same resources. Notification to observers in several sessions can be encoded once and sent to
+ *        all of them with sn_nsdl_send_observation_notification_to_observers().
+ *
+ * \param   *handle Pointer to nsdl-library handle
+ *
+ * \return  pointer to created session handle, to be released with sn_nsdl_destroy(). NULL if failed
+ */
+struct nsdl_s *sn_nsdl_init_session(struct nsdl_s *handle);
 
 /**
  * \fn extern uint16_t sn_nsdl_register_endpoint(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *endpoint_info_ptr);
@@ -330,7 +372,7 @@ extern void sn_nsdl_nsp_lost(struct nsdl_s *handle);
 
 /**
  * \fn extern uint16_t sn_nsdl_send_observation_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
- *                                                  uint8_t *payload_ptr, uint16_t payload_len,
+ *                                                  uint8_t *payload_ptr, sn_coap_len_t payload_len,
  *                                                  sn_coap_observe_e observe,
  *                                                  sn_coap_msg_type_e message_type, sn_coap_content_format_e content_format)
  *
@@ -348,16 +390,19 @@ extern void sn_nsdl_nsp_lost(struct nsdl_s *handle);
  *
  * \return  !0  Success, observation messages message ID
  * \return  0   Failure
+ *
+ * \note    Notification is held back while endpoint sleeps, see sn_nsdl_set_sleeping().
+ *          0 is returned also when the queue of held back notifications is full.
  */
 extern uint16_t sn_nsdl_send_observation_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
-        uint8_t *payload_ptr, uint16_t payload_len,
+        uint8_t *payload_ptr, sn_coap_len_t payload_len,
         sn_coap_observe_e observe,
         sn_coap_msg_type_e message_type,
         sn_coap_content_format_e content_format);
 
 /**
  * \fn extern uint16_t sn_nsdl_send_observation_notification_with_uri_path(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
- *                                                  uint8_t *payload_ptr, uint16_t payload_len,
+ *                                                  uint8_t *payload_ptr, sn_coap_len_t payload_len,
  *                                                  sn_coap_observe_e observe,
  *                                                  sn_coap_msg_type_e message_type, uint8_t content_type,
  *                                                  uint8_t *uri_path_ptr,
@@ -381,7 +426,42 @@ extern uint16_t sn_nsdl_send_observation_notification(struct nsdl_s *handle, uin
  * \return  0   Failure
  */
 extern uint16_t sn_nsdl_send_observation_notification_with_uri_path(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
-        uint8_t *payload_ptr, uint16_t payload_len,
+        uint8_t *payload_ptr, sn_coap_len_t payload_len,
+        sn_coap_observe_e observe,
+        sn_coap_msg_type_e message_type,
+        uint8_t content_type,
+        uint8_t *uri_path_ptr,
+        uint16_t uri_path_len);
+
+/**
+ * \fn extern uint8_t sn_nsdl_send_observation_notification_to_observers(sn_nsdl_observer_s *observers_ptr, uint8_t observer_count,
+ *                                                  uint8_t *payload_ptr, sn_coap_len_t payload_len,
+ *                                                  sn_coap_observe_e observe,
+ *                                                  sn_coap_msg_type_e message_type, uint8_t content_type,
+ *                                                  uint8_t *uri_path_ptr, uint16_t uri_path_len)
+ *
+ *
+ * \brief Sends the same observation message to observers of a resource in sessions sharing it, see sn_nsdl_init_session()
+ *
+ *        Message is encoded once, only message ID and token are changed for each observer. Each server has
+ *        its own observation, so every observer has its own token. Notification to a sleeping session is held
+ *        back as with sn_nsdl_send_observation_notification(). Notifications too large for one block are
+ *        built separately for each observer.
+ *
+ * \param   *observers_ptr  Observers, all of them in sessions sharing the same resources. msg_id of each is set.
+ * \param   observer_count  Number of observers
+ * \param   *payload_ptr    Pointer to payload to be sent
+ * \param   payload_len     Payload length
+ * \param   observe         Observe option value to be sent
+ * \param   message_type    Observation message type (confirmable or non-confirmable)
+ * \param   content_type    Observation message payload content type
+ * \param   uri_path_ptr    Pointer to uri path to be sent
+ * \param   uri_path_len    Uri path len
+ *
+ * \return  Number of observers the notification was sent or held back for, 0 if none
+ */
+extern uint8_t sn_nsdl_send_observation_notification_to_observers(sn_nsdl_observer_s *observers_ptr, uint8_t observer_count,
+        uint8_t *payload_ptr, sn_coap_len_t payload_len,
         sn_coap_observe_e observe,
         sn_coap_msg_type_e message_type,
         uint8_t content_type,
@@ -438,6 +518,22 @@ extern int8_t sn_nsdl_process_coap(struct nsdl_s *handle, uint8_t *packet, uint1
  */
 extern int8_t sn_nsdl_exec(struct nsdl_s *handle, uint32_t time);
 
+/**
+ * \fn extern int8_t sn_nsdl_get_next_deadline(struct nsdl_s *handle, uint32_t *deadline_ptr);
+ *
+ * \brief Returns time when sn_nsdl_exec() has next pending work.
+ *
+ * Covers CoAP retransmissions and automatic registration update. Application can sleep
+ * until returned time instead of calling sn_nsdl_exec() periodically.
+ *
+ * \param   *handle Pointer to nsdl-library handle
+ * \param   *deadline_ptr Time in seconds, in same time base as given to sn_nsdl_exec()
+ *
+ * \return  0   Success, deadline written
+ * \return  -1  Failure or nothing pending
+ */
+extern int8_t sn_nsdl_get_next_deadline(struct nsdl_s *handle, uint32_t *deadline_ptr);
+
 /**
  * \fn  extern int8_t sn_nsdl_create_resource(struct nsdl_s *handle, sn_nsdl_resource_info_s *res);
  *
@@ -475,6 +571,56 @@ extern int8_t sn_nsdl_create_resource(struct nsdl_s *handle, sn_nsdl_resource_in
  */
 extern int8_t sn_nsdl_put_resource(struct nsdl_s *handle, sn_nsdl_resource_info_s *res);
 
+/**
+ * \fn extern int8_t sn_nsdl_set_resource_template(struct nsdl_s *handle, const sn_nsdl_resource_info_s *resources, uint16_t resource_count)
+ *
+ * \brief Adds a shared resource template to the resources of a handle.
+ *
+ * Many handles exposing the same object model can use one template table, which is never copied or
+ * modified by the library and may be in read-only memory. Per handle, only one byte of registration
+ * state is kept for each template resource. A template resource is copied to the handle when its
+ * value is written, with sn_nsdl_update_resource() or a PUT or POST request; the copy points to the
+ * path, resource type and interface description strings of the template. Deleting a template resource
+ * hides it from the handle only.
+ *
+ * Template resources are returned by sn_nsdl_find_resource() and the resource iteration functions like
+ * other resources, as read-only structures. sn_nsdl_get_resource() copies a template resource to the
+ * handle first, so the structure it returns may be modified.
+ *
+ * \param   *handle         Pointer to nsdl-library handle
+ * \param   *resources      Table of resources. Table and everything it points to must stay valid and unchanged
+ *                          while any handle uses it. Paths must be unique and without leading or trailing '/'.
+ * \param   resource_count  Number of resources in the table
+ *
+ * \return  0   Success
+ * \return  -1  Failure, handle already has a template or out of memory
+ * \return  -2  A template path already exists in the handle
+ * \return  -3  Invalid path
+ */
+extern int8_t sn_nsdl_set_resource_template(struct nsdl_s *handle, const sn_nsdl_resource_info_s *resources, uint16_t resource_count);
+
+/**
+ * \fn extern int8_t sn_nsdl_set_static_dispatch(struct nsdl_s *handle, const sn_nsdl_static_handler_s *(*lookup)(const uint8_t *, uint16_t))
+ *
+ * \brief Sets lookup of request handlers fixed at build time.
+ *
+ * Requests are passed to the lookup before the resources of the handle are searched. If it returns
+ * a handler, access rights are checked and the request is given to the handler callback like to the
+ * callback of a dynamic resource; the resource store is not searched. Lookup must be fast and must not
+ * allocate, it is typically a generated perfect hash, see sn_static_dispatch.hpp.
+ *
+ * Links of these resources are not added to the registration by the lookup. Create them as resources,
+ * or in a resource template, if they are to be registered.
+ *
+ * \param   *handle     Pointer to nsdl-library handle
+ * \param   *lookup     Function returning handler of a request path given without leading '/', or NULL
+ *                      if there is none. NULL removes the lookup.
+ *
+ * \return  0   Success
+ * \return  -1  Failure
+ */
+extern int8_t sn_nsdl_set_static_dispatch(struct nsdl_s *handle, const sn_nsdl_static_handler_s *(*lookup)(const uint8_t *path_ptr, uint16_t path_len));
+
 /**
  * \fn extern int8_t sn_nsdl_update_resource(sn_nsdl_resource_info_s *res)
  *
@@ -514,7 +660,8 @@ extern int8_t sn_nsdl_delete_resource(struct nsdl_s *handle, uint16_t pathlen, u
  *
  * \brief Resource get function.
  *
- * Used to get a resource.
+ * Used to get a resource for modification. A template resource is copied to the handle first, see
+ * sn_nsdl_set_resource_template(). Use sn_nsdl_find_resource() to only read a resource.
  *
  * \param   *handle     Pointer to nsdl-library handle
  * \param   pathlen Contains the length of the path that is to be returned (excluding possible trailing '\0').
@@ -525,6 +672,23 @@ extern int8_t sn_nsdl_delete_resource(struct nsdl_s *handle, uint16_t pathlen, u
  */
 extern sn_nsdl_resource_info_s *sn_nsdl_get_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path);
 
+/**
+ * \fn extern const sn_nsdl_resource_info_s *sn_nsdl_find_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path)
+ *
+ * \brief Resource find function.
+ *
+ * Used to read a resource. The resource may be a shared template resource, so it is not copied and
+ * must not be modified.
+ *
+ * \param   *handle     Pointer to nsdl-library handle
+ * \param   pathlen Contains the length of the path that is to be returned (excluding possible trailing '\0').
+ * \param   *path   A pointer to an array containing the path.
+ *
+ * \return  !NULL   Success, pointer to a read-only sn_nsdl_resource_info_s that contains the resource information\n
+ * \return  NULL    Failure
+ */
+extern const sn_nsdl_resource_info_s *sn_nsdl_find_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path);
+
 /**
  * \fn extern sn_grs_resource_list_s *sn_nsdl_list_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path)
  *
@@ -590,6 +754,8 @@ extern int8_t set_NSP_address_2(struct nsdl_s *handle, uint8_t *NSP_address, uin
  *
  * \param   *handle Pointer to nsdl-library handle
  * \brief This function releases all allocated memory in mbed Device C Client library.
+ *        If resources are shared with sessions created by sn_nsdl_init_session(), only the given
+ *        session and its pending messages are released, resources are released with the last session.
  */
 extern int8_t sn_nsdl_destroy(struct nsdl_s *handle);
 
@@ -723,6 +889,88 @@ extern int8_t sn_nsdl_set_block_size(struct nsdl_s *handle, uint16_t block_size)
  */
 extern int8_t sn_nsdl_set_duplicate_buffer_size(struct nsdl_s *handle, uint8_t message_count);
 
+/**
+ * \fn int8_t sn_nsdl_set_registration_streaming(struct nsdl_s *handle, bool enable)
+ *
+ * \brief Enables generating registration payload block by block while it is sent.
+ *
+ *  When enabled, registration and registration update payload is not built to a single buffer,
+ *  so it can exceed 64 kB. Requires block transfer to be enabled.
+ *
+ * \param *handle Pointer to library handle
+ * \param bool enable true to enable streaming, false to build whole payload before sending
+ * \return  0 = success, -1 = failure
+ */
+extern int8_t sn_nsdl_set_registration_streaming(struct nsdl_s *handle, bool enable);
+
+/**
+ * \fn int8_t sn_nsdl_set_delta_update(struct nsdl_s *handle, bool enable)
+ *
+ * \brief Enables reporting deleted resources in registration update.
+ *
+ *  Registration update always lists only resources which are not yet registered. When enabled,
+ *  registered resources deleted since previous update are also listed as </path>;rm links,
+ *  so that server can drop them without a full registration. Disabling drops pending removals.
+ *  Attribute changes of registered resources are not tracked, a resource deleted and created
+ *  again is listed with its new attributes.
+ *
+ * \param *handle Pointer to library handle
+ * \param bool enable true to report deleted resources
+ * \return  0 = success, -1 = failure
+ */
+extern int8_t sn_nsdl_set_delta_update(struct nsdl_s *handle, bool enable);
+
+/**
+ * \fn int8_t sn_nsdl_set_update_interval(struct nsdl_s *handle, uint8_t lifetime_percent)
+ *
+ * \brief Enables automatic registration update from sn_nsdl_exec().
+ *
+ *  Update is sent when given percentage of lifetime has passed since registration or previous
+ *  update was accepted. Send time is advanced by a random jitter, see SN_NSDL_UPDATE_JITTER_PERCENT,
+ *  so that endpoints registered at the same time do not update at the same time.
+ *
+ *  If update can not be sent or no response arrives, it is retried after half of the time
+ *  left until lifetime ends, but not before CoAP resending of the previous update has ended.
+ *
+ * \param *handle Pointer to library handle
+ * \param uint8_t lifetime_percent 1 - 100, 0 disables automatic update (default)
+ * \return  0 = success, -1 = failure
+ */
+extern int8_t sn_nsdl_set_update_interval(struct nsdl_s *handle, uint8_t lifetime_percent);
+
+/**
+ * \fn int8_t sn_nsdl_set_sleeping(struct nsdl_s *handle, bool sleeping)
+ *
+ * \brief Tells whether the radio of an endpoint registered in queue mode is off.
+ *
+ *  While sleeping, observation notifications are held back, see SN_NSDL_MAX_QUEUED_NOTIFICATIONS.
+ *  Held back notifications are sent back to back when endpoint wakes up, or right after the next
+ *  registration update. Message ID returned for a held back notification is the one it is sent with.
+ *  Held back notifications are not dropped to make room for new ones. When SN_NSDL_MAX_QUEUED_NOTIFICATIONS
+ *  are held back, a new notification fails and 0 is returned, unless coalescing replaces one already held back.
+ *  Notifications are dropped if endpoint is unregistered or server is lost.
+ *
+ * \param *handle Pointer to library handle
+ * \param bool sleeping true when radio is off, false sends held back notifications
+ * \return  0 = success, -1 = failure, also if endpoint binding is not queue mode or
+ *          not all held back notifications could be sent
+ */
+extern int8_t sn_nsdl_set_sleeping(struct nsdl_s *handle, bool sleeping);
+
+/**
+ * \fn int8_t sn_nsdl_set_notification_coalescing(struct nsdl_s *handle, bool enable)
+ *
+ * \brief Keeps only the latest held back notification of each observation.
+ *
+ *  Notification with the same token and uri path as one already held back replaces its
+ *  payload, and gets its message ID.
+ *
+ * \param *handle Pointer to library handle
+ * \param bool enable true to keep only latest value, false to keep all (default)
+ * \return  0 = success, -1 = failure
+ */
+extern int8_t sn_nsdl_set_notification_coalescing(struct nsdl_s *handle, bool enable);
+
 #ifdef __cplusplus
 }
 #endif
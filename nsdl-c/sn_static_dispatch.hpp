@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file sn_static_dispatch.hpp
+ *
+ * \brief Header-only C++17 generator of perfect-hash request dispatch for resources fixed at build time.
+ *
+ * When the dynamic resources of an endpoint are known at build time, their
+ * handlers can be found without searching the resource store. The table is
+ * turned into a perfect hash by the compiler; no data structure is built at
+ * run time and a lookup is two hashes of the request path and one compare:
+ *
+ *   static constexpr sn::static_resource resources[] = {
+ *       {"3303/0/5700", SN_GRS_GET_ALLOWED, &temperature_callback},
+ *       {"3/0/4", SN_GRS_POST_ALLOWED, &reboot_callback},
+ *   };
+ *   static constexpr auto dispatch = sn::make_static_dispatch(resources);
+ *
+ *   sn::set_static_dispatch<dispatch>(nsdl);
+ *
+ * Callbacks are called like callbacks of dynamic resources, see
+ * sn_nsdl_set_static_dispatch(). Paths that are not in the table are served
+ * from the resource store as before.
+ *
+ * Duplicate or malformed paths fail the build.
+ */
+
+#ifndef SN_STATIC_DISPATCH_HPP_
+#define SN_STATIC_DISPATCH_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "ns_types.h"
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_nsdl_lib.h"
+
+namespace sn {
+
+/* One resource of the table given to make_static_dispatch() */
+struct static_resource {
+    const char *path;                   /* Leading '/' is ignored */
+    uint8_t access;                     /* sn_grs_resource_acl_e bits */
+    uint8_t (*callback)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e);
+};
+
+namespace detail {
+
+/* Not constexpr: called only when the table is invalid, which stops constant evaluation with this name in the error */
+inline void static_dispatch_duplicate_path() {}
+inline void static_dispatch_invalid_path() {}
+inline void static_dispatch_no_perfect_hash() {}
+
+constexpr std::size_t static_dispatch_size(std::size_t count)
+{
+    std::size_t size = 1;
+
+    while (size < count) {
+        size <<= 1;
+    }
+    return size;
+}
+
+/* FNV-1a with the seed in the offset basis, finished so that the low bits depend on every byte */
+template <typename Char>
+constexpr uint32_t static_dispatch_hash(const Char *path, std::size_t len, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+
+    for (std::size_t i = 0; i < len; i++) {
+        hash = (hash ^ static_cast<uint8_t>(path[i])) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+template <typename Char>
+constexpr bool static_dispatch_equal(const char *a, const Char *b, std::size_t len)
+{
+    for (std::size_t i = 0; i < len; i++) {
+        if (static_cast<uint8_t>(a[i]) != static_cast<uint8_t>(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/*
+ * Perfect hash of N paths, built by hash and displace: the first hash picks a
+ * bucket, and the bucket gives either the slot of its only path or the seed
+ * of a second hash that puts each of its paths to a separate slot. Buckets
+ * are placed from the largest down while the slot table is still empty.
+ */
+template <std::size_t N>
+class static_dispatch {
+public:
+    static_assert(N > 0 && N <= 0xffff, "static_dispatch table must have 1 to 65535 resources");
+
+    static constexpr std::size_t slot_count = detail::static_dispatch_size(N);
+    static constexpr uint32_t max_seed = 0x10000;
+
+    constexpr explicit static_dispatch(const static_resource (&table)[N])
+        : displacement_(), slots_(), valid_(false)
+    {
+        std::array<uint16_t, N> lengths{};
+        std::array<std::size_t, N> buckets{};
+        std::array<std::size_t, slot_count> bucket_sizes{};
+        std::array<bool, slot_count> taken{};
+        std::size_t largest = 0;
+
+        for (std::size_t i = 0; i < N; i++) {
+            const char *path = path_of(table[i]);
+            std::size_t len = 0;
+
+            while (path && path[len]) {
+                len++;
+            }
+            if (!len || len > 0xffff || path[len - 1] == '/') {
+                detail::static_dispatch_invalid_path();
+                return;
+            }
+            lengths[i] = static_cast<uint16_t>(len);
+            buckets[i] = detail::static_dispatch_hash(path, len, 0) & (slot_count - 1);
+            if (++bucket_sizes[buckets[i]] > largest) {
+                largest = bucket_sizes[buckets[i]];
+            }
+        }
+
+        for (std::size_t size = largest; size > 0; size--) {
+            for (std::size_t bucket = 0; bucket < slot_count; bucket++) {
+                if (bucket_sizes[bucket] != size) {
+                    continue;
+                }
+                if (size == 1) {
+                    place_single(table, lengths, buckets, taken, bucket);
+                } else if (!place_bucket(table, lengths, buckets, taken, bucket)) {
+                    return;
+                }
+            }
+        }
+        valid_ = true;
+    }
+
+    constexpr bool valid() const
+    {
+        return valid_;
+    }
+
+    /* Handler of a request path given without leading '/', NULL if the path is not in the table */
+    template <typename Char>
+    constexpr const sn_nsdl_static_handler_s *find(const Char *path, std::size_t len) const
+    {
+        if (!valid_ || !path) {
+            return nullptr;
+        }
+
+        int32_t displacement = displacement_[detail::static_dispatch_hash(path, len, 0) & (slot_count - 1)];
+        std::size_t index = displacement < 0 ? static_cast<std::size_t>(-displacement - 1) :
+                            detail::static_dispatch_hash(path, len, static_cast<uint32_t>(displacement)) & (slot_count - 1);
+        const slot &candidate = slots_[index];
+
+        if (!candidate.path || candidate.path_len != len || !detail::static_dispatch_equal(candidate.path, path, len)) {
+            return nullptr;
+        }
+        return &candidate.handler;
+    }
+
+private:
+    struct slot {
+        const char *path;
+        uint16_t path_len;
+        sn_nsdl_static_handler_s handler;
+    };
+
+    static constexpr const char *path_of(const static_resource &resource)
+    {
+        return resource.path && resource.path[0] == '/' ? resource.path + 1 : resource.path;
+    }
+
+    constexpr void fill(const static_resource &resource, uint16_t path_len, std::size_t index)
+    {
+        slots_[index].path = path_of(resource);
+        slots_[index].path_len = path_len;
+        slots_[index].handler.access = resource.access;
+        slots_[index].handler.callback = resource.callback;
+    }
+
+    constexpr void place_single(const static_resource (&table)[N], const std::array<uint16_t, N> &lengths,
+                                const std::array<std::size_t, N> &buckets, std::array<bool, slot_count> &taken,
+                                std::size_t bucket)
+    {
+        std::size_t free_slot = 0;
+
+        /* N <= slot_count, so a free slot is left for every bucket of one */
+        while (taken[free_slot]) {
+            free_slot++;
+        }
+        for (std::size_t i = 0; i < N; i++) {
+            if (buckets[i] == bucket) {
+                fill(table[i], lengths[i], free_slot);
+            }
+        }
+        taken[free_slot] = true;
+        displacement_[bucket] = -static_cast<int32_t>(free_slot) - 1;
+    }
+
+    constexpr bool place_bucket(const static_resource (&table)[N], const std::array<uint16_t, N> &lengths,
+                                const std::array<std::size_t, N> &buckets, std::array<bool, slot_count> &taken,
+                                std::size_t bucket)
+    {
+        /* Identical paths always share a bucket, so duplicates are found here */
+        for (std::size_t i = 0; i < N; i++) {
+            for (std::size_t j = i + 1; buckets[i] == bucket && j < N; j++) {
+                if (buckets[j] == bucket && lengths[i] == lengths[j] &&
+                        detail::static_dispatch_equal(path_of(table[i]), path_of(table[j]), lengths[i])) {
+                    detail::static_dispatch_duplicate_path();
+                    return false;
+                }
+            }
+        }
+
+        /* Seed 0 puts every path of the bucket to the same slot, search starts from 1 */
+        for (uint32_t seed = 1; seed < max_seed; seed++) {
+            std::array<bool, slot_count> trial = taken;
+            bool fits = true;
+
+            for (std::size_t i = 0; fits && i < N; i++) {
+                if (buckets[i] != bucket) {
+                    continue;
+                }
+                std::size_t index = detail::static_dispatch_hash(path_of(table[i]), lengths[i], seed) & (slot_count - 1);
+
+                fits = !trial[index];
+                trial[index] = true;
+            }
+            if (fits) {
+                for (std::size_t i = 0; i < N; i++) {
+                    if (buckets[i] == bucket) {
+                        fill(table[i], lengths[i], detail::static_dispatch_hash(path_of(table[i]), lengths[i], seed) & (slot_count - 1));
+                    }
+                }
+                taken = trial;
+                displacement_[bucket] = static_cast<int32_t>(seed);
+                return true;
+            }
+        }
+        detail::static_dispatch_no_perfect_hash();
+        return false;
+    }
+
+    std::array<int32_t, slot_count> displacement_;
+    std::array<slot, slot_count> slots_;
+    bool valid_;
+};
+
+template <std::size_t N>
+constexpr static_dispatch<N> make_static_dispatch(const static_resource (&table)[N])
+{
+    return static_dispatch<N>(table);
+}
+
+/* Lookup function given to the library, one per dispatch table */
+template <const auto &Dispatch>
+const sn_nsdl_static_handler_s *static_dispatch_lookup(const uint8_t *path_ptr, uint16_t path_len)
+{
+    return Dispatch.find(path_ptr, path_len);
+}
+
+/* Dispatch must be a constexpr object, so that the table is built by the compiler */
+template <const auto &Dispatch>
+bool set_static_dispatch(struct nsdl_s *handle)
+{
+    static_assert(Dispatch.valid(), "static_dispatch table is not valid");
+
+    return sn_nsdl_set_static_dispatch(handle, &static_dispatch_lookup<Dispatch>) == 0;
+}
+
+} // namespace sn
+
+#endif /* SN_STATIC_DISPATCH_HPP_ */
@@ -128,6 +128,32 @@ struct sn_coap_hdr_;
 #define SN_COAP_MAX_INCOMING_BLOCK_MESSAGE_SIZE UINT16_MAX
 #endif
 
+#if SN_COAP_MAX_INCOMING_BLOCK_MESSAGE_SIZE > SN_COAP_LEN_MAX
+#error "SN_COAP_MAX_INCOMING_MESSAGE_SIZE above UINT16_MAX needs SN_COAP_LARGE_PAYLOAD"
+#endif
+
+#ifdef YOTTA_CFG_COAP_BLOCKWISE_MAX_WINDOW
+#define SN_COAP_BLOCKWISE_MAX_WINDOW YOTTA_CFG_COAP_BLOCKWISE_MAX_WINDOW
+#elif defined MBED_CONF_MBED_CLIENT_SN_COAP_BLOCKWISE_MAX_WINDOW
+#define SN_COAP_BLOCKWISE_MAX_WINDOW MBED_CONF_MBED_CLIENT_SN_COAP_BLOCKWISE_MAX_WINDOW
+#endif
+
+#ifndef SN_COAP_BLOCKWISE_MAX_WINDOW
+#define SN_COAP_BLOCKWISE_MAX_WINDOW                4 /**< Maximum count of outstanding requests of one pipelined transfer */
+#endif
+
+#ifdef YOTTA_CFG_COAP_INLINE_URI_PATH_SIZE
+#define SN_COAP_INLINE_URI_PATH_SIZE YOTTA_CFG_COAP_INLINE_URI_PATH_SIZE
+#elif defined MBED_CONF_MBED_CLIENT_SN_COAP_INLINE_URI_PATH_SIZE
+#define SN_COAP_INLINE_URI_PATH_SIZE MBED_CONF_MBED_CLIENT_SN_COAP_INLINE_URI_PATH_SIZE
+#endif
+
+#ifndef SN_COAP_INLINE_URI_PATH_SIZE
+#define SN_COAP_INLINE_URI_PATH_SIZE                0  /**< Uri path stored inside message allocation, 0 disables compact message storage */
+#endif
+
+#define SN_COAP_MAX_TOKEN_LEN                       8
+
 /* * For Option handling * */
 #define COAP_OPTION_MAX_AGE_DEFAULT                 60 /**< Default value of Max-Age if option not present */
 #define COAP_OPTION_URI_PORT_NONE                   (-1) /**< Internal value to represent no Uri-Port option */
@@ -138,6 +164,15 @@ struct sn_coap_hdr_;
 int8_t prepare_blockwise_message(struct coap_s *handle, struct sn_coap_hdr_ *coap_hdr_ptr);
 #endif
 
+#if SN_COAP_INLINE_URI_PATH_SIZE
+/* Message allocated together with storage for token and short uri path */
+typedef struct sn_coap_compact_hdr_ {
+    struct sn_coap_hdr_ hdr;
+    uint8_t token[SN_COAP_MAX_TOKEN_LEN];
+    uint8_t uri_path[SN_COAP_INLINE_URI_PATH_SIZE];
+} sn_coap_compact_hdr_s;
+#endif
+
 /* Structure which is stored to Linked list for message sending purposes */
 typedef struct coap_send_msg_ {
     uint8_t             resending_counter;  /* Tells how many times message is still tried to resend */
@@ -177,11 +212,52 @@ typedef struct coap_blockwise_msg_ {
     sn_coap_hdr_s       *coap_msg_ptr;
     struct coap_s       *coap;      /* CoAP library handle */
 
+    uint32_t            payload_total_len;      /* Length of streamed payload, 0 if whole payload is stored to coap_msg_ptr */
+    uint16_t            (*payload_source)(void *, uint32_t, uint8_t *, uint16_t); /* Produces streamed payload blocks on demand */
+    void                *payload_source_context; /* Owned by the library, freed when message is removed */
+    void                *param;                 /* TX/RX callback parameter of streamed message */
+
     ns_list_link_t     link;
 } coap_blockwise_msg_s;
 
 typedef NS_LIST_HEAD(coap_blockwise_msg_s, link) coap_blockwise_msg_list_t;
 
+/* Outstanding request of a pipelined transfer */
+typedef struct coap_blockwise_transfer_slot_ {
+    uint32_t            block_number;
+    uint32_t            resending_time;
+    uint16_t            msg_id;     /* 0 when slot is free */
+    uint8_t             resending_counter;
+} coap_blockwise_transfer_slot_s;
+
+/* Pipelined Block2 download or Block1 upload, stored to Linked list */
+typedef struct coap_blockwise_transfer_ {
+    uint32_t            timestamp;  /* Tells when last block was acknowledged */
+
+    sn_coap_hdr_s       *coap_msg_ptr;  /* Request, Block option is rewritten for every block */
+    sn_nsdl_addr_s      addr;
+    struct coap_s       *coap;      /* CoAP library handle */
+
+    uint16_t            (*payload_sink)(void *, uint32_t, const uint8_t *, uint16_t); /* Download: consumes received blocks at their offsets */
+    uint16_t            (*payload_source)(void *, uint32_t, uint8_t *, uint16_t);     /* Upload: produces blocks to be sent */
+    void                *payload_context;       /* Owned by the library, freed when transfer is removed */
+    void                *param;                 /* TX/RX callback parameter */
+    uint32_t            payload_total_len;      /* Upload only */
+
+    uint32_t            next_block_number;
+    uint32_t            last_block_number;      /* Valid when last_block_known is set */
+    uint8_t             window;
+    uint8_t             block_size_exp;         /* SZX of Block option */
+    unsigned int        last_block_known:1;
+    unsigned int        block_size_agreed:1;    /* Set by first response, window is used after that */
+
+    coap_blockwise_transfer_slot_s slots[SN_COAP_BLOCKWISE_MAX_WINDOW];
+
+    ns_list_link_t     link;
+} coap_blockwise_transfer_s;
+
+typedef NS_LIST_HEAD(coap_blockwise_transfer_s, link) coap_blockwise_transfer_list_t;
+
 /* Structure which is stored to Linked list for blockwise messages receiving purposes */
 typedef struct coap_blockwise_payload_ {
     uint32_t            timestamp; /* Tells when Payload is stored to Linked list */
@@ -192,6 +268,8 @@ typedef struct coap_blockwise_payload_ {
 
     uint16_t            payload_len;
     uint8_t             *payload_ptr;
+    uint32_t            payload_offset; /* Blocks may arrive out of order */
+    uint8_t             last_block;     /* More bit was not set */
     struct coap_s       *coap;  /* CoAP library handle */
 
     ns_list_link_t     link;
@@ -200,7 +278,7 @@ typedef struct coap_blockwise_payload_ {
 typedef NS_LIST_HEAD(coap_blockwise_payload_s, link) coap_blockwise_payload_list_t;
 
 struct coap_s {
-    void *(*sn_coap_protocol_malloc)(uint16_t);
+    void *(*sn_coap_protocol_malloc)(sn_coap_len_t);
     void (*sn_coap_protocol_free)(void *);
 
     uint8_t (*sn_coap_tx_callback)(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *);
@@ -219,6 +297,7 @@ struct coap_s {
     #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwise is not used at all, this part of code will not be compiled */
         coap_blockwise_msg_list_t     linked_list_blockwise_sent_msgs; /* Blockwise message to to be sent is stored to this Linked list */
         coap_blockwise_payload_list_t linked_list_blockwise_received_payloads; /* Blockwise payload to to be received is stored to this Linked list */
+        coap_blockwise_transfer_list_t linked_list_blockwise_transfers; /* Pipelined downloads and uploads are stored to this Linked list */
     #endif
 
     uint32_t system_time;    /* System time seconds */
@@ -45,8 +45,7 @@ static int16_t  sn_coap_builder_options_build_add_one_option(uint8_t **dst_packe
 static int16_t  sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, uint8_t **src_pptr, uint16_t *src_len_ptr, sn_coap_option_numbers_e option, uint16_t *previous_option_number);
 static uint8_t  sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packet_data_pptr, uint32_t value, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number);
 static uint8_t  sn_coap_builder_options_get_option_part_count(uint16_t query_len, uint8_t *query_ptr, sn_coap_option_numbers_e option);
-static uint16_t sn_coap_builder_options_get_option_part_length_from_whole_option_string(uint16_t query_len, uint8_t *query_ptr, uint8_t query_index, sn_coap_option_numbers_e option);
-static int16_t  sn_coap_builder_options_get_option_part_position(uint16_t query_len, uint8_t *query_ptr, uint8_t query_index, sn_coap_option_numbers_e option);
+static uint16_t sn_coap_builder_options_get_next_option_part(uint16_t query_len, uint8_t *query_ptr, uint16_t *query_offset_ptr, sn_coap_option_numbers_e option);
 static void     sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, sn_coap_hdr_s *src_coap_msg_ptr);
 static uint8_t  sn_coap_builder_options_calculate_jump_need(sn_coap_hdr_s *src_coap_msg_ptr/*, uint8_t block_option*/);
 
@@ -81,13 +80,10 @@ sn_coap_hdr_s *sn_coap_build_response(struct coap_s *handle, sn_coap_hdr_s *coap
     }
 
     if (coap_packet_ptr->token_ptr) {
-        coap_res_ptr->token_len = coap_packet_ptr->token_len;
-        coap_res_ptr->token_ptr = handle->sn_coap_protocol_malloc(coap_res_ptr->token_len);
-        if (!coap_res_ptr->token_ptr) {
+        if (sn_coap_parser_set_token(handle, coap_res_ptr, coap_packet_ptr->token_ptr, coap_packet_ptr->token_len) != 0) {
             handle->sn_coap_protocol_free(coap_res_ptr);
             return NULL;
         }
-        memcpy(coap_res_ptr->token_ptr, coap_packet_ptr->token_ptr, coap_res_ptr->token_len);
     }
     return coap_res_ptr;
 }
@@ -330,12 +326,16 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(sn_coap_hdr_s *src_coap_
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
         if ((src_coap_msg_ptr->payload_len > blockwise_payload_size) && (blockwise_payload_size > 0)) {
             returned_byte_count += blockwise_payload_size;
-        } else {
+        } else
+#endif
+        {
+            /* Payload which is not blockwised must fit to one packet */
+            uint16_t payload_space = UINT16_MAX - returned_byte_count;
+            if (src_coap_msg_ptr->payload_len > payload_space) {
+                return 0;
+            }
             returned_byte_count += src_coap_msg_ptr->payload_len;
         }
-#else
-        returned_byte_count += src_coap_msg_ptr->payload_len;
-#endif
         if (src_coap_msg_ptr->payload_len) {
             returned_byte_count ++;    /* For payload marker */
         }
@@ -395,7 +395,9 @@ static uint8_t sn_coap_builder_options_calculate_jump_need(sn_coap_hdr_s *src_co
             previous_option_number = (COAP_OPTION_LOCATION_PATH);
         }
 
-        if (src_coap_msg_ptr->uri_path_ptr != NULL) {
+        /* Uri-Path is not built for notifications, see sn_coap_builder_options_build() */
+        if (src_coap_msg_ptr->uri_path_ptr != NULL &&
+                src_coap_msg_ptr->options_list_ptr->observe == COAP_OBSERVE_NONE) {
             previous_option_number = (COAP_OPTION_URI_PATH);
         }
         if (src_coap_msg_ptr->content_format != COAP_CT_NONE) {
@@ -554,8 +556,9 @@ static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, sn_c
                      src_coap_msg_ptr->options_list_ptr->uri_host_ptr, COAP_OPTION_URI_HOST, &previous_option_number);
 
         /* * * * Build ETag option  * * * */
+        uint16_t etag_len = src_coap_msg_ptr->options_list_ptr->etag_len;
         sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, &src_coap_msg_ptr->options_list_ptr->etag_ptr,
-                     (uint16_t *)&src_coap_msg_ptr->options_list_ptr->etag_len, COAP_OPTION_ETAG, &previous_option_number);
+                     &etag_len, COAP_OPTION_ETAG, &previous_option_number);
 
         /* * * * Build Observe option  * * * * */
         if (src_coap_msg_ptr->options_list_ptr->observe != COAP_OBSERVE_NONE) {
@@ -803,14 +806,14 @@ static int16_t sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_p
 
         /* * * * Options by adding all parts to option * * * */
         for (i = 0; i < query_part_count; i++) {
-            /* Get length of query part */
-            uint16_t one_query_part_len = sn_coap_builder_options_get_option_part_length_from_whole_option_string(query_len, query_ptr, i, option);
-
-            /* Get position of query part */
-            query_part_offset = sn_coap_builder_options_get_option_part_position(query_len, query_ptr, i, option);
+            /* Get position and length of query part */
+            uint16_t one_query_part_len = sn_coap_builder_options_get_next_option_part(query_len, query_ptr, &query_part_offset, option);
 
             /* Add Uri-query's one part to Options */
             sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, one_query_part_len, *src_pptr + query_part_offset, option, previous_option_number);
+
+            /* Next part starts after the separator */
+            query_part_offset += one_query_part_len + 1;
         }
     }
     /* Success */
@@ -834,6 +837,7 @@ static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, uin
     uint8_t     query_part_count    = sn_coap_builder_options_get_option_part_count(query_len, query_ptr, option);
     uint8_t     i                   = 0;
     uint16_t    ret_value           = 0;
+    uint16_t    query_part_offset   = 0;
 
     /* * * * * * * * * * * * * * * * * * * * * * * * */
     /* * * * Calculate Uri-query options length  * * */
@@ -842,7 +846,8 @@ static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, uin
         /* * * Length of Option number and Option value length * * */
 
         /* Get length of Query part */
-        uint16_t one_query_part_len = sn_coap_builder_options_get_option_part_length_from_whole_option_string(query_len, query_ptr, i, option);
+        uint16_t one_query_part_len = sn_coap_builder_options_get_next_option_part(query_len, query_ptr, &query_part_offset, option);
+        query_part_offset += one_query_part_len + 1;
 
         /* Check option length */
         switch (option) {
@@ -934,123 +939,46 @@ static uint8_t sn_coap_builder_options_get_option_part_count(uint16_t query_len,
 }
 
 /**
- * \fn static uint16_t sn_coap_builder_options_get_option_part_length_from_whole_option_string(uint16_t query_len,
-                                                                             uint8_t *query_ptr,
-                                                                             uint8_t query_index, sn_coap_option_numbers_e option)
+ * \fn static uint16_t sn_coap_builder_options_get_next_option_part(uint16_t query_len, uint8_t *query_ptr,
+                                                                     uint16_t *query_offset_ptr, sn_coap_option_numbers_e option)
  *
- * \brief Gets one's query part length from whole query string
+ * \brief Gets next query part from whole option string
+ *
+ * Parts are walked in order, so that every part does not need a search
+ * from the start of the string. Leading separator is skipped, and two
+ * separators in a row give an empty part.
  *
  * \param query_len is length of whole string
  *
  * \param *query_ptr is pointer to the start of whole string
  *
- * \param query_index is query part index to be found
+ * \param *query_offset_ptr is offset of the part in whole string, 0 for the first part and
+ *        previous part offset + length + 1 for the others. Moved over leading separator
  *
  * \param sn_coap_option_numbers_e option is option number of the option
  *
  * \return Return value is length of query part
  */
-static uint16_t sn_coap_builder_options_get_option_part_length_from_whole_option_string(uint16_t query_len, uint8_t *query_ptr,
-        uint8_t query_index, sn_coap_option_numbers_e option)
+static uint16_t sn_coap_builder_options_get_next_option_part(uint16_t query_len, uint8_t *query_ptr,
+        uint16_t *query_offset_ptr, sn_coap_option_numbers_e option)
 {
     uint16_t returned_query_part_len = 0;
-    uint8_t  temp_query_index        = 0;
-    uint16_t query_len_index         = 0;
     uint8_t  char_to_search          = '&';
 
     if (option == COAP_OPTION_URI_PATH || option == COAP_OPTION_LOCATION_PATH) {
         char_to_search = '/';
     }
 
-    /* Loop whole query and search '\0' characters */
-    for (query_len_index = 0; query_len_index < query_len; query_len_index++) {
-        /* Store character to temp_char for helping debugging */
-        uint8_t temp_char = *query_ptr;
-
-        /* If new query part starts */
-        if (temp_char == char_to_search && returned_query_part_len > 0) { /* returned_query_part_len > 0 is for querys which start with "\0" */
-            /* If query part index is wanted */
-            if (temp_query_index == query_index) {
-                /* Return length of query part */
-                return returned_query_part_len;
-            } else {
-                /* Reset length of query part because wanted query part finding continues*/
-                returned_query_part_len = 0;
-            }
-
-            /* Next query part is looped */
-            temp_query_index++;
-        } else if (temp_char != char_to_search) { /* Else if query part continues */
-            /* Increase query part length */
-            returned_query_part_len++;
-        }
-
-        query_ptr++;
+    if (*query_offset_ptr == 0 && query_len && *query_ptr == char_to_search) {
+        (*query_offset_ptr)++;
     }
 
-    /* Return length of query part in cases that query part does not finish to '\0' character (last query part can be like that) */
-    return returned_query_part_len;
-}
-
-/**
- * \fn static uint16_t sn_coap_builder_options_get_option_part_position(uint16_t query_len,
-                                                               uint8_t *query_ptr,
-                                                               uint8_t query_index, sn_coap_option_numbers_e option)
- *
- * \brief Gets query part position in whole query
- *
- * \param query_len is length of whole query
- *
- * \param *query_ptr is pointer to the start of whole query
- *
- * \param query_index is query part index to be found
- *
- * \return Return value is position (= offset) of query part in whole query. In
- *         fail cases -1 is returned.
- */
-static int16_t sn_coap_builder_options_get_option_part_position(uint16_t query_len, uint8_t *query_ptr,
-        uint8_t query_index, sn_coap_option_numbers_e option)
-{
-    uint16_t returned_query_part_offset = 0;
-    uint8_t  temp_query_index           = 0;
-    uint16_t query_len_index            = 0;
-    uint8_t  char_to_search             = '&';
-
-    if (option == COAP_OPTION_URI_PATH || option == COAP_OPTION_LOCATION_PATH) {
-        char_to_search = '/';
-    }
-
-    if (query_index == 0) {
-        if (*query_ptr == 0 || *query_ptr == char_to_search) {
-            return 1;
-        } else {
-            return 0;
-        }
+    while (*query_offset_ptr + returned_query_part_len < query_len &&
+            *(query_ptr + *query_offset_ptr + returned_query_part_len) != char_to_search) {
+        returned_query_part_len++;
     }
 
-    /* Loop whole query and search separator characters */
-    for (query_len_index = 0; query_len_index < query_len; query_len_index++) {
-        /* Store character to temp_char for helping debugging */
-        uint8_t temp_char = *query_ptr;
-
-        /* If new query part starts */
-        if (temp_char == char_to_search && returned_query_part_offset > 0) { /* returned_query_part_offset > 0 is for querys which start with searched char */
-            /* If query part index is wanted */
-            if (temp_query_index == (query_index - 1)) {
-                /* Return offset of query part */
-                return (returned_query_part_offset + 1); /* Plus one is for passing separator */
-            }
-
-            /* Next query part is looped */
-            temp_query_index++;
-        }
-
-        returned_query_part_offset++;
-
-        query_ptr++;
-    }
-
-    return -1; //Dead code?
+    return returned_query_part_len;
 }
 
 
@@ -43,7 +43,9 @@
 
 static void     sn_coap_parser_header_parse(uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr, coap_version_e *coap_version_ptr);
 static int8_t   sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr, uint8_t *packet_data_start_ptr, uint16_t packet_len);
-static int8_t   sn_coap_parser_options_parse_multiple_options(struct coap_s *handle, uint8_t **packet_data_pptr, uint16_t packet_left_len,  uint8_t **dst_pptr, uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len);
+static int8_t   sn_coap_parser_options_parse_multiple_options(struct coap_s *handle, uint8_t **packet_data_pptr, uint16_t packet_left_len,  uint8_t **dst_pptr, uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len, sn_coap_hdr_s *dst_coap_msg_ptr);
+static uint8_t *sn_coap_parser_alloc_uri_path(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, uint16_t uri_path_len);
+static uint8_t  sn_coap_parser_options_header_len(uint8_t first_byte);
 static int16_t  sn_coap_parser_options_count_needed_memory_multiple_option(uint8_t *packet_data_ptr, uint16_t packet_left_len, sn_coap_option_numbers_e option, uint16_t option_number_len);
 static int8_t   sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_start_ptr, uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr);
 
@@ -72,9 +74,17 @@ sn_coap_hdr_s *sn_coap_parser_alloc_message(struct coap_s *handle)
     }
 
     /* * * * Allocate memory for returned CoAP message and initialize allocated memory with with default values  * * * */
+#if SN_COAP_INLINE_URI_PATH_SIZE
+    returned_coap_msg_ptr = handle->sn_coap_protocol_malloc(sizeof(sn_coap_compact_hdr_s));
+    if (sn_coap_parser_init_message(returned_coap_msg_ptr)) {
+        returned_coap_msg_ptr->inline_storage = 1;
+    }
+    return returned_coap_msg_ptr;
+#else
     returned_coap_msg_ptr = handle->sn_coap_protocol_malloc(sizeof(sn_coap_hdr_s));
 
     return sn_coap_parser_init_message(returned_coap_msg_ptr);
+#endif
 }
 
 sn_coap_options_list_s *sn_coap_parser_alloc_options(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr)
@@ -109,6 +119,76 @@ sn_coap_options_list_s *sn_coap_parser_alloc_options(struct coap_s *handle, sn_c
     return coap_msg_ptr->options_list_ptr;
 }
 
+int8_t sn_coap_parser_set_token(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, const uint8_t *token_ptr, uint8_t token_len)
+{
+    /* * * * Check given pointers * * * */
+    if (handle == NULL || coap_msg_ptr == NULL || token_ptr == NULL) {
+        return -1;
+    }
+
+    if (token_len == 0 || token_len > SN_COAP_MAX_TOKEN_LEN || coap_msg_ptr->token_ptr) {
+        return -1;
+    }
+
+#if SN_COAP_INLINE_URI_PATH_SIZE
+    if (coap_msg_ptr->inline_storage) {
+        coap_msg_ptr->token_ptr = ((sn_coap_compact_hdr_s *)coap_msg_ptr)->token;
+    } else
+#endif
+    {
+        coap_msg_ptr->token_ptr = handle->sn_coap_protocol_malloc(token_len);
+        if (coap_msg_ptr->token_ptr == NULL) {
+            return -1;
+        }
+    }
+
+    memcpy(coap_msg_ptr->token_ptr, token_ptr, token_len);
+    coap_msg_ptr->token_len = token_len;
+
+    return 0;
+}
+
+int8_t sn_coap_parser_set_uri_path(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, const uint8_t *uri_path_ptr, uint16_t uri_path_len)
+{
+    /* * * * Check given pointers * * * */
+    if (handle == NULL || coap_msg_ptr == NULL || uri_path_ptr == NULL) {
+        return -1;
+    }
+
+    if (uri_path_len == 0 || coap_msg_ptr->uri_path_ptr) {
+        return -1;
+    }
+
+    coap_msg_ptr->uri_path_ptr = sn_coap_parser_alloc_uri_path(handle, coap_msg_ptr, uri_path_len);
+    if (coap_msg_ptr->uri_path_ptr == NULL) {
+        return -1;
+    }
+
+    memcpy(coap_msg_ptr->uri_path_ptr, uri_path_ptr, uri_path_len);
+    coap_msg_ptr->uri_path_len = uri_path_len;
+
+    return 0;
+}
+
+/**
+ * \fn static uint8_t *sn_coap_parser_alloc_uri_path(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, uint16_t uri_path_len)
+ *
+ * \brief Gives storage for uri path of message, from inside message allocation if it fits
+ *
+ * \return Pointer to storage, NULL if allocation failed
+ */
+static uint8_t *sn_coap_parser_alloc_uri_path(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, uint16_t uri_path_len)
+{
+#if SN_COAP_INLINE_URI_PATH_SIZE
+    if (coap_msg_ptr->inline_storage && uri_path_len <= SN_COAP_INLINE_URI_PATH_SIZE) {
+        return ((sn_coap_compact_hdr_s *)coap_msg_ptr)->uri_path;
+    }
+#else
+    (void)coap_msg_ptr;
+#endif
+    return handle->sn_coap_protocol_malloc(uri_path_len);
+}
+
 sn_coap_hdr_s *sn_coap_parser(struct coap_s *handle, uint16_t packet_data_len, uint8_t *packet_data_ptr, coap_version_e *coap_version_ptr)
 {
     uint8_t       *data_temp_ptr                    = packet_data_ptr;
@@ -152,6 +232,18 @@ void sn_coap_parser_release_allocated_coap_msg_mem(struct coap_s *handle, sn_coa
     }
 
     if (freed_coap_msg_ptr != NULL) {
+#if SN_COAP_INLINE_URI_PATH_SIZE
+        /* Inline storage is released together with the message */
+        if (freed_coap_msg_ptr->inline_storage) {
+            sn_coap_compact_hdr_s *compact_ptr = (sn_coap_compact_hdr_s *)freed_coap_msg_ptr;
+            if (freed_coap_msg_ptr->uri_path_ptr == compact_ptr->uri_path) {
+                freed_coap_msg_ptr->uri_path_ptr = NULL;
+            }
+            if (freed_coap_msg_ptr->token_ptr == compact_ptr->token) {
+                freed_coap_msg_ptr->token_ptr = NULL;
+            }
+        }
+#endif
         if (freed_coap_msg_ptr->uri_path_ptr != NULL) {
             handle->sn_coap_protocol_free(freed_coap_msg_ptr->uri_path_ptr);
         }
@@ -239,6 +331,24 @@ static uint32_t sn_coap_parser_options_parse_uint(uint8_t **packet_data_pptr, ui
     return value;
 }
 
+/**
+ * \brief Resolves length of option header from its first byte
+ *
+ * \param first_byte is the first byte of option, holding option delta and length
+ *
+ * \return Return value is option header length including extended delta and length bytes
+ */
+static uint8_t sn_coap_parser_options_header_len(uint8_t first_byte)
+{
+    uint8_t header_len = 1;
+    uint8_t delta = first_byte >> COAP_OPTIONS_OPTION_NUMBER_SHIFT;
+    uint8_t len = first_byte & 0x0F;
+
+    header_len += (delta == 13) ? 1 : ((delta == 14) ? 2 : 0);
+    header_len += (len == 13) ? 1 : ((len == 14) ? 2 : 0);
+    return header_len;
+}
+
 /**
  * \fn static uint8_t sn_coap_parser_options_parse(uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr)
  *
@@ -260,17 +370,13 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
     dst_coap_msg_ptr->token_len = *packet_data_start_ptr & COAP_HEADER_TOKEN_LENGTH_MASK;
 
     if (dst_coap_msg_ptr->token_len) {
-        if ((dst_coap_msg_ptr->token_len > 8) || dst_coap_msg_ptr->token_ptr) {
+        if (dst_coap_msg_ptr->token_len > packet_len - ((*packet_data_pptr) - packet_data_start_ptr)) {
             return -1;
         }
-
-        dst_coap_msg_ptr->token_ptr = handle->sn_coap_protocol_malloc(dst_coap_msg_ptr->token_len);
-
-        if (dst_coap_msg_ptr->token_ptr == NULL) {
+        if (sn_coap_parser_set_token(handle, dst_coap_msg_ptr, *packet_data_pptr, dst_coap_msg_ptr->token_len) != 0) {
             return -1;
         }
 
-        memcpy(dst_coap_msg_ptr->token_ptr, *packet_data_pptr, dst_coap_msg_ptr->token_len);
         (*packet_data_pptr) += dst_coap_msg_ptr->token_len;
     }
 
@@ -287,6 +393,11 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
             return -1;
         }
 
+        /* Extended option delta and length bytes must fit in the packet */
+        if (sn_coap_parser_options_header_len(**packet_data_pptr) > message_left) {
+            return -1;
+        }
+
         /* Resolve option delta */
         uint16_t  option_number = (**packet_data_pptr >> COAP_OPTIONS_OPTION_NUMBER_SHIFT);
 
@@ -316,6 +427,11 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
             (*packet_data_pptr) += 2;
         }
 
+        /* Option value must fit in the packet, pointer is now at the last byte of the option header */
+        message_left = packet_len - (*packet_data_pptr - packet_data_start_ptr);
+        if (option_len >= message_left) {
+            return -1;
+        }
 
         /* * * Parse option itself * * */
         /* Some options are handled independently in own functions */
@@ -377,20 +493,24 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
 
                 break;
 
-            case COAP_OPTION_ETAG:
-                /* This is managed independently because User gives this option in one character table */
+            case COAP_OPTION_ETAG: {
+                /* Length field of ETag is 8 bits wide, so it is parsed via local variable */
+                uint16_t etag_len = 0;
 
+                /* This is managed independently because User gives this option in one character table */
                 ret_status = sn_coap_parser_options_parse_multiple_options(handle, packet_data_pptr,
                              message_left,
                              &dst_coap_msg_ptr->options_list_ptr->etag_ptr,
-                             (uint16_t *)&dst_coap_msg_ptr->options_list_ptr->etag_len,
-                             COAP_OPTION_ETAG, option_len);
-                if (ret_status >= 0) {
+                             &etag_len,
+                             COAP_OPTION_ETAG, option_len, NULL);
+                dst_coap_msg_ptr->options_list_ptr->etag_len = (uint8_t)etag_len;
+                if (ret_status >= 0 && etag_len <= UINT8_MAX) {
                     i += (ret_status - 1); /* i += is because possible several Options are handled by sn_coap_parser_options_parse_multiple_options() */
                 } else {
                     return -1;
                 }
                 break;
+            }
 
             case COAP_OPTION_URI_HOST:
                 if ((option_len > 255) || (option_len < 1) || dst_coap_msg_ptr->options_list_ptr->uri_host_ptr) {
@@ -416,7 +536,7 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
                 /* This is managed independently because User gives this option in one character table */
                 ret_status = sn_coap_parser_options_parse_multiple_options(handle, packet_data_pptr, message_left,
                              &dst_coap_msg_ptr->options_list_ptr->location_path_ptr, &dst_coap_msg_ptr->options_list_ptr->location_path_len,
-                             COAP_OPTION_LOCATION_PATH, option_len);
+                             COAP_OPTION_LOCATION_PATH, option_len, NULL);
                 if (ret_status >= 0) {
                     i += (ret_status - 1); /* i += is because possible several Options are handled by sn_coap_parser_options_parse_multiple_options() */
                 } else {
@@ -438,7 +558,7 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
             case COAP_OPTION_LOCATION_QUERY:
                 ret_status = sn_coap_parser_options_parse_multiple_options(handle, packet_data_pptr, message_left,
                              &dst_coap_msg_ptr->options_list_ptr->location_query_ptr, &dst_coap_msg_ptr->options_list_ptr->location_query_len,
-                             COAP_OPTION_LOCATION_QUERY, option_len);
+                             COAP_OPTION_LOCATION_QUERY, option_len, NULL);
                 if (ret_status >= 0) {
                     i += (ret_status - 1); /* i += is because possible several Options are handled by sn_coap_parser_options_parse_multiple_options() */
                 } else {
@@ -450,7 +570,7 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
             case COAP_OPTION_URI_PATH:
                 ret_status = sn_coap_parser_options_parse_multiple_options(handle, packet_data_pptr, message_left,
                              &dst_coap_msg_ptr->uri_path_ptr, &dst_coap_msg_ptr->uri_path_len,
-                             COAP_OPTION_URI_PATH, option_len);
+                             COAP_OPTION_URI_PATH, option_len, dst_coap_msg_ptr);
                 if (ret_status >= 0) {
                     i += (ret_status - 1); /* i += is because possible several Options are handled by sn_coap_parser_options_parse_multiple_options() */
                 } else {
@@ -473,7 +593,7 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
             case COAP_OPTION_URI_QUERY:
                 ret_status = sn_coap_parser_options_parse_multiple_options(handle, packet_data_pptr, message_left,
                              &dst_coap_msg_ptr->options_list_ptr->uri_query_ptr, &dst_coap_msg_ptr->options_list_ptr->uri_query_len,
-                             COAP_OPTION_URI_QUERY, option_len);
+                             COAP_OPTION_URI_QUERY, option_len, NULL);
                 if (ret_status >= 0) {
                     i += (ret_status - 1); /* i += is because possible several Options are handled by sn_coap_parser_options_parse_multiple_options() */
                 } else {
@@ -550,13 +670,14 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
 
 /**
  * \fn static int8_t sn_coap_parser_options_parse_multiple_options(uint8_t **packet_data_pptr, uint8_t options_count_left, uint8_t *previous_option_number_ptr, uint8_t **dst_pptr,
- *                                                                  uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len)
+ *                                                                  uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len,
+ *                                                                  sn_coap_hdr_s *dst_coap_msg_ptr)
  *
  * \brief Parses CoAP message's Uri-query options
  *
  * \param **packet_data_pptr is source for Packet data to be parsed to CoAP message
  *
- * \param *dst_coap_msg_ptr is destination for parsed CoAP message
+ * \param *dst_coap_msg_ptr is message whose uri path storage is used, NULL for other than Uri-Path
  *
  * \param options_count_left tells how many options are unhandled in Packet data
  *
@@ -564,22 +685,26 @@ static int8_t sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **pack
  *
  * \return Return value is count of Uri-query optios parsed. In failure case -1 is returned.
 */
-static int8_t sn_coap_parser_options_parse_multiple_options(struct coap_s *handle, uint8_t **packet_data_pptr, uint16_t packet_left_len,  uint8_t **dst_pptr, uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len)
+static int8_t sn_coap_parser_options_parse_multiple_options(struct coap_s *handle, uint8_t **packet_data_pptr, uint16_t packet_left_len,  uint8_t **dst_pptr, uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len, sn_coap_hdr_s *dst_coap_msg_ptr)
 {
     int16_t     uri_query_needed_heap       = sn_coap_parser_options_count_needed_memory_multiple_option(*packet_data_pptr, packet_left_len, option, option_number_len);
     uint8_t    *temp_parsed_uri_query_ptr   = NULL;
     uint8_t     returned_option_counter     = 0;
+    uint8_t    *packet_end_ptr              = *packet_data_pptr + packet_left_len;
 
-    if (uri_query_needed_heap == -1) {
+    /* Option alone with empty value is not supported, it would leave packet pointer to option header */
+    if (uri_query_needed_heap <= 0) {
         return -1;
     }
 
-    if (uri_query_needed_heap) {
+    if (dst_coap_msg_ptr) {
+        *dst_pptr = sn_coap_parser_alloc_uri_path(handle, dst_coap_msg_ptr, uri_query_needed_heap);
+    } else {
         *dst_pptr = (uint8_t *) handle->sn_coap_protocol_malloc(uri_query_needed_heap);
+    }
 
-        if (*dst_pptr == NULL) {
-            return -1;
-        }
+    if (*dst_pptr == NULL) {
+        return -1;
     }
 
     *dst_len_ptr = uri_query_needed_heap;
@@ -605,7 +730,8 @@ static int8_t sn_coap_parser_options_parse_multiple_options(struct coap_s *handl
 
         (*packet_data_pptr)++;
 
-        if (((temp_parsed_uri_query_ptr - *dst_pptr) + option_number_len) > uri_query_needed_heap) {
+        if (((temp_parsed_uri_query_ptr - *dst_pptr) + option_number_len) > uri_query_needed_heap ||
+                option_number_len > packet_end_ptr - *packet_data_pptr) {
             return -1;
         }
 
@@ -614,10 +740,14 @@ static int8_t sn_coap_parser_options_parse_multiple_options(struct coap_s *handl
         (*packet_data_pptr) += option_number_len;
         temp_parsed_uri_query_ptr += option_number_len;
 
-        if ((temp_parsed_uri_query_ptr - *dst_pptr) >= uri_query_needed_heap || ((**packet_data_pptr >> COAP_OPTIONS_OPTION_NUMBER_SHIFT) != 0)) {
+        if ((temp_parsed_uri_query_ptr - *dst_pptr) >= uri_query_needed_heap || *packet_data_pptr >= packet_end_ptr ||
+                ((**packet_data_pptr >> COAP_OPTIONS_OPTION_NUMBER_SHIFT) != 0)) {
             return returned_option_counter;
         }
 
+        if (sn_coap_parser_options_header_len(**packet_data_pptr) > packet_end_ptr - *packet_data_pptr) {
+            return -1;
+        }
         option_number_len = (**packet_data_pptr & 0x0F);
         if (option_number_len == 13) {
             option_number_len = *(*packet_data_pptr + 1) + 13;
@@ -691,6 +821,11 @@ static int16_t sn_coap_parser_options_count_needed_memory_multiple_option(uint8_
             return (ret_value - 1);    /* -1 because last Part path does not include separator */
         }
 
+        /* Extended length bytes must fit in the packet */
+        if (sn_coap_parser_options_header_len(*(packet_data_ptr + i)) > packet_left_len - i) {
+            return -1;
+        }
+
         option_number_len = (*(packet_data_ptr + i) & 0x0F);
 
         if (option_number_len == 13) {
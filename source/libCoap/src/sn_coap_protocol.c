@@ -55,15 +55,26 @@ static void                  sn_coap_protocol_linked_list_duplication_info_remov
 #endif
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
 static void                  sn_coap_protocol_linked_list_blockwise_msg_remove(struct coap_s *handle, coap_blockwise_msg_s *removed_msg_ptr);
-static void                  sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *handle, sn_nsdl_addr_s *addr_ptr, uint16_t stored_payload_len, uint8_t *stored_payload_ptr);
+static int8_t                sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *handle, sn_nsdl_addr_s *addr_ptr, uint16_t stored_payload_len, uint8_t *stored_payload_ptr, uint32_t payload_offset, uint8_t last_block);
 static uint8_t              *sn_coap_protocol_linked_list_blockwise_payload_search(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint16_t *payload_length);
 static void                  sn_coap_protocol_linked_list_blockwise_payload_remove(struct coap_s *handle, coap_blockwise_payload_s *removed_payload_ptr);
 static void                  sn_coap_protocol_linked_list_blockwise_payload_remove_oldest(struct coap_s *handle);
 static uint32_t              sn_coap_protocol_linked_list_blockwise_payloads_get_len(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr);
+static uint8_t               sn_coap_protocol_linked_list_blockwise_payloads_complete(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr);
+static void                  sn_coap_protocol_linked_list_blockwise_payloads_gather(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint8_t *dst_payload_ptr, uint32_t dst_payload_len);
+static int8_t                sn_coap_protocol_send_block1_ack(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, sn_coap_hdr_s *received_coap_msg_ptr, void *param);
 static void                  sn_coap_protocol_linked_list_blockwise_remove_old_data(struct coap_s *handle);
 static sn_coap_hdr_s        *sn_coap_handle_blockwise_message(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, sn_coap_hdr_s *received_coap_msg_ptr, void *param);
 static int8_t                sn_coap_convert_block_size(uint16_t block_size);
 static sn_coap_hdr_s        *sn_coap_protocol_copy_header(struct coap_s *handle, sn_coap_hdr_s *source_header_ptr);
+static coap_blockwise_transfer_s *sn_coap_protocol_linked_list_blockwise_transfer_store(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr, uint8_t window, void *param);
+static coap_blockwise_transfer_s *sn_coap_protocol_linked_list_blockwise_transfer_search(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, sn_coap_hdr_s *received_coap_msg_ptr, coap_blockwise_transfer_slot_s **slot_pptr);
+static void                  sn_coap_protocol_linked_list_blockwise_transfer_remove(struct coap_s *handle, coap_blockwise_transfer_s *removed_transfer_ptr);
+static int8_t                sn_coap_protocol_blockwise_transfer_send(struct coap_s *handle, coap_blockwise_transfer_s *transfer_ptr, coap_blockwise_transfer_slot_s *slot_ptr);
+static void                  sn_coap_protocol_blockwise_transfer_fill_window(struct coap_s *handle, coap_blockwise_transfer_s *transfer_ptr);
+static int8_t                sn_coap_protocol_blockwise_download_store(coap_blockwise_transfer_s *download_ptr, uint32_t block_number, sn_coap_hdr_s *received_coap_msg_ptr);
+static sn_coap_hdr_s        *sn_coap_handle_blockwise_download(struct coap_s *handle, coap_blockwise_transfer_s *download_ptr, coap_blockwise_transfer_slot_s *slot_ptr, sn_coap_hdr_s *received_coap_msg_ptr);
+static sn_coap_hdr_s        *sn_coap_handle_blockwise_upload(struct coap_s *handle, coap_blockwise_transfer_s *upload_ptr, coap_blockwise_transfer_slot_s *slot_ptr, sn_coap_hdr_s *received_coap_msg_ptr);
 #endif
 #if ENABLE_RESENDINGS
 static void                  sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t send_packet_data_len, uint8_t *send_packet_data_ptr, uint32_t sending_time, void *param, uint8_t *uri_path_ptr, uint8_t uri_path_len);
@@ -115,6 +126,10 @@ int8_t sn_coap_protocol_destroy(struct coap_s *handle)
                 }
                 sn_coap_parser_release_allocated_coap_msg_mem(tmp->coap, tmp->coap_msg_ptr);
             }
+            if (tmp->payload_source_context) {
+                handle->sn_coap_protocol_free(tmp->payload_source_context);
+                tmp->payload_source_context = 0;
+            }
             ns_list_remove(&handle->linked_list_blockwise_sent_msgs, tmp);
             handle->sn_coap_protocol_free(tmp);
             tmp = 0;
@@ -135,6 +150,11 @@ int8_t sn_coap_protocol_destroy(struct coap_s *handle)
             tmp = 0;
         }
     }
+    ns_list_foreach_safe(coap_blockwise_transfer_s, tmp, &handle->linked_list_blockwise_transfers) {
+        if (tmp->coap == handle) {
+            sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, tmp);
+        }
+    }
 #endif
 
     handle->sn_coap_protocol_free(handle);
@@ -142,7 +162,7 @@ int8_t sn_coap_protocol_destroy(struct coap_s *handle)
     return 0;
 }
 
-struct coap_s *sn_coap_protocol_init(void *(*used_malloc_func_ptr)(uint16_t), void (*used_free_func_ptr)(void *),
+struct coap_s *sn_coap_protocol_init(void *(*used_malloc_func_ptr)(sn_coap_len_t), void (*used_free_func_ptr)(void *),
                                      uint8_t (*used_tx_callback_ptr)(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *),
                                      int8_t (*used_rx_callback_ptr)(sn_coap_hdr_s *, sn_nsdl_addr_s *, void *param))
 {
@@ -193,6 +213,7 @@ struct coap_s *sn_coap_protocol_init(void *(*used_malloc_func_ptr)(uint16_t), vo
 
     ns_list_init(&handle->linked_list_blockwise_sent_msgs);
     ns_list_init(&handle->linked_list_blockwise_received_payloads);
+    ns_list_init(&handle->linked_list_blockwise_transfers);
     handle->sn_coap_block_data_size = SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE;
 
 #endif /* ENABLE_RESENDINGS */
@@ -349,6 +370,53 @@ int8_t sn_coap_protocol_delete_retransmission(struct coap_s *handle, uint16_t ms
     return -2;
 }
 
+uint16_t sn_coap_protocol_reserve_message_id(struct coap_s *handle)
+{
+    uint16_t reserved_id;
+
+    if (handle == NULL) {
+        return 0;
+    }
+
+    reserved_id = message_id;
+    message_id++;
+    if (message_id == 0) {
+        message_id = 1;
+    }
+
+    return reserved_id;
+}
+
+void sn_coap_protocol_clear_sent_messages_by_param(struct coap_s *handle, void *param)
+{
+    if (handle == NULL) {
+        return;
+    }
+#if ENABLE_RESENDINGS
+    ns_list_foreach_safe(coap_send_msg_s, tmp, &handle->linked_list_resent_msgs) {
+        if (tmp->param == param) {
+            ns_list_remove(&handle->linked_list_resent_msgs, tmp);
+            --handle->count_resent_msgs;
+            sn_coap_protocol_release_allocated_send_msg_mem(handle, tmp);
+        }
+    }
+#endif
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+    /* Streamed payload source may refer to the owner of param */
+    ns_list_foreach_safe(coap_blockwise_msg_s, tmp, &handle->linked_list_blockwise_sent_msgs) {
+        if (tmp->payload_source && tmp->param == param) {
+            sn_coap_protocol_linked_list_blockwise_msg_remove(handle, tmp);
+        }
+    }
+    /* So may payload sink or source of a pipelined transfer */
+    ns_list_foreach_safe(coap_blockwise_transfer_s, tmp, &handle->linked_list_blockwise_transfers) {
+        if (tmp->param == param) {
+            sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, tmp);
+        }
+    }
+#endif
+}
+
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
 int8_t prepare_blockwise_message(struct coap_s *handle, sn_coap_hdr_s *src_coap_msg_ptr)
 {
@@ -394,7 +462,7 @@ int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_p
     tr_debug("sn_coap_protocol_build - payload len %d", src_coap_msg_ptr->payload_len);
     int16_t  byte_count_built     = 0;
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
-    uint16_t original_payload_len = 0;
+    sn_coap_len_t original_payload_len = 0;
 #endif
     /* * * * Check given pointers  * * * */
     if ((dst_addr_ptr == NULL) || (dst_packet_data_ptr == NULL) || (src_coap_msg_ptr == NULL) || handle == NULL) {
@@ -529,6 +597,236 @@ int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_p
     return byte_count_built;
 }
 
+int16_t sn_coap_protocol_build_copy(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *packet_data_ptr,
+                                    uint16_t packet_data_len, sn_coap_hdr_s *src_coap_msg_ptr, void *param)
+{
+    /* * * * Check given pointers  * * * */
+    if ((dst_addr_ptr == NULL) || (packet_data_ptr == NULL) || (src_coap_msg_ptr == NULL) || handle == NULL) {
+        return -2;
+    }
+
+    if (dst_addr_ptr->addr_ptr == NULL) {
+        return -2;
+    }
+
+    /* Token is rewritten in place, so it must take the same room */
+    if (packet_data_len < COAP_HEADER_LENGTH + src_coap_msg_ptr->token_len ||
+            (packet_data_ptr[0] & COAP_HEADER_TOKEN_LENGTH_MASK) != src_coap_msg_ptr->token_len ||
+            (src_coap_msg_ptr->token_len && src_coap_msg_ptr->token_ptr == NULL)) {
+        return -1;
+    }
+
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
+    /* Blockwise state is stored per message, so such messages are built one by one */
+    if (((src_coap_msg_ptr->payload_len > handle->sn_coap_block_data_size) && (handle->sn_coap_block_data_size > 0)) ||
+            src_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET) {
+        return -1;
+    }
+#endif
+
+    if (src_coap_msg_ptr->msg_type != COAP_MSG_TYPE_ACKNOWLEDGEMENT &&
+            src_coap_msg_ptr->msg_type != COAP_MSG_TYPE_RESET &&
+            src_coap_msg_ptr->msg_id == 0) {
+        src_coap_msg_ptr->msg_id = sn_coap_protocol_reserve_message_id(handle);
+    }
+
+    packet_data_ptr[2] = (uint8_t)(src_coap_msg_ptr->msg_id >> COAP_HEADER_MSG_ID_MSB_SHIFT);
+    packet_data_ptr[3] = (uint8_t)src_coap_msg_ptr->msg_id;
+    if (src_coap_msg_ptr->token_len) {
+        memcpy(packet_data_ptr + COAP_HEADER_LENGTH, src_coap_msg_ptr->token_ptr, src_coap_msg_ptr->token_len);
+    }
+
+#if ENABLE_RESENDINGS /* If Message resending is not used at all, this part of code will not be compiled */
+    if (src_coap_msg_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
+        sn_coap_protocol_linked_list_send_msg_store(handle, dst_addr_ptr, packet_data_len, packet_data_ptr,
+                handle->system_time + (uint32_t)(handle->sn_coap_resending_intervall * RESPONSE_RANDOM_FACTOR),
+                param, src_coap_msg_ptr->uri_path_ptr, src_coap_msg_ptr->uri_path_len);
+    }
+#else
+    (void)param;
+#endif /* ENABLE_RESENDINGS */
+
+    tr_debug("sn_coap_protocol_build_copy - msg id: [%d], bytes: [%d]", src_coap_msg_ptr->msg_id, packet_data_len);
+
+    return (int16_t)packet_data_len;
+}
+
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
+int8_t sn_coap_protocol_prepare_streamed_message(struct coap_s *handle, sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context)
+{
+    uint16_t first_block_len = 0;
+
+    if (!handle || !src_coap_msg_ptr || !payload_source || !payload_total_len || !handle->sn_coap_block_data_size) {
+        return -1;
+    }
+
+    /* Only request payload can be streamed, Block2 responses are served from stored payload */
+    if (src_coap_msg_ptr->msg_code >= COAP_MSG_CODE_RESPONSE_CREATED) {
+        return -1;
+    }
+
+    first_block_len = handle->sn_coap_block_data_size;
+    if (payload_total_len <= first_block_len) {
+        first_block_len = (uint16_t)payload_total_len;
+    } else {
+        /* Allocate memory for less used options */
+        if (sn_coap_parser_alloc_options(handle, src_coap_msg_ptr) == NULL) {
+            return -2;
+        }
+
+        /* First block (BLOCK NUMBER, 4 MSB bits) + More to come (MORE, 1 bit) */
+        src_coap_msg_ptr->options_list_ptr->block1 = 0x08;
+        src_coap_msg_ptr->options_list_ptr->block1 |= sn_coap_convert_block_size(handle->sn_coap_block_data_size);
+
+        src_coap_msg_ptr->options_list_ptr->use_size1 = true;
+        src_coap_msg_ptr->options_list_ptr->use_size2 = false;
+        src_coap_msg_ptr->options_list_ptr->size1 = payload_total_len;
+    }
+
+    src_coap_msg_ptr->payload_ptr = handle->sn_coap_protocol_malloc(first_block_len);
+    if (!src_coap_msg_ptr->payload_ptr) {
+        return -2;
+    }
+
+    if (payload_source(source_context, 0, src_coap_msg_ptr->payload_ptr, first_block_len) != first_block_len) {
+        handle->sn_coap_protocol_free(src_coap_msg_ptr->payload_ptr);
+        src_coap_msg_ptr->payload_ptr = 0;
+        return -1;
+    }
+    src_coap_msg_ptr->payload_len = first_block_len;
+
+    tr_debug("sn_coap_protocol_prepare_streamed_message - total len %lu", (unsigned long)payload_total_len);
+    return 0;
+}
+
+int16_t sn_coap_protocol_build_streamed(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr,
+        sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context, void *param)
+{
+    coap_blockwise_msg_s *stored_blockwise_msg_ptr = NULL;
+    int16_t byte_count_built = 0;
+
+    if (!handle || !src_coap_msg_ptr || !payload_source) {
+        return -2;
+    }
+
+    /* Whole payload fits to the first block, nothing to stream */
+    if (payload_total_len <= src_coap_msg_ptr->payload_len) {
+        byte_count_built = sn_coap_protocol_build(handle, dst_addr_ptr, dst_packet_data_ptr, src_coap_msg_ptr, param);
+        if (byte_count_built >= 0 && source_context) {
+            handle->sn_coap_protocol_free(source_context);
+        }
+        return byte_count_built;
+    }
+
+    /* Reserve storage before building, so that failure does not leave first block to resending queue */
+    stored_blockwise_msg_ptr = handle->sn_coap_protocol_malloc(sizeof(coap_blockwise_msg_s));
+    if (!stored_blockwise_msg_ptr) {
+        return -2;
+    }
+    memset(stored_blockwise_msg_ptr, 0, sizeof(coap_blockwise_msg_s));
+
+    stored_blockwise_msg_ptr->coap_msg_ptr = sn_coap_protocol_copy_header(handle, src_coap_msg_ptr);
+    if (stored_blockwise_msg_ptr->coap_msg_ptr == NULL) {
+        handle->sn_coap_protocol_free(stored_blockwise_msg_ptr);
+        return -2;
+    }
+
+    byte_count_built = sn_coap_protocol_build(handle, dst_addr_ptr, dst_packet_data_ptr, src_coap_msg_ptr, param);
+    if (byte_count_built < 0) {
+        sn_coap_parser_release_allocated_coap_msg_mem(handle, stored_blockwise_msg_ptr->coap_msg_ptr);
+        handle->sn_coap_protocol_free(stored_blockwise_msg_ptr);
+        return byte_count_built;
+    }
+
+    /* Fill struct, payload itself is never stored */
+    stored_blockwise_msg_ptr->timestamp = handle->system_time;
+    stored_blockwise_msg_ptr->coap_msg_ptr->msg_id = src_coap_msg_ptr->msg_id;
+    stored_blockwise_msg_ptr->payload_total_len = payload_total_len;
+    stored_blockwise_msg_ptr->payload_source = payload_source;
+    stored_blockwise_msg_ptr->payload_source_context = source_context;
+    stored_blockwise_msg_ptr->param = param;
+    stored_blockwise_msg_ptr->coap = handle;
+
+    ns_list_add_to_end(&handle->linked_list_blockwise_sent_msgs, stored_blockwise_msg_ptr);
+
+    return byte_count_built;
+}
+
+int8_t sn_coap_protocol_start_download(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr,
+        uint8_t window, uint16_t (*payload_sink)(void *, uint32_t, const uint8_t *, uint16_t), void *sink_context, void *param)
+{
+    coap_blockwise_transfer_s *transfer_ptr = NULL;
+    int8_t ret_val;
+
+    if (!handle || !dst_addr_ptr || !dst_addr_ptr->addr_ptr || !dst_addr_ptr->addr_len || !src_coap_msg_ptr ||
+            !payload_sink || !window || !handle->sn_coap_block_data_size) {
+        return -1;
+    }
+
+    if (src_coap_msg_ptr->msg_code != COAP_MSG_CODE_REQUEST_GET) {
+        return -1;
+    }
+
+    transfer_ptr = sn_coap_protocol_linked_list_blockwise_transfer_store(handle, dst_addr_ptr, src_coap_msg_ptr, window, param);
+    if (!transfer_ptr) {
+        return -2;
+    }
+    transfer_ptr->payload_sink = payload_sink;
+
+    /* First block is requested alone, server may want smaller blocks than we do */
+    transfer_ptr->payload_context = sink_context;
+    ret_val = sn_coap_protocol_blockwise_transfer_send(handle, transfer_ptr, &transfer_ptr->slots[0]);
+    if (ret_val != 0) {
+        /* Context stays with the caller when download could not be started */
+        transfer_ptr->payload_context = NULL;
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, transfer_ptr);
+        return ret_val;
+    }
+
+    tr_debug("sn_coap_protocol_start_download - window %d", transfer_ptr->window);
+    return 0;
+}
+
+int8_t sn_coap_protocol_start_upload(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr,
+        uint32_t payload_total_len, uint8_t window, uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t),
+        void *source_context, void *param)
+{
+    coap_blockwise_transfer_s *transfer_ptr = NULL;
+    int8_t ret_val;
+
+    if (!handle || !dst_addr_ptr || !dst_addr_ptr->addr_ptr || !dst_addr_ptr->addr_len || !src_coap_msg_ptr ||
+            !payload_source || !payload_total_len || !window || !handle->sn_coap_block_data_size) {
+        return -1;
+    }
+
+    if (src_coap_msg_ptr->msg_code != COAP_MSG_CODE_REQUEST_PUT && src_coap_msg_ptr->msg_code != COAP_MSG_CODE_REQUEST_POST) {
+        return -1;
+    }
+
+    transfer_ptr = sn_coap_protocol_linked_list_blockwise_transfer_store(handle, dst_addr_ptr, src_coap_msg_ptr, window, param);
+    if (!transfer_ptr) {
+        return -2;
+    }
+    transfer_ptr->payload_source = payload_source;
+    transfer_ptr->payload_total_len = payload_total_len;
+
+    /* First block is sent alone, server may want smaller blocks than we do */
+    transfer_ptr->payload_context = source_context;
+    ret_val = sn_coap_protocol_blockwise_transfer_send(handle, transfer_ptr, &transfer_ptr->slots[0]);
+    if (ret_val != 0) {
+        /* Context stays with the caller when upload could not be started */
+        transfer_ptr->payload_context = NULL;
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, transfer_ptr);
+        return ret_val;
+    }
+
+    tr_debug("sn_coap_protocol_start_upload - total len %lu, window %d", (unsigned long)payload_total_len, transfer_ptr->window);
+    return 0;
+}
+#endif
+
 sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint16_t packet_data_len, uint8_t *packet_data_ptr, void *param)
 {
     tr_debug("sn_coap_protocol_parse");
@@ -633,6 +931,17 @@ sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src
         } else { /* * * Message duplication detected * * */
             /* Set returned status to User */
             returned_dst_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_DUPLICATED_MSG;
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+            /* Acknowledgement of a block still being collected was lost, pipelining client resends it */
+            uint16_t stored_payload_len = 0;
+            if (returned_dst_coap_msg_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE &&
+                    returned_dst_coap_msg_ptr->msg_code <= COAP_MSG_CODE_REQUEST_DELETE &&
+                    returned_dst_coap_msg_ptr->options_list_ptr &&
+                    returned_dst_coap_msg_ptr->options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE &&
+                    sn_coap_protocol_linked_list_blockwise_payload_search(handle, src_addr_ptr, &stored_payload_len)) {
+                sn_coap_protocol_send_block1_ack(handle, src_addr_ptr, returned_dst_coap_msg_ptr, param);
+            }
+#endif
             // todo: send ACK to confirmable messages
             /* Because duplicate message, return with coap_status set */
             return returned_dst_coap_msg_ptr;
@@ -645,6 +954,20 @@ sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src
     /*** return to caller.                              ***/
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
 
+    /* Responses to pipelined requests are consumed by the transfer */
+    if (returned_dst_coap_msg_ptr->msg_code > COAP_MSG_CODE_REQUEST_DELETE ||
+            returned_dst_coap_msg_ptr->msg_type == COAP_MSG_TYPE_RESET) {
+        coap_blockwise_transfer_slot_s *slot_ptr = NULL;
+        coap_blockwise_transfer_s *transfer_ptr =
+            sn_coap_protocol_linked_list_blockwise_transfer_search(handle, src_addr_ptr, returned_dst_coap_msg_ptr, &slot_ptr);
+
+        if (transfer_ptr && transfer_ptr->payload_source) {
+            return sn_coap_handle_blockwise_upload(handle, transfer_ptr, slot_ptr, returned_dst_coap_msg_ptr);
+        } else if (transfer_ptr) {
+            return sn_coap_handle_blockwise_download(handle, transfer_ptr, slot_ptr, returned_dst_coap_msg_ptr);
+        }
+    }
+
     if (returned_dst_coap_msg_ptr->options_list_ptr != NULL &&
             (returned_dst_coap_msg_ptr->options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE ||
              returned_dst_coap_msg_ptr->options_list_ptr->block2 != COAP_OPTION_BLOCK_NONE)) {
@@ -662,17 +985,7 @@ sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src
 
         if (stored_blockwise_msg_temp_ptr) {
             tr_debug("sn_coap_protocol_parse - remove block message %d", stored_blockwise_msg_temp_ptr->coap_msg_ptr->msg_id);
-            ns_list_remove(&handle->linked_list_blockwise_sent_msgs, stored_blockwise_msg_temp_ptr);
-
-            if (stored_blockwise_msg_temp_ptr->coap_msg_ptr) {
-                if(stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_ptr){
-                    handle->sn_coap_protocol_free(stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_ptr);
-                    stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_ptr = 0;
-                }
-                sn_coap_parser_release_allocated_coap_msg_mem(stored_blockwise_msg_temp_ptr->coap, stored_blockwise_msg_temp_ptr->coap_msg_ptr);
-            }
-
-            handle->sn_coap_protocol_free(stored_blockwise_msg_temp_ptr);
+            sn_coap_protocol_linked_list_blockwise_msg_remove(handle, stored_blockwise_msg_temp_ptr);
             stored_blockwise_msg_temp_ptr = 0;
         }
     }
@@ -703,11 +1016,7 @@ sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src
             if (removed_msg_ptr != NULL) {
                 if (returned_dst_coap_msg_ptr->msg_type == COAP_MSG_TYPE_RESET) {
                     if(removed_msg_ptr->uri_path_len) {
-                        returned_dst_coap_msg_ptr->uri_path_ptr = handle->sn_coap_protocol_malloc(removed_msg_ptr->uri_path_len);
-                        if (returned_dst_coap_msg_ptr->uri_path_ptr != NULL) {
-                            memcpy(returned_dst_coap_msg_ptr->uri_path_ptr, removed_msg_ptr->uri_path_ptr, removed_msg_ptr->uri_path_len);
-                            returned_dst_coap_msg_ptr->uri_path_len = removed_msg_ptr->uri_path_len;
-                        }
+                        sn_coap_parser_set_uri_path(handle, returned_dst_coap_msg_ptr, removed_msg_ptr->uri_path_ptr, removed_msg_ptr->uri_path_len);
                     }
                 }
                 /* Remove resending message from active message resending Linked list */
@@ -790,11 +1099,91 @@ int8_t sn_coap_protocol_exec(struct coap_s *handle, uint32_t current_time)
         }
     }
 
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+    /* Pipelined transfers retransmit their own requests, one per window slot */
+    ns_list_foreach_safe(coap_blockwise_transfer_s, transfer_ptr, &handle->linked_list_blockwise_transfers) {
+        if (transfer_ptr->coap != handle) {
+            continue;
+        }
+        for (uint8_t i = 0; i < SN_COAP_BLOCKWISE_MAX_WINDOW; i++) {
+            coap_blockwise_transfer_slot_s *slot_ptr = &transfer_ptr->slots[i];
+
+            if (!slot_ptr->msg_id || current_time < slot_ptr->resending_time) {
+                continue;
+            }
+
+            slot_ptr->resending_counter++;
+            if (slot_ptr->resending_counter <= handle->sn_coap_resending_count) {
+                sn_coap_protocol_blockwise_transfer_send(handle, transfer_ptr, slot_ptr);
+                continue;
+            }
+
+            /* Block past the end of resource is not needed anyway */
+            if (transfer_ptr->last_block_known && slot_ptr->block_number > transfer_ptr->last_block_number) {
+                slot_ptr->msg_id = 0;
+                continue;
+            }
+
+            if (handle->sn_coap_rx_callback != 0) {
+                sn_coap_hdr_s *failed_msg_ptr = transfer_ptr->coap_msg_ptr;
+
+                failed_msg_ptr->msg_id = slot_ptr->msg_id;
+                if (transfer_ptr->payload_source) {
+                    failed_msg_ptr->options_list_ptr->block1 = (slot_ptr->block_number << 4) | transfer_ptr->block_size_exp;
+                } else {
+                    failed_msg_ptr->options_list_ptr->block2 = (slot_ptr->block_number << 4) | transfer_ptr->block_size_exp;
+                }
+                failed_msg_ptr->coap_status = COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED;
+                handle->sn_coap_rx_callback(failed_msg_ptr, &transfer_ptr->addr, transfer_ptr->param);
+            }
+            sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, transfer_ptr);
+            break;
+        }
+    }
+#endif
+
 #endif /* ENABLE_RESENDINGS */
 
     return 0;
 }
 
+int8_t sn_coap_protocol_get_next_deadline(struct coap_s *handle, uint32_t *deadline_ptr)
+{
+    int8_t ret_val = -1;
+
+    if (!handle || !deadline_ptr) {
+        return -1;
+    }
+
+#if ENABLE_RESENDINGS
+    ns_list_foreach(coap_send_msg_s, stored_msg_ptr, &handle->linked_list_resent_msgs) {
+        if (stored_msg_ptr->coap == handle) {
+            /* Compare as signed difference, system time may wrap */
+            if (ret_val != 0 || (int32_t)(stored_msg_ptr->resending_time - *deadline_ptr) < 0) {
+                *deadline_ptr = stored_msg_ptr->resending_time;
+                ret_val = 0;
+            }
+        }
+    }
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+    ns_list_foreach(coap_blockwise_transfer_s, transfer_ptr, &handle->linked_list_blockwise_transfers) {
+        if (transfer_ptr->coap != handle) {
+            continue;
+        }
+        for (uint8_t i = 0; i < SN_COAP_BLOCKWISE_MAX_WINDOW; i++) {
+            if (transfer_ptr->slots[i].msg_id &&
+                    (ret_val != 0 || (int32_t)(transfer_ptr->slots[i].resending_time - *deadline_ptr) < 0)) {
+                *deadline_ptr = transfer_ptr->slots[i].resending_time;
+                ret_val = 0;
+            }
+        }
+    }
+#endif
+#endif /* ENABLE_RESENDINGS */
+
+    return ret_val;
+}
+
 #if ENABLE_RESENDINGS  /* If Message resending is not used at all, this part of code will not be compiled */
 
 /**************************************************************************//**
@@ -1143,27 +1532,39 @@ static void sn_coap_protocol_linked_list_blockwise_msg_remove(struct coap_s *han
             sn_coap_parser_release_allocated_coap_msg_mem(handle, removed_msg_ptr->coap_msg_ptr);
         }
 
+        if (removed_msg_ptr->payload_source_context) {
+            handle->sn_coap_protocol_free(removed_msg_ptr->payload_source_context);
+            removed_msg_ptr->payload_source_context = 0;
+        }
+
         handle->sn_coap_protocol_free(removed_msg_ptr);
         removed_msg_ptr = 0;
     }
 }
 
 /**************************************************************************//**
- * \fn static void sn_coap_protocol_linked_list_blockwise_payload_store(sn_nsdl_addr_s *addr_ptr, uint16_t stored_payload_len, uint8_t *stored_payload_ptr)
+ * \fn static int8_t sn_coap_protocol_linked_list_blockwise_payload_store(sn_nsdl_addr_s *addr_ptr, uint16_t stored_payload_len,
+ *                                                      uint8_t *stored_payload_ptr, uint32_t payload_offset, uint8_t last_block)
  *
- * \brief Stores blockwise payload to Linked list
+ * \brief Stores blockwise payload to Linked list, payload already stored from same offset is replaced
  *
  * \param *addr_ptr is pointer to Address information to be stored
  * \param stored_payload_len is length of stored Payload
  * \param *stored_payload_ptr is pointer to stored Payload
+ * \param payload_offset is offset of Payload in whole blockwise payload
+ * \param last_block is 1 if more bit of block option was not set
+ *
+ * \return 0 if payload is stored or there is nothing to store, -2 if out of memory
  *****************************************************************************/
 
-static void sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *handle, sn_nsdl_addr_s *addr_ptr,
+static int8_t sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *handle, sn_nsdl_addr_s *addr_ptr,
         uint16_t stored_payload_len,
-        uint8_t *stored_payload_ptr)
+        uint8_t *stored_payload_ptr,
+        uint32_t payload_offset,
+        uint8_t last_block)
 {
     if (!addr_ptr || !stored_payload_len || !stored_payload_ptr) {
-        return;
+        return 0;
     }
 
     coap_blockwise_payload_s *stored_blockwise_payload_ptr = NULL;
@@ -1174,7 +1575,7 @@ static void sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *
     stored_blockwise_payload_ptr = handle->sn_coap_protocol_malloc(sizeof(coap_blockwise_payload_s));
 
     if (stored_blockwise_payload_ptr == NULL) {
-        return;
+        return -2;
     }
 
     /* Allocate memory for stored Payload's data */
@@ -1183,7 +1584,7 @@ static void sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *
     if (stored_blockwise_payload_ptr->payload_ptr == NULL) {
         handle->sn_coap_protocol_free(stored_blockwise_payload_ptr);
         stored_blockwise_payload_ptr = 0;
-        return;
+        return -2;
     }
 
     /* Allocate memory for stored Payload's address */
@@ -1195,7 +1596,7 @@ static void sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *
         handle->sn_coap_protocol_free(stored_blockwise_payload_ptr);
         stored_blockwise_payload_ptr = 0;
 
-        return;
+        return -2;
     }
 
     /* * * * Filling fields of stored Payload  * * * */
@@ -1206,12 +1607,29 @@ static void sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *
     stored_blockwise_payload_ptr->port = addr_ptr->port;
     memcpy(stored_blockwise_payload_ptr->payload_ptr, stored_payload_ptr, stored_payload_len);
     stored_blockwise_payload_ptr->payload_len = stored_payload_len;
+    stored_blockwise_payload_ptr->payload_offset = payload_offset;
+    stored_blockwise_payload_ptr->last_block = last_block;
 
     stored_blockwise_payload_ptr->coap = handle;
 
     /* * * * Storing Payload to Linked list  * * * */
 
+    /* Retransmitted block replaces the earlier copy, so every offset is stored only once.
+     * Earlier blocks of the same transfer are kept as long as new blocks keep arriving. */
+    ns_list_foreach_safe(coap_blockwise_payload_s, stored_payload_info_ptr, &handle->linked_list_blockwise_received_payloads) {
+        if (stored_payload_info_ptr->port == addr_ptr->port &&
+                0 == memcmp(addr_ptr->addr_ptr, stored_payload_info_ptr->addr_ptr, addr_ptr->addr_len)) {
+            if (stored_payload_info_ptr->payload_offset == payload_offset) {
+                sn_coap_protocol_linked_list_blockwise_payload_remove(handle, stored_payload_info_ptr);
+            } else {
+                stored_payload_info_ptr->timestamp = handle->system_time;
+            }
+        }
+    }
+
     ns_list_add_to_end(&handle->linked_list_blockwise_received_payloads, stored_blockwise_payload_ptr);
+
+    return 0;
 }
 
 /**************************************************************************//**
@@ -1320,6 +1738,64 @@ static uint32_t sn_coap_protocol_linked_list_blockwise_payloads_get_len(struct c
     return ret_whole_payload_len;
 }
 
+/**************************************************************************//**
+ * \fn static uint8_t sn_coap_protocol_linked_list_blockwise_payloads_complete(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr)
+ *
+ * \brief Checks if all blocks of blockwise payload are stored (Address as key)
+ *
+ * \param *src_addr_ptr is pointer to Address key
+ *
+ * \return 1 if last block and every block before it are stored, otherwise 0
+ *****************************************************************************/
+
+static uint8_t sn_coap_protocol_linked_list_blockwise_payloads_complete(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr)
+{
+    uint32_t stored_len = 0;
+    uint32_t whole_payload_len = 0;
+    uint8_t last_block_stored = 0;
+
+    ns_list_foreach(coap_blockwise_payload_s, searched_payload_info_ptr, &handle->linked_list_blockwise_received_payloads) {
+        if (searched_payload_info_ptr->port == src_addr_ptr->port &&
+                0 == memcmp(src_addr_ptr->addr_ptr, searched_payload_info_ptr->addr_ptr, src_addr_ptr->addr_len)) {
+            stored_len += searched_payload_info_ptr->payload_len;
+            if (searched_payload_info_ptr->last_block) {
+                last_block_stored = 1;
+                whole_payload_len = searched_payload_info_ptr->payload_offset + searched_payload_info_ptr->payload_len;
+            }
+        }
+    }
+
+    /* Blocks are stored once per offset, so lengths add up only when nothing is missing */
+    return (last_block_stored && stored_len == whole_payload_len);
+}
+
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_linked_list_blockwise_payloads_gather(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr,
+ *                                                      uint8_t *dst_payload_ptr, uint32_t dst_payload_len)
+ *
+ * \brief Copies stored blockwise payloads to their offsets and removes them from Linked list (Address as key)
+ *
+ * \param *src_addr_ptr is pointer to Address key
+ * \param *dst_payload_ptr is pointer to whole payload
+ * \param dst_payload_len is length of whole payload
+ *****************************************************************************/
+
+static void sn_coap_protocol_linked_list_blockwise_payloads_gather(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr,
+        uint8_t *dst_payload_ptr, uint32_t dst_payload_len)
+{
+    ns_list_foreach_safe(coap_blockwise_payload_s, searched_payload_info_ptr, &handle->linked_list_blockwise_received_payloads) {
+        if (searched_payload_info_ptr->port == src_addr_ptr->port &&
+                0 == memcmp(src_addr_ptr->addr_ptr, searched_payload_info_ptr->addr_ptr, src_addr_ptr->addr_len)) {
+            if (searched_payload_info_ptr->payload_offset <= dst_payload_len &&
+                    searched_payload_info_ptr->payload_len <= dst_payload_len - searched_payload_info_ptr->payload_offset) {
+                memcpy(dst_payload_ptr + searched_payload_info_ptr->payload_offset,
+                       searched_payload_info_ptr->payload_ptr, searched_payload_info_ptr->payload_len);
+            }
+            sn_coap_protocol_linked_list_blockwise_payload_remove(handle, searched_payload_info_ptr);
+        }
+    }
+}
+
 /**************************************************************************//**
  * \fn static void sn_coap_protocol_linked_list_blockwise_remove_old_data(struct coap_s *handle)
  *
@@ -1353,6 +1829,495 @@ static void sn_coap_protocol_linked_list_blockwise_remove_old_data(struct coap_s
             sn_coap_protocol_linked_list_blockwise_payload_remove(handle, removed_blocwise_payload_ptr);
         }
     }
+
+    /* Loop all pipelined transfers in Linked list, outstanding requests are timed out by retransmissions */
+    ns_list_foreach_safe(coap_blockwise_transfer_s, removed_transfer_ptr, &handle->linked_list_blockwise_transfers) {
+        if (removed_transfer_ptr->coap != handle ||
+                (handle->system_time - removed_transfer_ptr->timestamp) <= SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED) {
+            continue;
+        }
+#if ENABLE_RESENDINGS
+        uint8_t outstanding = 0;
+        for (uint8_t i = 0; i < SN_COAP_BLOCKWISE_MAX_WINDOW; i++) {
+            if (removed_transfer_ptr->slots[i].msg_id) {
+                outstanding = 1;
+            }
+        }
+        if (outstanding) {
+            continue;
+        }
+#endif
+        /* * * * Stalled transfer found, remove it from Linked list * * * */
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, removed_transfer_ptr);
+    }
+}
+
+/**************************************************************************//**
+ * \fn static coap_blockwise_transfer_s *sn_coap_protocol_linked_list_blockwise_transfer_store(struct coap_s *handle,
+ *        sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr, uint8_t window, void *param)
+ *
+ * \brief Stores new pipelined transfer to Linked list, first block is put to first window slot
+ *
+ * \param *dst_addr_ptr is pointer to address of the server
+ * \param *src_coap_msg_ptr is pointer to request to be copied
+ * \param window is maximum count of outstanding requests
+ * \param *param is passed to TX and RX callbacks
+ *
+ * \return Pointer to stored transfer or NULL if out of memory
+ *****************************************************************************/
+
+static coap_blockwise_transfer_s *sn_coap_protocol_linked_list_blockwise_transfer_store(struct coap_s *handle,
+        sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *src_coap_msg_ptr, uint8_t window, void *param)
+{
+    coap_blockwise_transfer_s *transfer_ptr = handle->sn_coap_protocol_malloc(sizeof(coap_blockwise_transfer_s));
+    if (!transfer_ptr) {
+        return NULL;
+    }
+    memset(transfer_ptr, 0, sizeof(coap_blockwise_transfer_s));
+    transfer_ptr->coap = handle;
+    ns_list_add_to_end(&handle->linked_list_blockwise_transfers, transfer_ptr);
+
+    transfer_ptr->addr.addr_ptr = handle->sn_coap_protocol_malloc(dst_addr_ptr->addr_len);
+    transfer_ptr->coap_msg_ptr = sn_coap_protocol_copy_header(handle, src_coap_msg_ptr);
+    if (!transfer_ptr->addr.addr_ptr || !transfer_ptr->coap_msg_ptr ||
+            sn_coap_parser_alloc_options(handle, transfer_ptr->coap_msg_ptr) == NULL) {
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, transfer_ptr);
+        return NULL;
+    }
+    memcpy(transfer_ptr->addr.addr_ptr, dst_addr_ptr->addr_ptr, dst_addr_ptr->addr_len);
+    transfer_ptr->addr.addr_len = dst_addr_ptr->addr_len;
+    transfer_ptr->addr.port = dst_addr_ptr->port;
+    transfer_ptr->addr.type = dst_addr_ptr->type;
+
+    if (window > SN_COAP_BLOCKWISE_MAX_WINDOW) {
+        window = SN_COAP_BLOCKWISE_MAX_WINDOW;
+    }
+
+    transfer_ptr->timestamp = handle->system_time;
+    transfer_ptr->param = param;
+    transfer_ptr->window = window;
+    transfer_ptr->block_size_exp = sn_coap_convert_block_size(handle->sn_coap_block_data_size);
+    transfer_ptr->coap_msg_ptr->options_list_ptr->block1 = COAP_OPTION_BLOCK_NONE;
+    transfer_ptr->coap_msg_ptr->options_list_ptr->block2 = COAP_OPTION_BLOCK_NONE;
+
+    transfer_ptr->slots[0].block_number = 0;
+    transfer_ptr->next_block_number = 1;
+
+    return transfer_ptr;
+}
+
+/**************************************************************************//**
+ * \fn static coap_blockwise_transfer_s *sn_coap_protocol_linked_list_blockwise_transfer_search(struct coap_s *handle,
+ *        sn_nsdl_addr_s *src_addr_ptr, sn_coap_hdr_s *received_coap_msg_ptr, coap_blockwise_transfer_slot_s **slot_pptr)
+ *
+ * \brief Searches pipelined transfer waiting for received response
+ *
+ * \param *src_addr_ptr is pointer to address of response sender
+ * \param *received_coap_msg_ptr is pointer to received response
+ * \param **slot_pptr is set to point to the window slot of the request
+ *
+ * \return Pointer to transfer or NULL if response does not belong to any transfer
+ *****************************************************************************/
+
+static coap_blockwise_transfer_s *sn_coap_protocol_linked_list_blockwise_transfer_search(struct coap_s *handle,
+        sn_nsdl_addr_s *src_addr_ptr, sn_coap_hdr_s *received_coap_msg_ptr, coap_blockwise_transfer_slot_s **slot_pptr)
+{
+    /* Separate response is matched by token and block number, piggybacked one by message ID */
+    uint8_t separate_response = (received_coap_msg_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE ||
+                                 received_coap_msg_ptr->msg_type == COAP_MSG_TYPE_NON_CONFIRMABLE);
+    uint32_t block_number = 0;
+
+    ns_list_foreach(coap_blockwise_transfer_s, transfer_ptr, &handle->linked_list_blockwise_transfers) {
+        if (transfer_ptr->coap != handle || transfer_ptr->addr.port != src_addr_ptr->port ||
+                transfer_ptr->addr.addr_len != src_addr_ptr->addr_len ||
+                memcmp(transfer_ptr->addr.addr_ptr, src_addr_ptr->addr_ptr, src_addr_ptr->addr_len)) {
+            continue;
+        }
+
+        if (separate_response) {
+            sn_coap_hdr_s *request_ptr = transfer_ptr->coap_msg_ptr;
+            if (request_ptr->token_len != received_coap_msg_ptr->token_len ||
+                    (request_ptr->token_len && memcmp(request_ptr->token_ptr, received_coap_msg_ptr->token_ptr, request_ptr->token_len))) {
+                continue;
+            }
+
+            /* Upload is answered with Block1, download with Block2 */
+            block_number = 0;
+            if (received_coap_msg_ptr->options_list_ptr) {
+                int32_t block = transfer_ptr->payload_source ? received_coap_msg_ptr->options_list_ptr->block1 :
+                                received_coap_msg_ptr->options_list_ptr->block2;
+                if (block != COAP_OPTION_BLOCK_NONE) {
+                    block_number = (uint32_t)block >> 4;
+                }
+            }
+        }
+
+        for (uint8_t i = 0; i < SN_COAP_BLOCKWISE_MAX_WINDOW; i++) {
+            coap_blockwise_transfer_slot_s *slot_ptr = &transfer_ptr->slots[i];
+
+            if (!slot_ptr->msg_id) {
+                continue;
+            }
+            if ((!separate_response && slot_ptr->msg_id == received_coap_msg_ptr->msg_id) ||
+                    (separate_response && slot_ptr->block_number == block_number)) {
+                *slot_pptr = slot_ptr;
+                return transfer_ptr;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_linked_list_blockwise_transfer_remove(struct coap_s *handle, coap_blockwise_transfer_s *removed_transfer_ptr)
+ *
+ * \brief Removes transfer from Linked list and releases its payload context
+ *
+ * \param *removed_transfer_ptr is transfer to be removed
+ *****************************************************************************/
+
+static void sn_coap_protocol_linked_list_blockwise_transfer_remove(struct coap_s *handle, coap_blockwise_transfer_s *removed_transfer_ptr)
+{
+    ns_list_remove(&handle->linked_list_blockwise_transfers, removed_transfer_ptr);
+
+    if (removed_transfer_ptr->coap_msg_ptr) {
+        sn_coap_parser_release_allocated_coap_msg_mem(handle, removed_transfer_ptr->coap_msg_ptr);
+        removed_transfer_ptr->coap_msg_ptr = 0;
+    }
+
+    if (removed_transfer_ptr->addr.addr_ptr) {
+        handle->sn_coap_protocol_free(removed_transfer_ptr->addr.addr_ptr);
+        removed_transfer_ptr->addr.addr_ptr = 0;
+    }
+
+    if (removed_transfer_ptr->payload_context) {
+        handle->sn_coap_protocol_free(removed_transfer_ptr->payload_context);
+        removed_transfer_ptr->payload_context = 0;
+    }
+
+    handle->sn_coap_protocol_free(removed_transfer_ptr);
+}
+
+/**************************************************************************//**
+ * \fn static int8_t sn_coap_protocol_blockwise_transfer_send(struct coap_s *handle, coap_blockwise_transfer_s *transfer_ptr, coap_blockwise_transfer_slot_s *slot_ptr)
+ *
+ * \brief Sends, or resends, request for the block of given window slot
+ *
+ * \param *transfer_ptr is transfer which request is sent
+ * \param *slot_ptr is window slot of the request, message ID is given to free slot
+ *
+ * \return 0 = success, -1 = request could not be built, -2 = out of memory
+ *****************************************************************************/
+
+static int8_t sn_coap_protocol_blockwise_transfer_send(struct coap_s *handle, coap_blockwise_transfer_s *transfer_ptr, coap_blockwise_transfer_slot_s *slot_ptr)
+{
+    sn_coap_hdr_s *request_ptr = transfer_ptr->coap_msg_ptr;
+    uint8_t *packet_ptr = NULL;
+    uint16_t packet_len = 0;
+    int8_t ret_val = 0;
+
+    if (!slot_ptr->msg_id) {
+        slot_ptr->msg_id = sn_coap_protocol_reserve_message_id(handle);
+        slot_ptr->resending_counter = 0;
+    }
+
+    request_ptr->msg_id = slot_ptr->msg_id;
+
+    if (transfer_ptr->payload_source) {
+        /* Upload, block is read from payload source again for every retransmission */
+        uint16_t block_size = 1u << (transfer_ptr->block_size_exp + 4);
+        uint32_t block_offset = slot_ptr->block_number << (transfer_ptr->block_size_exp + 4);
+        uint16_t payload_len = block_size;
+
+        request_ptr->options_list_ptr->block1 = COAP_OPTION_BLOCK_NONE;
+        request_ptr->options_list_ptr->use_size1 = false;
+        if (transfer_ptr->payload_total_len - block_offset <= block_size) {
+            payload_len = (uint16_t)(transfer_ptr->payload_total_len - block_offset);
+        }
+        if (transfer_ptr->payload_total_len > block_size) {
+            request_ptr->options_list_ptr->block1 = (slot_ptr->block_number << 4) | transfer_ptr->block_size_exp;
+            if (transfer_ptr->payload_total_len - block_offset > block_size) {
+                /* set more - bit */
+                request_ptr->options_list_ptr->block1 |= 0x08;
+            }
+            request_ptr->options_list_ptr->use_size1 = (slot_ptr->block_number == 0);
+            request_ptr->options_list_ptr->size1 = transfer_ptr->payload_total_len;
+        }
+
+        request_ptr->payload_ptr = handle->sn_coap_protocol_malloc(payload_len);
+        if (!request_ptr->payload_ptr) {
+            slot_ptr->msg_id = 0;
+            return -2;
+        }
+        request_ptr->payload_len = payload_len;
+        if (transfer_ptr->payload_source(transfer_ptr->payload_context, block_offset, request_ptr->payload_ptr, payload_len) != payload_len) {
+            ret_val = -1;
+        }
+    } else {
+        request_ptr->options_list_ptr->block2 = (slot_ptr->block_number << 4) | transfer_ptr->block_size_exp;
+
+        /* Ask server to tell resource size with the first block, so window never goes past the end */
+        request_ptr->options_list_ptr->use_size2 = (slot_ptr->block_number == 0);
+        request_ptr->options_list_ptr->size2 = 0;
+    }
+
+    if (ret_val == 0) {
+        packet_len = sn_coap_builder_calc_needed_packet_data_size_2(request_ptr, handle->sn_coap_block_data_size);
+        if (!packet_len) {
+            ret_val = -1;
+        }
+    }
+
+    if (ret_val == 0) {
+        packet_ptr = handle->sn_coap_protocol_malloc(packet_len);
+        if (!packet_ptr) {
+            ret_val = -2;
+        }
+    }
+
+    if (ret_val == 0 && sn_coap_builder_2(packet_ptr, request_ptr, handle->sn_coap_block_data_size) < 0) {
+        ret_val = -1;
+    }
+
+    if (ret_val == 0) {
+        handle->sn_coap_tx_callback(packet_ptr, packet_len, &transfer_ptr->addr, transfer_ptr->param);
+    }
+
+    if (packet_ptr) {
+        handle->sn_coap_protocol_free(packet_ptr);
+    }
+    if (request_ptr->payload_ptr) {
+        handle->sn_coap_protocol_free(request_ptr->payload_ptr);
+        request_ptr->payload_ptr = 0;
+        request_ptr->payload_len = 0;
+    }
+
+    if (ret_val != 0) {
+        slot_ptr->msg_id = 0;
+        return ret_val;
+    }
+
+#if ENABLE_RESENDINGS
+    slot_ptr->resending_time = handle->system_time + (((uint32_t)(handle->sn_coap_resending_intervall * RESPONSE_RANDOM_FACTOR)) <<
+                               slot_ptr->resending_counter);
+#endif
+
+    return 0;
+}
+
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_blockwise_transfer_fill_window(struct coap_s *handle, coap_blockwise_transfer_s *transfer_ptr)
+ *
+ * \brief Requests next blocks to free window slots
+ *
+ * \param *transfer_ptr is transfer which window is filled
+ *****************************************************************************/
+
+static void sn_coap_protocol_blockwise_transfer_fill_window(struct coap_s *handle, coap_blockwise_transfer_s *transfer_ptr)
+{
+    if (!transfer_ptr->block_size_agreed) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < transfer_ptr->window; i++) {
+        coap_blockwise_transfer_slot_s *slot_ptr = &transfer_ptr->slots[i];
+
+        if (slot_ptr->msg_id) {
+            continue;
+        }
+        if (transfer_ptr->last_block_known && transfer_ptr->next_block_number > transfer_ptr->last_block_number) {
+            return;
+        }
+        /* Block number is 20 bits */
+        if (transfer_ptr->next_block_number > 0xFFFFF) {
+            return;
+        }
+
+        slot_ptr->block_number = transfer_ptr->next_block_number;
+        if (sn_coap_protocol_blockwise_transfer_send(handle, transfer_ptr, slot_ptr) != 0) {
+            /* Retried when next response frees a slot */
+            return;
+        }
+        transfer_ptr->next_block_number++;
+    }
+}
+
+/**************************************************************************//**
+ * \fn static int8_t sn_coap_protocol_blockwise_download_store(coap_blockwise_transfer_s *download_ptr, uint32_t block_number, sn_coap_hdr_s *received_coap_msg_ptr)
+ *
+ * \brief Checks received 2.05 response against the download and gives its payload to payload sink
+ *
+ * \param *download_ptr is download the response belongs to
+ * \param block_number is number of the requested block
+ * \param *received_coap_msg_ptr is pointer to received response
+ *
+ * \return 0 = success, -1 = response does not fit to the download or payload sink failed
+ *****************************************************************************/
+
+static int8_t sn_coap_protocol_blockwise_download_store(coap_blockwise_transfer_s *download_ptr, uint32_t block_number, sn_coap_hdr_s *received_coap_msg_ptr)
+{
+    sn_coap_options_list_s *options_ptr = received_coap_msg_ptr->options_list_ptr;
+    uint8_t more = 0;
+
+    if (!options_ptr || options_ptr->block2 == COAP_OPTION_BLOCK_NONE) {
+        /* Whole resource fitted to one response */
+        if (block_number) {
+            return -1;
+        }
+        download_ptr->block_size_agreed = 1;
+    } else {
+        uint8_t block_size_exp = options_ptr->block2 & 0x07;
+        more = (options_ptr->block2 & 0x08) != 0;
+
+        if (((uint32_t)options_ptr->block2 >> 4) != block_number) {
+            return -1;
+        }
+
+        if (!download_ptr->block_size_agreed) {
+            /* Server may only make blocks smaller */
+            if (block_size_exp > download_ptr->block_size_exp) {
+                return -1;
+            }
+            download_ptr->block_size_exp = block_size_exp;
+            download_ptr->block_size_agreed = 1;
+
+            if (more && options_ptr->use_size2 && options_ptr->size2) {
+                download_ptr->last_block_known = 1;
+                download_ptr->last_block_number = (options_ptr->size2 - 1) >> (block_size_exp + 4);
+            }
+        } else if (block_size_exp != download_ptr->block_size_exp) {
+            return -1;
+        }
+    }
+
+    if (!more) {
+        if (download_ptr->last_block_known && block_number > download_ptr->last_block_number) {
+            return -1;
+        }
+        download_ptr->last_block_known = 1;
+        download_ptr->last_block_number = block_number;
+    } else if (download_ptr->last_block_known && block_number >= download_ptr->last_block_number) {
+        return -1;
+    }
+
+    if (received_coap_msg_ptr->payload_len &&
+            download_ptr->payload_sink(download_ptr->payload_context, block_number << (download_ptr->block_size_exp + 4),
+                                       received_coap_msg_ptr->payload_ptr, received_coap_msg_ptr->payload_len) != received_coap_msg_ptr->payload_len) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**************************************************************************//**
+ * \fn static sn_coap_hdr_s *sn_coap_handle_blockwise_download(struct coap_s *handle, coap_blockwise_transfer_s *download_ptr,
+ *        coap_blockwise_transfer_slot_s *slot_ptr, sn_coap_hdr_s *received_coap_msg_ptr)
+ *
+ * \brief Handles response to a download request and requests next blocks
+ *
+ * \param *download_ptr is download the response belongs to
+ * \param *slot_ptr is window slot of the answered request
+ * \param *received_coap_msg_ptr is pointer to received response
+ *
+ * \return Received response with coap_status set
+ *****************************************************************************/
+
+static sn_coap_hdr_s *sn_coap_handle_blockwise_download(struct coap_s *handle, coap_blockwise_transfer_s *download_ptr,
+        coap_blockwise_transfer_slot_s *slot_ptr, sn_coap_hdr_s *received_coap_msg_ptr)
+{
+    uint32_t block_number = slot_ptr->block_number;
+
+    slot_ptr->msg_id = 0;
+    download_ptr->timestamp = handle->system_time;
+
+    if (received_coap_msg_ptr->msg_type == COAP_MSG_TYPE_RESET ||
+            received_coap_msg_ptr->msg_code != COAP_MSG_CODE_RESPONSE_CONTENT) {
+        if (!block_number || (download_ptr->last_block_known && block_number <= download_ptr->last_block_number)) {
+            /* Needed block failed, error response is returned as it is */
+            sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, download_ptr);
+            return received_coap_msg_ptr;
+        }
+
+        /* Block past the end of resource, server did not tell the size */
+        if (!download_ptr->last_block_known) {
+            download_ptr->last_block_known = 1;
+            download_ptr->last_block_number = block_number - 1;
+        }
+    } else if (sn_coap_protocol_blockwise_download_store(download_ptr, block_number, received_coap_msg_ptr) != 0) {
+        tr_debug("sn_coap_handle_blockwise_download - block %lu rejected", (unsigned long)block_number);
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, download_ptr);
+        received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_MSG_REJECTED;
+        return received_coap_msg_ptr;
+    }
+
+    received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING;
+
+    sn_coap_protocol_blockwise_transfer_fill_window(handle, download_ptr);
+
+    /* Done when no needed block is outstanding, answers to requests past the end are not waited */
+    if (download_ptr->last_block_known && download_ptr->next_block_number > download_ptr->last_block_number) {
+        for (uint8_t i = 0; i < SN_COAP_BLOCKWISE_MAX_WINDOW; i++) {
+            if (download_ptr->slots[i].msg_id && download_ptr->slots[i].block_number <= download_ptr->last_block_number) {
+                return received_coap_msg_ptr;
+            }
+        }
+
+        tr_debug("sn_coap_handle_blockwise_download - %lu blocks received", (unsigned long)download_ptr->last_block_number + 1);
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, download_ptr);
+        received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED;
+        received_coap_msg_ptr->payload_ptr = NULL;
+        received_coap_msg_ptr->payload_len = 0;
+    }
+
+    return received_coap_msg_ptr;
+}
+
+/**************************************************************************//**
+ * \fn static sn_coap_hdr_s *sn_coap_handle_blockwise_upload(struct coap_s *handle, coap_blockwise_transfer_s *upload_ptr,
+ *        coap_blockwise_transfer_slot_s *slot_ptr, sn_coap_hdr_s *received_coap_msg_ptr)
+ *
+ * \brief Handles response to an upload request and sends next blocks
+ *
+ * \param *upload_ptr is upload the response belongs to
+ * \param *slot_ptr is window slot of the answered request
+ * \param *received_coap_msg_ptr is pointer to received response
+ *
+ * \return Received response, coap_status is COAP_STATUS_PARSER_BLOCKWISE_ACK for 2.31 Continue
+ *****************************************************************************/
+
+static sn_coap_hdr_s *sn_coap_handle_blockwise_upload(struct coap_s *handle, coap_blockwise_transfer_s *upload_ptr,
+        coap_blockwise_transfer_slot_s *slot_ptr, sn_coap_hdr_s *received_coap_msg_ptr)
+{
+    slot_ptr->msg_id = 0;
+    upload_ptr->timestamp = handle->system_time;
+
+    /* Final response or error ends the upload. Server answers only when it has all blocks,
+     * so acknowledgements of other blocks still outstanding are not needed anymore. */
+    if (received_coap_msg_ptr->msg_type == COAP_MSG_TYPE_RESET ||
+            received_coap_msg_ptr->msg_code != COAP_MSG_CODE_RESPONSE_CONTINUE) {
+        tr_debug("sn_coap_handle_blockwise_upload - done, code %d", received_coap_msg_ptr->msg_code);
+        sn_coap_protocol_linked_list_blockwise_transfer_remove(handle, upload_ptr);
+        return received_coap_msg_ptr;
+    }
+
+    if (!upload_ptr->block_size_agreed) {
+        /* Server may only make blocks smaller, it then kept the first block of its own size */
+        if (received_coap_msg_ptr->options_list_ptr &&
+                received_coap_msg_ptr->options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE &&
+                (received_coap_msg_ptr->options_list_ptr->block1 & 0x07) < upload_ptr->block_size_exp) {
+            upload_ptr->block_size_exp = received_coap_msg_ptr->options_list_ptr->block1 & 0x07;
+        }
+        upload_ptr->block_size_agreed = 1;
+        upload_ptr->last_block_known = 1;
+        upload_ptr->last_block_number = (upload_ptr->payload_total_len - 1) >> (upload_ptr->block_size_exp + 4);
+    }
+
+    received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_ACK;
+
+    sn_coap_protocol_blockwise_transfer_fill_window(handle, upload_ptr);
+
+    return received_coap_msg_ptr;
 }
 
 #endif /* SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE */
@@ -1483,7 +2448,7 @@ static uint16_t sn_coap_count_linked_list_size(const coap_send_msg_list_t *linke
 #endif
 
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
-void sn_coap_protocol_block_remove(struct coap_s *handle, sn_nsdl_addr_s *source_address, uint16_t payload_length, void *payload)
+void sn_coap_protocol_block_remove(struct coap_s *handle, sn_nsdl_addr_s *source_address, sn_coap_len_t payload_length, void *payload)
 {
     if(!handle || !source_address || !payload){
         return;
@@ -1514,6 +2479,90 @@ void sn_coap_protocol_block_remove(struct coap_s *handle, sn_nsdl_addr_s *source
         }
     }
 }
+/**************************************************************************//**
+ * \fn static int8_t sn_coap_protocol_send_block1_ack(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr,
+ *                                                      sn_coap_hdr_s *received_coap_msg_ptr, void *param)
+ *
+ * \brief Acknowledges received Block1 request, block size is limited to own block size
+ *
+ * \param *src_addr_ptr is pointer to source address of the request
+ * \param *received_coap_msg_ptr is pointer to received request
+ * \param *param is passed to TX callback
+ *
+ * \return 0 if success, -2 if out of memory
+ *****************************************************************************/
+
+static int8_t sn_coap_protocol_send_block1_ack(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr,
+        sn_coap_hdr_s *received_coap_msg_ptr, void *param)
+{
+    sn_coap_hdr_s *src_coap_blockwise_ack_msg_ptr = NULL;
+    uint16_t dst_packed_data_needed_mem = 0;
+    uint8_t *dst_ack_packet_data_ptr = NULL;
+    uint8_t block_temp = 0;
+
+    src_coap_blockwise_ack_msg_ptr = sn_coap_parser_alloc_message(handle);
+    if (src_coap_blockwise_ack_msg_ptr == NULL) {
+        return -2;
+    }
+
+    if (sn_coap_parser_alloc_options(handle, src_coap_blockwise_ack_msg_ptr) == NULL) {
+        handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr);
+        src_coap_blockwise_ack_msg_ptr = 0;
+        return -2;
+    }
+
+    // Response with COAP_MSG_CODE_RESPONSE_REQUEST_ENTITY_TOO_LARGE if the payload size is more than we can handle
+    tr_debug("sn_coap_protocol_send_block1_ack - incoming size: [%d]", received_coap_msg_ptr->options_list_ptr->size1);
+    uint32_t max_size = SN_COAP_MAX_INCOMING_BLOCK_MESSAGE_SIZE;
+    if (received_coap_msg_ptr->options_list_ptr->size1 > max_size) {
+        // Include maximum size that stack can handle into response
+        src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_REQUEST_ENTITY_TOO_LARGE;
+        src_coap_blockwise_ack_msg_ptr->options_list_ptr->size1 = max_size;
+
+    } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET) {
+        src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
+    } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST) {
+        src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTINUE;
+    } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT) {
+        src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTINUE;
+    } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_DELETE) {
+        src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_DELETED;
+    }
+
+    src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 = received_coap_msg_ptr->options_list_ptr->block1;
+    src_coap_blockwise_ack_msg_ptr->msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+
+    /* Check block size */
+    block_temp = (src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 & 0x07);
+    if (block_temp > sn_coap_convert_block_size(handle->sn_coap_block_data_size)) {
+        src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 &= 0xFFFFF8;
+        src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 |= sn_coap_convert_block_size(handle->sn_coap_block_data_size);
+    }
+
+    src_coap_blockwise_ack_msg_ptr->msg_id = received_coap_msg_ptr->msg_id;
+
+    dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
+
+    dst_ack_packet_data_ptr = handle->sn_coap_protocol_malloc(dst_packed_data_needed_mem);
+    if (!dst_ack_packet_data_ptr) {
+        handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->options_list_ptr);
+        src_coap_blockwise_ack_msg_ptr->options_list_ptr = 0;
+        handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr);
+        src_coap_blockwise_ack_msg_ptr = 0;
+        return -2;
+    }
+
+    sn_coap_builder_2(dst_ack_packet_data_ptr, src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
+    tr_debug("sn_coap_protocol_send_block1_ack - send msg id [%d]", src_coap_blockwise_ack_msg_ptr->msg_id);
+    handle->sn_coap_tx_callback(dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
+
+    sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
+    handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+    dst_ack_packet_data_ptr = 0;
+
+    return 0;
+}
+
 /**************************************************************************//**
  * \fn static int8_t sn_coap_handle_blockwise_message(void)
  *
@@ -1531,7 +2580,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
     uint8_t *dst_ack_packet_data_ptr = NULL;
     uint8_t block_temp = 0;
 
-    uint16_t original_payload_len = 0;
+    sn_coap_len_t original_payload_len = 0;
     uint8_t *original_payload_ptr = NULL;
 
     /* Block1 Option in a request (e.g., PUT or POST) */
@@ -1581,7 +2630,39 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     original_payload_len = stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len;
                     original_payload_ptr = stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_ptr;
 
-                    if ((block_size * (block_number + 1)) > stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len) {
+                    /* Keep transfer alive as long as blocks are acknowledged */
+                    stored_blockwise_msg_temp_ptr->timestamp = handle->system_time;
+
+                    if (stored_blockwise_msg_temp_ptr->payload_source) {
+                        /* Streamed payload, generate only the requested block */
+                        uint32_t block_offset = block_size * block_number;
+
+                        if (block_offset >= stored_blockwise_msg_temp_ptr->payload_total_len) {
+                            sn_coap_protocol_linked_list_blockwise_msg_remove(handle, stored_blockwise_msg_temp_ptr);
+                            sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
+                            return NULL;
+                        }
+
+                        src_coap_blockwise_ack_msg_ptr->payload_len = block_size;
+                        if ((stored_blockwise_msg_temp_ptr->payload_total_len - block_offset) > block_size) {
+                            /* set more - bit */
+                            src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 |= 0x08;
+                        } else {
+                            src_coap_blockwise_ack_msg_ptr->payload_len = (uint16_t)(stored_blockwise_msg_temp_ptr->payload_total_len - block_offset);
+                        }
+
+                        src_coap_blockwise_ack_msg_ptr->payload_ptr = handle->sn_coap_protocol_malloc(src_coap_blockwise_ack_msg_ptr->payload_len);
+                        if (!src_coap_blockwise_ack_msg_ptr->payload_ptr ||
+                                stored_blockwise_msg_temp_ptr->payload_source(stored_blockwise_msg_temp_ptr->payload_source_context, block_offset,
+                                        src_coap_blockwise_ack_msg_ptr->payload_ptr, src_coap_blockwise_ack_msg_ptr->payload_len) != src_coap_blockwise_ack_msg_ptr->payload_len) {
+                            tr_debug("sn_coap_handle_blockwise_message - block1 request, payload source failed");
+                            sn_coap_protocol_linked_list_blockwise_msg_remove(handle, stored_blockwise_msg_temp_ptr);
+                            sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
+                            return NULL;
+                        }
+                    }
+
+                    else if ((block_size * (block_number + 1)) > stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len) {
                         src_coap_blockwise_ack_msg_ptr->payload_len = stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len - (block_size * (block_number));
                         src_coap_blockwise_ack_msg_ptr->payload_ptr = src_coap_blockwise_ack_msg_ptr->payload_ptr + (block_size * block_number);
                     }
@@ -1597,7 +2678,13 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
 
                     dst_ack_packet_data_ptr = handle->sn_coap_protocol_malloc(dst_packed_data_needed_mem);
-                    if (!dst_ack_packet_data_ptr) {
+                    if (!dst_ack_packet_data_ptr && stored_blockwise_msg_temp_ptr->payload_source) {
+                        handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->payload_ptr);
+                        src_coap_blockwise_ack_msg_ptr->payload_ptr = 0;
+                        sn_coap_protocol_linked_list_blockwise_msg_remove(handle, stored_blockwise_msg_temp_ptr);
+                        sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
+                        return NULL;
+                    } else if (!dst_ack_packet_data_ptr) {
                         handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->options_list_ptr);
                         src_coap_blockwise_ack_msg_ptr->options_list_ptr = 0;
                         handle->sn_coap_protocol_free(original_payload_ptr);
@@ -1620,6 +2707,10 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
                     dst_ack_packet_data_ptr = 0;
 
+                    if (stored_blockwise_msg_temp_ptr->payload_source) {
+                        handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->payload_ptr);
+                    }
+
                     stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len = original_payload_len;
                     stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_ptr = original_payload_ptr;
 
@@ -1630,6 +2721,13 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                 tr_debug("sn_coap_handle_blockwise_message - block1 request - last block sent");
                 received_coap_msg_ptr->coap_status = COAP_STATUS_OK;
 
+                /* Streamed payload source is not needed anymore */
+                ns_list_foreach(coap_blockwise_msg_s, msg, &handle->linked_list_blockwise_sent_msgs) {
+                    if (msg->payload_source && msg->coap_msg_ptr && received_coap_msg_ptr->msg_id == msg->coap_msg_ptr->msg_id) {
+                        sn_coap_protocol_linked_list_blockwise_msg_remove(handle, msg);
+                        break;
+                    }
+                }
             }
         }
 
@@ -1640,74 +2738,29 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                 received_coap_msg_ptr->payload_len = handle->sn_coap_block_data_size;
             }
 
-            sn_coap_protocol_linked_list_blockwise_payload_store(handle, src_addr_ptr, received_coap_msg_ptr->payload_len, received_coap_msg_ptr->payload_ptr);
-            /* If not last block (more value is set) */
+            /* Blocks are placed by offset, pipelining client may send them out of order */
+            block_temp = received_coap_msg_ptr->options_list_ptr->block1 & 0x07;
+            if (block_temp > sn_coap_convert_block_size(handle->sn_coap_block_data_size)) {
+                block_temp = sn_coap_convert_block_size(handle->sn_coap_block_data_size);
+            }
+            if (sn_coap_protocol_linked_list_blockwise_payload_store(handle, src_addr_ptr, received_coap_msg_ptr->payload_len, received_coap_msg_ptr->payload_ptr,
+                    (uint32_t)(received_coap_msg_ptr->options_list_ptr->block1 >> 4) << (block_temp + 4),
+                    !(received_coap_msg_ptr->options_list_ptr->block1 & 0x08)) != 0) {
+                /* Block is not acknowledged, client sends it again */
+                tr_debug("sn_coap_handle_blockwise_message - block1 received, store fails");
+                sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
+                return NULL;
+            }
+
+            /* If some block is still missing, also last block is only acknowledged */
             /* Block option length can be 1-3 bytes. First 4-20 bits are for block number. Last 4 bits are ALWAYS more bit + block size. */
-            if (received_coap_msg_ptr->options_list_ptr->block1 & 0x08) {
+            if (!sn_coap_protocol_linked_list_blockwise_payloads_complete(handle, src_addr_ptr)) {
                 tr_debug("sn_coap_handle_blockwise_message - block1 received, send ack");
-                src_coap_blockwise_ack_msg_ptr = sn_coap_parser_alloc_message(handle);
-                if (src_coap_blockwise_ack_msg_ptr == NULL) {
+                if (sn_coap_protocol_send_block1_ack(handle, src_addr_ptr, received_coap_msg_ptr, param) != 0) {
                     sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
                     return NULL;
                 }
 
-                if (sn_coap_parser_alloc_options(handle, src_coap_blockwise_ack_msg_ptr) == NULL) {
-                    handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr);
-                    src_coap_blockwise_ack_msg_ptr = 0;
-                    sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
-                    return NULL;
-                }
-
-                // Response with COAP_MSG_CODE_RESPONSE_REQUEST_ENTITY_TOO_LARGE if the payload size is more than we can handle
-                tr_debug("sn_coap_handle_blockwise_message - block1 received - incoming size: [%d]", received_coap_msg_ptr->options_list_ptr->size1);
-                uint32_t max_size = SN_COAP_MAX_INCOMING_BLOCK_MESSAGE_SIZE;
-                if (received_coap_msg_ptr->options_list_ptr->size1 > max_size) {
-                    // Include maximum size that stack can handle into response
-                    src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_REQUEST_ENTITY_TOO_LARGE;
-                    src_coap_blockwise_ack_msg_ptr->options_list_ptr->size1 = max_size;
-
-                } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET) {
-                    src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
-                } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST) {
-                    src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTINUE;
-                } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT) {
-                    src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTINUE;
-                } else if (received_coap_msg_ptr->msg_code == COAP_MSG_CODE_REQUEST_DELETE) {
-                    src_coap_blockwise_ack_msg_ptr->msg_code = COAP_MSG_CODE_RESPONSE_DELETED;
-                }
-
-                src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 = received_coap_msg_ptr->options_list_ptr->block1;
-                src_coap_blockwise_ack_msg_ptr->msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
-
-                /* Check block size */
-                block_temp = (src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 & 0x07);
-                if (block_temp > sn_coap_convert_block_size(handle->sn_coap_block_data_size)) {
-                    src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 &= 0xFFFFF8;
-                    src_coap_blockwise_ack_msg_ptr->options_list_ptr->block1 |= sn_coap_convert_block_size(handle->sn_coap_block_data_size);
-                }
-
-                src_coap_blockwise_ack_msg_ptr->msg_id = received_coap_msg_ptr->msg_id;
-
-                dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
-
-                dst_ack_packet_data_ptr = handle->sn_coap_protocol_malloc(dst_packed_data_needed_mem);
-                if (!dst_ack_packet_data_ptr) {
-                    sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
-                    handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->options_list_ptr);
-                    src_coap_blockwise_ack_msg_ptr->options_list_ptr = 0;
-                    handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr);
-                    src_coap_blockwise_ack_msg_ptr = 0;
-                    return NULL;
-                }
-
-                sn_coap_builder_2(dst_ack_packet_data_ptr, src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
-                tr_debug("sn_coap_handle_blockwise_message - block1 received - send msg id [%d]", src_coap_blockwise_ack_msg_ptr->msg_id);
-                handle->sn_coap_tx_callback(dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
-
-                sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
-                handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
-                dst_ack_packet_data_ptr = 0;
-
                 received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING;
 
             } else {
@@ -1715,18 +2768,16 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                 /* * * This is the last block when whole Blockwise payload from received * * */
                 /* * * blockwise messages is gathered and returned to User               * * */
 
-                /* Store last Blockwise payload to Linked list */
-                uint16_t payload_len            = 0;
-                uint8_t *payload_ptr            = sn_coap_protocol_linked_list_blockwise_payload_search(handle, src_addr_ptr, &payload_len);
                 uint32_t whole_payload_len      = sn_coap_protocol_linked_list_blockwise_payloads_get_len(handle, src_addr_ptr);
                 uint8_t *temp_whole_payload_ptr = NULL;
 
                 tr_debug("sn_coap_handle_blockwise_message - block1 received, whole_payload_len %d", whole_payload_len);
-                temp_whole_payload_ptr = handle->sn_coap_protocol_malloc(whole_payload_len);
-                if (temp_whole_payload_ptr == NULL || whole_payload_len > UINT16_MAX) {
+                if (whole_payload_len <= SN_COAP_MAX_INCOMING_BLOCK_MESSAGE_SIZE) {
+                    temp_whole_payload_ptr = handle->sn_coap_protocol_malloc(whole_payload_len);
+                }
+                if (temp_whole_payload_ptr == NULL) {
                     tr_debug("sn_coap_handle_blockwise_message - block1 received, last block received alloc fails");
                     sn_coap_parser_release_allocated_coap_msg_mem(handle, received_coap_msg_ptr);
-                    handle->sn_coap_protocol_free(temp_whole_payload_ptr);
                     return 0;
                 }
 
@@ -1735,11 +2786,11 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                 received_coap_msg_ptr->payload_len = whole_payload_len;
 
                 /* Copy stored Blockwise payloads to returned whole Blockwise payload pointer */
-                while (payload_ptr != NULL) {
-                    memcpy(temp_whole_payload_ptr, payload_ptr, payload_len);
-                    temp_whole_payload_ptr += payload_len;
-                    sn_coap_protocol_linked_list_blockwise_payload_remove_oldest(handle);
-                    payload_ptr = sn_coap_protocol_linked_list_blockwise_payload_search(handle, src_addr_ptr, &payload_len);
+                sn_coap_protocol_linked_list_blockwise_payloads_gather(handle, src_addr_ptr, temp_whole_payload_ptr, whole_payload_len);
+
+                /* Block completing the payload may be other than the last one when blocks were reordered */
+                if (received_coap_msg_ptr->options_list_ptr->block1 & 0x08) {
+                    received_coap_msg_ptr->options_list_ptr->block1 = (((whole_payload_len - 1) >> (block_temp + 4)) << 4) | block_temp;
                 }
                 received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED;
             }
@@ -1757,8 +2808,9 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
             uint32_t block_number = 0;
 
             /* Store blockwise payload to Linked list */
-            //todo: add block number to stored values - just to make sure all packets are in order
-            sn_coap_protocol_linked_list_blockwise_payload_store(handle, src_addr_ptr, received_coap_msg_ptr->payload_len, received_coap_msg_ptr->payload_ptr);
+            sn_coap_protocol_linked_list_blockwise_payload_store(handle, src_addr_ptr, received_coap_msg_ptr->payload_len, received_coap_msg_ptr->payload_ptr,
+                    (uint32_t)(received_coap_msg_ptr->options_list_ptr->block2 >> 4) << ((received_coap_msg_ptr->options_list_ptr->block2 & 0x07) + 4),
+                    !(received_coap_msg_ptr->options_list_ptr->block2 & 0x08));
 
             /* If not last block (more value is set) */
             if (received_coap_msg_ptr->options_list_ptr->block2 & 0x08) {
@@ -1890,10 +2942,12 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                 /* Store last Blockwise payload to Linked list */
                 uint16_t payload_len            = 0;
                 uint8_t *payload_ptr            = sn_coap_protocol_linked_list_blockwise_payload_search(handle, src_addr_ptr, &payload_len);
-                uint16_t whole_payload_len      = sn_coap_protocol_linked_list_blockwise_payloads_get_len(handle, src_addr_ptr);
+                uint32_t whole_payload_len      = sn_coap_protocol_linked_list_blockwise_payloads_get_len(handle, src_addr_ptr);
                 uint8_t *temp_whole_payload_ptr = NULL;
 
-                temp_whole_payload_ptr = handle->sn_coap_protocol_malloc(whole_payload_len);
+                if (whole_payload_len <= SN_COAP_MAX_INCOMING_BLOCK_MESSAGE_SIZE) {
+                    temp_whole_payload_ptr = handle->sn_coap_protocol_malloc(whole_payload_len);
+                }
                 if (!temp_whole_payload_ptr) {
                     return 0;
                 }
@@ -1922,7 +2976,15 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
             tr_debug("sn_coap_handle_blockwise_message - block2 received");
             //Get message by using block number
             //NOTE: Getting the first from list might not be correct one
-            coap_blockwise_msg_s *stored_blockwise_msg_temp_ptr = ns_list_get_first(&handle->linked_list_blockwise_sent_msgs);
+            coap_blockwise_msg_s *stored_blockwise_msg_temp_ptr = NULL;
+
+            /* Streamed request payloads are not served as Block2 responses */
+            ns_list_foreach(coap_blockwise_msg_s, msg, &handle->linked_list_blockwise_sent_msgs) {
+                if (!msg->payload_source) {
+                    stored_blockwise_msg_temp_ptr = msg;
+                    break;
+                }
+            }
             if (stored_blockwise_msg_temp_ptr) {
                 uint16_t block_size;
                 uint32_t block_number;
@@ -2039,24 +3101,18 @@ static sn_coap_hdr_s *sn_coap_protocol_copy_header(struct coap_s *handle, sn_coa
     destination_header_ptr->msg_code = source_header_ptr->msg_code;
     destination_header_ptr->msg_id = source_header_ptr->msg_id;
 
-    if (source_header_ptr->uri_path_ptr) {
-        destination_header_ptr->uri_path_len = source_header_ptr->uri_path_len;
-        destination_header_ptr->uri_path_ptr = handle->sn_coap_protocol_malloc(source_header_ptr->uri_path_len);
-        if (!destination_header_ptr->uri_path_ptr) {
+    if (source_header_ptr->uri_path_ptr && source_header_ptr->uri_path_len) {
+        if (sn_coap_parser_set_uri_path(handle, destination_header_ptr, source_header_ptr->uri_path_ptr, source_header_ptr->uri_path_len) != 0) {
             sn_coap_parser_release_allocated_coap_msg_mem(handle, destination_header_ptr);
             return 0;
         }
-        memcpy(destination_header_ptr->uri_path_ptr, source_header_ptr->uri_path_ptr, source_header_ptr->uri_path_len);
     }
 
     if (source_header_ptr->token_ptr) {
-        destination_header_ptr->token_len = source_header_ptr->token_len;
-        destination_header_ptr->token_ptr = handle->sn_coap_protocol_malloc(source_header_ptr->token_len);
-        if (!destination_header_ptr->token_ptr) {
+        if (sn_coap_parser_set_token(handle, destination_header_ptr, source_header_ptr->token_ptr, source_header_ptr->token_len) != 0) {
             sn_coap_parser_release_allocated_coap_msg_mem(handle, destination_header_ptr);
             return 0;
         }
-        memcpy(destination_header_ptr->token_ptr, source_header_ptr->token_ptr, source_header_ptr->token_len);
     }
 
     destination_header_ptr->content_format = source_header_ptr->content_format;
@@ -38,6 +38,16 @@ extern "C" {
 #define SN_NDSL_RESOURCE_REGISTERING    1
 #define SN_NDSL_RESOURCE_REGISTERED     2
 
+/* Registration state of a resource is kept for each session sharing the store, two bits per session slot */
+#define SN_GRS_MAX_SESSIONS                 4
+#define SN_GRS_SESSION_BIT(slot)            (1u << (slot))
+#define SN_GRS_SESSION_STATE_SHIFT(slot)    ((slot) * 2)
+#define SN_GRS_SESSION_STATE_MASK           0x03
+
+/* Per-store state of a template resource: registration states of all session slots in the low byte */
+#define SN_GRS_TEMPLATE_REGISTRATION_MASK   0x00FF
+#define SN_GRS_TEMPLATE_HIDDEN              0x0100                              /* Deleted, or replaced by a writable copy */
+
 /***** Structs *****/
 
 typedef struct sn_grs_version_ {
@@ -48,40 +58,95 @@ typedef struct sn_grs_version_ {
 
 typedef NS_LIST_HEAD(sn_nsdl_resource_info_s, link) resource_list_t;
 
+/* Path of a registered resource deleted after registration, reported in next registration update */
+typedef struct sn_grs_removed_resource_ {
+    uint8_t *path;
+    uint16_t pathlen;
+    uint8_t sessions;                                                           /* Session slots whose server still has the link */
+    uint8_t sending;                                                            /* Session slots listing it in ongoing registration update */
+    ns_list_link_t link;
+} sn_grs_removed_resource_s;
+
+typedef NS_LIST_HEAD(sn_grs_removed_resource_s, link) removed_resource_list_t;
+
 struct grs_s {
     struct coap_s *coap;
 
-    void *(*sn_grs_alloc)(uint16_t);
+    void *(*sn_grs_alloc)(sn_coap_len_t);
     void (*sn_grs_free)(void *);
     uint8_t (*sn_grs_tx_callback)(struct nsdl_s *, sn_nsdl_capab_e , uint8_t *, uint16_t, sn_nsdl_addr_s *);
     int8_t (*sn_grs_rx_callback)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *);
 
     uint16_t resource_root_count;
     resource_list_t resource_root_list;
+
+    const sn_nsdl_resource_info_s *template_ptr;                                /* Shared read-only resources, owned by application */
+    uint16_t *template_state_ptr;                                               /* SN_GRS_TEMPLATE_ state of each template resource */
+    uint16_t template_count;
+
+    const sn_nsdl_static_handler_s *(*sn_grs_static_lookup)(const uint8_t *, uint16_t);   /* Handlers fixed at build time, searched first */
+
+    bool track_removed_resources:1;
+    removed_resource_list_t removed_resource_list;
+
+    uint8_t session_count;                                                      /* nsdl sessions sharing this resource store */
+    uint8_t session_slots;                                                      /* SN_GRS_SESSION_BIT of each slot in use */
 };
 
 
+/* Notification held back while endpoint sleeps in queue mode */
+typedef struct sn_nsdl_queued_notification_ {
+    uint8_t *token_ptr;
+    uint8_t *payload_ptr;
+    uint8_t *uri_path_ptr;
+    sn_coap_len_t payload_len;
+    uint16_t uri_path_len;
+    uint16_t msg_id;                                                            /* Reserved when queued, returned to application */
+    uint8_t token_len;
+    uint8_t content_format;
+    int32_t observe;
+    sn_coap_msg_type_e message_type;
+    ns_list_link_t link;
+} sn_nsdl_queued_notification_s;
+
+typedef NS_LIST_HEAD(sn_nsdl_queued_notification_s, link) queued_notification_list_t;
+
 struct nsdl_s {
     uint16_t update_register_msg_id;
-    uint16_t register_msg_len;
-    uint16_t update_register_msg_len;
+    uint32_t register_msg_len;
+    uint32_t update_register_msg_len;
+    uint32_t lifetime;                                                          /* Registration lifetime in seconds */
+    uint32_t update_deadline;                                                   /* System time of next automatic registration update */
+    uint32_t update_jitter_seed;                                                /* Spreads automatic updates of different endpoints */
 
     uint16_t register_msg_id;
     uint16_t unregister_msg_id;
 
     uint16_t bootstrap_msg_id;
+    uint16_t register_uri_query_len;                                            /* Length of pre-encoded registration Uri-Query */
+    uint16_t update_uri_query_len;                                              /* Length of pre-encoded registration update Uri-Query */
     uint16_t oma_bs_port;                                                       /* Bootstrap port */
+    uint8_t session_slot;                                                       /* Registration state of this session in shared resources */
     uint8_t oma_bs_address_len;                                                 /* Bootstrap address length */
+    uint8_t update_interval_percent;                                            /* Automatic update interval in percents of lifetime, 0 = disabled */
+    uint8_t queued_notification_count;
     unsigned int sn_nsdl_endpoint_registered:1;
     bool handle_bootstrap_msg:1;
+    bool registration_streaming:1;                                              /* Registration payload is generated block by block */
+    bool update_scheduled:1;                                                    /* update_deadline is valid */
+    bool sleeping:1;                                                            /* Queue mode, notifications are held back */
+    bool coalesce_notifications:1;                                              /* Only latest queued notification of an observation is kept */
 
     struct grs_s *grs;
     uint8_t *oma_bs_address_ptr;                                                /* Bootstrap address pointer. If null, no bootstrap in use */
     sn_nsdl_ep_parameters_s *ep_information_ptr;                                // Endpoint parameters, Name, Domain etc..
     sn_nsdl_oma_server_info_t *nsp_address_ptr;                                 // NSP server address information
+    uint8_t *register_uri_query_ptr;                                            /* ep=, et=, lt=, d= and b= query, built in set_endpoint_info */
+    uint8_t *update_uri_query_ptr;                                              /* lt= query of the latest registration update */
+    queued_notification_list_t queued_notification_list;                        /* Sent in one burst on wake up or registration update */
 
     void (*sn_nsdl_oma_bs_done_cb)(sn_nsdl_oma_server_info_t *server_info_ptr); /* Callback to inform application when bootstrap is done */
-    void *(*sn_nsdl_alloc)(uint16_t);
+    void *(*sn_nsdl_alloc)(sn_coap_len_t);
     void (*sn_nsdl_free)(void *);
     uint8_t (*sn_nsdl_tx_callback)(struct nsdl_s *, sn_nsdl_capab_e , uint8_t *, uint16_t, sn_nsdl_addr_s *);
     uint8_t (*sn_nsdl_rx_callback)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *);
@@ -108,12 +173,13 @@ struct nsdl_s {
  *
 */
 extern struct grs_s *sn_grs_init(uint8_t (*sn_grs_tx_callback_ptr)(struct nsdl_s *, sn_nsdl_capab_e , uint8_t *, uint16_t,
-                                 sn_nsdl_addr_s *), int8_t (*sn_grs_rx_callback_ptr)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *), void *(*sn_grs_alloc)(uint16_t), void (*sn_grs_free)(void *));
+                                 sn_nsdl_addr_s *), int8_t (*sn_grs_rx_callback_ptr)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *), void *(*sn_grs_alloc)(sn_coap_len_t), void (*sn_grs_free)(void *));
 
 extern const sn_nsdl_resource_info_s    *sn_grs_get_first_resource(struct grs_s *handle);
 extern const sn_nsdl_resource_info_s    *sn_grs_get_next_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *sn_grs_current_resource);
 extern int8_t                           sn_grs_process_coap(struct nsdl_s *handle, sn_coap_hdr_s *coap_packet_ptr, sn_nsdl_addr_s *src);
-extern sn_nsdl_resource_info_s          *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method);
+extern const sn_nsdl_resource_info_s    *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method);
+extern sn_nsdl_resource_info_s          *sn_grs_make_writable(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr);
 extern int8_t                           sn_grs_destroy(struct grs_s *handle);
 extern sn_grs_resource_list_s           *sn_grs_list_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path);
 extern void                             sn_grs_free_resource_list(struct grs_s *handle, sn_grs_resource_list_s *list);
@@ -123,6 +189,17 @@ extern int8_t                           sn_grs_create_resource(struct grs_s *han
 extern int8_t                           sn_grs_put_resource(struct grs_s *handle, sn_nsdl_resource_info_s *res);
 extern int8_t                           sn_grs_delete_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path);
 extern void                             sn_grs_mark_resources_as_registered(struct nsdl_s *handle);
+extern int8_t                           sn_grs_set_resource_template(struct grs_s *handle, const sn_nsdl_resource_info_s *resources, uint16_t resource_count);
+extern int8_t                           sn_grs_set_static_dispatch(struct grs_s *handle, const sn_nsdl_static_handler_s *(*lookup)(const uint8_t *, uint16_t));
+extern uint8_t                          sn_grs_get_registration_state(const struct grs_s *handle, const sn_nsdl_resource_info_s *res, uint8_t session_slot);
+extern void                             sn_grs_set_registration_state(struct grs_s *handle, const sn_nsdl_resource_info_s *res, uint8_t session_slot, uint8_t state);
+extern int8_t                           sn_grs_alloc_session_slot(struct grs_s *handle);
+extern void                             sn_grs_free_session_slot(struct grs_s *handle, uint8_t session_slot);
+extern void                             sn_grs_set_removed_resource_tracking(struct grs_s *handle, bool enable);
+extern const sn_grs_removed_resource_s  *sn_grs_get_first_removed_resource(struct grs_s *handle);
+extern const sn_grs_removed_resource_s  *sn_grs_get_next_removed_resource(struct grs_s *handle, const sn_grs_removed_resource_s *current_ptr);
+extern void                             sn_grs_mark_removed_resources_as_sending(struct grs_s *handle, uint8_t session_slot);
+extern void                             sn_grs_release_removed_resources(struct grs_s *handle, uint8_t session_mask, bool only_sent);
 
 #ifdef __cplusplus
 }
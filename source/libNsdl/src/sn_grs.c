@@ -46,6 +46,14 @@ static int8_t                       sn_grs_add_resource_to_list(struct grs_s *ha
 static int8_t                       sn_grs_core_request(struct nsdl_s *handle, sn_nsdl_addr_s *src_addr_ptr, sn_coap_hdr_s *coap_packet_ptr);
 static uint8_t                      coap_tx_callback(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *);
 static int8_t                       coap_rx_callback(sn_coap_hdr_s *coap_ptr, sn_nsdl_addr_s *address_ptr, void *param);
+static void                         sn_grs_store_removed_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr);
+static void                         sn_grs_forget_removed_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path);
+static bool                         sn_grs_is_template_resource(const struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr);
+static const sn_nsdl_resource_info_s *sn_grs_next_template_resource(const struct grs_s *handle, uint16_t index);
+static sn_nsdl_resource_info_s     *sn_grs_copy_template_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr);
+static bool                         sn_grs_method_allowed(uint8_t access, uint8_t msg_code);
+static int8_t                       sn_grs_call_dynamic(struct nsdl_s *nsdl_handle, uint8_t (*callback)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e),
+                                                        sn_coap_hdr_s *coap_packet_ptr, sn_nsdl_addr_s *src_addr_ptr);
 
 /* Extern function prototypes */
 extern int8_t                       sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *message_ptr, uint8_t updating_registeration);
@@ -65,6 +73,8 @@ extern int8_t sn_grs_destroy(struct grs_s *handle)
         --handle->resource_root_count;
         sn_grs_resource_info_free(handle, tmp);
     }
+    sn_grs_release_removed_resources(handle, UINT8_MAX, false);
+    handle->sn_grs_free(handle->template_state_ptr);
     handle->sn_grs_free(handle);
 
     return 0;
@@ -110,7 +120,7 @@ static int8_t coap_rx_callback(sn_coap_hdr_s *coap_ptr, sn_nsdl_addr_s *address_
 */
 extern struct grs_s *sn_grs_init(uint8_t (*sn_grs_tx_callback_ptr)(struct nsdl_s *, sn_nsdl_capab_e , uint8_t *, uint16_t,
                                  sn_nsdl_addr_s *), int8_t (*sn_grs_rx_callback_ptr)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *),
-                                 void *(*sn_grs_alloc)(uint16_t), void (*sn_grs_free)(void *))
+                                 void *(*sn_grs_alloc)(sn_coap_len_t), void (*sn_grs_free)(void *))
 {
 
     struct grs_s *handle_ptr = NULL;
@@ -137,6 +147,10 @@ extern struct grs_s *sn_grs_init(uint8_t (*sn_grs_tx_callback_ptr)(struct nsdl_s
     handle_ptr->sn_grs_tx_callback = sn_grs_tx_callback_ptr;
     handle_ptr->sn_grs_rx_callback = sn_grs_rx_callback_ptr;
 
+    /* Store is owned by the nsdl handle which created it, in slot 0. More sessions may attach later */
+    handle_ptr->session_count = 1;
+    handle_ptr->session_slots = SN_GRS_SESSION_BIT(0);
+
     /* Initialize CoAP protocol library */
     handle_ptr->coap = sn_coap_protocol_init(sn_grs_alloc, sn_grs_free, coap_tx_callback, coap_rx_callback);
 
@@ -148,6 +162,7 @@ extern sn_grs_resource_list_s *sn_grs_list_resource(struct grs_s *handle, uint16
 {
     (void) pathlen;
     sn_grs_resource_list_s *grs_resource_list_ptr = NULL;
+    const sn_nsdl_resource_info_s *grs_resource_ptr;
 
     if( handle == NULL || path == NULL){
         return NULL;
@@ -159,9 +174,13 @@ extern sn_grs_resource_list_s *sn_grs_list_resource(struct grs_s *handle, uint16
         goto fail;
     }
 
-    /* Count resources to the resource list struct */
+    /* Count resources to the resource list struct, template resources included */
     grs_resource_list_ptr->res_count = handle->resource_root_count;
     grs_resource_list_ptr->res = NULL;
+    for (grs_resource_ptr = sn_grs_next_template_resource(handle, 0); grs_resource_ptr;
+            grs_resource_ptr = sn_grs_next_template_resource(handle, (uint16_t)(grs_resource_ptr - handle->template_ptr) + 1)) {
+        grs_resource_list_ptr->res_count++;
+    }
 
     /**************************************/
     /* Fill resource structs to the table */
@@ -184,7 +203,8 @@ extern sn_grs_resource_list_s *sn_grs_list_resource(struct grs_s *handle, uint16
         }
 
         i = 0;
-        ns_list_foreach(sn_nsdl_resource_info_s, grs_resource_ptr, &handle->resource_root_list) {
+        for (grs_resource_ptr = sn_grs_get_first_resource(handle); grs_resource_ptr && i < grs_resource_list_ptr->res_count;
+                grs_resource_ptr = sn_grs_get_next_resource(handle, grs_resource_ptr)) {
             /* Copy pathlen to resource list */
             grs_resource_list_ptr->res[i].pathlen = grs_resource_ptr->pathlen;
 
@@ -229,24 +249,40 @@ extern void sn_grs_free_resource_list(struct grs_s *handle, sn_grs_resource_list
 
 extern const sn_nsdl_resource_info_s *sn_grs_get_first_resource(struct grs_s *handle)
 {
+    const sn_nsdl_resource_info_s *first;
+
     if( !handle ){
         return NULL;
     }
-    return ns_list_get_first(&handle->resource_root_list);
+    /* Own resources first, then visible template resources */
+    first = ns_list_get_first(&handle->resource_root_list);
+    if (!first) {
+        first = sn_grs_next_template_resource(handle, 0);
+    }
+    return first;
 }
 
 extern const sn_nsdl_resource_info_s *sn_grs_get_next_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *sn_grs_current_resource)
 {
+    const sn_nsdl_resource_info_s *next;
+
     if( !handle || !sn_grs_current_resource ){
         return NULL;
     }
-    return ns_list_get_next(&handle->resource_root_list, sn_grs_current_resource);
+    if (sn_grs_is_template_resource(handle, sn_grs_current_resource)) {
+        return sn_grs_next_template_resource(handle, (uint16_t)(sn_grs_current_resource - handle->template_ptr) + 1);
+    }
+    next = ns_list_get_next(&handle->resource_root_list, sn_grs_current_resource);
+    if (!next) {
+        next = sn_grs_next_template_resource(handle, 0);
+    }
+    return next;
 }
 
 extern int8_t sn_grs_delete_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path)
 {
     /* Local variables */
-    sn_nsdl_resource_info_s     *resource_temp  = NULL;
+    const sn_nsdl_resource_info_s *resource_temp = NULL;
 
     /* Search if resource found */
     resource_temp = sn_grs_search_resource(handle, pathlen, path, SN_GRS_SEARCH_METHOD);
@@ -258,12 +294,23 @@ extern int8_t sn_grs_delete_resource(struct grs_s *handle, uint16_t pathlen, uin
 
     /* If found, delete it and delete also subresources, if there is any */
     do {
-        /* Remove from list */
-        ns_list_remove(&handle->resource_root_list, resource_temp);
-        --handle->resource_root_count;
+        /* Server knows this link, it must be told that it is gone */
+        sn_grs_store_removed_resource(handle, resource_temp);
+
+        if (sn_grs_is_template_resource(handle, resource_temp)) {
+            /* Template is shared, it is only hidden from this store */
+            handle->template_state_ptr[resource_temp - handle->template_ptr] = SN_GRS_TEMPLATE_HIDDEN;
+        } else {
+            /* Own resource is returned as it is, nothing is copied */
+            sn_nsdl_resource_info_s *own_ptr = sn_grs_make_writable(handle, resource_temp);
 
-        /* Free */
-        sn_grs_resource_info_free(handle, resource_temp);
+            /* Remove from list */
+            ns_list_remove(&handle->resource_root_list, own_ptr);
+            --handle->resource_root_count;
+
+            /* Free */
+            sn_grs_resource_info_free(handle, own_ptr);
+        }
 
         /* Search for subresources */
         resource_temp = sn_grs_search_resource(handle, pathlen, path, SN_GRS_DELETE_METHOD);
@@ -281,8 +328,8 @@ extern int8_t sn_grs_update_resource(struct grs_s *handle, sn_nsdl_resource_info
         return SN_NSDL_FAILURE;
     }
 
-    /* Search resource */
-    resource_temp = sn_grs_search_resource(handle, res->pathlen, res->path, SN_GRS_SEARCH_METHOD);
+    /* Search resource, template resource is copied before it is changed */
+    resource_temp = sn_grs_make_writable(handle, sn_grs_search_resource(handle, res->pathlen, res->path, SN_GRS_SEARCH_METHOD));
     if (!resource_temp) {
         return SN_NSDL_FAILURE;
     }
@@ -339,6 +386,7 @@ extern int8_t sn_grs_create_resource(struct grs_s *handle, sn_nsdl_resource_info
 
     /* Create resource */
     if (sn_grs_add_resource_to_list(handle, res) == SN_NSDL_SUCCESS) {
+        sn_grs_forget_removed_resource(handle, res->pathlen, res->path);
         return SN_NSDL_SUCCESS;
     }
     return SN_GRS_LIST_ADDING_FAILURE;
@@ -369,6 +417,8 @@ int8_t sn_grs_put_resource(struct grs_s *handle, sn_nsdl_resource_info_s *res)
     ns_list_add_to_start(&handle->resource_root_list, res);
     ++handle->resource_root_count;
 
+    sn_grs_forget_removed_resource(handle, res->pathlen, res->path);
+
     return SN_NSDL_SUCCESS;
 }
 
@@ -397,7 +447,9 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
         return SN_NSDL_FAILURE;
     }
 
-    sn_nsdl_resource_info_s *resource_temp_ptr  = NULL;
+    const sn_nsdl_resource_info_s *resource_temp_ptr = NULL;
+    sn_nsdl_resource_info_s *writable_ptr = NULL;
+    const sn_nsdl_static_handler_s *static_handler_ptr = NULL;
     sn_coap_msg_code_e      status              = COAP_MSG_CODE_EMPTY;
     sn_coap_hdr_s           *response_message_hdr_ptr = NULL;
     struct grs_s            *handle = nsdl_handle->grs;
@@ -409,8 +461,19 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
             return sn_grs_core_request(nsdl_handle, src_addr_ptr, coap_packet_ptr);
         }
 
-        /* Get resource */
-        resource_temp_ptr = sn_grs_search_resource(handle, coap_packet_ptr->uri_path_len, coap_packet_ptr->uri_path_ptr, SN_GRS_SEARCH_METHOD);
+        /* Handlers fixed at build time first, resource store is searched only if there is none */
+        if (handle->sn_grs_static_lookup) {
+            static_handler_ptr = handle->sn_grs_static_lookup(coap_packet_ptr->uri_path_ptr, coap_packet_ptr->uri_path_len);
+        }
+        if (static_handler_ptr) {
+            if (sn_grs_method_allowed(static_handler_ptr->access, coap_packet_ptr->msg_code)) {
+                return sn_grs_call_dynamic(nsdl_handle, static_handler_ptr->callback, coap_packet_ptr, src_addr_ptr);
+            }
+            status = COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED;
+        } else {
+            /* Get resource */
+            resource_temp_ptr = sn_grs_search_resource(handle, coap_packet_ptr->uri_path_len, coap_packet_ptr->uri_path_ptr, SN_GRS_SEARCH_METHOD);
+        }
 
         /* * * * * * * * * * * */
         /* If resource exists  */
@@ -419,24 +482,10 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
             /* If dynamic resource, go to callback */
             if (resource_temp_ptr->mode == SN_GRS_DYNAMIC) {
                 /* Check accesses */
-                if (((coap_packet_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET) && !(resource_temp_ptr->access & SN_GRS_GET_ALLOWED))          ||
-                        ((coap_packet_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST) && !(resource_temp_ptr->access & SN_GRS_POST_ALLOWED))   ||
-                        ((coap_packet_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT) && !(resource_temp_ptr->access & SN_GRS_PUT_ALLOWED))     ||
-                        ((coap_packet_ptr->msg_code == COAP_MSG_CODE_REQUEST_DELETE) && !(resource_temp_ptr->access & SN_GRS_DELETE_ALLOWED))) {
-
+                if (!sn_grs_method_allowed(resource_temp_ptr->access, coap_packet_ptr->msg_code)) {
                     status = COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED;
                 } else {
-                    /* Do not call null pointer.. */
-                    if (resource_temp_ptr->sn_grs_dyn_res_callback != NULL) {
-                        resource_temp_ptr->sn_grs_dyn_res_callback(nsdl_handle, coap_packet_ptr, src_addr_ptr, SN_NSDL_PROTOCOL_COAP);
-                    }
-
-                    if (coap_packet_ptr->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED && coap_packet_ptr->payload_ptr) {
-                        handle->sn_grs_free(coap_packet_ptr->payload_ptr);
-                        coap_packet_ptr->payload_ptr = 0;
-                    }
-                    sn_coap_parser_release_allocated_coap_msg_mem(handle->coap, coap_packet_ptr);
-                    return SN_NSDL_SUCCESS;
+                    return sn_grs_call_dynamic(nsdl_handle, resource_temp_ptr->sn_grs_dyn_res_callback, coap_packet_ptr, src_addr_ptr);
                 }
             } else {
                 /* Static resource handling */
@@ -451,20 +500,25 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
                         break;
                     case (COAP_MSG_CODE_REQUEST_POST):
                         if (resource_temp_ptr->access & SN_GRS_POST_ALLOWED) {
-                            resource_temp_ptr->resourcelen = coap_packet_ptr->payload_len;
-                            handle->sn_grs_free(resource_temp_ptr->resource);
-                            resource_temp_ptr->resource = 0;
-                            if (resource_temp_ptr->resourcelen) {
-                                resource_temp_ptr->resource = handle->sn_grs_alloc(resource_temp_ptr->resourcelen);
-                                if (!resource_temp_ptr->resource) {
+                            writable_ptr = sn_grs_make_writable(handle, resource_temp_ptr);
+                            if (!writable_ptr) {
+                                status = COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR;
+                                break;
+                            }
+                            writable_ptr->resourcelen = coap_packet_ptr->payload_len;
+                            handle->sn_grs_free(writable_ptr->resource);
+                            writable_ptr->resource = 0;
+                            if (writable_ptr->resourcelen) {
+                                writable_ptr->resource = handle->sn_grs_alloc(writable_ptr->resourcelen);
+                                if (!writable_ptr->resource) {
                                     status = COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR;
                                     break;
                                 }
-                                memcpy(resource_temp_ptr->resource, coap_packet_ptr->payload_ptr, resource_temp_ptr->resourcelen);
+                                memcpy(writable_ptr->resource, coap_packet_ptr->payload_ptr, writable_ptr->resourcelen);
                             }
                             if (coap_packet_ptr->content_format != COAP_CT_NONE) {
-                                if (resource_temp_ptr->resource_parameters_ptr) {
-                                    resource_temp_ptr->resource_parameters_ptr->coap_content_type = coap_packet_ptr->content_format;
+                                if (writable_ptr->resource_parameters_ptr) {
+                                    writable_ptr->resource_parameters_ptr->coap_content_type = coap_packet_ptr->content_format;
                                 }
                             }
                             status = COAP_MSG_CODE_RESPONSE_CHANGED;
@@ -474,20 +528,25 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
                         break;
                     case (COAP_MSG_CODE_REQUEST_PUT):
                         if (resource_temp_ptr->access & SN_GRS_PUT_ALLOWED) {
-                            resource_temp_ptr->resourcelen = coap_packet_ptr->payload_len;
-                            handle->sn_grs_free(resource_temp_ptr->resource);
-                            resource_temp_ptr->resource = 0;
-                            if (resource_temp_ptr->resourcelen) {
-                                resource_temp_ptr->resource = handle->sn_grs_alloc(resource_temp_ptr->resourcelen);
-                                if (!resource_temp_ptr->resource) {
+                            writable_ptr = sn_grs_make_writable(handle, resource_temp_ptr);
+                            if (!writable_ptr) {
+                                status = COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR;
+                                break;
+                            }
+                            writable_ptr->resourcelen = coap_packet_ptr->payload_len;
+                            handle->sn_grs_free(writable_ptr->resource);
+                            writable_ptr->resource = 0;
+                            if (writable_ptr->resourcelen) {
+                                writable_ptr->resource = handle->sn_grs_alloc(writable_ptr->resourcelen);
+                                if (!writable_ptr->resource) {
                                     status = COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR;
                                     break;
                                 }
-                                memcpy(resource_temp_ptr->resource, coap_packet_ptr->payload_ptr, resource_temp_ptr->resourcelen);
+                                memcpy(writable_ptr->resource, coap_packet_ptr->payload_ptr, writable_ptr->resourcelen);
                             }
                             if (coap_packet_ptr->content_format != COAP_CT_NONE) {
-                                if (resource_temp_ptr->resource_parameters_ptr) {
-                                    resource_temp_ptr->resource_parameters_ptr->coap_content_type = coap_packet_ptr->content_format;
+                                if (writable_ptr->resource_parameters_ptr) {
+                                    writable_ptr->resource_parameters_ptr->coap_content_type = coap_packet_ptr->content_format;
                                 }
                             }
                             status = COAP_MSG_CODE_RESPONSE_CHANGED;
@@ -521,7 +580,7 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
         /* If resource was not found */
         /* * * * * * * * * * * * * * */
 
-        else {
+        else if (!static_handler_ptr) {
             if (coap_packet_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST) {
                 handle->sn_grs_rx_callback(nsdl_handle, coap_packet_ptr, src_addr_ptr);
 
@@ -573,9 +632,7 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
         response_message_hdr_ptr->msg_id = coap_packet_ptr->msg_id;
 
         if (coap_packet_ptr->token_ptr) {
-            response_message_hdr_ptr->token_len = coap_packet_ptr->token_len;
-            response_message_hdr_ptr->token_ptr = handle->sn_grs_alloc(response_message_hdr_ptr->token_len);
-            if (!response_message_hdr_ptr->token_ptr) {
+            if (sn_coap_parser_set_token(handle->coap, response_message_hdr_ptr, coap_packet_ptr->token_ptr, coap_packet_ptr->token_len) != 0) {
                 sn_coap_parser_release_allocated_coap_msg_mem(handle->coap, response_message_hdr_ptr);
 
                 if (coap_packet_ptr->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED && coap_packet_ptr->payload_ptr) {
@@ -586,7 +643,6 @@ extern int8_t sn_grs_process_coap(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coa
                 sn_coap_parser_release_allocated_coap_msg_mem(handle->coap, coap_packet_ptr);
                 return SN_NSDL_FAILURE;
             }
-            memcpy(response_message_hdr_ptr->token_ptr, coap_packet_ptr->token_ptr, response_message_hdr_ptr->token_len);
         }
 
         if (status == COAP_MSG_CODE_RESPONSE_CONTENT) {
@@ -739,11 +795,12 @@ static int8_t sn_grs_core_request(struct nsdl_s *handle, sn_nsdl_addr_s *src_add
 }
 
 /**
- * \fn  static sn_grs_resource_info_s *sn_grs_search_resource(uint16_t pathlen, uint8_t *path, uint8_t search_method)
+ * \fn  const sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method)
  *
  * \brief Searches given resource from linked list
  *
  *  Search either precise path, or subresources, eg. dr/x -> returns dr/x/1, dr/x/2 etc...
+ *  Result may be a shared template resource, so it is read-only. Use sn_grs_make_writable() to change it.
  *
  *  \param  pathlen         Length of the path to be search
  *
@@ -755,7 +812,7 @@ static int8_t sn_grs_core_request(struct nsdl_s *handle, sn_nsdl_addr_s *src_add
  *
 */
 
-sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method)
+const sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method)
 {
 
     /* Local variables */
@@ -780,6 +837,12 @@ sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t p
                 }
             }
         }
+        for (const sn_nsdl_resource_info_s *template_temp = sn_grs_next_template_resource(handle, 0); template_temp;
+                template_temp = sn_grs_next_template_resource(handle, (uint16_t)(template_temp - handle->template_ptr) + 1)) {
+            if (template_temp->pathlen == pathlen && 0 == memcmp(template_temp->path, path_temp_ptr, pathlen)) {
+                return template_temp;
+            }
+        }
     }
     /* Search also subresources, eg. dr/x -> returns dr/x/1, dr/x/2 etc... */
     else if (search_method == SN_GRS_DELETE_METHOD) {
@@ -792,6 +855,13 @@ sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t p
                 return resource_search_temp;
             }
         }
+        for (const sn_nsdl_resource_info_s *template_temp = sn_grs_next_template_resource(handle, 0); template_temp;
+                template_temp = sn_grs_next_template_resource(handle, (uint16_t)(template_temp - handle->template_ptr) + 1)) {
+            if (template_temp->pathlen > pathlen && template_temp->path[pathlen] == '/' &&
+                    0 == memcmp(template_temp->path, path_temp_ptr, pathlen)) {
+                return template_temp;
+            }
+        }
     }
 
     /* If there was not nodes we wanted, return NULL */
@@ -974,7 +1044,7 @@ static int8_t sn_grs_resource_info_free(struct grs_s *handle, sn_nsdl_resource_i
 {
     if (resource_ptr) {
         if (resource_ptr->resource_parameters_ptr) {
-            if (!resource_ptr->is_put) {
+            if (!resource_ptr->is_put && !resource_ptr->from_template) {
                 if (resource_ptr->resource_parameters_ptr->interface_description_ptr) {
                     handle->sn_grs_free(resource_ptr->resource_parameters_ptr->interface_description_ptr);
                     resource_ptr->resource_parameters_ptr->interface_description_ptr = 0;
@@ -1000,7 +1070,7 @@ static int8_t sn_grs_resource_info_free(struct grs_s *handle, sn_nsdl_resource_i
         }
 
         if (!resource_ptr->is_put) {
-            if (resource_ptr->path) {
+            if (resource_ptr->path && !resource_ptr->from_template) {
                 handle->sn_grs_free(resource_ptr->path);
                 resource_ptr->path = 0;
             }
@@ -1028,10 +1098,407 @@ void sn_grs_mark_resources_as_registered(struct nsdl_s *handle)
 
     while (temp_resource) {
         if (temp_resource->resource_parameters_ptr) {
-            if (temp_resource->resource_parameters_ptr->registered == SN_NDSL_RESOURCE_REGISTERING) {
-                temp_resource->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
+            if (sn_grs_get_registration_state(handle->grs, temp_resource, handle->session_slot) == SN_NDSL_RESOURCE_REGISTERING) {
+                sn_grs_set_registration_state(handle->grs, temp_resource, handle->session_slot, SN_NDSL_RESOURCE_REGISTERED);
             }
         }
         temp_resource = sn_grs_get_next_resource(handle->grs, temp_resource);
     }
 }
+
+void sn_grs_set_removed_resource_tracking(struct grs_s *handle, bool enable)
+{
+    if( !handle ){
+        return;
+    }
+
+    handle->track_removed_resources = enable;
+    if (!enable) {
+        sn_grs_release_removed_resources(handle, UINT8_MAX, false);
+    }
+}
+
+const sn_grs_removed_resource_s *sn_grs_get_first_removed_resource(struct grs_s *handle)
+{
+    if( !handle ){
+        return NULL;
+    }
+    return ns_list_get_first(&handle->removed_resource_list);
+}
+
+const sn_grs_removed_resource_s *sn_grs_get_next_removed_resource(struct grs_s *handle, const sn_grs_removed_resource_s *current_ptr)
+{
+    if( !handle || !current_ptr ){
+        return NULL;
+    }
+    return ns_list_get_next(&handle->removed_resource_list, current_ptr);
+}
+
+void sn_grs_mark_removed_resources_as_sending(struct grs_s *handle, uint8_t session_slot)
+{
+    if( !handle ){
+        return;
+    }
+
+    ns_list_foreach(sn_grs_removed_resource_s, removed_ptr, &handle->removed_resource_list) {
+        if (removed_ptr->sessions & SN_GRS_SESSION_BIT(session_slot)) {
+            removed_ptr->sending |= SN_GRS_SESSION_BIT(session_slot);
+        }
+    }
+}
+
+void sn_grs_release_removed_resources(struct grs_s *handle, uint8_t session_mask, bool only_sent)
+{
+    if( !handle ){
+        return;
+    }
+
+    ns_list_foreach_safe(sn_grs_removed_resource_s, removed_ptr, &handle->removed_resource_list) {
+        uint8_t released = only_sent ? (removed_ptr->sending & session_mask) : session_mask;
+
+        removed_ptr->sessions &= ~released;
+        removed_ptr->sending &= ~released;
+
+        /* Path is kept until every server which had the link has been told */
+        if (!removed_ptr->sessions) {
+            ns_list_remove(&handle->removed_resource_list, removed_ptr);
+            handle->sn_grs_free(removed_ptr->path);
+            handle->sn_grs_free(removed_ptr);
+        }
+    }
+}
+
+/**
+ * \fn static void sn_grs_store_removed_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+ *
+ * \brief Stores path of deleted resource, if it has been published to server.
+ *        If memory runs out, link stays in server until next full registration.
+ *
+ * \param *handle         Pointer to grs handle
+ * \param *resource_ptr   Resource being deleted
+ */
+static void sn_grs_store_removed_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+{
+    sn_grs_removed_resource_s *removed_ptr;
+    uint8_t sessions = 0;
+    uint8_t slot;
+
+    if (!handle->track_removed_resources || !resource_ptr->publish_uri || !resource_ptr->resource_parameters_ptr) {
+        return;
+    }
+
+    for (slot = 0; slot < SN_GRS_MAX_SESSIONS; slot++) {
+        if (sn_grs_get_registration_state(handle, resource_ptr, slot) != SN_NDSL_RESOURCE_NOT_REGISTERED) {
+            sessions |= SN_GRS_SESSION_BIT(slot);
+        }
+    }
+    if (!sessions) {
+        return;
+    }
+
+    removed_ptr = handle->sn_grs_alloc(sizeof(sn_grs_removed_resource_s));
+    if (!removed_ptr) {
+        return;
+    }
+    memset(removed_ptr, 0, sizeof(sn_grs_removed_resource_s));
+
+    removed_ptr->path = handle->sn_grs_alloc(resource_ptr->pathlen);
+    if (!removed_ptr->path) {
+        handle->sn_grs_free(removed_ptr);
+        return;
+    }
+    memcpy(removed_ptr->path, resource_ptr->path, resource_ptr->pathlen);
+    removed_ptr->pathlen = resource_ptr->pathlen;
+    removed_ptr->sessions = sessions;
+
+    ns_list_add_to_start(&handle->removed_resource_list, removed_ptr);
+}
+
+/**
+ * \fn static void sn_grs_forget_removed_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path)
+ *
+ * \brief Drops pending removal of a path that was created again. Removal already being sent
+ *        to a server is kept for it, re-created resource is then listed in following update.
+ *
+ * \param *handle     Pointer to grs handle
+ * \param pathlen     Length of the path
+ * \param *path       Path of the created resource
+ */
+static void sn_grs_forget_removed_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path)
+{
+    /* Stored paths are without '/' - marks in the end and beginning */
+    path = sn_grs_convert_uri(&pathlen, path);
+
+    ns_list_foreach_safe(sn_grs_removed_resource_s, removed_ptr, &handle->removed_resource_list) {
+        if (removed_ptr->pathlen == pathlen && !memcmp(removed_ptr->path, path, pathlen)) {
+            removed_ptr->sessions &= removed_ptr->sending;
+            if (!removed_ptr->sessions) {
+                ns_list_remove(&handle->removed_resource_list, removed_ptr);
+                handle->sn_grs_free(removed_ptr->path);
+                handle->sn_grs_free(removed_ptr);
+            }
+        }
+    }
+}
+
+int8_t sn_grs_set_resource_template(struct grs_s *handle, const sn_nsdl_resource_info_s *resources, uint16_t resource_count)
+{
+    uint16_t i;
+
+    if (!handle || !resources || !resource_count || handle->template_ptr) {
+        return SN_NSDL_FAILURE;
+    }
+
+    /* Template paths are used as they are, so they are checked instead of converted */
+    for (i = 0; i < resource_count; i++) {
+        const sn_nsdl_resource_info_s *resource_ptr = &resources[i];
+
+        if (!resource_ptr->pathlen || !resource_ptr->path ||
+                resource_ptr->path[0] == '/' || resource_ptr->path[resource_ptr->pathlen - 1] == '/') {
+            return SN_GRS_INVALID_PATH;
+        }
+        if (sn_grs_search_resource(handle, resource_ptr->pathlen, resource_ptr->path, SN_GRS_SEARCH_METHOD)) {
+            return SN_GRS_RESOURCE_ALREADY_EXISTS;
+        }
+    }
+
+    handle->template_state_ptr = handle->sn_grs_alloc(resource_count * sizeof(uint16_t));
+    if (!handle->template_state_ptr) {
+        return SN_NSDL_FAILURE;
+    }
+    /* Not registered to any session */
+    memset(handle->template_state_ptr, 0, resource_count * sizeof(uint16_t));
+
+    handle->template_ptr = resources;
+    handle->template_count = resource_count;
+
+    return SN_NSDL_SUCCESS;
+}
+
+int8_t sn_grs_set_static_dispatch(struct grs_s *handle, const sn_nsdl_static_handler_s *(*lookup)(const uint8_t *, uint16_t))
+{
+    if (!handle) {
+        return SN_NSDL_FAILURE;
+    }
+
+    handle->sn_grs_static_lookup = lookup;
+
+    return SN_NSDL_SUCCESS;
+}
+
+uint8_t sn_grs_get_registration_state(const struct grs_s *handle, const sn_nsdl_resource_info_s *res, uint8_t session_slot)
+{
+    uint8_t states;
+
+    if (!handle || !res || session_slot >= SN_GRS_MAX_SESSIONS) {
+        return SN_NDSL_RESOURCE_NOT_REGISTERED;
+    }
+    if (sn_grs_is_template_resource(handle, res)) {
+        states = (uint8_t)(handle->template_state_ptr[res - handle->template_ptr] & SN_GRS_TEMPLATE_REGISTRATION_MASK);
+    } else if (res->resource_parameters_ptr) {
+        states = res->resource_parameters_ptr->registered;
+    } else {
+        return SN_NDSL_RESOURCE_NOT_REGISTERED;
+    }
+    return (states >> SN_GRS_SESSION_STATE_SHIFT(session_slot)) & SN_GRS_SESSION_STATE_MASK;
+}
+
+void sn_grs_set_registration_state(struct grs_s *handle, const sn_nsdl_resource_info_s *res, uint8_t session_slot, uint8_t state)
+{
+    uint8_t shift = SN_GRS_SESSION_STATE_SHIFT(session_slot);
+
+    if (!handle || !res || session_slot >= SN_GRS_MAX_SESSIONS) {
+        return;
+    }
+    if (sn_grs_is_template_resource(handle, res)) {
+        uint16_t *state_ptr = &handle->template_state_ptr[res - handle->template_ptr];
+
+        *state_ptr = (*state_ptr & ~(SN_GRS_SESSION_STATE_MASK << shift)) | ((state & SN_GRS_SESSION_STATE_MASK) << shift);
+    } else if (res->resource_parameters_ptr) {
+        res->resource_parameters_ptr->registered = (res->resource_parameters_ptr->registered & ~(SN_GRS_SESSION_STATE_MASK << shift)) |
+                                                   ((state & SN_GRS_SESSION_STATE_MASK) << shift);
+    }
+}
+
+int8_t sn_grs_alloc_session_slot(struct grs_s *handle)
+{
+    uint8_t slot;
+
+    if (!handle) {
+        return -1;
+    }
+
+    /* Freed slots are cleared, so the new session starts with nothing registered */
+    for (slot = 0; slot < SN_GRS_MAX_SESSIONS; slot++) {
+        if (!(handle->session_slots & SN_GRS_SESSION_BIT(slot))) {
+            handle->session_slots |= SN_GRS_SESSION_BIT(slot);
+            handle->session_count++;
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void sn_grs_free_session_slot(struct grs_s *handle, uint8_t session_slot)
+{
+    const sn_nsdl_resource_info_s *resource_ptr;
+
+    if (!handle || session_slot >= SN_GRS_MAX_SESSIONS || !(handle->session_slots & SN_GRS_SESSION_BIT(session_slot))) {
+        return;
+    }
+
+    resource_ptr = sn_grs_get_first_resource(handle);
+    while (resource_ptr) {
+        sn_grs_set_registration_state(handle, resource_ptr, session_slot, SN_NDSL_RESOURCE_NOT_REGISTERED);
+        resource_ptr = sn_grs_get_next_resource(handle, resource_ptr);
+    }
+    sn_grs_release_removed_resources(handle, SN_GRS_SESSION_BIT(session_slot), false);
+
+    handle->session_slots &= ~SN_GRS_SESSION_BIT(session_slot);
+    handle->session_count--;
+}
+
+static bool sn_grs_is_template_resource(const struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+{
+    return handle->template_ptr && resource_ptr >= handle->template_ptr &&
+           resource_ptr < handle->template_ptr + handle->template_count;
+}
+
+/**
+ * \fn static const sn_nsdl_resource_info_s *sn_grs_next_template_resource(const struct grs_s *handle, uint16_t index)
+ *
+ * \brief Returns first template resource from index onwards which is not hidden from this store
+ *
+ * \param *handle   Pointer to grs handle
+ * \param index     Template index to start from
+ *
+ * \return Pointer to the template resource, NULL if none
+ */
+static const sn_nsdl_resource_info_s *sn_grs_next_template_resource(const struct grs_s *handle, uint16_t index)
+{
+    for (; index < handle->template_count; index++) {
+        if (!(handle->template_state_ptr[index] & SN_GRS_TEMPLATE_HIDDEN)) {
+            return &handle->template_ptr[index];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \fn sn_nsdl_resource_info_s *sn_grs_make_writable(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+ *
+ * \brief Gives a writable pointer to a resource found by sn_grs_search_resource() or the iteration
+ *        functions. Template resource is copied to the store first, own resource is returned as it is.
+ *
+ * \param *handle         Pointer to grs handle
+ * \param *resource_ptr   Resource to be changed
+ *
+ * \return Pointer to the writable resource, NULL if resource_ptr is NULL, not in the store or out of memory
+ */
+sn_nsdl_resource_info_s *sn_grs_make_writable(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+{
+    if (!handle || !resource_ptr) {
+        return NULL;
+    }
+    if (sn_grs_is_template_resource(handle, resource_ptr)) {
+        return sn_grs_copy_template_resource(handle, resource_ptr);
+    }
+
+    /* Own resource, the list holds it without qualifier */
+    ns_list_foreach(sn_nsdl_resource_info_s, resource_temp, &handle->resource_root_list) {
+        if (resource_temp == resource_ptr) {
+            return resource_temp;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \fn static sn_nsdl_resource_info_s *sn_grs_copy_template_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+ *
+ * \brief Copies a template resource to the store before its value is changed. The copy owns only
+ *        its value and parameters structure, strings are shared with the template. Template is
+ *        hidden from the store, so searches find the copy from then on.
+ *
+ * \param *handle         Pointer to grs handle
+ * \param *resource_ptr   Template resource to be changed
+ *
+ * \return Pointer to the copy, NULL if out of memory
+ */
+static sn_nsdl_resource_info_s *sn_grs_copy_template_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+{
+    sn_nsdl_resource_info_s *copy_ptr;
+    uint16_t *state_ptr = &handle->template_state_ptr[resource_ptr - handle->template_ptr];
+
+    copy_ptr = handle->sn_grs_alloc(sizeof(sn_nsdl_resource_info_s));
+    if (!copy_ptr) {
+        return NULL;
+    }
+    *copy_ptr = *resource_ptr;
+    copy_ptr->is_put = false;
+    copy_ptr->from_template = true;
+    copy_ptr->resource = NULL;
+    copy_ptr->resource_parameters_ptr = NULL;
+
+    if (resource_ptr->resource && resource_ptr->resourcelen) {
+        copy_ptr->resource = handle->sn_grs_alloc(resource_ptr->resourcelen);
+        if (!copy_ptr->resource) {
+            sn_grs_resource_info_free(handle, copy_ptr);
+            return NULL;
+        }
+        memcpy(copy_ptr->resource, resource_ptr->resource, resource_ptr->resourcelen);
+    } else {
+        copy_ptr->resourcelen = 0;
+    }
+
+    if (resource_ptr->resource_parameters_ptr) {
+        copy_ptr->resource_parameters_ptr = handle->sn_grs_alloc(sizeof(sn_nsdl_resource_parameters_s));
+        if (!copy_ptr->resource_parameters_ptr) {
+            sn_grs_resource_info_free(handle, copy_ptr);
+            return NULL;
+        }
+        *copy_ptr->resource_parameters_ptr = *resource_ptr->resource_parameters_ptr;
+        copy_ptr->resource_parameters_ptr->registered = (uint8_t)(*state_ptr & SN_GRS_TEMPLATE_REGISTRATION_MASK);
+    }
+
+    ns_list_add_to_start(&handle->resource_root_list, copy_ptr);
+    ++handle->resource_root_count;
+    *state_ptr = SN_GRS_TEMPLATE_HIDDEN;
+
+    return copy_ptr;
+}
+
+static bool sn_grs_method_allowed(uint8_t access, uint8_t msg_code)
+{
+    switch (msg_code) {
+        case COAP_MSG_CODE_REQUEST_GET:
+            return access & SN_GRS_GET_ALLOWED;
+        case COAP_MSG_CODE_REQUEST_POST:
+            return access & SN_GRS_POST_ALLOWED;
+        case COAP_MSG_CODE_REQUEST_PUT:
+            return access & SN_GRS_PUT_ALLOWED;
+        case COAP_MSG_CODE_REQUEST_DELETE:
+            return access & SN_GRS_DELETE_ALLOWED;
+        default:
+            return true;
+    }
+}
+
+/* Gives request to the application callback, which takes care of the response */
+static int8_t sn_grs_call_dynamic(struct nsdl_s *nsdl_handle, uint8_t (*callback)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e),
+                                  sn_coap_hdr_s *coap_packet_ptr, sn_nsdl_addr_s *src_addr_ptr)
+{
+    struct grs_s *handle = nsdl_handle->grs;
+
+    /* Do not call null pointer.. */
+    if (callback != NULL) {
+        callback(nsdl_handle, coap_packet_ptr, src_addr_ptr, SN_NSDL_PROTOCOL_COAP);
+    }
+
+    if (coap_packet_ptr->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED && coap_packet_ptr->payload_ptr) {
+        handle->sn_grs_free(coap_packet_ptr->payload_ptr);
+        coap_packet_ptr->payload_ptr = 0;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(handle->coap, coap_packet_ptr);
+    return SN_NSDL_SUCCESS;
+}
@@ -45,8 +45,11 @@
 #define OBS_PARAMETER_LEN               3
 #define AOBS_PARAMETER_LEN              8
 #define COAP_CON_PARAMETER_LEN          3
+#define RM_PARAMETER_LEN                2
 #define BS_EP_PARAMETER_LEN             3
 #define BS_QUEUE_MODE_PARAMATER_LEN     2
+#define SN_NSDL_URI_QUERY_MAX_FIELDS    5   /* ep, et, lt, d and b */
+#define SN_NSDL_BINDING_MAX_LEN         3   /* "UQS" at most */
 
 #define SN_NSDL_EP_REGISTER_MESSAGE     1
 #define SN_NSDL_EP_UPDATE_MESSAGE       2
@@ -57,6 +60,11 @@
 #define SN_NSDL_MSG_UPDATE              3
 #define SN_NSDL_MSG_BOOTSTRAP           4
 
+/* Which resources are listed in registration payload */
+#define SN_NSDL_BODY_ALL_RESOURCES      0
+#define SN_NSDL_BODY_UNREGISTERED       1
+#define SN_NSDL_BODY_REGISTERING        2
+
 #ifdef YOTTA_CFG_DISABLE_OBS_FEATURE
 #define COAP_DISABLE_OBS_FEATURE YOTTA_CFG_DISABLE_OBS_FEATURE
 #elif defined MBED_CONF_MBED_CLIENT_COAP_DISABLE_OBS_FEATURE
@@ -69,6 +77,57 @@
 #define MBED_CLIENT_DISABLE_BOOTSTRAP_FEATURE MBED_CONF_MBED_CLIENT_DISABLE_BOOTSTRAP_FEATURE
 #endif
 
+#ifdef YOTTA_CFG_NSDL_UPDATE_JITTER_PERCENT
+#define SN_NSDL_UPDATE_JITTER_PERCENT YOTTA_CFG_NSDL_UPDATE_JITTER_PERCENT
+#elif defined MBED_CONF_MBED_CLIENT_SN_NSDL_UPDATE_JITTER_PERCENT
+#define SN_NSDL_UPDATE_JITTER_PERCENT MBED_CONF_MBED_CLIENT_SN_NSDL_UPDATE_JITTER_PERCENT
+#endif
+
+#ifndef SN_NSDL_UPDATE_JITTER_PERCENT
+#define SN_NSDL_UPDATE_JITTER_PERCENT   10      /* Maximum random advance of automatic update, percents of update interval */
+#endif
+
+#ifdef YOTTA_CFG_NSDL_DEFAULT_LIFETIME
+#define SN_NSDL_DEFAULT_LIFETIME YOTTA_CFG_NSDL_DEFAULT_LIFETIME
+#elif defined MBED_CONF_MBED_CLIENT_SN_NSDL_DEFAULT_LIFETIME
+#define SN_NSDL_DEFAULT_LIFETIME MBED_CONF_MBED_CLIENT_SN_NSDL_DEFAULT_LIFETIME
+#endif
+
+#ifndef SN_NSDL_DEFAULT_LIFETIME
+#define SN_NSDL_DEFAULT_LIFETIME        86400   /* Lifetime in seconds if endpoint does not give lt parameter */
+#endif
+
+#ifdef YOTTA_CFG_NSDL_MAX_QUEUED_NOTIFICATIONS
+#define SN_NSDL_MAX_QUEUED_NOTIFICATIONS YOTTA_CFG_NSDL_MAX_QUEUED_NOTIFICATIONS
+#elif defined MBED_CONF_MBED_CLIENT_SN_NSDL_MAX_QUEUED_NOTIFICATIONS
+#define SN_NSDL_MAX_QUEUED_NOTIFICATIONS MBED_CONF_MBED_CLIENT_SN_NSDL_MAX_QUEUED_NOTIFICATIONS
+#endif
+
+#ifndef SN_NSDL_MAX_QUEUED_NOTIFICATIONS
+#define SN_NSDL_MAX_QUEUED_NOTIFICATIONS 8      /* Notifications held back while sleeping in queue mode */
+#endif
+
+
+/* Writes only the part of registration payload that is between start and start + len */
+typedef struct sn_nsdl_body_window_ {
+    uint8_t     *dst_ptr;
+    uint32_t    start;
+    uint16_t    len;
+    uint32_t    position;
+} sn_nsdl_body_window_s;
+
+/* One name=value field of uri-query, see sn_nsdl_get_uri_query_fields() */
+typedef struct sn_nsdl_uri_query_field_ {
+    const uint8_t   *name_ptr;
+    const uint8_t   *value_ptr;
+    uint8_t         name_len;
+    uint8_t         value_len;
+} sn_nsdl_uri_query_field_s;
+
+/* Context of streamed registration payload, owned by CoAP library while transfer is ongoing */
+typedef struct sn_nsdl_body_stream_ {
+    struct nsdl_s *handle;
+} sn_nsdl_body_stream_s;
 
 /* Constants */
 static uint8_t      ep_name_parameter_string[]  = {'e', 'p', '='};      /* Endpoint name. A unique name for the registering node in a domain.  */
@@ -82,6 +141,7 @@ static uint8_t      if_description_parameter[]  = {'i', 'f', '='};      /* Inter
 static uint8_t      ep_lifetime_parameter[]     = {'l', 't', '='};      /* Lifetime. Number of seconds that this registration will be valid for. Must be updated within this time, or will be removed. */
 static uint8_t      ep_domain_parameter[]       = {'d', '='};           /* Domain name. If this parameter is missing, a default domain is assumed. */
 static uint8_t      coap_con_type_parameter[]   = {'c', 't', '='};      /* CoAP content type */
+static uint8_t      removed_parameter[]         = {'r', 'm'};           /* Link removed from endpoint, only in registration update */
 /* * OMA BS parameters * */
 static uint8_t bs_uri[]                         = {'b', 's'};
 static uint8_t bs_ep_name[]                     = {'e', 'p', '='};
@@ -92,9 +152,28 @@ static uint8_t bs_queue_mode[]                  = {'b', '='};
 static uint16_t         sn_nsdl_internal_coap_send(struct nsdl_s *handle, sn_coap_hdr_s *coap_header_ptr, sn_nsdl_addr_s *dst_addr_ptr, uint8_t message_description);
 static void             sn_nsdl_resolve_nsp_address(struct nsdl_s *handle);
 int8_t                  sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *message_ptr, uint8_t updating_registeration);
-static uint16_t         sn_nsdl_calculate_registration_body_size(struct nsdl_s *handle, uint8_t updating_registeration, int8_t *error);
-static uint8_t          sn_nsdl_calculate_uri_query_option_len(sn_nsdl_ep_parameters_s *endpoint_info_ptr, uint8_t msg_type);
-static int8_t           sn_nsdl_fill_uri_query_options(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr, sn_coap_hdr_s *source_msg_ptr, uint8_t msg_type);
+static uint32_t         sn_nsdl_calculate_registration_body_size(struct nsdl_s *handle, uint8_t updating_registeration);
+static bool             sn_nsdl_include_in_registration_body(const struct nsdl_s *handle, const sn_nsdl_resource_info_s *resource_ptr, uint8_t updating_registeration);
+static uint32_t         sn_nsdl_calculate_link_len(const sn_nsdl_resource_info_s *resource_ptr);
+static uint8_t          *sn_nsdl_body_put_link(uint8_t *dst_ptr, const sn_nsdl_resource_info_s *resource_ptr);
+static uint32_t         sn_nsdl_calculate_removed_links_len(struct nsdl_s *handle, uint8_t updating_registeration);
+static uint8_t          *sn_nsdl_body_put_removed_links(struct nsdl_s *handle, uint8_t *dst_ptr, uint8_t updating_registeration);
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+static void             sn_nsdl_body_write(sn_nsdl_body_window_s *window, const uint8_t *src_ptr, uint16_t len);
+static void             sn_nsdl_body_write_char(sn_nsdl_body_window_s *window, uint8_t chr);
+static void             sn_nsdl_body_write_link(sn_nsdl_body_window_s *window, const sn_nsdl_resource_info_s *resource_ptr, uint32_t link_len);
+static void             sn_nsdl_body_write_removed_links(struct nsdl_s *handle, sn_nsdl_body_window_s *window, uint8_t updating_registeration);
+static uint16_t         sn_nsdl_registration_body_source(void *context, uint32_t offset, uint8_t *dst_ptr, uint16_t len);
+#endif
+static uint16_t         sn_nsdl_internal_coap_send_streamed(struct nsdl_s *handle, sn_coap_hdr_s *coap_header_ptr, sn_nsdl_addr_s *dst_addr_ptr, uint8_t message_description, uint8_t body_filter);
+static void             sn_nsdl_store_sent_msg_info(struct nsdl_s *handle, uint16_t msg_id, uint32_t msg_len, uint8_t message_description);
+static uint8_t          sn_nsdl_get_uri_query_fields(const sn_nsdl_ep_parameters_s *parameter_ptr, uint8_t msg_type, sn_nsdl_uri_query_field_s *field_ptr, uint8_t *binding_ptr);
+static void             sn_nsdl_set_uri_query_field(sn_nsdl_uri_query_field_s *field_ptr, const uint8_t *name_ptr, uint8_t name_len, const uint8_t *value_ptr, uint8_t value_len);
+static uint8_t          sn_nsdl_calculate_uri_query_option_len(const sn_nsdl_uri_query_field_s *field_ptr, uint8_t field_count);
+static int8_t           sn_nsdl_build_uri_query(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr, uint8_t msg_type, uint8_t **query_pptr, uint16_t *query_len_ptr);
+static int8_t           sn_nsdl_update_uri_query(struct nsdl_s *handle, uint8_t *lifetime_ptr, uint8_t lifetime_len);
+static bool             sn_nsdl_register_uri_query_matches(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr);
+static int8_t           sn_nsdl_store_ep_string(struct nsdl_s *handle, uint8_t **dst_pptr, uint8_t *dst_len_ptr, const uint8_t *src_ptr, uint8_t src_len);
 static int8_t           sn_nsdl_local_rx_function(struct nsdl_s *handle, sn_coap_hdr_s *coap_packet_ptr, sn_nsdl_addr_s *address_ptr);
 static int8_t           sn_nsdl_resolve_ep_information(struct nsdl_s *handle, sn_coap_hdr_s *coap_packet_ptr);
 static uint8_t          sn_nsdl_itoa_len(uint8_t value);
@@ -107,8 +186,27 @@ static void             sn_nsdl_check_oma_bs_status(struct nsdl_s *handle);
 static int8_t           sn_nsdl_create_oma_device_object_base(struct nsdl_s *handle, sn_nsdl_oma_device_t *oma_device_setup_ptr, sn_nsdl_oma_binding_and_mode_t binding_and_mode);
 static int8_t           set_endpoint_info(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *endpoint_info_ptr);
 static bool             validateParameters(sn_nsdl_ep_parameters_s *parameter_ptr);
+static uint32_t         sn_nsdl_resolve_lifetime(uint8_t *lifetime_ptr, uint8_t lifetime_len);
+static void             sn_nsdl_schedule_registration_update(struct nsdl_s *handle, uint32_t current_time, bool retry);
 static bool             validate(uint8_t* ptr, uint32_t len, char illegalChar);
-static bool             sn_nsdl_check_uint_overflow(uint16_t resource_size, uint16_t param_a, uint16_t param_b);
+static uint16_t         sn_nsdl_build_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
+                                                   uint8_t *payload_ptr, sn_coap_len_t payload_len, int32_t observe,
+                                                   sn_coap_msg_type_e message_type, uint8_t content_format,
+                                                   uint8_t *uri_path_ptr, uint16_t uri_path_len, uint16_t msg_id);
+static sn_coap_hdr_s    *sn_nsdl_alloc_notification(struct nsdl_s *handle, uint8_t *payload_ptr, sn_coap_len_t payload_len,
+                                                   int32_t observe, sn_coap_msg_type_e message_type, uint8_t content_format,
+                                                   uint8_t *uri_path_ptr, uint16_t uri_path_len);
+static void             sn_nsdl_release_notification(struct nsdl_s *handle, sn_coap_hdr_s *notification_message_ptr);
+static int8_t           sn_nsdl_build_notification_packet(struct nsdl_s *handle, sn_coap_hdr_s *notification_message_ptr,
+                                                          uint8_t **packet_pptr, uint16_t *packet_len_ptr);
+static uint16_t         sn_nsdl_queue_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
+                                                   uint8_t *payload_ptr, sn_coap_len_t payload_len, int32_t observe,
+                                                   sn_coap_msg_type_e message_type, uint8_t content_format,
+                                                   uint8_t *uri_path_ptr, uint16_t uri_path_len);
+static int8_t           sn_nsdl_flush_queued_notifications(struct nsdl_s *handle);
+static void             sn_nsdl_release_queued_notification(struct nsdl_s *handle, sn_nsdl_queued_notification_s *queued_ptr);
+static void             sn_nsdl_release_queued_notifications(struct nsdl_s *handle);
+static uint8_t          *sn_nsdl_copy_buffer(struct nsdl_s *handle, const uint8_t *src_ptr, sn_coap_len_t len);
 
 int8_t sn_nsdl_destroy(struct nsdl_s *handle)
 {
@@ -164,9 +262,27 @@ int8_t sn_nsdl_destroy(struct nsdl_s *handle)
         handle->sn_nsdl_free(handle->oma_bs_address_ptr);
     }
 
-    /* Destroy also libCoap and grs part of libNsdl */
-    sn_coap_protocol_destroy(handle->grs->coap);
-    sn_grs_destroy(handle->grs);
+    if (handle->register_uri_query_ptr) {
+        handle->sn_nsdl_free(handle->register_uri_query_ptr);
+        handle->register_uri_query_ptr = 0;
+    }
+
+    if (handle->update_uri_query_ptr) {
+        handle->sn_nsdl_free(handle->update_uri_query_ptr);
+        handle->update_uri_query_ptr = 0;
+    }
+
+    sn_nsdl_release_queued_notifications(handle);
+
+    if (handle->grs->session_count > 1) {
+        /* Resources are still used by other sessions, only messages and registration state of this one are dropped */
+        sn_coap_protocol_clear_sent_messages_by_param(handle->grs->coap, handle);
+        sn_grs_free_session_slot(handle->grs, handle->session_slot);
+    } else {
+        /* Destroy also libCoap and grs part of libNsdl */
+        sn_coap_protocol_destroy(handle->grs->coap);
+        sn_grs_destroy(handle->grs);
+    }
     handle->sn_nsdl_free(handle);
 
     return SN_NSDL_SUCCESS;
@@ -174,7 +290,7 @@ int8_t sn_nsdl_destroy(struct nsdl_s *handle)
 
 struct nsdl_s *sn_nsdl_init(uint8_t (*sn_nsdl_tx_cb)(struct nsdl_s *, sn_nsdl_capab_e , uint8_t *, uint16_t, sn_nsdl_addr_s *),
                             uint8_t (*sn_nsdl_rx_cb)(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *),
-                            void *(*sn_nsdl_alloc)(uint16_t), void (*sn_nsdl_free)(void *))
+                            void *(*sn_nsdl_alloc)(sn_coap_len_t), void (*sn_nsdl_free)(void *))
 {
     /* Check pointers and define function pointers */
     if (!sn_nsdl_alloc || !sn_nsdl_free || !sn_nsdl_tx_cb || !sn_nsdl_rx_cb) {
@@ -221,11 +337,64 @@ struct nsdl_s *sn_nsdl_init(uint8_t (*sn_nsdl_tx_cb)(struct nsdl_s *, sn_nsdl_ca
     sn_nsdl_resolve_nsp_address(handle);
 
     handle->sn_nsdl_endpoint_registered = SN_NSDL_ENDPOINT_NOT_REGISTERED;
+    handle->lifetime = SN_NSDL_DEFAULT_LIFETIME;
+    ns_list_init(&handle->queued_notification_list);
     // By default bootstrap msgs are handled in nsdl
     handle->handle_bootstrap_msg = true;
     return handle;
 }
 
+struct nsdl_s *sn_nsdl_init_session(struct nsdl_s *handle)
+{
+    struct nsdl_s *session = NULL;
+    int8_t session_slot;
+
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    session = handle->sn_nsdl_alloc(sizeof(struct nsdl_s));
+    if (session == NULL) {
+        return NULL;
+    }
+
+    memset(session, 0, sizeof(struct nsdl_s));
+
+    session->sn_nsdl_alloc = handle->sn_nsdl_alloc;
+    session->sn_nsdl_free = handle->sn_nsdl_free;
+    session->sn_nsdl_tx_callback = handle->sn_nsdl_tx_callback;
+    session->sn_nsdl_rx_callback = handle->sn_nsdl_rx_callback;
+
+    session->ep_information_ptr = session->sn_nsdl_alloc(sizeof(sn_nsdl_ep_parameters_s));
+    if (!session->ep_information_ptr) {
+        session->sn_nsdl_free(session);
+        return NULL;
+    }
+    memset(session->ep_information_ptr, 0, sizeof(sn_nsdl_ep_parameters_s));
+
+    /* Registration state is kept per session in shared resources, slots are limited */
+    session_slot = sn_grs_alloc_session_slot(handle->grs);
+    if (session_slot < 0) {
+        session->sn_nsdl_free(session->ep_information_ptr);
+        session->sn_nsdl_free(session);
+        return NULL;
+    }
+    session->session_slot = (uint8_t)session_slot;
+
+    /* Resources and CoAP state are shared with all other sessions */
+    session->grs = handle->grs;
+    session->registration_streaming = handle->registration_streaming;
+
+    sn_nsdl_resolve_nsp_address(session);
+
+    session->sn_nsdl_endpoint_registered = SN_NSDL_ENDPOINT_NOT_REGISTERED;
+    session->lifetime = SN_NSDL_DEFAULT_LIFETIME;
+    ns_list_init(&session->queued_notification_list);
+    session->handle_bootstrap_msg = true;
+
+    return session;
+}
+
 uint16_t sn_nsdl_register_endpoint(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *endpoint_info_ptr)
 {
     /* Local variables */
@@ -258,15 +427,18 @@ uint16_t sn_nsdl_register_endpoint(struct nsdl_s *handle, sn_nsdl_ep_parameters_
     register_message_ptr->uri_path_len = sizeof(resource_path_ptr);
     register_message_ptr->uri_path_ptr = resource_path_ptr;
 
-    /* Fill Uri-query options */
-    if( SN_NSDL_FAILURE == sn_nsdl_fill_uri_query_options(handle, endpoint_info_ptr,
-                                                          register_message_ptr, SN_NSDL_EP_REGISTER_MESSAGE) ){
+    /* Uri-query options are encoded when endpoint info is saved to handle */
+    if (!validateParameters(endpoint_info_ptr)) {
         register_message_ptr->uri_path_ptr = NULL;
         sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, register_message_ptr);
         return 0;
     }
 
-    if (endpoint_info_ptr->ds_register_mode == REGISTER_WITH_RESOURCES) {
+    /* Full registration replaces all links in server, pending removals are not needed anymore */
+    sn_grs_release_removed_resources(handle->grs, SN_GRS_SESSION_BIT(handle->session_slot), false);
+
+    /* Streamed body is generated while sending */
+    if (endpoint_info_ptr->ds_register_mode == REGISTER_WITH_RESOURCES && !handle->registration_streaming) {
         /* Built body for message */
         if (sn_nsdl_build_registration_body(handle, register_message_ptr, 0) == SN_NSDL_FAILURE) {
             register_message_ptr->uri_path_ptr = NULL;
@@ -291,8 +463,16 @@ uint16_t sn_nsdl_register_endpoint(struct nsdl_s *handle, sn_nsdl_ep_parameters_
         return 0;
     }
 
+    register_message_ptr->options_list_ptr->uri_query_ptr = handle->register_uri_query_ptr;
+    register_message_ptr->options_list_ptr->uri_query_len = handle->register_uri_query_len;
+
     /* Build and send coap message to NSP */
-    message_id = sn_nsdl_internal_coap_send(handle, register_message_ptr, handle->nsp_address_ptr->omalw_address_ptr, SN_NSDL_MSG_REGISTER);
+    if (endpoint_info_ptr->ds_register_mode == REGISTER_WITH_RESOURCES && handle->registration_streaming) {
+        message_id = sn_nsdl_internal_coap_send_streamed(handle, register_message_ptr, handle->nsp_address_ptr->omalw_address_ptr,
+                                                         SN_NSDL_MSG_REGISTER, SN_NSDL_BODY_ALL_RESOURCES);
+    } else {
+        message_id = sn_nsdl_internal_coap_send(handle, register_message_ptr, handle->nsp_address_ptr->omalw_address_ptr, SN_NSDL_MSG_REGISTER);
+    }
 
     if (register_message_ptr->payload_ptr) {
         handle->sn_nsdl_free(register_message_ptr->payload_ptr);
@@ -301,6 +481,7 @@ uint16_t sn_nsdl_register_endpoint(struct nsdl_s *handle, sn_nsdl_ep_parameters_
 
     register_message_ptr->uri_path_ptr = NULL;
     register_message_ptr->options_list_ptr->uri_host_ptr = NULL;
+    register_message_ptr->options_list_ptr->uri_query_ptr = NULL;
 
     sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, register_message_ptr);
 
@@ -322,6 +503,12 @@ uint16_t sn_nsdl_unregister_endpoint(struct nsdl_s *handle)
     /* Check that EP have been registered */
     if (sn_nsdl_is_ep_registered(handle)) {
 
+        /* No automatic updates for a registration which is being removed */
+        handle->update_scheduled = false;
+
+        /* Observations end with registration */
+        sn_nsdl_release_queued_notifications(handle);
+
         /* Memory allocation for unregister message */
         unregister_message_ptr = sn_coap_parser_alloc_message(handle->grs->coap);
         if (!unregister_message_ptr) {
@@ -382,7 +569,6 @@ uint16_t sn_nsdl_update_registration(struct nsdl_s *handle, uint8_t *lt_ptr, uin
     /* Local variables */
     sn_coap_hdr_s   *register_message_ptr;
     uint8_t         *temp_ptr;
-    sn_nsdl_ep_parameters_s temp_parameters;
     uint16_t        message_id = 0;
 
     /* Check parameters */
@@ -394,10 +580,10 @@ uint16_t sn_nsdl_update_registration(struct nsdl_s *handle, uint8_t *lt_ptr, uin
         return 0;
     }
 
-    memset(&temp_parameters, 0, sizeof(sn_nsdl_ep_parameters_s));
-
-    temp_parameters.lifetime_len = lt_len;
-    temp_parameters.lifetime_ptr = lt_ptr;
+    /* New lifetime is used for automatic updates after this */
+    if (lt_ptr && lt_len) {
+        handle->lifetime = sn_nsdl_resolve_lifetime(lt_ptr, lt_len);
+    }
 
     /*** Build endpoint register update message ***/
 
@@ -455,24 +641,42 @@ uint16_t sn_nsdl_update_registration(struct nsdl_s *handle, uint8_t *lt_ptr, uin
         return 0;
     }
 
-    /* Fill Uri-query options */
-    sn_nsdl_fill_uri_query_options(handle, &temp_parameters, register_message_ptr, SN_NSDL_EP_UPDATE_MESSAGE);
+    /* Fill Uri-query options, encoded query is owned by handle and re-encoded only if lifetime changes */
+    if (sn_nsdl_update_uri_query(handle, lt_ptr, lt_len) == SN_NSDL_SUCCESS) {
+        register_message_ptr->options_list_ptr->uri_query_ptr = handle->update_uri_query_ptr;
+        register_message_ptr->options_list_ptr->uri_query_len = handle->update_uri_query_len;
+    }
 
     /* Build payload */
     if (handle->ep_information_ptr->ds_register_mode == REGISTER_WITH_RESOURCES) {
+        sn_grs_mark_removed_resources_as_sending(handle->grs, handle->session_slot);
+    }
+    if (handle->ep_information_ptr->ds_register_mode == REGISTER_WITH_RESOURCES && !handle->registration_streaming) {
 
-        if (sn_nsdl_build_registration_body(handle, register_message_ptr, 1) == SN_NSDL_FAILURE) {
+        if (sn_nsdl_build_registration_body(handle, register_message_ptr, SN_NSDL_BODY_UNREGISTERED) == SN_NSDL_FAILURE) {
+            register_message_ptr->options_list_ptr->uri_query_ptr = NULL;
             sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, register_message_ptr);
             return 0;
         }
     }
 
     /* Build and send coap message to NSP */
-    message_id = sn_nsdl_internal_coap_send(handle, register_message_ptr, handle->nsp_address_ptr->omalw_address_ptr, SN_NSDL_MSG_UPDATE);
+    if (handle->ep_information_ptr->ds_register_mode == REGISTER_WITH_RESOURCES && handle->registration_streaming) {
+        message_id = sn_nsdl_internal_coap_send_streamed(handle, register_message_ptr, handle->nsp_address_ptr->omalw_address_ptr,
+                                                         SN_NSDL_MSG_UPDATE, SN_NSDL_BODY_UNREGISTERED);
+    } else {
+        message_id = sn_nsdl_internal_coap_send(handle, register_message_ptr, handle->nsp_address_ptr->omalw_address_ptr, SN_NSDL_MSG_UPDATE);
+    }
+
+    if (message_id) {
+        /* Radio is on anyway, held back notifications follow the update in the same burst */
+        sn_nsdl_flush_queued_notifications(handle);
+    }
 
     if (register_message_ptr->payload_ptr) {
         handle->sn_nsdl_free(register_message_ptr->payload_ptr);
     }
+    register_message_ptr->options_list_ptr->uri_query_ptr = NULL;
     sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, register_message_ptr);
 
     return message_id;
@@ -500,6 +704,7 @@ void sn_nsdl_nsp_lost(struct nsdl_s *handle)
     }
 
     handle->sn_nsdl_endpoint_registered = SN_NSDL_ENDPOINT_NOT_REGISTERED;
+    sn_nsdl_release_queued_notifications(handle);
 }
 
 int8_t sn_nsdl_is_ep_registered(struct nsdl_s *handle)
@@ -513,7 +718,7 @@ int8_t sn_nsdl_is_ep_registered(struct nsdl_s *handle)
 }
 
 uint16_t sn_nsdl_send_observation_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
-        uint8_t *payload_ptr, uint16_t payload_len,
+        uint8_t *payload_ptr, sn_coap_len_t payload_len,
         sn_coap_observe_e observe,
         sn_coap_msg_type_e message_type, sn_coap_content_format_e content_format)
 {
@@ -530,38 +735,180 @@ uint16_t sn_nsdl_send_observation_notification(struct nsdl_s *handle, uint8_t *t
 }
 
 uint16_t sn_nsdl_send_observation_notification_with_uri_path(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
-        uint8_t *payload_ptr, uint16_t payload_len,
+        uint8_t *payload_ptr, sn_coap_len_t payload_len,
         sn_coap_observe_e observe,
         sn_coap_msg_type_e message_type, uint8_t content_format,
         uint8_t *uri_path_ptr, uint16_t uri_path_len)
+{
+    /* Check parameters */
+    if (handle == NULL || handle->grs == NULL) {
+        return 0;
+    }
+
+    if (handle->sleeping) {
+        return sn_nsdl_queue_notification(handle, token_ptr, token_len, payload_ptr, payload_len, observe,
+                                          message_type, content_format, uri_path_ptr, uri_path_len);
+    }
+
+    return sn_nsdl_build_notification(handle, token_ptr, token_len, payload_ptr, payload_len, observe,
+                                      message_type, content_format, uri_path_ptr, uri_path_len, 0);
+}
+
+/**
+ * \fn static uint16_t sn_nsdl_build_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
+ *                                                uint8_t *payload_ptr, sn_coap_len_t payload_len, int32_t observe,
+ *                                                sn_coap_msg_type_e message_type, uint8_t content_format,
+ *                                                uint8_t *uri_path_ptr, uint16_t uri_path_len, uint16_t msg_id)
+ *
+ * \brief Builds and sends observation notification
+ *
+ * \param   msg_id  Message ID reserved earlier, 0 to use next free one. Other parameters as in sn_nsdl_send_observation_notification_with_uri_path()
+ *
+ * \return  message id, 0 if failed
+ */
+static uint16_t sn_nsdl_build_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
+                                           uint8_t *payload_ptr, sn_coap_len_t payload_len, int32_t observe,
+                                           sn_coap_msg_type_e message_type, uint8_t content_format,
+                                           uint8_t *uri_path_ptr, uint16_t uri_path_len, uint16_t msg_id)
 {
     sn_coap_hdr_s   *notification_message_ptr;
     uint16_t        return_msg_id = 0;
 
+    notification_message_ptr = sn_nsdl_alloc_notification(handle, payload_ptr, payload_len, observe, message_type,
+                                                          content_format, uri_path_ptr, uri_path_len);
+    if (notification_message_ptr == NULL) {
+        return 0;
+    }
+
+    notification_message_ptr->msg_id = msg_id;
+
+    /* Fill token */
+    notification_message_ptr->token_len = token_len;
+    notification_message_ptr->token_ptr = token_ptr;
+
+    /* Send message */
+    if (sn_nsdl_send_coap_message(handle, handle->nsp_address_ptr->omalw_address_ptr, notification_message_ptr) == SN_NSDL_FAILURE) {
+        return_msg_id = 0;
+    } else {
+        return_msg_id = notification_message_ptr->msg_id;
+    }
+
+    sn_nsdl_release_notification(handle, notification_message_ptr);
+
+    return return_msg_id;
+}
+
+uint8_t sn_nsdl_send_observation_notification_to_observers(sn_nsdl_observer_s *observers_ptr, uint8_t observer_count,
+        uint8_t *payload_ptr, sn_coap_len_t payload_len,
+        sn_coap_observe_e observe,
+        sn_coap_msg_type_e message_type, uint8_t content_format,
+        uint8_t *uri_path_ptr, uint16_t uri_path_len)
+{
+    struct nsdl_s   *handle;
+    sn_coap_hdr_s   *notification_message_ptr;
+    uint8_t         *packet_ptr = NULL;
+    uint16_t        packet_len = 0;
+    uint8_t         sent_count = 0;
+    uint8_t         i;
+
     /* Check parameters */
-    if (handle == NULL || handle->grs == NULL) {
+    if (observers_ptr == NULL || observer_count == 0 || observers_ptr[0].handle == NULL || observers_ptr[0].handle->grs == NULL) {
+        return 0;
+    }
+    handle = observers_ptr[0].handle;
+
+    /* Encoded message is reused only within one CoAP instance */
+    for (i = 0; i < observer_count; i++) {
+        observers_ptr[i].msg_id = 0;
+        if (observers_ptr[i].handle == NULL || observers_ptr[i].handle->grs != handle->grs) {
+            return 0;
+        }
+    }
+
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
+    /* Remaining blocks are stored per message, so blockwised notification is built for each observer */
+    if ((payload_len > handle->grs->coap->sn_coap_block_data_size) && (handle->grs->coap->sn_coap_block_data_size > 0)) {
+        for (i = 0; i < observer_count; i++) {
+            observers_ptr[i].msg_id = sn_nsdl_send_observation_notification_with_uri_path(observers_ptr[i].handle,
+                                      observers_ptr[i].token_ptr, observers_ptr[i].token_len, payload_ptr, payload_len,
+                                      observe, message_type, content_format, uri_path_ptr, uri_path_len);
+            if (observers_ptr[i].msg_id) {
+                sent_count++;
+            }
+        }
+        return sent_count;
+    }
+#endif
+
+    notification_message_ptr = sn_nsdl_alloc_notification(handle, payload_ptr, payload_len, observe, message_type,
+                                                          content_format, uri_path_ptr, uri_path_len);
+    if (notification_message_ptr == NULL) {
         return 0;
     }
 
+    for (i = 0; i < observer_count; i++) {
+        sn_nsdl_observer_s *observer_ptr = &observers_ptr[i];
+        struct nsdl_s *session_ptr = observer_ptr->handle;
+
+        if (session_ptr->sleeping) {
+            observer_ptr->msg_id = sn_nsdl_queue_notification(session_ptr, observer_ptr->token_ptr, observer_ptr->token_len,
+                                                              payload_ptr, payload_len, observe, message_type,
+                                                              content_format, uri_path_ptr, uri_path_len);
+        } else {
+            notification_message_ptr->msg_id = 0;
+            notification_message_ptr->token_len = observer_ptr->token_len;
+            notification_message_ptr->token_ptr = observer_ptr->token_ptr;
+
+            if (sn_nsdl_build_notification_packet(session_ptr, notification_message_ptr, &packet_ptr, &packet_len) == SN_NSDL_SUCCESS &&
+                    session_ptr->sn_nsdl_tx_callback(session_ptr, SN_NSDL_PROTOCOL_COAP, packet_ptr, packet_len,
+                                                     session_ptr->nsp_address_ptr->omalw_address_ptr)) {
+                observer_ptr->msg_id = notification_message_ptr->msg_id;
+            }
+        }
+        if (observer_ptr->msg_id) {
+            sent_count++;
+        }
+    }
+
+    if (packet_ptr) {
+        handle->sn_nsdl_free(packet_ptr);
+    }
+    sn_nsdl_release_notification(handle, notification_message_ptr);
+
+    return sent_count;
+}
+
+/**
+ * \fn static sn_coap_hdr_s *sn_nsdl_alloc_notification(struct nsdl_s *handle, uint8_t *payload_ptr, sn_coap_len_t payload_len,
+ *                                                      int32_t observe, sn_coap_msg_type_e message_type, uint8_t content_format,
+ *                                                      uint8_t *uri_path_ptr, uint16_t uri_path_len)
+ *
+ * \brief Allocates observation notification header without token and message ID. Payload and uri path are
+ *        not copied, header is released with sn_nsdl_release_notification().
+ *
+ * \return  pointer to header, NULL if out of memory
+ */
+static sn_coap_hdr_s *sn_nsdl_alloc_notification(struct nsdl_s *handle, uint8_t *payload_ptr, sn_coap_len_t payload_len,
+                                                 int32_t observe, sn_coap_msg_type_e message_type, uint8_t content_format,
+                                                 uint8_t *uri_path_ptr, uint16_t uri_path_len)
+{
+    sn_coap_hdr_s   *notification_message_ptr;
+
     /* Allocate and initialize memory for header struct */
     notification_message_ptr = sn_coap_parser_alloc_message(handle->grs->coap);
     if (notification_message_ptr == NULL) {
-        return 0;
+        return NULL;
     }
 
     if (sn_coap_parser_alloc_options(handle->grs->coap, notification_message_ptr) == NULL) {
         handle->sn_nsdl_free(notification_message_ptr);
-        return 0;
+        return NULL;
     }
 
     /* Fill header */
     notification_message_ptr->msg_type = message_type;
     notification_message_ptr->msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
 
-    /* Fill token */
-    notification_message_ptr->token_len = token_len;
-    notification_message_ptr->token_ptr = token_ptr;
-
     /* Fill payload */
     notification_message_ptr->payload_len = payload_len;
     notification_message_ptr->payload_ptr = payload_ptr;
@@ -576,21 +923,240 @@ uint16_t sn_nsdl_send_observation_notification_with_uri_path(struct nsdl_s *hand
     /* Fill content format */
     notification_message_ptr->content_format = content_format;
 
-    /* Send message */
-    if (sn_nsdl_send_coap_message(handle, handle->nsp_address_ptr->omalw_address_ptr, notification_message_ptr) == SN_NSDL_FAILURE) {
-        return_msg_id = 0;
-    } else {
-        return_msg_id = notification_message_ptr->msg_id;
-    }
+    return notification_message_ptr;
+}
 
-    /* Free memory */
+/**
+ * \fn static void sn_nsdl_release_notification(struct nsdl_s *handle, sn_coap_hdr_s *notification_message_ptr)
+ *
+ * \brief Releases header allocated by sn_nsdl_alloc_notification(), buffers given by application are not freed
+ */
+static void sn_nsdl_release_notification(struct nsdl_s *handle, sn_coap_hdr_s *notification_message_ptr)
+{
     notification_message_ptr->uri_path_ptr = NULL;
     notification_message_ptr->payload_ptr = NULL;
     notification_message_ptr->token_ptr = NULL;
 
     sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, notification_message_ptr);
+}
 
-    return return_msg_id;
+/**
+ * \fn static int8_t sn_nsdl_build_notification_packet(struct nsdl_s *handle, sn_coap_hdr_s *notification_message_ptr,
+ *                                                     uint8_t **packet_pptr, uint16_t *packet_len_ptr)
+ *
+ * \brief Builds notification to the server of a session. Packet encoded for an earlier observer is reused
+ *        when token has the same length, otherwise message is encoded again.
+ *
+ * \param   *handle                     Pointer to nsdl-library handle of the session
+ * \param   *notification_message_ptr   Notification with token of the observer, message ID is filled in
+ * \param   **packet_pptr               Packet of earlier observer or NULL, replaced if encoded again. Freed by caller.
+ * \param   *packet_len_ptr             Length of the packet
+ *
+ * \return  SN_NSDL_SUCCESS = 0, Failed = -1
+ */
+static int8_t sn_nsdl_build_notification_packet(struct nsdl_s *handle, sn_coap_hdr_s *notification_message_ptr,
+                                                uint8_t **packet_pptr, uint16_t *packet_len_ptr)
+{
+    sn_nsdl_addr_s *address_ptr = handle->nsp_address_ptr->omalw_address_ptr;
+
+    if (*packet_pptr && sn_coap_protocol_build_copy(handle->grs->coap, address_ptr, *packet_pptr, *packet_len_ptr,
+                                                    notification_message_ptr, (void *)handle) >= 0) {
+        return SN_NSDL_SUCCESS;
+    }
+
+    if (*packet_pptr) {
+        handle->sn_nsdl_free(*packet_pptr);
+        *packet_pptr = NULL;
+    }
+
+    *packet_len_ptr = sn_coap_builder_calc_needed_packet_data_size_2(notification_message_ptr, handle->grs->coap->sn_coap_block_data_size);
+    if (*packet_len_ptr == 0) {
+        return SN_NSDL_FAILURE;
+    }
+
+    *packet_pptr = handle->sn_nsdl_alloc(*packet_len_ptr);
+    if (*packet_pptr == NULL) {
+        return SN_NSDL_FAILURE;
+    }
+
+    if (sn_coap_protocol_build(handle->grs->coap, address_ptr, *packet_pptr, notification_message_ptr, (void *)handle) < 0) {
+        handle->sn_nsdl_free(*packet_pptr);
+        *packet_pptr = NULL;
+        return SN_NSDL_FAILURE;
+    }
+
+    return SN_NSDL_SUCCESS;
+}
+
+/**
+ * \fn static uint16_t sn_nsdl_queue_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
+ *                                                uint8_t *payload_ptr, sn_coap_len_t payload_len, int32_t observe,
+ *                                                sn_coap_msg_type_e message_type, uint8_t content_format,
+ *                                                uint8_t *uri_path_ptr, uint16_t uri_path_len)
+ *
+ * \brief Holds observation notification back until endpoint wakes up. If coalescing is enabled, replaces
+ *        notification already queued for the same observation.
+ *
+ * \return  message id which is used when notification is sent, 0 if failed or queue is full
+ */
+static uint16_t sn_nsdl_queue_notification(struct nsdl_s *handle, uint8_t *token_ptr, uint8_t token_len,
+                                           uint8_t *payload_ptr, sn_coap_len_t payload_len, int32_t observe,
+                                           sn_coap_msg_type_e message_type, uint8_t content_format,
+                                           uint8_t *uri_path_ptr, uint16_t uri_path_len)
+{
+    sn_nsdl_queued_notification_s *queued_ptr = NULL;
+    uint8_t *new_payload_ptr = NULL;
+
+    if (handle->coalesce_notifications) {
+        ns_list_foreach(sn_nsdl_queued_notification_s, temp_ptr, &handle->queued_notification_list) {
+            if (temp_ptr->token_len == token_len && temp_ptr->uri_path_len == uri_path_len &&
+                    (!token_len || !memcmp(temp_ptr->token_ptr, token_ptr, token_len)) &&
+                    (!uri_path_len || !memcmp(temp_ptr->uri_path_ptr, uri_path_ptr, uri_path_len))) {
+                queued_ptr = temp_ptr;
+                break;
+            }
+        }
+    }
+
+    if (queued_ptr) {
+        /* Only the latest value of the observation is sent */
+        if (payload_len) {
+            new_payload_ptr = sn_nsdl_copy_buffer(handle, payload_ptr, payload_len);
+            if (!new_payload_ptr) {
+                return 0;
+            }
+        }
+        if (queued_ptr->payload_ptr) {
+            handle->sn_nsdl_free(queued_ptr->payload_ptr);
+        }
+        queued_ptr->payload_ptr = new_payload_ptr;
+        queued_ptr->payload_len = payload_len;
+        queued_ptr->observe = observe;
+        queued_ptr->message_type = message_type;
+        queued_ptr->content_format = content_format;
+        return queued_ptr->msg_id;
+    }
+
+    /* Queued notifications are not dropped, message IDs already returned to application must stay valid */
+    if (handle->queued_notification_count >= SN_NSDL_MAX_QUEUED_NOTIFICATIONS) {
+        return 0;
+    }
+
+    queued_ptr = handle->sn_nsdl_alloc(sizeof(sn_nsdl_queued_notification_s));
+    if (!queued_ptr) {
+        return 0;
+    }
+    memset(queued_ptr, 0, sizeof(sn_nsdl_queued_notification_s));
+
+    if (token_len) {
+        queued_ptr->token_ptr = sn_nsdl_copy_buffer(handle, token_ptr, token_len);
+        queued_ptr->token_len = token_len;
+    }
+    if (payload_len) {
+        queued_ptr->payload_ptr = sn_nsdl_copy_buffer(handle, payload_ptr, payload_len);
+        queued_ptr->payload_len = payload_len;
+    }
+    if (uri_path_len) {
+        queued_ptr->uri_path_ptr = sn_nsdl_copy_buffer(handle, uri_path_ptr, uri_path_len);
+        queued_ptr->uri_path_len = uri_path_len;
+    }
+    if ((token_len && !queued_ptr->token_ptr) || (payload_len && !queued_ptr->payload_ptr) ||
+            (uri_path_len && !queued_ptr->uri_path_ptr)) {
+        if (queued_ptr->token_ptr) {
+            handle->sn_nsdl_free(queued_ptr->token_ptr);
+        }
+        if (queued_ptr->payload_ptr) {
+            handle->sn_nsdl_free(queued_ptr->payload_ptr);
+        }
+        if (queued_ptr->uri_path_ptr) {
+            handle->sn_nsdl_free(queued_ptr->uri_path_ptr);
+        }
+        handle->sn_nsdl_free(queued_ptr);
+        return 0;
+    }
+
+    queued_ptr->observe = observe;
+    queued_ptr->message_type = message_type;
+    queued_ptr->content_format = content_format;
+    queued_ptr->msg_id = sn_coap_protocol_reserve_message_id(handle->grs->coap);
+
+    ns_list_add_to_end(&handle->queued_notification_list, queued_ptr);
+    handle->queued_notification_count++;
+
+    return queued_ptr->msg_id;
+}
+
+/**
+ * \fn static int8_t sn_nsdl_flush_queued_notifications(struct nsdl_s *handle)
+ *
+ * \brief Sends all held back notifications back to back, in the order they were queued
+ *
+ * \param   *handle Pointer to nsdl-library handle
+ *
+ * \return  SN_NSDL_SUCCESS = 0, Failed = -1. Notifications which could not be sent stay in queue.
+ */
+static int8_t sn_nsdl_flush_queued_notifications(struct nsdl_s *handle)
+{
+    ns_list_foreach_safe(sn_nsdl_queued_notification_s, queued_ptr, &handle->queued_notification_list) {
+        if (!sn_nsdl_build_notification(handle, queued_ptr->token_ptr, queued_ptr->token_len,
+                                        queued_ptr->payload_ptr, queued_ptr->payload_len, queued_ptr->observe,
+                                        queued_ptr->message_type, queued_ptr->content_format,
+                                        queued_ptr->uri_path_ptr, queued_ptr->uri_path_len, queued_ptr->msg_id)) {
+            return SN_NSDL_FAILURE;
+        }
+        sn_nsdl_release_queued_notification(handle, queued_ptr);
+    }
+
+    return SN_NSDL_SUCCESS;
+}
+
+/**
+ * \fn static void sn_nsdl_release_queued_notification(struct nsdl_s *handle, sn_nsdl_queued_notification_s *queued_ptr)
+ *
+ * \brief Removes notification from queue and releases it
+ */
+static void sn_nsdl_release_queued_notification(struct nsdl_s *handle, sn_nsdl_queued_notification_s *queued_ptr)
+{
+    ns_list_remove(&handle->queued_notification_list, queued_ptr);
+    handle->queued_notification_count--;
+    if (queued_ptr->token_ptr) {
+        handle->sn_nsdl_free(queued_ptr->token_ptr);
+    }
+    if (queued_ptr->payload_ptr) {
+        handle->sn_nsdl_free(queued_ptr->payload_ptr);
+    }
+    if (queued_ptr->uri_path_ptr) {
+        handle->sn_nsdl_free(queued_ptr->uri_path_ptr);
+    }
+    handle->sn_nsdl_free(queued_ptr);
+}
+
+/**
+ * \fn static void sn_nsdl_release_queued_notifications(struct nsdl_s *handle)
+ *
+ * \brief Drops all held back notifications without sending them
+ */
+static void sn_nsdl_release_queued_notifications(struct nsdl_s *handle)
+{
+    ns_list_foreach_safe(sn_nsdl_queued_notification_s, queued_ptr, &handle->queued_notification_list) {
+        sn_nsdl_release_queued_notification(handle, queued_ptr);
+    }
+}
+
+/**
+ * \fn static uint8_t *sn_nsdl_copy_buffer(struct nsdl_s *handle, const uint8_t *src_ptr, sn_coap_len_t len)
+ *
+ * \brief Allocates a copy of given buffer
+ *
+ * \return  pointer to copy, NULL if allocation failed
+ */
+static uint8_t *sn_nsdl_copy_buffer(struct nsdl_s *handle, const uint8_t *src_ptr, sn_coap_len_t len)
+{
+    uint8_t *dst_ptr = handle->sn_nsdl_alloc(len);
+    if (dst_ptr) {
+        memcpy(dst_ptr, src_ptr, len);
+    }
+    return dst_ptr;
 }
 
 
@@ -677,7 +1243,7 @@ uint16_t sn_nsdl_oma_bootstrap(struct nsdl_s *handle, sn_nsdl_addr_s *bootstrap_
 omalw_certificate_list_t *sn_nsdl_get_certificates(struct nsdl_s *handle)
 {
 #ifndef MBED_CLIENT_DISABLE_BOOTSTRAP_FEATURE
-    sn_nsdl_resource_info_s *resource_ptr = 0;;
+    const sn_nsdl_resource_info_s *resource_ptr = 0;
     omalw_certificate_list_t *certi_list_ptr = 0;
 
     /* Check parameters */
@@ -692,7 +1258,7 @@ omalw_certificate_list_t *sn_nsdl_get_certificates(struct nsdl_s *handle)
     }
 
     /* Get private key resource */
-    resource_ptr = sn_nsdl_get_resource(handle, 5, (void *)"0/0/5");
+    resource_ptr = sn_nsdl_find_resource(handle, 5, (void *)"0/0/5");
     if (!resource_ptr) {
         handle->sn_nsdl_free(certi_list_ptr);
         return NULL;
@@ -701,7 +1267,7 @@ omalw_certificate_list_t *sn_nsdl_get_certificates(struct nsdl_s *handle)
     certi_list_ptr->own_private_key_len = resource_ptr->resourcelen;
 
     /* Get client certificate resource */
-    resource_ptr = sn_nsdl_get_resource(handle, 5, (void *)"0/0/4");
+    resource_ptr = sn_nsdl_find_resource(handle, 5, (void *)"0/0/4");
     if (!resource_ptr) {
         handle->sn_nsdl_free(certi_list_ptr);
         return NULL;
@@ -710,7 +1276,7 @@ omalw_certificate_list_t *sn_nsdl_get_certificates(struct nsdl_s *handle)
     certi_list_ptr->certificate_len[0] = resource_ptr->resourcelen;
 
     /* Get root certificate resource */
-    resource_ptr = sn_nsdl_get_resource(handle, 5, (void *)"0/0/3");
+    resource_ptr = sn_nsdl_find_resource(handle, 5, (void *)"0/0/3");
     if (!resource_ptr) {
         handle->sn_nsdl_free(certi_list_ptr);
         return NULL;
@@ -773,6 +1339,7 @@ int8_t sn_nsdl_update_certificates(struct nsdl_s *handle, omalw_certificate_list
 int8_t sn_nsdl_create_oma_device_object(struct nsdl_s *handle, sn_nsdl_oma_device_t *device_object_ptr)
 {
 #ifndef MBED_CLIENT_DISABLE_BOOTSTRAP_FEATURE
+    const sn_nsdl_resource_info_s *found_ptr;
     sn_nsdl_resource_info_s *resource_temp = 0;
     uint8_t path[8] = "3/0/11/0";
 
@@ -783,12 +1350,18 @@ int8_t sn_nsdl_create_oma_device_object(struct nsdl_s *handle, sn_nsdl_oma_devic
     /* * Error code * */
 
     /* Get first error message */
-    resource_temp = sn_grs_search_resource(handle->grs, 8, path, SN_GRS_SEARCH_METHOD);
+    found_ptr = sn_grs_search_resource(handle->grs, 8, path, SN_GRS_SEARCH_METHOD);
 
-    while (resource_temp) {
-        if (resource_temp->resource) {
+    while (found_ptr) {
+        if (found_ptr->resource) {
             /* If no error code set */
-            if (*resource_temp->resource == 0) {
+            if (*found_ptr->resource == 0) {
+                /* Template resource is copied before it is changed */
+                resource_temp = sn_grs_make_writable(handle->grs, found_ptr);
+                if (!resource_temp || !resource_temp->resource) {
+                    return SN_NSDL_FAILURE;
+                }
+
                 /* Set error code */
                 *resource_temp->resource = (uint8_t)device_object_ptr->error_code;
                 resource_temp->resourcelen = 1;
@@ -804,7 +1377,7 @@ int8_t sn_nsdl_create_oma_device_object(struct nsdl_s *handle, sn_nsdl_oma_devic
         }
 
         path[7]++;
-        resource_temp = sn_grs_search_resource(handle->grs, 8, path, SN_GRS_SEARCH_METHOD);
+        found_ptr = sn_grs_search_resource(handle->grs, 8, path, SN_GRS_SEARCH_METHOD);
     }
 
     /* Create new resource for this error */
@@ -869,7 +1442,7 @@ int8_t sn_nsdl_process_coap(struct nsdl_s *handle, uint8_t *packet_ptr, uint16_t
 {
     sn_coap_hdr_s           *coap_packet_ptr    = NULL;
     sn_coap_hdr_s           *coap_response_ptr  = NULL;
-    sn_nsdl_resource_info_s *resource = NULL;
+    const sn_nsdl_resource_info_s *resource = NULL;
     /* Check parameters */
     if (handle == NULL) {
         return SN_NSDL_FAILURE;
@@ -885,7 +1458,7 @@ int8_t sn_nsdl_process_coap(struct nsdl_s *handle, uint8_t *packet_ptr, uint16_t
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
     // Pass block to application if external_memory_block is set
     if(coap_packet_ptr->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING) {
-        resource = sn_nsdl_get_resource(handle, coap_packet_ptr->uri_path_len, coap_packet_ptr->uri_path_ptr);
+        resource = sn_nsdl_find_resource(handle, coap_packet_ptr->uri_path_len, coap_packet_ptr->uri_path_ptr);
         if(resource && resource->external_memory_block) {
             sn_coap_protocol_block_remove(handle->grs->coap,
                                           src_ptr,
@@ -982,21 +1555,21 @@ int8_t sn_nsdl_process_coap(struct nsdl_s *handle, uint8_t *packet_ptr, uint16_t
 
         /* Non - TLV message */
         else if (coap_packet_ptr->content_format == 97) {
-            sn_grs_process_coap(handle, coap_packet_ptr, src_ptr);
-
             /* Todo: move this copying to sn_nsdl_check_oma_bs_status(), also from TLV parser */
-            /* Security mode */
-            if (*(coap_packet_ptr->uri_path_ptr + (coap_packet_ptr->uri_path_len - 1)) == '2') {
-                handle->nsp_address_ptr->omalw_server_security = (omalw_server_security_t)sn_nsdl_atoi(coap_packet_ptr->payload_ptr, coap_packet_ptr->payload_len);
-                sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, coap_packet_ptr);
-            }
+            /* GRS releases the message, so it is read first */
+            if (coap_packet_ptr->uri_path_ptr && coap_packet_ptr->uri_path_len) {
+                /* Security mode */
+                if (*(coap_packet_ptr->uri_path_ptr + (coap_packet_ptr->uri_path_len - 1)) == '2') {
+                    handle->nsp_address_ptr->omalw_server_security = (omalw_server_security_t)sn_nsdl_atoi(coap_packet_ptr->payload_ptr, coap_packet_ptr->payload_len);
+                }
 
-            /* NSP address */
-            else if (*(coap_packet_ptr->uri_path_ptr + (coap_packet_ptr->uri_path_len - 1)) == '0') {
-                sn_nsdl_resolve_lwm2m_address(handle, coap_packet_ptr->payload_ptr, coap_packet_ptr->payload_len);
-                sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, coap_packet_ptr);
+                /* NSP address */
+                else if (*(coap_packet_ptr->uri_path_ptr + (coap_packet_ptr->uri_path_len - 1)) == '0') {
+                    sn_nsdl_resolve_lwm2m_address(handle, coap_packet_ptr->payload_ptr, coap_packet_ptr->payload_len);
+                }
             }
 
+            sn_grs_process_coap(handle, coap_packet_ptr, src_ptr);
             sn_nsdl_check_oma_bs_status(handle);
         } else {
             sn_coap_parser_release_allocated_coap_msg_mem(handle->grs->coap, coap_packet_ptr);
@@ -1017,11 +1590,43 @@ int8_t sn_nsdl_process_coap(struct nsdl_s *handle, uint8_t *packet_ptr, uint16_t
 
 int8_t sn_nsdl_exec(struct nsdl_s *handle, uint32_t time)
 {
+    int8_t ret_val;
+
     if(!handle || !handle->grs){
         return SN_NSDL_FAILURE;
     }
     /* Call CoAP execution function */
-    return sn_coap_protocol_exec(handle->grs->coap, time);
+    ret_val = sn_coap_protocol_exec(handle->grs->coap, time);
+
+    /* Send automatic registration update when its time has come */
+    if (handle->update_scheduled && (handle->sn_nsdl_endpoint_registered == SN_NSDL_ENDPOINT_IS_REGISTERED) &&
+            ((int32_t)(time - handle->update_deadline) >= 0)) {
+        /* Response reschedules, retry is used if it never arrives or if update could not be sent */
+        sn_nsdl_update_registration(handle, NULL, 0);
+        sn_nsdl_schedule_registration_update(handle, time, true);
+    }
+
+    return ret_val;
+}
+
+int8_t sn_nsdl_get_next_deadline(struct nsdl_s *handle, uint32_t *deadline_ptr)
+{
+    int8_t ret_val;
+
+    if (!handle || !handle->grs || !deadline_ptr) {
+        return SN_NSDL_FAILURE;
+    }
+
+    ret_val = sn_coap_protocol_get_next_deadline(handle->grs->coap, deadline_ptr);
+
+    if (handle->update_scheduled && (handle->sn_nsdl_endpoint_registered == SN_NSDL_ENDPOINT_IS_REGISTERED)) {
+        if (ret_val != 0 || (int32_t)(handle->update_deadline - *deadline_ptr) < 0) {
+            *deadline_ptr = handle->update_deadline;
+        }
+        ret_val = 0;
+    }
+
+    return ret_val == 0 ? SN_NSDL_SUCCESS : SN_NSDL_FAILURE;
 }
 
 sn_nsdl_resource_info_s *sn_nsdl_get_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path_ptr)
@@ -1031,6 +1636,17 @@ sn_nsdl_resource_info_s *sn_nsdl_get_resource(struct nsdl_s *handle, uint16_t pa
         return NULL;
     }
 
+    /* Caller may change the resource, so template resource is copied first */
+    return sn_grs_make_writable(handle->grs, sn_grs_search_resource(handle->grs, pathlen, path_ptr, SN_GRS_SEARCH_METHOD));
+}
+
+const sn_nsdl_resource_info_s *sn_nsdl_find_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path_ptr)
+{
+    /* Check parameters */
+    if (handle == NULL) {
+        return NULL;
+    }
+
     return sn_grs_search_resource(handle->grs, pathlen, path_ptr, SN_GRS_SEARCH_METHOD);
 }
 
@@ -1053,7 +1669,7 @@ static uint16_t sn_nsdl_internal_coap_send(struct nsdl_s *handle, sn_coap_hdr_s
     tr_debug("sn_nsdl_internal_coap_send");
     uint8_t     *coap_message_ptr   = NULL;
     int32_t     coap_message_len    = 0;
-    uint16_t    coap_header_len     = 0;
+    sn_coap_len_t coap_header_len   = 0;
 
 #if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
     int8_t ret_val = prepare_blockwise_message(handle->grs->coap, coap_header_ptr);
@@ -1082,26 +1698,131 @@ static uint16_t sn_nsdl_internal_coap_send(struct nsdl_s *handle, sn_coap_hdr_s
 
     /* If mesage type is confirmable, save it to list to wait for reply */
     if (coap_header_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
-        if (message_description == SN_NSDL_MSG_REGISTER) {
-            handle->register_msg_id = coap_header_ptr->msg_id;
-            handle->register_msg_len = coap_header_len;
-        }
-        else if (message_description == SN_NSDL_MSG_UNREGISTER) {
-            handle->unregister_msg_id = coap_header_ptr->msg_id;
-        }
-        else if (message_description == SN_NSDL_MSG_UPDATE) {
-            handle->update_register_msg_id = coap_header_ptr->msg_id;
-            handle->update_register_msg_len = coap_header_len;
-        }
-        else if (message_description == SN_NSDL_MSG_BOOTSTRAP) {
-            handle->bootstrap_msg_id = coap_header_ptr->msg_id;
+        sn_nsdl_store_sent_msg_info(handle, coap_header_ptr->msg_id, coap_header_len, message_description);
+    }
+
+    handle->sn_nsdl_tx_callback(handle, SN_NSDL_PROTOCOL_COAP, coap_message_ptr, coap_message_len, dst_addr_ptr);
+    handle->sn_nsdl_free(coap_message_ptr);
+
+    return coap_header_ptr->msg_id;
+}
+
+/**
+ * \fn static uint16_t sn_nsdl_internal_coap_send_streamed(struct nsdl_s *handle, sn_coap_hdr_s *coap_header_ptr, sn_nsdl_addr_s *dst_addr_ptr, uint8_t message_description, uint8_t body_filter)
+ *
+ *
+ * \brief To send registration or registration update with payload generated block by block.
+ *        Payload is never held in memory as a whole, so it can exceed 64 kB.
+ * \param   *handle                 Pointer to nsdl-library handle
+ * \param   *coap_header_ptr        Pointer to the CoAP message header to be sent, without payload
+ * \param   *dst_addr_ptr           Pointer to the address structure that contains destination address information
+ * \param   message_description     SN_NSDL_MSG_REGISTER or SN_NSDL_MSG_UPDATE
+ * \param   body_filter             SN_NSDL_BODY_ALL_RESOURCES or SN_NSDL_BODY_UNREGISTERED
+ *
+ * \return  message id, 0 if failed
+ */
+static uint16_t sn_nsdl_internal_coap_send_streamed(struct nsdl_s *handle, sn_coap_hdr_s *coap_header_ptr, sn_nsdl_addr_s *dst_addr_ptr, uint8_t message_description, uint8_t body_filter)
+{
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
+    tr_debug("sn_nsdl_internal_coap_send_streamed");
+    uint8_t                 *coap_message_ptr   = NULL;
+    uint16_t                coap_message_len    = 0;
+    uint32_t                payload_total_len   = 0;
+    sn_nsdl_body_stream_s   *stream_ptr;
+    const sn_nsdl_resource_info_s *resource_temp_ptr;
+
+    /* Mark resources which are listed in payload, so that payload stays the same between blocks.
+     * Marks are per session, registrations of other sessions sharing the resources are not affected */
+    resource_temp_ptr = sn_grs_get_first_resource(handle->grs);
+    while (resource_temp_ptr) {
+        if (sn_nsdl_include_in_registration_body(handle, resource_temp_ptr, body_filter)) {
+            sn_grs_set_registration_state(handle->grs, resource_temp_ptr, handle->session_slot, SN_NDSL_RESOURCE_REGISTERING);
         }
+        resource_temp_ptr = sn_grs_get_next_resource(handle->grs, resource_temp_ptr);
+    }
+
+    payload_total_len = sn_nsdl_calculate_registration_body_size(handle, SN_NSDL_BODY_REGISTERING);
+    if (!payload_total_len) {
+        return sn_nsdl_internal_coap_send(handle, coap_header_ptr, dst_addr_ptr, message_description);
+    }
+
+    stream_ptr = handle->sn_nsdl_alloc(sizeof(sn_nsdl_body_stream_s));
+    if (!stream_ptr) {
+        return 0;
+    }
+    stream_ptr->handle = handle;
+
+    if (sn_coap_protocol_prepare_streamed_message(handle->grs->coap, coap_header_ptr, payload_total_len,
+                                                  sn_nsdl_registration_body_source, stream_ptr) != 0) {
+        handle->sn_nsdl_free(stream_ptr);
+        return 0;
+    }
+
+    coap_message_len = sn_coap_builder_calc_needed_packet_data_size_2(coap_header_ptr, handle->grs->coap->sn_coap_block_data_size);
+    tr_debug("sn_nsdl_internal_coap_send_streamed - msg len after calc: [%d]", coap_message_len);
+    if (coap_message_len == 0) {
+        handle->sn_nsdl_free(stream_ptr);
+        return 0;
+    }
+
+    coap_message_ptr = handle->sn_nsdl_alloc(coap_message_len);
+    if (!coap_message_ptr) {
+        handle->sn_nsdl_free(stream_ptr);
+        return 0;
+    }
+
+    /* Build message, CoAP library takes ownership of the stream context */
+    if (sn_coap_protocol_build_streamed(handle->grs->coap, dst_addr_ptr, coap_message_ptr, coap_header_ptr,
+                                        payload_total_len, sn_nsdl_registration_body_source, stream_ptr, (void *)handle) < 0) {
+        handle->sn_nsdl_free(coap_message_ptr);
+        handle->sn_nsdl_free(stream_ptr);
+        return 0;
+    }
+
+    /* Streamed transfer has no empty trailing block, last block id is first + (len - 1) / block size */
+    if (coap_header_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
+        sn_nsdl_store_sent_msg_info(handle, coap_header_ptr->msg_id, payload_total_len - 1, message_description);
     }
 
     handle->sn_nsdl_tx_callback(handle, SN_NSDL_PROTOCOL_COAP, coap_message_ptr, coap_message_len, dst_addr_ptr);
     handle->sn_nsdl_free(coap_message_ptr);
 
     return coap_header_ptr->msg_id;
+#else
+    (void)handle;
+    (void)coap_header_ptr;
+    (void)dst_addr_ptr;
+    (void)message_description;
+    (void)body_filter;
+    return 0;
+#endif
+}
+
+/**
+ * \fn static void sn_nsdl_store_sent_msg_info(struct nsdl_s *handle, uint16_t msg_id, uint32_t msg_len, uint8_t message_description)
+ *
+ * \brief Stores message id and payload length of sent confirmable request to catch response from NSP server
+ * \param   *handle             Pointer to nsdl-library handle
+ * \param   msg_id              Message id of the first sent message
+ * \param   msg_len             Payload length, used to resolve message id of the last block
+ * \param   message_description Message description
+ */
+static void sn_nsdl_store_sent_msg_info(struct nsdl_s *handle, uint16_t msg_id, uint32_t msg_len, uint8_t message_description)
+{
+    if (message_description == SN_NSDL_MSG_REGISTER) {
+        handle->register_msg_id = msg_id;
+        handle->register_msg_len = msg_len;
+    }
+    else if (message_description == SN_NSDL_MSG_UNREGISTER) {
+        handle->unregister_msg_id = msg_id;
+    }
+    else if (message_description == SN_NSDL_MSG_UPDATE) {
+        handle->update_register_msg_id = msg_id;
+        handle->update_register_msg_len = msg_len;
+    }
+    else if (message_description == SN_NSDL_MSG_BOOTSTRAP) {
+        handle->bootstrap_msg_id = msg_id;
+    }
 }
 
 /**
@@ -1248,20 +1969,19 @@ int8_t sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *mes
 {
     tr_debug("sn_nsdl_build_registration_body");
     /* Local variables */
-    uint8_t                 *temp_ptr;
+    uint8_t                         *temp_ptr;
     const sn_nsdl_resource_info_s   *resource_temp_ptr;
 
     /* Calculate needed memory and allocate */
-    int8_t error = 0;
-    uint16_t msg_len = sn_nsdl_calculate_registration_body_size(handle, updating_registeration, &error);
-    if (SN_NSDL_FAILURE == error) {
-        return error;
+    uint32_t msg_len = sn_nsdl_calculate_registration_body_size(handle, updating_registeration);
+    if (msg_len > UINT16_MAX) {
+        return SN_NSDL_FAILURE;
     }
 
     if (!msg_len) {
         return SN_NSDL_SUCCESS;
     } else {
-        message_ptr->payload_len = msg_len;
+        message_ptr->payload_len = (uint16_t)msg_len;
     }
     tr_debug("sn_nsdl_build_registration_body - body size: [%d]", message_ptr->payload_len);
     message_ptr->payload_ptr = handle->sn_nsdl_alloc(message_ptr->payload_len);
@@ -1269,92 +1989,26 @@ int8_t sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *mes
         return SN_NSDL_FAILURE;
     }
 
-    /* Build message */
+    /* Build message, whole payload fits to the buffer so it is written directly */
     temp_ptr = message_ptr->payload_ptr;
 
+    /* Removed links first, before they can be confused with re-created ones */
+    temp_ptr = sn_nsdl_body_put_removed_links(handle, temp_ptr, updating_registeration);
+
     resource_temp_ptr = sn_grs_get_first_resource(handle->grs);
 
     /* Loop trough all resources */
     while (resource_temp_ptr) {
         /* if resource needs to be registered */
-        if (resource_temp_ptr->resource_parameters_ptr && resource_temp_ptr->publish_uri) {
-            if (updating_registeration && resource_temp_ptr->resource_parameters_ptr->registered == SN_NDSL_RESOURCE_REGISTERED) {
-                resource_temp_ptr = sn_grs_get_next_resource(handle->grs, resource_temp_ptr);
-                continue;
-            } else {
-                resource_temp_ptr->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
-            }
+        if (sn_nsdl_include_in_registration_body(handle, resource_temp_ptr, updating_registeration)) {
+            sn_grs_set_registration_state(handle->grs, resource_temp_ptr, handle->session_slot, SN_NDSL_RESOURCE_REGISTERED);
 
             /* If not first resource, add '.' to separator */
             if (temp_ptr != message_ptr->payload_ptr) {
                 *temp_ptr++ = ',';
             }
 
-            *temp_ptr++ = '<';
-            *temp_ptr++ = '/';
-            memcpy(temp_ptr, resource_temp_ptr->path, resource_temp_ptr->pathlen);
-            temp_ptr += resource_temp_ptr->pathlen;
-            *temp_ptr++ = '>';
-
-            /* Resource attributes */
-            if (resource_temp_ptr->resource_parameters_ptr->resource_type_len) {
-                *temp_ptr++ = ';';
-                memcpy(temp_ptr, resource_type_parameter, RT_PARAMETER_LEN);
-                temp_ptr += RT_PARAMETER_LEN;
-                *temp_ptr++ = '"';
-                memcpy(temp_ptr, resource_temp_ptr->resource_parameters_ptr->resource_type_ptr, resource_temp_ptr->resource_parameters_ptr->resource_type_len);
-                temp_ptr += resource_temp_ptr->resource_parameters_ptr->resource_type_len;
-                *temp_ptr++ = '"';
-            }
-
-            if (resource_temp_ptr->resource_parameters_ptr->interface_description_len) {
-                *temp_ptr++ = ';';
-                memcpy(temp_ptr, if_description_parameter, IF_PARAMETER_LEN);
-                temp_ptr += IF_PARAMETER_LEN;
-                *temp_ptr++ = '"';
-                memcpy(temp_ptr, resource_temp_ptr->resource_parameters_ptr->interface_description_ptr, resource_temp_ptr->resource_parameters_ptr->interface_description_len);
-                temp_ptr += resource_temp_ptr->resource_parameters_ptr->interface_description_len;
-                *temp_ptr++ = '"';
-            }
-
-            if (resource_temp_ptr->resource_parameters_ptr->coap_content_type != 0) {
-                *temp_ptr++ = ';';
-                memcpy(temp_ptr, coap_con_type_parameter, COAP_CON_PARAMETER_LEN);
-                temp_ptr += COAP_CON_PARAMETER_LEN;
-                *temp_ptr++ = '"';
-                temp_ptr = sn_nsdl_itoa(temp_ptr, resource_temp_ptr->resource_parameters_ptr->coap_content_type);
-                *temp_ptr++ = '"';
-            }
-
-            /* ;obs */
-             // This needs to be re-visited and may be need an API for maganging obs value for different server implementation
-#ifndef COAP_DISABLE_OBS_FEATURE
-            if (resource_temp_ptr->resource_parameters_ptr->observable) {
-                *temp_ptr++ = ';';
-                memcpy(temp_ptr, obs_parameter, OBS_PARAMETER_LEN);
-                temp_ptr += OBS_PARAMETER_LEN;
-            }
-#endif
-            /* ;aobs;id= */
-            /* todo: aosb not supported ATM */
-            /*
-            if((resource_temp_ptr->resource_parameters_ptr->auto_obs_len > 0 && resource_temp_ptr->resource_parameters_ptr->auto_obs_len <= 8) &&
-                    resource_temp_ptr->resource_parameters_ptr->auto_obs_ptr)
-            {
-                uint8_t i = 0;
-
-                *temp_ptr++ = ';';
-                memcpy(temp_ptr, aobs_parameter, AOBS_PARAMETER_LEN);
-                temp_ptr += AOBS_PARAMETER_LEN;
-
-                while(i < resource_temp_ptr->resource_parameters_ptr->auto_obs_len)
-                {
-                    temp_ptr = sn_nsdl_itoa(temp_ptr, *(resource_temp_ptr->resource_parameters_ptr->auto_obs_ptr + i));
-                    i++;
-                }
-            }
-            */
-
+            temp_ptr = sn_nsdl_body_put_link(temp_ptr, resource_temp_ptr);
         }
 
         resource_temp_ptr = sn_grs_get_next_resource(handle->grs, resource_temp_ptr);
@@ -1364,285 +2018,647 @@ int8_t sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *mes
 }
 
 /**
- * \fn static uint16_t sn_nsdl_calculate_registration_body_size(struct nsdl_s *handle, uint8_t updating_registeration, int8_t *error)
+ * \fn static uint32_t sn_nsdl_calculate_registration_body_size(struct nsdl_s *handle, uint8_t updating_registeration)
  *
  *
  * \brief   Calculates registration message payload size
  * \param   *handle                 Pointer to nsdl-library handle
- * \param   *updating_registeration Pointer to list of GRS resources
- * \param   *error                  Error code, SN_NSDL_SUCCESS or SN_NSDL_FAILURE
+ * \param   updating_registeration  Which resources are included, see sn_nsdl_include_in_registration_body()
  *
- * \return  Needed payload size
+ * \return  Needed payload size, can exceed 64 kB
  */
-static uint16_t sn_nsdl_calculate_registration_body_size(struct nsdl_s *handle, uint8_t updating_registeration, int8_t *error)
+static uint32_t sn_nsdl_calculate_registration_body_size(struct nsdl_s *handle, uint8_t updating_registeration)
 {
     tr_debug("sn_nsdl_calculate_registration_body_size");
     /* Local variables */
-    uint16_t return_value = 0;
-    *error = SN_NSDL_SUCCESS;
+    uint32_t return_value = sn_nsdl_calculate_removed_links_len(handle, updating_registeration);
     const sn_nsdl_resource_info_s *resource_temp_ptr;
 
     /* check pointer */
     resource_temp_ptr = sn_grs_get_first_resource(handle->grs);
 
     while (resource_temp_ptr) {
-        if (resource_temp_ptr->resource_parameters_ptr && resource_temp_ptr->publish_uri) {
-            if (updating_registeration && resource_temp_ptr->resource_parameters_ptr->registered == SN_NDSL_RESOURCE_REGISTERED) {
-                resource_temp_ptr = sn_grs_get_next_resource(handle->grs, resource_temp_ptr);
-                continue;
-            }
-
+        if (sn_nsdl_include_in_registration_body(handle, resource_temp_ptr, updating_registeration)) {
             /* If not first resource, then '.' will be added */
             if (return_value) {
-                if (sn_nsdl_check_uint_overflow(return_value, 1, 0)) {
-                    return_value++;
-                } else {
-                    *error = SN_NSDL_FAILURE;
-                    break;
-                }
+                return_value++;
             }
+            return_value += sn_nsdl_calculate_link_len(resource_temp_ptr);
+        }
+        resource_temp_ptr = sn_grs_get_next_resource(handle->grs, resource_temp_ptr);
+    }
+    return return_value;
+}
 
-            /* Count length for the resource path </path> */
-            if (sn_nsdl_check_uint_overflow(return_value, 3,resource_temp_ptr->pathlen)) {
-                return_value += (3 + resource_temp_ptr->pathlen);
-            } else {
-                *error = SN_NSDL_FAILURE;
-                break;
-            }
+/**
+ * \fn static bool sn_nsdl_include_in_registration_body(const struct nsdl_s *handle, const sn_nsdl_resource_info_s *resource_ptr, uint8_t updating_registeration)
+ *
+ * \brief   Checks if resource is listed in registration message payload of a session
+ * \param   *handle                 Pointer to nsdl-library handle, registration state of its session is used
+ * \param   *resource_ptr           Pointer to resource
+ * \param   updating_registeration  0 = all published resources, 1 = resources not yet registered,
+ *                                  SN_NSDL_BODY_REGISTERING = resources marked for streamed registration
+ *
+ * \return  true if resource is listed
+ */
+static bool sn_nsdl_include_in_registration_body(const struct nsdl_s *handle, const sn_nsdl_resource_info_s *resource_ptr, uint8_t updating_registeration)
+{
+    if (!resource_ptr->resource_parameters_ptr || !resource_ptr->publish_uri) {
+        return false;
+    }
+    if (updating_registeration == SN_NSDL_BODY_REGISTERING) {
+        return sn_grs_get_registration_state(handle->grs, resource_ptr, handle->session_slot) == SN_NDSL_RESOURCE_REGISTERING;
+    }
+    if (updating_registeration &&
+            sn_grs_get_registration_state(handle->grs, resource_ptr, handle->session_slot) == SN_NDSL_RESOURCE_REGISTERED) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * \fn static uint32_t sn_nsdl_calculate_link_len(const sn_nsdl_resource_info_s *resource_ptr)
+ *
+ * \brief   Calculates length of one resource in link format, without separator
+ * \param   *resource_ptr   Pointer to resource
+ *
+ * \return  Link length
+ */
+static uint32_t sn_nsdl_calculate_link_len(const sn_nsdl_resource_info_s *resource_ptr)
+{
+    /* Count length for the resource path </path> */
+    uint32_t return_value = 3 + (uint32_t)resource_ptr->pathlen;
 
-            /* Count lengths of the attributes */
+    /* Count lengths of the attributes */
 
-            /* Resource type parameter */
-            if (resource_temp_ptr->resource_parameters_ptr->resource_type_len) {
-                /* ;rt="restype" */
-                if (sn_nsdl_check_uint_overflow(return_value, 6, resource_temp_ptr->resource_parameters_ptr->resource_type_len)) {
-                    return_value += (6 + resource_temp_ptr->resource_parameters_ptr->resource_type_len);
-                } else {
-                    *error = SN_NSDL_FAILURE;
-                    break;
-                }
-            }
+    /* Resource type parameter */
+    if (resource_ptr->resource_parameters_ptr->resource_type_len) {
+        /* ;rt="restype" */
+        return_value += 6 + (uint32_t)resource_ptr->resource_parameters_ptr->resource_type_len;
+    }
 
-            /* Interface description parameter */
-            if (resource_temp_ptr->resource_parameters_ptr->interface_description_len) {
-                /* ;if="iftype" */
-                if (sn_nsdl_check_uint_overflow(return_value, 6, resource_temp_ptr->resource_parameters_ptr->interface_description_len)) {
-                    return_value += (6 + resource_temp_ptr->resource_parameters_ptr->interface_description_len);
-                } else {
-                    *error = SN_NSDL_FAILURE;
-                    break;
-                }
+    /* Interface description parameter */
+    if (resource_ptr->resource_parameters_ptr->interface_description_len) {
+        /* ;if="iftype" */
+        return_value += 6 + (uint32_t)resource_ptr->resource_parameters_ptr->interface_description_len;
+    }
+
+    if (resource_ptr->resource_parameters_ptr->coap_content_type != 0) {
+        /* ;ct="content" */
+        return_value += 6 + sn_nsdl_itoa_len(resource_ptr->resource_parameters_ptr->coap_content_type);
+    }
+#ifndef COAP_DISABLE_OBS_FEATURE
+    // This needs to be re-visited and may be need an API for maganging obs value for different server implementation
+    if (resource_ptr->resource_parameters_ptr->observable) {
+        return_value += 4;
+    }
+#endif
+    return return_value;
+}
+
+/**
+ * \fn static uint8_t *sn_nsdl_body_put_link(uint8_t *dst_ptr, const sn_nsdl_resource_info_s *resource_ptr)
+ *
+ * \brief   Writes one resource in link format to registration payload
+ * \param   *dst_ptr        Destination, must have room for sn_nsdl_calculate_link_len() bytes
+ * \param   *resource_ptr   Pointer to resource
+ *
+ * \return  Pointer to the first byte after the link
+ */
+static uint8_t *sn_nsdl_body_put_link(uint8_t *dst_ptr, const sn_nsdl_resource_info_s *resource_ptr)
+{
+    *dst_ptr++ = '<';
+    *dst_ptr++ = '/';
+    memcpy(dst_ptr, resource_ptr->path, resource_ptr->pathlen);
+    dst_ptr += resource_ptr->pathlen;
+    *dst_ptr++ = '>';
+
+    /* Resource attributes */
+    if (resource_ptr->resource_parameters_ptr->resource_type_len) {
+        *dst_ptr++ = ';';
+        memcpy(dst_ptr, resource_type_parameter, RT_PARAMETER_LEN);
+        dst_ptr += RT_PARAMETER_LEN;
+        *dst_ptr++ = '"';
+        memcpy(dst_ptr, resource_ptr->resource_parameters_ptr->resource_type_ptr, resource_ptr->resource_parameters_ptr->resource_type_len);
+        dst_ptr += resource_ptr->resource_parameters_ptr->resource_type_len;
+        *dst_ptr++ = '"';
+    }
+
+    if (resource_ptr->resource_parameters_ptr->interface_description_len) {
+        *dst_ptr++ = ';';
+        memcpy(dst_ptr, if_description_parameter, IF_PARAMETER_LEN);
+        dst_ptr += IF_PARAMETER_LEN;
+        *dst_ptr++ = '"';
+        memcpy(dst_ptr, resource_ptr->resource_parameters_ptr->interface_description_ptr, resource_ptr->resource_parameters_ptr->interface_description_len);
+        dst_ptr += resource_ptr->resource_parameters_ptr->interface_description_len;
+        *dst_ptr++ = '"';
+    }
+
+    if (resource_ptr->resource_parameters_ptr->coap_content_type != 0) {
+        *dst_ptr++ = ';';
+        memcpy(dst_ptr, coap_con_type_parameter, COAP_CON_PARAMETER_LEN);
+        dst_ptr += COAP_CON_PARAMETER_LEN;
+        *dst_ptr++ = '"';
+        dst_ptr = sn_nsdl_itoa(dst_ptr, resource_ptr->resource_parameters_ptr->coap_content_type);
+        *dst_ptr++ = '"';
+    }
+
+    /* ;obs */
+     // This needs to be re-visited and may be need an API for maganging obs value for different server implementation
+#ifndef COAP_DISABLE_OBS_FEATURE
+    if (resource_ptr->resource_parameters_ptr->observable) {
+        *dst_ptr++ = ';';
+        memcpy(dst_ptr, obs_parameter, OBS_PARAMETER_LEN);
+        dst_ptr += OBS_PARAMETER_LEN;
+    }
+#endif
+    /* ;aobs;id= */
+    /* todo: aosb not supported ATM */
+
+    return dst_ptr;
+}
+
+/**
+ * \fn static uint32_t sn_nsdl_calculate_removed_links_len(struct nsdl_s *handle, uint8_t updating_registeration)
+ *
+ * \brief   Calculates length of removed links in registration update payload, separators included
+ * \param   *handle                 Pointer to nsdl-library handle
+ * \param   updating_registeration  Removed links are never listed in full registration
+ *
+ * \return  Length of removed links
+ */
+static uint32_t sn_nsdl_calculate_removed_links_len(struct nsdl_s *handle, uint8_t updating_registeration)
+{
+    uint32_t return_value = 0;
+    const sn_grs_removed_resource_s *removed_temp_ptr;
+
+    if (updating_registeration == SN_NSDL_BODY_ALL_RESOURCES) {
+        return 0;
+    }
+
+    removed_temp_ptr = sn_grs_get_first_removed_resource(handle->grs);
+    while (removed_temp_ptr) {
+        if (removed_temp_ptr->sending & SN_GRS_SESSION_BIT(handle->session_slot)) {
+            if (return_value) {
+                return_value++;
             }
+            /* </path>;rm */
+            return_value += 4 + (uint32_t)removed_temp_ptr->pathlen + RM_PARAMETER_LEN;
+        }
+        removed_temp_ptr = sn_grs_get_next_removed_resource(handle->grs, removed_temp_ptr);
+    }
+    return return_value;
+}
 
-            if (resource_temp_ptr->resource_parameters_ptr->coap_content_type != 0) {
-                /* ;if="content" */
-                uint8_t len = sn_nsdl_itoa_len(resource_temp_ptr->resource_parameters_ptr->coap_content_type);
-                if (sn_nsdl_check_uint_overflow(return_value, 6, len)) {
-                    return_value += (6 + len);
-                } else {
-                    *error = SN_NSDL_FAILURE;
-                    break;
-                }
+/**
+ * \fn static uint8_t *sn_nsdl_body_put_removed_links(struct nsdl_s *handle, uint8_t *dst_ptr, uint8_t updating_registeration)
+ *
+ * \brief   Writes links of removed resources, included in ongoing registration update, to payload
+ * \param   *handle                 Pointer to nsdl-library handle
+ * \param   *dst_ptr                Start of the payload, must have room for sn_nsdl_calculate_removed_links_len() bytes
+ * \param   updating_registeration  Removed links are never listed in full registration
+ *
+ * \return  Pointer to the first byte after the links
+ */
+static uint8_t *sn_nsdl_body_put_removed_links(struct nsdl_s *handle, uint8_t *dst_ptr, uint8_t updating_registeration)
+{
+    uint8_t *start_ptr = dst_ptr;
+    const sn_grs_removed_resource_s *removed_temp_ptr;
+
+    if (updating_registeration == SN_NSDL_BODY_ALL_RESOURCES) {
+        return dst_ptr;
+    }
+
+    removed_temp_ptr = sn_grs_get_first_removed_resource(handle->grs);
+    while (removed_temp_ptr) {
+        if (removed_temp_ptr->sending & SN_GRS_SESSION_BIT(handle->session_slot)) {
+            if (dst_ptr != start_ptr) {
+                *dst_ptr++ = ',';
             }
+            *dst_ptr++ = '<';
+            *dst_ptr++ = '/';
+            memcpy(dst_ptr, removed_temp_ptr->path, removed_temp_ptr->pathlen);
+            dst_ptr += removed_temp_ptr->pathlen;
+            *dst_ptr++ = '>';
+            *dst_ptr++ = ';';
+            memcpy(dst_ptr, removed_parameter, RM_PARAMETER_LEN);
+            dst_ptr += RM_PARAMETER_LEN;
+        }
+        removed_temp_ptr = sn_grs_get_next_removed_resource(handle->grs, removed_temp_ptr);
+    }
+    return dst_ptr;
+}
+
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not used at all, this part of code will not be compiled */
+/**
+ * \fn static void sn_nsdl_body_write(sn_nsdl_body_window_s *window, const uint8_t *src_ptr, uint16_t len)
+ *
+ * \brief   Writes data to streamed registration payload. Only the part that falls into the window is copied,
+ *          position is always advanced.
+ * \param   *window     Pointer to payload window
+ * \param   *src_ptr    Data to be written
+ * \param   len         Length of the data
+ */
+static void sn_nsdl_body_write(sn_nsdl_body_window_s *window, const uint8_t *src_ptr, uint16_t len)
+{
+    uint32_t window_end = window->start + window->len;
+
+    if (window->position < window_end && (window->position + len) > window->start) {
+        uint32_t skip = 0;
+        uint32_t copy_len;
+
+        if (window->start > window->position) {
+            skip = window->start - window->position;
+        }
+        copy_len = len - skip;
+        if ((window->position + skip + copy_len) > window_end) {
+            copy_len = window_end - (window->position + skip);
+        }
+        memcpy(window->dst_ptr + (window->position + skip - window->start), src_ptr + skip, copy_len);
+    }
+
+    window->position += len;
+}
+
+static void sn_nsdl_body_write_char(sn_nsdl_body_window_s *window, uint8_t chr)
+{
+    sn_nsdl_body_write(window, &chr, 1);
+}
+
+/**
+ * \fn static void sn_nsdl_body_write_link(sn_nsdl_body_window_s *window, const sn_nsdl_resource_info_s *resource_ptr, uint32_t link_len)
+ *
+ * \brief   Writes one resource in link format to streamed registration payload.
+ *          Links inside the window are written directly, only links crossing a block border are clipped.
+ * \param   *window         Pointer to payload window
+ * \param   *resource_ptr   Pointer to resource
+ * \param   link_len        Length of the link, from sn_nsdl_calculate_link_len()
+ */
+static void sn_nsdl_body_write_link(sn_nsdl_body_window_s *window, const sn_nsdl_resource_info_s *resource_ptr, uint32_t link_len)
+{
+    if (window->position >= window->start && (window->position + link_len) <= (window->start + window->len)) {
+        sn_nsdl_body_put_link(window->dst_ptr + (window->position - window->start), resource_ptr);
+        window->position += link_len;
+        return;
+    }
+
+    sn_nsdl_body_write_char(window, '<');
+    sn_nsdl_body_write_char(window, '/');
+    sn_nsdl_body_write(window, resource_ptr->path, resource_ptr->pathlen);
+    sn_nsdl_body_write_char(window, '>');
+
+    if (resource_ptr->resource_parameters_ptr->resource_type_len) {
+        sn_nsdl_body_write_char(window, ';');
+        sn_nsdl_body_write(window, resource_type_parameter, RT_PARAMETER_LEN);
+        sn_nsdl_body_write_char(window, '"');
+        sn_nsdl_body_write(window, resource_ptr->resource_parameters_ptr->resource_type_ptr, resource_ptr->resource_parameters_ptr->resource_type_len);
+        sn_nsdl_body_write_char(window, '"');
+    }
+
+    if (resource_ptr->resource_parameters_ptr->interface_description_len) {
+        sn_nsdl_body_write_char(window, ';');
+        sn_nsdl_body_write(window, if_description_parameter, IF_PARAMETER_LEN);
+        sn_nsdl_body_write_char(window, '"');
+        sn_nsdl_body_write(window, resource_ptr->resource_parameters_ptr->interface_description_ptr, resource_ptr->resource_parameters_ptr->interface_description_len);
+        sn_nsdl_body_write_char(window, '"');
+    }
+
+    if (resource_ptr->resource_parameters_ptr->coap_content_type != 0) {
+        uint8_t content_type[3];
+        uint8_t *content_type_end = sn_nsdl_itoa(content_type, resource_ptr->resource_parameters_ptr->coap_content_type);
+
+        sn_nsdl_body_write_char(window, ';');
+        sn_nsdl_body_write(window, coap_con_type_parameter, COAP_CON_PARAMETER_LEN);
+        sn_nsdl_body_write_char(window, '"');
+        sn_nsdl_body_write(window, content_type, content_type_end - content_type);
+        sn_nsdl_body_write_char(window, '"');
+    }
+
 #ifndef COAP_DISABLE_OBS_FEATURE
-            // This needs to be re-visited and may be need an API for maganging obs value for different server implementation
-            if (resource_temp_ptr->resource_parameters_ptr->observable) {
-                if (sn_nsdl_check_uint_overflow(return_value, 4, 0)) {
-                    return_value += 4;
-                } else {
-                    *error = SN_NSDL_FAILURE;
-                    break;
+    if (resource_ptr->resource_parameters_ptr->observable) {
+        sn_nsdl_body_write_char(window, ';');
+        sn_nsdl_body_write(window, obs_parameter, OBS_PARAMETER_LEN);
+    }
+#endif
+}
+
+/**
+ * \fn static void sn_nsdl_body_write_removed_links(struct nsdl_s *handle, sn_nsdl_body_window_s *window, uint8_t updating_registeration)
+ *
+ * \brief   Writes links of removed resources, included in ongoing registration update, to streamed payload
+ * \param   *handle                 Pointer to nsdl-library handle
+ * \param   *window                 Pointer to payload window
+ * \param   updating_registeration  Removed links are never listed in full registration
+ */
+static void sn_nsdl_body_write_removed_links(struct nsdl_s *handle, sn_nsdl_body_window_s *window, uint8_t updating_registeration)
+{
+    const sn_grs_removed_resource_s *removed_temp_ptr;
+
+    if (updating_registeration == SN_NSDL_BODY_ALL_RESOURCES) {
+        return;
+    }
+
+    removed_temp_ptr = sn_grs_get_first_removed_resource(handle->grs);
+    while (removed_temp_ptr) {
+        if (removed_temp_ptr->sending & SN_GRS_SESSION_BIT(handle->session_slot)) {
+            if (window->position) {
+                sn_nsdl_body_write_char(window, ',');
+            }
+            sn_nsdl_body_write_char(window, '<');
+            sn_nsdl_body_write_char(window, '/');
+            sn_nsdl_body_write(window, removed_temp_ptr->path, removed_temp_ptr->pathlen);
+            sn_nsdl_body_write_char(window, '>');
+            sn_nsdl_body_write_char(window, ';');
+            sn_nsdl_body_write(window, removed_parameter, RM_PARAMETER_LEN);
+        }
+        removed_temp_ptr = sn_grs_get_next_removed_resource(handle->grs, removed_temp_ptr);
+    }
+}
+
+/**
+ * \fn static uint16_t sn_nsdl_registration_body_source(void *context, uint32_t offset, uint8_t *dst_ptr, uint16_t len)
+ *
+ * \brief   Payload source for streamed registration. Generates requested block of the link format payload
+ *          from resources marked as SN_NDSL_RESOURCE_REGISTERING, links ending before the block are only counted.
+ * \param   *context    Pointer to sn_nsdl_body_stream_s
+ * \param   offset      Offset of the block in whole payload
+ * \param   *dst_ptr    Destination of the block
+ * \param   len         Length of the block
+ *
+ * \return  Number of bytes written, less than len if resources were removed during registration
+ */
+static uint16_t sn_nsdl_registration_body_source(void *context, uint32_t offset, uint8_t *dst_ptr, uint16_t len)
+{
+    sn_nsdl_body_stream_s           *stream_ptr = context;
+    sn_nsdl_body_window_s           window;
+    const sn_nsdl_resource_info_s   *resource_temp_ptr;
+
+    window.dst_ptr = dst_ptr;
+    window.start = offset;
+    window.len = len;
+    window.position = 0;
+
+    sn_nsdl_body_write_removed_links(stream_ptr->handle, &window, SN_NSDL_BODY_REGISTERING);
+
+    resource_temp_ptr = sn_grs_get_first_resource(stream_ptr->handle->grs);
+
+    while (resource_temp_ptr && window.position < (offset + len)) {
+        if (sn_nsdl_include_in_registration_body(stream_ptr->handle, resource_temp_ptr, SN_NSDL_BODY_REGISTERING)) {
+            uint32_t link_len = sn_nsdl_calculate_link_len(resource_temp_ptr);
+
+            if ((window.position + (window.position ? 1 : 0) + link_len) <= offset) {
+                window.position += (window.position ? 1 : 0) + link_len;
+            } else {
+                if (window.position) {
+                    sn_nsdl_body_write_char(&window, ',');
                 }
+                sn_nsdl_body_write_link(&window, resource_temp_ptr, link_len);
             }
-#endif
         }
-        resource_temp_ptr = sn_grs_get_next_resource(handle->grs, resource_temp_ptr);
+        resource_temp_ptr = sn_grs_get_next_resource(stream_ptr->handle->grs, resource_temp_ptr);
     }
-    return return_value;
+
+    if (window.position >= (offset + len)) {
+        return len;
+    }
+    if (window.position > offset) {
+        return (uint16_t)(window.position - offset);
+    }
+    return 0;
+}
+#endif
+
+/**
+ * \fn static void sn_nsdl_set_uri_query_field(sn_nsdl_uri_query_field_s *field_ptr, const uint8_t *name_ptr, uint8_t name_len,
+ *                                             const uint8_t *value_ptr, uint8_t value_len)
+ *
+ * \brief Sets name and value of one uri-query field
+ */
+static void sn_nsdl_set_uri_query_field(sn_nsdl_uri_query_field_s *field_ptr, const uint8_t *name_ptr, uint8_t name_len,
+                                        const uint8_t *value_ptr, uint8_t value_len)
+{
+    field_ptr->name_ptr = name_ptr;
+    field_ptr->name_len = name_len;
+    field_ptr->value_ptr = value_ptr;
+    field_ptr->value_len = value_len;
 }
 
 /**
- * \fn static uint8_t sn_nsdl_calculate_uri_query_option_len(sn_nsdl_ep_parameters_s *endpoint_info_ptr, uint8_t msg_type)
- *
+ * \fn static uint8_t sn_nsdl_get_uri_query_fields(const sn_nsdl_ep_parameters_s *parameter_ptr, uint8_t msg_type,
+ *                                                 sn_nsdl_uri_query_field_s *field_ptr, uint8_t *binding_ptr)
  *
- * \brief Calculates needed uri query option length
- *
- * \param *endpoint_info_ptr    Pointer to endpoint info structure
- * \param msg_type              Message type
+ * \brief Lists name=value fields of uri-query in the order they are encoded.
+ *        Encoding, length calculation and comparison of stored uri-query all use this list.
+ * \param *parameter_ptr    Pointer to endpoint parameters struct
+ * \param msg_type          Message type
+ * \param *field_ptr        Array of SN_NSDL_URI_QUERY_MAX_FIELDS fields to fill
+ * \param *binding_ptr      Buffer of SN_NSDL_BINDING_MAX_LEN bytes for binding value, fields point to it
  *
- * \return  number of parameters in uri query
+ * \return  number of fields
  */
-static uint8_t sn_nsdl_calculate_uri_query_option_len(sn_nsdl_ep_parameters_s *endpoint_info_ptr, uint8_t msg_type)
+static uint8_t sn_nsdl_get_uri_query_fields(const sn_nsdl_ep_parameters_s *parameter_ptr, uint8_t msg_type,
+                                            sn_nsdl_uri_query_field_s *field_ptr, uint8_t *binding_ptr)
 {
-    uint8_t return_value = 0;
-    uint8_t number_of_parameters = 0;
-
+    uint8_t field_count = 0;
+    uint8_t binding_len = 0;
 
-    if ((endpoint_info_ptr->endpoint_name_len != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE) && endpoint_info_ptr->endpoint_name_ptr != 0) {
-        return_value += endpoint_info_ptr->endpoint_name_len;
-        return_value += EP_NAME_PARAMETERS_LEN; //ep=
-        number_of_parameters++;
+    if ((parameter_ptr->endpoint_name_len != 0) && (parameter_ptr->endpoint_name_ptr != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
+        sn_nsdl_set_uri_query_field(&field_ptr[field_count++], ep_name_parameter_string, EP_NAME_PARAMETERS_LEN,
+                                    parameter_ptr->endpoint_name_ptr, parameter_ptr->endpoint_name_len);
     }
 
-    if ((endpoint_info_ptr->type_len != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE) && (endpoint_info_ptr->type_ptr != 0)) {
-        return_value += endpoint_info_ptr->type_len;
-        return_value += ET_PARAMETER_LEN;       //et=
-        number_of_parameters++;
+    if ((parameter_ptr->type_len != 0) && (parameter_ptr->type_ptr != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
+        sn_nsdl_set_uri_query_field(&field_ptr[field_count++], et_parameter, ET_PARAMETER_LEN,
+                                    parameter_ptr->type_ptr, parameter_ptr->type_len);
     }
 
-    if ((endpoint_info_ptr->lifetime_len != 0) && (endpoint_info_ptr->lifetime_ptr != 0)) {
-        return_value += endpoint_info_ptr->lifetime_len;
-        return_value += LT_PARAMETER_LEN;       //lt=
-        number_of_parameters++;
+    if ((parameter_ptr->lifetime_len != 0) && (parameter_ptr->lifetime_ptr != 0)) {
+        sn_nsdl_set_uri_query_field(&field_ptr[field_count++], ep_lifetime_parameter, LT_PARAMETER_LEN,
+                                    parameter_ptr->lifetime_ptr, parameter_ptr->lifetime_len);
     }
 
-    if ((endpoint_info_ptr->domain_name_len != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE) && (endpoint_info_ptr->domain_name_ptr != 0)) {
-        return_value += endpoint_info_ptr->domain_name_len;
-        return_value += DOMAIN_PARAMETER_LEN;       //d=
-        number_of_parameters++;
+    if ((parameter_ptr->domain_name_len != 0) && (parameter_ptr->domain_name_ptr != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
+        sn_nsdl_set_uri_query_field(&field_ptr[field_count++], ep_domain_parameter, DOMAIN_PARAMETER_LEN,
+                                    parameter_ptr->domain_name_ptr, parameter_ptr->domain_name_len);
     }
 
-    if (((endpoint_info_ptr->binding_and_mode & 0x04) || (endpoint_info_ptr->binding_and_mode & 0x01)) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
-        return_value += BS_QUEUE_MODE_PARAMATER_LEN;
-
-        if (endpoint_info_ptr->binding_and_mode & 0x01) {
-            return_value++;
-        }
-        if (endpoint_info_ptr->binding_and_mode & 0x04) {
-            return_value++;
+    if (((parameter_ptr->binding_and_mode & 0x01) || (parameter_ptr->binding_and_mode & 0x04)) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
+        if (parameter_ptr->binding_and_mode & 0x01) {
+            binding_ptr[binding_len++] = 'U';
+            if (parameter_ptr->binding_and_mode & 0x02) {
+                binding_ptr[binding_len++] = 'Q';
+            }
         }
-        if ((endpoint_info_ptr->binding_and_mode & 0x02) && ((endpoint_info_ptr->binding_and_mode & 0x04) || (endpoint_info_ptr->binding_and_mode & 0x01))) {
-            return_value++;
+
+        if (parameter_ptr->binding_and_mode & 0x04) {
+            binding_ptr[binding_len++] = 'S';
+            if ((parameter_ptr->binding_and_mode & 0x02) && !(parameter_ptr->binding_and_mode & 0x01)) {
+                binding_ptr[binding_len++] = 'Q';
+            }
         }
 
-        number_of_parameters++;
+        sn_nsdl_set_uri_query_field(&field_ptr[field_count++], bs_queue_mode, BS_QUEUE_MODE_PARAMATER_LEN,
+                                    binding_ptr, binding_len);
+    }
+
+    return field_count;
+}
+
+/**
+ * \fn static uint8_t sn_nsdl_calculate_uri_query_option_len(const sn_nsdl_uri_query_field_s *field_ptr, uint8_t field_count)
+ *
+ *
+ * \brief Calculates needed uri query option length
+ *
+ * \param *field_ptr        Fields from sn_nsdl_get_uri_query_fields()
+ * \param field_count       Number of fields
+ *
+ * \return  length of uri query
+ */
+static uint8_t sn_nsdl_calculate_uri_query_option_len(const sn_nsdl_uri_query_field_s *field_ptr, uint8_t field_count)
+{
+    uint8_t return_value = 0;
+    uint8_t i;
+
+    for (i = 0; i < field_count; i++) {
+        return_value += field_ptr[i].name_len + field_ptr[i].value_len;
     }
 
-    if (number_of_parameters != 0) {
-        return_value += (number_of_parameters - 1);
+    /* Fields are separated by '&' */
+    if (field_count != 0) {
+        return_value += (field_count - 1);
     }
 
     return return_value;
 }
 
 /**
- * \fn static int8_t sn_nsdl_fill_uri_query_options(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr, sn_coap_hdr_s *source_msg_ptr, uint8_t msg_type)
+ * \fn static int8_t sn_nsdl_build_uri_query(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr, uint8_t msg_type, uint8_t **query_pptr, uint16_t *query_len_ptr)
  *
  *
- * \brief Fills uri-query options to message header struct
+ * \brief Encodes uri-query option bytes into a buffer owned by the handle.
+ *        Previous buffer pointed by *query_pptr is released. Parameters must be validated by caller.
  * \param *handle           Pointer to nsdl-library handle
  * \param *parameter_ptr    Pointer to endpoint parameters struct
- * \param *source_msg_ptr   Pointer to CoAP header struct
  * \param msg_type          Message type
+ * \param **query_pptr      Pointer to the stored query pointer
+ * \param *query_len_ptr    Pointer to the stored query length
  *
  * \return  SN_NSDL_SUCCESS = 0, Failed = -1
  */
-static int8_t sn_nsdl_fill_uri_query_options(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr, sn_coap_hdr_s *source_msg_ptr, uint8_t msg_type)
+static int8_t sn_nsdl_build_uri_query(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr, uint8_t msg_type, uint8_t **query_pptr, uint16_t *query_len_ptr)
 {
+    sn_nsdl_uri_query_field_s fields[SN_NSDL_URI_QUERY_MAX_FIELDS];
+    uint8_t binding[SN_NSDL_BINDING_MAX_LEN];
+    uint8_t field_count;
+    uint8_t i;
+    uint8_t *query_ptr = NULL;
     uint8_t *temp_ptr = NULL;
-    if( !validateParameters(parameter_ptr) ){
-        return SN_NSDL_FAILURE;
+
+    if (*query_pptr) {
+        handle->sn_nsdl_free(*query_pptr);
+        *query_pptr = NULL;
     }
-    source_msg_ptr->options_list_ptr->uri_query_len  = sn_nsdl_calculate_uri_query_option_len(parameter_ptr, msg_type);
-    if (source_msg_ptr->options_list_ptr->uri_query_len == 0) {
-        return 0;
+    field_count = sn_nsdl_get_uri_query_fields(parameter_ptr, msg_type, fields, binding);
+    *query_len_ptr = sn_nsdl_calculate_uri_query_option_len(fields, field_count);
+    if (*query_len_ptr == 0) {
+        return SN_NSDL_SUCCESS;
     }
 
-    source_msg_ptr->options_list_ptr->uri_query_ptr     =   handle->sn_nsdl_alloc(source_msg_ptr->options_list_ptr->uri_query_len);
-
-    if (source_msg_ptr->options_list_ptr->uri_query_ptr == NULL) {
+    query_ptr = handle->sn_nsdl_alloc(*query_len_ptr);
+    if (query_ptr == NULL) {
+        *query_len_ptr = 0;
         return SN_NSDL_FAILURE;
     }
-    memset(source_msg_ptr->options_list_ptr->uri_query_ptr,0,source_msg_ptr->options_list_ptr->uri_query_len);
-
-    temp_ptr = source_msg_ptr->options_list_ptr->uri_query_ptr;
-
-    /******************************************************/
-    /* If endpoint name is configured, fill needed fields */
-    /******************************************************/
-
-    if ((parameter_ptr->endpoint_name_len != 0) && (parameter_ptr->endpoint_name_ptr != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
-        /* fill endpoint name, first ?ep=, then endpoint name */
-        memcpy(temp_ptr, ep_name_parameter_string, sizeof(ep_name_parameter_string));
-        temp_ptr += EP_NAME_PARAMETERS_LEN;
-        memcpy(temp_ptr, parameter_ptr->endpoint_name_ptr, parameter_ptr->endpoint_name_len);
-        temp_ptr += parameter_ptr->endpoint_name_len;
-    }
 
-    /******************************************************/
-    /* If endpoint type is configured, fill needed fields */
-    /******************************************************/
-
-    if ((parameter_ptr->type_len != 0) && (parameter_ptr->type_ptr != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
-        if (temp_ptr != source_msg_ptr->options_list_ptr->uri_query_ptr) {
+    temp_ptr = query_ptr;
+    for (i = 0; i < field_count; i++) {
+        if (i != 0) {
             *temp_ptr++ = '&';
         }
-
-        memcpy(temp_ptr, et_parameter, sizeof(et_parameter));
-        temp_ptr += ET_PARAMETER_LEN;
-        memcpy(temp_ptr, parameter_ptr->type_ptr, parameter_ptr->type_len);
-        temp_ptr += parameter_ptr->type_len;
+        memcpy(temp_ptr, fields[i].name_ptr, fields[i].name_len);
+        temp_ptr += fields[i].name_len;
+        memcpy(temp_ptr, fields[i].value_ptr, fields[i].value_len);
+        temp_ptr += fields[i].value_len;
     }
 
+    *query_pptr = query_ptr;
+    return SN_NSDL_SUCCESS;
+}
 
-    /******************************************************/
-    /* If lifetime is configured, fill needed fields */
-    /******************************************************/
-
-    if ((parameter_ptr->lifetime_len != 0) && (parameter_ptr->lifetime_ptr != 0)) {
-        if (temp_ptr != source_msg_ptr->options_list_ptr->uri_query_ptr) {
-            *temp_ptr++ = '&';
-        }
+/**
+ * \fn static bool sn_nsdl_register_uri_query_matches(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr)
+ *
+ * \brief Checks if registration uri-query encoded earlier is the same that given parameters would give.
+ *        Fields are taken from sn_nsdl_get_uri_query_fields(), like sn_nsdl_build_uri_query() does.
+ * \param *handle           Pointer to nsdl-library handle
+ * \param *parameter_ptr    Endpoint parameters of the registration
+ *
+ * \return  true if encoded uri-query can be reused
+ */
+static bool sn_nsdl_register_uri_query_matches(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *parameter_ptr)
+{
+    sn_nsdl_uri_query_field_s fields[SN_NSDL_URI_QUERY_MAX_FIELDS];
+    uint8_t binding[SN_NSDL_BINDING_MAX_LEN];
+    uint8_t field_count;
+    uint8_t i;
+    const uint8_t *query_ptr = handle->register_uri_query_ptr;
 
-        memcpy(temp_ptr, ep_lifetime_parameter, sizeof(ep_lifetime_parameter));
-        temp_ptr += LT_PARAMETER_LEN;
-        memcpy(temp_ptr, parameter_ptr->lifetime_ptr, parameter_ptr->lifetime_len);
-        temp_ptr += parameter_ptr->lifetime_len;
+    field_count = sn_nsdl_get_uri_query_fields(parameter_ptr, SN_NSDL_EP_REGISTER_MESSAGE, fields, binding);
+    if (!query_ptr || handle->register_uri_query_len != sn_nsdl_calculate_uri_query_option_len(fields, field_count)) {
+        return false;
     }
 
-    /******************************************************/
-    /* If domain is configured, fill needed fields */
-    /******************************************************/
-
-    if ((parameter_ptr->domain_name_len != 0) && (parameter_ptr->domain_name_ptr != 0) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
-        if (temp_ptr != source_msg_ptr->options_list_ptr->uri_query_ptr) {
-            *temp_ptr++ = '&';
+    /* Length is the same, so fields and separators can be compared without further bounds checks */
+    for (i = 0; i < field_count; i++) {
+        if (i != 0 && *query_ptr++ != '&') {
+            return false;
         }
-
-        memcpy(temp_ptr, ep_domain_parameter, sizeof(ep_domain_parameter));
-        temp_ptr += DOMAIN_PARAMETER_LEN;
-        memcpy(temp_ptr, parameter_ptr->domain_name_ptr, parameter_ptr->domain_name_len);
-        temp_ptr += parameter_ptr->domain_name_len;
+        if (memcmp(query_ptr, fields[i].name_ptr, fields[i].name_len) ||
+                memcmp(query_ptr + fields[i].name_len, fields[i].value_ptr, fields[i].value_len)) {
+            return false;
+        }
+        query_ptr += fields[i].name_len + fields[i].value_len;
     }
+    return true;
+}
 
-    /******************************************************/
-    /* If queue-mode is configured, fill needed fields    */
-    /******************************************************/
-
-    if (((parameter_ptr->binding_and_mode & 0x01) || (parameter_ptr->binding_and_mode & 0x04)) && (msg_type == SN_NSDL_EP_REGISTER_MESSAGE)) {
-        if (temp_ptr != source_msg_ptr->options_list_ptr->uri_query_ptr) {
-            *temp_ptr++ = '&';
-        }
+/**
+ * \fn static int8_t sn_nsdl_update_uri_query(struct nsdl_s *handle, uint8_t *lifetime_ptr, uint8_t lifetime_len)
+ *
+ *
+ * \brief Refreshes registration update uri-query, re-encoded only if lifetime differs from previous update
+ * \param *handle           Pointer to nsdl-library handle
+ * \param *lifetime_ptr     Pointer to lifetime, NULL if lifetime is not updated
+ * \param lifetime_len      Length of lifetime
+ *
+ * \return  SN_NSDL_SUCCESS = 0, Failed = -1
+ */
+static int8_t sn_nsdl_update_uri_query(struct nsdl_s *handle, uint8_t *lifetime_ptr, uint8_t lifetime_len)
+{
+    sn_nsdl_ep_parameters_s temp_parameters;
 
-        memcpy(temp_ptr, bs_queue_mode, sizeof(bs_queue_mode));
-        temp_ptr += BS_QUEUE_MODE_PARAMATER_LEN;
+    if (lifetime_ptr && lifetime_len && handle->update_uri_query_ptr &&
+            (handle->update_uri_query_len == LT_PARAMETER_LEN + lifetime_len) &&
+            !memcmp(handle->update_uri_query_ptr + LT_PARAMETER_LEN, lifetime_ptr, lifetime_len)) {
+        return SN_NSDL_SUCCESS;
+    }
 
-        if (parameter_ptr->binding_and_mode & 0x01) {
-            *temp_ptr++ = 'U';
-            if (parameter_ptr->binding_and_mode & 0x02) {
-                *temp_ptr++ = 'Q';
-            }
-        }
+    memset(&temp_parameters, 0, sizeof(sn_nsdl_ep_parameters_s));
+    temp_parameters.lifetime_len = lifetime_len;
+    temp_parameters.lifetime_ptr = lifetime_ptr;
 
-        if (parameter_ptr->binding_and_mode & 0x04) {
-            *temp_ptr++ = 'S';
-            if ((parameter_ptr->binding_and_mode & 0x02) && !(parameter_ptr->binding_and_mode & 0x01)) {
-                *temp_ptr++ = 'Q';
-            }
+    if (!validateParameters(&temp_parameters)) {
+        if (handle->update_uri_query_ptr) {
+            handle->sn_nsdl_free(handle->update_uri_query_ptr);
+            handle->update_uri_query_ptr = NULL;
         }
+        handle->update_uri_query_len = 0;
+        return SN_NSDL_FAILURE;
     }
 
-    return SN_NSDL_SUCCESS;
+    return sn_nsdl_build_uri_query(handle, &temp_parameters, SN_NSDL_EP_UPDATE_MESSAGE,
+                                   &handle->update_uri_query_ptr, &handle->update_uri_query_len);
 }
 
 static bool validateParameters(sn_nsdl_ep_parameters_s *parameter_ptr)
@@ -1716,9 +2732,20 @@ static int8_t sn_nsdl_local_rx_function(struct nsdl_s *handle, sn_coap_hdr_s *co
         }
         if (coap_packet_ptr->msg_id == handle->update_register_msg_id) {
             is_update_reg_msg = true;
+            sn_grs_mark_resources_as_registered(handle);
+            sn_grs_release_removed_resources(handle->grs, SN_GRS_SESSION_BIT(handle->session_slot), true);
         }
     }
 
+    /* Lifetime restarts from successful registration or update */
+    if (is_reg_msg || is_update_reg_msg) {
+        sn_nsdl_schedule_registration_update(handle, handle->grs->coap->system_time, false);
+    } else if (coap_packet_ptr->msg_code >= COAP_MSG_CODE_RESPONSE_BAD_REQUEST &&
+               coap_packet_ptr->msg_id == handle->update_register_msg_id) {
+        /* Server rejected update, application has to register again */
+        handle->update_scheduled = false;
+    }
+
     if (coap_packet_ptr->msg_id == handle->unregister_msg_id) {
         is_unreg_msg = true;
         if (coap_packet_ptr->msg_code == COAP_MSG_CODE_RESPONSE_DELETED) {
@@ -1939,6 +2966,11 @@ static int32_t sn_nsdl_atoi(uint8_t *ptr, uint8_t len)
 
     while (len--) {
 
+        /* Too big values are treated as invalid, instead of overflowing */
+        if (result > (INT32_MAX - 9) / 10) {
+            return -1;
+        }
+
         if (result) {
             result *= 10;
         }
@@ -1956,6 +2988,87 @@ static int32_t sn_nsdl_atoi(uint8_t *ptr, uint8_t len)
 
 }
 
+/**
+ * \fn static uint32_t sn_nsdl_resolve_lifetime(uint8_t *lifetime_ptr, uint8_t lifetime_len)
+ *
+ * \brief Converts lt parameter to seconds
+ * \param *lifetime_ptr     Pointer to lifetime string, may be NULL
+ * \param lifetime_len      Length of lifetime string
+ *
+ * \return  lifetime in seconds, SN_NSDL_DEFAULT_LIFETIME if not given or invalid
+ */
+static uint32_t sn_nsdl_resolve_lifetime(uint8_t *lifetime_ptr, uint8_t lifetime_len)
+{
+    int32_t lifetime = -1;
+
+    if (lifetime_ptr && lifetime_len) {
+        lifetime = sn_nsdl_atoi(lifetime_ptr, lifetime_len);
+    }
+
+    if (lifetime <= 0) {
+        return SN_NSDL_DEFAULT_LIFETIME;
+    }
+    return (uint32_t)lifetime;
+}
+
+/**
+ * \fn static void sn_nsdl_schedule_registration_update(struct nsdl_s *handle, uint32_t current_time, bool retry)
+ *
+ * \brief Sets time of next automatic registration update.
+ *
+ *  Update is sent at configured percentage of lifetime, advanced by a random
+ *  jitter of at most SN_NSDL_UPDATE_JITTER_PERCENT of the interval. Retry is
+ *  scheduled when update is sent or sending fails, after half of the margin
+ *  between update interval and lifetime, and is replaced when response arrives.
+ *  Retry is not sooner than CoAP gives up resending the previous update, so
+ *  that a small margin does not make updates overlap or wake up constantly.
+ *
+ * \param *handle           Pointer to nsdl-library handle
+ * \param current_time      System time in seconds
+ * \param retry             true if scheduling retry of sent update
+ */
+static void sn_nsdl_schedule_registration_update(struct nsdl_s *handle, uint32_t current_time, bool retry)
+{
+    uint32_t interval;
+    uint32_t jitter_span;
+    uint32_t retry_floor;
+    struct coap_s *coap = handle->grs->coap;
+
+    if (!handle->update_interval_percent) {
+        handle->update_scheduled = false;
+        return;
+    }
+
+    /* Percentage of lifetime without overflowing 32 bits */
+    interval = (handle->lifetime / 100) * handle->update_interval_percent +
+               ((handle->lifetime % 100) * handle->update_interval_percent) / 100;
+
+    if (retry) {
+        interval = (handle->lifetime - interval) / 2;
+
+        /* Sum of CoAP resending timeouts, which double after every resend */
+        retry_floor = (uint32_t)(coap->sn_coap_resending_intervall * RESPONSE_RANDOM_FACTOR) *
+                      ((UINT32_C(1) << (coap->sn_coap_resending_count + 1)) - 1);
+        if (interval < retry_floor) {
+            interval = retry_floor;
+        }
+    } else {
+        jitter_span = (interval / 100) * SN_NSDL_UPDATE_JITTER_PERCENT +
+                      ((interval % 100) * SN_NSDL_UPDATE_JITTER_PERCENT) / 100;
+        if (jitter_span) {
+            handle->update_jitter_seed = (handle->update_jitter_seed * 1103515245) + 12345;
+            interval -= (handle->update_jitter_seed >> 16) % (jitter_span + 1);
+        }
+    }
+
+    if (interval == 0) {
+        interval = 1;
+    }
+
+    handle->update_deadline = current_time + interval;
+    handle->update_scheduled = true;
+}
+
 static uint32_t sn_nsdl_ahextoi(uint8_t *ptr, uint8_t len)
 {
 
@@ -2003,7 +3116,7 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
     /* Resolve address type */
     /* Count semicolons */
 
-    int8_t endPos = -1;
+    int16_t endPos = -1;
 
     while (i < (uri_len - (temp_ptr - uri))) {
         if (*(temp_ptr + i) == ':') {
@@ -2032,7 +3145,7 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
         }
 
         memset(handle->nsp_address_ptr->omalw_address_ptr->addr_ptr, 0, 16);
-        if (*temp_ptr == '[' && endPos > 0 && (temp_ptr - uri) + endPos < uri_len && *(temp_ptr + endPos + 1) == ':') {
+        if (*temp_ptr == '[' && endPos > 0 && (temp_ptr - uri) + endPos + 1 < uri_len && *(temp_ptr + endPos + 1) == ':') {
             temp_ptr++;
             endPos--;
         }else{
@@ -2040,7 +3153,10 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
             return SN_NSDL_FAILURE;
         }
 
-        int8_t loopbackPos = -1;
+        /* Address parsing must not go past the closing bracket */
+        uint8_t *addr_end_ptr = temp_ptr + endPos;
+
+        int16_t loopbackPos = -1;
         if( char_cnt != 8 ){
             i = 0;
             char_cnt -= 1;
@@ -2064,8 +3180,8 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
         }
 
         /* Resolve address */
-        int8_t pos = loopbackPos == 0?0:-1;
-        while (i < 16 && ((temp_ptr - uri) + char_cnt) < uri_len) {
+        int16_t pos = loopbackPos == 0?0:-1;
+        while (i < 16 && temp_ptr < addr_end_ptr) {
             char_cnt = 0;
             if( pos == loopbackPos ){
                 for( int k=0; k < numberOfZeros; k++ ){
@@ -2078,9 +3194,13 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
                 }
                 continue;
             }
-            while (*(temp_ptr + char_cnt) != ':' && *(temp_ptr + char_cnt) != ']') {
+            while (temp_ptr + char_cnt < addr_end_ptr && *(temp_ptr + char_cnt) != ':') {
                 char_cnt++;
                 pos++;
+                /* Group has at most 4 hex digits */
+                if (char_cnt > 4) {
+                    return SN_NSDL_FAILURE;
+                }
             }
             pos++;
 
@@ -2088,7 +3208,7 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
                 i++;
             }
 
-            while (char_cnt) {
+            while (char_cnt && i < 16) {
                 if (char_cnt % 2) {
                     *(handle->nsp_address_ptr->omalw_address_ptr->addr_ptr + i) = (uint8_t)sn_nsdl_ahextoi(temp_ptr, 1);
                     temp_ptr++;
@@ -2103,7 +3223,8 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
             temp_ptr++;
         }
 
-        temp_ptr++;
+        /* Port follows "]:" */
+        temp_ptr = addr_end_ptr + 2;
         uint16_t handled = (temp_ptr - uri);
         if( handled < uri_len ){
             if( *(temp_ptr + (uri_len - (temp_ptr - uri) -1)) == '/' ){
@@ -2120,6 +3241,7 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
 
         if( handle->nsp_address_ptr->omalw_address_ptr->addr_ptr ){
             handle->sn_nsdl_free(handle->nsp_address_ptr->omalw_address_ptr->addr_ptr);
+            handle->nsp_address_ptr->omalw_address_ptr->addr_ptr = NULL;
         }
 
         /* Check address type */
@@ -2147,6 +3269,14 @@ static int8_t sn_nsdl_resolve_lwm2m_address(struct nsdl_s *handle, uint8_t *uri,
             while (parseOk && ((temp_ptr - uri) < uri_len) && *(temp_ptr - 1) != ':') {
                 i++;
 
+                /* Port separator missing after the last number */
+                if ((temp_ptr - uri) + i >= uri_len) {
+                    parseOk = false;
+                    handle->sn_nsdl_free(handle->nsp_address_ptr->omalw_address_ptr->addr_ptr);
+                    handle->nsp_address_ptr->omalw_address_ptr->addr_ptr = NULL;
+                    break;
+                }
+
                 if (*(temp_ptr + i) == ':' || *(temp_ptr + i) == '.') {
                     int8_t value = (int8_t)sn_nsdl_atoi(temp_ptr, i);
                     if( value == -1 ){
@@ -2241,7 +3371,13 @@ int8_t sn_nsdl_process_oma_tlv(struct nsdl_s *handle, uint8_t *data_ptr, uint16_
 
     while ((temp_ptr - data_ptr) < data_len) {
         /* Save type for future use */
-        type = *temp_ptr++;
+        type = *temp_ptr;
+
+        /* Identifier and length fields must fit in the data */
+        if (1 + ((type & 0x20) ? 2 : 1) + ((type & 0x18) >> 3) > data_len - (temp_ptr - data_ptr)) {
+            return SN_NSDL_FAILURE;
+        }
+        temp_ptr++;
 
         /* * Bit 5: Indicates the Length of the Identifier. * */
         if (type & 0x20) {
@@ -2272,6 +3408,10 @@ int8_t sn_nsdl_process_oma_tlv(struct nsdl_s *handle, uint8_t *data_ptr, uint16_
             length += (uint8_t) * temp_ptr++;
         }
 
+        if (length > (uint32_t)(data_len - (temp_ptr - data_ptr))) {
+            return SN_NSDL_FAILURE;
+        }
+
         /* * Bits 7-6: Indicates the type of Identifier. * */
         if ((type & 0xC0) == 0x00) {
             /* 00 = Object Instance in which case the Value contains one or more Resource TLVs */
@@ -2358,9 +3498,9 @@ static void sn_nsdl_check_oma_bs_status(struct nsdl_s *handle)
         }
 
     } else if ((handle->nsp_address_ptr->omalw_server_security == CERTIFICATE) && (handle->nsp_address_ptr->omalw_address_ptr->type != SN_NSDL_ADDRESS_TYPE_NONE) &&
-               ((sn_nsdl_get_resource(handle, 5, (void *)"0/0/5") != 0) &&
-                (sn_nsdl_get_resource(handle, 5, (void *)"0/0/4") != 0) &&
-                (sn_nsdl_get_resource(handle, 5, (void *)"0/0/3") != 0))) {
+               ((sn_nsdl_find_resource(handle, 5, (void *)"0/0/5") != 0) &&
+                (sn_nsdl_find_resource(handle, 5, (void *)"0/0/4") != 0) &&
+                (sn_nsdl_find_resource(handle, 5, (void *)"0/0/3") != 0))) {
         if( handle->sn_nsdl_oma_bs_done_cb ){
             handle->sn_nsdl_oma_bs_done_cb(handle->nsp_address_ptr);
         }
@@ -2373,54 +3513,87 @@ static void sn_nsdl_check_oma_bs_status(struct nsdl_s *handle)
 
 static int8_t set_endpoint_info(struct nsdl_s *handle, sn_nsdl_ep_parameters_s *endpoint_info_ptr)
 {
-    if (handle->ep_information_ptr->domain_name_ptr) {
-        handle->sn_nsdl_free(handle->ep_information_ptr->domain_name_ptr);
-        handle->ep_information_ptr->domain_name_ptr = 0;
-        handle->ep_information_ptr->domain_name_len = 0;
-    }
-
-    if (handle->ep_information_ptr->endpoint_name_ptr) {
-        handle->sn_nsdl_free(handle->ep_information_ptr->endpoint_name_ptr);
-        handle->ep_information_ptr->endpoint_name_ptr = 0;
-        handle->ep_information_ptr->endpoint_name_len = 0;
-    }
-
-    if (endpoint_info_ptr->domain_name_ptr && endpoint_info_ptr->domain_name_len) {
-        handle->ep_information_ptr->domain_name_ptr = handle->sn_nsdl_alloc(endpoint_info_ptr->domain_name_len);
-
-        if (!handle->ep_information_ptr->domain_name_ptr) {
-            return -1;
-        }
+    /* Registering again with same parameters reuses stored copies and encoded uri-query */
+    bool query_unchanged = sn_nsdl_register_uri_query_matches(handle, endpoint_info_ptr);
 
-        memcpy(handle->ep_information_ptr->domain_name_ptr, endpoint_info_ptr->domain_name_ptr, endpoint_info_ptr->domain_name_len);
-        handle->ep_information_ptr->domain_name_len = endpoint_info_ptr->domain_name_len;
+    if (sn_nsdl_store_ep_string(handle, &handle->ep_information_ptr->domain_name_ptr, &handle->ep_information_ptr->domain_name_len,
+                                endpoint_info_ptr->domain_name_ptr, endpoint_info_ptr->domain_name_len) == SN_NSDL_FAILURE) {
+        return -1;
     }
 
-    if (endpoint_info_ptr->endpoint_name_ptr && endpoint_info_ptr->endpoint_name_len) {
-        handle->ep_information_ptr->endpoint_name_ptr = handle->sn_nsdl_alloc(endpoint_info_ptr->endpoint_name_len);
-
-        if (!handle->ep_information_ptr->endpoint_name_ptr) {
-            if (handle->ep_information_ptr->domain_name_ptr) {
-                handle->sn_nsdl_free(handle->ep_information_ptr->domain_name_ptr);
-                handle->ep_information_ptr->domain_name_ptr = 0;
-                handle->ep_information_ptr->domain_name_len = 0;
-            }
-            return -1;
+    if (sn_nsdl_store_ep_string(handle, &handle->ep_information_ptr->endpoint_name_ptr, &handle->ep_information_ptr->endpoint_name_len,
+                                endpoint_info_ptr->endpoint_name_ptr, endpoint_info_ptr->endpoint_name_len) == SN_NSDL_FAILURE) {
+        if (handle->ep_information_ptr->domain_name_ptr) {
+            handle->sn_nsdl_free(handle->ep_information_ptr->domain_name_ptr);
+            handle->ep_information_ptr->domain_name_ptr = 0;
+            handle->ep_information_ptr->domain_name_len = 0;
         }
-
-        memcpy(handle->ep_information_ptr->endpoint_name_ptr, endpoint_info_ptr->endpoint_name_ptr, endpoint_info_ptr->endpoint_name_len);
-        handle->ep_information_ptr->endpoint_name_len = endpoint_info_ptr->endpoint_name_len;
+        return -1;
     }
 
     handle->ep_information_ptr->binding_and_mode = endpoint_info_ptr->binding_and_mode;
     handle->ep_information_ptr->ds_register_mode = endpoint_info_ptr->ds_register_mode;
 
+    /* Automatic updates are scheduled again when registration is accepted.
+     * Endpoint name seeds the jitter, so that endpoints of one host spread their updates */
+    handle->update_scheduled = false;
+    handle->lifetime = sn_nsdl_resolve_lifetime(endpoint_info_ptr->lifetime_ptr, endpoint_info_ptr->lifetime_len);
+    handle->update_jitter_seed = (uint32_t)(uintptr_t)handle;
+    for (uint8_t i = 0; i < handle->ep_information_ptr->endpoint_name_len; i++) {
+        handle->update_jitter_seed = (handle->update_jitter_seed * 31) + handle->ep_information_ptr->endpoint_name_ptr[i];
+    }
+
     handle->ep_information_ptr->location_ptr = 0;
     handle->ep_information_ptr->location_len = 0;
 
+    /* Encode registration uri-query once, it is reused until endpoint info changes */
+    if (!query_unchanged &&
+            sn_nsdl_build_uri_query(handle, endpoint_info_ptr, SN_NSDL_EP_REGISTER_MESSAGE,
+                                    &handle->register_uri_query_ptr, &handle->register_uri_query_len) == SN_NSDL_FAILURE) {
+        return -1;
+    }
+
     return 0;
 }
 
+/**
+ * \fn static int8_t sn_nsdl_store_ep_string(struct nsdl_s *handle, uint8_t **dst_pptr, uint8_t *dst_len_ptr, const uint8_t *src_ptr, uint8_t src_len)
+ *
+ * \brief Stores a copy of endpoint name or domain to handle. Stored copy is kept if it is equal.
+ * \param *handle       Pointer to nsdl-library handle
+ * \param **dst_pptr    Stored copy, released if the new one differs
+ * \param *dst_len_ptr  Length of stored copy
+ * \param *src_ptr      New value, NULL if not given
+ * \param src_len       Length of new value
+ *
+ * \return  SN_NSDL_SUCCESS = 0, Failed = -1
+ */
+static int8_t sn_nsdl_store_ep_string(struct nsdl_s *handle, uint8_t **dst_pptr, uint8_t *dst_len_ptr, const uint8_t *src_ptr, uint8_t src_len)
+{
+    if (!src_ptr) {
+        src_len = 0;
+    }
+    if (*dst_pptr && *dst_len_ptr == src_len && !memcmp(*dst_pptr, src_ptr, src_len)) {
+        return SN_NSDL_SUCCESS;
+    }
+
+    if (*dst_pptr) {
+        handle->sn_nsdl_free(*dst_pptr);
+        *dst_pptr = 0;
+        *dst_len_ptr = 0;
+    }
+
+    if (src_len) {
+        *dst_pptr = handle->sn_nsdl_alloc(src_len);
+        if (!*dst_pptr) {
+            return SN_NSDL_FAILURE;
+        }
+        memcpy(*dst_pptr, src_ptr, src_len);
+        *dst_len_ptr = src_len;
+    }
+    return SN_NSDL_SUCCESS;
+}
+
 /* Wrapper */
 sn_grs_resource_list_s *sn_nsdl_list_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path)
 {
@@ -2481,6 +3654,24 @@ extern int8_t sn_nsdl_put_resource(struct nsdl_s *handle, sn_nsdl_resource_info_
     return sn_grs_put_resource(handle->grs, res);
 }
 
+extern int8_t sn_nsdl_set_resource_template(struct nsdl_s *handle, const sn_nsdl_resource_info_s *resources, uint16_t resource_count)
+{
+    if (!handle) {
+        return SN_NSDL_FAILURE;
+    }
+
+    return sn_grs_set_resource_template(handle->grs, resources, resource_count);
+}
+
+extern int8_t sn_nsdl_set_static_dispatch(struct nsdl_s *handle, const sn_nsdl_static_handler_s *(*lookup)(const uint8_t *path_ptr, uint16_t path_len))
+{
+    if (!handle) {
+        return SN_NSDL_FAILURE;
+    }
+
+    return sn_grs_set_static_dispatch(handle->grs, lookup);
+}
+
 extern int8_t sn_nsdl_delete_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path)
 {
     /* Check parameters */
@@ -2571,17 +3762,68 @@ extern int8_t sn_nsdl_set_duplicate_buffer_size(struct nsdl_s *handle, uint8_t m
     return sn_coap_protocol_set_duplicate_buffer_size(handle->grs->coap, message_count);
 }
 
-bool sn_nsdl_check_uint_overflow(uint16_t resource_size, uint16_t param_a, uint16_t param_b)
+extern int8_t sn_nsdl_set_registration_streaming(struct nsdl_s *handle, bool enable)
 {
-    uint16_t first_check = param_a + param_b;
-    if (first_check < param_b) {
-        return false;
-    } else {
-        uint16_t total = resource_size + first_check;
-        if (total < first_check) {
-            return false;
-        } else {
-            return true;
+    if (handle == NULL) {
+        return SN_NSDL_FAILURE;
+    }
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+    handle->registration_streaming = enable;
+    return SN_NSDL_SUCCESS;
+#else
+    (void)enable;
+    return SN_NSDL_FAILURE;
+#endif
+}
+
+extern int8_t sn_nsdl_set_delta_update(struct nsdl_s *handle, bool enable)
+{
+    if (handle == NULL) {
+        return SN_NSDL_FAILURE;
+    }
+    sn_grs_set_removed_resource_tracking(handle->grs, enable);
+    return SN_NSDL_SUCCESS;
+}
+
+extern int8_t sn_nsdl_set_sleeping(struct nsdl_s *handle, bool sleeping)
+{
+    if (handle == NULL) {
+        return SN_NSDL_FAILURE;
+    }
+
+    if (sleeping) {
+        /* Server holds requests only for endpoints registered in queue mode */
+        if (!handle->ep_information_ptr || !(handle->ep_information_ptr->binding_and_mode & BINDING_MODE_Q)) {
+            return SN_NSDL_FAILURE;
         }
+        handle->sleeping = true;
+        return SN_NSDL_SUCCESS;
     }
+
+    handle->sleeping = false;
+    return sn_nsdl_flush_queued_notifications(handle);
+}
+
+extern int8_t sn_nsdl_set_notification_coalescing(struct nsdl_s *handle, bool enable)
+{
+    if (handle == NULL) {
+        return SN_NSDL_FAILURE;
+    }
+    handle->coalesce_notifications = enable;
+    return SN_NSDL_SUCCESS;
+}
+
+extern int8_t sn_nsdl_set_update_interval(struct nsdl_s *handle, uint8_t lifetime_percent)
+{
+    if (handle == NULL || lifetime_percent > 100) {
+        return SN_NSDL_FAILURE;
+    }
+    handle->update_interval_percent = lifetime_percent;
+
+    if (!lifetime_percent) {
+        handle->update_scheduled = false;
+    } else if (handle->sn_nsdl_endpoint_registered == SN_NSDL_ENDPOINT_IS_REGISTERED) {
+        sn_nsdl_schedule_registration_update(handle, handle->grs->coap->system_time, false);
+    }
+    return SN_NSDL_SUCCESS;
 }
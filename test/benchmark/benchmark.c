@@ -0,0 +1,598 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Microbenchmarks for parser, builder, protocol layer, request dispatch,
+ * resource search and registration body building. Every benchmark prints one
+ * JSON object per line with ns/op, allocations/op and allocated bytes/op:
+ *
+ *   {"name":"parser/registration","iterations":524288,"ns_per_op":212.4,"allocs_per_op":3.00,"bytes_per_op":148.0,"allocs_budget":5}
+ *
+ * Allocations per operation are checked against budgets below, and exit
+ * status is 2 when any benchmark allocates more than its budget.
+ *
+ * Usage: benchmark [-time 200] [-filter parser/]
+ *   -time     minimum measuring time of one benchmark in milliseconds
+ *   -filter   runs only benchmarks whose name contains given string
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ns_types.h"
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "sn_grs.h"
+
+/* Not in public headers, same declaration as in sn_grs.c */
+extern int8_t sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *message_ptr, uint8_t updating_registeration);
+
+#define BENCHMARK_PACKET_MAX    1152
+#define BENCHMARK_PEER_PORT     5683
+
+typedef void benchmark_op(void *context);
+
+typedef struct benchmark_budget_s {
+    const char *name_prefix;
+    uint32_t allocs_per_op;
+} benchmark_budget_s;
+
+typedef struct benchmark_packet_s {
+    const char *name;
+    uint8_t data[BENCHMARK_PACKET_MAX];
+    uint16_t len;
+} benchmark_packet_s;
+
+static uint64_t min_time_ns = 200000000;
+static const char *name_filter;
+
+static uint64_t alloc_count;
+static uint64_t alloc_bytes;
+
+static uint8_t peer_address[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01};
+static sn_nsdl_addr_s peer;
+
+static uint8_t link_payload[] = {"</3/0/0>;rt=\"t\",</3/0/1>;rt=\"t\",</3303/0/5700>;obs;rt=\"temperature\""};
+static uint8_t token[] = {0x5a, 0x17, 0xc3, 0x09};
+static uint8_t registration_query[] = {"ep=benchmark-endpoint&et=type&lt=86400"};
+static uint8_t notification_value[] = {"21.5"};
+
+/* Allocations per operation, first matching prefix applies */
+static const benchmark_budget_s budgets[] = {
+    {"parser/empty_ack", 1},
+    {"parser/registration", 5},
+    {"parser/", 3},
+    {"builder/", 0},
+    {"protocol_parse/duplicates_", 5},
+    {"protocol_parse/retransmissions_", 1},
+    {"dispatch/", 10},
+    {"grs_search/", 0},
+    {"registration_body/", 1},
+};
+static int over_budget;
+
+static benchmark_packet_s corpus[5];
+static sn_coap_hdr_s corpus_headers[5];
+static sn_coap_options_list_s corpus_options[5];
+static const int corpus_count = sizeof(corpus) / sizeof(corpus[0]);
+
+static void *benchmark_alloc(sn_coap_len_t size)
+{
+    if (size) {
+        alloc_count++;
+        alloc_bytes += size;
+        return malloc(size);
+    }
+    return 0;
+}
+
+static void benchmark_free(void *ptr)
+{
+    free(ptr);
+}
+
+static uint8_t benchmark_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)packet_ptr;
+    (void)packet_len;
+    (void)address_ptr;
+    (void)param;
+    return 1;
+}
+
+static int8_t benchmark_coap_rx(sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)coap_header;
+    (void)address_ptr;
+    (void)param;
+    return 0;
+}
+
+static uint8_t benchmark_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    (void)handle;
+    (void)protocol;
+    (void)data_ptr;
+    (void)data_len;
+    (void)address_ptr;
+    return 1;
+}
+
+static uint8_t benchmark_nsdl_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    (void)handle;
+    (void)coap_header;
+    (void)address_ptr;
+    return 0;
+}
+
+static uint64_t benchmark_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/* Doubles iteration count until one batch takes at least min_time_ns, then reports that batch */
+static void benchmark_run(const char *name, benchmark_op *op, void *context)
+{
+    uint64_t iterations = 1;
+    uint64_t elapsed_ns;
+    uint64_t allocs;
+    uint64_t bytes;
+    uint64_t i;
+
+    if (name_filter && !strstr(name, name_filter)) {
+        return;
+    }
+
+    op(context);
+    for (;;) {
+        uint64_t start_ns;
+
+        alloc_count = 0;
+        alloc_bytes = 0;
+        start_ns = benchmark_now_ns();
+        for (i = 0; i < iterations; i++) {
+            op(context);
+        }
+        elapsed_ns = benchmark_now_ns() - start_ns;
+        allocs = alloc_count;
+        bytes = alloc_bytes;
+        if (elapsed_ns >= min_time_ns || iterations >= (UINT64_C(1) << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    printf("{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f",
+           name, (unsigned long long)iterations, (double)elapsed_ns / iterations,
+           (double)allocs / iterations, (double)bytes / iterations);
+    for (i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        if (!strncmp(name, budgets[i].name_prefix, strlen(budgets[i].name_prefix))) {
+            printf(",\"allocs_budget\":%u", (unsigned)budgets[i].allocs_per_op);
+            if (allocs > (uint64_t)budgets[i].allocs_per_op * iterations) {
+                fprintf(stderr, "%s: %.2f allocations per operation, budget is %u\n",
+                        name, (double)allocs / iterations, (unsigned)budgets[i].allocs_per_op);
+                over_budget = 1;
+            }
+            break;
+        }
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+static void benchmark_init_options(sn_coap_options_list_s *options)
+{
+    memset(options, 0, sizeof(sn_coap_options_list_s));
+    options->max_age = 60;
+    options->uri_port = -1;
+    options->observe = -1;
+    options->accept = COAP_CT_NONE;
+    options->block1 = -1;
+    options->block2 = -1;
+}
+
+/* Typical traffic of a registered client, built with the library's own builder */
+static void benchmark_init_corpus(void)
+{
+    static uint8_t block_payload[1024];
+    sn_coap_hdr_s *hdr;
+    int i;
+
+    memset(corpus_headers, 0, sizeof(corpus_headers));
+    memset(block_payload, 'x', sizeof(block_payload));
+    for (i = 0; i < corpus_count; i++) {
+        benchmark_init_options(&corpus_options[i]);
+        corpus_headers[i].content_format = COAP_CT_NONE;
+        corpus_headers[i].msg_id = (uint16_t)(1000 + i);
+    }
+
+    corpus[0].name = "empty_ack";
+    hdr = &corpus_headers[0];
+    hdr->msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+    hdr->msg_code = COAP_MSG_CODE_EMPTY;
+
+    corpus[1].name = "get_request";
+    hdr = &corpus_headers[1];
+    hdr->msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    hdr->msg_code = COAP_MSG_CODE_REQUEST_GET;
+    hdr->token_ptr = token;
+    hdr->token_len = sizeof(token);
+    hdr->uri_path_ptr = (uint8_t *)"3303/0/5700";
+    hdr->uri_path_len = 11;
+
+    corpus[2].name = "registration";
+    hdr = &corpus_headers[2];
+    hdr->msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    hdr->msg_code = COAP_MSG_CODE_REQUEST_POST;
+    hdr->token_ptr = token;
+    hdr->token_len = sizeof(token);
+    hdr->uri_path_ptr = (uint8_t *)"rd";
+    hdr->uri_path_len = 2;
+    hdr->content_format = COAP_CT_LINK_FORMAT;
+    hdr->options_list_ptr = &corpus_options[2];
+    corpus_options[2].uri_query_ptr = registration_query;
+    corpus_options[2].uri_query_len = sizeof(registration_query) - 1;
+    hdr->payload_ptr = link_payload;
+    hdr->payload_len = sizeof(link_payload) - 1;
+
+    corpus[3].name = "notification";
+    hdr = &corpus_headers[3];
+    hdr->msg_type = COAP_MSG_TYPE_NON_CONFIRMABLE;
+    hdr->msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
+    hdr->token_ptr = token;
+    hdr->token_len = sizeof(token);
+    hdr->content_format = COAP_CT_TEXT_PLAIN;
+    hdr->options_list_ptr = &corpus_options[3];
+    corpus_options[3].observe = 42;
+    hdr->payload_ptr = notification_value;
+    hdr->payload_len = sizeof(notification_value) - 1;
+
+    corpus[4].name = "block2_response";
+    hdr = &corpus_headers[4];
+    hdr->msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+    hdr->msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
+    hdr->token_ptr = token;
+    hdr->token_len = sizeof(token);
+    hdr->content_format = COAP_CT_OCTET_STREAM;
+    hdr->options_list_ptr = &corpus_options[4];
+    corpus_options[4].block2 = (3 << 4) | 0x08 | 6;
+    hdr->payload_ptr = block_payload;
+    hdr->payload_len = sizeof(block_payload);
+
+    for (i = 0; i < corpus_count; i++) {
+        int16_t len = sn_coap_builder_2(corpus[i].data, &corpus_headers[i], 0);
+
+        if (len <= 0) {
+            printf("Building %s failed\n", corpus[i].name);
+            exit(1);
+        }
+        corpus[i].len = (uint16_t)len;
+    }
+}
+
+typedef struct benchmark_parser_s {
+    struct coap_s *coap;
+    benchmark_packet_s *packet;
+} benchmark_parser_s;
+
+static void benchmark_parser_op(void *context)
+{
+    benchmark_parser_s *bench = context;
+    coap_version_e version = COAP_VERSION_UNKNOWN;
+    sn_coap_hdr_s *hdr = sn_coap_parser(bench->coap, bench->packet->len, bench->packet->data, &version);
+
+    sn_coap_parser_release_allocated_coap_msg_mem(bench->coap, hdr);
+}
+
+static void benchmark_parser(struct coap_s *coap)
+{
+    benchmark_parser_s bench;
+    char name[64];
+    int i;
+
+    bench.coap = coap;
+    for (i = 0; i < corpus_count; i++) {
+        bench.packet = &corpus[i];
+        snprintf(name, sizeof(name), "parser/%s", corpus[i].name);
+        benchmark_run(name, &benchmark_parser_op, &bench);
+    }
+}
+
+static void benchmark_builder_op(void *context)
+{
+    static uint8_t packet[BENCHMARK_PACKET_MAX];
+    sn_coap_hdr_s *hdr = context;
+    uint16_t len = sn_coap_builder_calc_needed_packet_data_size_2(hdr, 0);
+
+    if (len > sizeof(packet) || sn_coap_builder_2(packet, hdr, 0) < 0) {
+        printf("Building failed\n");
+        exit(1);
+    }
+}
+
+static void benchmark_builder(void)
+{
+    char name[64];
+    int i;
+
+    for (i = 0; i < corpus_count; i++) {
+        snprintf(name, sizeof(name), "builder/%s", corpus[i].name);
+        benchmark_run(name, &benchmark_builder_op, &corpus_headers[i]);
+    }
+}
+
+typedef struct benchmark_protocol_s {
+    struct coap_s *coap;
+    sn_coap_hdr_s *hdr;
+    uint8_t packet[BENCHMARK_PACKET_MAX];
+    uint16_t packet_len;
+} benchmark_protocol_s;
+
+/* Fresh message id every time, so the message is stored and the oldest entry evicted */
+static void benchmark_protocol_request_op(void *context)
+{
+    benchmark_protocol_s *bench = context;
+    sn_coap_hdr_s *hdr;
+
+    bench->hdr->msg_id++;
+    sn_coap_builder_2(bench->packet, bench->hdr, 0);
+    hdr = sn_coap_protocol_parse(bench->coap, &peer, bench->packet_len, bench->packet, NULL);
+    sn_coap_parser_release_allocated_coap_msg_mem(bench->coap, hdr);
+}
+
+/* Acknowledgement matches no stored message, so the whole table is searched */
+static void benchmark_protocol_ack_op(void *context)
+{
+    benchmark_protocol_s *bench = context;
+    sn_coap_hdr_s *hdr = sn_coap_protocol_parse(bench->coap, &peer, bench->packet_len, bench->packet, NULL);
+
+    sn_coap_parser_release_allocated_coap_msg_mem(bench->coap, hdr);
+}
+
+static void benchmark_protocol(void)
+{
+    static const uint8_t fill_levels[] = {1, 3, 6};
+    benchmark_protocol_s bench;
+    sn_coap_hdr_s request;
+    char name[64];
+    unsigned i;
+    uint8_t j;
+
+    request = corpus_headers[1];
+    bench.hdr = &request;
+    bench.packet_len = corpus[1].len;
+
+    for (i = 0; i < sizeof(fill_levels); i++) {
+        bench.coap = sn_coap_protocol_init(&benchmark_alloc, &benchmark_free, &benchmark_coap_tx, &benchmark_coap_rx);
+        if (!bench.coap) {
+            printf("Init failed\n");
+            exit(1);
+        }
+        sn_coap_protocol_set_duplicate_buffer_size(bench.coap, fill_levels[i]);
+        for (j = 0; j < fill_levels[i]; j++) {
+            benchmark_protocol_request_op(&bench);
+        }
+        snprintf(name, sizeof(name), "protocol_parse/duplicates_%u", fill_levels[i]);
+        benchmark_run(name, &benchmark_protocol_request_op, &bench);
+        sn_coap_protocol_destroy(bench.coap);
+    }
+
+    for (i = 0; i < sizeof(fill_levels); i++) {
+        sn_coap_hdr_s confirmable = corpus_headers[1];
+        sn_coap_hdr_s ack = corpus_headers[0];
+
+        bench.coap = sn_coap_protocol_init(&benchmark_alloc, &benchmark_free, &benchmark_coap_tx, &benchmark_coap_rx);
+        if (!bench.coap) {
+            printf("Init failed\n");
+            exit(1);
+        }
+        sn_coap_protocol_set_retransmission_buffer(bench.coap, fill_levels[i], 0);
+        for (j = 0; j < fill_levels[i]; j++) {
+            confirmable.msg_id = (uint16_t)(2000 + j);
+            sn_coap_protocol_build(bench.coap, &peer, bench.packet, &confirmable, NULL);
+        }
+        ack.msg_id = 3000;
+        bench.packet_len = (uint16_t)sn_coap_builder_2(bench.packet, &ack, 0);
+        snprintf(name, sizeof(name), "protocol_parse/retransmissions_%u", fill_levels[i]);
+        benchmark_run(name, &benchmark_protocol_ack_op, &bench);
+        sn_coap_protocol_destroy(bench.coap);
+    }
+}
+
+static struct nsdl_s *benchmark_create_nsdl(uint32_t resource_count)
+{
+    struct nsdl_s *handle = sn_nsdl_init(&benchmark_nsdl_tx, &benchmark_nsdl_rx, &benchmark_alloc, &benchmark_free);
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+    uint8_t path[32];
+    uint32_t i;
+
+    if (!handle) {
+        printf("Init failed\n");
+        exit(1);
+    }
+
+    memset(&resource, 0, sizeof(resource));
+    memset(&parameters, 0, sizeof(parameters));
+    resource.resource_parameters_ptr = &parameters;
+    resource.access = (sn_grs_resource_acl_e)SN_GRS_DEFAULT_ACCESS;
+    resource.mode = SN_GRS_DYNAMIC;
+    resource.publish_uri = 1;
+    resource.path = path;
+    parameters.resource_type_ptr = (uint8_t *)"t";
+    parameters.resource_type_len = 1;
+
+    for (i = 0; i < resource_count; i++) {
+        resource.pathlen = (uint16_t)snprintf((char *)path, sizeof(path), "3303/%u/5700", (unsigned)i);
+        if (sn_nsdl_create_resource(handle, &resource) != 0) {
+            printf("Creating resource failed\n");
+            exit(1);
+        }
+    }
+    return handle;
+}
+
+typedef struct benchmark_dispatch_s {
+    struct nsdl_s *handle;
+    uint8_t packet[BENCHMARK_PACKET_MAX];
+    uint16_t packet_len;
+    uint16_t msg_id;
+} benchmark_dispatch_s;
+
+/* Fresh message id every time, so that the request is not answered as a duplicate */
+static void benchmark_dispatch_op(void *context)
+{
+    benchmark_dispatch_s *bench = context;
+
+    bench->msg_id++;
+    bench->packet[2] = (uint8_t)(bench->msg_id >> 8);
+    bench->packet[3] = (uint8_t)bench->msg_id;
+    sn_nsdl_process_coap(bench->handle, bench->packet, bench->packet_len, &peer);
+}
+
+/* Parse, resource lookup, response building and sending of a GET to a static resource */
+static void benchmark_dispatch(void)
+{
+    static benchmark_dispatch_s bench;
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+
+    bench.handle = benchmark_create_nsdl(0);
+    memset(&resource, 0, sizeof(resource));
+    memset(&parameters, 0, sizeof(parameters));
+    resource.resource_parameters_ptr = &parameters;
+    resource.access = SN_GRS_GET_ALLOWED;
+    resource.mode = SN_GRS_STATIC;
+    resource.path = corpus_headers[1].uri_path_ptr;
+    resource.pathlen = corpus_headers[1].uri_path_len;
+    resource.resource = notification_value;
+    resource.resourcelen = sizeof(notification_value) - 1;
+    if (sn_nsdl_create_resource(bench.handle, &resource) != 0) {
+        printf("Creating resource failed\n");
+        exit(1);
+    }
+
+    memcpy(bench.packet, corpus[1].data, corpus[1].len);
+    bench.packet_len = corpus[1].len;
+    bench.msg_id = corpus_headers[1].msg_id;
+    benchmark_run("dispatch/static_get", &benchmark_dispatch_op, &bench);
+    sn_nsdl_destroy(bench.handle);
+}
+
+typedef struct benchmark_grs_s {
+    struct nsdl_s *handle;
+    uint8_t path[32];
+    uint16_t pathlen;
+} benchmark_grs_s;
+
+static void benchmark_grs_search_op(void *context)
+{
+    benchmark_grs_s *bench = context;
+
+    if (!sn_grs_search_resource(bench->handle->grs, bench->pathlen, bench->path, SN_GRS_SEARCH_METHOD)) {
+        printf("Resource not found\n");
+        exit(1);
+    }
+}
+
+static void benchmark_registration_body_op(void *context)
+{
+    benchmark_grs_s *bench = context;
+    sn_coap_hdr_s message;
+
+    memset(&message, 0, sizeof(message));
+    if (sn_nsdl_build_registration_body(bench->handle, &message, 0) != 0) {
+        printf("Building registration body failed\n");
+        exit(1);
+    }
+    bench->handle->sn_nsdl_free(message.payload_ptr);
+}
+
+static void benchmark_resources(void)
+{
+    static const uint32_t resource_counts[] = {10, 100, 1000, 10000};
+    benchmark_grs_s bench;
+    char name[64];
+    unsigned i;
+
+    for (i = 0; i < sizeof(resource_counts) / sizeof(resource_counts[0]); i++) {
+        bench.handle = benchmark_create_nsdl(resource_counts[i]);
+
+        /* Middle and oldest resource, the oldest one is found last */
+        bench.pathlen = (uint16_t)snprintf((char *)bench.path, sizeof(bench.path), "3303/%u/5700", (unsigned)(resource_counts[i] / 2));
+        snprintf(name, sizeof(name), "grs_search/%u/middle", (unsigned)resource_counts[i]);
+        benchmark_run(name, &benchmark_grs_search_op, &bench);
+        bench.pathlen = (uint16_t)snprintf((char *)bench.path, sizeof(bench.path), "3303/0/5700");
+        snprintf(name, sizeof(name), "grs_search/%u/oldest", (unsigned)resource_counts[i]);
+        benchmark_run(name, &benchmark_grs_search_op, &bench);
+
+        /* Body length is limited to 16 bits */
+        if (resource_counts[i] <= 1000) {
+            snprintf(name, sizeof(name), "registration_body/%u", (unsigned)resource_counts[i]);
+            benchmark_run(name, &benchmark_registration_body_op, &bench);
+        }
+        sn_nsdl_destroy(bench.handle);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct coap_s *coap;
+    int i;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp("-time", argv[i])) {
+            min_time_ns = (uint64_t)strtoul(argv[i + 1], NULL, 10) * 1000000u;
+        } else if (!strcmp("-filter", argv[i])) {
+            name_filter = argv[i + 1];
+        } else {
+            break;
+        }
+    }
+    if (i < argc) {
+        printf("Usage: benchmark [-time 200] [-filter parser/]\n");
+        return 1;
+    }
+
+    peer.type = SN_NSDL_ADDRESS_TYPE_IPV6;
+    peer.addr_ptr = peer_address;
+    peer.addr_len = sizeof(peer_address);
+    peer.port = BENCHMARK_PEER_PORT;
+
+    coap = sn_coap_protocol_init(&benchmark_alloc, &benchmark_free, &benchmark_coap_tx, &benchmark_coap_rx);
+    if (!coap) {
+        printf("Init failed\n");
+        return 1;
+    }
+    benchmark_init_corpus();
+
+    benchmark_parser(coap);
+    benchmark_builder();
+    benchmark_protocol();
+    benchmark_dispatch();
+    benchmark_resources();
+
+    sn_coap_protocol_destroy(coap);
+    return over_budget ? 2 : 0;
+}
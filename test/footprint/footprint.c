@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * RAM footprint of one client under one compile-time profile. The library is
+ * compiled into this program with profile definitions, see CMakeLists.txt.
+ * Prints one JSON object:
+ *
+ *   {"profile":"default","text":23456,"data":8,"bss":0,"sizeof_coap_s":96,"sizeof_nsdl_s":160,
+ *    "init_allocs":4,"init_bytes":312,"steady_allocs":21,"steady_bytes":1480,"peak_bytes":2210}
+ *
+ * init_* are objects and bytes left allocated by sn_nsdl_init(). steady_*
+ * are left allocated after the standard workload, and peak_bytes is the
+ * highest amount allocated at once during it. Workload against an in-process
+ * server:
+ *   - FOOTPRINT_RESOURCES observable resources are created and registered,
+ *     Block1 is used when the profile has blockwise transfers
+ *   - FOOTPRINT_REQUESTS confirmable GETs are served
+ *   - FOOTPRINT_NOTIFICATIONS confirmable notifications are sent and acknowledged
+ * Time advances one second per step, so duplicate detection and resending
+ * queues hold what a running client holds.
+ *
+ * Usage: footprint-<profile> [-size text data bss]
+ *   -size     library section sizes, printed as given. footprint_report.sh
+ *             reads them from the profile library.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ns_types.h"
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "sn_grs.h"
+#include "sn_coap_protocol_internal.h"
+#include "alloc_tracker.h"
+
+#ifndef FOOTPRINT_PROFILE
+#define FOOTPRINT_PROFILE           "default"
+#endif
+
+#define FOOTPRINT_RESOURCES         8
+#define FOOTPRINT_REQUESTS          16
+#define FOOTPRINT_NOTIFICATIONS     16
+#define FOOTPRINT_PACKET_MAX        1280
+#define FOOTPRINT_QUEUE_SIZE        8
+
+typedef struct footprint_packet_s {
+    uint8_t data[FOOTPRINT_PACKET_MAX];
+    uint16_t len;
+} footprint_packet_s;
+
+static uint8_t server_address[4] = {10, 0, 0, 1};
+static sn_nsdl_addr_s server;
+static uint8_t location[] = {"rd/footprint"};
+static uint8_t token[] = {0x5a, 0x17, 0xc3, 0x09};
+static uint8_t value[] = {"21.5"};
+static char paths[FOOTPRINT_RESOURCES][16];
+
+/* Datagrams from client, answered by the server after each client call */
+static footprint_packet_s queue[FOOTPRINT_QUEUE_SIZE];
+static uint8_t queue_count;
+
+static struct coap_s *server_coap;
+static uint16_t server_msg_id;
+static uint32_t now;
+
+static void *footprint_server_alloc(sn_coap_len_t size)
+{
+    return size ? malloc(size) : NULL;
+}
+
+static void footprint_server_free(void *ptr)
+{
+    free(ptr);
+}
+
+static uint8_t footprint_server_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)packet_ptr;
+    (void)packet_len;
+    (void)address_ptr;
+    (void)param;
+    return 1;
+}
+
+static uint8_t footprint_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    (void)handle;
+    (void)protocol;
+    (void)address_ptr;
+
+    if (queue_count == FOOTPRINT_QUEUE_SIZE || data_len > FOOTPRINT_PACKET_MAX) {
+        return 0;
+    }
+    memcpy(queue[queue_count].data, data_ptr, data_len);
+    queue[queue_count].len = data_len;
+    queue_count++;
+    return 1;
+}
+
+static uint8_t footprint_nsdl_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    (void)handle;
+    (void)coap_header;
+    (void)address_ptr;
+    return 0;
+}
+
+/* Acknowledges a confirmable datagram of client, NULL if it needs no answer */
+static sn_coap_hdr_s *footprint_server_answer(sn_coap_hdr_s *msg)
+{
+    sn_coap_hdr_s *answer;
+
+    if (msg->msg_type != COAP_MSG_TYPE_CONFIRMABLE) {
+        return NULL;
+    }
+    if (msg->msg_code > COAP_MSG_CODE_REQUEST_DELETE) {
+        /* Notification, empty acknowledgement */
+        answer = sn_coap_build_response(server_coap, msg, COAP_MSG_CODE_EMPTY);
+        if (answer && answer->token_ptr) {
+            server_coap->sn_coap_protocol_free(answer->token_ptr);
+            answer->token_ptr = NULL;
+            answer->token_len = 0;
+        }
+        return answer;
+    }
+
+    /* Registration or its update, Block1 is acknowledged block by block */
+    if (msg->options_list_ptr && msg->options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE &&
+            (msg->options_list_ptr->block1 & 0x08)) {
+        answer = sn_coap_build_response(server_coap, msg, COAP_MSG_CODE_RESPONSE_CONTINUE);
+        if (answer && sn_coap_parser_alloc_options(server_coap, answer)) {
+            answer->options_list_ptr->block1 = msg->options_list_ptr->block1;
+        }
+        return answer;
+    }
+    answer = sn_coap_build_response(server_coap, msg, msg->msg_code == COAP_MSG_CODE_REQUEST_POST &&
+                                    msg->uri_path_len == 2 ? COAP_MSG_CODE_RESPONSE_CREATED : COAP_MSG_CODE_RESPONSE_CHANGED);
+    if (answer && sn_coap_parser_alloc_options(server_coap, answer)) {
+        /* Borrowed, not released with the answer */
+        answer->options_list_ptr->location_path_ptr = location;
+        answer->options_list_ptr->location_path_len = sizeof(location) - 1;
+        if (msg->options_list_ptr && msg->options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE) {
+            answer->options_list_ptr->block1 = msg->options_list_ptr->block1;
+        }
+    }
+    return answer;
+}
+
+/* Server answers queued datagrams until client has nothing more to say */
+static void footprint_deliver(struct nsdl_s *handle)
+{
+    while (queue_count) {
+        footprint_packet_s packet = queue[0];
+        coap_version_e version = COAP_VERSION_UNKNOWN;
+        sn_coap_hdr_s *msg;
+        sn_coap_hdr_s *answer;
+        uint8_t answer_packet[FOOTPRINT_PACKET_MAX];
+        int16_t answer_len = -1;
+
+        queue_count--;
+        memmove(&queue[0], &queue[1], queue_count * sizeof(footprint_packet_s));
+
+        msg = sn_coap_parser(server_coap, packet.len, packet.data, &version);
+        if (!msg) {
+            continue;
+        }
+        answer = msg->coap_status == COAP_STATUS_OK ? footprint_server_answer(msg) : NULL;
+        if (answer) {
+            answer_len = sn_coap_builder_2(answer_packet, answer, 0);
+            if (answer->options_list_ptr) {
+                answer->options_list_ptr->location_path_ptr = NULL;
+            }
+            sn_coap_parser_release_allocated_coap_msg_mem(server_coap, answer);
+        }
+        sn_coap_parser_release_allocated_coap_msg_mem(server_coap, msg);
+
+        if (answer_len > 0) {
+            sn_nsdl_process_coap(handle, answer_packet, (uint16_t)answer_len, &server);
+        }
+    }
+}
+
+static void footprint_step(struct nsdl_s *handle)
+{
+    footprint_deliver(handle);
+    sn_nsdl_exec(handle, ++now);
+    footprint_deliver(handle);
+}
+
+static int footprint_create_resources(struct nsdl_s *handle)
+{
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+    int i;
+
+    for (i = 0; i < FOOTPRINT_RESOURCES; i++) {
+        memset(&resource, 0, sizeof(resource));
+        memset(&parameters, 0, sizeof(parameters));
+        parameters.resource_type_ptr = (uint8_t *)"temperature";
+        parameters.resource_type_len = 11;
+        parameters.observable = 1;
+        resource.resource_parameters_ptr = &parameters;
+        resource.access = SN_GRS_GET_ALLOWED;
+        resource.mode = SN_GRS_STATIC;
+        resource.publish_uri = 1;
+        sprintf(paths[i], "3303/%d/5700", i);
+        resource.path = (uint8_t *)paths[i];
+        resource.pathlen = (uint16_t)strlen(paths[i]);
+        resource.resource = value;
+        resource.resourcelen = sizeof(value) - 1;
+        if (sn_nsdl_create_resource(handle, &resource) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void footprint_request(struct nsdl_s *handle, const char *path)
+{
+    sn_coap_hdr_s msg;
+    uint8_t packet[FOOTPRINT_PACKET_MAX];
+    int16_t packet_len;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    msg.msg_code = COAP_MSG_CODE_REQUEST_GET;
+    msg.msg_id = ++server_msg_id;
+    msg.token_ptr = token;
+    msg.token_len = sizeof(token);
+    msg.uri_path_ptr = (uint8_t *)path;
+    msg.uri_path_len = (uint16_t)strlen(path);
+    msg.content_format = COAP_CT_NONE;
+    packet_len = sn_coap_builder_2(packet, &msg, 0);
+    if (packet_len > 0) {
+        sn_nsdl_process_coap(handle, packet, (uint16_t)packet_len, &server);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct nsdl_s *handle;
+    sn_nsdl_ep_parameters_s endpoint;
+    alloc_tracker_stats_s init_stats;
+    alloc_tracker_stats_s steady_stats;
+    unsigned long text = 0, data = 0, bss = 0;
+    uint32_t leaked;
+    int i;
+
+    if (argc == 5 && !strcmp(argv[1], "-size")) {
+        text = strtoul(argv[2], NULL, 10);
+        data = strtoul(argv[3], NULL, 10);
+        bss = strtoul(argv[4], NULL, 10);
+    } else if (argc != 1) {
+        printf("Usage: %s [-size text data bss]\n", argv[0]);
+        return 1;
+    }
+
+    server_coap = sn_coap_protocol_init(&footprint_server_alloc, &footprint_server_free, &footprint_server_coap_tx, NULL);
+    if (!server_coap) {
+        return 1;
+    }
+    server.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    server.addr_ptr = server_address;
+    server.addr_len = sizeof(server_address);
+    server.port = 5683;
+
+    /* Tracker is not restarted, so later snapshots include the handle */
+    alloc_tracker_begin();
+    handle = sn_nsdl_init(&footprint_nsdl_tx, &footprint_nsdl_rx, &alloc_tracker_alloc, &alloc_tracker_free);
+    if (!handle) {
+        return 1;
+    }
+    set_NSP_address(handle, server_address, server.port, SN_NSDL_ADDRESS_TYPE_IPV4);
+    alloc_tracker_end(&init_stats);
+
+    if (footprint_create_resources(handle) != 0) {
+        fprintf(stderr, "Resource creation failed\n");
+        return 1;
+    }
+
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = (uint8_t *)"footprint-endpoint";
+    endpoint.endpoint_name_len = 18;
+    endpoint.lifetime_ptr = (uint8_t *)"3600";
+    endpoint.lifetime_len = 4;
+    if (!sn_nsdl_register_endpoint(handle, &endpoint)) {
+        fprintf(stderr, "Registration failed\n");
+        return 1;
+    }
+    footprint_step(handle);
+    if (!sn_nsdl_is_ep_registered(handle)) {
+        fprintf(stderr, "Endpoint did not register\n");
+        return 1;
+    }
+
+    for (i = 0; i < FOOTPRINT_REQUESTS; i++) {
+        footprint_request(handle, paths[i % FOOTPRINT_RESOURCES]);
+        footprint_step(handle);
+    }
+    for (i = 0; i < FOOTPRINT_NOTIFICATIONS; i++) {
+        sn_nsdl_send_observation_notification(handle, token, sizeof(token), value, sizeof(value) - 1,
+                                              (sn_coap_observe_e)(i + 1), COAP_MSG_TYPE_CONFIRMABLE, COAP_CT_TEXT_PLAIN);
+        footprint_step(handle);
+    }
+    alloc_tracker_end(&steady_stats);
+
+    sn_nsdl_destroy(handle);
+    leaked = alloc_tracker_outstanding();
+    sn_coap_protocol_destroy(server_coap);
+
+    printf("{\"profile\":\"%s\",\"text\":%lu,\"data\":%lu,\"bss\":%lu,\"sizeof_coap_s\":%u,\"sizeof_nsdl_s\":%u,"
+           "\"init_allocs\":%d,\"init_bytes\":%d,\"steady_allocs\":%d,\"steady_bytes\":%d,\"peak_bytes\":%u}\n",
+           FOOTPRINT_PROFILE, text, data, bss, (unsigned)sizeof(struct coap_s), (unsigned)sizeof(struct nsdl_s),
+           (int)init_stats.live, (int)init_stats.live_bytes, (int)steady_stats.live, (int)steady_stats.live_bytes,
+           (unsigned)steady_stats.peak_bytes);
+
+    if (leaked) {
+        fprintf(stderr, "%u objects left allocated after sn_nsdl_destroy()\n", (unsigned)leaked);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+#
+# Prints footprint of every profile as JSON lines, see footprint.c.
+# Run by footprint-report target:
+#
+#   footprint_report.sh SIZE PROFILE LIBRARY EXECUTABLE [PROFILE LIBRARY EXECUTABLE]...
+#
+# Section sizes are totals of the profile library, from SIZE (binutils size).
+
+SIZE=$1
+shift
+
+while [ $# -ge 3 ]; do
+    library=$2
+    executable=$3
+    shift 3
+
+    # Last line of "size -t" is totals: text data bss dec hex filename
+    totals=$("$SIZE" -t "$library" | tail -n 1) || exit 1
+    text=$(echo "$totals" | awk '{ print $1 }')
+    data=$(echo "$totals" | awk '{ print $2 }')
+    bss=$(echo "$totals" | awk '{ print $3 }')
+
+    "$executable" -size "$text" "$data" "$bss" || exit $?
+done
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Footprint profile: constrained device, e.g. Cortex-M0 with 16-32 KB RAM.
+ * Small blocks, one message in each queue, no bootstrap.
+ */
+
+#ifndef FOOTPRINT_PROFILE_CONSTRAINED_H
+#define FOOTPRINT_PROFILE_CONSTRAINED_H
+
+#define SN_COAP_DUPLICATION_MAX_MSGS_COUNT      1
+#define SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE      64
+#define SN_COAP_RESENDING_QUEUE_SIZE_MSGS       1
+#define SN_COAP_RESENDING_QUEUE_SIZE_BYTES      0
+#define MBED_CLIENT_DISABLE_BOOTSTRAP_FEATURE
+
+#endif // FOOTPRINT_PROFILE_CONSTRAINED_H
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Footprint profile: library defaults from sn_config.h.
+ * Duplicate detection of 1 message, no blockwise, resending of 2 messages.
+ */
+
+#ifndef FOOTPRINT_PROFILE_DEFAULT_H
+#define FOOTPRINT_PROFILE_DEFAULT_H
+
+#endif // FOOTPRINT_PROFILE_DEFAULT_H
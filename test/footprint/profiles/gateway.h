@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Footprint profile: gateway or Linux device. Largest blocks and the largest
+ * queues the library API allows.
+ */
+
+#ifndef FOOTPRINT_PROFILE_GATEWAY_H
+#define FOOTPRINT_PROFILE_GATEWAY_H
+
+#define SN_COAP_DUPLICATION_MAX_MSGS_COUNT      6
+#define SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE      1024
+#define SN_COAP_RESENDING_QUEUE_SIZE_MSGS       6
+#define SN_COAP_RESENDING_QUEUE_SIZE_BYTES      0
+
+#endif // FOOTPRINT_PROFILE_GATEWAY_H
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Footprint profile: smallest client. Every optional feature is off,
+ * application must handle retransmissions and large payloads itself.
+ */
+
+#ifndef FOOTPRINT_PROFILE_MINIMAL_H
+#define FOOTPRINT_PROFILE_MINIMAL_H
+
+#define SN_COAP_DUPLICATION_MAX_MSGS_COUNT      0
+#define SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE      0
+#define SN_COAP_RESENDING_QUEUE_SIZE_MSGS       0
+#define SN_COAP_RESENDING_QUEUE_SIZE_BYTES      0
+#define COAP_DISABLE_OBS_FEATURE
+#define MBED_CLIENT_DISABLE_BOOTSTRAP_FEATURE
+
+#endif // FOOTPRINT_PROFILE_MINIMAL_H
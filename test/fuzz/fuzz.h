@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FUZZ_H_
+#define FUZZ_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ns_types.h"
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_nsdl_lib.h"
+
+#define FUZZ_MAX_INPUT_LEN      4096    /* Larger inputs are ignored, CoAP over UDP does not get near it */
+
+#define FUZZ_CT_OMA_TLV         99
+#define FUZZ_CT_OMA_PLAIN_TEXT  97
+
+/**
+ * \brief Harness entry point, runs one input. Same as libFuzzer's.
+ *
+ * \return 0 always
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/**
+ * \brief Memory hooks of the harnesses
+ */
+void *fuzz_alloc(sn_coap_len_t size);
+void fuzz_free(void *ptr);
+
+/**
+ * \brief Creates a client that has started OMA bootstrap
+ *
+ * \return Client handle, NULL if out of memory
+ */
+struct nsdl_s *fuzz_nsdl_bootstrap(void);
+
+/**
+ * \brief Delivers a PUT from bootstrap server to client created with fuzz_nsdl_bootstrap()
+ *
+ * \param *handle           Client handle
+ * \param content_format    Content format of the write
+ * \param *path             Uri-Path of the write
+ * \param *payload_ptr      Payload
+ * \param payload_len       Payload length
+ *
+ * \return 0 if the write was delivered, -1 if it could not be built
+ */
+int8_t fuzz_nsdl_bootstrap_write(struct nsdl_s *handle, uint8_t content_format, const char *path,
+                                 const uint8_t *payload_ptr, uint16_t payload_len);
+
+#endif /* FUZZ_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * sn_coap_parser() on raw input. Messages that parse are built again, so
+ * that builder also meets whatever the parser accepted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fuzz.h"
+#include "sn_coap_protocol.h"
+
+static uint8_t fuzz_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)packet_ptr;
+    (void)packet_len;
+    (void)address_ptr;
+    (void)param;
+    return 1;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static struct coap_s *coap;
+    coap_version_e version = COAP_VERSION_UNKNOWN;
+    sn_coap_hdr_s *hdr;
+    uint8_t *packet;
+
+    if (size > FUZZ_MAX_INPUT_LEN) {
+        return 0;
+    }
+    if (!coap) {
+        coap = sn_coap_protocol_init(&fuzz_alloc, &fuzz_free, &fuzz_coap_tx, NULL);
+        if (!coap) {
+            abort();
+        }
+    }
+
+    /* Exact copy, so that reading past the end is caught by sanitizers */
+    packet = malloc(size ? size : 1);
+    if (!packet) {
+        return 0;
+    }
+    memcpy(packet, data, size);
+
+    hdr = sn_coap_parser(coap, (uint16_t)size, packet, &version);
+    if (hdr && hdr->coap_status == COAP_STATUS_OK) {
+        uint16_t built_size = sn_coap_builder_calc_needed_packet_data_size_2(hdr, 0);
+        uint8_t *built = built_size ? malloc(built_size) : NULL;
+
+        if (built) {
+            sn_coap_builder_2(built, hdr, 0);
+            free(built);
+        }
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+    free(packet);
+    return 0;
+}
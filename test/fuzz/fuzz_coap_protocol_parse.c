@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * sn_coap_protocol_parse() on a sequence of datagrams from one peer, so that
+ * duplicate detection, acknowledgements and blockwise reassembly see traffic
+ * across messages. Input is split into datagrams, each prefixed by its length
+ * as 16-bit big endian. Protocol timers advance by one second per datagram.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fuzz.h"
+#include "sn_coap_protocol.h"
+
+static uint8_t peer_address[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01};
+
+static uint8_t fuzz_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)packet_ptr;
+    (void)packet_len;
+    (void)address_ptr;
+    (void)param;
+    return 1;
+}
+
+static int8_t fuzz_coap_rx(sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)coap_header;
+    (void)address_ptr;
+    (void)param;
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    struct coap_s *coap;
+    sn_nsdl_addr_s peer;
+    uint32_t time = 0;
+
+    if (size > FUZZ_MAX_INPUT_LEN) {
+        return 0;
+    }
+    coap = sn_coap_protocol_init(&fuzz_alloc, &fuzz_free, &fuzz_coap_tx, &fuzz_coap_rx);
+    if (!coap) {
+        return 0;
+    }
+    memset(&peer, 0, sizeof(peer));
+    peer.type = SN_NSDL_ADDRESS_TYPE_IPV6;
+    peer.addr_ptr = peer_address;
+    peer.addr_len = sizeof(peer_address);
+    peer.port = 5683;
+
+    while (size >= 2) {
+        uint16_t packet_len = (uint16_t)(data[0] << 8 | data[1]);
+        uint8_t *packet;
+        sn_coap_hdr_s *hdr;
+
+        data += 2;
+        size -= 2;
+        if (packet_len > size) {
+            packet_len = (uint16_t)size;
+        }
+
+        /* Exact copy, so that reading past the end is caught by sanitizers */
+        packet = malloc(packet_len ? packet_len : 1);
+        if (!packet) {
+            break;
+        }
+        memcpy(packet, data, packet_len);
+        hdr = sn_coap_protocol_parse(coap, &peer, packet_len, packet, NULL);
+        sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+        free(packet);
+
+        data += packet_len;
+        size -= packet_len;
+        sn_coap_protocol_exec(coap, ++time);
+    }
+
+    sn_coap_protocol_destroy(coap);
+    return 0;
+}
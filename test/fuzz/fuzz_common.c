@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Shared parts of the harnesses. OMA TLV and LwM2M server URI parsing are
+ * internal to sn_nsdl.c, so they are reached the same way the bootstrap
+ * server reaches them: through writes to a client in bootstrap.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fuzz.h"
+#include "sn_coap_protocol.h"
+
+#define FUZZ_BOOTSTRAP_PORT     5693
+
+static uint8_t bootstrap_address[4] = {10, 0, 0, 2};
+static uint8_t endpoint_name[] = {"fuzz-endpoint"};
+
+void *fuzz_alloc(sn_coap_len_t size)
+{
+    return size ? malloc(size) : NULL;
+}
+
+void fuzz_free(void *ptr)
+{
+    free(ptr);
+}
+
+static uint8_t fuzz_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    (void)handle;
+    (void)protocol;
+    (void)data_ptr;
+    (void)data_len;
+    (void)address_ptr;
+    return 1;
+}
+
+static uint8_t fuzz_nsdl_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    (void)handle;
+    (void)coap_header;
+    (void)address_ptr;
+    return 0;
+}
+
+static void fuzz_nsdl_bootstrap_done(sn_nsdl_oma_server_info_t *server_info_ptr)
+{
+    (void)server_info_ptr;
+}
+
+static void fuzz_nsdl_address(sn_nsdl_addr_s *address)
+{
+    memset(address, 0, sizeof(sn_nsdl_addr_s));
+    address->type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    address->addr_ptr = bootstrap_address;
+    address->addr_len = sizeof(bootstrap_address);
+    address->port = FUZZ_BOOTSTRAP_PORT;
+}
+
+struct nsdl_s *fuzz_nsdl_bootstrap(void)
+{
+    static sn_nsdl_oma_device_t device_object;
+    struct nsdl_s *handle = sn_nsdl_init(&fuzz_nsdl_tx, &fuzz_nsdl_rx, &fuzz_alloc, &fuzz_free);
+    sn_nsdl_ep_parameters_s endpoint;
+    sn_nsdl_bs_ep_info_t bootstrap_info;
+    sn_nsdl_addr_s address;
+
+    if (!handle) {
+        return NULL;
+    }
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = endpoint_name;
+    endpoint.endpoint_name_len = sizeof(endpoint_name) - 1;
+    memset(&bootstrap_info, 0, sizeof(bootstrap_info));
+    bootstrap_info.oma_bs_status_cb = &fuzz_nsdl_bootstrap_done;
+    bootstrap_info.device_object = &device_object;
+    fuzz_nsdl_address(&address);
+
+    if (!sn_nsdl_oma_bootstrap(handle, &address, &endpoint, &bootstrap_info)) {
+        sn_nsdl_destroy(handle);
+        return NULL;
+    }
+    return handle;
+}
+
+int8_t fuzz_nsdl_bootstrap_write(struct nsdl_s *handle, uint8_t content_format, const char *path,
+                                 const uint8_t *payload_ptr, uint16_t payload_len)
+{
+    static uint16_t msg_id;
+    sn_coap_hdr_s msg;
+    sn_nsdl_addr_s address;
+    uint8_t *packet;
+    uint16_t packet_size;
+    int16_t packet_len;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    msg.msg_code = COAP_MSG_CODE_REQUEST_PUT;
+    msg.msg_id = ++msg_id;
+    msg.uri_path_ptr = (uint8_t *)path;
+    msg.uri_path_len = (uint16_t)strlen(path);
+    msg.content_format = (sn_coap_content_format_e)content_format;
+    msg.payload_ptr = (uint8_t *)payload_ptr;
+    msg.payload_len = payload_len;
+
+    /* Whole payload in one message, also when blockwise transfers are compiled in */
+    packet_size = sn_coap_builder_calc_needed_packet_data_size_2(&msg, 0);
+    packet = packet_size ? malloc(packet_size) : NULL;
+    if (!packet) {
+        return -1;
+    }
+    packet_len = sn_coap_builder_2(packet, &msg, 0);
+    if (packet_len > 0) {
+        fuzz_nsdl_address(&address);
+        sn_nsdl_process_coap(handle, packet, (uint16_t)packet_len, &address);
+    }
+    free(packet);
+    return packet_len > 0 ? 0 : -1;
+}
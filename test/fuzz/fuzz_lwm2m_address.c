@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * LwM2M server URI parsing, sn_nsdl_resolve_lwm2m_address() inside the
+ * library. Input is the payload of a plain text write of the server URI
+ * resource from the bootstrap server.
+ */
+
+#include "fuzz.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    struct nsdl_s *handle;
+
+    if (size > FUZZ_MAX_INPUT_LEN) {
+        return 0;
+    }
+    handle = fuzz_nsdl_bootstrap();
+    if (!handle) {
+        return 0;
+    }
+    fuzz_nsdl_bootstrap_write(handle, FUZZ_CT_OMA_PLAIN_TEXT, "0/0/0", data, (uint16_t)size);
+    sn_nsdl_destroy(handle);
+    return 0;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Driver of the fuzz harnesses when they are not linked with libFuzzer.
+ * Runs given files, and all files of given directories, through the harness
+ * once, which replays a corpus or a crash. Without arguments the input is
+ * read from stdin. AFL runs the harness built with afl-gcc as:
+ *
+ *   afl-fuzz -i corpus/coap_parser -o findings -- ./fuzz-coap-parser @@
+ *
+ * In replay mode every input is run repeatedly for the given time, and
+ * time per input and the whole corpus throughput are printed as JSON lines:
+ *
+ *   {"name":"coap_parser/many_options","iterations":8192,"ns_per_op":24517.0}
+ *   {"name":"coap_parser","inputs":12,"packets_per_s":412000.0,"worst_ns_per_op":24517.0,"worst_input":"many_options"}
+ *
+ * Usage: fuzz-<target> [-replay ms] [-max-us us] [FILE|DIR]...
+ *   -replay   replays each input for at least given time in milliseconds
+ *   -max-us   exit status is 2 if any input takes longer per run
+ */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "fuzz.h"
+
+typedef struct fuzz_input_s {
+    char *path;
+    const char *name;
+    uint8_t *data;
+    size_t size;
+} fuzz_input_s;
+
+static fuzz_input_s *inputs;
+static size_t input_count;
+static size_t input_size;
+
+static uint64_t fuzz_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int fuzz_read(FILE *file, fuzz_input_s *input)
+{
+    size_t size = 0;
+    uint8_t *data = NULL;
+
+    for (;;) {
+        uint8_t *grown = realloc(data, size + 4096);
+        size_t read_len;
+
+        if (!grown) {
+            free(data);
+            return -1;
+        }
+        data = grown;
+        read_len = fread(data + size, 1, 4096, file);
+        size += read_len;
+        if (read_len < 4096) {
+            break;
+        }
+    }
+    input->data = data;
+    input->size = size;
+    return 0;
+}
+
+static int fuzz_add_file(const char *path)
+{
+    fuzz_input_s *input;
+    FILE *file;
+    const char *slash;
+
+    if (input_count == input_size) {
+        fuzz_input_s *grown = realloc(inputs, (input_size * 2 + 16) * sizeof(fuzz_input_s));
+
+        if (!grown) {
+            return -1;
+        }
+        inputs = grown;
+        input_size = input_size * 2 + 16;
+    }
+    input = &inputs[input_count];
+    memset(input, 0, sizeof(fuzz_input_s));
+
+    file = fopen(path, "rb");
+    input->path = strdup(path);
+    if (!file || !input->path || fuzz_read(file, input) != 0) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        if (file) {
+            fclose(file);
+        }
+        free(input->path);
+        return -1;
+    }
+    fclose(file);
+    slash = strrchr(input->path, '/');
+    input->name = slash ? slash + 1 : input->path;
+    input_count++;
+    return 0;
+}
+
+static int fuzz_compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Directory entries are sorted, so that output is the same on every run */
+static int fuzz_add_dir(const char *path)
+{
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    char **names = NULL;
+    size_t name_count = 0;
+    size_t i;
+    int ret_val = 0;
+
+    if (!dir) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        char **grown;
+
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        grown = realloc(names, (name_count + 1) * sizeof(char *));
+        if (!grown) {
+            ret_val = -1;
+            break;
+        }
+        names = grown;
+        names[name_count] = malloc(strlen(path) + strlen(entry->d_name) + 2);
+        if (!names[name_count]) {
+            ret_val = -1;
+            break;
+        }
+        sprintf(names[name_count++], "%s/%s", path, entry->d_name);
+    }
+    closedir(dir);
+
+    if (name_count) {
+        qsort(names, name_count, sizeof(char *), &fuzz_compare_names);
+    }
+    for (i = 0; i < name_count; i++) {
+        if (ret_val == 0) {
+            ret_val = fuzz_add_file(names[i]);
+        }
+        free(names[i]);
+    }
+    free(names);
+    return ret_val;
+}
+
+/* Target name from the executable name, fuzz-coap-parser is coap_parser */
+static void fuzz_target_name(const char *argv0, char *name, size_t name_size)
+{
+    const char *base = strrchr(argv0, '/');
+    size_t i;
+
+    base = base ? base + 1 : argv0;
+    if (!strncmp(base, "fuzz-", 5) || !strncmp(base, "fuzz_", 5)) {
+        base += 5;
+    }
+    for (i = 0; i + 1 < name_size && base[i]; i++) {
+        name[i] = base[i] == '-' ? '_' : base[i];
+    }
+    name[i] = '\0';
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t replay_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t total_ns = 0;
+    uint64_t total_iterations = 0;
+    double worst_ns_per_op = 0;
+    const char *worst_input = "";
+    char target[64];
+    int over_limit = 0;
+    int i;
+    size_t j;
+
+    for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (!strcmp("-replay", argv[i])) {
+            replay_ns = (uint64_t)strtoul(argv[i + 1], NULL, 10) * 1000000u;
+        } else if (!strcmp("-max-us", argv[i])) {
+            max_ns = (uint64_t)strtoul(argv[i + 1], NULL, 10) * 1000u;
+        } else {
+            break;
+        }
+    }
+    if (i < argc && argv[i][0] == '-') {
+        printf("Usage: %s [-replay ms] [-max-us us] [FILE|DIR]...\n", argv[0]);
+        return 1;
+    }
+
+    if (i == argc) {
+        inputs = calloc(1, sizeof(fuzz_input_s));
+        if (!inputs || fuzz_read(stdin, inputs) != 0) {
+            return 1;
+        }
+        inputs->name = "stdin";
+        input_count = 1;
+    }
+    for (; i < argc; i++) {
+        struct stat st;
+        int ret_val;
+
+        if (stat(argv[i], &st) != 0) {
+            fprintf(stderr, "Cannot open %s\n", argv[i]);
+            return 1;
+        }
+        ret_val = S_ISDIR(st.st_mode) ? fuzz_add_dir(argv[i]) : fuzz_add_file(argv[i]);
+        if (ret_val != 0) {
+            return 1;
+        }
+    }
+
+    fuzz_target_name(argv[0], target, sizeof(target));
+    for (j = 0; j < input_count; j++) {
+        fuzz_input_s *input = &inputs[j];
+        uint64_t iterations = 1;
+        uint64_t elapsed_ns;
+        double ns_per_op;
+
+        /* First run alone, it is the crash check and warms up */
+        elapsed_ns = fuzz_now_ns();
+        LLVMFuzzerTestOneInput(input->data, input->size);
+        elapsed_ns = fuzz_now_ns() - elapsed_ns;
+
+        /* Iteration count doubles until one batch takes at least replay time */
+        while (replay_ns && elapsed_ns < replay_ns && iterations < (UINT64_C(1) << 40)) {
+            uint64_t k;
+
+            iterations *= 2;
+            elapsed_ns = fuzz_now_ns();
+            for (k = 0; k < iterations; k++) {
+                LLVMFuzzerTestOneInput(input->data, input->size);
+            }
+            elapsed_ns = fuzz_now_ns() - elapsed_ns;
+        }
+
+        ns_per_op = (double)elapsed_ns / iterations;
+        total_ns += elapsed_ns;
+        total_iterations += iterations;
+        if (ns_per_op > worst_ns_per_op) {
+            worst_ns_per_op = ns_per_op;
+            worst_input = input->name;
+        }
+        if (max_ns && ns_per_op > max_ns) {
+            fprintf(stderr, "%s: %.0f ns per run, limit is %llu ns\n", input->name, ns_per_op, (unsigned long long)max_ns);
+            over_limit = 1;
+        }
+        if (replay_ns) {
+            printf("{\"name\":\"%s/%s\",\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+                   target, input->name, (unsigned long long)iterations, ns_per_op);
+            fflush(stdout);
+        }
+    }
+
+    if (replay_ns && total_ns) {
+        printf("{\"name\":\"%s\",\"inputs\":%u,\"packets_per_s\":%.1f,\"worst_ns_per_op\":%.1f,\"worst_input\":\"%s\"}\n",
+               target, (unsigned)input_count, (double)total_iterations * 1e9 / total_ns, worst_ns_per_op, worst_input);
+    } else if (!replay_ns) {
+        printf("%u inputs\n", (unsigned)input_count);
+    }
+
+    for (j = 0; j < input_count; j++) {
+        free(inputs[j].path);
+        free(inputs[j].data);
+    }
+    free(inputs);
+    return over_limit ? 2 : 0;
+}
@@ -0,0 +1,576 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* SOL_UDP */
+#endif
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "ns_list.h"
+#include "linux_udp_driver.h"
+#include "linux_udp_driver_internal.h"
+
+#define LINUX_UDP_HASH_MIN_SIZE     64
+
+/* nsdl TX callback has no context, so the driver of the calling thread is used */
+static __thread struct linux_udp_driver_s *linux_udp_thread_driver;
+
+static uint32_t linux_udp_hash(const struct nsdl_s *handle, uint32_t hash_size)
+{
+    uintptr_t key = (uintptr_t)handle;
+    key ^= key >> 17;
+    key *= 0x9E3779B1u;
+    return (uint32_t)(key >> 7) & (hash_size - 1);
+}
+
+static int linux_udp_hash_resize(struct linux_udp_driver_s *driver, uint32_t new_size)
+{
+    struct linux_udp_endpoint_s **new_hash = calloc(new_size, sizeof(struct linux_udp_endpoint_s *));
+    if (!new_hash) {
+        return -1;
+    }
+
+    ns_list_foreach(struct linux_udp_endpoint_s, endpoint, &driver->endpoints) {
+        uint32_t index = linux_udp_hash(endpoint->handle, new_size);
+        endpoint->hash_next = new_hash[index];
+        new_hash[index] = endpoint;
+    }
+
+    free(driver->hash);
+    driver->hash = new_hash;
+    driver->hash_size = new_size;
+    return 0;
+}
+
+static struct linux_udp_endpoint_s *linux_udp_find(struct linux_udp_driver_s *driver, const struct nsdl_s *handle)
+{
+    if (driver->current && driver->current->handle == handle) {
+        return driver->current;
+    }
+
+    struct linux_udp_endpoint_s *endpoint = driver->hash[linux_udp_hash(handle, driver->hash_size)];
+    while (endpoint && endpoint->handle != handle) {
+        endpoint = endpoint->hash_next;
+    }
+    return endpoint;
+}
+
+static void linux_udp_mark_dirty(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    if (!endpoint->dirty) {
+        endpoint->dirty = 1;
+        endpoint->dirty_next = driver->dirty_list;
+        driver->dirty_list = endpoint;
+    }
+}
+
+/* Reads deadline of one endpoint and keeps earliest deadline of the driver up to date */
+static void linux_udp_update_deadline(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint, uint32_t now)
+{
+    uint32_t old_deadline = endpoint->deadline;
+    uint32_t deadline = 0;
+
+    if (sn_nsdl_get_next_deadline(endpoint->handle, &deadline) != 0) {
+        deadline = endpoint->received ? now + LINUX_UDP_IDLE_EXEC_INTERVAL : 0;
+    }
+    endpoint->deadline = deadline;
+
+    if (deadline && (!driver->next_deadline || deadline < driver->next_deadline)) {
+        driver->next_deadline = deadline;
+    } else if (old_deadline && old_deadline == driver->next_deadline && deadline != old_deadline) {
+        driver->rescan = 1;
+    }
+}
+
+static void linux_udp_update_deadlines(struct linux_udp_driver_s *driver)
+{
+    uint32_t now = linux_udp_driver_time(driver);
+
+    while (driver->dirty_list) {
+        struct linux_udp_endpoint_s *endpoint = driver->dirty_list;
+        driver->dirty_list = endpoint->dirty_next;
+        endpoint->dirty = 0;
+        linux_udp_update_deadline(driver, endpoint, now);
+    }
+
+    if (driver->rescan) {
+        driver->rescan = 0;
+        driver->next_deadline = 0;
+        ns_list_foreach(struct linux_udp_endpoint_s, endpoint, &driver->endpoints) {
+            if (endpoint->deadline && (!driver->next_deadline || endpoint->deadline < driver->next_deadline)) {
+                driver->next_deadline = endpoint->deadline;
+            }
+        }
+    }
+}
+
+/* Milliseconds until earliest deadline, limited to timeout_ms */
+static int linux_udp_wait_timeout(struct linux_udp_driver_s *driver, int timeout_ms)
+{
+    struct timespec now;
+    int64_t due_ms;
+
+    if (!driver->next_deadline) {
+        return timeout_ms;
+    }
+
+    /* Deadline is reached when driver time turns to it, nanoseconds are rounded down so wakeup is never early */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    due_ms = ((int64_t)driver->time_base + driver->next_deadline - 1 - now.tv_sec) * 1000 - now.tv_nsec / 1000000;
+    if (due_ms < 0) {
+        due_ms = 0;
+    }
+    if (timeout_ms < 0 || due_ms < timeout_ms) {
+        return (int)due_ms;
+    }
+    return timeout_ms;
+}
+
+/* Executes every endpoint whose deadline has passed */
+static void linux_udp_exec_due(struct linux_udp_driver_s *driver)
+{
+    uint32_t now = linux_udp_driver_time(driver);
+
+    if (!driver->next_deadline || driver->next_deadline > now) {
+        return;
+    }
+
+    driver->next_deadline = 0;
+    ns_list_foreach(struct linux_udp_endpoint_s, endpoint, &driver->endpoints) {
+        if (endpoint->deadline && endpoint->deadline <= now) {
+            driver->current = endpoint;
+            endpoint->received = 0;
+            sn_nsdl_exec(endpoint->handle, now);
+            driver->stats.exec_calls++;
+            linux_udp_mark_dirty(driver, endpoint);
+        } else if (endpoint->deadline && (!driver->next_deadline || endpoint->deadline < driver->next_deadline)) {
+            driver->next_deadline = endpoint->deadline;
+        }
+    }
+    driver->current = NULL;
+}
+
+static int linux_udp_to_sockaddr(const struct linux_udp_endpoint_s *endpoint, const sn_nsdl_addr_s *address_ptr,
+                                 struct sockaddr_storage *addr, socklen_t *addr_len)
+{
+    memset(addr, 0, sizeof(*addr));
+
+    if (endpoint->family == AF_INET) {
+        struct sockaddr_in *sin = (struct sockaddr_in *)addr;
+        if (address_ptr->addr_len != 4) {
+            return -1;
+        }
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(address_ptr->port);
+        memcpy(&sin->sin_addr, address_ptr->addr_ptr, 4);
+        *addr_len = sizeof(struct sockaddr_in);
+    } else {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)addr;
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(address_ptr->port);
+        if (address_ptr->addr_len == 4) {
+            /* IPv4 peer through dual stack socket */
+            sin6->sin6_addr.s6_addr[10] = 0xff;
+            sin6->sin6_addr.s6_addr[11] = 0xff;
+            memcpy(&sin6->sin6_addr.s6_addr[12], address_ptr->addr_ptr, 4);
+        } else if (address_ptr->addr_len == 16) {
+            memcpy(&sin6->sin6_addr, address_ptr->addr_ptr, 16);
+        } else {
+            return -1;
+        }
+        *addr_len = sizeof(struct sockaddr_in6);
+    }
+    return 0;
+}
+
+static void linux_udp_from_sockaddr(const struct sockaddr_storage *addr, sn_nsdl_addr_s *address_ptr)
+{
+    if (addr->ss_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)addr;
+        address_ptr->type = SN_NSDL_ADDRESS_TYPE_IPV4;
+        address_ptr->addr_len = 4;
+        address_ptr->addr_ptr = (uint8_t *)&sin->sin_addr;
+        address_ptr->port = ntohs(sin->sin_port);
+    } else {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)addr;
+        address_ptr->port = ntohs(sin6->sin6_port);
+        if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr)) {
+            address_ptr->type = SN_NSDL_ADDRESS_TYPE_IPV4;
+            address_ptr->addr_len = 4;
+            address_ptr->addr_ptr = (uint8_t *)&sin6->sin6_addr.s6_addr[12];
+        } else {
+            address_ptr->type = SN_NSDL_ADDRESS_TYPE_IPV6;
+            address_ptr->addr_len = 16;
+            address_ptr->addr_ptr = (uint8_t *)&sin6->sin6_addr;
+        }
+    }
+}
+
+void linux_udp_deliver(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint,
+                       uint8_t *data, uint32_t len, uint16_t segment_size, const struct sockaddr *addr)
+{
+    sn_nsdl_addr_s src;
+
+    memset(&src, 0, sizeof(src));
+    linux_udp_from_sockaddr((const struct sockaddr_storage *)addr, &src);
+
+    if (!segment_size || segment_size > len) {
+        segment_size = (uint16_t)len;
+    }
+
+    driver->current = endpoint;
+    while (len) {
+        uint16_t datagram_len = len < segment_size ? (uint16_t)len : segment_size;
+        driver->stats.rx_datagrams++;
+        sn_nsdl_process_coap(endpoint->handle, data, datagram_len, &src);
+        data += datagram_len;
+        len -= datagram_len;
+    }
+    driver->current = NULL;
+
+    endpoint->received = 1;
+    linux_udp_mark_dirty(driver, endpoint);
+}
+
+uint16_t linux_udp_gro_segment_size(struct msghdr *msg)
+{
+    struct cmsghdr *cmsg;
+
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int segment_size;
+            memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+            return (uint16_t)segment_size;
+        }
+    }
+    return 0;
+}
+
+uint16_t linux_udp_gso_count(const struct linux_udp_driver_s *driver, uint16_t start)
+{
+    const linux_udp_tx_slot_s *first = &driver->tx_slots[start];
+    uint32_t total = first->len;
+    uint16_t end = start + 1;
+
+    if (!driver->gso) {
+        return 1;
+    }
+
+    /* Segments must be equal, only the last one may be shorter */
+    while (end < driver->tx_count && end - start < LINUX_UDP_GSO_MAX_SEGMENTS) {
+        const linux_udp_tx_slot_s *slot = &driver->tx_slots[end];
+        if (slot->sock != first->sock || slot->len > first->len || total + slot->len > LINUX_UDP_GSO_MAX_BYTES ||
+                slot->addr_len != first->addr_len || memcmp(&slot->addr, &first->addr, first->addr_len) != 0) {
+            break;
+        }
+        total += slot->len;
+        end++;
+        if (slot->len < first->len) {
+            break;
+        }
+    }
+    return end - start;
+}
+
+void linux_udp_gso_control(struct msghdr *msg, uint8_t *control, uint16_t segment_size)
+{
+    struct cmsghdr *cmsg;
+
+    memset(control, 0, LINUX_UDP_GSO_CONTROL_SIZE);
+    msg->msg_control = control;
+    msg->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+    cmsg = CMSG_FIRSTHDR(msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+}
+
+/* UDP_SEGMENT is known since Linux 4.18 */
+static uint8_t linux_udp_gso_supported(void)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    int value = 0;
+    uint8_t supported;
+
+    if (sock < 0) {
+        return 0;
+    }
+    supported = setsockopt(sock, SOL_UDP, UDP_SEGMENT, &value, sizeof(value)) == 0;
+    close(sock);
+    return supported;
+}
+
+struct linux_udp_driver_s *linux_udp_driver_create(void)
+{
+    struct linux_udp_driver_s *driver = calloc(1, sizeof(struct linux_udp_driver_s));
+    struct timespec now;
+
+    if (!driver) {
+        return NULL;
+    }
+
+    ns_list_init(&driver->endpoints);
+    driver->hash = calloc(LINUX_UDP_HASH_MIN_SIZE, sizeof(struct linux_udp_endpoint_s *));
+    driver->hash_size = LINUX_UDP_HASH_MIN_SIZE;
+    if (!driver->hash || linux_udp_backend_create(driver) != 0) {
+        free(driver->hash);
+        free(driver);
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    driver->time_base = now.tv_sec;
+    driver->gso = LINUX_UDP_GSO && linux_udp_gso_supported();
+
+    linux_udp_thread_driver = driver;
+    return driver;
+}
+
+void linux_udp_driver_destroy(struct linux_udp_driver_s *driver)
+{
+    if (!driver) {
+        return;
+    }
+
+    linux_udp_driver_flush(driver);
+    linux_udp_backend_destroy(driver);
+
+    ns_list_foreach_safe(struct linux_udp_endpoint_s, endpoint, &driver->endpoints) {
+        ns_list_remove(&driver->endpoints, endpoint);
+        close(endpoint->sock);
+        free(endpoint);
+    }
+
+    free(driver->hash);
+    if (linux_udp_thread_driver == driver) {
+        linux_udp_thread_driver = NULL;
+    }
+    free(driver);
+}
+
+struct linux_udp_endpoint_s *linux_udp_driver_open(struct linux_udp_driver_s *driver, struct nsdl_s *handle,
+        const struct sockaddr *bind_addr, socklen_t bind_addr_len)
+{
+    struct linux_udp_endpoint_s *endpoint;
+
+    if (!driver || !handle || !bind_addr || linux_udp_find(driver, handle)) {
+        return NULL;
+    }
+    if (bind_addr->sa_family != AF_INET && bind_addr->sa_family != AF_INET6) {
+        return NULL;
+    }
+
+    if (driver->endpoint_count >= driver->hash_size * 2 &&
+            linux_udp_hash_resize(driver, driver->hash_size * 2) != 0) {
+        return NULL;
+    }
+
+    endpoint = calloc(1, sizeof(struct linux_udp_endpoint_s));
+    if (!endpoint) {
+        return NULL;
+    }
+    endpoint->handle = handle;
+    endpoint->family = bind_addr->sa_family;
+
+    endpoint->sock = socket(endpoint->family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (endpoint->sock < 0) {
+        free(endpoint);
+        return NULL;
+    }
+
+#if LINUX_UDP_GRO
+    /* Best effort, without it datagrams just arrive one by one */
+    int gro = 1;
+    setsockopt(endpoint->sock, SOL_UDP, UDP_GRO, &gro, sizeof(gro));
+#endif
+
+    if (bind(endpoint->sock, bind_addr, bind_addr_len) != 0 ||
+            linux_udp_backend_open(driver, endpoint) != 0) {
+        close(endpoint->sock);
+        free(endpoint);
+        return NULL;
+    }
+
+    uint32_t index = linux_udp_hash(handle, driver->hash_size);
+    endpoint->hash_next = driver->hash[index];
+    driver->hash[index] = endpoint;
+    ns_list_add_to_end(&driver->endpoints, endpoint);
+    driver->endpoint_count++;
+
+    return endpoint;
+}
+
+void linux_udp_driver_close(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    struct linux_udp_endpoint_s **prev_ptr;
+
+    if (!driver || !endpoint) {
+        return;
+    }
+
+    linux_udp_driver_flush(driver);
+
+    prev_ptr = &driver->hash[linux_udp_hash(endpoint->handle, driver->hash_size)];
+    while (*prev_ptr && *prev_ptr != endpoint) {
+        prev_ptr = &(*prev_ptr)->hash_next;
+    }
+    if (*prev_ptr) {
+        *prev_ptr = endpoint->hash_next;
+    }
+
+    if (endpoint->dirty) {
+        prev_ptr = &driver->dirty_list;
+        while (*prev_ptr && *prev_ptr != endpoint) {
+            prev_ptr = &(*prev_ptr)->dirty_next;
+        }
+        if (*prev_ptr) {
+            *prev_ptr = endpoint->dirty_next;
+        }
+    }
+
+    if (endpoint->deadline && endpoint->deadline == driver->next_deadline) {
+        driver->rescan = 1;
+    }
+    if (driver->current == endpoint) {
+        driver->current = NULL;
+    }
+
+    linux_udp_backend_close(driver, endpoint);
+    close(endpoint->sock);
+    ns_list_remove(&driver->endpoints, endpoint);
+    driver->endpoint_count--;
+    free(endpoint);
+}
+
+uint8_t linux_udp_driver_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr,
+                            uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    struct linux_udp_driver_s *driver = linux_udp_thread_driver;
+    struct linux_udp_endpoint_s *endpoint;
+    linux_udp_tx_slot_s *slot;
+    (void)protocol;
+
+    if (!driver || !data_ptr || !address_ptr || !address_ptr->addr_ptr || data_len > LINUX_UDP_MAX_DATAGRAM) {
+        return 0;
+    }
+
+    endpoint = linux_udp_find(driver, handle);
+    if (!endpoint) {
+        return 0;
+    }
+
+    if (driver->tx_count == LINUX_UDP_TX_BATCH) {
+        linux_udp_driver_flush(driver);
+    }
+
+    slot = &driver->tx_slots[driver->tx_count];
+    if (linux_udp_to_sockaddr(endpoint, address_ptr, &slot->addr, &slot->addr_len) != 0) {
+        return 0;
+    }
+    slot->sock = endpoint->sock;
+    slot->len = data_len;
+    memcpy(slot->data, data_ptr, data_len);
+    driver->tx_count++;
+
+    /* Sending may have started a retransmission */
+    linux_udp_mark_dirty(driver, endpoint);
+    return 1;
+}
+
+int linux_udp_driver_flush(struct linux_udp_driver_s *driver)
+{
+    int sent;
+
+    if (!driver || !driver->tx_count) {
+        return 0;
+    }
+
+    sent = linux_udp_backend_send(driver);
+    driver->tx_count = 0;
+    return sent;
+}
+
+int linux_udp_driver_run_once(struct linux_udp_driver_s *driver, int timeout_ms)
+{
+    int processed;
+
+    if (!driver) {
+        return -1;
+    }
+    linux_udp_thread_driver = driver;
+
+    /* Work queued by application since last round */
+    linux_udp_driver_flush(driver);
+    linux_udp_update_deadlines(driver);
+    linux_udp_exec_due(driver);
+    linux_udp_driver_flush(driver);
+    linux_udp_update_deadlines(driver);
+
+    processed = linux_udp_backend_wait(driver, linux_udp_wait_timeout(driver, timeout_ms));
+    if (processed < 0) {
+        return -1;
+    }
+
+    linux_udp_exec_due(driver);
+    linux_udp_driver_flush(driver);
+    linux_udp_update_deadlines(driver);
+
+    return processed;
+}
+
+void linux_udp_driver_refresh(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    if (driver && endpoint) {
+        linux_udp_mark_dirty(driver, endpoint);
+    }
+}
+
+uint32_t linux_udp_driver_time(struct linux_udp_driver_s *driver)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec - driver->time_base) + 1;
+}
+
+int linux_udp_driver_get_port(struct linux_udp_endpoint_s *endpoint)
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+
+    if (!endpoint || getsockname(endpoint->sock, (struct sockaddr *)&addr, &addr_len) != 0) {
+        return -1;
+    }
+    if (addr.ss_family == AF_INET) {
+        return ntohs(((struct sockaddr_in *)&addr)->sin_port);
+    }
+    return ntohs(((struct sockaddr_in6 *)&addr)->sin6_port);
+}
+
+void linux_udp_driver_get_stats(struct linux_udp_driver_s *driver, linux_udp_driver_stats_s *stats)
+{
+    if (driver && stats) {
+        *stats = driver->stats;
+    }
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file linux_udp_driver.h
+ *
+ * \brief UDP transport for running many nsdl handles in one Linux thread.
+ *
+ * Each handle gets its own non-blocking socket. Sent datagrams are collected
+ * to a TX ring, which is flushed once per loop round. Instead of calling
+ * sn_nsdl_exec() every second, the driver sleeps until the earliest
+ * sn_nsdl_get_next_deadline() of all handles. Bursts of equal sized datagrams,
+ * like pipelined blocks, are handed to kernel as one buffer with UDP_SEGMENT.
+ *
+ * Two I/O backends are available, chosen at build time:
+ * - linux_udp_epoll.c waits sockets with epoll, receives with recvmmsg() and sends with sendmmsg().
+ * - linux_udp_uring.c uses io_uring: multishot recvmsg into a provided buffer ring, so datagrams
+ *   are parsed where kernel wrote them, and linked sendmsg requests submitted with one system call.
+ *
+ * A driver and all handles added to it must be used from one thread only,
+ * the thread which created the driver.
+ */
+
+#ifndef LINUX_UDP_DRIVER_H_
+#define LINUX_UDP_DRIVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_nsdl_lib.h"
+
+/**
+ * \def LINUX_UDP_RX_BATCH
+ * \brief Count of datagrams received from one socket with one recvmmsg() call.
+ */
+#ifndef LINUX_UDP_RX_BATCH
+#define LINUX_UDP_RX_BATCH              32
+#endif
+
+/**
+ * \def LINUX_UDP_TX_BATCH
+ * \brief Size of TX ring, ring is flushed with sendmmsg() when full and at the end of every loop round.
+ */
+#ifndef LINUX_UDP_TX_BATCH
+#define LINUX_UDP_TX_BATCH              64
+#endif
+
+/**
+ * \def LINUX_UDP_MAX_DATAGRAM
+ * \brief Largest datagram received or sent, must fit biggest block with CoAP header.
+ */
+#ifndef LINUX_UDP_MAX_DATAGRAM
+#define LINUX_UDP_MAX_DATAGRAM          1500
+#endif
+
+/**
+ * \def LINUX_UDP_IDLE_EXEC_INTERVAL
+ * \brief Seconds after which a handle that has received data is executed even if it has no deadline,
+ *        so that stale duplicate and blockwise data gets released.
+ */
+#ifndef LINUX_UDP_IDLE_EXEC_INTERVAL
+#define LINUX_UDP_IDLE_EXEC_INTERVAL    10
+#endif
+
+/**
+ * \def LINUX_UDP_GSO
+ * \brief Sends consecutive equal sized datagrams to the same peer as one UDP_SEGMENT (GSO) buffer.
+ *        Used only if the kernel supports it.
+ */
+#ifndef LINUX_UDP_GSO
+#define LINUX_UDP_GSO                   1
+#endif
+
+/**
+ * \def LINUX_UDP_GRO
+ * \brief Enables UDP_GRO on sockets, so that kernel can give a burst from one peer as one buffer.
+ *        Every receive buffer grows to 64 KiB, size LINUX_UDP_RX_BATCH and LINUX_UDP_URING_BUFFERS accordingly.
+ */
+#ifndef LINUX_UDP_GRO
+#define LINUX_UDP_GRO                   0
+#endif
+
+/**
+ * \def LINUX_UDP_URING_ENTRIES
+ * \brief Submission queue size of io_uring backend.
+ */
+#ifndef LINUX_UDP_URING_ENTRIES
+#define LINUX_UDP_URING_ENTRIES         256
+#endif
+
+/**
+ * \def LINUX_UDP_URING_BUFFERS
+ * \brief Count of receive buffers shared by all sockets in io_uring backend, power of two.
+ */
+#ifndef LINUX_UDP_URING_BUFFERS
+#define LINUX_UDP_URING_BUFFERS         256
+#endif
+
+struct linux_udp_driver_s;
+struct linux_udp_endpoint_s;
+
+/**
+ * \brief Counters of one driver.
+ */
+typedef struct linux_udp_driver_stats_ {
+    uint64_t rx_datagrams;
+    uint64_t rx_syscalls;       /**< recvmmsg() or io_uring_enter() calls returning data */
+    uint64_t tx_datagrams;
+    uint64_t tx_syscalls;       /**< sendmmsg() or io_uring_enter() calls made for sending */
+    uint64_t tx_segmented;      /**< Datagrams sent inside UDP_SEGMENT buffers */
+    uint64_t tx_dropped;        /**< Datagrams kernel did not take, CoAP retransmission recovers them */
+    uint64_t exec_calls;        /**< sn_nsdl_exec() calls made for deadlines */
+    uint64_t wakeups;           /**< Returns from waiting */
+} linux_udp_driver_stats_s;
+
+/**
+ * \fn struct linux_udp_driver_s *linux_udp_driver_create(void)
+ *
+ * \brief Creates driver with its I/O backend. Driver is bound to calling thread.
+ *
+ * \return Pointer to driver, NULL on failure
+ */
+extern struct linux_udp_driver_s *linux_udp_driver_create(void);
+
+/**
+ * \fn void linux_udp_driver_destroy(struct linux_udp_driver_s *driver)
+ *
+ * \brief Flushes pending datagrams and closes all sockets. Added nsdl handles are not destroyed.
+ */
+extern void linux_udp_driver_destroy(struct linux_udp_driver_s *driver);
+
+/**
+ * \fn struct linux_udp_endpoint_s *linux_udp_driver_open(struct linux_udp_driver_s *driver, struct nsdl_s *handle,
+ *                                                       const struct sockaddr *bind_addr, socklen_t bind_addr_len)
+ *
+ * \brief Opens socket for nsdl handle. Handle must be created with linux_udp_driver_tx() as TX callback.
+ *
+ * \param *driver Pointer to driver
+ * \param *handle Pointer to nsdl handle
+ * \param *bind_addr Local address, IPv4 or IPv6. Port 0 lets kernel choose the port.
+ * \param bind_addr_len Length of bind_addr
+ *
+ * \return Pointer to endpoint, NULL on failure
+ */
+extern struct linux_udp_endpoint_s *linux_udp_driver_open(struct linux_udp_driver_s *driver, struct nsdl_s *handle,
+        const struct sockaddr *bind_addr, socklen_t bind_addr_len);
+
+/**
+ * \fn void linux_udp_driver_close(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+ *
+ * \brief Closes socket of an endpoint. Datagrams already queued for it are sent first.
+ */
+extern void linux_udp_driver_close(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint);
+
+/**
+ * \fn uint8_t linux_udp_driver_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr,
+ *                                 uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+ *
+ * \brief TX callback to be given to sn_nsdl_init(). Datagram is copied to TX ring of the driver of calling thread.
+ *
+ * \return 1 if datagram was queued, 0 if handle is unknown or datagram is too big
+ */
+extern uint8_t linux_udp_driver_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr,
+                                   uint16_t data_len, sn_nsdl_addr_s *address_ptr);
+
+/**
+ * \fn int linux_udp_driver_run_once(struct linux_udp_driver_s *driver, int timeout_ms)
+ *
+ * \brief Waits for datagrams or next deadline at most timeout_ms, processes them and flushes TX ring.
+ *        Each ready socket is read once per round, so one busy peer can not starve the others.
+ *
+ * \param timeout_ms Maximum time to wait, -1 waits until something happens
+ *
+ * \return Count of processed datagrams, -1 on failure
+ */
+extern int linux_udp_driver_run_once(struct linux_udp_driver_s *driver, int timeout_ms);
+
+/**
+ * \fn int linux_udp_driver_flush(struct linux_udp_driver_s *driver)
+ *
+ * \brief Sends datagrams queued to TX ring. Needed only when sending outside linux_udp_driver_run_once().
+ *
+ * \return Count of sent datagrams
+ */
+extern int linux_udp_driver_flush(struct linux_udp_driver_s *driver);
+
+/**
+ * \fn void linux_udp_driver_refresh(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+ *
+ * \brief Makes driver read deadline of the handle again. Sending through linux_udp_driver_tx()
+ *        does this automatically, needed only if handle state is changed without sending anything.
+ */
+extern void linux_udp_driver_refresh(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint);
+
+/**
+ * \fn uint32_t linux_udp_driver_time(struct linux_udp_driver_s *driver)
+ *
+ * \brief Returns time in seconds in the time base given to sn_nsdl_exec() by the driver.
+ */
+extern uint32_t linux_udp_driver_time(struct linux_udp_driver_s *driver);
+
+/**
+ * \fn int linux_udp_driver_get_port(struct linux_udp_endpoint_s *endpoint)
+ *
+ * \brief Returns local port of endpoint socket, useful when bound to port 0.
+ */
+extern int linux_udp_driver_get_port(struct linux_udp_endpoint_s *endpoint);
+
+/**
+ * \fn void linux_udp_driver_get_stats(struct linux_udp_driver_s *driver, linux_udp_driver_stats_s *stats)
+ *
+ * \brief Copies driver counters.
+ */
+extern void linux_udp_driver_get_stats(struct linux_udp_driver_s *driver, linux_udp_driver_stats_s *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_UDP_DRIVER_H_ */
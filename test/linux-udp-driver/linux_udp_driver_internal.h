@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file linux_udp_driver_internal.h
+ *
+ * \brief Structures shared by linux_udp_driver.c and the I/O backends.
+ *
+ * linux_udp_driver.c keeps the endpoint table, deadlines and the TX ring.
+ * A backend (linux_udp_epoll.c or linux_udp_uring.c) moves the datagrams.
+ */
+
+#ifndef LINUX_UDP_DRIVER_INTERNAL_H_
+#define LINUX_UDP_DRIVER_INTERNAL_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/socket.h>
+#include "ns_list.h"
+#include "linux_udp_driver.h"
+
+struct linux_udp_endpoint_s {
+    struct nsdl_s               *handle;
+    int                         sock;
+    int                         family;
+    uint32_t                    deadline;       /* 0 when nothing pending */
+    uint8_t                     dirty;          /* Deadline must be read again */
+    uint8_t                     received;       /* Received data after last exec */
+    uint8_t                     rx_armed;       /* Backend has a receive request pending in kernel */
+    struct linux_udp_endpoint_s *hash_next;
+    struct linux_udp_endpoint_s *dirty_next;
+    struct linux_udp_endpoint_s *rx_next;       /* Backend private list */
+    ns_list_link_t              link;
+};
+
+typedef NS_LIST_HEAD(struct linux_udp_endpoint_s, link) linux_udp_endpoint_list_t;
+
+typedef struct linux_udp_tx_slot_ {
+    int                         sock;
+    struct sockaddr_storage     addr;
+    socklen_t                   addr_len;
+    uint16_t                    len;
+    uint8_t                     data[LINUX_UDP_MAX_DATAGRAM];
+} linux_udp_tx_slot_s;
+
+#if LINUX_UDP_GRO
+#define LINUX_UDP_RX_BUFFER_SIZE    65535
+#else
+#define LINUX_UDP_RX_BUFFER_SIZE    LINUX_UDP_MAX_DATAGRAM
+#endif
+
+/* Kernel limits for one UDP_SEGMENT buffer */
+#define LINUX_UDP_GSO_MAX_SEGMENTS  64
+#define LINUX_UDP_GSO_MAX_BYTES     65000
+
+/* Control buffer large enough for UDP_SEGMENT and UDP_GRO */
+#define LINUX_UDP_GSO_CONTROL_SIZE  CMSG_SPACE(sizeof(int))
+
+struct linux_udp_backend_s;
+
+struct linux_udp_driver_s {
+    time_t                      time_base;      /* CLOCK_MONOTONIC seconds of driver time 1 */
+    uint32_t                    next_deadline;  /* Earliest deadline of all endpoints, 0 when none */
+    uint8_t                     rescan;         /* Earliest deadline moved later, all endpoints must be checked */
+
+    linux_udp_endpoint_list_t   endpoints;
+    struct linux_udp_endpoint_s **hash;
+    uint32_t                    hash_size;
+    uint32_t                    endpoint_count;
+    struct linux_udp_endpoint_s *dirty_list;
+    struct linux_udp_endpoint_s *current;       /* Endpoint being processed, most TX is for it */
+
+    linux_udp_tx_slot_s         tx_slots[LINUX_UDP_TX_BATCH];
+    uint16_t                    tx_count;
+    uint8_t                     gso;            /* Kernel supports UDP_SEGMENT */
+
+    struct linux_udp_backend_s  *backend;
+    linux_udp_driver_stats_s    stats;
+};
+
+/* Implemented by linux_udp_driver.c for backends */
+
+/* Gives received datagrams to nsdl handle of the endpoint. With GRO the buffer holds
+ * segment_size long datagrams, last one may be shorter. Zero segment_size means one datagram. */
+void linux_udp_deliver(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint,
+                       uint8_t *data, uint32_t len, uint16_t segment_size, const struct sockaddr *addr);
+
+/* Returns GRO segment size found from control messages, 0 if none */
+uint16_t linux_udp_gro_segment_size(struct msghdr *msg);
+
+/* Returns count of TX slots from start which can be sent as one UDP_SEGMENT buffer, at least 1 */
+uint16_t linux_udp_gso_count(const struct linux_udp_driver_s *driver, uint16_t start);
+
+/* Fills control message of msg with UDP_SEGMENT, control must be LINUX_UDP_GSO_CONTROL_SIZE bytes */
+void linux_udp_gso_control(struct msghdr *msg, uint8_t *control, uint16_t segment_size);
+
+/* Implemented by backend */
+
+int linux_udp_backend_create(struct linux_udp_driver_s *driver);
+
+/* Stops all I/O, sockets are closed by caller afterwards */
+void linux_udp_backend_destroy(struct linux_udp_driver_s *driver);
+
+/* Starts receiving from bound socket of endpoint */
+int linux_udp_backend_open(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint);
+
+/* Stops receiving, after return backend holds no reference to endpoint */
+void linux_udp_backend_close(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint);
+
+/* Sends tx_slots[0 .. tx_count - 1], returns count of sent datagrams */
+int linux_udp_backend_send(struct linux_udp_driver_s *driver);
+
+/* Waits at most timeout_ms, delivers received datagrams and returns their count, -1 on failure */
+int linux_udp_backend_wait(struct linux_udp_driver_s *driver, int timeout_ms);
+
+#endif /* LINUX_UDP_DRIVER_INTERNAL_H_ */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * epoll backend: sockets are waited with epoll, read with recvmmsg()
+ * and TX ring is sent with sendmmsg(). A run of equal sized datagrams
+ * to one peer is one sendmmsg() entry with UDP_SEGMENT.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* recvmmsg, sendmmsg */
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "linux_udp_driver_internal.h"
+
+#define LINUX_UDP_EPOLL_EVENTS      64
+
+struct linux_udp_backend_s {
+    int                         epoll_fd;
+
+    /* RX ring, filled by one recvmmsg() */
+    struct mmsghdr              rx_msgs[LINUX_UDP_RX_BATCH];
+    struct iovec                rx_iov[LINUX_UDP_RX_BATCH];
+    struct sockaddr_storage     rx_addr[LINUX_UDP_RX_BATCH];
+    uint8_t                     rx_control[LINUX_UDP_RX_BATCH][LINUX_UDP_GSO_CONTROL_SIZE];
+    uint8_t                     rx_buf[LINUX_UDP_RX_BATCH][LINUX_UDP_RX_BUFFER_SIZE];
+
+    /* One entry sends one slot, or with UDP_SEGMENT a run of slots */
+    struct mmsghdr              tx_msgs[LINUX_UDP_TX_BATCH];
+    uint16_t                    tx_first[LINUX_UDP_TX_BATCH];
+    uint16_t                    tx_segments[LINUX_UDP_TX_BATCH];
+    uint8_t                     tx_control[LINUX_UDP_TX_BATCH][LINUX_UDP_GSO_CONTROL_SIZE];
+    struct iovec                tx_iov[LINUX_UDP_TX_BATCH];     /* Slot data */
+};
+
+int linux_udp_backend_create(struct linux_udp_driver_s *driver)
+{
+    struct linux_udp_backend_s *backend = calloc(1, sizeof(struct linux_udp_backend_s));
+    int i;
+
+    if (!backend) {
+        return -1;
+    }
+
+    backend->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (backend->epoll_fd < 0) {
+        free(backend);
+        return -1;
+    }
+
+    for (i = 0; i < LINUX_UDP_RX_BATCH; i++) {
+        backend->rx_iov[i].iov_base = backend->rx_buf[i];
+        backend->rx_iov[i].iov_len = LINUX_UDP_RX_BUFFER_SIZE;
+        backend->rx_msgs[i].msg_hdr.msg_iov = &backend->rx_iov[i];
+        backend->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        backend->rx_msgs[i].msg_hdr.msg_name = &backend->rx_addr[i];
+    }
+    for (i = 0; i < LINUX_UDP_TX_BATCH; i++) {
+        backend->tx_iov[i].iov_base = driver->tx_slots[i].data;
+    }
+
+    driver->backend = backend;
+    return 0;
+}
+
+void linux_udp_backend_destroy(struct linux_udp_driver_s *driver)
+{
+    close(driver->backend->epoll_fd);
+    free(driver->backend);
+    driver->backend = NULL;
+}
+
+int linux_udp_backend_open(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = endpoint;
+    return epoll_ctl(driver->backend->epoll_fd, EPOLL_CTL_ADD, endpoint->sock, &event);
+}
+
+void linux_udp_backend_close(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    epoll_ctl(driver->backend->epoll_fd, EPOLL_CTL_DEL, endpoint->sock, NULL);
+}
+
+/* Sends slots of a failed UDP_SEGMENT entry one by one */
+static int linux_udp_epoll_send_segments(struct linux_udp_driver_s *driver, uint16_t first, uint16_t count)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    int sent_total = 0;
+    uint16_t i;
+
+    for (i = first; i < first + count; i++) {
+        struct msghdr msg;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &driver->tx_slots[i].addr;
+        msg.msg_namelen = driver->tx_slots[i].addr_len;
+        msg.msg_iov = &backend->tx_iov[i];
+        msg.msg_iovlen = 1;
+        driver->stats.tx_syscalls++;
+        if (sendmsg(driver->tx_slots[i].sock, &msg, MSG_DONTWAIT) < 0) {
+            driver->stats.tx_dropped++;
+        } else {
+            driver->stats.tx_datagrams++;
+            sent_total++;
+        }
+    }
+    return sent_total;
+}
+
+int linux_udp_backend_send(struct linux_udp_driver_s *driver)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    uint16_t msg_count = 0;
+    uint16_t slot = 0;
+    uint16_t start = 0;
+    int sent_total = 0;
+
+    while (slot < driver->tx_count) {
+        struct msghdr *msg = &backend->tx_msgs[msg_count].msg_hdr;
+        uint16_t segments = linux_udp_gso_count(driver, slot);
+        uint16_t i;
+
+        memset(msg, 0, sizeof(*msg));
+        msg->msg_name = &driver->tx_slots[slot].addr;
+        msg->msg_namelen = driver->tx_slots[slot].addr_len;
+        msg->msg_iov = &backend->tx_iov[slot];
+        msg->msg_iovlen = segments;
+        for (i = slot; i < slot + segments; i++) {
+            backend->tx_iov[i].iov_len = driver->tx_slots[i].len;
+        }
+        if (segments > 1) {
+            linux_udp_gso_control(msg, backend->tx_control[msg_count], driver->tx_slots[slot].len);
+        }
+        backend->tx_first[msg_count] = slot;
+        backend->tx_segments[msg_count] = segments;
+        msg_count++;
+        slot += segments;
+    }
+
+    while (start < msg_count) {
+        /* sendmmsg() takes one socket, so send runs of entries from the same socket */
+        int sock = driver->tx_slots[backend->tx_first[start]].sock;
+        uint16_t end = start;
+        while (end < msg_count && driver->tx_slots[backend->tx_first[end]].sock == sock) {
+            end++;
+        }
+
+        while (start < end) {
+            int sent = sendmmsg(sock, &backend->tx_msgs[start], end - start, MSG_DONTWAIT);
+            int i;
+
+            driver->stats.tx_syscalls++;
+            if (sent <= 0) {
+                if (sent < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (backend->tx_segments[start] > 1) {
+                    /* Segmentation refused, for example datagram is bigger than path MTU */
+                    sent_total += linux_udp_epoll_send_segments(driver, backend->tx_first[start], backend->tx_segments[start]);
+                } else {
+                    /* Socket buffer full or peer unreachable, skip the failing datagram */
+                    driver->stats.tx_dropped++;
+                }
+                start++;
+                continue;
+            }
+            for (i = start; i < start + sent; i++) {
+                driver->stats.tx_datagrams += backend->tx_segments[i];
+                if (backend->tx_segments[i] > 1) {
+                    driver->stats.tx_segmented += backend->tx_segments[i];
+                }
+                sent_total += backend->tx_segments[i];
+            }
+            start += sent;
+        }
+    }
+
+    return sent_total;
+}
+
+/* Reads one batch from endpoint socket */
+static int linux_udp_epoll_receive(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    int count;
+    int i;
+
+    for (i = 0; i < LINUX_UDP_RX_BATCH; i++) {
+        backend->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        backend->rx_msgs[i].msg_hdr.msg_control = backend->rx_control[i];
+        backend->rx_msgs[i].msg_hdr.msg_controllen = LINUX_UDP_GSO_CONTROL_SIZE;
+    }
+
+    count = recvmmsg(endpoint->sock, backend->rx_msgs, LINUX_UDP_RX_BATCH, MSG_DONTWAIT, NULL);
+    if (count <= 0) {
+        return 0;
+    }
+    driver->stats.rx_syscalls++;
+
+    for (i = 0; i < count; i++) {
+        if (backend->rx_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            continue;
+        }
+        linux_udp_deliver(driver, endpoint, backend->rx_buf[i], backend->rx_msgs[i].msg_len,
+                          linux_udp_gro_segment_size(&backend->rx_msgs[i].msg_hdr),
+                          (const struct sockaddr *)&backend->rx_addr[i]);
+    }
+    return count;
+}
+
+int linux_udp_backend_wait(struct linux_udp_driver_s *driver, int timeout_ms)
+{
+    struct epoll_event events[LINUX_UDP_EPOLL_EVENTS];
+    int processed = 0;
+    int count;
+    int i;
+
+    count = epoll_wait(driver->backend->epoll_fd, events, LINUX_UDP_EPOLL_EVENTS, timeout_ms);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    driver->stats.wakeups++;
+
+    for (i = 0; i < count; i++) {
+        processed += linux_udp_epoll_receive(driver, events[i].data.ptr);
+        /* Answers leave while the next socket is read */
+        linux_udp_driver_flush(driver);
+    }
+
+    return processed;
+}
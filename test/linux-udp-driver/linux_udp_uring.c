@@ -0,0 +1,569 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * io_uring backend, needs Linux 6.0 or later.
+ *
+ * Every socket has one multishot recvmsg request, which takes its buffers from
+ * a provided buffer ring shared by all sockets. Received datagram is parsed
+ * straight from the buffer kernel wrote it to, and buffer is given back to the
+ * ring afterwards. TX ring is sent as sendmsg requests, requests of the same
+ * socket are linked to keep their order, and all of them are submitted with
+ * one io_uring_enter(). A run of equal sized datagrams to one peer is one
+ * sendmsg with UDP_SEGMENT.
+ *
+ * Rings are set up with raw system calls so that liburing is not needed.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "linux_udp_driver_internal.h"
+
+#define LINUX_UDP_URING_TX_TAG      1   /* Low byte of sendmsg user_data, receive uses endpoint pointer */
+#define LINUX_UDP_URING_CANCEL_TAG  2
+#define LINUX_UDP_URING_BGID        0
+
+/* Buffer holds struct io_uring_recvmsg_out, source address and payload, rounded to keep addresses aligned */
+#define LINUX_UDP_URING_BUFFER_SIZE ((sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_storage) + \
+                                      LINUX_UDP_GSO_CONTROL_SIZE + LINUX_UDP_RX_BUFFER_SIZE + 63) & ~(size_t)63)
+
+typedef struct linux_udp_uring_rx_ {
+    struct linux_udp_endpoint_s *endpoint;
+    uint8_t                     *data;
+    const struct sockaddr       *addr;
+    uint16_t                    len;
+    uint16_t                    segment_size;   /* GRO segment size, 0 for single datagram */
+    uint16_t                    bid;
+} linux_udp_uring_rx_s;
+
+struct linux_udp_backend_s {
+    int                         ring_fd;
+
+    /* Submission queue */
+    void                        *sq_map;
+    size_t                      sq_map_len;
+    unsigned                    *sq_head;
+    unsigned                    *sq_tail;
+    unsigned                    sq_mask;
+    unsigned                    sq_entries;
+    struct io_uring_sqe         *sqes;
+    size_t                      sqes_len;
+    unsigned                    sqe_tail;       /* Local tail, published at io_uring_enter() */
+    unsigned                    sqe_submitted;
+
+    /* Completion queue */
+    void                        *cq_map;
+    size_t                      cq_map_len;
+    unsigned                    *cq_head;
+    unsigned                    *cq_tail;
+    unsigned                    cq_mask;
+    struct io_uring_cqe         *cqes;
+
+    /* Provided buffers */
+    struct io_uring_buf_ring    *buf_ring;
+    size_t                      buf_ring_len;
+    uint8_t                     *buffers;
+    uint16_t                    buf_tail;
+
+    /* Received datagrams waiting for processing, each holds one buffer */
+    linux_udp_uring_rx_s        rx_pending[LINUX_UDP_URING_BUFFERS];
+    uint16_t                    rx_count;
+    struct linux_udp_endpoint_s *rearm_list;    /* Endpoints whose multishot receive has ended */
+    struct msghdr               rx_msghdr;      /* Only lengths are used by multishot recvmsg */
+
+    /* One sendmsg sends one slot, or with UDP_SEGMENT a run of slots */
+    struct msghdr               tx_msghdr[LINUX_UDP_TX_BATCH];
+    uint8_t                     tx_control[LINUX_UDP_TX_BATCH][LINUX_UDP_GSO_CONTROL_SIZE];
+    struct iovec                tx_iov[LINUX_UDP_TX_BATCH];     /* Slot data */
+    unsigned                    tx_inflight;
+    int                         tx_sent;
+};
+
+static int linux_udp_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int linux_udp_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static uint8_t *linux_udp_uring_buffer(struct linux_udp_backend_s *backend, uint16_t bid)
+{
+    return backend->buffers + (size_t)bid * LINUX_UDP_URING_BUFFER_SIZE;
+}
+
+/* Gives buffer back to kernel, visible after linux_udp_uring_publish_buffers() */
+static void linux_udp_uring_recycle(struct linux_udp_backend_s *backend, uint16_t bid)
+{
+    struct io_uring_buf *buf = &backend->buf_ring->bufs[backend->buf_tail & (LINUX_UDP_URING_BUFFERS - 1)];
+
+    buf->addr = (uintptr_t)linux_udp_uring_buffer(backend, bid);
+    buf->len = LINUX_UDP_URING_BUFFER_SIZE;
+    buf->bid = bid;
+    backend->buf_tail++;
+}
+
+static void linux_udp_uring_publish_buffers(struct linux_udp_backend_s *backend)
+{
+    __atomic_store_n(&backend->buf_ring->tail, backend->buf_tail, __ATOMIC_RELEASE);
+}
+
+/* Submits queued requests and waits until at least min_complete completions are available */
+static int linux_udp_uring_enter(struct linux_udp_backend_s *backend, unsigned min_complete, int timeout_ms)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    unsigned to_submit = backend->sqe_tail - backend->sqe_submitted;
+    unsigned flags = 0;
+    void *argp = NULL;
+    size_t argsz = 0;
+    int ret;
+
+    __atomic_store_n(backend->sq_tail, backend->sqe_tail, __ATOMIC_RELEASE);
+
+    if (min_complete) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_ms >= 0) {
+            memset(&arg, 0, sizeof(arg));
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+            arg.ts = (uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            argp = &arg;
+            argsz = sizeof(arg);
+        }
+    }
+
+    ret = (int)syscall(__NR_io_uring_enter, backend->ring_fd, to_submit, min_complete, flags, argp, argsz);
+    if (ret < 0) {
+        return -errno;
+    }
+    backend->sqe_submitted += ret;
+    return ret;
+}
+
+static struct io_uring_sqe *linux_udp_uring_get_sqe(struct linux_udp_backend_s *backend)
+{
+    struct io_uring_sqe *sqe;
+
+    if (backend->sqe_tail - __atomic_load_n(backend->sq_head, __ATOMIC_ACQUIRE) >= backend->sq_entries) {
+        /* Queue full, let kernel take what is queued */
+        if (linux_udp_uring_enter(backend, 0, 0) < 0 ||
+                backend->sqe_tail - __atomic_load_n(backend->sq_head, __ATOMIC_ACQUIRE) >= backend->sq_entries) {
+            return NULL;
+        }
+    }
+
+    sqe = &backend->sqes[backend->sqe_tail & backend->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    backend->sqe_tail++;
+    return sqe;
+}
+
+static int linux_udp_uring_arm_receive(struct linux_udp_backend_s *backend, struct linux_udp_endpoint_s *endpoint)
+{
+    struct io_uring_sqe *sqe = linux_udp_uring_get_sqe(backend);
+
+    if (!sqe) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = endpoint->sock;
+    sqe->addr = (uintptr_t)&backend->rx_msghdr;
+    sqe->len = 1;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = LINUX_UDP_URING_BGID;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = (uintptr_t)endpoint;
+    endpoint->rx_armed = 1;
+    return 0;
+}
+
+static void linux_udp_uring_handle_receive(struct linux_udp_driver_s *driver, const struct io_uring_cqe *cqe)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    struct linux_udp_endpoint_s *endpoint = (struct linux_udp_endpoint_s *)(uintptr_t)cqe->user_data;
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        uint8_t *buf = linux_udp_uring_buffer(backend, bid);
+        struct io_uring_recvmsg_out *out = (struct io_uring_recvmsg_out *)buf;
+
+        if (cqe->res > 0 && !(out->flags & MSG_TRUNC) && out->payloadlen <= LINUX_UDP_RX_BUFFER_SIZE) {
+            linux_udp_uring_rx_s *rx = &backend->rx_pending[backend->rx_count++];
+            struct msghdr control;
+
+            memset(&control, 0, sizeof(control));
+            control.msg_control = buf + sizeof(*out) + backend->rx_msghdr.msg_namelen;
+            control.msg_controllen = out->controllen;
+
+            rx->endpoint = endpoint;
+            rx->addr = (const struct sockaddr *)(out + 1);
+            rx->data = buf + sizeof(*out) + backend->rx_msghdr.msg_namelen + backend->rx_msghdr.msg_controllen;
+            rx->len = (uint16_t)out->payloadlen;
+            rx->segment_size = linux_udp_gro_segment_size(&control);
+            rx->bid = bid;
+        } else {
+            linux_udp_uring_recycle(backend, bid);
+        }
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        /* Cancelled, out of buffers or failed, restarted after pending datagrams are processed */
+        endpoint->rx_armed = 0;
+        endpoint->rx_next = backend->rearm_list;
+        backend->rearm_list = endpoint;
+    }
+}
+
+/* Takes all available completions, received datagrams are left to rx_pending */
+static void linux_udp_uring_reap(struct linux_udp_driver_s *driver)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    unsigned head = *backend->cq_head;
+    unsigned tail = __atomic_load_n(backend->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &backend->cqes[head & backend->cq_mask];
+
+        if ((cqe->user_data & 0xff) == LINUX_UDP_URING_TX_TAG) {
+            unsigned segments = (unsigned)(cqe->user_data >> 8);
+            backend->tx_inflight--;
+            if (cqe->res < 0) {
+                /* Linked requests after a failed one complete with -ECANCELED */
+                driver->stats.tx_dropped += segments;
+                if (segments > 1 && (cqe->res == -EINVAL || cqe->res == -EIO)) {
+                    /* Segmentation refused, for example datagram is bigger than path MTU.
+                     * Lost datagrams are retransmitted by CoAP, later ones go one by one. */
+                    driver->gso = 0;
+                }
+            } else {
+                driver->stats.tx_datagrams += segments;
+                if (segments > 1) {
+                    driver->stats.tx_segmented += segments;
+                }
+                backend->tx_sent += segments;
+            }
+        } else if (cqe->user_data != LINUX_UDP_URING_CANCEL_TAG) {
+            linux_udp_uring_handle_receive(driver, cqe);
+        }
+        head++;
+    }
+
+    __atomic_store_n(backend->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static void linux_udp_uring_unmap(struct linux_udp_backend_s *backend)
+{
+    if (backend->buf_ring) {
+        munmap(backend->buf_ring, backend->buf_ring_len);
+    }
+    if (backend->sqes) {
+        munmap(backend->sqes, backend->sqes_len);
+    }
+    if (backend->cq_map && backend->cq_map != backend->sq_map) {
+        munmap(backend->cq_map, backend->cq_map_len);
+    }
+    if (backend->sq_map) {
+        munmap(backend->sq_map, backend->sq_map_len);
+    }
+}
+
+static int linux_udp_uring_map(struct linux_udp_backend_s *backend, const struct io_uring_params *params)
+{
+    struct io_uring_buf_reg reg;
+    unsigned *sq_array;
+    unsigned i;
+
+    backend->sq_map_len = params->sq_off.array + params->sq_entries * sizeof(unsigned);
+    backend->cq_map_len = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    if (params->features & IORING_FEAT_SINGLE_MMAP) {
+        if (backend->cq_map_len > backend->sq_map_len) {
+            backend->sq_map_len = backend->cq_map_len;
+        }
+        backend->cq_map_len = backend->sq_map_len;
+    }
+
+    backend->sq_map = mmap(NULL, backend->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           backend->ring_fd, IORING_OFF_SQ_RING);
+    if (backend->sq_map == MAP_FAILED) {
+        backend->sq_map = NULL;
+        return -1;
+    }
+    if (params->features & IORING_FEAT_SINGLE_MMAP) {
+        backend->cq_map = backend->sq_map;
+    } else {
+        backend->cq_map = mmap(NULL, backend->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               backend->ring_fd, IORING_OFF_CQ_RING);
+        if (backend->cq_map == MAP_FAILED) {
+            backend->cq_map = NULL;
+            return -1;
+        }
+    }
+
+    backend->sqes_len = params->sq_entries * sizeof(struct io_uring_sqe);
+    backend->sqes = mmap(NULL, backend->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         backend->ring_fd, IORING_OFF_SQES);
+    if (backend->sqes == MAP_FAILED) {
+        backend->sqes = NULL;
+        return -1;
+    }
+
+    backend->sq_head = (unsigned *)((uint8_t *)backend->sq_map + params->sq_off.head);
+    backend->sq_tail = (unsigned *)((uint8_t *)backend->sq_map + params->sq_off.tail);
+    backend->sq_mask = *(unsigned *)((uint8_t *)backend->sq_map + params->sq_off.ring_mask);
+    backend->sq_entries = params->sq_entries;
+    sq_array = (unsigned *)((uint8_t *)backend->sq_map + params->sq_off.array);
+    for (i = 0; i < params->sq_entries; i++) {
+        sq_array[i] = i;
+    }
+    backend->sqe_tail = *backend->sq_tail;
+    backend->sqe_submitted = backend->sqe_tail;
+
+    backend->cq_head = (unsigned *)((uint8_t *)backend->cq_map + params->cq_off.head);
+    backend->cq_tail = (unsigned *)((uint8_t *)backend->cq_map + params->cq_off.tail);
+    backend->cq_mask = *(unsigned *)((uint8_t *)backend->cq_map + params->cq_off.ring_mask);
+    backend->cqes = (struct io_uring_cqe *)((uint8_t *)backend->cq_map + params->cq_off.cqes);
+
+    /* Provided buffer ring must be page aligned */
+    backend->buf_ring_len = LINUX_UDP_URING_BUFFERS * sizeof(struct io_uring_buf);
+    backend->buf_ring = mmap(NULL, backend->buf_ring_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (backend->buf_ring == MAP_FAILED) {
+        backend->buf_ring = NULL;
+        return -1;
+    }
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uintptr_t)backend->buf_ring;
+    reg.ring_entries = LINUX_UDP_URING_BUFFERS;
+    reg.bgid = LINUX_UDP_URING_BGID;
+    if (linux_udp_uring_register(backend->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        return -1;
+    }
+
+    for (i = 0; i < LINUX_UDP_URING_BUFFERS; i++) {
+        linux_udp_uring_recycle(backend, (uint16_t)i);
+    }
+    linux_udp_uring_publish_buffers(backend);
+    return 0;
+}
+
+int linux_udp_backend_create(struct linux_udp_driver_s *driver)
+{
+    struct linux_udp_backend_s *backend = calloc(1, sizeof(struct linux_udp_backend_s));
+    struct io_uring_params params;
+    int i;
+
+    if (!backend) {
+        return -1;
+    }
+
+    backend->buffers = malloc((size_t)LINUX_UDP_URING_BUFFERS * LINUX_UDP_URING_BUFFER_SIZE);
+    memset(&params, 0, sizeof(params));
+    backend->ring_fd = backend->buffers ? linux_udp_uring_setup(LINUX_UDP_URING_ENTRIES, &params) : -1;
+    if (backend->ring_fd < 0 || !(params.features & IORING_FEAT_EXT_ARG) ||
+            linux_udp_uring_map(backend, &params) != 0) {
+        linux_udp_uring_unmap(backend);
+        if (backend->ring_fd >= 0) {
+            close(backend->ring_fd);
+        }
+        free(backend->buffers);
+        free(backend);
+        return -1;
+    }
+
+    backend->rx_msghdr.msg_namelen = sizeof(struct sockaddr_storage);
+    backend->rx_msghdr.msg_controllen = LINUX_UDP_GSO_CONTROL_SIZE;
+
+    for (i = 0; i < LINUX_UDP_TX_BATCH; i++) {
+        backend->tx_iov[i].iov_base = driver->tx_slots[i].data;
+    }
+
+    driver->backend = backend;
+    return 0;
+}
+
+void linux_udp_backend_destroy(struct linux_udp_driver_s *driver)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+
+    /* Closing the ring cancels all requests, so endpoints are not referenced afterwards */
+    linux_udp_uring_unmap(backend);
+    close(backend->ring_fd);
+    free(backend->buffers);
+    free(backend);
+    driver->backend = NULL;
+}
+
+int linux_udp_backend_open(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    /* Submitted with next io_uring_enter() */
+    return linux_udp_uring_arm_receive(driver->backend, endpoint);
+}
+
+void linux_udp_backend_close(struct linux_udp_driver_s *driver, struct linux_udp_endpoint_s *endpoint)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    struct linux_udp_endpoint_s **prev_ptr;
+    uint16_t i;
+    uint16_t kept = 0;
+
+    if (endpoint->rx_armed) {
+        struct io_uring_sqe *sqe = linux_udp_uring_get_sqe(backend);
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = (uintptr_t)endpoint;
+            sqe->user_data = LINUX_UDP_URING_CANCEL_TAG;
+        }
+        /* Last completion of the receive request tells it is gone */
+        while (endpoint->rx_armed) {
+            int ret = linux_udp_uring_enter(backend, 1, -1);
+            if (ret < 0 && ret != -EINTR) {
+                break;
+            }
+            linux_udp_uring_reap(driver);
+        }
+    }
+
+    prev_ptr = &backend->rearm_list;
+    while (*prev_ptr) {
+        if (*prev_ptr == endpoint) {
+            *prev_ptr = endpoint->rx_next;
+        } else {
+            prev_ptr = &(*prev_ptr)->rx_next;
+        }
+    }
+
+    for (i = 0; i < backend->rx_count; i++) {
+        if (backend->rx_pending[i].endpoint == endpoint) {
+            linux_udp_uring_recycle(backend, backend->rx_pending[i].bid);
+        } else {
+            backend->rx_pending[kept++] = backend->rx_pending[i];
+        }
+    }
+    backend->rx_count = kept;
+    linux_udp_uring_publish_buffers(backend);
+}
+
+int linux_udp_backend_send(struct linux_udp_driver_s *driver)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    uint16_t msg_count = 0;
+    uint16_t slot = 0;
+
+    backend->tx_sent = 0;
+
+    while (slot < driver->tx_count) {
+        struct msghdr *msg = &backend->tx_msghdr[msg_count];
+        struct io_uring_sqe *sqe = linux_udp_uring_get_sqe(backend);
+        uint16_t segments = linux_udp_gso_count(driver, slot);
+        uint16_t i;
+
+        if (!sqe) {
+            driver->stats.tx_dropped += driver->tx_count - slot;
+            break;
+        }
+
+        memset(msg, 0, sizeof(*msg));
+        msg->msg_name = &driver->tx_slots[slot].addr;
+        msg->msg_namelen = driver->tx_slots[slot].addr_len;
+        msg->msg_iov = &backend->tx_iov[slot];
+        msg->msg_iovlen = segments;
+        for (i = slot; i < slot + segments; i++) {
+            backend->tx_iov[i].iov_len = driver->tx_slots[i].len;
+        }
+        if (segments > 1) {
+            linux_udp_gso_control(msg, backend->tx_control[msg_count], driver->tx_slots[slot].len);
+        }
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = driver->tx_slots[slot].sock;
+        sqe->addr = (uintptr_t)msg;
+        sqe->len = 1;
+        sqe->msg_flags = MSG_DONTWAIT;
+        /* Segment count is carried in user_data above the tag */
+        sqe->user_data = LINUX_UDP_URING_TX_TAG | ((uint64_t)segments << 8);
+        slot += segments;
+        if (slot < driver->tx_count && driver->tx_slots[slot].sock == sqe->fd) {
+            sqe->flags = IOSQE_IO_LINK;
+        }
+        backend->tx_inflight++;
+        msg_count++;
+    }
+
+    /* Slots are reused after return, so wait until kernel is done with them */
+    while (backend->tx_inflight) {
+        int ret = linux_udp_uring_enter(backend, 1, -1);
+        driver->stats.tx_syscalls++;
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            break;
+        }
+        linux_udp_uring_reap(driver);
+    }
+
+    return backend->tx_sent;
+}
+
+int linux_udp_backend_wait(struct linux_udp_driver_s *driver, int timeout_ms)
+{
+    struct linux_udp_backend_s *backend = driver->backend;
+    int processed = 0;
+    uint16_t i;
+    int ret;
+
+    while (backend->rearm_list) {
+        struct linux_udp_endpoint_s *endpoint = backend->rearm_list;
+        if (linux_udp_uring_arm_receive(backend, endpoint) != 0) {
+            break;
+        }
+        backend->rearm_list = endpoint->rx_next;
+    }
+
+    /* Datagrams taken while sending are processed without waiting */
+    ret = linux_udp_uring_enter(backend, 1, backend->rx_count ? 0 : timeout_ms);
+    if (ret < 0 && ret != -ETIME && ret != -EINTR) {
+        return -1;
+    }
+    driver->stats.wakeups++;
+    linux_udp_uring_reap(driver);
+    if (backend->rx_count) {
+        driver->stats.rx_syscalls++;
+    }
+
+    for (i = 0; i < backend->rx_count; i++) {
+        linux_udp_uring_rx_s *rx = &backend->rx_pending[i];
+        linux_udp_deliver(driver, rx->endpoint, rx->data, rx->len, rx->segment_size, rx->addr);
+        linux_udp_uring_recycle(backend, rx->bid);
+        processed++;
+    }
+    backend->rx_count = 0;
+    linux_udp_uring_publish_buffers(backend);
+
+    return processed;
+}
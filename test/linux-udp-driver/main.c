@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Registers many endpoints from one thread through linux_udp_driver.
+ * Usage: linux-udp-driver-example [-d 127.0.0.1] [-dp 5683] [-n 100]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "linux_udp_driver.h"
+
+static uint8_t res_manufacturer[] = {"3/0/0"};
+static uint8_t res_manufacturer_val[] = {"ARM"};
+static uint8_t res_type_test[] = {"t"};
+static uint8_t endpoint_type[] = {"type"};
+static uint8_t lifetime[] = {"120"};
+
+static volatile sig_atomic_t running = 1;
+static int registered_count;
+
+static void *own_alloc(sn_coap_len_t size)
+{
+    if (size) {
+        return malloc(size);
+    }
+    return 0;
+}
+
+static void own_free(void *ptr)
+{
+    free(ptr);
+}
+
+static void ctrl_c_handle_function(int signal)
+{
+    (void)signal;
+    running = 0;
+}
+
+static uint8_t rx_function(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address)
+{
+    (void)handle;
+    (void)address;
+    if (coap_header && coap_header->msg_code == COAP_MSG_CODE_RESPONSE_CREATED) {
+        registered_count++;
+    }
+    return 0;
+}
+
+static int create_resources(struct nsdl_s *handle)
+{
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+
+    memset(&resource, 0, sizeof(resource));
+    memset(&parameters, 0, sizeof(parameters));
+    resource.resource_parameters_ptr = &parameters;
+    resource.access = (sn_grs_resource_acl_e)0x0f;
+    resource.mode = SN_GRS_STATIC;
+    resource.pathlen = sizeof(res_manufacturer) - 1;
+    resource.path = res_manufacturer;
+    resource.resource = res_manufacturer_val;
+    resource.resourcelen = sizeof(res_manufacturer_val) - 1;
+    parameters.resource_type_ptr = res_type_test;
+    parameters.resource_type_len = sizeof(res_type_test) - 1;
+
+    return sn_nsdl_create_resource(handle, &resource);
+}
+
+int main(int argc, char **argv)
+{
+    char dst[64] = "127.0.0.1";
+    uint16_t dport = 5683;
+    int count = 100;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp("-d", argv[i]) && i + 1 < argc) {
+            strncpy(dst, argv[++i], sizeof(dst) - 1);
+        } else if (!strcmp("-dp", argv[i]) && i + 1 < argc) {
+            dport = atoi(argv[++i]);
+        } else if (!strcmp("-n", argv[i]) && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else {
+            printf("Usage: linux-udp-driver-example [-d 127.0.0.1] [-dp 5683] [-n 100]\n");
+            return 1;
+        }
+    }
+
+    uint8_t nsp_addr[4];
+    if (inet_pton(AF_INET, dst, nsp_addr) != 1) {
+        printf("IPv4 address expected\n");
+        return 1;
+    }
+
+    signal(SIGINT, ctrl_c_handle_function);
+
+    struct linux_udp_driver_s *driver = linux_udp_driver_create();
+    struct nsdl_s **handles = calloc(count, sizeof(struct nsdl_s *));
+    if (!driver || !handles) {
+        printf("Driver init failed\n");
+        return 1;
+    }
+
+    struct sockaddr_in bind_addr;
+    memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_addr.s_addr = INADDR_ANY;
+
+    for (i = 0; i < count; i++) {
+        char name[32];
+        sn_nsdl_ep_parameters_s endpoint;
+
+        handles[i] = sn_nsdl_init(&linux_udp_driver_tx, &rx_function, &own_alloc, &own_free);
+        if (!handles[i] || !linux_udp_driver_open(driver, handles[i], (struct sockaddr *)&bind_addr, sizeof(bind_addr))) {
+            printf("Endpoint %d init failed\n", i);
+            return 1;
+        }
+        set_NSP_address(handles[i], nsp_addr, dport, SN_NSDL_ADDRESS_TYPE_IPV4);
+        create_resources(handles[i]);
+
+        snprintf(name, sizeof(name), "UDP_DRIVER_%d", i);
+        memset(&endpoint, 0, sizeof(endpoint));
+        endpoint.endpoint_name_ptr = (uint8_t *)name;
+        endpoint.endpoint_name_len = strlen(name);
+        endpoint.type_ptr = endpoint_type;
+        endpoint.type_len = sizeof(endpoint_type) - 1;
+        endpoint.lifetime_ptr = lifetime;
+        endpoint.lifetime_len = sizeof(lifetime) - 1;
+        sn_nsdl_set_update_interval(handles[i], 80);
+        sn_nsdl_register_endpoint(handles[i], &endpoint);
+    }
+
+    uint32_t last_print = 0;
+    while (running) {
+        if (linux_udp_driver_run_once(driver, 1000) < 0) {
+            break;
+        }
+        uint32_t now = linux_udp_driver_time(driver);
+        if (now - last_print >= 10) {
+            linux_udp_driver_stats_s stats;
+            linux_udp_driver_get_stats(driver, &stats);
+            printf("registered %d/%d, rx %llu in %llu calls, tx %llu in %llu calls (%llu segmented), exec %llu, wakeups %llu\n",
+                   registered_count, count,
+                   (unsigned long long)stats.rx_datagrams, (unsigned long long)stats.rx_syscalls,
+                   (unsigned long long)stats.tx_datagrams, (unsigned long long)stats.tx_syscalls,
+                   (unsigned long long)stats.tx_segmented,
+                   (unsigned long long)stats.exec_calls, (unsigned long long)stats.wakeups);
+            last_print = now;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        sn_nsdl_unregister_endpoint(handles[i]);
+    }
+    linux_udp_driver_flush(driver);
+    linux_udp_driver_destroy(driver);
+    for (i = 0; i < count; i++) {
+        sn_nsdl_destroy(handles[i]);
+    }
+    free(handles);
+    return 0;
+}
@@ -0,0 +1,827 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Hosts many simulated endpoints in one process, registers them and sends
+ * notifications on a schedule, then reports throughput, latency and memory.
+ * Usage: load-generator [-n 1000] [-threads 1] [-resources 4] [-interval 10]
+ *                       [-duration 60] [-rate 0] [-latency 0] [-d ADDR] [-dp 5683]
+ *   -n          endpoints in total, spread evenly over threads
+ *   -threads    shards, each with its own transport and thread
+ *   -resources  resources of one endpoint, the first one 3303/0/5700 is observable
+ *   -interval   seconds between notifications of one endpoint
+ *   -duration   seconds notifications are sent after all endpoints registered
+ *   -rate       registrations started per second in each shard, 0 starts all at once
+ *   -latency    one-way delay of loopback network in milliseconds
+ *   -d, -dp     IPv4 address and port of a server on UDP, every shard then runs
+ *               linux_udp_driver. Server must observe 3303/0/5700 of every
+ *               endpoint, for example lwm2m-server -q -o 3303/0/5700.
+ *
+ * Without -d every shard runs its own lwm2m_server over loopback_net. Time is
+ * then virtual, so the simulation runs as fast as the CPU allows: interval,
+ * duration and rate are in virtual seconds, but rates and latencies are
+ * reported on wall clock. Latency is measured from sending to receiving the
+ * response, 2.01 for registration and ACK for a confirmable notification.
+ *
+ * Exit status is non-zero if a shard failed, an endpoint did not register, or
+ * a scheduled notification was lost: skipped because the endpoint was not
+ * observed or its previous one was unacknowledged, refused by the library,
+ * timed out, or still unacknowledged when the run ended.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "linux_udp_driver.h"
+#include "loopback_net.h"
+#include "lwm2m_server.h"
+
+#define LOADGEN_STEP_MS             10
+#define LOADGEN_REGISTER_TIMEOUT_MS 300000
+#define LOADGEN_DRAIN_MS            5000
+#define LOADGEN_TOKEN_MAX           8
+
+static uint8_t observed_path[] = {"3303/0/5700"};
+static uint8_t resource_type[] = {"t"};
+static uint8_t resource_value[] = {"0"};
+static uint8_t notification_value[] = {"21.5"};
+static uint8_t endpoint_type[] = {"loadgen"};
+static uint8_t endpoint_lifetime[] = {"3600"};
+static const uint8_t server_addr[4] = {10, 0, 0, 1};
+
+typedef struct loadgen_config_ {
+    uint32_t endpoints;
+    uint32_t threads;
+    uint32_t resources;
+    uint32_t interval_ms;
+    uint32_t duration_ms;
+    uint32_t rate;
+    uint32_t latency_ms;
+    int udp;
+    uint8_t udp_addr[4];
+    uint16_t udp_port;
+} loadgen_config_s;
+
+/* Latencies in microseconds, sorted for percentiles at the end */
+typedef struct loadgen_samples_ {
+    uint32_t *values;
+    uint32_t count;
+    uint32_t size;
+} loadgen_samples_s;
+
+struct loadgen_shard_;
+
+typedef struct loadgen_endpoint_ {
+    struct nsdl_s *handle;
+    uint64_t register_ns;
+    uint64_t notify_ns;             /* Send time of unacknowledged notification, 0 if none */
+    uint64_t next_notify_ms;
+    uint32_t observe_number;
+    uint16_t notify_msg_id;
+    uint8_t token[LOADGEN_TOKEN_MAX];
+    uint8_t token_len;              /* 0 until server observes */
+    uint8_t registered;
+    uint8_t failed;
+} loadgen_endpoint_s;
+
+typedef struct loadgen_shard_ {
+    uint32_t index;
+    uint32_t first;                 /* Global number of first endpoint */
+    uint32_t count;
+    loadgen_endpoint_s *endpoints;
+    loadgen_endpoint_s **by_handle; /* Sorted by handle for lookups from callbacks */
+    pthread_t thread;
+
+    struct loopback_net_s *net;     /* Loopback mode */
+    struct loopback_node_s *server_node;
+    struct lwm2m_server_s *server;
+    struct linux_udp_driver_s *driver; /* UDP mode */
+
+    uint32_t registered;
+    uint32_t register_failed;
+    uint32_t notifications_sent;
+    uint32_t notifications_acked;
+    uint32_t notifications_failed;  /* Sent, but resending timed out */
+    uint32_t notifications_refused; /* Not sent, library returned 0 */
+    uint32_t notifications_skipped; /* Not sent, endpoint not observed or previous one unacknowledged */
+    uint64_t register_start_ns;
+    uint64_t register_end_ns;       /* When last 2.01 arrived */
+    uint64_t notify_start_ns;
+    uint64_t notify_end_ns;
+    loadgen_samples_s register_latency;
+    loadgen_samples_s notify_latency;
+    lwm2m_server_stats_s server_stats;
+    int failed;
+} loadgen_shard_s;
+
+static loadgen_config_s config;
+static pthread_barrier_t barrier;
+static volatile sig_atomic_t running = 1;
+
+/* nsdl callbacks have no context, each shard runs in its own thread */
+static __thread loadgen_shard_s *current_shard;
+
+static void *own_alloc(sn_coap_len_t size)
+{
+    if (size) {
+        return malloc(size);
+    }
+    return 0;
+}
+
+static void own_free(void *ptr)
+{
+    free(ptr);
+}
+
+static void stop_handler(int signal)
+{
+    (void)signal;
+    running = 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t rss_bytes(void)
+{
+    FILE *file = fopen("/proc/self/statm", "r");
+    unsigned long size = 0;
+    unsigned long resident = 0;
+
+    if (!file) {
+        return 0;
+    }
+    if (fscanf(file, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(file);
+    return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+static void samples_add(loadgen_samples_s *samples, uint64_t start_ns)
+{
+    uint64_t latency_us = (now_ns() - start_ns) / 1000;
+
+    if (samples->count == samples->size) {
+        uint32_t new_size = samples->size ? samples->size * 2 : 1024;
+        uint32_t *values = realloc(samples->values, new_size * sizeof(uint32_t));
+        if (!values) {
+            return;
+        }
+        samples->values = values;
+        samples->size = new_size;
+    }
+    samples->values[samples->count++] = latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int compare_handle(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t)(*(loadgen_endpoint_s *const *)a)->handle;
+    uintptr_t y = (uintptr_t)(*(loadgen_endpoint_s *const *)b)->handle;
+    return x < y ? -1 : x > y;
+}
+
+static loadgen_endpoint_s *find_endpoint(struct nsdl_s *handle)
+{
+    loadgen_shard_s *shard = current_shard;
+    uint32_t low = 0;
+    uint32_t high = shard->count;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if ((uintptr_t)shard->by_handle[middle]->handle < (uintptr_t)handle) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < shard->count && shard->by_handle[low]->handle == handle ? shard->by_handle[low] : NULL;
+}
+
+static uint8_t endpoint_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address)
+{
+    loadgen_shard_s *shard = current_shard;
+    loadgen_endpoint_s *ep = find_endpoint(handle);
+
+    (void)address;
+    if (!ep || !coap_header) {
+        return 0;
+    }
+
+    if (coap_header->coap_status == COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED) {
+        if (ep->notify_ns && coap_header->msg_id == ep->notify_msg_id) {
+            ep->notify_ns = 0;
+            shard->notifications_failed++;
+        } else if (!ep->registered && !ep->failed) {
+            ep->failed = 1;
+            shard->register_failed++;
+        }
+    } else if (coap_header->msg_code == COAP_MSG_CODE_RESPONSE_CREATED && !ep->registered) {
+        ep->registered = 1;
+        shard->registered++;
+        shard->register_end_ns = now_ns();
+        samples_add(&shard->register_latency, ep->register_ns);
+    } else if (coap_header->msg_type == COAP_MSG_TYPE_ACKNOWLEDGEMENT && ep->notify_ns &&
+               coap_header->msg_id == ep->notify_msg_id) {
+        samples_add(&shard->notify_latency, ep->notify_ns);
+        ep->notify_ns = 0;
+        shard->notifications_acked++;
+    }
+    return 0;
+}
+
+/* Observable resource, server is answered with observe option and the token is kept for notifications */
+static uint8_t observed_resource_cb(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address,
+                                    sn_nsdl_capab_e protocol)
+{
+    loadgen_endpoint_s *ep = find_endpoint(handle);
+    sn_coap_hdr_s *response;
+    uint8_t msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
+
+    (void)protocol;
+    if (!ep) {
+        return 0;
+    }
+    if (coap_header->msg_code != COAP_MSG_CODE_REQUEST_GET) {
+        msg_code = COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED;
+    }
+
+    response = sn_nsdl_build_response(handle, coap_header, msg_code);
+    if (!response) {
+        return 0;
+    }
+    if (msg_code == COAP_MSG_CODE_RESPONSE_CONTENT) {
+        response->content_format = COAP_CT_TEXT_PLAIN;
+        response->payload_ptr = notification_value;
+        response->payload_len = sizeof(notification_value) - 1;
+        if (coap_header->options_list_ptr && coap_header->options_list_ptr->observe == COAP_OBSERVE_REGISTER &&
+                coap_header->token_len && coap_header->token_len <= LOADGEN_TOKEN_MAX &&
+                sn_nsdl_alloc_options_list(handle, response)) {
+            memcpy(ep->token, coap_header->token_ptr, coap_header->token_len);
+            ep->token_len = coap_header->token_len;
+            response->options_list_ptr->observe = (sn_coap_observe_e)(ep->observe_number & COAP_OBSERVE__MAX);
+        }
+    }
+    sn_nsdl_send_coap_message(handle, address, response);
+    sn_nsdl_release_allocated_coap_msg_mem(handle, response);
+    return 0;
+}
+
+static int create_resources(struct nsdl_s *handle)
+{
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+    char path[32];
+    uint32_t i;
+
+    memset(&resource, 0, sizeof(resource));
+    memset(&parameters, 0, sizeof(parameters));
+    resource.resource_parameters_ptr = &parameters;
+    resource.access = (sn_grs_resource_acl_e)0x0f;
+    resource.publish_uri = 1;
+    parameters.resource_type_ptr = resource_type;
+    parameters.resource_type_len = sizeof(resource_type) - 1;
+
+    resource.mode = SN_GRS_DYNAMIC;
+    resource.path = observed_path;
+    resource.pathlen = sizeof(observed_path) - 1;
+    resource.sn_grs_dyn_res_callback = &observed_resource_cb;
+    parameters.observable = 1;
+    if (sn_nsdl_create_resource(handle, &resource) != 0) {
+        return -1;
+    }
+
+    resource.mode = SN_GRS_STATIC;
+    resource.sn_grs_dyn_res_callback = NULL;
+    resource.resource = resource_value;
+    resource.resourcelen = sizeof(resource_value) - 1;
+    parameters.observable = 0;
+    for (i = 1; i < config.resources; i++) {
+        resource.pathlen = (uint16_t)snprintf(path, sizeof(path), "3/0/%u", (unsigned)i);
+        resource.path = (uint8_t *)path;
+        if (sn_nsdl_create_resource(handle, &resource) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static uint8_t server_send(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *context)
+{
+    loadgen_shard_s *shard = context;
+    return loopback_net_coap_tx(data_ptr, data_len, address_ptr, shard->server_node);
+}
+
+static void server_rx(struct loopback_node_s *node, uint8_t *data_ptr, uint16_t data_len,
+                      sn_nsdl_addr_s *src_addr_ptr, void *context)
+{
+    loadgen_shard_s *shard = context;
+
+    (void)node;
+    lwm2m_server_receive(shard->server, data_ptr, data_len, src_addr_ptr);
+}
+
+static void server_exec(struct loopback_node_s *node, uint32_t time, void *context)
+{
+    loadgen_shard_s *shard = context;
+
+    (void)node;
+    lwm2m_server_exec(shard->server, time);
+}
+
+static void server_event(struct lwm2m_server_s *server, lwm2m_server_event_e event,
+                         const lwm2m_server_endpoint_s *endpoint, void *context)
+{
+    (void)context;
+    if (event == LWM2M_SERVER_REGISTERED) {
+        lwm2m_server_observe(server, endpoint->name, (const char *)observed_path, NULL, NULL);
+    }
+}
+
+static int shard_init(loadgen_shard_s *shard)
+{
+    struct sockaddr_in bind_addr;
+    uint32_t i;
+
+    shard->endpoints = calloc(shard->count, sizeof(loadgen_endpoint_s));
+    shard->by_handle = calloc(shard->count, sizeof(loadgen_endpoint_s *));
+    if (!shard->endpoints || !shard->by_handle) {
+        return -1;
+    }
+
+    if (config.udp) {
+        shard->driver = linux_udp_driver_create();
+        if (!shard->driver) {
+            return -1;
+        }
+        memset(&bind_addr, 0, sizeof(bind_addr));
+        bind_addr.sin_family = AF_INET;
+        bind_addr.sin_addr.s_addr = INADDR_ANY;
+    } else {
+        loopback_net_config_s net_config;
+
+        memset(&net_config, 0, sizeof(net_config));
+        net_config.latency_ms = config.latency_ms;
+        net_config.seed = shard->index + 1;
+        shard->net = loopback_net_create(&net_config);
+        shard->server = lwm2m_server_create(&server_send, shard);
+        if (!shard->net || !shard->server) {
+            return -1;
+        }
+        shard->server_node = loopback_net_add_datagram(shard->net, server_addr, LOOPBACK_NET_PORT,
+                             &server_rx, &server_exec, shard);
+        if (!shard->server_node) {
+            return -1;
+        }
+        lwm2m_server_set_event_cb(shard->server, &server_event, shard);
+    }
+
+    for (i = 0; i < shard->count; i++) {
+        loadgen_endpoint_s *ep = &shard->endpoints[i];
+        uint32_t number = shard->first + i;
+
+        ep->handle = sn_nsdl_init(config.udp ? &linux_udp_driver_tx : &loopback_net_nsdl_tx, &endpoint_rx,
+                                  &own_alloc, &own_free);
+        if (!ep->handle || create_resources(ep->handle) != 0) {
+            return -1;
+        }
+        shard->by_handle[i] = ep;
+
+        if (config.udp) {
+            if (!linux_udp_driver_open(shard->driver, ep->handle, (struct sockaddr *)&bind_addr, sizeof(bind_addr))) {
+                return -1;
+            }
+            set_NSP_address(ep->handle, config.udp_addr, config.udp_port, SN_NSDL_ADDRESS_TYPE_IPV4);
+        } else {
+            /* Endpoints are at 10.1.0.0 onwards */
+            uint8_t addr[4] = {10, (uint8_t)(1 + (number >> 16)), (uint8_t)(number >> 8), (uint8_t)number};
+            if (!loopback_net_add_nsdl(shard->net, ep->handle, addr, LOOPBACK_NET_PORT)) {
+                return -1;
+            }
+            set_NSP_address(ep->handle, (uint8_t *)server_addr, LOOPBACK_NET_PORT, SN_NSDL_ADDRESS_TYPE_IPV4);
+        }
+    }
+    qsort(shard->by_handle, shard->count, sizeof(loadgen_endpoint_s *), &compare_handle);
+    return 0;
+}
+
+static void shard_destroy(loadgen_shard_s *shard)
+{
+    uint32_t i;
+
+    if (shard->server) {
+        lwm2m_server_get_stats(shard->server, &shard->server_stats);
+    }
+    if (shard->driver) {
+        linux_udp_driver_destroy(shard->driver);
+    }
+    loopback_net_destroy(shard->net);
+    for (i = 0; shard->endpoints && i < shard->count; i++) {
+        if (shard->endpoints[i].handle) {
+            sn_nsdl_destroy(shard->endpoints[i].handle);
+        }
+    }
+    lwm2m_server_destroy(shard->server);
+    free(shard->endpoints);
+    free(shard->by_handle);
+}
+
+static uint64_t shard_time_ms(loadgen_shard_s *shard)
+{
+    return shard->net ? loopback_net_time_ms(shard->net) : now_ns() / 1000000;
+}
+
+static int shard_run(loadgen_shard_s *shard)
+{
+    if (shard->net) {
+        loopback_net_run_for(shard->net, LOADGEN_STEP_MS);
+        return 0;
+    }
+    linux_udp_driver_flush(shard->driver);
+    return linux_udp_driver_run_once(shard->driver, LOADGEN_STEP_MS) < 0 ? -1 : 0;
+}
+
+static void register_endpoint(loadgen_endpoint_s *ep, uint32_t number)
+{
+    sn_nsdl_ep_parameters_s endpoint;
+    char name[32];
+
+    snprintf(name, sizeof(name), "loadgen-%u", (unsigned)number);
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = (uint8_t *)name;
+    endpoint.endpoint_name_len = strlen(name);
+    endpoint.type_ptr = endpoint_type;
+    endpoint.type_len = sizeof(endpoint_type) - 1;
+    endpoint.lifetime_ptr = endpoint_lifetime;
+    endpoint.lifetime_len = sizeof(endpoint_lifetime) - 1;
+
+    ep->register_ns = now_ns();
+    if (sn_nsdl_register_endpoint(ep->handle, &endpoint) == 0) {
+        ep->failed = 1;
+        current_shard->register_failed++;
+    }
+}
+
+static void shard_register(loadgen_shard_s *shard)
+{
+    uint64_t start_ms = shard_time_ms(shard);
+    uint32_t started = 0;
+
+    shard->register_start_ns = now_ns();
+    shard->register_end_ns = shard->register_start_ns;
+    while (running && shard->registered + shard->register_failed < shard->count) {
+        uint64_t elapsed_ms = shard_time_ms(shard) - start_ms;
+        uint64_t allowed = config.rate ? elapsed_ms * config.rate / 1000 + 1 : shard->count;
+
+        if (elapsed_ms > LOADGEN_REGISTER_TIMEOUT_MS) {
+            break;
+        }
+        while (started < shard->count && started < allowed) {
+            register_endpoint(&shard->endpoints[started], shard->first + started);
+            started++;
+        }
+        if (shard_run(shard) != 0) {
+            shard->failed = 1;
+            return;
+        }
+    }
+}
+
+/* Endpoints notify in index order with phases spread over one interval, so due times stay sorted in a ring */
+static void shard_notify(loadgen_shard_s *shard)
+{
+    uint64_t start_ms = shard_time_ms(shard);
+    uint64_t end_ms = start_ms + config.duration_ms;
+    uint32_t cursor = 0;
+    uint32_t i;
+
+    for (i = 0; i < shard->count; i++) {
+        shard->endpoints[i].next_notify_ms = start_ms + (uint64_t)config.interval_ms * i / shard->count;
+    }
+
+    shard->notify_start_ns = now_ns();
+    while (running && shard_time_ms(shard) < end_ms) {
+        uint64_t time_ms = shard_time_ms(shard);
+
+        for (i = 0; i < shard->count && shard->endpoints[cursor].next_notify_ms <= time_ms; i++) {
+            loadgen_endpoint_s *ep = &shard->endpoints[cursor];
+
+            /* Not observed yet or previous notification still unacknowledged, skip this round */
+            if (!ep->registered || !ep->token_len || ep->notify_ns) {
+                shard->notifications_skipped++;
+            } else {
+                ep->observe_number++;
+                ep->notify_ns = now_ns();
+                ep->notify_msg_id = sn_nsdl_send_observation_notification(ep->handle, ep->token, ep->token_len,
+                                    notification_value, sizeof(notification_value) - 1,
+                                    (sn_coap_observe_e)(ep->observe_number & COAP_OBSERVE__MAX),
+                                    COAP_MSG_TYPE_CONFIRMABLE, COAP_CT_TEXT_PLAIN);
+                if (ep->notify_msg_id) {
+                    shard->notifications_sent++;
+                } else {
+                    ep->notify_ns = 0;
+                    shard->notifications_refused++;
+                }
+            }
+            ep->next_notify_ms += config.interval_ms;
+            cursor = cursor + 1 < shard->count ? cursor + 1 : 0;
+        }
+        if (shard_run(shard) != 0) {
+            shard->failed = 1;
+            return;
+        }
+    }
+
+    /* Let last acknowledgements arrive */
+    end_ms = shard_time_ms(shard) + LOADGEN_DRAIN_MS;
+    while (running && shard->notifications_acked + shard->notifications_failed < shard->notifications_sent &&
+            shard_time_ms(shard) < end_ms) {
+        if (shard_run(shard) != 0) {
+            break;
+        }
+    }
+    shard->notify_end_ns = now_ns();
+}
+
+static void *shard_thread(void *arg)
+{
+    loadgen_shard_s *shard = arg;
+
+    current_shard = shard;
+    if (shard_init(shard) != 0) {
+        printf("Shard %u init failed\n", (unsigned)shard->index);
+        shard->failed = 1;
+    }
+
+    /* Main thread measures memory of created endpoints between these */
+    pthread_barrier_wait(&barrier);
+    pthread_barrier_wait(&barrier);
+
+    if (!shard->failed) {
+        shard_register(shard);
+    }
+    if (!shard->failed && config.duration_ms) {
+        shard_notify(shard);
+    }
+
+    pthread_barrier_wait(&barrier);
+    pthread_barrier_wait(&barrier);
+    shard_destroy(shard);
+    return NULL;
+}
+
+static void print_latency(const char *what, loadgen_samples_s *samples)
+{
+    if (!samples->count) {
+        printf("%s latency -\n", what);
+        return;
+    }
+    qsort(samples->values, samples->count, sizeof(uint32_t), &compare_u32);
+    printf("%s latency p50 %.3f ms p99 %.3f ms max %.3f ms\n", what,
+           samples->values[(samples->count - 1) / 2] / 1000.0,
+           samples->values[(uint64_t)(samples->count - 1) * 99 / 100] / 1000.0,
+           samples->values[samples->count - 1] / 1000.0);
+}
+
+static void samples_merge(loadgen_samples_s *dst, loadgen_samples_s *src)
+{
+    uint32_t *values = src->count ? realloc(dst->values, ((size_t)dst->count + src->count) * sizeof(uint32_t)) : NULL;
+
+    if (values) {
+        memcpy(values + dst->count, src->values, (size_t)src->count * sizeof(uint32_t));
+        dst->values = values;
+        dst->count += src->count;
+        dst->size = dst->count;
+    }
+    free(src->values);
+    src->values = NULL;
+}
+
+/* Returns the number of scheduled notifications that were not acknowledged */
+static uint64_t report(loadgen_shard_s *shards, uint64_t rss_base, uint64_t rss_endpoints, uint64_t rss_end)
+{
+    loadgen_samples_s register_latency = {NULL, 0, 0};
+    loadgen_samples_s notify_latency = {NULL, 0, 0};
+    uint64_t register_ns = 0;
+    uint64_t notify_ns = 0;
+    uint64_t registered = 0;
+    uint64_t register_failed = 0;
+    uint64_t sent = 0;
+    uint64_t acked = 0;
+    uint64_t failed = 0;
+    uint64_t refused = 0;
+    uint64_t skipped = 0;
+    uint64_t lost;
+    uint32_t i;
+
+    for (i = 0; i < config.threads; i++) {
+        loadgen_shard_s *shard = &shards[i];
+
+        registered += shard->registered;
+        register_failed += shard->register_failed;
+        sent += shard->notifications_sent;
+        acked += shard->notifications_acked;
+        failed += shard->notifications_failed;
+        refused += shard->notifications_refused;
+        skipped += shard->notifications_skipped;
+        if (shard->register_end_ns - shard->register_start_ns > register_ns) {
+            register_ns = shard->register_end_ns - shard->register_start_ns;
+        }
+        if (shard->notify_end_ns - shard->notify_start_ns > notify_ns) {
+            notify_ns = shard->notify_end_ns - shard->notify_start_ns;
+        }
+        samples_merge(&register_latency, &shard->register_latency);
+        samples_merge(&notify_latency, &shard->notify_latency);
+    }
+
+    printf("endpoints %u threads %u resources %u mode %s\n", (unsigned)config.endpoints, (unsigned)config.threads,
+           (unsigned)config.resources, config.udp ? "udp" : "loopback");
+    printf("registered %llu/%u failed %llu in %.3f s, %.0f registrations/s\n",
+           (unsigned long long)registered, (unsigned)config.endpoints, (unsigned long long)register_failed,
+           register_ns / 1e9, register_ns ? registered * 1e9 / register_ns : 0.0);
+    print_latency("registration", &register_latency);
+    lost = sent - acked + refused + skipped;
+    printf("notifications %llu acked %llu failed %llu refused %llu skipped %llu lost %llu in %.3f s, "
+           "%.0f notifications/s\n", (unsigned long long)sent, (unsigned long long)acked, (unsigned long long)failed,
+           (unsigned long long)refused, (unsigned long long)skipped, (unsigned long long)lost,
+           notify_ns / 1e9, notify_ns ? acked * 1e9 / notify_ns : 0.0);
+    print_latency("notification", &notify_latency);
+    printf("rss %.0f bytes per endpoint, %.0f with %s\n",
+           (double)(rss_endpoints > rss_base ? rss_endpoints - rss_base : 0) / config.endpoints,
+           (double)(rss_end > rss_base ? rss_end - rss_base : 0) / config.endpoints,
+           config.udp ? "traffic" : "traffic and server");
+    if (!config.udp) {
+        lwm2m_server_stats_s total;
+
+        memset(&total, 0, sizeof(total));
+        for (i = 0; i < config.threads; i++) {
+            total.registrations += shards[i].server_stats.registrations;
+            total.notifications += shards[i].server_stats.notifications;
+            total.rx_datagrams += shards[i].server_stats.rx_datagrams;
+            total.tx_datagrams += shards[i].server_stats.tx_datagrams;
+        }
+        printf("server registrations %llu notifications %llu rx %llu tx %llu\n",
+               (unsigned long long)total.registrations, (unsigned long long)total.notifications,
+               (unsigned long long)total.rx_datagrams, (unsigned long long)total.tx_datagrams);
+    }
+
+    if (lost) {
+        printf("LOST %llu of %llu notifications: %llu skipped, %llu refused, %llu timed out, "
+               "%llu unacknowledged at end\n", (unsigned long long)lost,
+               (unsigned long long)(sent + refused + skipped), (unsigned long long)skipped,
+               (unsigned long long)refused, (unsigned long long)failed, (unsigned long long)(sent - acked - failed));
+    }
+
+    free(register_latency.values);
+    free(notify_latency.values);
+    return lost;
+}
+
+static void usage(void)
+{
+    printf("Usage: load-generator [-n 1000] [-threads 1] [-resources 4] [-interval 10] [-duration 60] [-rate 0] "
+           "[-latency 0] [-d ADDR] [-dp 5683]\n");
+}
+
+int main(int argc, char **argv)
+{
+    loadgen_shard_s *shards;
+    uint64_t rss_base;
+    uint64_t rss_endpoints;
+    uint64_t rss_end;
+    int exit_status = 0;
+    uint32_t i;
+    int arg;
+
+    config.endpoints = 1000;
+    config.threads = 1;
+    config.resources = 4;
+    config.interval_ms = 10000;
+    config.duration_ms = 60000;
+    config.udp_port = 5683;
+
+    for (arg = 1; arg + 1 < argc; arg += 2) {
+        uint32_t value = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+
+        if (!strcmp("-n", argv[arg])) {
+            config.endpoints = value;
+        } else if (!strcmp("-threads", argv[arg])) {
+            config.threads = value;
+        } else if (!strcmp("-resources", argv[arg])) {
+            config.resources = value;
+        } else if (!strcmp("-interval", argv[arg])) {
+            config.interval_ms = value * 1000;
+        } else if (!strcmp("-duration", argv[arg])) {
+            config.duration_ms = value * 1000;
+        } else if (!strcmp("-rate", argv[arg])) {
+            config.rate = value;
+        } else if (!strcmp("-latency", argv[arg])) {
+            config.latency_ms = value;
+        } else if (!strcmp("-d", argv[arg])) {
+            if (inet_pton(AF_INET, argv[arg + 1], config.udp_addr) != 1) {
+                printf("IPv4 address expected\n");
+                return 1;
+            }
+            config.udp = 1;
+        } else if (!strcmp("-dp", argv[arg])) {
+            config.udp_port = (uint16_t)value;
+        } else {
+            break;
+        }
+    }
+    if (arg < argc || !config.endpoints || !config.threads || config.threads > config.endpoints ||
+            !config.resources || !config.interval_ms || config.endpoints >= (UINT32_C(1) << 24)) {
+        usage();
+        return 1;
+    }
+
+    /* Every UDP endpoint has its own socket */
+    if (config.udp) {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+
+    shards = calloc(config.threads, sizeof(loadgen_shard_s));
+    if (!shards || pthread_barrier_init(&barrier, NULL, config.threads + 1) != 0) {
+        printf("Init failed\n");
+        return 1;
+    }
+
+    rss_base = rss_bytes();
+    for (i = 0; i < config.threads; i++) {
+        shards[i].index = i;
+        shards[i].first = (uint32_t)((uint64_t)config.endpoints * i / config.threads);
+        shards[i].count = (uint32_t)((uint64_t)config.endpoints * (i + 1) / config.threads) - shards[i].first;
+        if (pthread_create(&shards[i].thread, NULL, &shard_thread, &shards[i]) != 0) {
+            printf("Creating thread failed\n");
+            return 1;
+        }
+    }
+
+    pthread_barrier_wait(&barrier);
+    rss_endpoints = rss_bytes();
+    pthread_barrier_wait(&barrier);
+
+    pthread_barrier_wait(&barrier);
+    rss_end = rss_bytes();
+    pthread_barrier_wait(&barrier);
+
+    for (i = 0; i < config.threads; i++) {
+        pthread_join(shards[i].thread, NULL);
+        if (shards[i].failed || shards[i].registered < shards[i].count) {
+            exit_status = 1;
+        }
+    }
+
+    if (report(shards, rss_base, rss_endpoints, rss_end) != 0) {
+        exit_status = 1;
+    }
+    pthread_barrier_destroy(&barrier);
+    free(shards);
+    return exit_status;
+}
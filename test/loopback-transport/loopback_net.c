@@ -0,0 +1,591 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ns_list.h"
+#include "loopback_net.h"
+#include "sn_coap_protocol.h"
+
+#define LOOPBACK_NET_HASH_MIN_SIZE  64
+#define LOOPBACK_NET_HEAP_MIN_SIZE  64
+
+struct loopback_node_s {
+    struct loopback_net_s       *net;
+    struct nsdl_s               *nsdl;          /* One of nsdl and coap is set, or neither for a datagram node */
+    struct coap_s               *coap;
+    loopback_coap_rx_cb         *rx_cb;
+    loopback_datagram_rx_cb     *datagram_rx_cb;
+    loopback_exec_cb            *exec_cb;
+    void                        *context;
+    uint8_t                     addr[4];
+    uint16_t                    port;
+    struct loopback_node_s      *handle_next;   /* Hash chain by handle */
+    struct loopback_node_s      *addr_next;     /* Hash chain by address */
+    ns_list_link_t              link;
+};
+
+typedef NS_LIST_HEAD(struct loopback_node_s, link) loopback_node_list_t;
+
+typedef struct loopback_packet_ {
+    uint64_t                    deliver_ms;
+    uint32_t                    seq;            /* Send order, keeps equal delivery times deterministic */
+    uint8_t                     src_addr[4];
+    uint16_t                    src_port;
+    uint8_t                     dst_addr[4];
+    uint16_t                    dst_port;
+    uint16_t                    len;
+    uint8_t                     data[];
+} loopback_packet_s;
+
+struct loopback_net_s {
+    loopback_net_config_s       config;
+    uint32_t                    random;
+    uint64_t                    now_ms;
+    uint64_t                    next_tick_ms;
+    uint32_t                    seq;
+
+    /* Datagrams in flight, binary heap ordered by delivery time */
+    loopback_packet_s           **heap;
+    uint32_t                    heap_count;
+    uint32_t                    heap_size;
+
+    loopback_node_list_t        nodes;
+    struct loopback_node_s      **handle_hash;
+    struct loopback_node_s      **addr_hash;
+    uint32_t                    hash_size;
+    uint32_t                    node_count;
+    struct loopback_node_s      *current;       /* Node being run, most TX is from it */
+
+    loopback_net_stats_s        stats;
+};
+
+/* nsdl TX callback has no context, so the network of the calling thread is used */
+static __thread struct loopback_net_s *loopback_thread_net;
+
+/* xorshift32, deterministic for a given seed */
+static uint32_t loopback_net_random(struct loopback_net_s *net)
+{
+    uint32_t x = net->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    net->random = x;
+    return x;
+}
+
+static int loopback_net_chance(struct loopback_net_s *net, uint16_t per_mille)
+{
+    return per_mille && loopback_net_random(net) % 1000 < per_mille;
+}
+
+static uint32_t loopback_net_hash_ptr(const void *ptr, uint32_t hash_size)
+{
+    uintptr_t key = (uintptr_t)ptr;
+    key ^= key >> 17;
+    key *= 0x9E3779B1u;
+    return (uint32_t)(key >> 7) & (hash_size - 1);
+}
+
+static uint32_t loopback_net_hash_addr(const uint8_t addr[4], uint16_t port, uint32_t hash_size)
+{
+    uint32_t key = ((uint32_t)addr[0] << 24 | (uint32_t)addr[1] << 16 | (uint32_t)addr[2] << 8 | addr[3]) ^ ((uint32_t)port * 0x85EBCA6Bu);
+    key ^= key >> 15;
+    key *= 0x2C1B3C6Du;
+    key ^= key >> 12;
+    return key & (hash_size - 1);
+}
+
+static const void *loopback_node_handle(const struct loopback_node_s *node)
+{
+    return node->nsdl ? (const void *)node->nsdl : (const void *)node->coap;
+}
+
+static int loopback_net_hash_resize(struct loopback_net_s *net, uint32_t new_size)
+{
+    struct loopback_node_s **handle_hash = calloc(new_size, sizeof(struct loopback_node_s *));
+    struct loopback_node_s **addr_hash = calloc(new_size, sizeof(struct loopback_node_s *));
+
+    if (!handle_hash || !addr_hash) {
+        free(handle_hash);
+        free(addr_hash);
+        return -1;
+    }
+
+    ns_list_foreach(struct loopback_node_s, node, &net->nodes) {
+        uint32_t index;
+        if (loopback_node_handle(node)) {
+            index = loopback_net_hash_ptr(loopback_node_handle(node), new_size);
+            node->handle_next = handle_hash[index];
+            handle_hash[index] = node;
+        }
+        index = loopback_net_hash_addr(node->addr, node->port, new_size);
+        node->addr_next = addr_hash[index];
+        addr_hash[index] = node;
+    }
+
+    free(net->handle_hash);
+    free(net->addr_hash);
+    net->handle_hash = handle_hash;
+    net->addr_hash = addr_hash;
+    net->hash_size = new_size;
+    return 0;
+}
+
+static struct loopback_node_s *loopback_net_find_handle(struct loopback_net_s *net, const void *handle)
+{
+    struct loopback_node_s *node;
+
+    if (net->current && loopback_node_handle(net->current) == handle) {
+        return net->current;
+    }
+
+    node = net->handle_hash[loopback_net_hash_ptr(handle, net->hash_size)];
+    while (node && loopback_node_handle(node) != handle) {
+        node = node->handle_next;
+    }
+    return node;
+}
+
+static struct loopback_node_s *loopback_net_find_addr(struct loopback_net_s *net, const uint8_t addr[4], uint16_t port)
+{
+    struct loopback_node_s *node = net->addr_hash[loopback_net_hash_addr(addr, port, net->hash_size)];
+
+    while (node && (node->port != port || memcmp(node->addr, addr, 4) != 0)) {
+        node = node->addr_next;
+    }
+    return node;
+}
+
+static int loopback_net_packet_before(const loopback_packet_s *a, const loopback_packet_s *b)
+{
+    if (a->deliver_ms != b->deliver_ms) {
+        return a->deliver_ms < b->deliver_ms;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static int loopback_net_heap_push(struct loopback_net_s *net, loopback_packet_s *packet)
+{
+    uint32_t index;
+
+    if (net->heap_count == net->heap_size) {
+        uint32_t new_size = net->heap_size ? net->heap_size * 2 : LOOPBACK_NET_HEAP_MIN_SIZE;
+        loopback_packet_s **heap = realloc(net->heap, new_size * sizeof(loopback_packet_s *));
+        if (!heap) {
+            return -1;
+        }
+        net->heap = heap;
+        net->heap_size = new_size;
+    }
+
+    index = net->heap_count++;
+    while (index) {
+        uint32_t parent = (index - 1) / 2;
+        if (!loopback_net_packet_before(packet, net->heap[parent])) {
+            break;
+        }
+        net->heap[index] = net->heap[parent];
+        index = parent;
+    }
+    net->heap[index] = packet;
+    return 0;
+}
+
+static loopback_packet_s *loopback_net_heap_pop(struct loopback_net_s *net)
+{
+    loopback_packet_s *top = net->heap[0];
+    loopback_packet_s *last = net->heap[--net->heap_count];
+    uint32_t index = 0;
+
+    while (net->heap_count) {
+        uint32_t child = index * 2 + 1;
+        if (child >= net->heap_count) {
+            break;
+        }
+        if (child + 1 < net->heap_count && loopback_net_packet_before(net->heap[child + 1], net->heap[child])) {
+            child++;
+        }
+        if (!loopback_net_packet_before(net->heap[child], last)) {
+            break;
+        }
+        net->heap[index] = net->heap[child];
+        index = child;
+    }
+    if (net->heap_count) {
+        net->heap[index] = last;
+    }
+    return top;
+}
+
+/* Queues one copy of datagram with its own delay */
+static void loopback_net_enqueue(struct loopback_net_s *net, const struct loopback_node_s *src,
+                                 const uint8_t *data, uint16_t len, const sn_nsdl_addr_s *dst)
+{
+    loopback_packet_s *packet = malloc(sizeof(loopback_packet_s) + len);
+    uint64_t delay = net->config.latency_ms;
+
+    if (!packet) {
+        net->stats.lost++;
+        return;
+    }
+
+    if (net->config.jitter_ms) {
+        delay += loopback_net_random(net) % (net->config.jitter_ms + 1);
+    }
+    if (loopback_net_chance(net, net->config.reorder)) {
+        delay += net->config.reorder_ms;
+        net->stats.reordered++;
+    }
+
+    packet->deliver_ms = net->now_ms + delay;
+    packet->seq = net->seq++;
+    memcpy(packet->src_addr, src->addr, 4);
+    packet->src_port = src->port;
+    memcpy(packet->dst_addr, dst->addr_ptr, 4);
+    packet->dst_port = dst->port;
+    packet->len = len;
+    memcpy(packet->data, data, len);
+
+    if (loopback_net_heap_push(net, packet) != 0) {
+        free(packet);
+        net->stats.lost++;
+    }
+}
+
+static uint8_t loopback_net_send(struct loopback_net_s *net, const struct loopback_node_s *src,
+                                 const uint8_t *data, uint16_t len, const sn_nsdl_addr_s *dst)
+{
+    if (!data || !dst || !dst->addr_ptr || dst->addr_len != 4) {
+        return 0;
+    }
+
+    net->stats.sent++;
+    net->stats.bytes += len;
+
+    if (loopback_net_chance(net, net->config.loss)) {
+        net->stats.lost++;
+        return 1;
+    }
+
+    loopback_net_enqueue(net, src, data, len, dst);
+    if (loopback_net_chance(net, net->config.duplicate)) {
+        net->stats.duplicated++;
+        loopback_net_enqueue(net, src, data, len, dst);
+    }
+    return 1;
+}
+
+static int loopback_net_deliver(struct loopback_net_s *net, loopback_packet_s *packet)
+{
+    struct loopback_node_s *node = loopback_net_find_addr(net, packet->dst_addr, packet->dst_port);
+    sn_nsdl_addr_s src;
+
+    if (!node) {
+        net->stats.undeliverable++;
+        return 0;
+    }
+    net->stats.delivered++;
+
+    memset(&src, 0, sizeof(src));
+    src.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    src.addr_len = 4;
+    src.addr_ptr = packet->src_addr;
+    src.port = packet->src_port;
+
+    net->current = node;
+    if (node->nsdl) {
+        sn_nsdl_process_coap(node->nsdl, packet->data, packet->len, &src);
+    } else if (node->datagram_rx_cb) {
+        node->datagram_rx_cb(node, packet->data, packet->len, &src, node->context);
+    } else {
+        sn_coap_hdr_s *coap_msg_ptr = sn_coap_protocol_parse(node->coap, &src, packet->len, packet->data, node);
+        if (coap_msg_ptr) {
+            if (node->rx_cb) {
+                node->rx_cb(node, coap_msg_ptr, &src, node->context);
+            }
+            sn_coap_parser_release_allocated_coap_msg_mem(node->coap, coap_msg_ptr);
+        }
+    }
+    net->current = NULL;
+    return 1;
+}
+
+static void loopback_net_tick(struct loopback_net_s *net)
+{
+    uint32_t time = loopback_net_time(net);
+
+    ns_list_foreach(struct loopback_node_s, node, &net->nodes) {
+        net->current = node;
+        if (node->nsdl) {
+            sn_nsdl_exec(node->nsdl, time);
+        } else if (node->coap) {
+            sn_coap_protocol_exec(node->coap, time);
+        } else if (node->exec_cb) {
+            node->exec_cb(node, time, node->context);
+        }
+    }
+    net->current = NULL;
+}
+
+struct loopback_net_s *loopback_net_create(const loopback_net_config_s *config)
+{
+    struct loopback_net_s *net = calloc(1, sizeof(struct loopback_net_s));
+
+    if (!net) {
+        return NULL;
+    }
+
+    ns_list_init(&net->nodes);
+    if (loopback_net_hash_resize(net, LOOPBACK_NET_HASH_MIN_SIZE) != 0) {
+        free(net);
+        return NULL;
+    }
+
+    loopback_net_set_config(net, config);
+    net->random = net->config.seed ? net->config.seed : 1;
+    net->now_ms = 1000;
+    net->next_tick_ms = 1000;
+
+    loopback_thread_net = net;
+    return net;
+}
+
+void loopback_net_destroy(struct loopback_net_s *net)
+{
+    if (!net) {
+        return;
+    }
+
+    while (net->heap_count) {
+        free(loopback_net_heap_pop(net));
+    }
+    ns_list_foreach_safe(struct loopback_node_s, node, &net->nodes) {
+        ns_list_remove(&net->nodes, node);
+        free(node);
+    }
+
+    free(net->heap);
+    free(net->handle_hash);
+    free(net->addr_hash);
+    if (loopback_thread_net == net) {
+        loopback_thread_net = NULL;
+    }
+    free(net);
+}
+
+void loopback_net_set_config(struct loopback_net_s *net, const loopback_net_config_s *config)
+{
+    if (!net) {
+        return;
+    }
+    if (config) {
+        net->config = *config;
+    } else {
+        memset(&net->config, 0, sizeof(net->config));
+    }
+}
+
+static struct loopback_node_s *loopback_net_add(struct loopback_net_s *net, const uint8_t addr[4], uint16_t port)
+{
+    struct loopback_node_s *node;
+    uint32_t index;
+
+    if (!net || !addr || loopback_net_find_addr(net, addr, port)) {
+        return NULL;
+    }
+    if (net->node_count >= net->hash_size * 2 && loopback_net_hash_resize(net, net->hash_size * 2) != 0) {
+        return NULL;
+    }
+
+    node = calloc(1, sizeof(struct loopback_node_s));
+    if (!node) {
+        return NULL;
+    }
+    node->net = net;
+    memcpy(node->addr, addr, 4);
+    node->port = port;
+    ns_list_add_to_end(&net->nodes, node);
+    net->node_count++;
+
+    index = loopback_net_hash_addr(addr, port, net->hash_size);
+    node->addr_next = net->addr_hash[index];
+    net->addr_hash[index] = node;
+    return node;
+}
+
+static void loopback_net_add_handle(struct loopback_net_s *net, struct loopback_node_s *node)
+{
+    uint32_t index = loopback_net_hash_ptr(loopback_node_handle(node), net->hash_size);
+    node->handle_next = net->handle_hash[index];
+    net->handle_hash[index] = node;
+}
+
+struct loopback_node_s *loopback_net_add_nsdl(struct loopback_net_s *net, struct nsdl_s *handle,
+        const uint8_t addr[4], uint16_t port)
+{
+    struct loopback_node_s *node;
+
+    if (!handle || !net || loopback_net_find_handle(net, handle)) {
+        return NULL;
+    }
+    node = loopback_net_add(net, addr, port);
+    if (node) {
+        node->nsdl = handle;
+        loopback_net_add_handle(net, node);
+    }
+    return node;
+}
+
+struct loopback_node_s *loopback_net_add_coap(struct loopback_net_s *net, struct coap_s *handle,
+        const uint8_t addr[4], uint16_t port,
+        loopback_coap_rx_cb *rx_cb, void *context)
+{
+    struct loopback_node_s *node;
+
+    if (!handle || !net || loopback_net_find_handle(net, handle)) {
+        return NULL;
+    }
+    node = loopback_net_add(net, addr, port);
+    if (node) {
+        node->coap = handle;
+        node->rx_cb = rx_cb;
+        node->context = context;
+        loopback_net_add_handle(net, node);
+    }
+    return node;
+}
+
+struct loopback_node_s *loopback_net_add_datagram(struct loopback_net_s *net, const uint8_t addr[4], uint16_t port,
+        loopback_datagram_rx_cb *rx_cb, loopback_exec_cb *exec_cb,
+        void *context)
+{
+    struct loopback_node_s *node;
+
+    if (!rx_cb) {
+        return NULL;
+    }
+    node = loopback_net_add(net, addr, port);
+    if (node) {
+        node->datagram_rx_cb = rx_cb;
+        node->exec_cb = exec_cb;
+        node->context = context;
+    }
+    return node;
+}
+
+uint8_t loopback_net_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr,
+                             uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    struct loopback_net_s *net = loopback_thread_net;
+    struct loopback_node_s *node;
+    (void)protocol;
+
+    if (!net) {
+        return 0;
+    }
+    node = loopback_net_find_handle(net, handle);
+    if (!node) {
+        return 0;
+    }
+    return loopback_net_send(net, node, data_ptr, data_len, address_ptr);
+}
+
+uint8_t loopback_net_coap_tx(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    struct loopback_node_s *node = param;
+
+    if (!node) {
+        return 0;
+    }
+    return loopback_net_send(node->net, node, data_ptr, data_len, address_ptr);
+}
+
+int loopback_net_run_until(struct loopback_net_s *net, uint64_t time_ms)
+{
+    int delivered = 0;
+
+    if (!net) {
+        return 0;
+    }
+    loopback_thread_net = net;
+
+    for (;;) {
+        uint64_t next_packet_ms = net->heap_count ? net->heap[0]->deliver_ms : UINT64_MAX;
+
+        /* Exec runs before datagrams due at the same millisecond */
+        if (net->next_tick_ms <= time_ms && net->next_tick_ms <= next_packet_ms) {
+            net->now_ms = net->next_tick_ms;
+            net->next_tick_ms += 1000;
+            loopback_net_tick(net);
+        } else if (next_packet_ms <= time_ms) {
+            loopback_packet_s *packet = loopback_net_heap_pop(net);
+            net->now_ms = packet->deliver_ms;
+            delivered += loopback_net_deliver(net, packet);
+            free(packet);
+        } else {
+            break;
+        }
+    }
+
+    if (time_ms > net->now_ms) {
+        net->now_ms = time_ms;
+    }
+    return delivered;
+}
+
+int loopback_net_run_for(struct loopback_net_s *net, uint32_t duration_ms)
+{
+    if (!net) {
+        return 0;
+    }
+    return loopback_net_run_until(net, net->now_ms + duration_ms);
+}
+
+int loopback_net_pending(const struct loopback_net_s *net)
+{
+    return net ? (int)net->heap_count : 0;
+}
+
+uint64_t loopback_net_time_ms(const struct loopback_net_s *net)
+{
+    return net ? net->now_ms : 0;
+}
+
+uint32_t loopback_net_time(const struct loopback_net_s *net)
+{
+    return net ? (uint32_t)(net->now_ms / 1000) : 0;
+}
+
+void loopback_net_get_stats(const struct loopback_net_s *net, loopback_net_stats_s *stats)
+{
+    if (net && stats) {
+        *stats = net->stats;
+    }
+}
+
+void loopback_node_get_address(const struct loopback_node_s *node, sn_nsdl_addr_s *addr)
+{
+    if (!node || !addr) {
+        return;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    addr->addr_len = 4;
+    addr->addr_ptr = (uint8_t *)node->addr;
+    addr->port = node->port;
+}
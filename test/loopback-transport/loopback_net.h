@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file loopback_net.h
+ *
+ * \brief In-process network connecting nsdl and CoAP handles through queues.
+ *
+ * Every datagram gets a delivery time from configured latency and jitter, and
+ * may be lost, duplicated or delayed past later datagrams. Time is virtual:
+ * it advances only when the network is run, and sn_nsdl_exec() and
+ * sn_coap_protocol_exec() of every node are called at each whole second.
+ * Random decisions come from a generator seeded by the configuration, so the
+ * same seed and the same sends give the same run.
+ *
+ * A network and its nodes must be used from one thread only.
+ */
+
+#ifndef LOOPBACK_NET_H_
+#define LOOPBACK_NET_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_nsdl_lib.h"
+
+/**
+ * \def LOOPBACK_NET_PORT
+ * \brief Port of a node added without explicit port.
+ */
+#define LOOPBACK_NET_PORT       5683
+
+struct loopback_net_s;
+struct loopback_node_s;
+
+/**
+ * \brief Network model. Probabilities are in parts per thousand.
+ */
+typedef struct loopback_net_config_ {
+    uint32_t latency_ms;        /**< Base one-way delay */
+    uint32_t jitter_ms;         /**< Random extra delay 0 .. jitter_ms */
+    uint16_t loss;              /**< Datagram is dropped */
+    uint16_t duplicate;         /**< Datagram is delivered twice */
+    uint16_t reorder;           /**< Datagram is held back by reorder_ms, so later ones overtake it */
+    uint32_t reorder_ms;
+    uint32_t seed;              /**< Random generator seed, 0 is replaced by 1 */
+} loopback_net_config_s;
+
+/**
+ * \brief Counters of one network.
+ */
+typedef struct loopback_net_stats_ {
+    uint32_t sent;              /**< Datagrams given to network */
+    uint32_t delivered;
+    uint32_t lost;
+    uint32_t duplicated;
+    uint32_t reordered;
+    uint32_t undeliverable;     /**< No node at destination address */
+    uint64_t bytes;             /**< Bytes given to network */
+} loopback_net_stats_s;
+
+/**
+ * \brief Receive callback of a CoAP node. Message is released by network after return.
+ */
+typedef void loopback_coap_rx_cb(struct loopback_node_s *node, sn_coap_hdr_s *coap_msg_ptr,
+                                 sn_nsdl_addr_s *src_addr_ptr, void *context);
+
+/**
+ * \brief Receive callback of a datagram node. Datagram is freed by network after return.
+ */
+typedef void loopback_datagram_rx_cb(struct loopback_node_s *node, uint8_t *data_ptr, uint16_t data_len,
+                                     sn_nsdl_addr_s *src_addr_ptr, void *context);
+
+/**
+ * \brief Called for a datagram node at each whole second, with time in seconds.
+ */
+typedef void loopback_exec_cb(struct loopback_node_s *node, uint32_t time, void *context);
+
+/**
+ * \fn struct loopback_net_s *loopback_net_create(const loopback_net_config_s *config)
+ *
+ * \brief Creates network. Virtual time starts from 1 second.
+ *
+ * \param *config Network model, NULL gives a perfect network with zero delay
+ *
+ * \return Pointer to network, NULL on failure
+ */
+extern struct loopback_net_s *loopback_net_create(const loopback_net_config_s *config);
+
+/**
+ * \fn void loopback_net_destroy(struct loopback_net_s *net)
+ *
+ * \brief Drops datagrams in flight and frees nodes. Handles of the nodes are not destroyed.
+ */
+extern void loopback_net_destroy(struct loopback_net_s *net);
+
+/**
+ * \fn void loopback_net_set_config(struct loopback_net_s *net, const loopback_net_config_s *config)
+ *
+ * \brief Changes network model for datagrams sent from now on. Random generator is not reseeded.
+ */
+extern void loopback_net_set_config(struct loopback_net_s *net, const loopback_net_config_s *config);
+
+/**
+ * \fn struct loopback_node_s *loopback_net_add_nsdl(struct loopback_net_s *net, struct nsdl_s *handle,
+ *                                                   const uint8_t addr[4], uint16_t port)
+ *
+ * \brief Attaches nsdl handle to network. Handle must be created with loopback_net_nsdl_tx() as TX callback.
+ *
+ * \param addr IPv4 address of the node
+ * \param port Port of the node
+ *
+ * \return Pointer to node, NULL on failure or if address is taken
+ */
+extern struct loopback_node_s *loopback_net_add_nsdl(struct loopback_net_s *net, struct nsdl_s *handle,
+        const uint8_t addr[4], uint16_t port);
+
+/**
+ * \fn struct loopback_node_s *loopback_net_add_coap(struct loopback_net_s *net, struct coap_s *handle,
+ *                                                   const uint8_t addr[4], uint16_t port,
+ *                                                   loopback_coap_rx_cb *rx_cb, void *context)
+ *
+ * \brief Attaches CoAP handle to network. Handle must be created with loopback_net_coap_tx() as TX callback,
+ *        and the node must be given as param to every sn_coap_protocol function that sends.
+ *
+ * \param *rx_cb Called for every message sn_coap_protocol_parse() returns
+ *
+ * \return Pointer to node, NULL on failure or if address is taken
+ */
+extern struct loopback_node_s *loopback_net_add_coap(struct loopback_net_s *net, struct coap_s *handle,
+        const uint8_t addr[4], uint16_t port,
+        loopback_coap_rx_cb *rx_cb, void *context);
+
+/**
+ * \fn struct loopback_node_s *loopback_net_add_datagram(struct loopback_net_s *net, const uint8_t addr[4], uint16_t port,
+ *                                                       loopback_datagram_rx_cb *rx_cb, loopback_exec_cb *exec_cb,
+ *                                                       void *context)
+ *
+ * \brief Attaches a node which handles raw datagrams itself, for example a server with its own CoAP handle.
+ *        The node sends with loopback_net_coap_tx(), giving the node as param.
+ *
+ * \param *rx_cb Called for every datagram delivered to the node
+ * \param *exec_cb Called at each whole second, can be NULL
+ *
+ * \return Pointer to node, NULL on failure or if address is taken
+ */
+extern struct loopback_node_s *loopback_net_add_datagram(struct loopback_net_s *net, const uint8_t addr[4], uint16_t port,
+        loopback_datagram_rx_cb *rx_cb, loopback_exec_cb *exec_cb,
+        void *context);
+
+/**
+ * \fn uint8_t loopback_net_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr,
+ *                                  uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+ *
+ * \brief TX callback for sn_nsdl_init(). Datagram is copied to network of calling thread.
+ *
+ * \return 1 if datagram was taken (even if it is going to be lost), 0 if handle is not a node
+ */
+extern uint8_t loopback_net_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr,
+                                    uint16_t data_len, sn_nsdl_addr_s *address_ptr);
+
+/**
+ * \fn uint8_t loopback_net_coap_tx(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *param)
+ *
+ * \brief TX callback for sn_coap_protocol_init(). Can also be called directly to send a built message.
+ *
+ * \param *param Sending node
+ */
+extern uint8_t loopback_net_coap_tx(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *param);
+
+/**
+ * \fn int loopback_net_run_until(struct loopback_net_s *net, uint64_t time_ms)
+ *
+ * \brief Advances virtual time to time_ms, delivering datagrams and executing nodes in time order.
+ *
+ * \return Count of delivered datagrams
+ */
+extern int loopback_net_run_until(struct loopback_net_s *net, uint64_t time_ms);
+
+/**
+ * \fn int loopback_net_run_for(struct loopback_net_s *net, uint32_t duration_ms)
+ *
+ * \brief Advances virtual time by duration_ms, see loopback_net_run_until().
+ */
+extern int loopback_net_run_for(struct loopback_net_s *net, uint32_t duration_ms);
+
+/**
+ * \fn int loopback_net_pending(const struct loopback_net_s *net)
+ *
+ * \brief Returns count of datagrams in flight.
+ */
+extern int loopback_net_pending(const struct loopback_net_s *net);
+
+/**
+ * \fn uint64_t loopback_net_time_ms(const struct loopback_net_s *net)
+ *
+ * \brief Returns virtual time in milliseconds.
+ */
+extern uint64_t loopback_net_time_ms(const struct loopback_net_s *net);
+
+/**
+ * \fn uint32_t loopback_net_time(const struct loopback_net_s *net)
+ *
+ * \brief Returns virtual time in seconds, as given to exec functions of nodes.
+ */
+extern uint32_t loopback_net_time(const struct loopback_net_s *net);
+
+/**
+ * \fn void loopback_net_get_stats(const struct loopback_net_s *net, loopback_net_stats_s *stats)
+ *
+ * \brief Copies network counters.
+ */
+extern void loopback_net_get_stats(const struct loopback_net_s *net, loopback_net_stats_s *stats);
+
+/**
+ * \fn void loopback_node_get_address(const struct loopback_node_s *node, sn_nsdl_addr_s *addr)
+ *
+ * \brief Fills address of node. addr_ptr points inside node.
+ */
+extern void loopback_node_get_address(const struct loopback_node_s *node, sn_nsdl_addr_s *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOOPBACK_NET_H_ */
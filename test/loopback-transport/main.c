@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Registers an endpoint over a lossy loopback network once per seed and
+ * prints how long registration took and how many datagrams it needed.
+ * Usage: loopback-transport-example [-runs 20] [-latency 50] [-jitter 20]
+ *                                   [-loss 200] [-dup 0] [-reorder 0]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "loopback_net.h"
+
+#define REGISTRATION_TIMEOUT_MS     300000
+
+static const uint8_t server_addr[4] = {10, 0, 0, 1};
+static const uint8_t client_addr[4] = {10, 0, 0, 2};
+static uint8_t location_path[] = {"rd/loop"};
+static uint8_t endpoint_name[] = {"loopback"};
+
+static int registration_result;  /* 1 registered, -1 retransmissions ran out */
+
+static void *own_alloc(sn_coap_len_t size)
+{
+    if (size) {
+        return malloc(size);
+    }
+    return 0;
+}
+
+static void own_free(void *ptr)
+{
+    free(ptr);
+}
+
+static uint8_t client_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address)
+{
+    (void)handle;
+    (void)address;
+    if (coap_header && coap_header->msg_code == COAP_MSG_CODE_RESPONSE_CREATED) {
+        registration_result = 1;
+    } else if (coap_header && coap_header->coap_status == COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED) {
+        registration_result = -1;
+    }
+    return 0;
+}
+
+/* Answers every confirmable POST with piggybacked 2.01 Created */
+static void server_rx(struct loopback_node_s *node, sn_coap_hdr_s *coap_msg_ptr, sn_nsdl_addr_s *src_addr_ptr, void *context)
+{
+    struct coap_s *coap = context;
+    sn_coap_hdr_s response;
+    sn_coap_options_list_s options;
+    uint8_t packet[64];
+    int16_t packet_len;
+
+    if (coap_msg_ptr->msg_type != COAP_MSG_TYPE_CONFIRMABLE || coap_msg_ptr->msg_code != COAP_MSG_CODE_REQUEST_POST) {
+        return;
+    }
+
+    memset(&response, 0, sizeof(response));
+    memset(&options, 0, sizeof(options));
+    options.max_age = 60;
+    options.uri_port = -1;
+    options.observe = -1;
+    options.accept = COAP_CT_NONE;
+    options.block1 = -1;
+    options.block2 = -1;
+    options.location_path_ptr = location_path;
+    options.location_path_len = sizeof(location_path) - 1;
+
+    response.msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+    response.msg_code = COAP_MSG_CODE_RESPONSE_CREATED;
+    response.msg_id = coap_msg_ptr->msg_id;
+    response.token_ptr = coap_msg_ptr->token_ptr;
+    response.token_len = coap_msg_ptr->token_len;
+    response.content_format = COAP_CT_NONE;
+    response.options_list_ptr = &options;
+
+    packet_len = sn_coap_protocol_build(coap, src_addr_ptr, packet, &response, node);
+    if (packet_len > 0) {
+        loopback_net_coap_tx(packet, (uint16_t)packet_len, src_addr_ptr, node);
+    }
+}
+
+static int run_once(const loopback_net_config_s *config, uint32_t *time_ms, loopback_net_stats_s *stats)
+{
+    struct loopback_net_s *net = loopback_net_create(config);
+    struct coap_s *server = sn_coap_protocol_init(&own_alloc, &own_free, &loopback_net_coap_tx, NULL);
+    struct nsdl_s *client = sn_nsdl_init(&loopback_net_nsdl_tx, &client_rx, &own_alloc, &own_free);
+    sn_nsdl_ep_parameters_s endpoint;
+    uint64_t start_ms;
+
+    if (!net || !server || !client ||
+            !loopback_net_add_coap(net, server, server_addr, LOOPBACK_NET_PORT, &server_rx, server) ||
+            !loopback_net_add_nsdl(net, client, client_addr, LOOPBACK_NET_PORT)) {
+        printf("Init failed\n");
+        exit(1);
+    }
+
+    set_NSP_address(client, (uint8_t *)server_addr, LOOPBACK_NET_PORT, SN_NSDL_ADDRESS_TYPE_IPV4);
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = endpoint_name;
+    endpoint.endpoint_name_len = sizeof(endpoint_name) - 1;
+
+    registration_result = 0;
+    start_ms = loopback_net_time_ms(net);
+    sn_nsdl_register_endpoint(client, &endpoint);
+    while (!registration_result && loopback_net_time_ms(net) - start_ms < REGISTRATION_TIMEOUT_MS) {
+        loopback_net_run_for(net, 10);
+    }
+
+    *time_ms = (uint32_t)(loopback_net_time_ms(net) - start_ms);
+    loopback_net_get_stats(net, stats);
+
+    loopback_net_destroy(net);
+    sn_nsdl_destroy(client);
+    sn_coap_protocol_destroy(server);
+    return registration_result;
+}
+
+int main(int argc, char **argv)
+{
+    loopback_net_config_s config;
+    int runs = 20;
+    int succeeded = 0;
+    uint64_t total_time_ms = 0;
+    uint64_t total_sent = 0;
+    int i;
+
+    memset(&config, 0, sizeof(config));
+    config.latency_ms = 50;
+    config.jitter_ms = 20;
+    config.loss = 200;
+    config.reorder_ms = 100;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            break;
+        }
+        if (!strcmp("-runs", argv[i])) {
+            runs = atoi(argv[++i]);
+        } else if (!strcmp("-latency", argv[i])) {
+            config.latency_ms = atoi(argv[++i]);
+        } else if (!strcmp("-jitter", argv[i])) {
+            config.jitter_ms = atoi(argv[++i]);
+        } else if (!strcmp("-loss", argv[i])) {
+            config.loss = atoi(argv[++i]);
+        } else if (!strcmp("-dup", argv[i])) {
+            config.duplicate = atoi(argv[++i]);
+        } else if (!strcmp("-reorder", argv[i])) {
+            config.reorder = atoi(argv[++i]);
+        } else {
+            break;
+        }
+    }
+    if (i < argc) {
+        printf("Usage: loopback-transport-example [-runs 20] [-latency 50] [-jitter 20] [-loss 200] [-dup 0] [-reorder 0]\n");
+        return 1;
+    }
+
+    for (i = 0; i < runs; i++) {
+        loopback_net_stats_s stats;
+        uint32_t time_ms;
+        int result;
+
+        config.seed = i + 1;
+        result = run_once(&config, &time_ms, &stats);
+        if (result > 0) {
+            succeeded++;
+            total_time_ms += time_ms;
+            total_sent += stats.sent;
+        }
+        printf("seed %d: %s in %u ms, sent %u lost %u duplicated %u reordered %u\n", i + 1,
+               result > 0 ? "registered" : result < 0 ? "failed" : "timeout", time_ms,
+               stats.sent, stats.lost, stats.duplicated, stats.reordered);
+    }
+
+    if (succeeded) {
+        printf("%d/%d registered, average %llu ms and %.1f datagrams\n", succeeded, runs,
+               (unsigned long long)(total_time_ms / succeeded), (double)total_sent / succeeded);
+    } else {
+        printf("0/%d registered\n", runs);
+    }
+    return succeeded == runs ? 0 : 1;
+}
@@ -0,0 +1,1108 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ns_list.h"
+#include "lwm2m_server.h"
+#include "sn_coap_protocol.h"
+
+#define LWM2M_SERVER_HASH_MIN_SIZE  64
+#define LWM2M_SERVER_TOKEN_LEN      4           /* Request ID in network byte order */
+#define LWM2M_SERVER_DOMAIN         "local"     /* Domain of endpoints registering without d parameter */
+
+typedef struct lwm2m_server_ep_ {
+    lwm2m_server_endpoint_s     pub;            /* First, public pointers are cast back */
+    uint8_t                     addr[16];
+    struct lwm2m_server_ep_     *hash_next;
+    ns_list_link_t              link;
+} lwm2m_server_ep_s;
+
+typedef NS_LIST_HEAD(lwm2m_server_ep_s, link) lwm2m_server_ep_list_t;
+
+typedef struct lwm2m_server_request_ {
+    int32_t                     id;
+    uint8_t                     observe;
+    uint8_t                     observing;      /* First response received, notifications follow */
+    uint32_t                    sent_time;
+    lwm2m_server_ep_s           *endpoint;      /* NULL after endpoint was removed */
+    char                        *path;
+    uint8_t                     *payload;       /* Payload to write, or response collected block by block */
+    uint32_t                    payload_len;
+    uint32_t                    payload_size;
+    lwm2m_server_response_cb    *response_cb;
+    void                        *context;
+    struct lwm2m_server_request_ *hash_next;
+    ns_list_link_t              link;
+} lwm2m_server_request_s;
+
+typedef NS_LIST_HEAD(lwm2m_server_request_s, link) lwm2m_server_request_list_t;
+
+/* Context of a libCoap transfer, freed by libCoap. Request is looked up by ID, as it may be gone. */
+typedef struct lwm2m_server_transfer_ {
+    struct lwm2m_server_s       *server;
+    int32_t                     request_id;
+} lwm2m_server_transfer_s;
+
+struct lwm2m_server_s {
+    struct coap_s               *coap;
+    lwm2m_server_send_cb        *send_cb;
+    void                        *send_context;
+    lwm2m_server_event_cb       *event_cb;
+    void                        *event_context;
+    uint32_t                    time;
+    int32_t                     last_request_id;
+
+    lwm2m_server_ep_list_t      endpoints;
+    lwm2m_server_ep_s           **hash;
+    uint32_t                    hash_size;
+    uint32_t                    endpoint_count;
+
+    lwm2m_server_request_list_t requests;
+    lwm2m_server_request_s      **request_hash; /* By ID, every observation stays here while it lasts */
+    uint32_t                    request_hash_size;
+    uint32_t                    request_count;
+
+    lwm2m_server_stats_s        stats;
+};
+
+static void *lwm2m_server_alloc(sn_coap_len_t size)
+{
+    if (size) {
+        return malloc(size);
+    }
+    return NULL;
+}
+
+static void lwm2m_server_free(void *ptr)
+{
+    free(ptr);
+}
+
+static char *lwm2m_server_strdup(const uint8_t *ptr, uint16_t len)
+{
+    char *str = malloc(len + 1);
+
+    if (str) {
+        memcpy(str, ptr, len);
+        str[len] = '\0';
+    }
+    return str;
+}
+
+/* FNV-1a */
+static uint32_t lwm2m_server_hash_name(const uint8_t *name, uint16_t name_len, uint32_t hash_size)
+{
+    uint32_t hash = 2166136261u;
+    uint16_t i;
+
+    for (i = 0; i < name_len; i++) {
+        hash = (hash ^ name[i]) * 16777619u;
+    }
+    return hash & (hash_size - 1);
+}
+
+static int lwm2m_server_hash_resize(struct lwm2m_server_s *server, uint32_t new_size)
+{
+    lwm2m_server_ep_s **hash = calloc(new_size, sizeof(lwm2m_server_ep_s *));
+
+    if (!hash) {
+        return -1;
+    }
+    ns_list_foreach(lwm2m_server_ep_s, ep, &server->endpoints) {
+        uint32_t index = lwm2m_server_hash_name((const uint8_t *)ep->pub.name, strlen(ep->pub.name), new_size);
+        ep->hash_next = hash[index];
+        hash[index] = ep;
+    }
+    free(server->hash);
+    server->hash = hash;
+    server->hash_size = new_size;
+    return 0;
+}
+
+static lwm2m_server_ep_s *lwm2m_server_find_ep(const struct lwm2m_server_s *server, const uint8_t *name, uint16_t name_len)
+{
+    lwm2m_server_ep_s *ep = server->hash[lwm2m_server_hash_name(name, name_len, server->hash_size)];
+
+    while (ep && (strlen(ep->pub.name) != name_len || memcmp(ep->pub.name, name, name_len))) {
+        ep = ep->hash_next;
+    }
+    return ep;
+}
+
+/* IDs are consecutive, so low bits spread them evenly */
+static int lwm2m_server_request_hash_resize(struct lwm2m_server_s *server, uint32_t new_size)
+{
+    lwm2m_server_request_s **hash = calloc(new_size, sizeof(lwm2m_server_request_s *));
+
+    if (!hash) {
+        return -1;
+    }
+    ns_list_foreach(lwm2m_server_request_s, req, &server->requests) {
+        uint32_t index = (uint32_t)req->id & (new_size - 1);
+        req->hash_next = hash[index];
+        hash[index] = req;
+    }
+    free(server->request_hash);
+    server->request_hash = hash;
+    server->request_hash_size = new_size;
+    return 0;
+}
+
+static void lwm2m_server_link_request(struct lwm2m_server_s *server, lwm2m_server_request_s *req)
+{
+    uint32_t index;
+
+    ns_list_add_to_end(&server->requests, req);
+    server->request_count++;
+
+    /* If growing fails, chains just get longer */
+    if (server->request_count < server->request_hash_size * 2 ||
+            lwm2m_server_request_hash_resize(server, server->request_hash_size * 2) != 0) {
+        index = (uint32_t)req->id & (server->request_hash_size - 1);
+        req->hash_next = server->request_hash[index];
+        server->request_hash[index] = req;
+    }
+}
+
+static void lwm2m_server_unlink_request(struct lwm2m_server_s *server, lwm2m_server_request_s *req)
+{
+    lwm2m_server_request_s **prev = &server->request_hash[(uint32_t)req->id & (server->request_hash_size - 1)];
+
+    while (*prev != req) {
+        prev = &(*prev)->hash_next;
+    }
+    *prev = req->hash_next;
+    ns_list_remove(&server->requests, req);
+    server->request_count--;
+}
+
+static lwm2m_server_request_s *lwm2m_server_find_request(const struct lwm2m_server_s *server, int32_t request_id)
+{
+    lwm2m_server_request_s *req = server->request_hash[(uint32_t)request_id & (server->request_hash_size - 1)];
+
+    while (req && req->id != request_id) {
+        req = req->hash_next;
+    }
+    return req;
+}
+
+static lwm2m_server_request_s *lwm2m_server_find_token(const struct lwm2m_server_s *server, const sn_coap_hdr_s *msg)
+{
+    const uint8_t *token = msg->token_ptr;
+
+    if (msg->token_len != LWM2M_SERVER_TOKEN_LEN || !token) {
+        return NULL;
+    }
+    return lwm2m_server_find_request(server, (int32_t)((uint32_t)token[0] << 24 | (uint32_t)token[1] << 16 |
+                                     (uint32_t)token[2] << 8 | token[3]));
+}
+
+/* libCoap builder omits Uri-Path from messages carrying Observe, as on a client only notifications do.
+ * Observe requests are therefore built without it, and Observe=0 is inserted here in front of Uri-Path,
+ * which covers retransmissions and blockwise follow-ups as well. */
+static uint8_t lwm2m_server_coap_tx(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    struct lwm2m_server_s *server = param;
+    const uint16_t opt_offset = 4 + LWM2M_SERVER_TOKEN_LEN;
+    lwm2m_server_request_s *req = NULL;
+    uint8_t delta;
+    uint8_t *packet;
+    uint8_t ret_val;
+
+    if (!server) {
+        return 0;
+    }
+    server->stats.tx_datagrams++;
+
+    if (data_len > opt_offset && (data_ptr[0] & 0x0F) == LWM2M_SERVER_TOKEN_LEN &&
+            data_ptr[1] == COAP_MSG_CODE_REQUEST_GET) {
+        req = lwm2m_server_find_request(server, (int32_t)((uint32_t)data_ptr[4] << 24 | (uint32_t)data_ptr[5] << 16 |
+                                        (uint32_t)data_ptr[6] << 8 | data_ptr[7]));
+    }
+    delta = data_len > opt_offset ? data_ptr[opt_offset] >> 4 : 0;
+    if (!req || !req->observe || req->observing || delta < COAP_OPTION_OBSERVE || delta >= 13) {
+        return server->send_cb(data_ptr, data_len, address_ptr, server->send_context);
+    }
+
+    packet = malloc(data_len + 1);
+    if (!packet) {
+        return 0;
+    }
+    memcpy(packet, data_ptr, opt_offset);
+    packet[opt_offset] = COAP_OPTION_OBSERVE << 4;
+    memcpy(packet + opt_offset + 1, data_ptr + opt_offset, data_len - opt_offset);
+    packet[opt_offset + 1] = (uint8_t)((delta - COAP_OPTION_OBSERVE) << 4 | (data_ptr[opt_offset] & 0x0F));
+    ret_val = server->send_cb(packet, data_len + 1, address_ptr, server->send_context);
+    free(packet);
+    return ret_val;
+}
+
+/* Returns value of key=value parameter from Uri-Query, NULL if not present */
+static const uint8_t *lwm2m_server_query(const sn_coap_hdr_s *msg, const char *key, uint16_t *value_len)
+{
+    const uint8_t *query;
+    uint16_t query_len;
+    size_t key_len = strlen(key);
+
+    if (!msg->options_list_ptr || !msg->options_list_ptr->uri_query_ptr) {
+        return NULL;
+    }
+    query = msg->options_list_ptr->uri_query_ptr;
+    query_len = msg->options_list_ptr->uri_query_len;
+
+    while (query_len) {
+        const uint8_t *end = memchr(query, '&', query_len);
+        uint16_t len = end ? (uint16_t)(end - query) : query_len;
+
+        if (len > key_len && query[key_len] == '=' && !memcmp(query, key, key_len)) {
+            *value_len = len - key_len - 1;
+            return query + key_len + 1;
+        }
+        if (!end) {
+            break;
+        }
+        query_len -= len + 1;
+        query = end + 1;
+    }
+    return NULL;
+}
+
+static uint32_t lwm2m_server_parse_uint(const uint8_t *ptr, uint16_t len)
+{
+    uint32_t value = 0;
+
+    while (len-- && *ptr >= '0' && *ptr <= '9') {
+        value = value * 10 + (*ptr++ - '0');
+    }
+    return value;
+}
+
+static void lwm2m_server_init_options(sn_coap_options_list_s *options)
+{
+    memset(options, 0, sizeof(sn_coap_options_list_s));
+    options->max_age = 60;
+    options->uri_port = -1;
+    options->observe = -1;
+    options->accept = COAP_CT_NONE;
+    options->block1 = -1;
+    options->block2 = -1;
+}
+
+static void lwm2m_server_build_and_send(struct lwm2m_server_s *server, sn_nsdl_addr_s *dst_addr_ptr, sn_coap_hdr_s *msg)
+{
+    uint16_t packet_size = sn_coap_builder_calc_needed_packet_data_size(msg);
+    uint8_t *packet = packet_size ? malloc(packet_size) : NULL;
+    int16_t packet_len;
+
+    if (!packet) {
+        return;
+    }
+    packet_len = sn_coap_protocol_build(server->coap, dst_addr_ptr, packet, msg, server);
+    if (packet_len > 0) {
+        lwm2m_server_coap_tx(packet, (uint16_t)packet_len, dst_addr_ptr, server);
+    }
+    free(packet);
+}
+
+/* Sends empty Acknowledgement or Reset */
+static void lwm2m_server_send_empty(struct lwm2m_server_s *server, sn_coap_msg_type_e msg_type, uint16_t msg_id,
+                                    sn_nsdl_addr_s *dst_addr_ptr)
+{
+    sn_coap_hdr_s msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = msg_type;
+    msg.msg_code = COAP_MSG_CODE_EMPTY;
+    msg.msg_id = msg_id;
+    msg.content_format = COAP_CT_NONE;
+    lwm2m_server_build_and_send(server, dst_addr_ptr, &msg);
+}
+
+static void lwm2m_server_send_response(struct lwm2m_server_s *server, const sn_coap_hdr_s *request,
+                                       sn_nsdl_addr_s *dst_addr_ptr, sn_coap_msg_code_e msg_code, const char *location)
+{
+    sn_coap_hdr_s response;
+    sn_coap_options_list_s options;
+
+    memset(&response, 0, sizeof(response));
+    if (request->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
+        response.msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+        response.msg_id = request->msg_id;
+    } else {
+        response.msg_type = COAP_MSG_TYPE_NON_CONFIRMABLE;
+    }
+    response.msg_code = msg_code;
+    response.token_ptr = request->token_ptr;
+    response.token_len = request->token_len;
+    response.content_format = COAP_CT_NONE;
+
+    if (location) {
+        lwm2m_server_init_options(&options);
+        options.location_path_ptr = (uint8_t *)location;
+        options.location_path_len = strlen(location);
+        response.options_list_ptr = &options;
+    }
+
+    lwm2m_server_build_and_send(server, dst_addr_ptr, &response);
+}
+
+static int lwm2m_server_set_string(char **str_ptr, const uint8_t *ptr, uint16_t len)
+{
+    char *str = lwm2m_server_strdup(ptr, len);
+
+    if (!str) {
+        return -2;
+    }
+    free(*str_ptr);
+    *str_ptr = str;
+    return 0;
+}
+
+/* Takes lifetime, binding, links and address from registration or update */
+static int lwm2m_server_update_ep(struct lwm2m_server_s *server, lwm2m_server_ep_s *ep, const sn_coap_hdr_s *msg,
+                                  const sn_nsdl_addr_s *src_addr_ptr)
+{
+    const uint8_t *value;
+    uint16_t value_len;
+
+    value = lwm2m_server_query(msg, "lt", &value_len);
+    if (value) {
+        ep->pub.lifetime = lwm2m_server_parse_uint(value, value_len);
+    }
+    value = lwm2m_server_query(msg, "b", &value_len);
+    if (value && lwm2m_server_set_string(&ep->pub.binding, value, value_len) != 0) {
+        return -2;
+    }
+    if (msg->payload_ptr && msg->payload_len) {
+        uint8_t *links = malloc(msg->payload_len);
+        if (!links) {
+            return -2;
+        }
+        memcpy(links, msg->payload_ptr, msg->payload_len);
+        free(ep->pub.links);
+        ep->pub.links = links;
+        ep->pub.links_len = msg->payload_len;
+    }
+
+    if (src_addr_ptr->addr_len <= sizeof(ep->addr)) {
+        memcpy(ep->addr, src_addr_ptr->addr_ptr, src_addr_ptr->addr_len);
+        ep->pub.addr.addr_ptr = ep->addr;
+        ep->pub.addr.addr_len = src_addr_ptr->addr_len;
+        ep->pub.addr.port = src_addr_ptr->port;
+        ep->pub.addr.type = src_addr_ptr->type;
+    }
+    ep->pub.updated_time = server->time;
+    return 0;
+}
+
+static lwm2m_server_ep_s *lwm2m_server_add_ep(struct lwm2m_server_s *server, const uint8_t *name, uint16_t name_len,
+        const sn_coap_hdr_s *msg)
+{
+    lwm2m_server_ep_s *ep;
+    const uint8_t *domain;
+    uint16_t domain_len;
+    uint32_t index;
+
+    if (server->endpoint_count >= server->hash_size * 2 &&
+            lwm2m_server_hash_resize(server, server->hash_size * 2) != 0) {
+        return NULL;
+    }
+
+    ep = calloc(1, sizeof(lwm2m_server_ep_s));
+    if (!ep) {
+        return NULL;
+    }
+
+    domain = lwm2m_server_query(msg, "d", &domain_len);
+    if (!domain) {
+        domain = (const uint8_t *)LWM2M_SERVER_DOMAIN;
+        domain_len = sizeof(LWM2M_SERVER_DOMAIN) - 1;
+    }
+    ep->pub.name = lwm2m_server_strdup(name, name_len);
+    ep->pub.domain = lwm2m_server_strdup(domain, domain_len);
+    ep->pub.location = malloc(sizeof("rd//") + domain_len + name_len);
+    if (!ep->pub.name || !ep->pub.domain || !ep->pub.location) {
+        free(ep->pub.name);
+        free(ep->pub.domain);
+        free(ep->pub.location);
+        free(ep);
+        return NULL;
+    }
+    /* Client updates and deregisters at rd/domain/name, so updates find the endpoint by name */
+    strcpy(ep->pub.location, "rd/");
+    strcat(ep->pub.location, ep->pub.domain);
+    strcat(ep->pub.location, "/");
+    strcat(ep->pub.location, ep->pub.name);
+
+    index = lwm2m_server_hash_name(name, name_len, server->hash_size);
+    ep->hash_next = server->hash[index];
+    server->hash[index] = ep;
+    ns_list_add_to_end(&server->endpoints, ep);
+    server->endpoint_count++;
+    return ep;
+}
+
+static void lwm2m_server_complete(struct lwm2m_server_s *server, lwm2m_server_request_s *req, sn_coap_msg_code_e msg_code,
+                                  const uint8_t *payload_ptr, uint32_t payload_len)
+{
+    lwm2m_server_result_s result;
+
+    lwm2m_server_unlink_request(server, req);
+
+    if (msg_code == COAP_MSG_CODE_EMPTY || msg_code >= COAP_MSG_CODE_RESPONSE_BAD_REQUEST) {
+        server->stats.failures++;
+    }
+
+    if (req->response_cb) {
+        memset(&result, 0, sizeof(result));
+        result.request_id = req->id;
+        result.path = req->path;
+        result.msg_code = msg_code;
+        result.payload = payload_ptr;
+        result.payload_len = payload_len;
+        req->response_cb(server, req->endpoint ? &req->endpoint->pub : NULL, &result, req->context);
+    }
+
+    free(req->path);
+    free(req->payload);
+    free(req);
+}
+
+static void lwm2m_server_remove_ep(struct lwm2m_server_s *server, lwm2m_server_ep_s *ep, lwm2m_server_event_e event)
+{
+    lwm2m_server_ep_s **prev = &server->hash[lwm2m_server_hash_name((const uint8_t *)ep->pub.name,
+                                             strlen(ep->pub.name), server->hash_size)];
+    lwm2m_server_request_s *req;
+
+    while (*prev != ep) {
+        prev = &(*prev)->hash_next;
+    }
+    *prev = ep->hash_next;
+    ns_list_remove(&server->endpoints, ep);
+    server->endpoint_count--;
+
+    if (server->event_cb) {
+        server->event_cb(server, event, &ep->pub, server->event_context);
+    }
+
+    /* Callbacks may cancel other requests, so search again after each one */
+    do {
+        req = NULL;
+        ns_list_foreach(lwm2m_server_request_s, cur, &server->requests) {
+            if (cur->endpoint == ep) {
+                req = cur;
+                break;
+            }
+        }
+        if (req) {
+            req->endpoint = NULL;
+            lwm2m_server_complete(server, req, COAP_MSG_CODE_EMPTY, NULL, 0);
+        }
+    } while (req);
+
+    free(ep->pub.name);
+    free(ep->pub.domain);
+    free(ep->pub.location);
+    free(ep->pub.binding);
+    free(ep->pub.links);
+    free(ep);
+}
+
+static void lwm2m_server_event(struct lwm2m_server_s *server, lwm2m_server_event_e event, lwm2m_server_ep_s *ep)
+{
+    if (server->event_cb) {
+        server->event_cb(server, event, &ep->pub, server->event_context);
+    }
+}
+
+static void lwm2m_server_register(struct lwm2m_server_s *server, sn_coap_hdr_s *msg, sn_nsdl_addr_s *src_addr_ptr)
+{
+    const uint8_t *name;
+    uint16_t name_len;
+    lwm2m_server_ep_s *ep;
+
+    name = lwm2m_server_query(msg, "ep", &name_len);
+    if (!name || !name_len) {
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_BAD_REQUEST, NULL);
+        return;
+    }
+
+    /* Registration with a known name replaces the old one */
+    ep = lwm2m_server_find_ep(server, name, name_len);
+    if (!ep) {
+        ep = lwm2m_server_add_ep(server, name, name_len, msg);
+        if (!ep) {
+            lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR, NULL);
+            return;
+        }
+    }
+
+    ep->pub.lifetime = LWM2M_SERVER_DEFAULT_LIFETIME;
+    ep->pub.registered_time = server->time;
+    ep->pub.update_count = 0;
+    if (lwm2m_server_update_ep(server, ep, msg, src_addr_ptr) != 0) {
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR, NULL);
+        lwm2m_server_remove_ep(server, ep, LWM2M_SERVER_DEREGISTERED);
+        return;
+    }
+
+    server->stats.registrations++;
+    lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_CREATED, ep->pub.location);
+    lwm2m_server_event(server, LWM2M_SERVER_REGISTERED, ep);
+}
+
+static void lwm2m_server_handle_request(struct lwm2m_server_s *server, sn_coap_hdr_s *msg, sn_nsdl_addr_s *src_addr_ptr)
+{
+    const uint8_t *path = msg->uri_path_ptr;
+    uint16_t path_len = msg->uri_path_len;
+    const uint8_t *name;
+    lwm2m_server_ep_s *ep;
+
+    if (!path || path_len < 2 || memcmp(path, "rd", 2) || (path_len > 2 && path[2] != '/')) {
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_NOT_FOUND, NULL);
+        return;
+    }
+
+    if (path_len == 2) {
+        if (msg->msg_code == COAP_MSG_CODE_REQUEST_POST) {
+            lwm2m_server_register(server, msg, src_addr_ptr);
+        } else {
+            lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED, NULL);
+        }
+        return;
+    }
+
+    /* Last segment of rd/domain/name */
+    name = path + path_len;
+    while (name[-1] != '/') {
+        name--;
+    }
+    ep = lwm2m_server_find_ep(server, name, (uint16_t)(path + path_len - name));
+    if (!ep) {
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_NOT_FOUND, NULL);
+        return;
+    }
+
+    if (msg->msg_code == COAP_MSG_CODE_REQUEST_POST) {
+        if (lwm2m_server_update_ep(server, ep, msg, src_addr_ptr) != 0) {
+            lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR, NULL);
+            return;
+        }
+        ep->pub.update_count++;
+        server->stats.updates++;
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_CHANGED, NULL);
+        lwm2m_server_event(server, LWM2M_SERVER_UPDATED, ep);
+    } else if (msg->msg_code == COAP_MSG_CODE_REQUEST_DELETE) {
+        server->stats.deregistrations++;
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_DELETED, NULL);
+        lwm2m_server_remove_ep(server, ep, LWM2M_SERVER_DEREGISTERED);
+    } else {
+        lwm2m_server_send_response(server, msg, src_addr_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED, NULL);
+    }
+}
+
+static void lwm2m_server_handle_response(struct lwm2m_server_s *server, sn_coap_hdr_s *msg, sn_nsdl_addr_s *src_addr_ptr)
+{
+    lwm2m_server_request_s *req = lwm2m_server_find_token(server, msg);
+    const uint8_t *payload_ptr = msg->payload_ptr;
+    uint32_t payload_len = msg->payload_len;
+
+    if (!req) {
+        /* Notification of a cancelled observation, Reset ends it */
+        if (msg->msg_type == COAP_MSG_TYPE_CONFIRMABLE || msg->msg_type == COAP_MSG_TYPE_NON_CONFIRMABLE) {
+            lwm2m_server_send_empty(server, COAP_MSG_TYPE_RESET, msg->msg_id, src_addr_ptr);
+        }
+        return;
+    }
+
+    /* Separate response or notification */
+    if (msg->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
+        lwm2m_server_send_empty(server, COAP_MSG_TYPE_ACKNOWLEDGEMENT, msg->msg_id, src_addr_ptr);
+    }
+
+    switch (msg->coap_status) {
+        case COAP_STATUS_PARSER_DUPLICATED_MSG:
+        case COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING:
+        case COAP_STATUS_PARSER_BLOCKWISE_ACK:
+            return;
+        case COAP_STATUS_PARSER_BLOCKWISE_MSG_REJECTED:
+            lwm2m_server_complete(server, req, COAP_MSG_CODE_EMPTY, NULL, 0);
+            return;
+        case COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED:
+            if (!payload_ptr) {
+                /* Blocks were given to lwm2m_server_payload_sink() */
+                payload_ptr = req->payload;
+                payload_len = req->payload_len;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (req->observing) {
+        lwm2m_server_result_s result;
+
+        server->stats.notifications++;
+        if (msg->msg_code >= COAP_MSG_CODE_RESPONSE_BAD_REQUEST) {
+            lwm2m_server_complete(server, req, msg->msg_code, payload_ptr, payload_len);
+            return;
+        }
+        if (req->response_cb) {
+            memset(&result, 0, sizeof(result));
+            result.request_id = req->id;
+            result.path = req->path;
+        result.path = req->path;
+            result.msg_code = msg->msg_code;
+            result.notification = 1;
+            result.payload = payload_ptr;
+            result.payload_len = payload_len;
+            req->response_cb(server, req->endpoint ? &req->endpoint->pub : NULL, &result, req->context);
+        }
+        return;
+    }
+
+    server->stats.responses++;
+    if (req->observe && msg->msg_code == COAP_MSG_CODE_RESPONSE_CONTENT &&
+            msg->options_list_ptr && msg->options_list_ptr->observe >= 0) {
+        lwm2m_server_result_s result;
+        uint8_t *collected = req->payload;
+
+        /* Callback may cancel the observation, so collected payload is detached first */
+        req->observing = 1;
+        req->payload = NULL;
+        req->payload_len = 0;
+        req->payload_size = 0;
+        if (req->response_cb) {
+            memset(&result, 0, sizeof(result));
+            result.request_id = req->id;
+            result.path = req->path;
+        result.path = req->path;
+            result.msg_code = msg->msg_code;
+            result.payload = payload_ptr;
+            result.payload_len = payload_len;
+            req->response_cb(server, req->endpoint ? &req->endpoint->pub : NULL, &result, req->context);
+        }
+        free(collected);
+        return;
+    }
+
+    lwm2m_server_complete(server, req, msg->msg_code, payload_ptr, payload_len);
+}
+
+/* libCoap calls this when a request was not answered after all retransmissions */
+static int8_t lwm2m_server_coap_rx(sn_coap_hdr_s *msg, sn_nsdl_addr_s *addr, void *param)
+{
+    struct lwm2m_server_s *server = param;
+    lwm2m_server_request_s *req;
+
+    (void)addr;
+    if (!server || !msg || msg->coap_status != COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED) {
+        return 0;
+    }
+    req = lwm2m_server_find_token(server, msg);
+    if (req && !req->observing) {
+        lwm2m_server_complete(server, req, COAP_MSG_CODE_EMPTY, NULL, 0);
+    }
+    return 0;
+}
+
+#if LWM2M_SERVER_BLOCKWISE
+static uint16_t lwm2m_server_payload_sink(void *context, uint32_t offset, const uint8_t *data, uint16_t len)
+{
+    lwm2m_server_transfer_s *transfer = context;
+    lwm2m_server_request_s *req = lwm2m_server_find_request(transfer->server, transfer->request_id);
+
+    if (!req || offset + len > LWM2M_SERVER_MAX_PAYLOAD) {
+        return 0;
+    }
+    if (offset + len > req->payload_size) {
+        uint32_t new_size = req->payload_size ? req->payload_size * 2 : LWM2M_SERVER_BLOCK_SIZE;
+        uint8_t *payload;
+
+        while (new_size < offset + len) {
+            new_size *= 2;
+        }
+        payload = realloc(req->payload, new_size);
+        if (!payload) {
+            return 0;
+        }
+        req->payload = payload;
+        req->payload_size = new_size;
+    }
+
+    /* Blocks may arrive out of order */
+    memcpy(req->payload + offset, data, len);
+    if (offset + len > req->payload_len) {
+        req->payload_len = offset + len;
+    }
+    return len;
+}
+
+static uint16_t lwm2m_server_payload_source(void *context, uint32_t offset, uint8_t *data, uint16_t len)
+{
+    lwm2m_server_transfer_s *transfer = context;
+    lwm2m_server_request_s *req = lwm2m_server_find_request(transfer->server, transfer->request_id);
+
+    if (!req || offset + len > req->payload_len) {
+        return 0;
+    }
+    memcpy(data, req->payload + offset, len);
+    return len;
+}
+#endif
+
+static int8_t lwm2m_server_send_request(struct lwm2m_server_s *server, lwm2m_server_request_s *req, sn_coap_hdr_s *msg)
+{
+    sn_nsdl_addr_s *dst_addr_ptr = &req->endpoint->pub.addr;
+    uint16_t packet_size;
+    uint8_t *packet;
+    int16_t packet_len;
+
+#if LWM2M_SERVER_BLOCKWISE
+    if (msg->msg_code == COAP_MSG_CODE_REQUEST_GET || req->payload_len > LWM2M_SERVER_BLOCK_SIZE) {
+        lwm2m_server_transfer_s *transfer = malloc(sizeof(lwm2m_server_transfer_s));
+        int8_t ret_val;
+
+        if (!transfer) {
+            return -2;
+        }
+        transfer->server = server;
+        transfer->request_id = req->id;
+
+        if (msg->msg_code == COAP_MSG_CODE_REQUEST_GET) {
+            ret_val = sn_coap_protocol_start_download(server->coap, dst_addr_ptr, msg, LWM2M_SERVER_BLOCK_WINDOW,
+                      &lwm2m_server_payload_sink, transfer, server);
+        } else {
+            ret_val = sn_coap_protocol_start_upload(server->coap, dst_addr_ptr, msg, req->payload_len,
+                                                    LWM2M_SERVER_BLOCK_WINDOW, &lwm2m_server_payload_source, transfer, server);
+        }
+        if (ret_val != 0) {
+            free(transfer);
+        }
+        return ret_val;
+    }
+#endif
+
+    msg->payload_ptr = req->payload;
+    msg->payload_len = req->payload_len;
+    packet_size = sn_coap_builder_calc_needed_packet_data_size(msg);
+    packet = packet_size ? malloc(packet_size) : NULL;
+    if (!packet) {
+        return -2;
+    }
+    packet_len = sn_coap_protocol_build(server->coap, dst_addr_ptr, packet, msg, server);
+    if (packet_len > 0) {
+        lwm2m_server_coap_tx(packet, (uint16_t)packet_len, dst_addr_ptr, server);
+    }
+    free(packet);
+    return packet_len > 0 ? 0 : packet_len == -1 ? -1 : -2;
+}
+
+static int32_t lwm2m_server_request(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                                    sn_coap_msg_code_e msg_code, uint8_t observe,
+                                    const uint8_t *payload_ptr, uint32_t payload_len,
+                                    lwm2m_server_response_cb *response_cb, void *context)
+{
+    lwm2m_server_request_s *req;
+    lwm2m_server_ep_s *ep;
+    sn_coap_hdr_s msg;
+    uint8_t token[LWM2M_SERVER_TOKEN_LEN];
+    int8_t ret_val;
+
+    if (!server || !endpoint_name || !path || !*path || strlen(path) > UINT8_MAX || strlen(endpoint_name) > UINT16_MAX ||
+            (payload_len && !payload_ptr)) {
+        return -1;
+    }
+    ep = lwm2m_server_find_ep(server, (const uint8_t *)endpoint_name, (uint16_t)strlen(endpoint_name));
+    if (!ep) {
+        return -1;
+    }
+
+    req = calloc(1, sizeof(lwm2m_server_request_s));
+    if (!req) {
+        return -2;
+    }
+    req->path = lwm2m_server_strdup((const uint8_t *)path, strlen(path));
+    if (payload_len) {
+        req->payload = malloc(payload_len);
+    }
+    if (!req->path || (payload_len && !req->payload)) {
+        free(req->path);
+        free(req->payload);
+        free(req);
+        return -2;
+    }
+    if (payload_len) {
+        memcpy(req->payload, payload_ptr, payload_len);
+        req->payload_len = payload_len;
+        req->payload_size = payload_len;
+    }
+
+    /* IDs are tokens, and must not repeat while responses may still arrive */
+    server->last_request_id = server->last_request_id == INT32_MAX ? 1 : server->last_request_id + 1;
+    req->id = server->last_request_id;
+    req->observe = observe;
+    req->sent_time = server->time;
+    req->endpoint = ep;
+    req->response_cb = response_cb;
+    req->context = context;
+
+    token[0] = (uint8_t)(req->id >> 24);
+    token[1] = (uint8_t)(req->id >> 16);
+    token[2] = (uint8_t)(req->id >> 8);
+    token[3] = (uint8_t)req->id;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    msg.msg_code = msg_code;
+    msg.token_ptr = token;
+    msg.token_len = sizeof(token);
+    msg.uri_path_ptr = (uint8_t *)path;
+    msg.uri_path_len = strlen(path);
+    msg.content_format = msg_code == COAP_MSG_CODE_REQUEST_PUT ? COAP_CT_TEXT_PLAIN : COAP_CT_NONE;
+
+    /* Upload payload source looks the request up, so it is listed before sending */
+    lwm2m_server_link_request(server, req);
+    ret_val = lwm2m_server_send_request(server, req, &msg);
+    if (ret_val != 0) {
+        lwm2m_server_unlink_request(server, req);
+        free(req->path);
+        free(req->payload);
+        free(req);
+        return ret_val;
+    }
+
+    server->stats.requests++;
+    return req->id;
+}
+
+struct lwm2m_server_s *lwm2m_server_create(lwm2m_server_send_cb *send_cb, void *context)
+{
+    struct lwm2m_server_s *server;
+
+    if (!send_cb) {
+        return NULL;
+    }
+    server = calloc(1, sizeof(struct lwm2m_server_s));
+    if (!server) {
+        return NULL;
+    }
+    ns_list_init(&server->endpoints);
+    ns_list_init(&server->requests);
+    server->send_cb = send_cb;
+    server->send_context = context;
+
+    server->coap = sn_coap_protocol_init(&lwm2m_server_alloc, &lwm2m_server_free, &lwm2m_server_coap_tx, &lwm2m_server_coap_rx);
+    if (!server->coap || lwm2m_server_hash_resize(server, LWM2M_SERVER_HASH_MIN_SIZE) != 0 ||
+            lwm2m_server_request_hash_resize(server, LWM2M_SERVER_HASH_MIN_SIZE) != 0) {
+        if (server->coap) {
+            sn_coap_protocol_destroy(server->coap);
+        }
+        free(server->hash);
+        free(server);
+        return NULL;
+    }
+#if LWM2M_SERVER_BLOCKWISE
+    sn_coap_protocol_set_block_size(server->coap, LWM2M_SERVER_BLOCK_SIZE);
+#endif
+    return server;
+}
+
+void lwm2m_server_destroy(struct lwm2m_server_s *server)
+{
+    if (!server) {
+        return;
+    }
+
+    /* Transfer contexts are freed by libCoap */
+    sn_coap_protocol_destroy(server->coap);
+
+    ns_list_foreach_safe(lwm2m_server_request_s, req, &server->requests) {
+        ns_list_remove(&server->requests, req);
+        free(req->path);
+        free(req->payload);
+        free(req);
+    }
+    ns_list_foreach_safe(lwm2m_server_ep_s, ep, &server->endpoints) {
+        ns_list_remove(&server->endpoints, ep);
+        free(ep->pub.name);
+        free(ep->pub.domain);
+        free(ep->pub.location);
+        free(ep->pub.binding);
+        free(ep->pub.links);
+        free(ep);
+    }
+    free(server->hash);
+    free(server->request_hash);
+    free(server);
+}
+
+void lwm2m_server_set_event_cb(struct lwm2m_server_s *server, lwm2m_server_event_cb *event_cb, void *context)
+{
+    if (server) {
+        server->event_cb = event_cb;
+        server->event_context = context;
+    }
+}
+
+int8_t lwm2m_server_receive(struct lwm2m_server_s *server, uint8_t *packet_ptr, uint16_t packet_len,
+                            sn_nsdl_addr_s *src_addr_ptr)
+{
+    sn_coap_hdr_s *msg;
+
+    if (!server || !packet_ptr || !src_addr_ptr) {
+        return -1;
+    }
+
+    server->stats.rx_datagrams++;
+    msg = sn_coap_protocol_parse(server->coap, src_addr_ptr, packet_len, packet_ptr, server);
+    if (!msg) {
+        return -1;
+    }
+
+    if (msg->msg_code > COAP_MSG_CODE_REQUEST_DELETE) {
+        lwm2m_server_handle_response(server, msg, src_addr_ptr);
+    } else if (msg->msg_code != COAP_MSG_CODE_EMPTY &&
+               (msg->coap_status == COAP_STATUS_OK || msg->coap_status == COAP_STATUS_PARSER_DUPLICATED_MSG ||
+                msg->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED)) {
+        /* Requests are idempotent here, so a duplicate is answered again */
+        lwm2m_server_handle_request(server, msg, src_addr_ptr);
+    }
+    /* Empty Acknowledgements and Resets are handled by libCoap */
+
+    /* Payload gathered from blocks is owned by the application */
+    if (msg->coap_status == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED && msg->payload_ptr) {
+        free(msg->payload_ptr);
+        msg->payload_ptr = NULL;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(server->coap, msg);
+    return 0;
+}
+
+void lwm2m_server_exec(struct lwm2m_server_s *server, uint32_t time)
+{
+    lwm2m_server_request_s *req;
+
+    if (!server) {
+        return;
+    }
+    server->time = time;
+    sn_coap_protocol_exec(server->coap, time);
+
+    ns_list_foreach_safe(lwm2m_server_ep_s, ep, &server->endpoints) {
+        if (time - ep->pub.updated_time > ep->pub.lifetime) {
+            server->stats.expirations++;
+            lwm2m_server_remove_ep(server, ep, LWM2M_SERVER_EXPIRED);
+        }
+    }
+
+    /* Callbacks may cancel other requests, so search again after each one */
+    do {
+        req = NULL;
+        ns_list_foreach(lwm2m_server_request_s, cur, &server->requests) {
+            if (!cur->observing && time - cur->sent_time > LWM2M_SERVER_REQUEST_TIMEOUT) {
+                req = cur;
+                break;
+            }
+        }
+        if (req) {
+            lwm2m_server_complete(server, req, COAP_MSG_CODE_EMPTY, NULL, 0);
+        }
+    } while (req);
+}
+
+int32_t lwm2m_server_read(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                          lwm2m_server_response_cb *response_cb, void *context)
+{
+    return lwm2m_server_request(server, endpoint_name, path, COAP_MSG_CODE_REQUEST_GET, 0, NULL, 0, response_cb, context);
+}
+
+int32_t lwm2m_server_write(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                           const uint8_t *payload_ptr, uint32_t payload_len,
+                           lwm2m_server_response_cb *response_cb, void *context)
+{
+    return lwm2m_server_request(server, endpoint_name, path, COAP_MSG_CODE_REQUEST_PUT, 0,
+                                payload_ptr, payload_len, response_cb, context);
+}
+
+int32_t lwm2m_server_observe(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                             lwm2m_server_response_cb *response_cb, void *context)
+{
+    return lwm2m_server_request(server, endpoint_name, path, COAP_MSG_CODE_REQUEST_GET, 1, NULL, 0, response_cb, context);
+}
+
+int8_t lwm2m_server_cancel(struct lwm2m_server_s *server, int32_t request_id)
+{
+    lwm2m_server_request_s *req;
+
+    if (!server) {
+        return -1;
+    }
+    req = lwm2m_server_find_request(server, request_id);
+    if (!req) {
+        return -1;
+    }
+    lwm2m_server_unlink_request(server, req);
+    free(req->path);
+    free(req->payload);
+    free(req);
+    return 0;
+}
+
+const lwm2m_server_endpoint_s *lwm2m_server_find(const struct lwm2m_server_s *server, const char *endpoint_name)
+{
+    lwm2m_server_ep_s *ep;
+
+    if (!server || !endpoint_name || strlen(endpoint_name) > UINT16_MAX) {
+        return NULL;
+    }
+    ep = lwm2m_server_find_ep(server, (const uint8_t *)endpoint_name, (uint16_t)strlen(endpoint_name));
+    return ep ? &ep->pub : NULL;
+}
+
+const lwm2m_server_endpoint_s *lwm2m_server_next(const struct lwm2m_server_s *server,
+        const lwm2m_server_endpoint_s *endpoint)
+{
+    const lwm2m_server_ep_s *ep;
+
+    if (!server) {
+        return NULL;
+    }
+    if (!endpoint) {
+        ep = ns_list_get_first(&server->endpoints);
+    } else {
+        ep = ns_list_get_next(&server->endpoints, (const lwm2m_server_ep_s *)endpoint);
+    }
+    return ep ? &ep->pub : NULL;
+}
+
+uint32_t lwm2m_server_endpoint_count(const struct lwm2m_server_s *server)
+{
+    return server ? server->endpoint_count : 0;
+}
+
+uint32_t lwm2m_server_pending(const struct lwm2m_server_s *server)
+{
+    return server ? server->request_count : 0;
+}
+
+void lwm2m_server_get_stats(const struct lwm2m_server_s *server, lwm2m_server_stats_s *stats)
+{
+    if (server && stats) {
+        *stats = server->stats;
+    }
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * \file lwm2m_server.h
+ *
+ * \brief Minimal LwM2M server for end-to-end tests, built on libCoap.
+ *
+ * Accepts registrations (POST rd), updates (POST rd/domain/endpoint) and
+ * deregistrations (DELETE rd/domain/endpoint), and sends reads, writes and
+ * observations to registered endpoints. Registration payloads, read
+ * responses and write payloads larger than one block are transferred
+ * blockwise by libCoap when it is built with blockwise support.
+ * Notifications must fit in one block.
+ *
+ * The server does not own a socket: received datagrams are given to
+ * lwm2m_server_receive() and datagrams to send come out of the send callback.
+ * A server must be used from one thread only.
+ */
+
+#ifndef LWM2M_SERVER_H_
+#define LWM2M_SERVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+
+/**
+ * \def LWM2M_SERVER_BLOCKWISE
+ * \brief Nonzero when libCoap is built with blockwise transfers. Follows the same configuration
+ *        as SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE. Without it every message must fit in one datagram.
+ */
+#ifndef LWM2M_SERVER_BLOCKWISE
+#ifdef YOTTA_CFG_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+#define LWM2M_SERVER_BLOCKWISE          YOTTA_CFG_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+#elif defined MBED_CONF_MBED_CLIENT_SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+#define LWM2M_SERVER_BLOCKWISE          MBED_CONF_MBED_CLIENT_SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+#else
+#define LWM2M_SERVER_BLOCKWISE          0
+#endif
+#endif
+
+/**
+ * \def LWM2M_SERVER_BLOCK_SIZE
+ * \brief Block size of blockwise transfers. Must be 2^x, 16 - 1024.
+ */
+#ifndef LWM2M_SERVER_BLOCK_SIZE
+#define LWM2M_SERVER_BLOCK_SIZE         1024
+#endif
+
+/**
+ * \def LWM2M_SERVER_BLOCK_WINDOW
+ * \brief Blocks outstanding at a time in reads and large writes.
+ */
+#ifndef LWM2M_SERVER_BLOCK_WINDOW
+#define LWM2M_SERVER_BLOCK_WINDOW       4
+#endif
+
+/**
+ * \def LWM2M_SERVER_REQUEST_TIMEOUT
+ * \brief Seconds after which a request with no response is completed with code 0.
+ */
+#ifndef LWM2M_SERVER_REQUEST_TIMEOUT
+#define LWM2M_SERVER_REQUEST_TIMEOUT    120
+#endif
+
+/**
+ * \def LWM2M_SERVER_DEFAULT_LIFETIME
+ * \brief Lifetime of a registration without lt parameter, in seconds.
+ */
+#ifndef LWM2M_SERVER_DEFAULT_LIFETIME
+#define LWM2M_SERVER_DEFAULT_LIFETIME   86400
+#endif
+
+/**
+ * \def LWM2M_SERVER_MAX_PAYLOAD
+ * \brief Largest payload collected from a read or registration.
+ */
+#ifndef LWM2M_SERVER_MAX_PAYLOAD
+#define LWM2M_SERVER_MAX_PAYLOAD        65536
+#endif
+
+struct lwm2m_server_s;
+
+/**
+ * \brief Registered endpoint. Owned by the server, valid until the endpoint is removed.
+ */
+typedef struct lwm2m_server_endpoint_ {
+    char            *name;
+    char            *domain;
+    char            *location;          /**< Location-Path given to client, "rd/domain/name" */
+    char            *binding;           /**< NULL if client did not tell */
+    uint8_t         *links;             /**< Link format payload of registration or last update */
+    sn_coap_len_t   links_len;
+    uint32_t        lifetime;
+    uint32_t        registered_time;    /**< Server time of registration */
+    uint32_t        updated_time;       /**< Server time of registration or last update */
+    uint32_t        update_count;
+    sn_nsdl_addr_s  addr;               /**< Source address of last registration or update */
+} lwm2m_server_endpoint_s;
+
+typedef enum lwm2m_server_event_ {
+    LWM2M_SERVER_REGISTERED,
+    LWM2M_SERVER_UPDATED,
+    LWM2M_SERVER_DEREGISTERED,
+    LWM2M_SERVER_EXPIRED            /**< Lifetime passed without update */
+} lwm2m_server_event_e;
+
+/**
+ * \brief Outcome of a request. Payload is valid only during the callback.
+ */
+typedef struct lwm2m_server_result_ {
+    int32_t             request_id;
+    const char          *path;          /**< Resource path given with the request */
+    sn_coap_msg_code_e  msg_code;       /**< COAP_MSG_CODE_EMPTY when no response was received */
+    uint8_t             notification;   /**< Later notification of an observation */
+    const uint8_t       *payload;
+    uint32_t            payload_len;
+} lwm2m_server_result_s;
+
+typedef struct lwm2m_server_stats_ {
+    uint32_t    registrations;
+    uint32_t    updates;
+    uint32_t    deregistrations;
+    uint32_t    expirations;
+    uint32_t    requests;           /**< Reads, writes and observations sent */
+    uint32_t    responses;
+    uint32_t    notifications;
+    uint32_t    failures;           /**< Requests not answered or answered with error */
+    uint32_t    rx_datagrams;
+    uint32_t    tx_datagrams;
+} lwm2m_server_stats_s;
+
+/**
+ * \brief Sends built datagram, same form as TX callback of sn_coap_protocol_init().
+ *        Return value is ignored.
+ */
+typedef uint8_t lwm2m_server_send_cb(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *context);
+
+typedef void lwm2m_server_event_cb(struct lwm2m_server_s *server, lwm2m_server_event_e event,
+                                   const lwm2m_server_endpoint_s *endpoint, void *context);
+
+/**
+ * \brief Called once for reads and writes, and for an observation for the first response and every
+ *        notification until lwm2m_server_cancel(). When the endpoint is deregistered or expires,
+ *        its pending requests are completed with COAP_MSG_CODE_EMPTY and NULL endpoint.
+ */
+typedef void lwm2m_server_response_cb(struct lwm2m_server_s *server, const lwm2m_server_endpoint_s *endpoint,
+                                      const lwm2m_server_result_s *result, void *context);
+
+/**
+ * \fn struct lwm2m_server_s *lwm2m_server_create(lwm2m_server_send_cb *send_cb, void *context)
+ *
+ * \brief Creates server.
+ *
+ * \param *send_cb Called for every datagram to send
+ * \param *context Passed to send_cb
+ *
+ * \return Pointer to server, NULL on failure
+ */
+extern struct lwm2m_server_s *lwm2m_server_create(lwm2m_server_send_cb *send_cb, void *context);
+
+/**
+ * \fn void lwm2m_server_destroy(struct lwm2m_server_s *server)
+ *
+ * \brief Frees server, its endpoints and pending requests. Callbacks are not called.
+ */
+extern void lwm2m_server_destroy(struct lwm2m_server_s *server);
+
+/**
+ * \fn void lwm2m_server_set_event_cb(struct lwm2m_server_s *server, lwm2m_server_event_cb *event_cb, void *context)
+ *
+ * \brief Sets callback for registration events.
+ */
+extern void lwm2m_server_set_event_cb(struct lwm2m_server_s *server, lwm2m_server_event_cb *event_cb, void *context);
+
+/**
+ * \fn int8_t lwm2m_server_receive(struct lwm2m_server_s *server, uint8_t *packet_ptr, uint16_t packet_len,
+ *                                 sn_nsdl_addr_s *src_addr_ptr)
+ *
+ * \brief Processes received datagram. Responses are sent and callbacks called before return.
+ *
+ * \return 0 if datagram was CoAP, -1 otherwise
+ */
+extern int8_t lwm2m_server_receive(struct lwm2m_server_s *server, uint8_t *packet_ptr, uint16_t packet_len,
+                                   sn_nsdl_addr_s *src_addr_ptr);
+
+/**
+ * \fn void lwm2m_server_exec(struct lwm2m_server_s *server, uint32_t time)
+ *
+ * \brief Retransmits requests, removes expired registrations and times out requests.
+ *        Should be called once a second.
+ *
+ * \param time Server time in seconds
+ */
+extern void lwm2m_server_exec(struct lwm2m_server_s *server, uint32_t time);
+
+/**
+ * \fn int32_t lwm2m_server_read(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+ *                               lwm2m_server_response_cb *response_cb, void *context)
+ *
+ * \brief Sends GET to resource of registered endpoint. Response of any size is collected blockwise.
+ *
+ * \param *path Resource path without leading '/', for example "3303/0/5700"
+ *
+ * \return Request ID > 0, -1 if endpoint is not registered or parameter is invalid, -2 if out of memory
+ */
+extern int32_t lwm2m_server_read(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                                 lwm2m_server_response_cb *response_cb, void *context);
+
+/**
+ * \fn int32_t lwm2m_server_write(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+ *                                const uint8_t *payload_ptr, uint32_t payload_len,
+ *                                lwm2m_server_response_cb *response_cb, void *context)
+ *
+ * \brief Sends PUT to resource of registered endpoint. Payload is copied, and sent blockwise
+ *        if it does not fit in one block.
+ *
+ * \return Request ID > 0, -1 if endpoint is not registered or parameter is invalid, -2 if out of memory
+ */
+extern int32_t lwm2m_server_write(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                                  const uint8_t *payload_ptr, uint32_t payload_len,
+                                  lwm2m_server_response_cb *response_cb, void *context);
+
+/**
+ * \fn int32_t lwm2m_server_observe(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+ *                                  lwm2m_server_response_cb *response_cb, void *context)
+ *
+ * \brief Sends GET with Observe 0. The observation stays until lwm2m_server_cancel(), an error response,
+ *        or removal of the endpoint.
+ *
+ * \return Request ID > 0, -1 if endpoint is not registered or parameter is invalid, -2 if out of memory
+ */
+extern int32_t lwm2m_server_observe(struct lwm2m_server_s *server, const char *endpoint_name, const char *path,
+                                    lwm2m_server_response_cb *response_cb, void *context);
+
+/**
+ * \fn int8_t lwm2m_server_cancel(struct lwm2m_server_s *server, int32_t request_id)
+ *
+ * \brief Forgets request without calling its callback. Next notification of a cancelled
+ *        observation is answered with Reset, which ends it on the client.
+ *
+ * \return 0 on success, -1 if request is not pending
+ */
+extern int8_t lwm2m_server_cancel(struct lwm2m_server_s *server, int32_t request_id);
+
+/**
+ * \fn const lwm2m_server_endpoint_s *lwm2m_server_find(const struct lwm2m_server_s *server, const char *endpoint_name)
+ *
+ * \return Registered endpoint, NULL if not found
+ */
+extern const lwm2m_server_endpoint_s *lwm2m_server_find(const struct lwm2m_server_s *server, const char *endpoint_name);
+
+/**
+ * \fn const lwm2m_server_endpoint_s *lwm2m_server_next(const struct lwm2m_server_s *server,
+ *                                                      const lwm2m_server_endpoint_s *endpoint)
+ *
+ * \brief Iterates registered endpoints in registration order.
+ *
+ * \param *endpoint Previous endpoint, NULL to get the first one
+ *
+ * \return Next endpoint, NULL after the last one
+ */
+extern const lwm2m_server_endpoint_s *lwm2m_server_next(const struct lwm2m_server_s *server,
+        const lwm2m_server_endpoint_s *endpoint);
+
+/**
+ * \fn uint32_t lwm2m_server_endpoint_count(const struct lwm2m_server_s *server)
+ */
+extern uint32_t lwm2m_server_endpoint_count(const struct lwm2m_server_s *server);
+
+/**
+ * \fn uint32_t lwm2m_server_pending(const struct lwm2m_server_s *server)
+ *
+ * \brief Returns count of requests waiting for response, observations included.
+ */
+extern uint32_t lwm2m_server_pending(const struct lwm2m_server_s *server);
+
+/**
+ * \fn void lwm2m_server_get_stats(const struct lwm2m_server_s *server, lwm2m_server_stats_s *stats)
+ */
+extern void lwm2m_server_get_stats(const struct lwm2m_server_s *server, lwm2m_server_stats_s *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWM2M_SERVER_H_ */
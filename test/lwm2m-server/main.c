@@ -0,0 +1,525 @@
+/*
+ * Copyright (c) 2016 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Local LwM2M server on UDP, driven by commands from standard input.
+ * Usage: lwm2m-server [-p 5683] [-q] [-o PATH]
+ *   -q   events and automatic observations are not printed
+ *   -o   observes PATH of every endpoint as soon as it registers
+ *
+ * Commands are run one at a time, a request waits for its response:
+ *   wait COUNT [SECONDS]          until COUNT endpoints are registered
+ *   read NAME PATH
+ *   write NAME PATH VALUE         VALUE @file writes contents of file
+ *   expect NAME PATH VALUE        read and compare, mismatch fails
+ *   observe NAME PATH             notifications are printed as they come
+ *   cancel ID                     forget observation
+ *   list | links NAME | stats | sleep SECONDS | quit
+ *
+ * Exit status is 1 if a command failed. At end of input the server keeps
+ * running until interrupted.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "lwm2m_server.h"
+
+#define CLI_LINE_MAX            1024
+#define CLI_REQUEST_TIMEOUT     (LWM2M_SERVER_REQUEST_TIMEOUT + 5)
+#define CLI_DATAGRAM_MAX        1500
+
+typedef enum cli_state_ {
+    CLI_IDLE,
+    CLI_REQUEST,                /* Waiting for response to cli_request_id */
+    CLI_WAIT,                   /* Waiting for cli_wait_count endpoints */
+    CLI_SLEEP
+} cli_state_e;
+
+static struct lwm2m_server_s *server;
+static int sock = -1;
+static volatile sig_atomic_t running = 1;
+static int quiet;
+static const char *auto_observe_path;
+static int exit_status;
+static struct timespec start_time;
+
+static cli_state_e cli_state;
+static uint32_t cli_deadline;
+static int32_t cli_request_id;
+static uint32_t cli_wait_count;
+static char cli_expect[CLI_LINE_MAX];
+static int cli_expecting;
+
+static char line_buf[CLI_LINE_MAX + 1];
+static size_t line_len;
+static int input_open = 1;
+
+static void stop_handler(int signum)
+{
+    (void)signum;
+    running = 0;
+}
+
+/* Seconds since start, from 1 */
+static uint32_t server_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec - start_time.tv_sec) + 1;
+}
+
+static int milliseconds_to_next_second(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int)((1000000000L - (now.tv_nsec - start_time.tv_nsec + 1000000000L) % 1000000000L) / 1000000L) + 1;
+}
+
+static void address_to_sockaddr(const sn_nsdl_addr_s *addr, struct sockaddr_in6 *sa)
+{
+    memset(sa, 0, sizeof(*sa));
+    sa->sin6_family = AF_INET6;
+    sa->sin6_port = htons(addr->port);
+    if (addr->addr_len == 4) {
+        /* IPv4-mapped */
+        sa->sin6_addr.s6_addr[10] = 0xff;
+        sa->sin6_addr.s6_addr[11] = 0xff;
+        memcpy(&sa->sin6_addr.s6_addr[12], addr->addr_ptr, 4);
+    } else {
+        memcpy(&sa->sin6_addr, addr->addr_ptr, 16);
+    }
+}
+
+static void sockaddr_to_address(const struct sockaddr_in6 *sa, sn_nsdl_addr_s *addr, uint8_t *addr_buf)
+{
+    if (IN6_IS_ADDR_V4MAPPED(&sa->sin6_addr)) {
+        memcpy(addr_buf, &sa->sin6_addr.s6_addr[12], 4);
+        addr->addr_len = 4;
+        addr->type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    } else {
+        memcpy(addr_buf, &sa->sin6_addr, 16);
+        addr->addr_len = 16;
+        addr->type = SN_NSDL_ADDRESS_TYPE_IPV6;
+    }
+    addr->addr_ptr = addr_buf;
+    addr->port = ntohs(sa->sin6_port);
+}
+
+static const char *address_string(const sn_nsdl_addr_s *addr, char *buf, size_t buf_len)
+{
+    char ip[INET6_ADDRSTRLEN];
+
+    inet_ntop(addr->addr_len == 4 ? AF_INET : AF_INET6, addr->addr_ptr, ip, sizeof(ip));
+    snprintf(buf, buf_len, addr->addr_len == 4 ? "%s:%u" : "[%s]:%u", ip, addr->port);
+    return buf;
+}
+
+static uint8_t udp_send(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *context)
+{
+    struct sockaddr_in6 sa;
+
+    (void)context;
+    address_to_sockaddr(address_ptr, &sa);
+    return sendto(sock, data_ptr, data_len, 0, (struct sockaddr *)&sa, sizeof(sa)) == data_len;
+}
+
+static void udp_receive(void)
+{
+    uint8_t buf[CLI_DATAGRAM_MAX];
+    struct sockaddr_in6 sa;
+    socklen_t sa_len;
+    sn_nsdl_addr_s addr;
+    uint8_t addr_buf[16];
+    ssize_t len;
+
+    for (;;) {
+        sa_len = sizeof(sa);
+        len = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr *)&sa, &sa_len);
+        if (len < 0) {
+            return;
+        }
+        sockaddr_to_address(&sa, &addr, addr_buf);
+        lwm2m_server_receive(server, buf, (uint16_t)len, &addr);
+    }
+}
+
+/* Payloads are printed as text up to first NUL, the example client sends its buffer with padding */
+static size_t payload_text_len(const uint8_t *payload, uint32_t payload_len)
+{
+    const uint8_t *end = payload ? memchr(payload, '\0', payload_len) : NULL;
+    return end ? (size_t)(end - payload) : payload_len;
+}
+
+static void print_payload(const uint8_t *payload, uint32_t payload_len)
+{
+    size_t len = payload_text_len(payload, payload_len);
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (payload[i] < 0x20 || payload[i] > 0x7e) {
+            printf(" <%u bytes>", (unsigned)payload_len);
+            return;
+        }
+    }
+    if (len > 256) {
+        printf(" <%u bytes>", (unsigned)payload_len);
+    } else if (len) {
+        printf(" %.*s", (int)len, (const char *)payload);
+    }
+}
+
+static void print_code(sn_coap_msg_code_e msg_code)
+{
+    if (msg_code == COAP_MSG_CODE_EMPTY) {
+        printf(" timeout");
+    } else {
+        printf(" %d.%02d", msg_code >> 5, msg_code & 0x1f);
+    }
+}
+
+static void auto_observe_cb(struct lwm2m_server_s *srv, const lwm2m_server_endpoint_s *endpoint,
+                            const lwm2m_server_result_s *result, void *context)
+{
+    (void)srv;
+    (void)context;
+    if (!quiet) {
+        printf("%s %d %s/%s", result->notification ? "notify" : "response", result->request_id,
+               endpoint ? endpoint->name : "-", result->path);
+        print_code(result->msg_code);
+        print_payload(result->payload, result->payload_len);
+        printf("\n");
+    }
+}
+
+static void event_cb(struct lwm2m_server_s *srv, lwm2m_server_event_e event,
+                     const lwm2m_server_endpoint_s *endpoint, void *context)
+{
+    static const char *const names[] = {"registered", "updated", "deregistered", "expired"};
+    char addr[64];
+
+    (void)context;
+    if (!quiet) {
+        printf("%s %s %s %s\n", names[event], endpoint->name, endpoint->location,
+               address_string(&endpoint->addr, addr, sizeof(addr)));
+    }
+    if (event == LWM2M_SERVER_REGISTERED && auto_observe_path &&
+            lwm2m_server_observe(srv, endpoint->name, auto_observe_path, &auto_observe_cb, NULL) < 0) {
+        printf("error observing %s/%s\n", endpoint->name, auto_observe_path);
+    }
+}
+
+static void response_cb(struct lwm2m_server_s *srv, const lwm2m_server_endpoint_s *endpoint,
+                        const lwm2m_server_result_s *result, void *context)
+{
+    const char *name = endpoint ? endpoint->name : "-";
+
+    (void)srv;
+    (void)context;
+    printf("%s %d %s/%s", result->notification ? "notify" : "response", result->request_id, name, result->path);
+    print_code(result->msg_code);
+    print_payload(result->payload, result->payload_len);
+    printf("\n");
+
+    if (cli_state == CLI_REQUEST && result->request_id == cli_request_id) {
+        if (result->msg_code == COAP_MSG_CODE_EMPTY || result->msg_code >= COAP_MSG_CODE_RESPONSE_BAD_REQUEST) {
+            exit_status = 1;
+        } else if (cli_expecting) {
+            size_t len = payload_text_len(result->payload, result->payload_len);
+            if (strlen(cli_expect) != len || memcmp(cli_expect, result->payload, len)) {
+                printf("expect %s/%s failed, wanted %s\n", name, result->path, cli_expect);
+                exit_status = 1;
+            }
+        }
+        cli_state = CLI_IDLE;
+    }
+}
+
+static uint8_t *read_file(const char *name, uint32_t *len_ptr)
+{
+    FILE *file = fopen(name, "rb");
+    uint8_t *data = NULL;
+    long len;
+
+    if (!file) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (len = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc(len);
+        if (data && fread(data, 1, len, file) != (size_t)len) {
+            free(data);
+            data = NULL;
+        }
+        *len_ptr = (uint32_t)len;
+    }
+    fclose(file);
+    return data;
+}
+
+static void start_request(int32_t request_id)
+{
+    if (request_id < 0) {
+        printf("error %s\n", request_id == -1 ? "endpoint not registered" : "out of memory");
+        exit_status = 1;
+        return;
+    }
+    printf("request %d\n", request_id);
+    cli_state = CLI_REQUEST;
+    cli_request_id = request_id;
+    cli_deadline = server_time() + CLI_REQUEST_TIMEOUT;
+}
+
+static void print_list(void)
+{
+    const lwm2m_server_endpoint_s *endpoint = NULL;
+    char addr[64];
+
+    while ((endpoint = lwm2m_server_next(server, endpoint)) != NULL) {
+        printf("endpoint %s %s lt=%u b=%s updates=%u %s\n", endpoint->name, endpoint->location,
+               endpoint->lifetime, endpoint->binding ? endpoint->binding : "-", endpoint->update_count,
+               address_string(&endpoint->addr, addr, sizeof(addr)));
+    }
+    printf("endpoints %u\n", lwm2m_server_endpoint_count(server));
+}
+
+static void print_stats(void)
+{
+    lwm2m_server_stats_s stats;
+
+    lwm2m_server_get_stats(server, &stats);
+    printf("stats registrations %u updates %u deregistrations %u expirations %u\n",
+           stats.registrations, stats.updates, stats.deregistrations, stats.expirations);
+    printf("stats requests %u responses %u notifications %u failures %u rx %u tx %u\n",
+           stats.requests, stats.responses, stats.notifications, stats.failures,
+           stats.rx_datagrams, stats.tx_datagrams);
+}
+
+static void run_command(char *line)
+{
+    char *cmd = strtok(line, " \t");
+    char *name;
+    char *path;
+    char *value;
+
+    if (!cmd || cmd[0] == '#') {
+        return;
+    }
+    name = strtok(NULL, " \t");
+    path = strtok(NULL, " \t");
+    value = strtok(NULL, "");
+    while (value && (*value == ' ' || *value == '\t')) {
+        value++;
+    }
+    cli_expecting = 0;
+
+    if (!strcmp(cmd, "quit")) {
+        running = 0;
+    } else if (!strcmp(cmd, "list")) {
+        print_list();
+    } else if (!strcmp(cmd, "stats")) {
+        print_stats();
+    } else if (!strcmp(cmd, "links") && name) {
+        const lwm2m_server_endpoint_s *endpoint = lwm2m_server_find(server, name);
+        if (endpoint) {
+            printf("links %s %.*s\n", name, (int)endpoint->links_len, (const char *)endpoint->links);
+        } else {
+            printf("error endpoint not registered\n");
+            exit_status = 1;
+        }
+    } else if (!strcmp(cmd, "wait") && name) {
+        cli_wait_count = strtoul(name, NULL, 10);
+        cli_deadline = server_time() + (path ? strtoul(path, NULL, 10) : 60);
+        cli_state = CLI_WAIT;
+    } else if (!strcmp(cmd, "sleep") && name) {
+        cli_deadline = server_time() + strtoul(name, NULL, 10);
+        cli_state = CLI_SLEEP;
+    } else if (!strcmp(cmd, "cancel") && name) {
+        if (lwm2m_server_cancel(server, (int32_t)strtol(name, NULL, 10)) != 0) {
+            printf("error no such request\n");
+            exit_status = 1;
+        }
+    } else if ((!strcmp(cmd, "read") || !strcmp(cmd, "observe")) && path) {
+        start_request(cmd[0] == 'r' ? lwm2m_server_read(server, name, path, &response_cb, NULL) :
+                      lwm2m_server_observe(server, name, path, &response_cb, NULL));
+    } else if (!strcmp(cmd, "expect") && value) {
+        snprintf(cli_expect, sizeof(cli_expect), "%s", value);
+        start_request(lwm2m_server_read(server, name, path, &response_cb, NULL));
+        cli_expecting = 1;
+    } else if (!strcmp(cmd, "write") && value) {
+        uint8_t *data = (uint8_t *)value;
+        uint32_t len = strlen(value);
+
+        if (value[0] == '@' && (data = read_file(value + 1, &len)) == NULL) {
+            printf("error cannot read %s\n", value + 1);
+            exit_status = 1;
+            return;
+        }
+        start_request(lwm2m_server_write(server, name, path, data, len, &response_cb, NULL));
+        if (data != (uint8_t *)value) {
+            free(data);
+        }
+    } else {
+        printf("error unknown command %s\n", cmd);
+        exit_status = 1;
+    }
+}
+
+/* Runs buffered input lines until a command has to wait */
+static void run_input(void)
+{
+    char *end;
+
+    while (running && cli_state == CLI_IDLE && (end = memchr(line_buf, '\n', line_len)) != NULL) {
+        size_t used = end - line_buf + 1;
+
+        *end = '\0';
+        run_command(line_buf);
+        memmove(line_buf, line_buf + used, line_len - used);
+        line_len -= used;
+    }
+    if (!input_open && line_len && cli_state == CLI_IDLE) {
+        /* Last line without newline */
+        line_buf[line_len] = '\0';
+        line_len = 0;
+        run_command(line_buf);
+    }
+}
+
+static void read_input(void)
+{
+    ssize_t len = read(STDIN_FILENO, line_buf + line_len, CLI_LINE_MAX - line_len);
+
+    if (len <= 0) {
+        input_open = 0;
+    } else {
+        line_len += len;
+        if (line_len == CLI_LINE_MAX && !memchr(line_buf, '\n', line_len)) {
+            printf("error line too long\n");
+            line_len = 0;
+        }
+    }
+}
+
+static void check_state(uint32_t now)
+{
+    if (cli_state == CLI_WAIT && lwm2m_server_endpoint_count(server) >= cli_wait_count) {
+        printf("registered %u\n", lwm2m_server_endpoint_count(server));
+        cli_state = CLI_IDLE;
+    } else if (cli_state != CLI_IDLE && (int32_t)(now - cli_deadline) >= 0) {
+        if (cli_state == CLI_WAIT) {
+            printf("wait timeout, %u registered\n", lwm2m_server_endpoint_count(server));
+            exit_status = 1;
+        } else if (cli_state == CLI_REQUEST) {
+            printf("request %d timeout\n", cli_request_id);
+            exit_status = 1;
+        }
+        cli_state = CLI_IDLE;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_in6 sa;
+    uint16_t port = 5683;
+    uint32_t last_exec = 0;
+    int off = 0;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp("-p", argv[i]) && i + 1 < argc) {
+            port = (uint16_t)atoi(argv[++i]);
+        } else if (!strcmp("-q", argv[i])) {
+            quiet = 1;
+        } else if (!strcmp("-o", argv[i]) && i + 1 < argc) {
+            auto_observe_path = argv[++i];
+        } else {
+            printf("Usage: lwm2m-server [-p 5683] [-q] [-o PATH]\n");
+            return 1;
+        }
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    memset(&sa, 0, sizeof(sa));
+    sa.sin6_family = AF_INET6;
+    sa.sin6_port = htons(port);
+    sa.sin6_addr = in6addr_any;
+    if (sock < 0 || setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) != 0 ||
+            bind(sock, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        printf("Cannot bind port %u: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    server = lwm2m_server_create(&udp_send, NULL);
+    if (!server) {
+        printf("Init failed\n");
+        return 1;
+    }
+    lwm2m_server_set_event_cb(server, &event_cb, NULL);
+    printf("listening on port %u, blockwise %s\n", port, LWM2M_SERVER_BLOCKWISE ? "on" : "off");
+
+    while (running) {
+        struct pollfd fds[2];
+        int fd_count = 1;
+        uint32_t now;
+
+        fds[0].fd = sock;
+        fds[0].events = POLLIN;
+        if (input_open && cli_state == CLI_IDLE) {
+            fds[1].fd = STDIN_FILENO;
+            fds[1].events = POLLIN;
+            fd_count = 2;
+        }
+
+        if (poll(fds, fd_count, milliseconds_to_next_second()) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            udp_receive();
+        }
+
+        now = server_time();
+        if (now != last_exec) {
+            last_exec = now;
+            lwm2m_server_exec(server, now);
+        }
+        check_state(now);
+
+        if (fd_count == 2 && fds[1].revents) {
+            read_input();
+        }
+        run_input();
+    }
+
+    lwm2m_server_destroy(server);
+    close(sock);
+    return exit_status;
+}
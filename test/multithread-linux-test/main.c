@@ -36,7 +36,7 @@ void stop_pgm(char *s)
 	exit(1);
 }
 
-void *own_alloc(uint16_t size)
+void *own_alloc(sn_coap_len_t size)
 {
     if(size) {
         return malloc(size);
@@ -65,7 +65,7 @@ struct thread_data_struct {
 typedef struct thread_data_struct thread_data_struct_s;
 
 extern void stop_pgm();
-extern void *own_alloc(uint16_t size);
+extern void *own_alloc(sn_coap_len_t size);
 extern void own_free(void* ptr);
 
 /* Function templates */
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "alloc_tracker.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GNUC__
+#define ALLOC_TRACKER_CALLER()  __builtin_return_address(0)
+#else
+#define ALLOC_TRACKER_CALLER()  NULL
+#endif
+
+/* Size is kept in front of every allocation, so that free can account for it */
+typedef union alloc_tracker_header_ {
+    uint32_t    size;
+    void        *align_ptr;
+    double      align_double;
+    uint64_t    align_u64;
+} alloc_tracker_header_u;
+
+static alloc_tracker_stats_s current;
+static alloc_tracker_site_s sites[ALLOC_TRACKER_MAX_SITES];
+static uint8_t site_count;
+static uint32_t outstanding;
+
+static void alloc_tracker_add_site(const void *caller, uint32_t size)
+{
+    uint8_t i;
+
+    for (i = 0; i < site_count; i++) {
+        if (sites[i].caller == caller) {
+            break;
+        }
+    }
+    if (i == site_count) {
+        if (site_count == ALLOC_TRACKER_MAX_SITES) {
+            return;
+        }
+        sites[i].caller = caller;
+        site_count++;
+    }
+    sites[i].allocs++;
+    sites[i].bytes += size;
+}
+
+void *alloc_tracker_alloc(sn_coap_len_t size)
+{
+    alloc_tracker_header_u *header;
+
+    if (!size) {
+        return NULL;
+    }
+    header = malloc(sizeof(alloc_tracker_header_u) + size);
+    if (!header) {
+        return NULL;
+    }
+    header->size = size;
+
+    current.allocs++;
+    current.bytes += size;
+    current.live++;
+    current.live_bytes += size;
+    if (current.live_bytes > 0 && (uint32_t)current.live_bytes > current.peak_bytes) {
+        current.peak_bytes = (uint32_t)current.live_bytes;
+    }
+    outstanding++;
+    alloc_tracker_add_site(ALLOC_TRACKER_CALLER(), size);
+    return header + 1;
+}
+
+void alloc_tracker_free(void *ptr)
+{
+    alloc_tracker_header_u *header;
+
+    if (!ptr) {
+        return;
+    }
+    header = (alloc_tracker_header_u *)ptr - 1;
+    current.frees++;
+    current.live--;
+    current.live_bytes -= header->size;
+    outstanding--;
+    free(header);
+}
+
+void alloc_tracker_begin(void)
+{
+    memset(&current, 0, sizeof(current));
+    memset(sites, 0, sizeof(sites));
+    site_count = 0;
+}
+
+void alloc_tracker_end(alloc_tracker_stats_s *stats)
+{
+    if (stats) {
+        *stats = current;
+    }
+}
+
+const alloc_tracker_site_s *alloc_tracker_sites(uint8_t *count)
+{
+    if (count) {
+        *count = site_count;
+    }
+    return sites;
+}
+
+uint32_t alloc_tracker_outstanding(void)
+{
+    return outstanding;
+}
+
+void alloc_tracker_print(FILE *stream, const char *operation, const alloc_tracker_stats_s *stats)
+{
+    uint8_t i;
+
+    fprintf(stream, "%s: %u allocs, %u frees, %u bytes, peak %u bytes, %d live (%d bytes)\n",
+            operation, (unsigned)stats->allocs, (unsigned)stats->frees, (unsigned)stats->bytes,
+            (unsigned)stats->peak_bytes, (int)stats->live, (int)stats->live_bytes);
+    for (i = 0; i < site_count; i++) {
+        fprintf(stream, "    %p: %u allocs, %u bytes\n", sites[i].caller, (unsigned)sites[i].allocs, (unsigned)sites[i].bytes);
+    }
+}
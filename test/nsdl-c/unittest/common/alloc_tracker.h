@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/**
+ * \file alloc_tracker.h
+ *
+ * \brief Instrumented allocator for the library alloc/free hooks
+ *
+ * Counts allocations, bytes, peak and live objects of one operation at a
+ * time, both in total and per call site. Call site is the library function
+ * that called the hook, reported as code address.
+ *
+ *   alloc_tracker_begin();
+ *   sn_nsdl_process_coap(handle, packet, packet_len, &address);
+ *   alloc_tracker_end(&stats);
+ */
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sn_coap_header.h"
+
+#define ALLOC_TRACKER_MAX_SITES     32
+
+typedef struct alloc_tracker_stats_ {
+    uint32_t    allocs;
+    uint32_t    frees;
+    uint32_t    bytes;          /**< Bytes allocated */
+    uint32_t    peak_bytes;     /**< Highest amount of bytes allocated by the operation at once */
+    int32_t     live;           /**< Objects left allocated by the operation, negative if it freed older ones */
+    int32_t     live_bytes;
+} alloc_tracker_stats_s;
+
+typedef struct alloc_tracker_site_ {
+    const void  *caller;
+    uint32_t    allocs;
+    uint32_t    bytes;
+} alloc_tracker_site_s;
+
+/**
+ * \brief Hooks to give to sn_nsdl_init() or sn_coap_protocol_init()
+ */
+void *alloc_tracker_alloc(sn_coap_len_t size);
+void alloc_tracker_free(void *ptr);
+
+/**
+ * \brief Starts a new operation, clears counters and call sites
+ */
+void alloc_tracker_begin(void);
+
+/**
+ * \brief Ends operation started with alloc_tracker_begin()
+ *
+ * \param *stats    Counters of the operation are stored here
+ */
+void alloc_tracker_end(alloc_tracker_stats_s *stats);
+
+/**
+ * \brief Call sites of the last operation
+ *
+ * \param *count    Number of sites is stored here
+ *
+ * \return Sites in order of first allocation
+ */
+const alloc_tracker_site_s *alloc_tracker_sites(uint8_t *count);
+
+/**
+ * \brief Number of objects allocated through the hooks and not freed, over all operations
+ */
+uint32_t alloc_tracker_outstanding(void);
+
+/**
+ * \brief Prints counters and call sites of the last operation
+ */
+void alloc_tracker_print(FILE *stream, const char *operation, const alloc_tracker_stats_s *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALLOC_TRACKER_H
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_alloc_budget.h"
+
+TEST_GROUP(sn_alloc_budget)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_alloc_budget, test_sn_alloc_budget_parse_get)
+{
+    CHECK(test_sn_alloc_budget_parse_get());
+}
+
+TEST(sn_alloc_budget, test_sn_alloc_budget_dispatch_get)
+{
+    CHECK(test_sn_alloc_budget_dispatch_get());
+}
+
+TEST(sn_alloc_budget, test_sn_alloc_budget_register)
+{
+    CHECK(test_sn_alloc_budget_register());
+}
+
+TEST(sn_alloc_budget, test_sn_alloc_budget_register_again)
+{
+    CHECK(test_sn_alloc_budget_register_again());
+}
+
+TEST(sn_alloc_budget, test_sn_alloc_budget_notification)
+{
+    CHECK(test_sn_alloc_budget_notification());
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * Heap budgets of common operations, run against the real library with an
+ * instrumented allocator. Budgets are the current numbers, so that any new
+ * allocation on these paths fails the test and the budget has to be raised
+ * knowingly. Counters of every operation are printed when over budget.
+ */
+
+#include "test_sn_alloc_budget.h"
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "alloc_tracker.h"
+
+/* Budgets: allocations, and objects left allocated. Byte counts depend on pointer size, so they are only printed. */
+#define BUDGET_PARSE_GET_ALLOCS                 3
+#define BUDGET_DISPATCH_GET_ALLOCS              10
+#define BUDGET_DISPATCH_GET_LIVE                2   /* Response kept for duplicate detection */
+#define BUDGET_DISPATCH_NOT_FOUND_ALLOCS        8
+#define BUDGET_DISPATCH_NOT_FOUND_LIVE          0   /* Replaces the previous response */
+#define BUDGET_REGISTER_ALLOCS                  12
+#define BUDGET_REGISTER_LIVE                    8   /* Endpoint parameters and message kept for resending */
+#define BUDGET_REGISTER_AGAIN_ALLOCS            10  /* Same endpoint parameters, stored copies are reused */
+#define BUDGET_NOTIFICATION_ALLOCS              3
+
+static uint8_t server_address[4] = {10, 0, 0, 1};
+static sn_nsdl_addr_s server;
+static uint8_t token[4] = {0x5a, 0x17, 0xc3, 0x09};
+static uint8_t static_value[] = {"mbed"};
+static uint16_t tx_count;
+
+static uint8_t budget_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    tx_count++;
+    return 1;
+}
+
+static uint8_t budget_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+static uint8_t budget_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    return 1;
+}
+
+static bool check_budget(const char *operation, const alloc_tracker_stats_s *stats, uint32_t max_allocs, int32_t max_live)
+{
+    if (stats->allocs > max_allocs || stats->live > max_live) {
+        alloc_tracker_print(stderr, operation, stats);
+        return false;
+    }
+    return true;
+}
+
+static struct nsdl_s *create_client(void)
+{
+    struct nsdl_s *handle = sn_nsdl_init(&budget_tx, &budget_rx, &alloc_tracker_alloc, &alloc_tracker_free);
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+
+    if (!handle) {
+        return NULL;
+    }
+    server.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    server.addr_ptr = server_address;
+    server.addr_len = sizeof(server_address);
+    server.port = 5683;
+    set_NSP_address(handle, server_address, server.port, SN_NSDL_ADDRESS_TYPE_IPV4);
+
+    memset(&resource, 0, sizeof(resource));
+    memset(&parameters, 0, sizeof(parameters));
+    parameters.resource_type_ptr = (uint8_t *)"t";
+    parameters.resource_type_len = 1;
+    resource.resource_parameters_ptr = &parameters;
+    resource.access = SN_GRS_GET_ALLOWED;
+    resource.mode = SN_GRS_STATIC;
+    resource.publish_uri = 1;
+    resource.path = (uint8_t *)"3/0/0";
+    resource.pathlen = 5;
+    resource.resource = static_value;
+    resource.resourcelen = sizeof(static_value) - 1;
+    if (sn_nsdl_create_resource(handle, &resource) != 0) {
+        sn_nsdl_destroy(handle);
+        return NULL;
+    }
+    return handle;
+}
+
+/* Builds a confirmable GET from the server */
+static int16_t build_get(uint8_t *packet, const char *path, uint16_t msg_id)
+{
+    sn_coap_hdr_s msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    msg.msg_code = COAP_MSG_CODE_REQUEST_GET;
+    msg.msg_id = msg_id;
+    msg.token_ptr = token;
+    msg.token_len = sizeof(token);
+    msg.uri_path_ptr = (uint8_t *)path;
+    msg.uri_path_len = (uint16_t)strlen(path);
+    msg.content_format = COAP_CT_NONE;
+    return sn_coap_builder(packet, &msg);
+}
+
+bool test_sn_alloc_budget_parse_get()
+{
+    struct coap_s *coap = sn_coap_protocol_init(&alloc_tracker_alloc, &alloc_tracker_free, &budget_coap_tx, NULL);
+    alloc_tracker_stats_s stats;
+    coap_version_e version = COAP_VERSION_UNKNOWN;
+    sn_coap_hdr_s *hdr;
+    uint8_t packet[64];
+    int16_t packet_len = build_get(packet, "3/0/0", 1);
+    bool ret;
+
+    if (!coap || packet_len <= 0) {
+        return false;
+    }
+
+    alloc_tracker_begin();
+    hdr = sn_coap_parser(coap, (uint16_t)packet_len, packet, &version);
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+    alloc_tracker_end(&stats);
+
+    ret = check_budget("parse_get", &stats, BUDGET_PARSE_GET_ALLOCS, 0) && hdr;
+    sn_coap_protocol_destroy(coap);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_alloc_budget_dispatch_get()
+{
+    struct nsdl_s *handle = create_client();
+    alloc_tracker_stats_s stats;
+    uint8_t packet[64];
+    int16_t packet_len = build_get(packet, "3/0/0", 2);
+    bool ret;
+
+    if (!handle || packet_len <= 0) {
+        return false;
+    }
+
+    tx_count = 0;
+    alloc_tracker_begin();
+    sn_nsdl_process_coap(handle, packet, (uint16_t)packet_len, &server);
+    alloc_tracker_end(&stats);
+
+    ret = check_budget("dispatch_get", &stats, BUDGET_DISPATCH_GET_ALLOCS, BUDGET_DISPATCH_GET_LIVE) && tx_count == 1;
+
+    packet_len = build_get(packet, "3/0/9", 3);
+    tx_count = 0;
+    alloc_tracker_begin();
+    sn_nsdl_process_coap(handle, packet, (uint16_t)packet_len, &server);
+    alloc_tracker_end(&stats);
+
+    ret = check_budget("dispatch_not_found", &stats, BUDGET_DISPATCH_NOT_FOUND_ALLOCS, BUDGET_DISPATCH_NOT_FOUND_LIVE) &&
+          tx_count == 1 && ret;
+
+    sn_nsdl_destroy(handle);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_alloc_budget_register()
+{
+    struct nsdl_s *handle = create_client();
+    sn_nsdl_ep_parameters_s endpoint;
+    alloc_tracker_stats_s stats;
+    bool ret;
+
+    if (!handle) {
+        return false;
+    }
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = (uint8_t *)"budget-endpoint";
+    endpoint.endpoint_name_len = 15;
+    endpoint.lifetime_ptr = (uint8_t *)"3600";
+    endpoint.lifetime_len = 4;
+
+    tx_count = 0;
+    alloc_tracker_begin();
+    sn_nsdl_register_endpoint(handle, &endpoint);
+    alloc_tracker_end(&stats);
+
+    ret = check_budget("register", &stats, BUDGET_REGISTER_ALLOCS, BUDGET_REGISTER_LIVE) && tx_count == 1;
+
+    sn_nsdl_destroy(handle);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_alloc_budget_register_again()
+{
+    struct nsdl_s *handle = create_client();
+    sn_nsdl_ep_parameters_s endpoint;
+    alloc_tracker_stats_s stats;
+    bool ret;
+
+    if (!handle) {
+        return false;
+    }
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = (uint8_t *)"budget-endpoint";
+    endpoint.endpoint_name_len = 15;
+    endpoint.domain_name_ptr = (uint8_t *)"domain";
+    endpoint.domain_name_len = 6;
+    endpoint.lifetime_ptr = (uint8_t *)"3600";
+    endpoint.lifetime_len = 4;
+
+    sn_nsdl_register_endpoint(handle, &endpoint);
+
+    /* Stored endpoint name, domain and encoded uri-query are reused */
+    tx_count = 0;
+    alloc_tracker_begin();
+    sn_nsdl_register_endpoint(handle, &endpoint);
+    alloc_tracker_end(&stats);
+
+    ret = check_budget("register_again", &stats, BUDGET_REGISTER_AGAIN_ALLOCS, BUDGET_REGISTER_LIVE) && tx_count == 1;
+
+    sn_nsdl_destroy(handle);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_alloc_budget_notification()
+{
+    struct nsdl_s *handle = create_client();
+    alloc_tracker_stats_s stats;
+    bool ret;
+
+    if (!handle) {
+        return false;
+    }
+
+    tx_count = 0;
+    alloc_tracker_begin();
+    sn_nsdl_send_observation_notification(handle, token, sizeof(token), static_value, sizeof(static_value) - 1,
+                                          7, COAP_MSG_TYPE_NON_CONFIRMABLE, COAP_CT_TEXT_PLAIN);
+    alloc_tracker_end(&stats);
+
+    ret = check_budget("notification", &stats, BUDGET_NOTIFICATION_ALLOCS, 0) && tx_count == 1;
+
+    sn_nsdl_destroy(handle);
+    return ret && alloc_tracker_outstanding() == 0;
+}
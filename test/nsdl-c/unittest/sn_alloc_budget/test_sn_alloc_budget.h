@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_ALLOC_BUDGET_H
+#define TEST_SN_ALLOC_BUDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+bool test_sn_alloc_budget_parse_get();
+bool test_sn_alloc_budget_dispatch_get();
+bool test_sn_alloc_budget_register();
+bool test_sn_alloc_budget_register_again();
+bool test_sn_alloc_budget_notification();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_SN_ALLOC_BUDGET_H
+
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_bootstrap.h"
+
+TEST_GROUP(sn_bootstrap)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_bootstrap, test_sn_bootstrap_truncated_tlv)
+{
+    CHECK(test_sn_bootstrap_truncated_tlv());
+}
+
+TEST(sn_bootstrap, test_sn_bootstrap_plain_text)
+{
+    CHECK(test_sn_bootstrap_plain_text());
+}
+
+TEST(sn_bootstrap, test_sn_bootstrap_server_uri)
+{
+    CHECK(test_sn_bootstrap_server_uri());
+}
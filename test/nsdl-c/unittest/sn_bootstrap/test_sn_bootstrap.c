@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * Bootstrap writes run against the real library. Writes are built as if
+ * they came from the bootstrap server, the response of the client is
+ * captured from the transmit callback.
+ */
+
+#include "test_sn_bootstrap.h"
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "alloc_tracker.h"
+
+static uint8_t bootstrap_address[4] = {10, 0, 0, 2};
+static sn_nsdl_addr_s bootstrap_server;
+static sn_nsdl_oma_device_t device_object;
+static uint8_t tx_packet[512];
+static uint16_t tx_len;
+static sn_nsdl_addr_type_e done_type;
+static uint8_t done_address[16];
+static uint8_t done_address_len;
+static uint16_t done_port;
+static int done_count;
+
+static uint8_t bootstrap_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    tx_len = 0;
+    if (data_len <= sizeof(tx_packet)) {
+        memcpy(tx_packet, data_ptr, data_len);
+        tx_len = data_len;
+    }
+    return 1;
+}
+
+static uint8_t bootstrap_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+static uint8_t bootstrap_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    return 1;
+}
+
+static void bootstrap_done(sn_nsdl_oma_server_info_t *server_info_ptr)
+{
+    sn_nsdl_addr_s *address_ptr = server_info_ptr->omalw_address_ptr;
+
+    done_count++;
+    done_type = address_ptr->type;
+    done_port = address_ptr->port;
+    done_address_len = 0;
+    memset(done_address, 0, sizeof(done_address));
+    if (address_ptr->addr_ptr && address_ptr->addr_len <= sizeof(done_address)) {
+        memcpy(done_address, address_ptr->addr_ptr, address_ptr->addr_len);
+        done_address_len = address_ptr->addr_len;
+    }
+}
+
+static struct nsdl_s *start_bootstrap()
+{
+    struct nsdl_s *handle = sn_nsdl_init(&bootstrap_tx, &bootstrap_rx, &alloc_tracker_alloc, &alloc_tracker_free);
+    sn_nsdl_ep_parameters_s endpoint;
+    sn_nsdl_bs_ep_info_t bootstrap_info;
+
+    if (!handle) {
+        return NULL;
+    }
+    done_count = 0;
+    memset(&bootstrap_server, 0, sizeof(bootstrap_server));
+    bootstrap_server.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    bootstrap_server.addr_ptr = bootstrap_address;
+    bootstrap_server.addr_len = sizeof(bootstrap_address);
+    bootstrap_server.port = 5693;
+
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = (uint8_t *)"ep";
+    endpoint.endpoint_name_len = 2;
+    memset(&bootstrap_info, 0, sizeof(bootstrap_info));
+    bootstrap_info.oma_bs_status_cb = &bootstrap_done;
+    bootstrap_info.device_object = &device_object;
+
+    if (!sn_nsdl_oma_bootstrap(handle, &bootstrap_server, &endpoint, &bootstrap_info)) {
+        sn_nsdl_destroy(handle);
+        return NULL;
+    }
+    return handle;
+}
+
+/*
+ * Sends write from bootstrap server and returns code of the response. Packet
+ * is given in buffer of exact size, so that reading past the end of the
+ * payload is seen by memory checkers.
+ */
+static sn_coap_msg_code_e bootstrap_write(struct nsdl_s *handle, struct coap_s *coap, uint8_t content_format, const char *path,
+                                          const uint8_t *payload_ptr, uint16_t payload_len)
+{
+    static uint16_t msg_id;
+    sn_coap_msg_code_e response_code = COAP_MSG_CODE_EMPTY;
+    coap_version_e version = COAP_VERSION_UNKNOWN;
+    sn_coap_hdr_s msg;
+    sn_coap_hdr_s *response;
+    uint8_t packet[512];
+    uint8_t *exact;
+    int16_t packet_len;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    msg.msg_code = COAP_MSG_CODE_REQUEST_PUT;
+    msg.msg_id = ++msg_id;
+    msg.uri_path_ptr = (uint8_t *)path;
+    msg.uri_path_len = (uint16_t)strlen(path);
+    msg.content_format = (sn_coap_content_format_e)content_format;
+    msg.payload_ptr = (uint8_t *)payload_ptr;
+    msg.payload_len = payload_len;
+
+    packet_len = sn_coap_builder(packet, &msg);
+    if (packet_len <= 0) {
+        return COAP_MSG_CODE_EMPTY;
+    }
+    exact = (uint8_t *)malloc(packet_len);
+    memcpy(exact, packet, packet_len);
+    tx_len = 0;
+    sn_nsdl_process_coap(handle, exact, (uint16_t)packet_len, &bootstrap_server);
+    free(exact);
+
+    if (tx_len) {
+        response = sn_coap_parser(coap, tx_len, tx_packet, &version);
+        if (response && response->msg_id == msg.msg_id) {
+            response_code = response->msg_code;
+        }
+        sn_coap_parser_release_allocated_coap_msg_mem(coap, response);
+    }
+    return response_code;
+}
+
+bool test_sn_bootstrap_truncated_tlv()
+{
+    /* Security mode, resource 2 of one byte */
+    const uint8_t security_mode[] = {0xc1, 0x02, '0'};
+    /* 16-bit identifier and 8-bit length, only identifier present */
+    const uint8_t truncated_header[] = {0xe8, 0x00, 0x03};
+    /* Public key of 16 bytes, two bytes present */
+    const uint8_t truncated_value[] = {0xc8, 0x03, 0x10, 'k', 'e'};
+    struct coap_s *coap = sn_coap_protocol_init(&alloc_tracker_alloc, &alloc_tracker_free, &bootstrap_coap_tx, NULL);
+    struct nsdl_s *handle = start_bootstrap();
+    bool ret;
+
+    if (!coap || !handle) {
+        return false;
+    }
+
+    ret = bootstrap_write(handle, coap, 99, "0", security_mode, sizeof(security_mode)) == COAP_MSG_CODE_RESPONSE_CREATED &&
+          bootstrap_write(handle, coap, 99, "0", truncated_header, sizeof(truncated_header)) == COAP_MSG_CODE_RESPONSE_NOT_ACCEPTABLE &&
+          bootstrap_write(handle, coap, 99, "0", truncated_value, sizeof(truncated_value)) == COAP_MSG_CODE_RESPONSE_NOT_ACCEPTABLE &&
+          !sn_nsdl_get_resource(handle, 5, (uint8_t *)"0/0/3");
+
+    sn_nsdl_destroy(handle);
+    sn_coap_protocol_destroy(coap);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_bootstrap_plain_text()
+{
+    const uint8_t server_uri[] = "coap://10.0.0.1:5684";
+    const uint8_t server_address[4] = {10, 0, 0, 1};
+    struct coap_s *coap = sn_coap_protocol_init(&alloc_tracker_alloc, &alloc_tracker_free, &bootstrap_coap_tx, NULL);
+    struct nsdl_s *handle = start_bootstrap();
+    bool ret = true;
+
+    if (!coap || !handle) {
+        return false;
+    }
+
+    /* Message is released by resource server, address and mode are read before that */
+    bootstrap_write(handle, coap, 97, "0/0/0", server_uri, sizeof(server_uri) - 1);
+    bootstrap_write(handle, coap, 97, "0/0/2", (const uint8_t *)"0", 1);
+    if (done_count != 1 || done_port != 5684 || memcmp(done_address, server_address, sizeof(server_address))) {
+        ret = false;
+    }
+
+    sn_nsdl_destroy(handle);
+    sn_coap_protocol_destroy(coap);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+/* Writes server uri and security mode, which completes bootstrap with the parsed address */
+static bool bootstrap_server_uri(const char *server_uri)
+{
+    struct coap_s *coap = sn_coap_protocol_init(&alloc_tracker_alloc, &alloc_tracker_free, &bootstrap_coap_tx, NULL);
+    struct nsdl_s *handle = start_bootstrap();
+
+    if (!coap || !handle) {
+        return false;
+    }
+    bootstrap_write(handle, coap, 97, "0/0/0", (const uint8_t *)server_uri, (uint16_t)strlen(server_uri));
+    bootstrap_write(handle, coap, 97, "0/0/2", (const uint8_t *)"0", 1);
+
+    sn_nsdl_destroy(handle);
+    sn_coap_protocol_destroy(coap);
+    return alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_bootstrap_server_uri()
+{
+    const uint8_t ipv6_address[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01};
+    bool ret = true;
+
+    if (!bootstrap_server_uri("coap://[::1]:5684") || done_count != 1 || done_type != SN_NSDL_ADDRESS_TYPE_IPV6 ||
+            done_port != 5684 || memcmp(done_address, ipv6_address, sizeof(ipv6_address))) {
+        ret = false;
+    }
+
+    /* Port follows the closing bracket, also when the last group is short */
+    if (!bootstrap_server_uri("coap://[fe80::1:2]:5684") || done_port != 5684) {
+        ret = false;
+    }
+
+    /* Group longer than 4 digits would be written past the address, parsing stops before the port */
+    if (!bootstrap_server_uri("coap://[1:2:3:1234567890abcdef1234567890abcdef]:5684") || done_port == 5684) {
+        ret = false;
+    }
+
+    /* Number after the last dot is not followed by port separator, so it is not IPv4 address */
+    if (!bootstrap_server_uri("coap://1.2.3.:5684") || done_type != SN_NSDL_ADDRESS_TYPE_HOSTNAME ||
+            done_address_len != 6 || memcmp(done_address, "1.2.3.", 6) || done_port != 5684) {
+        ret = false;
+    }
+
+    /* Number that does not fit in 32 bits is not taken as octet */
+    if (!bootstrap_server_uri("coap://10.0.0.4294967297:5684") || done_type != SN_NSDL_ADDRESS_TYPE_HOSTNAME) {
+        ret = false;
+    }
+
+    return ret;
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_BOOTSTRAP_H
+#define TEST_SN_BOOTSTRAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+bool test_sn_bootstrap_truncated_tlv();
+bool test_sn_bootstrap_plain_text();
+bool test_sn_bootstrap_server_uri();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_SN_BOOTSTRAP_H
@@ -162,6 +162,34 @@ TEST(libCoap_builder, build_message_options_uri_path)
     CHECK(sn_coap_builder(buffer, &coap_header) == 11);
 }
 
+TEST(libCoap_builder, build_message_options_uri_path_empty_segment)
+{
+    uint8_t path[] = {'/', 'a', '/', '/', 'b', '/'};
+    uint8_t expected[] = {0xb1, 'a', 0x00, 0x01, 'b'};
+    coap_header.content_format = COAP_CT_NONE;
+    coap_header.uri_path_ptr = path;
+    coap_header.uri_path_len = sizeof(path);
+    coap_header.options_list_ptr->max_age = COAP_OPTION_MAX_AGE_DEFAULT;
+    coap_header.options_list_ptr->uri_port = COAP_OPTION_URI_PORT_NONE;
+    coap_header.options_list_ptr->observe = COAP_OBSERVE_NONE;
+    coap_header.options_list_ptr->accept = COAP_CT_NONE;
+    coap_header.options_list_ptr->block1 = COAP_OPTION_BLOCK_NONE;
+    coap_header.options_list_ptr->block2 = COAP_OPTION_BLOCK_NONE;
+
+    /* Leading and trailing separators are dropped, two separators in a row give an empty Uri-Path */
+    CHECK(sn_coap_builder_calc_needed_packet_data_size(&coap_header) == 4 + sizeof(expected));
+    CHECK(sn_coap_builder(buffer, &coap_header) == 4 + sizeof(expected));
+    CHECK(memcmp(&buffer[4], expected, sizeof(expected)) == 0);
+
+    /* Uri-Query can not be empty */
+    uint8_t query[] = {'a', '&', '&', 'b'};
+    coap_header.uri_path_ptr = NULL;
+    coap_header.uri_path_len = 0;
+    coap_header.options_list_ptr->uri_query_ptr = query;
+    coap_header.options_list_ptr->uri_query_len = sizeof(query);
+    CHECK(sn_coap_builder_calc_needed_packet_data_size(&coap_header) == 0);
+}
+
 TEST(libCoap_builder, build_message_options_content_type)
 {
     coap_header.content_format = COAP_CT_TEXT_PLAIN;
@@ -188,6 +216,21 @@ TEST(libCoap_builder, build_message_options_etag)
     CHECK(sn_coap_builder(buffer, &coap_header) == 14);
 }
 
+TEST(libCoap_builder, build_message_options_etag_with_size1)
+{
+    uint8_t etag[2] = {'a', 'b'};
+    coap_header.options_list_ptr->etag_ptr = etag;
+    coap_header.options_list_ptr->etag_len = 2;
+    coap_header.options_list_ptr->use_size1 = 1;
+    coap_header.options_list_ptr->size1 = 1;
+
+    /* Bits stored next to etag_len are not part of the length */
+    int16_t val = sn_coap_builder(buffer, &coap_header);
+    CHECK(val == (int16_t)sn_coap_builder_calc_needed_packet_data_size(&coap_header));
+    CHECK(buffer[4] == 0x42);
+    CHECK(memcmp(&buffer[5], etag, 2) == 0);
+}
+
 TEST(libCoap_builder, build_message_options_uri_host)
 {
     coap_header.options_list_ptr->uri_host_ptr = temp;
@@ -222,6 +265,27 @@ TEST(libCoap_builder, build_message_options_observe)
     CHECK(sn_coap_builder(buffer, &coap_header) == 11);
 }
 
+TEST(libCoap_builder, build_message_notification_with_uri_path)
+{
+    uint8_t path[] = {'a'};
+    coap_header.content_format = COAP_CT_NONE;
+    coap_header.uri_path_ptr = path;
+    coap_header.uri_path_len = sizeof(path);
+    coap_header.options_list_ptr->max_age = COAP_OPTION_MAX_AGE_DEFAULT;
+    coap_header.options_list_ptr->uri_port = COAP_OPTION_URI_PORT_NONE;
+    coap_header.options_list_ptr->accept = COAP_CT_NONE;
+    coap_header.options_list_ptr->block1 = COAP_OPTION_BLOCK_NONE;
+    coap_header.options_list_ptr->observe = 1;
+    coap_header.options_list_ptr->block2 = 0;
+
+    /* Uri-Path is not built for notification, so Block2 follows Observe and needs an extended delta */
+    uint16_t len = sn_coap_builder_calc_needed_packet_data_size(&coap_header);
+    uint8_t *packet = (uint8_t*)malloc(len);
+    CHECK(sn_coap_builder(packet, &coap_header) == len);
+    CHECK(packet[6] == 0xd0 && packet[7] == 4);
+    free(packet);
+}
+
 
 TEST(libCoap_builder, build_message_options_accept)
 {
@@ -441,6 +505,11 @@ TEST(libCoap_builder, sn_coap_builder_calc_needed_packet_data_size)
     uint16_t val = sn_coap_builder_calc_needed_packet_data_size(&header);
     CHECK( 12 == val );
 
+    //Payload which is not blockwised must fit to one packet
+    header.payload_len = UINT16_MAX;
+    CHECK(0 == sn_coap_builder_calc_needed_packet_data_size_2(&header, 0));
+    header.payload_len = 1;
+
     free(header.uri_path_ptr);
     free(header.token_ptr);
 }
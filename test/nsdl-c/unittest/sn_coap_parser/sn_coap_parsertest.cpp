@@ -49,3 +49,18 @@ TEST(sn_coap_parser, test_sn_coap_parser_release_allocated_coap_msg_mem)
 {
     CHECK(test_sn_coap_parser_release_allocated_coap_msg_mem());
 }
+
+TEST(sn_coap_parser, test_sn_coap_parser_set_token_and_uri_path)
+{
+    CHECK(test_sn_coap_parser_set_token_and_uri_path());
+}
+
+TEST(sn_coap_parser, test_sn_coap_parser_truncated_packet)
+{
+    CHECK(test_sn_coap_parser_truncated_packet());
+}
+
+TEST(sn_coap_parser, test_sn_coap_parser_long_etag)
+{
+    CHECK(test_sn_coap_parser_long_etag());
+}
@@ -980,3 +980,160 @@ bool test_sn_coap_parser_release_allocated_coap_msg_mem()
     return true; //this is a memory leak check, so that will pass/fail
 }
 
+bool test_sn_coap_parser_set_token_and_uri_path()
+{
+    bool ret = false;
+    uint8_t token[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t path[] = "1/0/2";
+    struct coap_s* coap = (struct coap_s*)malloc(sizeof(struct coap_s));
+    coap->sn_coap_protocol_malloc = myMalloc;
+    coap->sn_coap_protocol_free = myFree;
+    retCounter = 1;
+
+    sn_coap_hdr_s *hdr = sn_coap_parser_alloc_message(coap);
+    if (!hdr) {
+        goto end;
+    }
+
+    if (-1 != sn_coap_parser_set_token(NULL, hdr, token, 4)) {
+        goto end;
+    }
+    if (-1 != sn_coap_parser_set_token(coap, hdr, token, 0)) {
+        goto end;
+    }
+    if (-1 != sn_coap_parser_set_token(coap, hdr, token, 9)) {
+        goto end;
+    }
+    if (-1 != sn_coap_parser_set_uri_path(coap, hdr, NULL, 5)) {
+        goto end;
+    }
+    if (-1 != sn_coap_parser_set_uri_path(coap, hdr, path, 0)) {
+        goto end;
+    }
+
+    retCounter = 2;
+    if (0 != sn_coap_parser_set_token(coap, hdr, token, 8)) {
+        goto end;
+    }
+    if (hdr->token_len != 8 || memcmp(hdr->token_ptr, token, 8)) {
+        goto end;
+    }
+    /* Token is already set */
+    if (-1 != sn_coap_parser_set_token(coap, hdr, token, 4)) {
+        goto end;
+    }
+
+    if (0 != sn_coap_parser_set_uri_path(coap, hdr, path, 5)) {
+        goto end;
+    }
+    if (hdr->uri_path_len != 5 || memcmp(hdr->uri_path_ptr, path, 5)) {
+        goto end;
+    }
+    if (-1 != sn_coap_parser_set_uri_path(coap, hdr, path, 5)) {
+        goto end;
+    }
+
+    ret = true;
+end:
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+    free(coap);
+    return ret;
+}
+
+/* Parses copy of packet in buffer of exact size, so that reading past the end is seen by memory checkers */
+static sn_coap_hdr_s *parse_exact(struct coap_s *coap, const uint8_t *packet, uint16_t packet_len)
+{
+    coap_version_e ver = COAP_VERSION_UNKNOWN;
+    uint8_t *copy = (uint8_t *)malloc(packet_len);
+    sn_coap_hdr_s *hdr;
+
+    memcpy(copy, packet, packet_len);
+    retCounter = 10;
+    hdr = sn_coap_parser(coap, packet_len, copy, &ver);
+    free(copy);
+    return hdr;
+}
+
+static bool parse_fails(struct coap_s *coap, const uint8_t *packet, uint16_t packet_len)
+{
+    sn_coap_hdr_s *hdr = parse_exact(coap, packet, packet_len);
+    bool ret = hdr && hdr->coap_status == COAP_STATUS_PARSER_ERROR_IN_HEADER;
+
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+    return ret;
+}
+
+bool test_sn_coap_parser_truncated_packet()
+{
+    /* Token length 8, two bytes left */
+    const uint8_t token[] = {0x48, 0x01, 0x00, 0x01, 0xaa, 0xbb};
+    /* Extended option delta without the extension byte */
+    const uint8_t delta[] = {0x40, 0x01, 0x00, 0x01, 0xd0};
+    /* Uri-Path with two byte extended length, one byte left */
+    const uint8_t length[] = {0x40, 0x01, 0x00, 0x01, 0xbe, 0x01};
+    /* Uri-Host of 5 bytes, two bytes left */
+    const uint8_t value[] = {0x40, 0x01, 0x00, 0x01, 0x35, 'a', 'b'};
+    /* Second Uri-Path part of 5 bytes, one byte left */
+    const uint8_t part[] = {0x40, 0x01, 0x00, 0x01, 0xb1, 'a', 0x05, 'b'};
+    /* Second Uri-Path part with extended length, extension byte missing */
+    const uint8_t part_length[] = {0x40, 0x01, 0x00, 0x01, 0xb1, 'a', 0x0d};
+    /* Lone empty Uri-Path */
+    const uint8_t empty[] = {0x40, 0x01, 0x00, 0x01, 0xb0};
+    const uint8_t valid[] = {0x40, 0x01, 0x00, 0x01, 0xb1, 'a', 0x01, 'b'};
+    struct coap_s *coap = (struct coap_s *)malloc(sizeof(struct coap_s));
+    sn_coap_hdr_s *hdr;
+    bool ret;
+
+    coap->sn_coap_protocol_malloc = myMalloc;
+    coap->sn_coap_protocol_free = myFree;
+
+    ret = parse_fails(coap, token, sizeof(token)) &&
+          parse_fails(coap, delta, sizeof(delta)) &&
+          parse_fails(coap, length, sizeof(length)) &&
+          parse_fails(coap, value, sizeof(value)) &&
+          parse_fails(coap, part, sizeof(part)) &&
+          parse_fails(coap, part_length, sizeof(part_length)) &&
+          parse_fails(coap, empty, sizeof(empty));
+
+    hdr = parse_exact(coap, valid, sizeof(valid));
+    if (!hdr || hdr->coap_status != COAP_STATUS_OK || hdr->uri_path_len != 3 || memcmp(hdr->uri_path_ptr, "a/b", 3)) {
+        ret = false;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+
+    free(coap);
+    return ret;
+}
+
+bool test_sn_coap_parser_long_etag()
+{
+    /* ETag options of 8 bytes, joined with separators */
+    uint8_t packet[4 + 30 * 9] = {0x40, 0x01, 0x00, 0x01};
+    struct coap_s *coap = (struct coap_s *)malloc(sizeof(struct coap_s));
+    sn_coap_hdr_s *hdr;
+    bool ret = true;
+
+    coap->sn_coap_protocol_malloc = myMalloc;
+    coap->sn_coap_protocol_free = myFree;
+
+    for (uint16_t i = 4; i < sizeof(packet); i += 9) {
+        packet[i] = (i == 4) ? 0x48 : 0x08;
+        memset(&packet[i + 1], 'e', 8);
+    }
+
+    /* Two options, 17 bytes */
+    hdr = parse_exact(coap, packet, 4 + 2 * 9);
+    if (!hdr || hdr->coap_status != COAP_STATUS_OK || !hdr->options_list_ptr || hdr->options_list_ptr->etag_len != 17 ||
+            hdr->options_list_ptr->etag_ptr[8] != '&') {
+        ret = false;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, hdr);
+
+    /* 269 bytes do not fit in etag_len */
+    if (!parse_fails(coap, packet, sizeof(packet))) {
+        ret = false;
+    }
+
+    free(coap);
+    return ret;
+}
@@ -25,6 +25,12 @@ bool test_sn_coap_parser_parsing();
 
 bool test_sn_coap_parser_release_allocated_coap_msg_mem();
 
+bool test_sn_coap_parser_set_token_and_uri_path();
+
+bool test_sn_coap_parser_truncated_packet();
+
+bool test_sn_coap_parser_long_etag();
+
 
 #ifdef __cplusplus
 }
@@ -189,6 +189,363 @@ TEST(libCoap_protocol, sn_coap_protocol_delete_retransmission)
 #endif
 }
 
+TEST(libCoap_protocol, sn_coap_protocol_get_next_deadline)
+{
+    uint32_t deadline = 0;
+    CHECK( -1 == sn_coap_protocol_get_next_deadline(NULL, &deadline));
+
+    retCounter = 6;
+    struct coap_s * handle = sn_coap_protocol_init(myMalloc, myFree, null_tx_cb, NULL);
+    CHECK( -1 == sn_coap_protocol_get_next_deadline(handle, NULL));
+    CHECK( -1 == sn_coap_protocol_get_next_deadline(handle, &deadline));
+
+#if ENABLE_RESENDINGS
+    sn_nsdl_addr_s dst_addr_ptr;
+    sn_coap_hdr_s src_coap_msg_ptr;
+    uint8_t temp_addr[4] = {0};
+    uint8_t dst_packet_data_ptr[4] = {0x40, 0x00, 0x00, 0x63};
+
+    memset(&dst_addr_ptr, 0, sizeof(sn_nsdl_addr_s));
+    memset(&src_coap_msg_ptr, 0, sizeof(sn_coap_hdr_s));
+
+    dst_addr_ptr.addr_ptr = temp_addr;
+    dst_addr_ptr.addr_len = 4;
+    dst_addr_ptr.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+
+    sn_coap_protocol_exec(handle, 100);
+    sn_coap_builder_stub.expectedInt16 = 4;
+    CHECK( 0 < sn_coap_protocol_build(handle, &dst_addr_ptr, dst_packet_data_ptr, &src_coap_msg_ptr, NULL));
+
+    CHECK( 0 == sn_coap_protocol_get_next_deadline(handle, &deadline));
+    CHECK( deadline > 100 );
+
+    CHECK( 0 == sn_coap_protocol_delete_retransmission(handle, 99));
+    CHECK( -1 == sn_coap_protocol_get_next_deadline(handle, &deadline));
+    sn_coap_builder_stub.expectedInt16 = 0;
+#endif
+
+    sn_coap_protocol_destroy(handle);
+}
+
+TEST(libCoap_protocol, sn_coap_protocol_clear_sent_messages_by_param)
+{
+    sn_coap_protocol_clear_sent_messages_by_param(NULL, NULL);
+
+    retCounter = 6;
+    struct coap_s * handle = sn_coap_protocol_init(myMalloc, myFree, null_tx_cb, NULL);
+
+#if ENABLE_RESENDINGS
+    sn_nsdl_addr_s dst_addr_ptr;
+    sn_coap_hdr_s src_coap_msg_ptr;
+    uint8_t temp_addr[4] = {0};
+    uint8_t dst_packet_data_ptr[4] = {0x40, 0x00, 0x00, 0x63};
+    int session_a, session_b;
+    uint32_t deadline = 0;
+
+    memset(&dst_addr_ptr, 0, sizeof(sn_nsdl_addr_s));
+    memset(&src_coap_msg_ptr, 0, sizeof(sn_coap_hdr_s));
+
+    dst_addr_ptr.addr_ptr = temp_addr;
+    dst_addr_ptr.addr_len = 4;
+    dst_addr_ptr.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+
+    sn_coap_builder_stub.expectedInt16 = 4;
+    CHECK( 0 < sn_coap_protocol_build(handle, &dst_addr_ptr, dst_packet_data_ptr, &src_coap_msg_ptr, &session_a));
+    CHECK( 0 == sn_coap_protocol_get_next_deadline(handle, &deadline));
+
+    sn_coap_protocol_clear_sent_messages_by_param(handle, &session_b);
+    CHECK( 0 == sn_coap_protocol_get_next_deadline(handle, &deadline));
+
+    sn_coap_protocol_clear_sent_messages_by_param(handle, &session_a);
+    CHECK( -1 == sn_coap_protocol_get_next_deadline(handle, &deadline));
+    sn_coap_builder_stub.expectedInt16 = 0;
+#endif
+
+    sn_coap_protocol_destroy(handle);
+}
+
+TEST(libCoap_protocol, sn_coap_protocol_build_copy)
+{
+    sn_nsdl_addr_s dst_addr_ptr;
+    sn_coap_hdr_s src_coap_msg_ptr;
+    uint8_t temp_addr[4] = {0};
+    uint8_t packet[6] = {0x41, 0x45, 0x00, 0x63, 0xAA, 0xFF};
+    uint8_t token = 0xBB;
+
+    memset(&dst_addr_ptr, 0, sizeof(sn_nsdl_addr_s));
+    memset(&src_coap_msg_ptr, 0, sizeof(sn_coap_hdr_s));
+
+    dst_addr_ptr.addr_ptr = temp_addr;
+    dst_addr_ptr.addr_len = 4;
+    dst_addr_ptr.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+
+    src_coap_msg_ptr.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    src_coap_msg_ptr.msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
+
+    CHECK( -2 == sn_coap_protocol_build_copy(NULL, &dst_addr_ptr, packet, sizeof(packet), &src_coap_msg_ptr, NULL));
+    CHECK( -2 == sn_coap_protocol_build_copy(coap_handle, &dst_addr_ptr, NULL, sizeof(packet), &src_coap_msg_ptr, NULL));
+
+    /* Token of another length does not fit in place */
+    CHECK( -1 == sn_coap_protocol_build_copy(coap_handle, &dst_addr_ptr, packet, sizeof(packet), &src_coap_msg_ptr, NULL));
+    src_coap_msg_ptr.token_len = 1;
+    CHECK( -1 == sn_coap_protocol_build_copy(coap_handle, &dst_addr_ptr, packet, 4, &src_coap_msg_ptr, NULL));
+    src_coap_msg_ptr.token_ptr = &token;
+
+    retCounter = 5;
+    CHECK( sizeof(packet) == sn_coap_protocol_build_copy(coap_handle, &dst_addr_ptr, packet, sizeof(packet), &src_coap_msg_ptr, NULL));
+    CHECK( src_coap_msg_ptr.msg_id != 0 );
+    CHECK( packet[2] == (uint8_t)(src_coap_msg_ptr.msg_id >> 8) );
+    CHECK( packet[3] == (uint8_t)src_coap_msg_ptr.msg_id );
+    CHECK( packet[4] == 0xBB );
+    CHECK( packet[0] == 0x41 && packet[1] == 0x45 && packet[5] == 0xFF );
+
+#if ENABLE_RESENDINGS
+    /* Confirmable copy is resent like a built message */
+    CHECK( 0 == sn_coap_protocol_delete_retransmission(coap_handle, src_coap_msg_ptr.msg_id));
+#endif
+
+    /* Given message ID is kept */
+    src_coap_msg_ptr.msg_type = COAP_MSG_TYPE_NON_CONFIRMABLE;
+    src_coap_msg_ptr.msg_id = 0x1234;
+    CHECK( sizeof(packet) == sn_coap_protocol_build_copy(coap_handle, &dst_addr_ptr, packet, sizeof(packet), &src_coap_msg_ptr, NULL));
+    CHECK( packet[2] == 0x12 && packet[3] == 0x34 );
+
+#if SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+    /* Blockwised message is not copied */
+    coap_handle->sn_coap_block_data_size = 16;
+    src_coap_msg_ptr.payload_len = 17;
+    CHECK( -1 == sn_coap_protocol_build_copy(coap_handle, &dst_addr_ptr, packet, sizeof(packet), &src_coap_msg_ptr, NULL));
+#endif
+}
+
+uint16_t test_payload_source(void *context, uint32_t offset, uint8_t *dst, uint16_t len)
+{
+    memset(dst, '1', len);
+    return len;
+}
+
+uint16_t failing_payload_source(void *context, uint32_t offset, uint8_t *dst, uint16_t len)
+{
+    return 0;
+}
+
+TEST(libCoap_protocol, sn_coap_protocol_prepare_streamed_message)
+{
+    sn_coap_hdr_s hdr;
+    memset(&hdr, 0, sizeof(sn_coap_hdr_s));
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_POST;
+
+    CHECK( -1 == sn_coap_protocol_prepare_streamed_message(NULL, &hdr, 100, test_payload_source, NULL));
+    CHECK( -1 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 0, test_payload_source, NULL));
+    CHECK( -1 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 100, NULL, NULL));
+
+    hdr.msg_code = COAP_MSG_CODE_RESPONSE_CONTENT;
+    CHECK( -1 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 100, test_payload_source, NULL));
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_POST;
+
+    retCounter = 0;
+    CHECK( -2 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 100, test_payload_source, NULL));
+
+    retCounter = 1;
+    CHECK( -2 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 100, test_payload_source, NULL));
+
+    retCounter = 1;
+    CHECK( -1 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 100, failing_payload_source, NULL));
+    CHECK( NULL == hdr.payload_ptr );
+
+    retCounter = 1;
+    CHECK( 0 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 100, test_payload_source, NULL));
+    CHECK( SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE == hdr.payload_len );
+    CHECK( 0x08 == (hdr.options_list_ptr->block1 & 0x08) );
+    CHECK( 100 == hdr.options_list_ptr->size1 );
+    free(hdr.payload_ptr);
+    free(hdr.options_list_ptr);
+    hdr.options_list_ptr = NULL;
+
+    // Payload fits to one block, no Block1 option needed
+    retCounter = 1;
+    CHECK( 0 == sn_coap_protocol_prepare_streamed_message(coap_handle, &hdr, 5, test_payload_source, NULL));
+    CHECK( 5 == hdr.payload_len );
+    CHECK( NULL == hdr.options_list_ptr );
+    free(hdr.payload_ptr);
+}
+
+TEST(libCoap_protocol, sn_coap_protocol_build_streamed)
+{
+    sn_nsdl_addr_s addr;
+    memset(&addr, 0, sizeof(sn_nsdl_addr_s));
+    sn_coap_hdr_s hdr;
+    memset(&hdr, 0, sizeof(sn_coap_hdr_s));
+    uint8_t dst_packet_data_ptr[50];
+
+    addr.addr_ptr = (uint8_t*)malloc(5);
+    memset(addr.addr_ptr, '1', 5);
+
+    CHECK( -2 == sn_coap_protocol_build_streamed(NULL, &addr, dst_packet_data_ptr, &hdr, 100, test_payload_source, NULL, NULL));
+    CHECK( -2 == sn_coap_protocol_build_streamed(coap_handle, &addr, dst_packet_data_ptr, &hdr, 100, NULL, NULL, NULL));
+
+    hdr.msg_type = COAP_MSG_TYPE_NON_CONFIRMABLE;
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_POST;
+    hdr.payload_ptr = (uint8_t*)malloc(SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE);
+    hdr.payload_len = SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE;
+    hdr.options_list_ptr = (sn_coap_options_list_s*)malloc(sizeof(sn_coap_options_list_s));
+    memset(hdr.options_list_ptr, 0, sizeof(sn_coap_options_list_s));
+    hdr.options_list_ptr->block1 = 0x08;
+
+    retCounter = 0;
+    CHECK( -2 == sn_coap_protocol_build_streamed(coap_handle, &addr, dst_packet_data_ptr, &hdr, 100, test_payload_source, NULL, NULL));
+
+    retCounter = 1;
+    CHECK( -2 == sn_coap_protocol_build_streamed(coap_handle, &addr, dst_packet_data_ptr, &hdr, 100, test_payload_source, NULL, NULL));
+
+    // Context is owned by the library after successful build
+    retCounter = 10;
+    sn_coap_builder_stub.expectedInt16 = 1;
+    void *context = malloc(4);
+    CHECK( 1 == sn_coap_protocol_build_streamed(coap_handle, &addr, dst_packet_data_ptr, &hdr, 100, test_payload_source, context, NULL));
+
+    free(hdr.options_list_ptr);
+    free(hdr.payload_ptr);
+    free(addr.addr_ptr);
+}
+
+uint16_t test_payload_sink(void *context, uint32_t offset, const uint8_t *src, uint16_t len)
+{
+    return len;
+}
+
+TEST(libCoap_protocol, sn_coap_protocol_start_download)
+{
+    sn_nsdl_addr_s addr;
+    memset(&addr, 0, sizeof(sn_nsdl_addr_s));
+    sn_coap_hdr_s hdr;
+    memset(&hdr, 0, sizeof(sn_coap_hdr_s));
+    uint8_t addr_data[4] = {1, 2, 3, 4};
+
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+
+    addr.addr_ptr = addr_data;
+    addr.addr_len = 4;
+    hdr.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_GET;
+
+    CHECK( -1 == sn_coap_protocol_start_download(NULL, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, NULL, &hdr, 4, test_payload_sink, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, &addr, NULL, 4, test_payload_sink, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 0, test_payload_sink, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, NULL, NULL, NULL));
+
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_PUT;
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_GET;
+
+    retCounter = 0;
+    CHECK( -2 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+
+    retCounter = 3;
+    CHECK( -2 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+
+    // First request can not be built
+    retCounter = 4;
+    sn_coap_builder_stub.expectedUint16 = 0;
+    CHECK( -1 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+
+    retCounter = 4;
+    sn_coap_builder_stub.expectedUint16 = 10;
+    CHECK( -2 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 4, test_payload_sink, NULL, NULL));
+    CHECK( ns_list_is_empty(&coap_handle->linked_list_blockwise_transfers) );
+
+    // Context is owned by the library after successful start, window is clamped
+    retCounter = 5;
+    sn_coap_builder_stub.expectedInt16 = 10;
+    void *context = malloc(4);
+    CHECK( 0 == sn_coap_protocol_start_download(coap_handle, &addr, &hdr, 200, test_payload_sink, context, NULL));
+    coap_blockwise_transfer_s *download_ptr = ns_list_get_first(&coap_handle->linked_list_blockwise_transfers);
+    CHECK( download_ptr != NULL );
+    CHECK( SN_COAP_BLOCKWISE_MAX_WINDOW == download_ptr->window );
+    CHECK( 0 != download_ptr->slots[0].msg_id );
+    CHECK( 0 == download_ptr->slots[1].msg_id );
+
+    uint32_t deadline = 0;
+    CHECK( 0 == sn_coap_protocol_get_next_deadline(coap_handle, &deadline));
+    CHECK( download_ptr->slots[0].resending_time == deadline );
+
+    // Parameter owner going away ends the download
+    sn_coap_protocol_clear_sent_messages_by_param(coap_handle, NULL);
+    CHECK( ns_list_is_empty(&coap_handle->linked_list_blockwise_transfers) );
+
+    sn_coap_builder_stub.expectedUint16 = 0;
+    sn_coap_builder_stub.expectedInt16 = 0;
+}
+
+uint16_t test_short_payload_source(void *context, uint32_t offset, uint8_t *dst, uint16_t len)
+{
+    return 0;
+}
+
+TEST(libCoap_protocol, sn_coap_protocol_start_upload)
+{
+    sn_nsdl_addr_s addr;
+    memset(&addr, 0, sizeof(sn_nsdl_addr_s));
+    sn_coap_hdr_s hdr;
+    memset(&hdr, 0, sizeof(sn_coap_hdr_s));
+    uint8_t addr_data[4] = {1, 2, 3, 4};
+
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+
+    addr.addr_ptr = addr_data;
+    addr.addr_len = 4;
+    hdr.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_PUT;
+
+    CHECK( -1 == sn_coap_protocol_start_upload(NULL, &addr, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, NULL, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, NULL, 3000, 4, test_payload_source, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 0, 4, test_payload_source, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 0, test_payload_source, NULL, NULL));
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, NULL, NULL, NULL));
+
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_GET;
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+    hdr.msg_code = COAP_MSG_CODE_REQUEST_POST;
+
+    retCounter = 0;
+    CHECK( -2 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+
+    // Block can not be read from payload source
+    retCounter = 4;
+    CHECK( -2 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+
+    retCounter = 5;
+    CHECK( -1 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_short_payload_source, NULL, NULL));
+    CHECK( ns_list_is_empty(&coap_handle->linked_list_blockwise_transfers) );
+
+    retCounter = 5;
+    sn_coap_builder_stub.expectedUint16 = 10;
+    CHECK( -2 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_payload_source, NULL, NULL));
+    CHECK( ns_list_is_empty(&coap_handle->linked_list_blockwise_transfers) );
+
+    // First block is sent alone with size of whole payload
+    retCounter = 6;
+    sn_coap_builder_stub.expectedInt16 = 10;
+    void *context = malloc(4);
+    CHECK( 0 == sn_coap_protocol_start_upload(coap_handle, &addr, &hdr, 3000, 4, test_payload_source, context, NULL));
+    coap_blockwise_transfer_s *upload_ptr = ns_list_get_first(&coap_handle->linked_list_blockwise_transfers);
+    CHECK( upload_ptr != NULL );
+    CHECK( 3000 == upload_ptr->payload_total_len );
+    CHECK( 0 != upload_ptr->slots[0].msg_id );
+    CHECK( 0 == upload_ptr->slots[1].msg_id );
+    CHECK( 0x08 == (upload_ptr->coap_msg_ptr->options_list_ptr->block1 & 0xF8) );
+    CHECK( upload_ptr->coap_msg_ptr->options_list_ptr->use_size1 );
+    CHECK( NULL == upload_ptr->coap_msg_ptr->payload_ptr );
+
+    sn_coap_protocol_clear_sent_messages_by_param(coap_handle, NULL);
+    CHECK( ns_list_is_empty(&coap_handle->linked_list_blockwise_transfers) );
+
+    sn_coap_builder_stub.expectedUint16 = 0;
+    sn_coap_builder_stub.expectedInt16 = 0;
+}
+
 TEST(libCoap_protocol, sn_coap_protocol_build)
 {
     retCounter = 1;
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_coro.h"
+
+TEST_GROUP(sn_coro)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_coro, test_sn_coro_client_get)
+{
+    CHECK(test_sn_coro_client_get());
+}
+
+TEST(sn_coro, test_sn_coro_client_overlapping)
+{
+    CHECK(test_sn_coro_client_overlapping());
+}
+
+TEST(sn_coro, test_sn_coro_client_timeout)
+{
+    CHECK(test_sn_coro_client_timeout());
+}
+
+TEST(sn_coro, test_sn_coro_client_destroyed)
+{
+    CHECK(test_sn_coro_client_destroyed());
+}
+
+TEST(sn_coro, test_sn_coro_server_immediate)
+{
+    CHECK(test_sn_coro_server_immediate());
+}
+
+TEST(sn_coro, test_sn_coro_server_deferred)
+{
+    CHECK(test_sn_coro_server_deferred());
+}
+
+TEST(sn_coro, test_sn_coro_server_no_response)
+{
+    CHECK(test_sn_coro_server_no_response());
+}
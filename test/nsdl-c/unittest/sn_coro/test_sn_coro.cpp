@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * Coroutine layer tests. A coap_client and an NSDL endpoint exchange
+ * datagrams over in-memory queues, delivered explicitly by the test so that
+ * ordering and loss can be controlled. Real library on both sides, counting
+ * allocator checks that nothing is left behind.
+ */
+
+#include "test_sn_coro.h"
+#include <string.h>
+#include <deque>
+#include "sn_coro.hpp"
+#include "alloc_tracker.h"
+
+static uint8_t client_address[4] = {10, 0, 0, 1};
+static uint8_t endpoint_address[4] = {10, 0, 0, 2};
+static std::deque<std::vector<uint8_t> > to_endpoint;
+static std::deque<std::vector<uint8_t> > to_client;
+static uint8_t static_value[] = {"mbed"};
+
+static sn_nsdl_addr_s make_address(uint8_t *addr)
+{
+    sn_nsdl_addr_s address;
+
+    address.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    address.addr_ptr = addr;
+    address.addr_len = 4;
+    address.port = 5683;
+    return address;
+}
+
+static uint8_t endpoint_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    to_client.push_back(std::vector<uint8_t>(data_ptr, data_ptr + data_len));
+    return 1;
+}
+
+static uint8_t endpoint_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+class loopback {
+public:
+    loopback()
+        : endpoint(&endpoint_tx, &endpoint_rx, &alloc_tracker_alloc, &alloc_tracker_free),
+          client(&alloc_tracker_alloc, &alloc_tracker_free, make_address(endpoint_address),
+                 [](sn::byte_view datagram, const sn_nsdl_addr_s &) {
+                     to_endpoint.push_back(std::vector<uint8_t>(datagram.begin(), datagram.end()));
+                     return true;
+                 })
+    {
+        to_endpoint.clear();
+        to_client.clear();
+    }
+
+    bool add_static(const char *path)
+    {
+        sn_nsdl_resource_info_s resource;
+        sn_nsdl_resource_parameters_s parameters;
+
+        memset(&resource, 0, sizeof(resource));
+        memset(&parameters, 0, sizeof(parameters));
+        resource.resource_parameters_ptr = &parameters;
+        resource.access = SN_GRS_GET_ALLOWED;
+        resource.mode = SN_GRS_STATIC;
+        resource.path = (uint8_t *)path;
+        resource.pathlen = (uint16_t)strlen(path);
+        resource.resource = static_value;
+        resource.resourcelen = sizeof(static_value) - 1;
+        return sn_nsdl_create_resource(endpoint.get(), &resource) == 0;
+    }
+
+    /* Delivers queued datagrams until both queues are empty */
+    void deliver()
+    {
+        sn_nsdl_addr_s from_client = make_address(client_address);
+
+        while (!to_endpoint.empty() || !to_client.empty()) {
+            if (!to_endpoint.empty()) {
+                std::vector<uint8_t> datagram = std::move(to_endpoint.front());
+                to_endpoint.pop_front();
+                endpoint.process(datagram, from_client);
+            }
+            if (!to_client.empty()) {
+                std::vector<uint8_t> datagram = std::move(to_client.front());
+                to_client.pop_front();
+                client.input(datagram);
+            }
+        }
+    }
+
+    sn::nsdl_handle endpoint;
+    sn::coap_client client;
+};
+
+/* Suspends until opened, stands for any I/O a handler waits for */
+struct gate {
+    bool await_ready() const noexcept { return open_; }
+    void await_suspend(std::coroutine_handle<> waiter) noexcept { waiter_ = waiter; }
+    void await_resume() const noexcept {}
+
+    void open()
+    {
+        open_ = true;
+        if (waiter_) {
+            std::exchange(waiter_, nullptr).resume();
+        }
+    }
+
+    bool open_ = false;
+    std::coroutine_handle<> waiter_;
+};
+
+static sn::task<> fetch(sn::coap_client &client, const char *path, std::string &result, int &completed)
+{
+    sn::coap_message response = co_await client.get(path);
+
+    if (response && response.code() == COAP_MSG_CODE_RESPONSE_CONTENT) {
+        result.assign(response.payload().begin(), response.payload().end());
+    } else if (response) {
+        result = "code " + std::to_string(response.code());
+    } else {
+        result = "failed";
+    }
+    completed++;
+}
+
+bool test_sn_coro_client_get()
+{
+    bool ret;
+    {
+        loopback net;
+        std::string result;
+        int completed = 0;
+
+        if (!net.endpoint || !net.client || !net.add_static("3/0/1")) {
+            return false;
+        }
+        sn::spawn(fetch(net.client, "/3/0/1", result, completed));
+        ret = completed == 0 && net.client.outstanding() == 1 && to_endpoint.size() == 1;
+
+        net.deliver();
+        ret = ret && completed == 1 && result == "mbed" && net.client.outstanding() == 0;
+
+        /* Unknown resource completes with the error response */
+        sn::spawn(fetch(net.client, "3/0/9", result, completed));
+        net.deliver();
+        ret = ret && completed == 2 && result == "code " + std::to_string(COAP_MSG_CODE_RESPONSE_NOT_FOUND);
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_coro_client_overlapping()
+{
+    static const char *paths[] = {"1/0/0", "1/0/1", "3/0/0", "3/0/1", "3/0/2", "3/0/3", "4/0/0", "5/0/0"};
+    const int count = sizeof(paths) / sizeof(paths[0]);
+    bool ret = true;
+    {
+        loopback net;
+        std::string results[count];
+        int completed = 0;
+
+        if (!net.endpoint || !net.client) {
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            ret = ret && net.add_static(paths[i]);
+            sn::spawn(fetch(net.client, paths[i], results[i], completed));
+        }
+        ret = ret && net.client.outstanding() == count && (int)to_endpoint.size() == count;
+
+        /* Requests are answered in reverse order, each response finds its own coroutine */
+        std::reverse(to_endpoint.begin(), to_endpoint.end());
+        net.deliver();
+
+        ret = ret && completed == count && net.client.outstanding() == 0;
+        for (int i = 0; i < count; i++) {
+            ret = ret && results[i] == "mbed";
+        }
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_coro_client_timeout()
+{
+    bool ret;
+    {
+        loopback net;
+        std::string result;
+        int completed = 0;
+
+        if (!net.endpoint || !net.client) {
+            return false;
+        }
+        net.client.set_timeout(10);
+        sn::spawn(fetch(net.client, "3/0/1", result, completed));
+
+        /* Request is lost, nothing is delivered */
+        to_endpoint.clear();
+        net.client.exec(9);
+        ret = completed == 0;
+        net.client.exec(10);
+        ret = ret && completed == 1 && result == "failed" && net.client.outstanding() == 0;
+
+        /* Late response is ignored */
+        to_endpoint.clear();
+        net.client.exec(100);
+        ret = ret && completed == 1;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_coro_client_destroyed()
+{
+    std::string result;
+    int completed = 0;
+    {
+        loopback net;
+
+        if (!net.endpoint || !net.client) {
+            return false;
+        }
+        sn::spawn(fetch(net.client, "3/0/1", result, completed));
+        sn::spawn(fetch(net.client, "3/0/2", result, completed));
+    }
+    return completed == 2 && result == "failed" && alloc_tracker_outstanding() == 0;
+}
+
+static sn::task<> respond_now(sn::server_request request)
+{
+    request.respond(COAP_MSG_CODE_RESPONSE_CONTENT, sn::byte_view((const uint8_t *)"now", 3), COAP_CT_TEXT_PLAIN);
+    co_return;
+}
+
+bool test_sn_coro_server_immediate()
+{
+    bool ret;
+    {
+        loopback net;
+        sn::coap_server server(net.endpoint.get());
+        std::string result;
+        int completed = 0;
+
+        if (!net.endpoint || !net.client || !server.add_resource("/3303/0/5700", SN_GRS_GET_ALLOWED, &respond_now)) {
+            return false;
+        }
+        sn::spawn(fetch(net.client, "3303/0/5700", result, completed));
+
+        /* Piggybacked: exactly one datagram back, the ACK carrying the response */
+        std::vector<uint8_t> request = to_endpoint.front();
+        to_endpoint.clear();
+        sn_nsdl_addr_s from_client = make_address(client_address);
+        net.endpoint.process(request, from_client);
+        ret = to_client.size() == 1 && (to_client.front()[0] & 0x30) == 0x20;
+
+        net.deliver();
+        ret = ret && completed == 1 && result == "now";
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+static sn::task<> respond_later(sn::server_request request, gate &sensor)
+{
+    co_await sensor;
+    request.respond(COAP_MSG_CODE_RESPONSE_CONTENT, request.payload(), COAP_CT_TEXT_PLAIN);
+}
+
+static sn::task<> put_value(sn::coap_client &client, std::string &result, int &completed)
+{
+    static const uint8_t value[] = {'4', '2'};
+    sn::coap_message response = co_await client.put("sensor", value);
+
+    if (response) {
+        result.assign(response.payload().begin(), response.payload().end());
+    }
+    completed++;
+}
+
+bool test_sn_coro_server_deferred()
+{
+    bool ret;
+    {
+        loopback net;
+        sn::coap_server server(net.endpoint.get());
+        gate sensor;
+        std::string result;
+        int completed = 0;
+
+        if (!net.endpoint || !net.client ||
+                !server.add_resource("sensor", SN_GRS_PUT_ALLOWED,
+                                     [&sensor](sn::server_request request) {
+                                         return respond_later(std::move(request), sensor);
+                                     })) {
+            return false;
+        }
+        sn::spawn(put_value(net.client, result, completed));
+
+        /* Handler waits: request is acknowledged with an empty ACK, client keeps waiting */
+        net.deliver();
+        ret = completed == 0 && net.client.outstanding() == 1;
+
+        /* Client must not resend the acknowledged request */
+        net.client.exec(60);
+        ret = ret && to_endpoint.empty();
+
+        /* Separate response is confirmable, client acknowledges it */
+        sensor.open();
+        ret = ret && to_client.size() == 1 && (to_client.front()[0] & 0x30) == 0x00;
+        net.deliver();
+        ret = ret && completed == 1 && result == "42" && net.client.outstanding() == 0;
+
+        /* Acknowledged response is not resent by the endpoint */
+        net.endpoint.exec(60);
+        ret = ret && to_client.empty();
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+static sn::task<> forget(sn::server_request request, gate &sensor)
+{
+    co_await sensor;
+}
+
+bool test_sn_coro_server_no_response()
+{
+    bool ret;
+    {
+        loopback net;
+        sn::coap_server server(net.endpoint.get());
+        gate sensor;
+        std::string result;
+        int completed = 0;
+
+        if (!net.endpoint || !net.client ||
+                !server.add_resource("3/0/1", SN_GRS_GET_ALLOWED,
+                                     [&sensor](sn::server_request request) {
+                                         return forget(std::move(request), sensor);
+                                     })) {
+            return false;
+        }
+        sn::spawn(fetch(net.client, "3/0/1", result, completed));
+        net.deliver();
+        sensor.open();
+        net.deliver();
+        ret = completed == 1 && result == "code " + std::to_string(COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR);
+
+        /* Server gone while handler waits, late response is dropped */
+        gate late;
+        {
+            sn::coap_server temporary(net.endpoint.get());
+
+            ret = ret && temporary.add_resource("3/0/2", SN_GRS_GET_ALLOWED,
+                                                [&late](sn::server_request request) {
+                                                    return forget(std::move(request), late);
+                                                });
+            sn::spawn(fetch(net.client, "3/0/2", result, completed));
+            net.deliver();
+        }
+        late.open();
+        ret = ret && to_client.empty() && completed == 1 && net.client.outstanding() == 1;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_CORO_H
+#define TEST_SN_CORO_H
+
+bool test_sn_coro_client_get();
+bool test_sn_coro_client_overlapping();
+bool test_sn_coro_client_timeout();
+bool test_sn_coro_client_destroyed();
+bool test_sn_coro_server_immediate();
+bool test_sn_coro_server_deferred();
+bool test_sn_coro_server_no_response();
+
+#endif // TEST_SN_CORO_H
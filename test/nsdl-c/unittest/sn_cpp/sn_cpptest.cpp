@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_cpp.h"
+
+TEST_GROUP(sn_cpp)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_cpp, test_sn_cpp_build_and_parse)
+{
+    CHECK(test_sn_cpp_build_and_parse());
+}
+
+TEST(sn_cpp, test_sn_cpp_move)
+{
+    CHECK(test_sn_cpp_move());
+}
+
+TEST(sn_cpp, test_sn_cpp_response)
+{
+    CHECK(test_sn_cpp_response());
+}
+
+TEST(sn_cpp, test_sn_cpp_borrowed_options)
+{
+    CHECK(test_sn_cpp_borrowed_options());
+}
+
+TEST(sn_cpp, test_sn_cpp_blockwise_payload)
+{
+    CHECK(test_sn_cpp_blockwise_payload());
+}
+
+TEST(sn_cpp, test_sn_cpp_nsdl_handle)
+{
+    CHECK(test_sn_cpp_nsdl_handle());
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * C++ layer tests, run against the real library with the counting allocator
+ * so that every owner is checked to release exactly what the C API expects.
+ */
+
+#include "test_sn_cpp.h"
+#include <string.h>
+#include "sn_cpp.hpp"
+#include "alloc_tracker.h"
+
+static uint8_t peer_address[4] = {10, 0, 0, 1};
+static uint8_t static_value[] = {"mbed"};
+static uint16_t nsdl_tx_count;
+
+static sn_nsdl_addr_s peer()
+{
+    sn_nsdl_addr_s address;
+
+    address.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    address.addr_ptr = peer_address;
+    address.addr_len = sizeof(peer_address);
+    address.port = 5683;
+    return address;
+}
+
+static uint8_t cpp_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    return 1;
+}
+
+static uint8_t cpp_nsdl_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    nsdl_tx_count++;
+    return 1;
+}
+
+static uint8_t cpp_nsdl_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+static sn::coap_handle create_handle()
+{
+    return sn::coap_handle(&alloc_tracker_alloc, &alloc_tracker_free, &cpp_coap_tx);
+}
+
+bool test_sn_cpp_build_and_parse()
+{
+    static const uint8_t token[] = {0x5a, 0x17, 0xc3, 0x09};
+    static const uint8_t payload[] = {'2', '1', '.', '5'};
+    bool ret = false;
+    {
+        sn::coap_handle coap = create_handle();
+        sn_nsdl_addr_s address = peer();
+        std::vector<uint8_t> datagram;
+
+        if (!coap) {
+            return false;
+        }
+        {
+            sn::coap_message msg = coap.create_message();
+
+            if (!msg || !msg.set_token(token) || !msg.set_uri_path("3303/0/5700")) {
+                return false;
+            }
+            msg.set_type(COAP_MSG_TYPE_NON_CONFIRMABLE);
+            msg.set_code(COAP_MSG_CODE_RESPONSE_CONTENT);
+            msg.set_msg_id(77);
+            msg.set_content_format(COAP_CT_TEXT_PLAIN);
+            msg.set_payload(payload);
+            datagram = coap.build(msg, address);
+        }
+        if (datagram.empty()) {
+            return false;
+        }
+
+        sn::coap_message parsed = coap.parse(std::move(datagram), address);
+
+        ret = parsed &&
+              parsed.type() == COAP_MSG_TYPE_NON_CONFIRMABLE &&
+              parsed.code() == COAP_MSG_CODE_RESPONSE_CONTENT &&
+              parsed.msg_id() == 77 &&
+              parsed.content_format() == COAP_CT_TEXT_PLAIN &&
+              parsed.token().size() == sizeof(token) &&
+              memcmp(parsed.token().data(), token, sizeof(token)) == 0 &&
+              parsed.uri_path() == "3303/0/5700" &&
+              parsed.payload().size() == sizeof(payload) &&
+              memcmp(parsed.payload().data(), payload, sizeof(payload)) == 0 &&
+              parsed.uri_query().empty() &&
+              parsed.observe() == -1;
+
+        /* Too long token is refused without touching the message */
+        static const uint8_t long_token[9] = {0};
+        ret = ret && !parsed.set_token(long_token) && parsed.token().size() == sizeof(token);
+
+        /* Oversized datagram is refused */
+        std::vector<uint8_t> oversized(UINT16_MAX + 1u);
+        ret = ret && !coap.parse_packet(oversized);
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_cpp_move()
+{
+    bool ret;
+    {
+        sn::coap_handle coap = create_handle();
+        sn::coap_message first = coap.create_message();
+        sn::coap_message second;
+
+        if (!first || second) {
+            return false;
+        }
+        first.set_msg_id(5);
+        second = std::move(first);
+        ret = !first && second && second.msg_id() == 5;
+
+        sn::coap_message third(std::move(second));
+        ret = ret && !second && third && third.msg_id() == 5;
+
+        /* Assigning over an owning message releases the old one */
+        third = coap.create_message();
+        ret = ret && third && third.msg_id() == 0;
+
+        third.reset();
+        ret = ret && !third;
+
+        /* Released message is owned by the caller */
+        sn::coap_message released = coap.create_message();
+        sn_coap_hdr_s *hdr = released.release();
+        ret = ret && hdr && !released;
+        sn_coap_parser_release_allocated_coap_msg_mem(coap.get(), hdr);
+
+        /* Handles move too, the moved-from one does not destroy */
+        sn::coap_handle other = std::move(coap);
+        ret = ret && !coap && other;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_cpp_response()
+{
+    static const uint8_t token[] = {0x01, 0x02};
+    bool ret;
+    {
+        sn::coap_handle coap = create_handle();
+        sn_nsdl_addr_s address = peer();
+        std::vector<uint8_t> datagram;
+        {
+            sn::coap_message request = coap.create_message();
+
+            if (!request || !request.set_token(token) || !request.set_uri_path("3/0/0")) {
+                return false;
+            }
+            request.set_type(COAP_MSG_TYPE_CONFIRMABLE);
+            request.set_code(COAP_MSG_CODE_REQUEST_GET);
+            request.set_msg_id(1000);
+            datagram = coap.build(request, address);
+        }
+
+        /* Request is parsed in place, views refer to the datagram */
+        sn::coap_message request = coap.parse_packet(datagram);
+        sn::coap_message response = coap.create_response(request, COAP_MSG_CODE_RESPONSE_CONTENT);
+
+        ret = request && request.observe() == -1 && request.uri_path() == "3/0/0" &&
+              response &&
+              response.type() == COAP_MSG_TYPE_ACKNOWLEDGEMENT &&
+              response.code() == COAP_MSG_CODE_RESPONSE_CONTENT &&
+              response.msg_id() == 1000 &&
+              response.token().size() == sizeof(token) &&
+              memcmp(response.token().data(), token, sizeof(token)) == 0;
+
+        ret = ret && !coap.create_response(sn::coap_message(), COAP_MSG_CODE_RESPONSE_CONTENT);
+
+        /* Notification carries observe option instead of uri path */
+        ret = ret && response.set_observe(5);
+        sn::coap_message notification = coap.parse_packet(coap.build(response, address));
+        ret = ret && notification && notification.observe() == 5 && notification.uri_path().empty();
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_cpp_borrowed_options()
+{
+    static const char query[] = "ep=node&lt=3600";
+    bool ret;
+    {
+        sn::coap_handle coap = create_handle();
+        sn_nsdl_addr_s address = peer();
+        std::vector<uint8_t> datagram;
+        {
+            sn::coap_message msg = coap.create_message();
+
+            if (!msg || !msg.set_uri_path("rd")) {
+                return false;
+            }
+            msg.set_type(COAP_MSG_TYPE_NON_CONFIRMABLE);
+            msg.set_code(COAP_MSG_CODE_REQUEST_POST);
+            /* Borrowed twice, second one replaces the first without freeing either */
+            if (!msg.borrow_uri_query("stale") || !msg.borrow_uri_query(query) ||
+                !msg.borrow_location_path("rd/1") || !msg.borrow_location_query("q")) {
+                return false;
+            }
+            datagram = coap.build(msg, address);
+        }
+
+        sn::coap_message parsed = coap.parse_packet(std::move(datagram));
+
+        ret = parsed &&
+              parsed.uri_query() == std::string_view(query, sizeof(query) - 1) &&
+              parsed.location_path() == "rd/1";
+
+        /* Borrowing over an allocated option frees the library copy */
+        ret = ret && parsed.borrow_uri_query(query) && parsed.uri_query().data() == query;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_cpp_blockwise_payload()
+{
+    uint8_t payload[40];
+    bool ret = false;
+
+    for (uint8_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = i;
+    }
+    {
+        sn::coap_handle sender = create_handle();
+        sn::coap_handle receiver = create_handle();
+        sn_nsdl_addr_s address = peer();
+        sn::coap_message received;
+
+        if (!sender || !receiver) {
+            return false;
+        }
+
+        /* Block1 request in 16 byte blocks, receiver acknowledges all but the last one */
+        for (uint8_t block = 0; block * 16 < sizeof(payload); block++) {
+            sn::coap_message msg = sender.create_message();
+            uint8_t len = sizeof(payload) - block * 16 > 16 ? 16 : sizeof(payload) - block * 16;
+
+            if (!msg || !msg.set_uri_path("fw") || !sn_coap_parser_alloc_options(sender.get(), msg.get())) {
+                return false;
+            }
+            msg.set_type(COAP_MSG_TYPE_NON_CONFIRMABLE);
+            msg.set_code(COAP_MSG_CODE_REQUEST_PUT);
+            msg.set_msg_id(300 + block);
+            msg.set_payload(sn::byte_view(payload + block * 16, len));
+            msg.get()->options_list_ptr->block1 = (block << 4) | (len == 16 ? 0x08 : 0);
+
+            received = receiver.parse(sender.build(msg, address), address);
+            if (!received || received.status() != COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING) {
+                break;
+            }
+        }
+
+        /* Reassembled payload was allocated by the library, it is freed with the message */
+        ret = received &&
+              received.status() == COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVED &&
+              received.payload().size() == sizeof(payload) &&
+              memcmp(received.payload().data(), payload, sizeof(payload)) == 0;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_cpp_nsdl_handle()
+{
+    static const uint8_t token[] = {0x0a, 0x0b};
+    static const uint8_t value[] = {'1'};
+    bool ret;
+    {
+        sn::nsdl_handle nsdl(&cpp_nsdl_tx, &cpp_nsdl_rx, &alloc_tracker_alloc, &alloc_tracker_free);
+        sn::coap_handle coap = create_handle();
+        sn_nsdl_addr_s address = peer();
+        sn_nsdl_resource_info_s resource;
+        sn_nsdl_resource_parameters_s parameters;
+        std::vector<uint8_t> datagram;
+
+        if (!nsdl || !coap) {
+            return false;
+        }
+        set_NSP_address(nsdl.get(), peer_address, address.port, SN_NSDL_ADDRESS_TYPE_IPV4);
+
+        memset(&resource, 0, sizeof(resource));
+        memset(&parameters, 0, sizeof(parameters));
+        resource.resource_parameters_ptr = &parameters;
+        resource.access = SN_GRS_GET_ALLOWED;
+        resource.mode = SN_GRS_STATIC;
+        resource.path = (uint8_t *)"3/0/0";
+        resource.pathlen = 5;
+        resource.resource = static_value;
+        resource.resourcelen = sizeof(static_value) - 1;
+        if (sn_nsdl_create_resource(nsdl.get(), &resource) != 0) {
+            return false;
+        }
+        {
+            sn::coap_message request = coap.create_message();
+
+            if (!request || !request.set_token(token) || !request.set_uri_path("3/0/0")) {
+                return false;
+            }
+            request.set_type(COAP_MSG_TYPE_CONFIRMABLE);
+            request.set_code(COAP_MSG_CODE_REQUEST_GET);
+            request.set_msg_id(9);
+            datagram = coap.build(request, address);
+        }
+
+        nsdl_tx_count = 0;
+        ret = nsdl.process(datagram, address) == SN_NSDL_SUCCESS && nsdl_tx_count == 1;
+
+        nsdl_tx_count = 0;
+        ret = ret && nsdl.send_notification(token, value, COAP_OBSERVE_NONE) != 0 && nsdl_tx_count == 1;
+
+        static const uint8_t long_token[9] = {0};
+        ret = ret && nsdl.send_notification(long_token, value, COAP_OBSERVE_NONE) == 0;
+        ret = ret && nsdl.exec(1) == SN_NSDL_SUCCESS;
+
+        sn::nsdl_handle other = std::move(nsdl);
+        ret = ret && !nsdl && other;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
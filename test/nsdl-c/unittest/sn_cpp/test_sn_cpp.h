@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_CPP_H
+#define TEST_SN_CPP_H
+
+bool test_sn_cpp_build_and_parse();
+bool test_sn_cpp_move();
+bool test_sn_cpp_response();
+bool test_sn_cpp_borrowed_options();
+bool test_sn_cpp_blockwise_payload();
+bool test_sn_cpp_nsdl_handle();
+
+#endif // TEST_SN_CPP_H
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_executor.h"
+
+TEST_GROUP(sn_executor)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_executor, test_sn_executor_pool_runs_all)
+{
+    CHECK(test_sn_executor_pool_runs_all());
+}
+
+TEST(sn_executor, test_sn_executor_pool_steals)
+{
+    CHECK(test_sn_executor_pool_steals());
+}
+
+TEST(sn_executor, test_sn_executor_deferred)
+{
+    CHECK(test_sn_executor_deferred());
+}
+
+TEST(sn_executor, test_sn_executor_handler_throws)
+{
+    CHECK(test_sn_executor_handler_throws());
+}
+
+TEST(sn_executor, test_sn_executor_dispatcher_destroyed)
+{
+    CHECK(test_sn_executor_dispatcher_destroyed());
+}
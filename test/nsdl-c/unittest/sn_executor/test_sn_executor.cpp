@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * Pool dispatcher tests. Handlers run on real worker threads; the test
+ * thread owns the NSDL handle, processes requests and polls completions.
+ * Waits are bounded so that a lost job fails the test instead of hanging it.
+ */
+
+#include "test_sn_executor.h"
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include "sn_executor.hpp"
+#include "alloc_tracker.h"
+
+static uint8_t client_address[4] = {10, 0, 0, 1};
+static std::deque<std::vector<uint8_t> > to_client;
+
+static sn_nsdl_addr_s make_address()
+{
+    sn_nsdl_addr_s address;
+
+    address.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    address.addr_ptr = client_address;
+    address.addr_len = 4;
+    address.port = 5683;
+    return address;
+}
+
+static uint8_t endpoint_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    to_client.push_back(std::vector<uint8_t>(data_ptr, data_ptr + data_len));
+    return 1;
+}
+
+static uint8_t endpoint_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+static uint8_t client_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    return 1;
+}
+
+/* Released from the test thread, waited by handlers */
+class latch {
+public:
+    void open()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        open_ = true;
+        changed_.notify_all();
+    }
+
+    bool wait()
+    {
+        std::unique_lock<std::mutex> guard(lock_);
+        return changed_.wait_for(guard, std::chrono::seconds(10), [this] { return open_; });
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable changed_;
+    bool open_ = false;
+};
+
+class endpoint {
+public:
+    endpoint()
+        : nsdl(&endpoint_tx, &endpoint_rx, &alloc_tracker_alloc, &alloc_tracker_free),
+          client(&alloc_tracker_alloc, &alloc_tracker_free, &client_tx)
+    {
+        to_client.clear();
+    }
+
+    bool request(const char *path, sn_coap_msg_type_e type, uint8_t token)
+    {
+        std::vector<uint8_t> datagram;
+        sn_nsdl_addr_s from_client = make_address();
+        {
+            sn::coap_message message = client.create_message();
+
+            if (!message || !message.set_token(sn::byte_view(&token, 1)) || !message.set_uri_path(path)) {
+                return false;
+            }
+            message.set_type(type);
+            message.set_code(COAP_MSG_CODE_REQUEST_GET);
+            message.set_msg_id(token);
+            datagram = client.build(message, from_client);
+        }
+        return !datagram.empty() && nsdl.process(datagram, from_client) == SN_NSDL_SUCCESS;
+    }
+
+    /* Polls until count responses are sent or time runs out */
+    bool poll_until(sn::pool_dispatcher &dispatcher, std::size_t count)
+    {
+        std::chrono::steady_clock::time_point give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        std::size_t sent = 0;
+
+        while (sent < count && std::chrono::steady_clock::now() < give_up) {
+            sent += dispatcher.poll();
+            std::this_thread::yield();
+        }
+        return sent == count;
+    }
+
+    sn::coap_message received()
+    {
+        if (to_client.empty()) {
+            return sn::coap_message();
+        }
+        std::vector<uint8_t> datagram = std::move(to_client.front());
+        sn_nsdl_addr_s from_endpoint = make_address();
+
+        to_client.pop_front();
+        return client.parse(std::move(datagram), from_endpoint);
+    }
+
+    sn::nsdl_handle nsdl;
+    sn::coap_handle client;
+};
+
+bool test_sn_executor_pool_runs_all()
+{
+    std::atomic<int> done(0);
+    {
+        sn::work_stealing_pool pool(4);
+
+        for (int i = 0; i < 1000; i++) {
+            pool.submit([&pool, &done] {
+                /* Follow-up job goes to the worker's own deque */
+                pool.submit([&done] {
+                    done++;
+                });
+                done++;
+            });
+        }
+    }
+    return done == 2000;
+}
+
+bool test_sn_executor_pool_steals()
+{
+    sn::work_stealing_pool pool(2);
+    latch finished;
+    std::atomic<int> done(0);
+    std::atomic<bool> ret(false);
+
+    /* Worker blocks after queueing to its own deque, only the other worker can run those jobs */
+    pool.submit([&] {
+        latch stolen;
+
+        for (int i = 0; i < 8; i++) {
+            pool.submit([&] {
+                if (++done == 8) {
+                    stolen.open();
+                }
+            });
+        }
+        ret = stolen.wait();
+        finished.open();
+    });
+    return finished.wait() && ret && done == 8 && pool.steals() >= 8;
+}
+
+bool test_sn_executor_deferred()
+{
+    bool ret;
+    {
+        sn::work_stealing_pool pool(2);
+        endpoint ep;
+        std::atomic<int> wakeups(0);
+        sn::pool_dispatcher dispatcher(ep.nsdl.get(), pool, [&wakeups] { wakeups++; });
+        latch sensor;
+
+        if (!ep.nsdl ||
+                !dispatcher.add_resource("/3303/0/5700", SN_GRS_GET_ALLOWED,
+                                         [&sensor](const sn::pool_dispatcher::request &request) {
+                                             sensor.wait();
+                                             return sn::pool_dispatcher::response{COAP_MSG_CODE_RESPONSE_CONTENT,
+                                                                                  std::vector<uint8_t>(request.uri_path.begin(), request.uri_path.begin() + 4),
+                                                                                  COAP_CT_TEXT_PLAIN};
+                                         }) ||
+                !dispatcher.add_resource("3/0/1", SN_GRS_GET_ALLOWED,
+                                         [](const sn::pool_dispatcher::request &request) {
+                                             return sn::pool_dispatcher::response{COAP_MSG_CODE_RESPONSE_CONTENT, {'m', 'b', 'e', 'd'}};
+                                         })) {
+            return false;
+        }
+
+        /* Slow request is acknowledged at once, nothing else */
+        ret = ep.request("3303/0/5700", COAP_MSG_TYPE_CONFIRMABLE, 1) && to_client.size() == 1;
+        sn::coap_message ack = ep.received();
+        ret = ret && ack && ack.type() == COAP_MSG_TYPE_ACKNOWLEDGEMENT && ack.code() == COAP_MSG_CODE_EMPTY && ack.msg_id() == 1;
+
+        /* Fast request is answered while the slow one still runs */
+        ret = ret && ep.request("3/0/1", COAP_MSG_TYPE_NON_CONFIRMABLE, 2) && to_client.empty();
+        ret = ret && ep.poll_until(dispatcher, 1) && dispatcher.in_flight() == 1;
+        sn::coap_message fast = ep.received();
+        ret = ret && fast && fast.type() == COAP_MSG_TYPE_NON_CONFIRMABLE && fast.token().size() == 1 &&
+              fast.token()[0] == 2 && fast.payload().size() == 4 && memcmp(fast.payload().data(), "mbed", 4) == 0;
+
+        /* Separate response of the slow one is confirmable and carries its token */
+        sensor.open();
+        ret = ret && ep.poll_until(dispatcher, 1) && dispatcher.in_flight() == 0 && wakeups == 2;
+        sn::coap_message slow = ep.received();
+        ret = ret && slow && slow.type() == COAP_MSG_TYPE_CONFIRMABLE && slow.token().size() == 1 &&
+              slow.token()[0] == 1 && slow.content_format() == COAP_CT_TEXT_PLAIN &&
+              slow.payload().size() == 4 && memcmp(slow.payload().data(), "3303", 4) == 0;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_executor_handler_throws()
+{
+    bool ret;
+    {
+        sn::work_stealing_pool pool(1);
+        endpoint ep;
+        sn::pool_dispatcher dispatcher(ep.nsdl.get(), pool);
+
+        if (!ep.nsdl ||
+                !dispatcher.add_resource("3/0/1", SN_GRS_GET_ALLOWED,
+                                         [](const sn::pool_dispatcher::request &) -> sn::pool_dispatcher::response {
+                                             throw std::runtime_error("sensor");
+                                         })) {
+            return false;
+        }
+        ret = ep.request("3/0/1", COAP_MSG_TYPE_NON_CONFIRMABLE, 3) && ep.poll_until(dispatcher, 1);
+        sn::coap_message response = ep.received();
+        ret = ret && response && response.code() == COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_executor_dispatcher_destroyed()
+{
+    bool ret;
+    {
+        sn::work_stealing_pool pool(1);
+        endpoint ep;
+        latch sensor;
+        std::atomic<bool> ran(false);
+
+        if (!ep.nsdl) {
+            return false;
+        }
+        {
+            sn::pool_dispatcher dispatcher(ep.nsdl.get(), pool);
+
+            ret = dispatcher.add_resource("3/0/1", SN_GRS_GET_ALLOWED,
+                                          [&](const sn::pool_dispatcher::request &) {
+                                              sensor.wait();
+                                              ran = true;
+                                              return sn::pool_dispatcher::response{COAP_MSG_CODE_RESPONSE_CONTENT, {}};
+                                          });
+            ret = ret && ep.request("3/0/1", COAP_MSG_TYPE_CONFIRMABLE, 4) && dispatcher.in_flight() == 1;
+        }
+        to_client.clear();
+
+        /* Handler outlives its dispatcher, its response is dropped */
+        sensor.open();
+        while (!ran) {
+            std::this_thread::yield();
+        }
+
+        /* Resource is gone with the dispatcher */
+        ret = ret && ep.request("3/0/1", COAP_MSG_TYPE_CONFIRMABLE, 5);
+        sn::coap_message response = ep.received();
+        ret = ret && response && response.code() == COAP_MSG_CODE_RESPONSE_NOT_FOUND && to_client.empty();
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
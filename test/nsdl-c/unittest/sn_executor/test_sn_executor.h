@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_EXECUTOR_H
+#define TEST_SN_EXECUTOR_H
+
+bool test_sn_executor_pool_runs_all();
+bool test_sn_executor_pool_steals();
+bool test_sn_executor_deferred();
+bool test_sn_executor_handler_throws();
+bool test_sn_executor_dispatcher_destroyed();
+
+#endif // TEST_SN_EXECUTOR_H
@@ -86,3 +86,27 @@ TEST(sn_grs, test_sn_grs_mark_resources_as_registered)
     CHECK(test_sn_grs_mark_resources_as_registered());
 }
 
+TEST(sn_grs, test_sn_grs_removed_resource_tracking)
+{
+    CHECK(test_sn_grs_removed_resource_tracking());
+}
+
+TEST(sn_grs, test_sn_grs_session_slots)
+{
+    CHECK(test_sn_grs_session_slots());
+}
+
+TEST(sn_grs, test_sn_grs_resource_template)
+{
+    CHECK(test_sn_grs_resource_template());
+}
+
+TEST(sn_grs, test_sn_grs_make_writable)
+{
+    CHECK(test_sn_grs_make_writable());
+}
+
+TEST(sn_grs, test_sn_grs_static_dispatch)
+{
+    CHECK(test_sn_grs_static_dispatch());
+}
@@ -1223,3 +1223,561 @@ bool test_sn_grs_mark_resources_as_registered()
     return true;
 }
 
+bool test_sn_grs_removed_resource_tracking()
+{
+    sn_grs_set_removed_resource_tracking(NULL, true);
+    if( NULL != sn_grs_get_first_removed_resource(NULL) ){
+        return false;
+    }
+
+    struct grs_s* handle = (struct grs_s*)malloc(sizeof(struct grs_s));
+    memset(handle, 0, sizeof(struct grs_s));
+    handle->sn_grs_alloc = myMalloc;
+    handle->sn_grs_free = myFree;
+
+    sn_nsdl_resource_parameters_s params;
+    memset(&params, 0, sizeof(sn_nsdl_resource_parameters_s));
+    sn_nsdl_resource_info_s res;
+    memset(&res, 0, sizeof(sn_nsdl_resource_info_s));
+    uint8_t path[3] = {'a', '/', '1'};
+    res.path = path;
+    res.pathlen = 3;
+    res.publish_uri = 1;
+    res.resource_parameters_ptr = &params;
+
+    // Not tracked
+    retCounter = 3;
+    if( SN_NSDL_SUCCESS != sn_grs_create_resource(handle, &res) ){
+        return false;
+    }
+    sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD)->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
+    if( SN_NSDL_SUCCESS != sn_grs_delete_resource(handle, 3, path) ){
+        return false;
+    }
+    if( NULL != sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+
+    // Unregistered resource is not reported
+    sn_grs_set_removed_resource_tracking(handle, true);
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    sn_grs_delete_resource(handle, 3, path);
+    if( NULL != sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+
+    // Out of memory, removal is lost
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD)->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
+    retCounter = 1;
+    sn_grs_delete_resource(handle, 3, path);
+    if( NULL != sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+
+    // Re-created resource cancels pending removal
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD)->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
+    retCounter = 2;
+    sn_grs_delete_resource(handle, 3, path);
+    const sn_grs_removed_resource_s *removed = sn_grs_get_first_removed_resource(handle);
+    if( !removed || removed->pathlen != 3 || memcmp(removed->path, path, 3) || removed->sending ||
+        removed->sessions != SN_GRS_SESSION_BIT(0) ){
+        return false;
+    }
+    if( NULL != sn_grs_get_next_removed_resource(handle, removed) ){
+        return false;
+    }
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    if( NULL != sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+
+    // Removal being sent is kept until released
+    sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD)->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
+    retCounter = 2;
+    sn_grs_delete_resource(handle, 3, path);
+    sn_grs_mark_removed_resources_as_sending(handle, 0);
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    if( NULL == sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+    sn_grs_release_removed_resources(handle, SN_GRS_SESSION_BIT(0), true);
+    if( NULL != sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+
+    // Disabling drops pending removals
+    sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD)->resource_parameters_ptr->registered = SN_NDSL_RESOURCE_REGISTERED;
+    retCounter = 2;
+    sn_grs_delete_resource(handle, 3, path);
+    sn_grs_set_removed_resource_tracking(handle, false);
+    if( NULL != sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+
+    sn_grs_destroy(handle);
+    return true;
+}
+
+
+bool test_sn_grs_session_slots()
+{
+    if( -1 != sn_grs_alloc_session_slot(NULL) ){
+        return false;
+    }
+    sn_grs_free_session_slot(NULL, 0);
+
+    struct grs_s* handle = (struct grs_s*)malloc(sizeof(struct grs_s));
+    memset(handle, 0, sizeof(struct grs_s));
+    handle->sn_grs_alloc = myMalloc;
+    handle->sn_grs_free = myFree;
+    handle->session_count = 1;
+    handle->session_slots = SN_GRS_SESSION_BIT(0);
+
+    // Lowest free slot is taken until all are in use
+    if( 1 != sn_grs_alloc_session_slot(handle) || 2 != sn_grs_alloc_session_slot(handle) ||
+        3 != sn_grs_alloc_session_slot(handle) || -1 != sn_grs_alloc_session_slot(handle) ||
+        handle->session_count != 4 ){
+        return false;
+    }
+
+    sn_nsdl_resource_parameters_s params;
+    memset(&params, 0, sizeof(sn_nsdl_resource_parameters_s));
+    sn_nsdl_resource_info_s res;
+    memset(&res, 0, sizeof(sn_nsdl_resource_info_s));
+    uint8_t path[3] = {'a', '/', '1'};
+    res.path = path;
+    res.pathlen = 3;
+    res.publish_uri = 1;
+    res.resource_parameters_ptr = &params;
+
+    retCounter = 3;
+    if( SN_NSDL_SUCCESS != sn_grs_create_resource(handle, &res) ){
+        return false;
+    }
+    const sn_nsdl_resource_info_s *stored = sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD);
+
+    // Registration of one session does not change the others
+    sn_grs_set_registration_state(handle, stored, 0, SN_NDSL_RESOURCE_REGISTERED);
+    sn_grs_set_registration_state(handle, stored, 2, SN_NDSL_RESOURCE_REGISTERING);
+    if( SN_NDSL_RESOURCE_REGISTERED != sn_grs_get_registration_state(handle, stored, 0) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, stored, 1) ||
+        SN_NDSL_RESOURCE_REGISTERING != sn_grs_get_registration_state(handle, stored, 2) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, stored, 3) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, stored, SN_GRS_MAX_SESSIONS) ){
+        return false;
+    }
+
+    // Removal is kept for each session whose server has the link
+    sn_grs_set_removed_resource_tracking(handle, true);
+    retCounter = 2;
+    sn_grs_delete_resource(handle, 3, path);
+    const sn_grs_removed_resource_s *removed = sn_grs_get_first_removed_resource(handle);
+    if( !removed || removed->sessions != (SN_GRS_SESSION_BIT(0) | SN_GRS_SESSION_BIT(2)) ){
+        return false;
+    }
+    sn_grs_mark_removed_resources_as_sending(handle, 0);
+    sn_grs_mark_removed_resources_as_sending(handle, 1);
+    if( removed->sending != SN_GRS_SESSION_BIT(0) ){
+        return false;
+    }
+    sn_grs_release_removed_resources(handle, SN_GRS_SESSION_BIT(0), true);
+    removed = sn_grs_get_first_removed_resource(handle);
+    if( !removed || removed->sessions != SN_GRS_SESSION_BIT(2) || removed->sending ){
+        return false;
+    }
+
+    // Re-created resource keeps removal only for session already sending it
+    sn_grs_mark_removed_resources_as_sending(handle, 2);
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    stored = sn_grs_search_resource(handle, 3, path, SN_GRS_SEARCH_METHOD);
+    removed = sn_grs_get_first_removed_resource(handle);
+    if( !removed || removed->sessions != SN_GRS_SESSION_BIT(2) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, stored, 0) ){
+        return false;
+    }
+
+    // Freed slot forgets its registrations and pending removals
+    sn_grs_set_registration_state(handle, stored, 0, SN_NDSL_RESOURCE_REGISTERED);
+    sn_grs_set_registration_state(handle, stored, 2, SN_NDSL_RESOURCE_REGISTERED);
+    sn_grs_free_session_slot(handle, 2);
+    if( sn_grs_get_first_removed_resource(handle) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, stored, 2) ||
+        SN_NDSL_RESOURCE_REGISTERED != sn_grs_get_registration_state(handle, stored, 0) ||
+        handle->session_slots != 0x0B || handle->session_count != 3 ){
+        return false;
+    }
+    sn_grs_free_session_slot(handle, 2);
+    if( handle->session_count != 3 || 2 != sn_grs_alloc_session_slot(handle) ){
+        return false;
+    }
+
+    sn_grs_destroy(handle);
+    return true;
+}
+
+bool test_sn_grs_resource_template()
+{
+    static uint8_t rt[] = {"oma.lwm2m"};
+    static sn_nsdl_resource_parameters_s params = {0, 0, sizeof(rt) - 1, 0, 0, rt, NULL};
+    static sn_nsdl_resource_info_s templ[3];
+    static uint8_t value[] = {'A', 'R', 'M'};
+    uint8_t bad_path[] = {'/', '3'};
+
+    memset(templ, 0, sizeof(templ));
+    templ[0].path = (uint8_t *)"3/0/0";
+    templ[0].pathlen = 5;
+    templ[0].mode = SN_GRS_STATIC;
+    templ[0].access = SN_GRS_GET_ALLOWED | SN_GRS_PUT_ALLOWED;
+    templ[0].publish_uri = 1;
+    templ[0].resource = value;
+    templ[0].resourcelen = sizeof(value);
+    templ[0].resource_parameters_ptr = &params;
+    templ[1].path = (uint8_t *)"3/0/1";
+    templ[1].pathlen = 5;
+    templ[1].mode = SN_GRS_DYNAMIC;
+    templ[1].publish_uri = 1;
+    templ[1].sn_grs_dyn_res_callback = &myResCallback;
+    templ[1].resource_parameters_ptr = &params;
+    templ[2].path = (uint8_t *)"1/0/1";
+    templ[2].pathlen = 5;
+    templ[2].mode = SN_GRS_STATIC;
+
+    sn_nsdl_resource_info_s saved[3];
+    memcpy(saved, templ, sizeof(templ));
+
+    if( SN_NSDL_FAILURE != sn_grs_set_resource_template(NULL, templ, 3) ){
+        return false;
+    }
+
+    struct grs_s* handle = (struct grs_s*)malloc(sizeof(struct grs_s));
+    memset(handle, 0, sizeof(struct grs_s));
+    handle->sn_grs_alloc = myMalloc;
+    handle->sn_grs_free = myFree;
+
+    sn_nsdl_resource_parameters_s own_params;
+    memset(&own_params, 0, sizeof(sn_nsdl_resource_parameters_s));
+    sn_nsdl_resource_info_s res;
+    memset(&res, 0, sizeof(sn_nsdl_resource_info_s));
+    res.path = (uint8_t *)"1/0/1";
+    res.pathlen = 5;
+    res.publish_uri = 1;
+    res.resource_parameters_ptr = &own_params;
+
+    // Path already in the store
+    retCounter = 3;
+    sn_grs_create_resource(handle, &res);
+    if( SN_GRS_RESOURCE_ALREADY_EXISTS != sn_grs_set_resource_template(handle, templ, 3) ){
+        return false;
+    }
+    sn_grs_delete_resource(handle, 5, res.path);
+
+    // Template paths are not converted
+    templ[2].path = bad_path;
+    templ[2].pathlen = 2;
+    if( SN_GRS_INVALID_PATH != sn_grs_set_resource_template(handle, templ, 3) ){
+        return false;
+    }
+    templ[2].path = (uint8_t *)"1/0/1";
+    templ[2].pathlen = 5;
+
+    retCounter = 0;
+    if( SN_NSDL_FAILURE != sn_grs_set_resource_template(handle, templ, 3) ){
+        return false;
+    }
+    retCounter = 1;
+    if( SN_NSDL_SUCCESS != sn_grs_set_resource_template(handle, templ, 3) ){
+        return false;
+    }
+    if( SN_NSDL_FAILURE != sn_grs_set_resource_template(handle, templ, 3) ){
+        return false;
+    }
+
+    // Template resources are found in place, after own resources
+    if( sn_grs_search_resource(handle, 6, (uint8_t *)"/3/0/1", SN_GRS_SEARCH_METHOD) != &templ[1] ||
+        sn_grs_search_resource(handle, 3, (uint8_t *)"3/0", SN_GRS_DELETE_METHOD) != &templ[0] ){
+        return false;
+    }
+    res.path = (uint8_t *)"5/0/0";
+    retCounter = 3;
+    if( SN_NSDL_SUCCESS != sn_grs_create_resource(handle, &res) ){
+        return false;
+    }
+    const sn_nsdl_resource_info_s *iter = sn_grs_get_first_resource(handle);
+    if( !iter || iter->pathlen != 5 || memcmp(iter->path, "5/0/0", 5) ){
+        return false;
+    }
+    iter = sn_grs_get_next_resource(handle, iter);
+    if( iter != &templ[0] || sn_grs_get_next_resource(handle, iter) != &templ[1] ||
+        sn_grs_get_next_resource(handle, &templ[1]) != &templ[2] || sn_grs_get_next_resource(handle, &templ[2]) ){
+        return false;
+    }
+
+    retCounter = 9;
+    sn_grs_resource_list_s *list = sn_grs_list_resource(handle, 0, res.path);
+    if( !list || list->res_count != 4 || list->res[3].pathlen != 5 || memcmp(list->res[3].path, "1/0/1", 5) ){
+        return false;
+    }
+    sn_grs_free_resource_list(handle, list);
+
+    // Registration state is kept in the store, not in the template
+    sn_grs_set_registration_state(handle, &templ[0], 0, SN_NDSL_RESOURCE_REGISTERED);
+    sn_grs_set_registration_state(handle, &templ[0], 3, SN_NDSL_RESOURCE_REGISTERING);
+    if( SN_NDSL_RESOURCE_REGISTERED != sn_grs_get_registration_state(handle, &templ[0], 0) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, &templ[0], 1) ||
+        SN_NDSL_RESOURCE_REGISTERING != sn_grs_get_registration_state(handle, &templ[0], 3) ||
+        SN_NDSL_RESOURCE_NOT_REGISTERED != sn_grs_get_registration_state(handle, &templ[1], 0) ||
+        params.registered != 0 ){
+        return false;
+    }
+
+    // Writing a value copies the resource, strings stay shared
+    uint8_t new_value[] = {'m', 'b', 'e', 'd'};
+    sn_nsdl_resource_info_s update;
+    memset(&update, 0, sizeof(sn_nsdl_resource_info_s));
+    update.path = (uint8_t *)"3/0/0";
+    update.pathlen = 5;
+    update.resource = new_value;
+    update.resourcelen = sizeof(new_value);
+    update.access = SN_GRS_GET_ALLOWED;
+
+    retCounter = 1;
+    if( SN_NSDL_FAILURE != sn_grs_update_resource(handle, &update) ||
+        sn_grs_search_resource(handle, 5, update.path, SN_GRS_SEARCH_METHOD) != &templ[0] ){
+        return false;
+    }
+    retCounter = 4;
+    if( SN_NSDL_SUCCESS != sn_grs_update_resource(handle, &update) ){
+        return false;
+    }
+    const sn_nsdl_resource_info_s *copy = sn_grs_search_resource(handle, 5, update.path, SN_GRS_SEARCH_METHOD);
+    if( !copy || copy == &templ[0] || !copy->from_template || copy->path != templ[0].path ||
+        copy->resource_parameters_ptr->resource_type_ptr != rt || copy->resourcelen != sizeof(new_value) ||
+        memcmp(copy->resource, new_value, sizeof(new_value)) ||
+        SN_NDSL_RESOURCE_REGISTERED != sn_grs_get_registration_state(handle, copy, 0) ||
+        SN_NDSL_RESOURCE_REGISTERING != sn_grs_get_registration_state(handle, copy, 3) ){
+        return false;
+    }
+    int count = 0;
+    for (iter = sn_grs_get_first_resource(handle); iter; iter = sn_grs_get_next_resource(handle, iter)) {
+        count++;
+    }
+    if( count != 4 ){
+        return false;
+    }
+
+    // Deleting hides the template resource, and reports it when registered
+    sn_grs_set_removed_resource_tracking(handle, true);
+    sn_grs_set_registration_state(handle, &templ[1], 0, SN_NDSL_RESOURCE_REGISTERED);
+    retCounter = 2;
+    if( SN_NSDL_SUCCESS != sn_grs_delete_resource(handle, 5, (uint8_t *)"3/0/1") ||
+        sn_grs_search_resource(handle, 5, (uint8_t *)"3/0/1", SN_GRS_SEARCH_METHOD) ||
+        !sn_grs_get_first_removed_resource(handle) ){
+        return false;
+    }
+    sn_grs_set_removed_resource_tracking(handle, false);
+
+    // Deleted path can be created again as an own resource
+    res.path = (uint8_t *)"3/0/1";
+    retCounter = 3;
+    if( SN_NSDL_SUCCESS != sn_grs_create_resource(handle, &res) ){
+        return false;
+    }
+
+    // Template is untouched
+    if( memcmp(saved, templ, sizeof(templ)) || params.registered != 0 || memcmp(value, "ARM", 3) ){
+        return false;
+    }
+
+    sn_grs_destroy(handle);
+    return true;
+}
+
+/* Template and its value are in read-only memory, any write through a lookup result crashes */
+static const sn_nsdl_resource_info_s const_templ[2] = {
+    {.mode = SN_GRS_STATIC, .access = SN_GRS_GET_ALLOWED | SN_GRS_PUT_ALLOWED, .pathlen = 5, .resourcelen = 3,
+     .path = (uint8_t *)"3/0/0", .resource = (uint8_t *)"ARM"},
+    {.mode = SN_GRS_STATIC, .access = SN_GRS_GET_ALLOWED, .pathlen = 5, .path = (uint8_t *)"3/0/1"}
+};
+
+bool test_sn_grs_make_writable()
+{
+    sn_coap_protocol_stub.expectedCoap = (struct coap_s*)malloc(sizeof(struct coap_s));
+    memset(sn_coap_protocol_stub.expectedCoap, 0, sizeof(struct coap_s));
+
+    struct nsdl_s* handle = (struct nsdl_s*)malloc(sizeof(struct nsdl_s));
+    memset(handle, 0, sizeof(struct nsdl_s));
+    retCounter = 1;
+    handle->grs = sn_grs_init(&myTxCallback, &myRxCallback, &myMalloc, &myFree);
+
+    if( sn_grs_make_writable(NULL, &const_templ[0]) || sn_grs_make_writable(handle->grs, NULL) ){
+        return false;
+    }
+
+    // Own resource is returned as it is, unknown one not at all
+    sn_nsdl_resource_info_s res;
+    memset(&res, 0, sizeof(sn_nsdl_resource_info_s));
+    res.path = (uint8_t *)"5/0/0";
+    res.pathlen = 5;
+    retCounter = 2;
+    if( SN_NSDL_SUCCESS != sn_grs_create_resource(handle->grs, &res) ){
+        return false;
+    }
+    const sn_nsdl_resource_info_s *own = sn_grs_search_resource(handle->grs, 5, res.path, SN_GRS_SEARCH_METHOD);
+    retCounter = 0;
+    if( !own || sn_grs_make_writable(handle->grs, own) != own || sn_grs_make_writable(handle->grs, &res) ){
+        return false;
+    }
+
+    retCounter = 1;
+    if( SN_NSDL_SUCCESS != sn_grs_set_resource_template(handle->grs, const_templ, 2) ){
+        return false;
+    }
+
+    // Out of memory, template stays in use
+    retCounter = 0;
+    if( sn_grs_make_writable(handle->grs, &const_templ[1]) ||
+        sn_grs_search_resource(handle->grs, 5, (uint8_t *)"3/0/1", SN_GRS_SEARCH_METHOD) != &const_templ[1] ){
+        return false;
+    }
+    retCounter = 1;
+    sn_nsdl_resource_info_s *copy = sn_grs_make_writable(handle->grs, &const_templ[1]);
+    if( !copy || copy == &const_templ[1] || !copy->from_template ||
+        sn_grs_search_resource(handle->grs, 5, (uint8_t *)"3/0/1", SN_GRS_SEARCH_METHOD) != copy ){
+        return false;
+    }
+
+    // PUT writes to a copy of the template resource
+    sn_coap_hdr_s *hdr = (sn_coap_hdr_s*)malloc(sizeof(sn_coap_hdr_s));
+    memset(hdr, 0, sizeof(sn_coap_hdr_s));
+    hdr->msg_code = COAP_MSG_CODE_REQUEST_PUT;
+    hdr->msg_type = COAP_MSG_TYPE_RESET;
+    hdr->uri_path_ptr = (uint8_t*)malloc(5);
+    memcpy(hdr->uri_path_ptr, "3/0/0", 5);
+    hdr->uri_path_len = 5;
+    hdr->payload_ptr = (uint8_t *)"mbed";
+    hdr->payload_len = 4;
+    sn_nsdl_addr_s addr;
+    memset(&addr, 0, sizeof(sn_nsdl_addr_s));
+    retCounter = 3;
+    if( SN_NSDL_SUCCESS != sn_grs_process_coap(handle, hdr, &addr) ){
+        return false;
+    }
+    const sn_nsdl_resource_info_s *put = sn_grs_search_resource(handle->grs, 5, (uint8_t *)"3/0/0", SN_GRS_SEARCH_METHOD);
+    if( !put || put == &const_templ[0] || put->resourcelen != 4 || memcmp(put->resource, "mbed", 4) ||
+        const_templ[0].resourcelen != 3 || memcmp(const_templ[0].resource, "ARM", 3) ){
+        return false;
+    }
+
+    free(sn_coap_protocol_stub.expectedCoap);
+    sn_coap_protocol_stub.expectedCoap = NULL;
+    sn_grs_destroy(handle->grs);
+    free(handle);
+    return true;
+}
+
+static int static_calls;
+static int store_calls;
+
+static uint8_t myStaticCallback(struct nsdl_s *a, sn_coap_hdr_s *b, sn_nsdl_addr_s *c, sn_nsdl_capab_e d)
+{
+    static_calls++;
+    return 0;
+}
+
+static uint8_t myStoreCallback(struct nsdl_s *a, sn_coap_hdr_s *b, sn_nsdl_addr_s *c, sn_nsdl_capab_e d)
+{
+    store_calls++;
+    return 0;
+}
+
+static const sn_nsdl_static_handler_s static_handler = {SN_GRS_GET_ALLOWED, &myStaticCallback};
+
+static const sn_nsdl_static_handler_s *myStaticLookup(const uint8_t *path, uint16_t len)
+{
+    if (len == 5 && !memcmp(path, "3/0/1", 5)) {
+        return &static_handler;
+    }
+    return NULL;
+}
+
+static sn_coap_hdr_s *static_dispatch_request(sn_coap_msg_code_e code)
+{
+    sn_coap_hdr_s *hdr = (sn_coap_hdr_s*)malloc(sizeof(sn_coap_hdr_s));
+    memset(hdr, 0, sizeof(sn_coap_hdr_s));
+    hdr->msg_code = code;
+    hdr->msg_type = COAP_MSG_TYPE_RESET;
+    hdr->uri_path_ptr = (uint8_t*)malloc(5);
+    memcpy(hdr->uri_path_ptr, "3/0/1", 5);
+    hdr->uri_path_len = 5;
+    return hdr;
+}
+
+bool test_sn_grs_static_dispatch()
+{
+    if( SN_NSDL_FAILURE != sn_grs_set_static_dispatch(NULL, &myStaticLookup) ){
+        return false;
+    }
+
+    sn_coap_protocol_stub.expectedCoap = (struct coap_s*)malloc(sizeof(struct coap_s));
+    memset(sn_coap_protocol_stub.expectedCoap, 0, sizeof(struct coap_s));
+
+    struct nsdl_s* handle = (struct nsdl_s*)malloc(sizeof(struct nsdl_s));
+    memset(handle, 0, sizeof(struct nsdl_s));
+    retCounter = 1;
+    handle->grs = sn_grs_init(&myTxCallback, &myRxCallback, &myMalloc, &myFree);
+
+    sn_nsdl_addr_s addr;
+    memset(&addr, 0, sizeof(sn_nsdl_addr_s));
+
+    // Same path in the store
+    sn_nsdl_resource_info_s res;
+    memset(&res, 0, sizeof(sn_nsdl_resource_info_s));
+    res.path = (uint8_t *)"3/0/1";
+    res.pathlen = 5;
+    res.mode = SN_GRS_DYNAMIC;
+    res.access = SN_GRS_GET_ALLOWED | SN_GRS_PUT_ALLOWED;
+    res.sn_grs_dyn_res_callback = &myStoreCallback;
+    retCounter = 2;
+    if( SN_NSDL_SUCCESS != sn_grs_create_resource(handle->grs, &res) ){
+        return false;
+    }
+
+    static_calls = 0;
+    store_calls = 0;
+    if( SN_NSDL_SUCCESS != sn_grs_set_static_dispatch(handle->grs, &myStaticLookup) ){
+        return false;
+    }
+
+    // Lookup goes before the store
+    if( SN_NSDL_SUCCESS != sn_grs_process_coap(handle, static_dispatch_request(COAP_MSG_CODE_REQUEST_GET), &addr) ||
+        static_calls != 1 || store_calls != 0 ){
+        return false;
+    }
+
+    // Access of the handler is checked, store is not tried
+    if( SN_NSDL_SUCCESS != sn_grs_process_coap(handle, static_dispatch_request(COAP_MSG_CODE_REQUEST_PUT), &addr) ||
+        static_calls != 1 || store_calls != 0 ){
+        return false;
+    }
+
+    // Without lookup the store is used again
+    sn_grs_set_static_dispatch(handle->grs, NULL);
+    if( SN_NSDL_SUCCESS != sn_grs_process_coap(handle, static_dispatch_request(COAP_MSG_CODE_REQUEST_PUT), &addr) ||
+        static_calls != 1 || store_calls != 1 ){
+        return false;
+    }
+
+    free(sn_coap_protocol_stub.expectedCoap);
+    sn_coap_protocol_stub.expectedCoap = NULL;
+    sn_grs_destroy(handle->grs);
+    free(handle);
+    return true;
+}
@@ -25,6 +25,15 @@ bool test_sn_grs_put_resource();
 bool test_sn_grs_delete_resource();
 bool test_sn_grs_mark_resources_as_registered();
 
+bool test_sn_grs_removed_resource_tracking();
+
+bool test_sn_grs_session_slots();
+
+bool test_sn_grs_resource_template();
+bool test_sn_grs_make_writable();
+
+bool test_sn_grs_static_dispatch();
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,6 +65,11 @@ TEST(sn_nsdl, test_sn_nsdl_send_observation_notification_with_uri_path)
     CHECK(test_sn_nsdl_send_observation_notification_with_uri_path());
 }
 
+TEST(sn_nsdl, test_sn_nsdl_send_observation_notification_to_observers)
+{
+    CHECK(test_sn_nsdl_send_observation_notification_to_observers());
+}
+
 TEST(sn_nsdl, test_sn_nsdl_oma_bootstrap)
 {
     CHECK(test_sn_nsdl_oma_bootstrap());
@@ -186,5 +191,33 @@ TEST(sn_nsdl, test_sn_nsdl_set_duplicate_buffer_size)
     CHECK(test_sn_nsdl_set_duplicate_buffer_size());
 }
 
+TEST(sn_nsdl, test_sn_nsdl_set_registration_streaming)
+{
+    CHECK(test_sn_nsdl_set_registration_streaming());
+}
+
+TEST(sn_nsdl, test_sn_nsdl_register_streamed)
+{
+    CHECK(test_sn_nsdl_register_streamed());
+}
 
+TEST(sn_nsdl, test_sn_nsdl_set_delta_update)
+{
+    CHECK(test_sn_nsdl_set_delta_update());
+}
+
+TEST(sn_nsdl, test_sn_nsdl_set_update_interval)
+{
+    CHECK(test_sn_nsdl_set_update_interval());
+}
+
+TEST(sn_nsdl, test_sn_nsdl_init_session)
+{
+    CHECK(test_sn_nsdl_init_session());
+}
+
+TEST(sn_nsdl, test_sn_nsdl_set_sleeping)
+{
+    CHECK(test_sn_nsdl_set_sleeping());
+}
 
@@ -44,6 +44,14 @@ uint8_t nsdl_tx_callback(struct nsdl_s *a, sn_nsdl_capab_e b, uint8_t *c, uint16
 
 }
 
+int txCount = 0;
+
+uint8_t nsdl_tx_count_callback(struct nsdl_s *a, sn_nsdl_capab_e b, uint8_t *c, uint16_t d, sn_nsdl_addr_s *e)
+{
+    txCount++;
+    return 1;
+}
+
 uint8_t nsdl_rx_callback(struct nsdl_s *a, sn_coap_hdr_s *b, sn_nsdl_addr_s *c)
 {
     return rxRetVal;
@@ -59,6 +67,8 @@ bool test_sn_nsdl_destroy()
     handle->sn_nsdl_alloc = myMalloc;
     handle->sn_nsdl_free = myFree;
     handle->oma_bs_address_ptr = (uint8_t*)malloc(5);
+    handle->register_uri_query_ptr = (uint8_t*)malloc(5);
+    handle->update_uri_query_ptr = (uint8_t*)malloc(5);
 
     handle->ep_information_ptr = (sn_nsdl_ep_parameters_s *)malloc(sizeof(sn_nsdl_ep_parameters_s));
     memset(handle->ep_information_ptr,0,sizeof(sn_nsdl_ep_parameters_s));
@@ -72,7 +82,9 @@ bool test_sn_nsdl_destroy()
     handle->nsp_address_ptr->omalw_address_ptr = (sn_nsdl_addr_s*)malloc(sizeof(sn_nsdl_addr_s));
     handle->nsp_address_ptr->omalw_address_ptr->addr_ptr = (uint8_t*)malloc(5);
 
+    ns_list_init(&handle->queued_notification_list);
     handle->grs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    handle->grs->session_count = 1;
 
     int8_t ret = sn_nsdl_destroy(handle);
     return ret == SN_NSDL_SUCCESS;
@@ -1106,6 +1118,85 @@ bool test_sn_nsdl_send_observation_notification_with_uri_path()
     return true;
 }
 
+bool test_sn_nsdl_send_observation_notification_to_observers()
+{
+    uint8_t token1[2] = {0x01, 0x02};
+    uint8_t token2[2] = {0x03, 0x04};
+    uint8_t payload[2] = {'2', '2'};
+
+    if( 0 != sn_nsdl_send_observation_notification_to_observers(NULL, 0, NULL, 0, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0, NULL, 0) ){
+        return false;
+    }
+    sn_grs_stub.retNull = false;
+    sn_grs_stub.expectedInt8 = SN_NSDL_SUCCESS;
+    retCounter = 4;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    struct nsdl_s* handle = sn_nsdl_init(&nsdl_tx_count_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+    handle->grs->session_count = 1;
+    handle->grs->session_slots = SN_GRS_SESSION_BIT(0);
+    sn_grs_stub.expectedGrs->coap = (struct coap_s *)malloc(sizeof(struct coap_s));
+    memset(sn_grs_stub.expectedGrs->coap, 0, sizeof(struct coap_s));
+    sn_grs_stub.expectedGrs->coap->sn_coap_protocol_free = myFree;
+    sn_grs_stub.expectedGrs->coap->sn_coap_protocol_malloc = myMalloc;
+    retCounter = 4;
+    struct nsdl_s* session = sn_nsdl_init_session(handle);
+
+    sn_nsdl_observer_s observers[2];
+    memset(observers, 0, sizeof(observers));
+    observers[0].handle = handle;
+    observers[0].token_ptr = token1;
+    observers[0].token_len = 2;
+    observers[0].msg_id = 5;
+    observers[1].handle = session;
+    observers[1].token_ptr = token2;
+    observers[1].token_len = 2;
+
+    // Sessions must share the resources
+    struct grs_s other_grs;
+    session->grs = &other_grs;
+    if( 0 != sn_nsdl_send_observation_notification_to_observers(observers, 2, payload, 2, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0, NULL, 0) ||
+        observers[0].msg_id != 0 ){
+        return false;
+    }
+    session->grs = handle->grs;
+
+    retCounter = 0;
+    if( 0 != sn_nsdl_send_observation_notification_to_observers(observers, 2, payload, 2, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0, NULL, 0) ){
+        return false;
+    }
+
+    // Packet is encoded once and copied for the second server
+    retCounter = 3;
+    txCount = 0;
+    sn_coap_builder_stub.expectedUint16 = 10;
+    sn_coap_protocol_stub.expectedInt16 = 10;
+    sn_nsdl_send_observation_notification_to_observers(observers, 2, payload, 2, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0, NULL, 0);
+    if( txCount != 2 ){
+        return false;
+    }
+
+    // Sleeping sessions hold the notification back
+    handle->sleeping = true;
+    session->sleeping = true;
+    retCounter = 8;
+    sn_coap_protocol_stub.expectedUint16 = 7;
+    if( 2 != sn_nsdl_send_observation_notification_to_observers(observers, 2, payload, 2, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0, NULL, 0) ||
+        observers[0].msg_id != 7 || observers[1].msg_id != 7 ||
+        handle->queued_notification_count != 1 || session->queued_notification_count != 1 ){
+        return false;
+    }
+
+    sn_coap_builder_stub.expectedUint16 = 0;
+    sn_coap_protocol_stub.expectedInt16 = 0;
+    sn_nsdl_destroy(session);
+    handle->grs->session_slots = SN_GRS_SESSION_BIT(0);
+    handle->grs->session_count = 1;
+    free(sn_grs_stub.expectedGrs->coap);
+    sn_nsdl_destroy(handle);
+    return true;
+}
+
 bool test_sn_nsdl_oma_bootstrap()
 {
     if( 0 != sn_nsdl_oma_bootstrap(NULL, NULL, NULL, NULL)){
@@ -2881,6 +2972,7 @@ bool test_sn_nsdl_release_allocated_coap_msg_mem()
     struct nsdl_s* handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
 
     sn_coap_hdr_s* list = (sn_coap_hdr_s*)malloc(sizeof(sn_coap_hdr_s));
+    memset(list, 0, sizeof(sn_coap_hdr_s));
 
     sn_nsdl_release_allocated_coap_msg_mem(handle, list); //mem leak or pass
 
@@ -2963,3 +3055,413 @@ bool test_sn_nsdl_set_duplicate_buffer_size()
     sn_nsdl_destroy(handle);
     return true;
 }
+
+bool test_sn_nsdl_set_registration_streaming()
+{
+    struct nsdl_s* handle = NULL;
+    if (sn_nsdl_set_registration_streaming(handle, true) == 0){
+        return false;
+    }
+    retCounter = 4;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+
+    if (sn_nsdl_set_registration_streaming(handle, true) != 0 || !handle->registration_streaming){
+        return false;
+    }
+    if (sn_nsdl_set_registration_streaming(handle, false) != 0 || handle->registration_streaming){
+        return false;
+    }
+    sn_nsdl_destroy(handle);
+    return true;
+}
+
+extern int8_t sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *message_ptr, uint8_t updating_registeration);
+
+bool test_sn_nsdl_register_streamed()
+{
+    static const char *paths[] = {"3303/0/5700", "3303/0/5701", "3/0/0", "3/0/13"};
+    sn_nsdl_resource_parameters_s params[4];
+    sn_nsdl_resource_info_s resources[4];
+    sn_nsdl_ep_parameters_s eptr;
+    sn_coap_hdr_s buffered;
+    uint8_t streamed[256];
+    bool ret = true;
+    int i;
+
+    memset(params, 0, sizeof(params));
+    memset(resources, 0, sizeof(resources));
+    for (i = 0; i < 4; i++) {
+        resources[i].path = (uint8_t*)paths[i];
+        resources[i].pathlen = strlen(paths[i]);
+        resources[i].publish_uri = 1;
+        resources[i].resource_parameters_ptr = &params[i];
+    }
+    params[0].resource_type_ptr = (uint8_t*)"temperature";
+    params[0].resource_type_len = 11;
+    params[0].observable = 1;
+    params[1].interface_description_ptr = (uint8_t*)"sensor";
+    params[1].interface_description_len = 6;
+    params[2].coap_content_type = 50;
+    params[3].resource_type_ptr = (uint8_t*)"t";
+    params[3].resource_type_len = 1;
+
+    retCounter = 100;
+    sn_grs_stub.retNull = false;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    struct nsdl_s* handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+    struct coap_s *coap = (struct coap_s *)malloc(sizeof(struct coap_s));
+    memset(coap, 0, sizeof(struct coap_s));
+    coap->sn_coap_protocol_free = myFree;
+    coap->sn_coap_protocol_malloc = myMalloc;
+    coap->sn_coap_block_data_size = 16;
+    sn_grs_stub.expectedGrs->coap = coap;
+
+    sn_grs_stub.resourceList = resources;
+    sn_grs_stub.resourceCount = 4;
+    sn_coap_protocol_stub.expectedInt8 = 0;
+    sn_coap_protocol_stub.expectedInt16 = 0;
+    sn_coap_protocol_stub.streamedPayload = streamed;
+    sn_coap_builder_stub.expectedUint16 = 64;
+
+    memset(&eptr, 0, sizeof(eptr));
+    eptr.endpoint_name_ptr = (uint8_t*)"ep";
+    eptr.endpoint_name_len = 2;
+    eptr.ds_register_mode = REGISTER_WITH_RESOURCES;
+
+    memset(streamed, 0, sizeof(streamed));
+    sn_nsdl_set_registration_streaming(handle, true);
+    sn_nsdl_register_endpoint(handle, &eptr);
+
+    /* Every block is pulled separately, links cross block borders */
+    memset(&buffered, 0, sizeof(buffered));
+    if (sn_nsdl_build_registration_body(handle, &buffered, 0) != 0 || !buffered.payload_ptr) {
+        ret = false;
+    } else if (buffered.payload_len != sn_coap_protocol_stub.streamedPayloadLen ||
+               memcmp(buffered.payload_ptr, streamed, buffered.payload_len) != 0) {
+        ret = false;
+    }
+
+    /* Payload is a multiple of block size, there is no empty last block to wait for */
+    if (ret && (buffered.payload_len % 16 != 0 ||
+                sn_coap_protocol_stub.streamedBlockCount != buffered.payload_len / 16 ||
+                handle->register_msg_len / 16 != sn_coap_protocol_stub.streamedBlockCount - 1)) {
+        ret = false;
+    }
+    free(buffered.payload_ptr);
+
+    sn_grs_stub.resourceList = NULL;
+    sn_grs_stub.resourceCount = 0;
+    sn_coap_protocol_stub.streamedPayload = NULL;
+    sn_nsdl_destroy(handle);
+    free(coap);
+    return ret;
+}
+
+bool test_sn_nsdl_set_delta_update()
+{
+    struct nsdl_s* handle = NULL;
+    if (sn_nsdl_set_delta_update(handle, true) == 0){
+        return false;
+    }
+    retCounter = 4;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+
+    if (sn_nsdl_set_delta_update(handle, true) != 0){
+        return false;
+    }
+    sn_nsdl_destroy(handle);
+    return true;
+}
+
+
+bool test_sn_nsdl_set_update_interval()
+{
+    uint32_t deadline = 0;
+    struct nsdl_s* handle = NULL;
+    if (sn_nsdl_set_update_interval(handle, 50) == 0){
+        return false;
+    }
+    if (sn_nsdl_get_next_deadline(handle, &deadline) == 0){
+        return false;
+    }
+    retCounter = 4;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+    sn_grs_stub.expectedGrs->coap = (struct coap_s *)malloc(sizeof(struct coap_s));
+    memset(sn_grs_stub.expectedGrs->coap, 0, sizeof(struct coap_s));
+    sn_grs_stub.expectedGrs->coap->system_time = 1000;
+    sn_coap_protocol_stub.expectedInt8 = -1;
+
+    if (sn_nsdl_set_update_interval(handle, 101) == 0){
+        return false;
+    }
+
+    // Not registered, nothing to wait for
+    if (sn_nsdl_set_update_interval(handle, 50) != 0){
+        return false;
+    }
+    if (sn_nsdl_get_next_deadline(handle, &deadline) == 0){
+        return false;
+    }
+
+    // Update is due at half of lifetime, advanced by at most 10% jitter
+    handle->sn_nsdl_endpoint_registered = SN_NSDL_ENDPOINT_IS_REGISTERED;
+    handle->lifetime = 100;
+    if (sn_nsdl_set_update_interval(handle, 50) != 0){
+        return false;
+    }
+    if (sn_nsdl_get_next_deadline(handle, NULL) == 0){
+        return false;
+    }
+    if (sn_nsdl_get_next_deadline(handle, &deadline) != 0){
+        return false;
+    }
+    if (deadline < 1045 || deadline > 1050){
+        return false;
+    }
+
+    // Nothing is sent before the deadline
+    sn_coap_protocol_stub.expectedInt8 = 0;
+    if (sn_nsdl_exec(handle, deadline - 1) != 0){
+        return false;
+    }
+    sn_coap_protocol_stub.expectedInt8 = -1;
+    uint32_t next = 0;
+    if (sn_nsdl_get_next_deadline(handle, &next) != 0 || next != deadline){
+        return false;
+    }
+
+    // Update that can not be sent is retried, not before CoAP would have given up resending it
+    sn_grs_stub.expectedGrs->coap->sn_coap_protocol_free = myFree;
+    sn_grs_stub.expectedGrs->coap->sn_coap_protocol_malloc = myMalloc;
+    sn_grs_stub.expectedGrs->coap->sn_coap_resending_intervall = 10;
+    sn_grs_stub.expectedGrs->coap->sn_coap_resending_count = 3;
+    retCounter = 0;
+    sn_coap_protocol_stub.expectedInt8 = 0;
+    if (sn_nsdl_exec(handle, deadline) != 0){
+        return false;
+    }
+    sn_coap_protocol_stub.expectedInt8 = -1;
+    if (sn_nsdl_get_next_deadline(handle, &next) != 0 || next != deadline + 150){
+        return false;
+    }
+
+    // Interval of whole lifetime leaves no margin, retry still waits for CoAP
+    if (sn_nsdl_set_update_interval(handle, 100) != 0){
+        return false;
+    }
+    if (sn_nsdl_get_next_deadline(handle, &deadline) != 0){
+        return false;
+    }
+    sn_coap_protocol_stub.expectedInt8 = 0;
+    if (sn_nsdl_exec(handle, deadline) != 0){
+        return false;
+    }
+    sn_coap_protocol_stub.expectedInt8 = -1;
+    if (sn_nsdl_get_next_deadline(handle, &next) != 0 || next != deadline + 150){
+        return false;
+    }
+
+    if (sn_nsdl_set_update_interval(handle, 0) != 0){
+        return false;
+    }
+    if (sn_nsdl_get_next_deadline(handle, &deadline) == 0){
+        return false;
+    }
+
+    free(sn_grs_stub.expectedGrs->coap);
+    sn_nsdl_destroy(handle);
+    return true;
+}
+
+bool test_sn_nsdl_init_session()
+{
+    if (NULL != sn_nsdl_init_session(NULL)){
+        return false;
+    }
+    retCounter = 4;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    struct nsdl_s* handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+    handle->grs->session_count = 1;
+    handle->grs->session_slots = SN_GRS_SESSION_BIT(0);
+
+    retCounter = 0;
+    if (NULL != sn_nsdl_init_session(handle)){
+        return false;
+    }
+    retCounter = 1;
+    if (NULL != sn_nsdl_init_session(handle)){
+        return false;
+    }
+
+    // Every session slot in use
+    handle->grs->session_slots = 0x0F;
+    retCounter = 4;
+    if (NULL != sn_nsdl_init_session(handle)){
+        return false;
+    }
+    handle->grs->session_slots = SN_GRS_SESSION_BIT(0) | SN_GRS_SESSION_BIT(2);
+    handle->grs->session_count = 2;
+
+    retCounter = 4;
+    struct nsdl_s* session = sn_nsdl_init_session(handle);
+    if (NULL == session || session->grs != handle->grs || session->nsp_address_ptr == NULL){
+        return false;
+    }
+    // Lowest free slot is taken
+    if (handle->session_slot != 0 || session->session_slot != 1 ||
+        handle->grs->session_count != 3 || handle->grs->session_slots != 0x07){
+        return false;
+    }
+
+    // Resources stay while other sessions use them
+    if (sn_nsdl_destroy(session) != SN_NSDL_SUCCESS){
+        return false;
+    }
+    if (handle->grs->session_count != 2 || handle->grs->session_slots != 0x05){
+        return false;
+    }
+    handle->grs->session_slots = SN_GRS_SESSION_BIT(0);
+    handle->grs->session_count = 1;
+
+    sn_nsdl_destroy(handle);
+    return true;
+}
+
+bool test_sn_nsdl_set_sleeping()
+{
+    uint8_t token[2] = {0x01, 0x02};
+    uint8_t payload[2] = {'2', '2'};
+
+    if (sn_nsdl_set_sleeping(NULL, true) == 0){
+        return false;
+    }
+    if (sn_nsdl_set_notification_coalescing(NULL, true) == 0){
+        return false;
+    }
+    sn_grs_stub.retNull = false;
+    retCounter = 4;
+    sn_grs_stub.expectedGrs = (struct grs_s *)malloc(sizeof(struct grs_s));
+    memset(sn_grs_stub.expectedGrs,0, sizeof(struct grs_s));
+    struct nsdl_s* handle = sn_nsdl_init(&nsdl_tx_callback, &nsdl_rx_callback, &myMalloc, &myFree);
+    sn_grs_stub.expectedGrs->coap = (struct coap_s *)malloc(sizeof(struct coap_s));
+    sn_grs_stub.expectedGrs->coap->sn_coap_protocol_free = myFree;
+    sn_grs_stub.expectedGrs->coap->sn_coap_protocol_malloc = myMalloc;
+
+    // Only queue mode endpoint can sleep
+    handle->ep_information_ptr->binding_and_mode = BINDING_MODE_U;
+    if (sn_nsdl_set_sleeping(handle, true) == 0){
+        return false;
+    }
+    handle->ep_information_ptr->binding_and_mode = (sn_nsdl_oma_binding_and_mode_t)(BINDING_MODE_U | BINDING_MODE_Q);
+    if (sn_nsdl_set_sleeping(handle, true) != 0){
+        return false;
+    }
+
+    // Allocation failure
+    retCounter = 2;
+    if (0 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+
+    retCounter = 3;
+    sn_coap_protocol_stub.expectedUint16 = 7;
+    if (7 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+    retCounter = 3;
+    sn_coap_protocol_stub.expectedUint16 = 8;
+    if (8 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 1, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+    if (handle->queued_notification_count != 2){
+        return false;
+    }
+
+    // Latest value replaces the first queued one
+    if (sn_nsdl_set_notification_coalescing(handle, true) != 0){
+        return false;
+    }
+    retCounter = 1;
+    sn_coap_protocol_stub.expectedUint16 = 9;
+    if (7 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 2, 2, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+    sn_nsdl_queued_notification_s *queued_ptr = ns_list_get_first(&handle->queued_notification_list);
+    if (handle->queued_notification_count != 2 || queued_ptr->payload_len != 2 || queued_ptr->observe != 2){
+        return false;
+    }
+
+    // Full queue refuses new notification, message IDs of queued ones stay valid
+    if (sn_nsdl_set_notification_coalescing(handle, false) != 0){
+        return false;
+    }
+    while (handle->queued_notification_count < 8){ // Default SN_NSDL_MAX_QUEUED_NOTIFICATIONS
+        retCounter = 3;
+        sn_coap_protocol_stub.expectedUint16 = 10;
+        if (10 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 3, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+            return false;
+        }
+    }
+    retCounter = 3;
+    sn_coap_protocol_stub.expectedUint16 = 11;
+    if (0 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 4, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+    queued_ptr = ns_list_get_first(&handle->queued_notification_list);
+    if (handle->queued_notification_count != 8 || queued_ptr->msg_id != 7){
+        return false;
+    }
+
+    // Coalesced notification does not need room
+    if (sn_nsdl_set_notification_coalescing(handle, true) != 0){
+        return false;
+    }
+    retCounter = 1;
+    if (7 != sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 5, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+
+    // Send failure keeps notifications
+    retCounter = 4;
+    sn_grs_stub.expectedInt8 = SN_NSDL_FAILURE;
+    if (sn_nsdl_set_sleeping(handle, false) == 0 || handle->queued_notification_count != 8){
+        return false;
+    }
+
+    handle->sleeping = true;
+    retCounter = 32;
+    sn_grs_stub.expectedInt8 = SN_NSDL_SUCCESS;
+    if (sn_nsdl_set_sleeping(handle, false) != 0 || handle->queued_notification_count != 0){
+        return false;
+    }
+
+    // Dropped when server is lost
+    if (sn_nsdl_set_sleeping(handle, true) != 0){
+        return false;
+    }
+    retCounter = 3;
+    if (0 == sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+    sn_nsdl_nsp_lost(handle);
+    if (handle->queued_notification_count != 0){
+        return false;
+    }
+
+    retCounter = 3;
+    if (0 == sn_nsdl_send_observation_notification(handle, token, 2, payload, 1, 0, COAP_MSG_TYPE_NON_CONFIRMABLE, 0)){
+        return false;
+    }
+    sn_coap_protocol_stub.expectedUint16 = 0;
+    free(sn_grs_stub.expectedGrs->coap);
+    sn_nsdl_destroy(handle);
+    return true;
+}
@@ -30,6 +30,8 @@ bool test_sn_nsdl_send_observation_notification();
 
 bool test_sn_nsdl_send_observation_notification_with_uri_path();
 
+bool test_sn_nsdl_send_observation_notification_to_observers();
+
 bool test_sn_nsdl_oma_bootstrap();
 
 bool test_sn_nsdl_get_certificates();
@@ -78,6 +80,18 @@ bool test_sn_nsdl_set_block_size();
 
 bool test_sn_nsdl_set_duplicate_buffer_size();
 
+bool test_sn_nsdl_set_registration_streaming();
+
+bool test_sn_nsdl_register_streamed();
+
+bool test_sn_nsdl_set_delta_update();
+
+bool test_sn_nsdl_set_update_interval();
+
+bool test_sn_nsdl_init_session();
+
+bool test_sn_nsdl_set_sleeping();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_registration.h"
+
+TEST_GROUP(sn_registration)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_registration, test_sn_registration_update_removed_links)
+{
+    CHECK(test_sn_registration_update_removed_links());
+}
+
+TEST(sn_registration, test_sn_registration_uri_query_reuse)
+{
+    CHECK(test_sn_registration_uri_query_reuse());
+}
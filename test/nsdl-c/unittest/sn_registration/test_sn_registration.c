@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * Registration flows run against the real library. Requests are captured
+ * from the transmit callback and parsed, responses are built and given to
+ * sn_nsdl_process_coap() as if they came from the server.
+ */
+
+#include "test_sn_registration.h"
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "sn_nsdl.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "sn_nsdl_lib.h"
+#include "alloc_tracker.h"
+
+static uint8_t server_address[4] = {10, 0, 0, 1};
+static sn_nsdl_addr_s server;
+static uint8_t tx_packet[512];
+static uint16_t tx_len;
+
+static uint8_t registration_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    tx_len = 0;
+    if (data_len <= sizeof(tx_packet)) {
+        memcpy(tx_packet, data_ptr, data_len);
+        tx_len = data_len;
+    }
+    return 1;
+}
+
+static uint8_t registration_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+static uint8_t registration_coap_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    return 1;
+}
+
+static int8_t create_resource(struct nsdl_s *handle, const char *path, const char *resource_type)
+{
+    sn_nsdl_resource_info_s resource;
+    sn_nsdl_resource_parameters_s parameters;
+
+    memset(&resource, 0, sizeof(resource));
+    memset(&parameters, 0, sizeof(parameters));
+    parameters.resource_type_ptr = (uint8_t *)resource_type;
+    parameters.resource_type_len = (uint16_t)strlen(resource_type);
+    resource.resource_parameters_ptr = &parameters;
+    resource.access = SN_GRS_GET_ALLOWED;
+    resource.mode = SN_GRS_STATIC;
+    resource.publish_uri = 1;
+    resource.path = (uint8_t *)path;
+    resource.pathlen = (uint16_t)strlen(path);
+    return sn_nsdl_create_resource(handle, &resource);
+}
+
+/* Parses the last request sent by the client */
+static sn_coap_hdr_s *parse_sent(struct coap_s *coap)
+{
+    coap_version_e version = COAP_VERSION_UNKNOWN;
+
+    if (!tx_len) {
+        return NULL;
+    }
+    return sn_coap_parser(coap, tx_len, tx_packet, &version);
+}
+
+/* Acknowledges request with a piggybacked response, location is given for 2.01 Created */
+static int8_t acknowledge(struct nsdl_s *handle, struct coap_s *coap, uint16_t msg_id, sn_coap_msg_code_e msg_code, const char *location)
+{
+    sn_coap_hdr_s *msg = sn_coap_parser_alloc_message(coap);
+    uint8_t packet[64];
+    int16_t packet_len = -1;
+
+    if (!msg) {
+        return -1;
+    }
+    msg->msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+    msg->msg_code = msg_code;
+    msg->msg_id = msg_id;
+    if (!location || sn_coap_parser_alloc_options(coap, msg)) {
+        if (location) {
+            msg->options_list_ptr->location_path_ptr = (uint8_t *)location;
+            msg->options_list_ptr->location_path_len = (uint16_t)strlen(location);
+        }
+        packet_len = sn_coap_builder(packet, msg);
+        if (location) {
+            msg->options_list_ptr->location_path_ptr = NULL;
+        }
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, msg);
+    if (packet_len <= 0) {
+        return -1;
+    }
+    return sn_nsdl_process_coap(handle, packet, (uint16_t)packet_len, &server);
+}
+
+static bool uri_query_equals(const sn_coap_hdr_s *msg, const char *expected)
+{
+    uint16_t expected_len = (uint16_t)strlen(expected);
+
+    if (!msg || !msg->options_list_ptr || msg->options_list_ptr->uri_query_len != expected_len) {
+        return false;
+    }
+    return memcmp(msg->options_list_ptr->uri_query_ptr, expected, expected_len) == 0;
+}
+
+static bool register_with_query(struct nsdl_s *handle, struct coap_s *coap, sn_nsdl_ep_parameters_s *endpoint, const char *expected)
+{
+    sn_coap_hdr_s *sent;
+    bool ret;
+
+    tx_len = 0;
+    sn_nsdl_register_endpoint(handle, endpoint);
+    sent = parse_sent(coap);
+    ret = uri_query_equals(sent, expected);
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, sent);
+    return ret;
+}
+
+static bool payload_equals(const sn_coap_hdr_s *msg, const char *expected)
+{
+    uint16_t expected_len = (uint16_t)strlen(expected);
+
+    if (!msg || msg->payload_len != expected_len) {
+        return false;
+    }
+    return !expected_len || memcmp(msg->payload_ptr, expected, expected_len) == 0;
+}
+
+bool test_sn_registration_update_removed_links()
+{
+    struct coap_s *coap = sn_coap_protocol_init(&alloc_tracker_alloc, &alloc_tracker_free, &registration_coap_tx, NULL);
+    struct nsdl_s *handle = sn_nsdl_init(&registration_tx, &registration_rx, &alloc_tracker_alloc, &alloc_tracker_free);
+    sn_nsdl_ep_parameters_s endpoint;
+    sn_coap_hdr_s *sent;
+    bool ret = true;
+
+    if (!coap || !handle) {
+        return false;
+    }
+    server.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    server.addr_ptr = server_address;
+    server.addr_len = sizeof(server_address);
+    server.port = 5683;
+    set_NSP_address(handle, server_address, server.port, SN_NSDL_ADDRESS_TYPE_IPV4);
+    sn_nsdl_set_delta_update(handle, true);
+
+    if (create_resource(handle, "3/0/0", "a") != 0 || create_resource(handle, "3303/0/5700", "t") != 0) {
+        ret = false;
+    }
+
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = (uint8_t *)"ep";
+    endpoint.endpoint_name_len = 2;
+    endpoint.ds_register_mode = REGISTER_WITH_RESOURCES;
+    tx_len = 0;
+    sn_nsdl_register_endpoint(handle, &endpoint);
+    sent = parse_sent(coap);
+    if (!sent || acknowledge(handle, coap, sent->msg_id, COAP_MSG_CODE_RESPONSE_CREATED, "rd/d/ep") != 0 ||
+            sn_nsdl_is_ep_registered(handle) != SN_NSDL_ENDPOINT_IS_REGISTERED) {
+        ret = false;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, sent);
+
+    /* Removed link comes first, then the added one */
+    if (sn_nsdl_delete_resource(handle, 11, (uint8_t *)"3303/0/5700") != 0 || create_resource(handle, "3/0/1", "n") != 0) {
+        ret = false;
+    }
+    tx_len = 0;
+    sn_nsdl_update_registration(handle, NULL, 0);
+    sent = parse_sent(coap);
+    if (!payload_equals(sent, "</3303/0/5700>;rm,</3/0/1>;rt=\"n\"")) {
+        ret = false;
+    }
+
+    /* Removal is reported once, it is dropped when server has accepted the update */
+    if (!sent || acknowledge(handle, coap, sent->msg_id, COAP_MSG_CODE_RESPONSE_CHANGED, NULL) != 0) {
+        ret = false;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, sent);
+
+    /* Attributes are changed by creating the resource again, new link replaces the old one */
+    if (sn_nsdl_delete_resource(handle, 5, (uint8_t *)"3/0/0") != 0 || create_resource(handle, "3/0/0", "b") != 0) {
+        ret = false;
+    }
+    tx_len = 0;
+    sn_nsdl_update_registration(handle, NULL, 0);
+    sent = parse_sent(coap);
+    if (!payload_equals(sent, "</3/0/0>;rt=\"b\"") ||
+            acknowledge(handle, coap, sent->msg_id, COAP_MSG_CODE_RESPONSE_CHANGED, NULL) != 0) {
+        ret = false;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, sent);
+
+    tx_len = 0;
+    sn_nsdl_update_registration(handle, NULL, 0);
+    sent = parse_sent(coap);
+    if (!payload_equals(sent, "")) {
+        ret = false;
+    }
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, sent);
+
+    sn_nsdl_destroy(handle);
+    sn_coap_protocol_destroy(coap);
+    return ret && alloc_tracker_outstanding() == 0;
+}
+
+bool test_sn_registration_uri_query_reuse()
+{
+    struct coap_s *coap = sn_coap_protocol_init(&alloc_tracker_alloc, &alloc_tracker_free, &registration_coap_tx, NULL);
+    struct nsdl_s *handle = sn_nsdl_init(&registration_tx, &registration_rx, &alloc_tracker_alloc, &alloc_tracker_free);
+    sn_nsdl_ep_parameters_s endpoint;
+    uint8_t name[] = {'e', 'p', '1'};
+    bool ret = true;
+
+    if (!coap || !handle) {
+        return false;
+    }
+    server.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    server.addr_ptr = server_address;
+    server.addr_len = sizeof(server_address);
+    server.port = 5683;
+    set_NSP_address(handle, server_address, server.port, SN_NSDL_ADDRESS_TYPE_IPV4);
+
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.endpoint_name_ptr = name;
+    endpoint.endpoint_name_len = sizeof(name);
+    endpoint.type_ptr = (uint8_t *)"t";
+    endpoint.type_len = 1;
+    endpoint.lifetime_ptr = (uint8_t *)"3600";
+    endpoint.lifetime_len = 4;
+    endpoint.domain_name_ptr = (uint8_t *)"d";
+    endpoint.domain_name_len = 1;
+    endpoint.binding_and_mode = 0x03;
+    endpoint.ds_register_mode = REGISTER_WITH_TEMPLATE;
+
+    ret = register_with_query(handle, coap, &endpoint, "ep=ep1&et=t&lt=3600&d=d&b=UQ") &&
+          register_with_query(handle, coap, &endpoint, "ep=ep1&et=t&lt=3600&d=d&b=UQ");
+
+    /* Each parameter is compared, also when length stays the same */
+    name[2] = '2';
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&et=t&lt=3600&d=d&b=UQ");
+    endpoint.lifetime_ptr = (uint8_t *)"1200";
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&et=t&lt=1200&d=d&b=UQ");
+    endpoint.type_ptr = (uint8_t *)"s";
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&et=s&lt=1200&d=d&b=UQ");
+    endpoint.domain_name_ptr = (uint8_t *)"e";
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&et=s&lt=1200&d=e&b=UQ");
+    endpoint.binding_and_mode = 0x06;
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&et=s&lt=1200&d=e&b=SQ");
+    endpoint.binding_and_mode = 0x07;
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&et=s&lt=1200&d=e&b=UQS");
+    endpoint.binding_and_mode = 0;
+    endpoint.type_ptr = NULL;
+    endpoint.type_len = 0;
+    ret = ret && register_with_query(handle, coap, &endpoint, "ep=ep2&lt=1200&d=e");
+
+    sn_nsdl_destroy(handle);
+    sn_coap_protocol_destroy(coap);
+    return ret && alloc_tracker_outstanding() == 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_REGISTRATION_H
+#define TEST_SN_REGISTRATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+bool test_sn_registration_update_removed_links();
+bool test_sn_registration_uri_query_reuse();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_SN_REGISTRATION_H
+
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "test_sn_static_dispatch.h"
+
+TEST_GROUP(sn_static_dispatch)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(sn_static_dispatch, test_sn_static_dispatch_lookup)
+{
+    CHECK(test_sn_static_dispatch_lookup());
+}
+
+TEST(sn_static_dispatch, test_sn_static_dispatch_full_table)
+{
+    CHECK(test_sn_static_dispatch_full_table());
+}
+
+TEST(sn_static_dispatch, test_sn_static_dispatch_invalid)
+{
+    CHECK(test_sn_static_dispatch_invalid());
+}
+
+TEST(sn_static_dispatch, test_sn_static_dispatch_requests)
+{
+    CHECK(test_sn_static_dispatch_requests());
+}
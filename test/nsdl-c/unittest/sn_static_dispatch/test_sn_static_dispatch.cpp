@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+
+/*
+ * Static dispatch tests. Tables are checked at compile time with
+ * static_assert and again at run time with request paths, then the lookup is
+ * installed to a real NSDL handle and driven with CoAP requests.
+ */
+
+#include "test_sn_static_dispatch.h"
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "sn_cpp.hpp"
+#include "sn_static_dispatch.hpp"
+#include "alloc_tracker.h"
+
+static uint8_t client_address[4] = {10, 0, 0, 1};
+static std::deque<std::vector<uint8_t> > to_client;
+static int temperature_calls;
+static int device_calls;
+static int store_calls;
+static uint8_t static_value[] = {"mbed"};
+
+static uint8_t temperature(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e)
+{
+    temperature_calls++;
+    return 0;
+}
+
+static uint8_t device(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e)
+{
+    device_calls++;
+    return 0;
+}
+
+static uint8_t store(struct nsdl_s *, sn_coap_hdr_s *, sn_nsdl_addr_s *, sn_nsdl_capab_e)
+{
+    store_calls++;
+    return 0;
+}
+
+static constexpr sn::static_resource resources[] = {
+    {"1/0/0", SN_GRS_GET_ALLOWED, &device},
+    {"1/0/1", SN_GRS_GET_ALLOWED | SN_GRS_PUT_ALLOWED, &device},
+    {"1/0/7", SN_GRS_GET_ALLOWED, &device},
+    {"1/0/8", SN_GRS_POST_ALLOWED, &device},
+    {"3/0/0", SN_GRS_GET_ALLOWED, &device},
+    {"3/0/1", SN_GRS_GET_ALLOWED, &device},
+    {"3/0/2", SN_GRS_GET_ALLOWED, &device},
+    {"3/0/3", SN_GRS_GET_ALLOWED, &device},
+    {"/3/0/4", SN_GRS_POST_ALLOWED, &device},
+    {"3/0/5", SN_GRS_POST_ALLOWED, &device},
+    {"3/0/11", SN_GRS_GET_ALLOWED, &device},
+    {"3/0/13", SN_GRS_GET_ALLOWED | SN_GRS_PUT_ALLOWED, &device},
+    {"3/0/16", SN_GRS_GET_ALLOWED, &device},
+    {"4/0/0", SN_GRS_GET_ALLOWED, &device},
+    {"4/0/1", SN_GRS_GET_ALLOWED, &device},
+    {"4/0/2", SN_GRS_GET_ALLOWED, &device},
+    {"5/0/1", SN_GRS_PUT_ALLOWED, &device},
+    {"5/0/2", SN_GRS_POST_ALLOWED, &device},
+    {"5/0/3", SN_GRS_GET_ALLOWED, &device},
+    {"3303/0/5700", SN_GRS_GET_ALLOWED, &temperature},
+    {"3303/0/5701", SN_GRS_GET_ALLOWED, &temperature},
+    {"3303/1/5700", SN_GRS_GET_ALLOWED, &temperature},
+    {"3303/1/5701", SN_GRS_GET_ALLOWED, &temperature},
+};
+static constexpr auto dispatch = sn::make_static_dispatch(resources);
+
+/* Built by the compiler, checked by the compiler */
+static_assert(dispatch.valid(), "table is built at compile time");
+static_assert(dispatch.find("3303/1/5700", 11)->callback == &temperature, "path finds its handler");
+static_assert(dispatch.find("3/0/4", 5)->access == SN_GRS_POST_ALLOWED, "leading '/' of table path is ignored");
+static_assert(!dispatch.find("3303/1/570", 10) && !dispatch.find("3/0/6", 5), "unknown path is not found");
+static_assert(decltype(dispatch)::slot_count == 32, "slots are rounded up to a power of two");
+
+/* Every slot used */
+static constexpr sn::static_resource full_resources[] = {
+    {"a", SN_GRS_GET_ALLOWED, &device}, {"b", SN_GRS_GET_ALLOWED, &device},
+    {"c", SN_GRS_GET_ALLOWED, &device}, {"d", SN_GRS_GET_ALLOWED, &device},
+    {"ab", SN_GRS_GET_ALLOWED, &device}, {"ba", SN_GRS_GET_ALLOWED, &device},
+    {"abc", SN_GRS_GET_ALLOWED, &device}, {"cba", SN_GRS_GET_ALLOWED, &temperature},
+};
+static constexpr auto full_dispatch = sn::make_static_dispatch(full_resources);
+static_assert(decltype(full_dispatch)::slot_count == 8, "table is full");
+
+static constexpr sn::static_resource single_resource[] = {
+    {"3/0/1", SN_GRS_GET_ALLOWED, &device},
+};
+static constexpr auto single_dispatch = sn::make_static_dispatch(single_resource);
+
+static sn_nsdl_addr_s make_address()
+{
+    sn_nsdl_addr_s address;
+
+    address.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    address.addr_ptr = client_address;
+    address.addr_len = 4;
+    address.port = 5683;
+    return address;
+}
+
+static uint8_t endpoint_tx(struct nsdl_s *handle, sn_nsdl_capab_e protocol, uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr)
+{
+    to_client.push_back(std::vector<uint8_t>(data_ptr, data_ptr + data_len));
+    return 1;
+}
+
+static uint8_t endpoint_rx(struct nsdl_s *handle, sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address_ptr)
+{
+    return 0;
+}
+
+static uint8_t client_tx(uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    return 1;
+}
+
+/* Runs a path of the table as it comes from a request */
+template <std::size_t N>
+static const sn_nsdl_static_handler_s *find(const sn::static_dispatch<N> &table, const char *path)
+{
+    std::vector<uint8_t> request_path(path, path + strlen(path));
+
+    return table.find(request_path.data(), request_path.size());
+}
+
+class endpoint {
+public:
+    endpoint()
+        : nsdl(&endpoint_tx, &endpoint_rx, &alloc_tracker_alloc, &alloc_tracker_free),
+          client(&alloc_tracker_alloc, &alloc_tracker_free, &client_tx)
+    {
+        to_client.clear();
+        temperature_calls = 0;
+        device_calls = 0;
+        store_calls = 0;
+    }
+
+    bool add(const char *path, sn_nsdl_resource_mode_e mode)
+    {
+        sn_nsdl_resource_info_s resource;
+        sn_nsdl_resource_parameters_s parameters;
+
+        memset(&resource, 0, sizeof(resource));
+        memset(&parameters, 0, sizeof(parameters));
+        resource.resource_parameters_ptr = &parameters;
+        resource.access = SN_GRS_GET_ALLOWED | SN_GRS_PUT_ALLOWED;
+        resource.mode = mode;
+        resource.path = (uint8_t *)path;
+        resource.pathlen = (uint16_t)strlen(path);
+        if (mode == SN_GRS_STATIC) {
+            resource.resource = static_value;
+            resource.resourcelen = sizeof(static_value) - 1;
+        } else {
+            resource.sn_grs_dyn_res_callback = &store;
+        }
+        return sn_nsdl_create_resource(nsdl.get(), &resource) == 0;
+    }
+
+    bool request(const char *path, sn_coap_msg_code_e code, uint8_t token)
+    {
+        std::vector<uint8_t> datagram;
+        sn_nsdl_addr_s from_client = make_address();
+        {
+            sn::coap_message message = client.create_message();
+
+            if (!message || !message.set_token(sn::byte_view(&token, 1)) || !message.set_uri_path(path)) {
+                return false;
+            }
+            message.set_type(COAP_MSG_TYPE_CONFIRMABLE);
+            message.set_code(code);
+            message.set_msg_id(token);
+            datagram = client.build(message, from_client);
+        }
+        return !datagram.empty() && nsdl.process(datagram, from_client) == SN_NSDL_SUCCESS;
+    }
+
+    sn::coap_message received()
+    {
+        if (to_client.empty()) {
+            return sn::coap_message();
+        }
+        std::vector<uint8_t> datagram = std::move(to_client.front());
+        sn_nsdl_addr_s from_endpoint = make_address();
+
+        to_client.pop_front();
+        return client.parse(std::move(datagram), from_endpoint);
+    }
+
+    sn::nsdl_handle nsdl;
+    sn::coap_handle client;
+};
+
+bool test_sn_static_dispatch_lookup()
+{
+    for (const sn::static_resource &resource : resources) {
+        const char *path = resource.path[0] == '/' ? resource.path + 1 : resource.path;
+        const sn_nsdl_static_handler_s *handler = find(dispatch, path);
+
+        if (!handler || handler->access != resource.access || handler->callback != resource.callback) {
+            return false;
+        }
+    }
+
+    /* Near misses of table paths */
+    static const char *unknown[] = {"", "/3/0/4", "3/0/4/", "3/0", "3/0/1/0", "3/0/10", "3303/0/5702", "3303/0/570", "5/0/4"};
+    for (const char *path : unknown) {
+        if (find(dispatch, path)) {
+            return false;
+        }
+    }
+
+    return !dispatch.find(static_cast<const uint8_t *>(nullptr), 0) &&
+           find(single_dispatch, "3/0/1") && !find(single_dispatch, "3/0/2") && !find(single_dispatch, "");
+}
+
+bool test_sn_static_dispatch_full_table()
+{
+    for (const sn::static_resource &resource : full_resources) {
+        const sn_nsdl_static_handler_s *handler = find(full_dispatch, resource.path);
+
+        if (!handler || handler->callback != resource.callback) {
+            return false;
+        }
+    }
+    return !find(full_dispatch, "e") && !find(full_dispatch, "bc") && !find(full_dispatch, "abcd");
+}
+
+bool test_sn_static_dispatch_invalid()
+{
+    /* Built at run time instead of failing the build */
+    static const sn::static_resource duplicate[] = {
+        {"3/0/1", SN_GRS_GET_ALLOWED, &device},
+        {"3/0/2", SN_GRS_GET_ALLOWED, &device},
+        {"/3/0/1", SN_GRS_GET_ALLOWED, &temperature},
+    };
+    static const sn::static_resource trailing_slash[] = {
+        {"3/0/", SN_GRS_GET_ALLOWED, &device},
+    };
+    static const sn::static_resource empty[] = {
+        {"3/0/1", SN_GRS_GET_ALLOWED, &device},
+        {"/", SN_GRS_GET_ALLOWED, &device},
+    };
+    static const sn::static_resource null_path[] = {
+        {nullptr, SN_GRS_GET_ALLOWED, &device},
+    };
+    sn::static_dispatch<3> duplicate_dispatch(duplicate);
+    sn::static_dispatch<1> trailing_slash_dispatch(trailing_slash);
+    sn::static_dispatch<2> empty_dispatch(empty);
+    sn::static_dispatch<1> null_path_dispatch(null_path);
+
+    return !duplicate_dispatch.valid() && !find(duplicate_dispatch, "3/0/2") &&
+           !trailing_slash_dispatch.valid() && !empty_dispatch.valid() && !find(empty_dispatch, "3/0/1") &&
+           !null_path_dispatch.valid();
+}
+
+bool test_sn_static_dispatch_requests()
+{
+    bool ret;
+    {
+        endpoint ep;
+
+        /* Same path in the store as in the table, and a path only in the store */
+        if (!ep.nsdl || !ep.add("3303/0/5700", SN_GRS_DYNAMIC) || !ep.add("3303/0/5750", SN_GRS_STATIC) ||
+                !sn::set_static_dispatch<dispatch>(ep.nsdl.get())) {
+            return false;
+        }
+
+        /* Handler of the table is called, it takes care of the response */
+        ret = ep.request("3303/0/5700", COAP_MSG_CODE_REQUEST_GET, 1) && temperature_calls == 1 && store_calls == 0 &&
+              to_client.empty();
+        ret = ret && ep.request("/3/0/4", COAP_MSG_CODE_REQUEST_POST, 2) && device_calls == 1;
+
+        /* Access of the table is checked, store is not tried */
+        ret = ret && ep.request("3303/0/5700", COAP_MSG_CODE_REQUEST_PUT, 3) && temperature_calls == 1 && store_calls == 0;
+        sn::coap_message response = ep.received();
+        ret = ret && response && response.code() == COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED && response.msg_id() == 3;
+
+        /* Paths not in the table are served from the store */
+        ret = ret && ep.request("3303/0/5750", COAP_MSG_CODE_REQUEST_GET, 4);
+        response = ep.received();
+        ret = ret && response && response.code() == COAP_MSG_CODE_RESPONSE_CONTENT && response.payload().size() == 4 &&
+              memcmp(response.payload().data(), "mbed", 4) == 0;
+        ret = ret && ep.request("3303/0/5751", COAP_MSG_CODE_REQUEST_GET, 5);
+        response = ep.received();
+        ret = ret && response && response.code() == COAP_MSG_CODE_RESPONSE_NOT_FOUND;
+
+        /* Lookup removed, store handles the shadowed path again */
+        ret = ret && sn_nsdl_set_static_dispatch(ep.nsdl.get(), NULL) == 0;
+        ret = ret && ep.request("3303/0/5700", COAP_MSG_CODE_REQUEST_PUT, 6) && temperature_calls == 1 && store_calls == 1;
+    }
+    return ret && alloc_tracker_outstanding() == 0;
+}
@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2016 ARM. All rights reserved.
+ */
+#ifndef TEST_SN_STATIC_DISPATCH_H
+#define TEST_SN_STATIC_DISPATCH_H
+
+bool test_sn_static_dispatch_lookup();
+bool test_sn_static_dispatch_full_table();
+bool test_sn_static_dispatch_invalid();
+bool test_sn_static_dispatch_requests();
+
+#endif // TEST_SN_STATIC_DISPATCH_H
@@ -133,3 +133,35 @@ sn_coap_options_list_s *sn_coap_parser_alloc_options(struct coap_s *handle, sn_c
 
     return coap_msg_ptr->options_list_ptr;
 }
+
+int8_t sn_coap_parser_set_token(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, const uint8_t *token_ptr, uint8_t token_len)
+{
+    if (handle == NULL || coap_msg_ptr == NULL || token_ptr == NULL || token_len == 0) {
+        return -1;
+    }
+
+    coap_msg_ptr->token_ptr = handle->sn_coap_protocol_malloc(token_len);
+    if (coap_msg_ptr->token_ptr == NULL) {
+        return -1;
+    }
+    memcpy(coap_msg_ptr->token_ptr, token_ptr, token_len);
+    coap_msg_ptr->token_len = token_len;
+
+    return 0;
+}
+
+int8_t sn_coap_parser_set_uri_path(struct coap_s *handle, sn_coap_hdr_s *coap_msg_ptr, const uint8_t *uri_path_ptr, uint16_t uri_path_len)
+{
+    if (handle == NULL || coap_msg_ptr == NULL || uri_path_ptr == NULL || uri_path_len == 0) {
+        return -1;
+    }
+
+    coap_msg_ptr->uri_path_ptr = handle->sn_coap_protocol_malloc(uri_path_len);
+    if (coap_msg_ptr->uri_path_ptr == NULL) {
+        return -1;
+    }
+    memcpy(coap_msg_ptr->uri_path_ptr, uri_path_ptr, uri_path_len);
+    coap_msg_ptr->uri_path_len = uri_path_len;
+
+    return 0;
+}
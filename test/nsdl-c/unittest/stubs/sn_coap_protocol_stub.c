@@ -94,6 +94,46 @@ int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_p
     return sn_coap_protocol_stub.expectedInt16;
 }
 
+int16_t sn_coap_protocol_build_copy(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *packet_data_ptr,
+                                    uint16_t packet_data_len, sn_coap_hdr_s *src_coap_msg_ptr, void *param)
+{
+    return sn_coap_protocol_stub.expectedInt16;
+}
+
+int8_t sn_coap_protocol_prepare_streamed_message(struct coap_s *handle, sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context)
+{
+    return sn_coap_protocol_stub.expectedInt8;
+}
+
+int16_t sn_coap_protocol_build_streamed(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr,
+        sn_coap_hdr_s *src_coap_msg_ptr, uint32_t payload_total_len,
+        uint16_t (*payload_source)(void *, uint32_t, uint8_t *, uint16_t), void *source_context, void *param)
+{
+    if (sn_coap_protocol_stub.streamedPayload && handle && handle->sn_coap_block_data_size) {
+        uint32_t offset;
+
+        sn_coap_protocol_stub.streamedPayloadLen = 0;
+        sn_coap_protocol_stub.streamedBlockCount = 0;
+        for (offset = 0; offset < payload_total_len; offset += handle->sn_coap_block_data_size) {
+            uint16_t len = handle->sn_coap_block_data_size;
+
+            if (payload_total_len - offset < len) {
+                len = (uint16_t)(payload_total_len - offset);
+            }
+            sn_coap_protocol_stub.streamedPayloadLen += payload_source(source_context, offset,
+                                                                       sn_coap_protocol_stub.streamedPayload + offset, len);
+            sn_coap_protocol_stub.streamedBlockCount++;
+        }
+    }
+
+    /* Library owns the context after successful build */
+    if (sn_coap_protocol_stub.expectedInt16 >= 0 && handle && source_context) {
+        handle->sn_coap_protocol_free(source_context);
+    }
+    return sn_coap_protocol_stub.expectedInt16;
+}
+
 sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint16_t packet_data_len, uint8_t *packet_data_ptr, void *param)
 {
     return sn_coap_protocol_stub.expectedHeader;
@@ -104,6 +144,20 @@ int8_t sn_coap_protocol_exec(struct coap_s *handle, uint32_t current_time)
     return sn_coap_protocol_stub.expectedInt8;
 }
 
+int8_t sn_coap_protocol_get_next_deadline(struct coap_s *handle, uint32_t *deadline_ptr)
+{
+    return sn_coap_protocol_stub.expectedInt8;
+}
+
+uint16_t sn_coap_protocol_reserve_message_id(struct coap_s *handle)
+{
+    return sn_coap_protocol_stub.expectedUint16;
+}
+
+void sn_coap_protocol_clear_sent_messages_by_param(struct coap_s *handle, void *param)
+{
+}
+
 coap_send_msg_s *sn_coap_protocol_allocate_mem_for_msg(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t packet_data_len)
 {
     return sn_coap_protocol_stub.expectedSendMsg;
@@ -23,9 +23,13 @@
 typedef struct {
     int8_t expectedInt8;
     int16_t expectedInt16;
+    uint16_t expectedUint16;
     struct coap_s *expectedCoap;
     sn_coap_hdr_s *expectedHeader;
     coap_send_msg_s *expectedSendMsg;
+    uint8_t *streamedPayload;           /* Streamed payload is pulled here block by block when set */
+    uint32_t streamedPayloadLen;
+    uint16_t streamedBlockCount;
 } sn_coap_protocol_stub_def;
 
 extern sn_coap_protocol_stub_def sn_coap_protocol_stub;
@@ -80,6 +80,9 @@ extern void sn_grs_free_resource_list(struct grs_s *handle, sn_grs_resource_list
 
 extern const sn_nsdl_resource_info_s *sn_grs_get_first_resource(struct grs_s *handle)
 {
+    if( sn_grs_stub.resourceList ){
+        return sn_grs_stub.resourceCount ? sn_grs_stub.resourceList : NULL;
+    }
     if( sn_grs_stub.retNull ){
         return NULL;
     }
@@ -98,6 +101,12 @@ extern const sn_nsdl_resource_info_s *sn_grs_get_first_resource(struct grs_s *ha
 
 extern const sn_nsdl_resource_info_s *sn_grs_get_next_resource(struct grs_s *handle, const sn_nsdl_resource_info_s *sn_grs_current_resource)
 {
+    if( sn_grs_stub.resourceList ){
+        if( sn_grs_current_resource + 1 < sn_grs_stub.resourceList + sn_grs_stub.resourceCount ){
+            return sn_grs_current_resource + 1;
+        }
+        return NULL;
+    }
     if( sn_grs_stub.retNull ){
         return NULL;
     }
@@ -154,7 +163,7 @@ extern int8_t sn_grs_send_coap_message(struct nsdl_s *handle, sn_nsdl_addr_s *ad
     return sn_grs_stub.expectedInt8;
 }
 
-sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method)
+const sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t pathlen, uint8_t *path, uint8_t search_method)
 {
     if(sn_grs_stub.useMockedPath){
         memcpy(path, &sn_grs_stub.mockedPath, sn_grs_stub.mockedPathLen);
@@ -174,7 +183,85 @@ sn_nsdl_resource_info_s *sn_grs_search_resource(struct grs_s *handle, uint16_t p
     return NULL;
 }
 
+sn_nsdl_resource_info_s *sn_grs_make_writable(struct grs_s *handle, const sn_nsdl_resource_info_s *resource_ptr)
+{
+    if( resource_ptr && resource_ptr == sn_grs_stub.expectedInfo ){
+        return sn_grs_stub.expectedInfo;
+    }
+    return NULL;
+}
+
 void sn_grs_mark_resources_as_registered(struct nsdl_s *handle)
 {
 }
 
+int8_t sn_grs_set_resource_template(struct grs_s *handle, const sn_nsdl_resource_info_s *resources, uint16_t resource_count)
+{
+    return sn_grs_stub.expectedInt8;
+}
+
+int8_t sn_grs_set_static_dispatch(struct grs_s *handle, const sn_nsdl_static_handler_s *(*lookup)(const uint8_t *, uint16_t))
+{
+    return sn_grs_stub.expectedInt8;
+}
+
+uint8_t sn_grs_get_registration_state(const struct grs_s *handle, const sn_nsdl_resource_info_s *res, uint8_t session_slot)
+{
+    if (!res || !res->resource_parameters_ptr) {
+        return SN_NDSL_RESOURCE_NOT_REGISTERED;
+    }
+    return (res->resource_parameters_ptr->registered >> SN_GRS_SESSION_STATE_SHIFT(session_slot)) & SN_GRS_SESSION_STATE_MASK;
+}
+
+void sn_grs_set_registration_state(struct grs_s *handle, const sn_nsdl_resource_info_s *res, uint8_t session_slot, uint8_t state)
+{
+    uint8_t shift = SN_GRS_SESSION_STATE_SHIFT(session_slot);
+
+    if (res && res->resource_parameters_ptr) {
+        res->resource_parameters_ptr->registered = (res->resource_parameters_ptr->registered & ~(SN_GRS_SESSION_STATE_MASK << shift)) |
+                                                   (state << shift);
+    }
+}
+
+int8_t sn_grs_alloc_session_slot(struct grs_s *handle)
+{
+    uint8_t slot;
+
+    for (slot = 0; slot < SN_GRS_MAX_SESSIONS; slot++) {
+        if (!(handle->session_slots & SN_GRS_SESSION_BIT(slot))) {
+            handle->session_slots |= SN_GRS_SESSION_BIT(slot);
+            handle->session_count++;
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void sn_grs_free_session_slot(struct grs_s *handle, uint8_t session_slot)
+{
+    handle->session_slots &= ~SN_GRS_SESSION_BIT(session_slot);
+    handle->session_count--;
+}
+
+void sn_grs_set_removed_resource_tracking(struct grs_s *handle, bool enable)
+{
+}
+
+const sn_grs_removed_resource_s *sn_grs_get_first_removed_resource(struct grs_s *handle)
+{
+    return NULL;
+}
+
+const sn_grs_removed_resource_s *sn_grs_get_next_removed_resource(struct grs_s *handle, const sn_grs_removed_resource_s *current_ptr)
+{
+    return NULL;
+}
+
+void sn_grs_mark_removed_resources_as_sending(struct grs_s *handle, uint8_t session_slot)
+{
+}
+
+void sn_grs_release_removed_resources(struct grs_s *handle, uint8_t session_mask, bool only_sent)
+{
+}
+
@@ -28,6 +28,8 @@ typedef struct {
     struct grs_s *expectedGrs;
     sn_nsdl_resource_info_s *expectedInfo;
     sn_grs_resource_list_s *expectedList;
+    sn_nsdl_resource_info_s *resourceList;     /* Iterated by get_first/next_resource when set */
+    uint16_t resourceCount;
 
     bool useMockedPath;
     uint8_t mockedPath[8];
@@ -155,6 +155,11 @@ sn_nsdl_resource_info_s *sn_nsdl_get_resource(struct nsdl_s *handle, uint16_t pa
     return NULL;
 }
 
+const sn_nsdl_resource_info_s *sn_nsdl_find_resource(struct nsdl_s *handle, uint16_t pathlen, uint8_t *path_ptr)
+{
+    return NULL;
+}
+
 int8_t sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *message_ptr, uint8_t updating_registeration)
 {
     if( sn_nsdl_stub.allocatePayloadPtr && message_ptr && handle){